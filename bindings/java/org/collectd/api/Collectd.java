@@ -175,6 +175,20 @@ public class Collectd
   native public static int registerWrite (String name,
       CollectdWriteInterface object);
 
+  /**
+   * Registers a write callback that receives value lists in batches.
+   *
+   * Value lists are queued and passed to the callback once
+   * {@code batchSize} of them have been collected or the oldest one has been
+   * waiting for one interval, whichever comes first. This is a lot cheaper
+   * than calling a {@link CollectdWriteInterface} for every value list.
+   *
+   * @return Zero when successful, non-zero otherwise.
+   * @see CollectdWriteBatchInterface
+   */
+  native public static int registerWriteBatch (String name,
+      CollectdWriteBatchInterface object, int batchSize);
+
   /**
    * Java representation of collectd/src/plugin.h:plugin_register_flush
    *
@@ -236,6 +250,15 @@ public class Collectd
    */
   native public static int dispatchValues (ValueList vl);
 
+  /**
+   * Dispatches all value lists in {@code vls} with a single call into the
+   * daemon.
+   *
+   * @return Zero when successful, otherwise the number of value lists that
+   * could not be dispatched.
+   */
+  native public static int dispatchValuesBatch (ValueList[] vls);
+
   /**
    * Java representation of collectd/src/plugin.h:plugin_dispatch_notification
    *
@@ -0,0 +1,88 @@
+#!/usr/bin/python
+
+###############################################################################
+# Benchmark for dispatching values from Python plugins.                       #
+#                                                                             #
+# Every interval this module dispatches "Count" value lists once with         #
+# Values.dispatch() in a loop and once with collectd.dispatch_many() and logs #
+# the rates. It also registers a plain and a batched write callback and logs  #
+# how many value lists each of them received per second.                      #
+#                                                                             #
+#   <Plugin python>                                                           #
+#     ModulePath "/path/to/collectd/contrib/python"                           #
+#     Import "dispatch_bench"                                                 #
+#     <Module dispatch_bench>                                                 #
+#       Count 10000                                                           #
+#       BatchSize 512                                                         #
+#     </Module>                                                               #
+#   </Plugin>                                                                 #
+###############################################################################
+
+import time
+import collectd
+
+count = 10000
+batch_size = 512
+received = {'single': 0, 'batch': 0}
+started = [None]
+
+
+def config(conf):
+    global count, batch_size
+    for node in conf.children:
+        if node.key.lower() == 'count':
+            count = int(node.values[0])
+        elif node.key.lower() == 'batchsize':
+            batch_size = int(node.values[0])
+
+
+def make_values(what):
+    return [collectd.Values(plugin='dispatch_bench', plugin_instance=what,
+                            type='gauge', type_instance=str(i), values=[i])
+            for i in range(count)]
+
+
+def read():
+    if started[0] is not None:
+        elapsed = time.time() - started[0]
+        collectd.info('dispatch_bench: write: %.0f/s single, %.0f/s batched'
+                      % (received['single'] / elapsed,
+                         received['batch'] / elapsed))
+    received['single'] = received['batch'] = 0
+    started[0] = time.time()
+
+    values = make_values('loop')
+    start = time.time()
+    for v in values:
+        v.dispatch()
+    loop = time.time() - start
+
+    values = make_values('many')
+    start = time.time()
+    collectd.dispatch_many(values)
+    many = time.time() - start
+
+    collectd.info('dispatch_bench: dispatch: %.0f/s loop, %.0f/s dispatch_many'
+                  % (count / loop, count / many))
+
+
+def write_single(v):
+    if v.plugin == 'dispatch_bench':
+        received['single'] += 1
+
+
+def write_batch(values):
+    for v in values:
+        if v.plugin == 'dispatch_bench':
+            received['batch'] += 1
+
+
+def init():
+    collectd.register_write(write_single, name='dispatch_bench_single')
+    collectd.register_write(write_batch, name='dispatch_bench_batch',
+                            batch_size=batch_size)
+
+
+collectd.register_config(config)
+collectd.register_init(init)
+collectd.register_read(read)
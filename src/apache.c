@@ -28,6 +28,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 
 #include <curl/curl.h>
 
@@ -74,13 +75,14 @@ static void apache_free(void *arg) {
   sfree(st->server);
   sfree(st->apache_buffer);
   if (st->curl) {
+    curl_engine_cancel(st->curl);
     curl_easy_cleanup(st->curl);
     st->curl = NULL;
   }
   sfree(st);
 } /* apache_free */
 
-static size_t apache_curl_callback(void *buf, size_t size, size_t nmemb,
+static size_t apache_curl_callback(char *buf, size_t size, size_t nmemb,
                                    void *user_data) {
   apache_t *st = user_data;
   if (st == NULL) {
@@ -103,7 +105,7 @@ static size_t apache_curl_callback(void *buf, size_t size, size_t nmemb,
     st->apache_buffer_size = st->apache_buffer_fill + len + 1;
   }
 
-  memcpy(st->apache_buffer + st->apache_buffer_fill, (char *)buf, len);
+  memcpy(st->apache_buffer + st->apache_buffer_fill, buf, len);
   st->apache_buffer_fill += len;
   st->apache_buffer[st->apache_buffer_fill] = 0;
 
@@ -465,26 +467,14 @@ static void submit_scoreboard(char *buf, apache_t *st) {
   }
 }
 
-static int apache_read_host(user_data_t *user_data) /* {{{ */
-{
-  apache_t *st = user_data->data;
-
-  assert(st->url != NULL);
-  /* (Assured by `config_add') */
-
-  if (st->curl == NULL) {
-    if (init_host(st) != 0)
-      return -1;
-  }
-  assert(st->curl != NULL);
-
-  st->apache_buffer_fill = 0;
-
-  curl_easy_setopt(st->curl, CURLOPT_URL, st->url);
+/* Called by the cURL engine once the status page has been received. */
+static void apache_page_done(__attribute__((unused)) CURL *curl, /* {{{ */
+                             CURLcode code, void *user_data) {
+  apache_t *st = user_data;
 
-  if (curl_easy_perform(st->curl) != CURLE_OK) {
+  if (code != CURLE_OK) {
     ERROR("apache: curl_easy_perform failed: %s", st->apache_curl_error);
-    return -1;
+    return;
   }
 
   /* fallback - server_type to apache if not set at this time */
@@ -547,6 +537,41 @@ static int apache_read_host(user_data_t *user_data) /* {{{ */
   }
 
   st->apache_buffer_fill = 0;
+} /* }}} void apache_page_done */
+
+static int apache_read_host(user_data_t *user_data) /* {{{ */
+{
+  apache_t *st = user_data->data;
+
+  assert(st->url != NULL);
+  /* (Assured by `config_add') */
+
+  if (st->curl == NULL) {
+    if (init_host(st) != 0)
+      return -1;
+  }
+  assert(st->curl != NULL);
+
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(st->curl, &submitted);
+  if (skipped > 0) {
+    WARNING("apache plugin: The request to `%s' has not finished after %.3f "
+            "seconds, skipping this interval (%u skipped so far).",
+            st->url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
+  st->apache_buffer_fill = 0;
+
+  curl_easy_setopt(st->curl, CURLOPT_URL, st->url);
+
+  int status = curl_engine_submit(st->curl, apache_curl_callback, st,
+                                  apache_page_done, st);
+  if (status != 0) {
+    ERROR("apache plugin: Submitting request to `%s' failed: %s", st->url,
+          STRERROR(status));
+    return -1;
+  }
 
   return 0;
 } /* }}} int apache_read_host */
@@ -562,4 +587,5 @@ static int apache_init(void) /* {{{ */
 void module_register(void) {
   plugin_register_complex_config("apache", config);
   plugin_register_init("apache", apache_init);
+  plugin_register_init_exclusive("apache");
 } /* void module_register */
@@ -29,6 +29,8 @@
 #include "plugin.h"
 #include "utils/common/common.h"
 
+#include "utils/curl_engine/curl_engine.h"
+
 #include <curl/curl.h>
 #include <libxml/parser.h>
 
@@ -128,7 +130,7 @@ static int ascent_submit_gauge(const char *plugin_instance, /* {{{ */
   return 0;
 } /* }}} int ascent_submit_gauge */
 
-static size_t ascent_curl_callback(void *buf, size_t size,
+static size_t ascent_curl_callback(char *buf, size_t size,
                                    size_t nmemb, /* {{{ */
                                    void __attribute__((unused)) * stream) {
   size_t len = size * nmemb;
@@ -148,7 +150,7 @@ static size_t ascent_curl_callback(void *buf, size_t size,
     ascent_buffer_size = ascent_buffer_fill + len + 1;
   }
 
-  memcpy(ascent_buffer + ascent_buffer_fill, (char *)buf, len);
+  memcpy(ascent_buffer + ascent_buffer_fill, buf, len);
   ascent_buffer_fill += len;
   ascent_buffer[ascent_buffer_fill] = 0;
 
@@ -478,6 +480,7 @@ static int ascent_init(void) /* {{{ */
   }
 
   if (curl != NULL) {
+    curl_engine_cancel(curl);
     curl_easy_cleanup(curl);
   }
 
@@ -538,6 +541,18 @@ static int ascent_init(void) /* {{{ */
   return 0;
 } /* }}} int ascent_init */
 
+/* Called by the cURL engine once the status page has been received. */
+static void ascent_page_done(__attribute__((unused)) CURL *c, /* {{{ */
+                             CURLcode code,
+                             __attribute__((unused)) void *user_data) {
+  if (code != CURLE_OK) {
+    ERROR("ascent plugin: curl_easy_perform failed: %s", ascent_curl_error);
+    return;
+  }
+
+  ascent_xml(ascent_buffer);
+} /* }}} void ascent_page_done */
+
 static int ascent_read(void) /* {{{ */
 {
   int status;
@@ -552,24 +567,46 @@ static int ascent_read(void) /* {{{ */
     return -1;
   }
 
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(curl, &submitted);
+  if (skipped > 0) {
+    WARNING("ascent plugin: The request to `%s' has not finished after %.3f "
+            "seconds, skipping this interval (%u skipped so far).",
+            url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
   ascent_buffer_fill = 0;
 
   curl_easy_setopt(curl, CURLOPT_URL, url);
 
-  if (curl_easy_perform(curl) != CURLE_OK) {
-    ERROR("ascent plugin: curl_easy_perform failed: %s", ascent_curl_error);
+  status = curl_engine_submit(curl, ascent_curl_callback,
+                              /* write_data = */ NULL, ascent_page_done,
+                              /* user_data = */ NULL);
+  if (status != 0) {
+    ERROR("ascent plugin: Submitting request to `%s' failed: %s", url,
+          STRERROR(status));
     return -1;
   }
 
-  status = ascent_xml(ascent_buffer);
-  if (status != 0)
-    return -1;
-  else
-    return 0;
+  return 0;
 } /* }}} int ascent_read */
 
+static int ascent_shutdown(void) /* {{{ */
+{
+  if (curl != NULL) {
+    curl_engine_cancel(curl);
+    curl_easy_cleanup(curl);
+    curl = NULL;
+  }
+
+  return 0;
+} /* }}} int ascent_shutdown */
+
 void module_register(void) {
   plugin_register_config("ascent", ascent_config, config_keys, config_keys_num);
   plugin_register_init("ascent", ascent_init);
+  plugin_register_init_exclusive("ascent");
   plugin_register_read("ascent", ascent_read);
+  plugin_register_shutdown("ascent", ascent_shutdown);
 } /* void module_register */
@@ -45,6 +45,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 
 #include <time.h>
 
@@ -265,31 +266,6 @@ static void submit(time_t ts, const char *plugin_instance, /* {{{ */
   plugin_dispatch_values(&vl);
 } /* }}} void submit */
 
-static size_t bind_curl_callback(void *buf, size_t size, /* {{{ */
-                                 size_t nmemb,
-                                 void __attribute__((unused)) * stream) {
-  size_t len = size * nmemb;
-
-  if (len == 0)
-    return len;
-
-  if ((bind_buffer_fill + len) >= bind_buffer_size) {
-    char *temp = realloc(bind_buffer, bind_buffer_fill + len + 1);
-    if (temp == NULL) {
-      ERROR("bind plugin: realloc failed.");
-      return 0;
-    }
-    bind_buffer = temp;
-    bind_buffer_size = bind_buffer_fill + len + 1;
-  }
-
-  memcpy(bind_buffer + bind_buffer_fill, (char *)buf, len);
-  bind_buffer_fill += len;
-  bind_buffer[bind_buffer_fill] = 0;
-
-  return len;
-} /* }}} size_t bind_curl_callback */
-
 /*
  * Callback, that's called with a translation table.
  * (Plugin instance is fixed, type and type instance come from lookup table.)
@@ -378,6 +354,37 @@ static int bind_xml_read_gauge(xmlDoc *doc, xmlNode *node, /* {{{ */
   return 0;
 } /* }}} int bind_xml_read_gauge */
 
+static int bind_parse_timestamp(const char *str, time_t *ret_value) /* {{{ */
+{
+  struct tm tm = {0};
+  char *tmp = strptime(str, "%Y-%m-%dT%T", &tm);
+  if (tmp == NULL) {
+    ERROR("bind plugin: bind_parse_timestamp: strptime failed.");
+    return -1;
+  }
+
+#if HAVE_TIMEGM
+  time_t t = timegm(&tm);
+  if (t == ((time_t)-1)) {
+    ERROR("bind plugin: timegm() failed: %s", STRERRNO);
+    return -1;
+  }
+  *ret_value = t;
+#else
+  time_t t = mktime(&tm);
+  if (t == ((time_t)-1)) {
+    ERROR("bind plugin: mktime() failed: %s", STRERRNO);
+    return -1;
+  }
+  /* mktime assumes that tm is local time. Luckily, it also sets timezone to
+   * the offset used for the conversion, and we undo the conversion to convert
+   * back to UTC. */
+  *ret_value = t - timezone;
+#endif
+
+  return 0;
+} /* }}} int bind_parse_timestamp */
+
 static int bind_xml_read_timestamp(const char *xpath_expression, /* {{{ */
                                    xmlDoc *doc, xmlXPathContext *xpathCtx,
                                    time_t *ret_value) {
@@ -416,36 +423,10 @@ static int bind_xml_read_timestamp(const char *xpath_expression, /* {{{ */
     return -1;
   }
 
-  struct tm tm = {0};
-  char *tmp = strptime(str_ptr, "%Y-%m-%dT%T", &tm);
+  int status = bind_parse_timestamp(str_ptr, ret_value);
   xmlFree(str_ptr);
-  if (tmp == NULL) {
-    ERROR("bind plugin: bind_xml_read_timestamp: strptime failed.");
-    xmlXPathFreeObject(xpathObj);
-    return -1;
-  }
-
-#if HAVE_TIMEGM
-  time_t t = timegm(&tm);
-  if (t == ((time_t)-1)) {
-    ERROR("bind plugin: timegm() failed: %s", STRERRNO);
-    return -1;
-  }
-  *ret_value = t;
-#else
-  time_t t = mktime(&tm);
-  if (t == ((time_t)-1)) {
-    ERROR("bind plugin: mktime() failed: %s", STRERRNO);
-    return -1;
-  }
-  /* mktime assumes that tm is local time. Luckily, it also sets timezone to
-   * the offset used for the conversion, and we undo the conversion to convert
-   * back to UTC. */
-  *ret_value = t - timezone;
-#endif
-
   xmlXPathFreeObject(xpathObj);
-  return 0;
+  return status;
 } /* }}} int bind_xml_read_timestamp */
 
 /*
@@ -1408,6 +1389,563 @@ static int bind_xml(const char *data) /* {{{ */
   return ret;
 } /* }}} int bind_xml */
 
+/*
+ * Streaming parser for version 3 statistics documents
+ *
+ * With many zones, the v3 document gets huge. Instead of building a DOM and
+ * evaluating XPath expressions on it, the document is fed to a SAX parser as
+ * it is received and the values are dispatched as soon as their element has
+ * been closed. Only the element path and the text of the current leaf element
+ * are kept, so memory use does not depend on the size of the document. Older
+ * documents (versions 1 and 2) are detected from the root element and are
+ * still handled by `bind_xml'.
+ */
+typedef enum {
+  BIND_TAG_OTHER,
+  BIND_TAG_STATISTICS,
+  BIND_TAG_SERVER,
+  BIND_TAG_CURRENT_TIME,
+  BIND_TAG_COUNTERS,
+  BIND_TAG_COUNTER,
+  BIND_TAG_VIEWS,
+  BIND_TAG_VIEW,
+  BIND_TAG_ZONES,
+  BIND_TAG_ZONE,
+  BIND_TAG_CACHE,
+  BIND_TAG_RRSET,
+  BIND_TAG_NAME,
+  BIND_TAG_MEMORY,
+  BIND_TAG_SUMMARY,
+} bind_tag_t;
+
+static const struct {
+  const char *name;
+  bind_tag_t tag;
+} bind_tags[] = {
+    {"counter", BIND_TAG_COUNTER}, {"counters", BIND_TAG_COUNTERS},
+    {"zone", BIND_TAG_ZONE},       {"name", BIND_TAG_NAME},
+    {"rrset", BIND_TAG_RRSET},     {"zones", BIND_TAG_ZONES},
+    {"view", BIND_TAG_VIEW},       {"views", BIND_TAG_VIEWS},
+    {"cache", BIND_TAG_CACHE},     {"server", BIND_TAG_SERVER},
+    {"current-time", BIND_TAG_CURRENT_TIME},
+    {"memory", BIND_TAG_MEMORY},   {"summary", BIND_TAG_SUMMARY},
+    {"statistics", BIND_TAG_STATISTICS},
+};
+
+/* Element paths, starting at the root element, the streaming parser acts on.
+ */
+static const bind_tag_t path_current_time[] = {
+    BIND_TAG_STATISTICS, BIND_TAG_SERVER, BIND_TAG_CURRENT_TIME};
+static const bind_tag_t path_server_counters[] = {
+    BIND_TAG_STATISTICS, BIND_TAG_SERVER, BIND_TAG_COUNTERS};
+static const bind_tag_t path_view[] = {BIND_TAG_STATISTICS, BIND_TAG_VIEWS,
+                                       BIND_TAG_VIEW};
+static const bind_tag_t path_view_counters[] = {
+    BIND_TAG_STATISTICS, BIND_TAG_VIEWS, BIND_TAG_VIEW, BIND_TAG_COUNTERS};
+static const bind_tag_t path_rrset[] = {BIND_TAG_STATISTICS, BIND_TAG_VIEWS,
+                                        BIND_TAG_VIEW, BIND_TAG_CACHE,
+                                        BIND_TAG_RRSET};
+static const bind_tag_t path_zone[] = {BIND_TAG_STATISTICS, BIND_TAG_VIEWS,
+                                       BIND_TAG_VIEW, BIND_TAG_ZONES,
+                                       BIND_TAG_ZONE};
+static const bind_tag_t path_zone_counters[] = {
+    BIND_TAG_STATISTICS, BIND_TAG_VIEWS,   BIND_TAG_VIEW,
+    BIND_TAG_ZONES,      BIND_TAG_ZONE,    BIND_TAG_COUNTERS};
+static const bind_tag_t path_memory_summary[] = {
+    BIND_TAG_STATISTICS, BIND_TAG_MEMORY, BIND_TAG_SUMMARY};
+
+#define BIND_STREAM_MAX_DEPTH 16
+
+typedef enum {
+  BIND_STREAM_UNKNOWN, /* root element has not been seen yet */
+  BIND_STREAM_V3,      /* values are extracted while the document streams in */
+  BIND_STREAM_DOM,     /* older version, parsed by bind_xml() once received */
+} bind_stream_mode_t;
+
+typedef enum {
+  BIND_TEXT_NONE,
+  BIND_TEXT_CURRENT_TIME,
+  BIND_TEXT_COUNTER,
+  BIND_TEXT_RRSET_NAME,
+  BIND_TEXT_RRSET_COUNTER,
+} bind_text_t;
+
+typedef struct {
+  bind_stream_mode_t mode;
+  xmlParserCtxt *ctxt;
+  time_t current_time;
+  /* Values are only dispatched once <current-time> has been read; the read
+   * fails if it is missing, like it does for bind_xml(). */
+  bool have_current_time;
+
+  /* Tags of the currently open elements. Only the first
+   * BIND_STREAM_MAX_DEPTH levels are recorded. */
+  bind_tag_t path[BIND_STREAM_MAX_DEPTH];
+  int depth;
+
+  /* Configured view / zone the parser is in, if any. */
+  cb_view_t *view;
+  char zone_instance[DATA_MAX_NAME_LEN];
+
+  /* Destination of the <counter> elements of the open <counters> element.
+   * NULL if these counters are not collected. */
+  list_callback_t counters_callback;
+  void *counters_user_data;
+  int counters_ds_type;
+  char counters_plugin_instance[DATA_MAX_NAME_LEN];
+  translation_table_ptr_t counters_table;
+  list_info_ptr_t counters_list;
+
+  /* Text of the leaf element being read. */
+  bind_text_t text_type;
+  int text_depth;
+  char text[64];
+  size_t text_len;
+  char text_name[DATA_MAX_NAME_LEN];
+
+  char rrset_name[DATA_MAX_NAME_LEN];
+  char rrset_counter[64];
+} bind_stream_t;
+
+static bind_stream_t bind_stream;
+
+static bind_tag_t bind_stream_tag(const xmlChar *name) /* {{{ */
+{
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(bind_tags); i++)
+    if (strcmp((const char *)name, bind_tags[i].name) == 0)
+      return bind_tags[i].tag;
+  return BIND_TAG_OTHER;
+} /* }}} bind_tag_t bind_stream_tag */
+
+/* Returns true if the open elements are exactly `path'. */
+static bool bind_stream_at(const bind_stream_t *s, /* {{{ */
+                           const bind_tag_t *path, int path_len) {
+  if ((s->depth != path_len) || (path_len > BIND_STREAM_MAX_DEPTH))
+    return false;
+  return memcmp(s->path, path, sizeof(*path) * path_len) == 0;
+} /* }}} bool bind_stream_at */
+
+/* Returns true if the parent of the current element is at `path'. */
+static bool bind_stream_in(const bind_stream_t *s, /* {{{ */
+                           const bind_tag_t *path, int path_len) {
+  if ((s->depth != path_len + 1) || (path_len > BIND_STREAM_MAX_DEPTH))
+    return false;
+  return memcmp(s->path, path, sizeof(*path) * path_len) == 0;
+} /* }}} bool bind_stream_in */
+
+#define BIND_STREAM_AT(s, p) bind_stream_at((s), (p), STATIC_ARRAY_SIZE(p))
+#define BIND_STREAM_IN(s, p) bind_stream_in((s), (p), STATIC_ARRAY_SIZE(p))
+
+/* Returns the value of attribute `name' or copies nothing if it is missing.
+ * SAX2 attributes are not null-terminated. */
+static bool bind_stream_attr(const xmlChar **attributes, /* {{{ */
+                             int nb_attributes, const char *name, char *buffer,
+                             size_t buffer_size) {
+  for (int i = 0; i < nb_attributes; i++) {
+    const xmlChar **attr = attributes + 5 * i;
+    if (strcmp((const char *)attr[0], name) != 0)
+      continue;
+
+    size_t len = (size_t)(attr[4] - attr[3]);
+    if (len >= buffer_size)
+      len = buffer_size - 1;
+    memcpy(buffer, attr[3], len);
+    buffer[len] = 0;
+    return true;
+  }
+  return false;
+} /* }}} bool bind_stream_attr */
+
+static void bind_stream_counters_list(bind_stream_t *s, /* {{{ */
+                                      const char *type) {
+  s->counters_list = (list_info_ptr_t){s->counters_plugin_instance, type};
+  s->counters_callback = bind_xml_list_callback;
+  s->counters_user_data = &s->counters_list;
+} /* }}} void bind_stream_counters_list */
+
+static void bind_stream_counters_table(bind_stream_t *s, /* {{{ */
+                                       const translation_info_t *table,
+                                       size_t table_length) {
+  s->counters_table = (translation_table_ptr_t){table, table_length,
+                                                s->counters_plugin_instance};
+  s->counters_callback = bind_xml_table_callback;
+  s->counters_user_data = &s->counters_table;
+} /* }}} void bind_stream_counters_table */
+
+/* Selects the destination of the counters in a <counters type="..."> block. */
+static void bind_stream_counters(bind_stream_t *s, const char *type) /* {{{ */
+{
+  char *pi = s->counters_plugin_instance;
+  size_t pi_size = sizeof(s->counters_plugin_instance);
+
+  s->counters_callback = NULL;
+  s->counters_ds_type = DS_TYPE_COUNTER;
+
+  if (BIND_STREAM_AT(s, path_server_counters)) {
+    if (global_opcodes && (strcmp("opcode", type) == 0)) {
+      sstrncpy(pi, "global-opcodes", pi_size);
+      bind_stream_counters_list(s, "dns_opcode");
+    } else if (global_qtypes && (strcmp("qtype", type) == 0)) {
+      sstrncpy(pi, "global-qtypes", pi_size);
+      bind_stream_counters_list(s, "dns_qtype");
+    } else if (global_server_stats && (strcmp("nsstat", type) == 0)) {
+      sstrncpy(pi, "global-server_stats", pi_size);
+      bind_stream_counters_table(s, nsstats_translation_table,
+                                 nsstats_translation_table_length);
+    } else if (global_zone_maint_stats && (strcmp("zonestat", type) == 0)) {
+      sstrncpy(pi, "global-zone_maint_stats", pi_size);
+      bind_stream_counters_table(s, zonestats_translation_table,
+                                 zonestats_translation_table_length);
+    } else if (global_resolver_stats && (strcmp("resstat", type) == 0)) {
+      sstrncpy(pi, "global-resolver_stats", pi_size);
+      bind_stream_counters_table(s, resstats_translation_table,
+                                 resstats_translation_table_length);
+    }
+  } else if ((s->view != NULL) && BIND_STREAM_AT(s, path_view_counters)) {
+    if (s->view->qtypes && (strcmp("resqtype", type) == 0)) {
+      snprintf(pi, pi_size, "%s-qtypes", s->view->name);
+      bind_stream_counters_list(s, "dns_qtype");
+    } else if (s->view->resolver_stats && (strcmp("resstats", type) == 0)) {
+      snprintf(pi, pi_size, "%s-resolver_stats", s->view->name);
+      bind_stream_counters_table(s, resstats_translation_table,
+                                 resstats_translation_table_length);
+    }
+  } else if ((s->zone_instance[0] != 0) &&
+             BIND_STREAM_AT(s, path_zone_counters)) {
+    sstrncpy(pi, s->zone_instance, pi_size);
+    if (strcmp("rcode", type) == 0)
+      bind_stream_counters_table(s, nsstats_translation_table,
+                                 nsstats_translation_table_length);
+    else if (strcmp("qtype", type) == 0)
+      bind_stream_counters_list(s, "dns_qtype");
+  }
+} /* }}} void bind_stream_counters */
+
+static void bind_stream_zone(bind_stream_t *s, const xmlChar **attributes,
+                             int nb_attributes) /* {{{ */
+{
+  char name[DATA_MAX_NAME_LEN];
+  char rdataclass[DATA_MAX_NAME_LEN];
+  char zone_name[2 * DATA_MAX_NAME_LEN];
+
+  s->zone_instance[0] = 0;
+
+  if (!bind_stream_attr(attributes, nb_attributes, "name", name,
+                        sizeof(name)) ||
+      !bind_stream_attr(attributes, nb_attributes, "rdataclass", rdataclass,
+                        sizeof(rdataclass))) {
+    ERROR("bind plugin: Could not determine zone name.");
+    return;
+  }
+  snprintf(zone_name, sizeof(zone_name), "%s/%s", name, rdataclass);
+
+  for (size_t i = 0; i < s->view->zones_num; i++) {
+    if (strcasecmp(zone_name, s->view->zones[i]) != 0)
+      continue;
+
+    DEBUG("bind plugin: bind_stream_zone: Found zone `%s'.",
+          s->view->zones[i]);
+    snprintf(s->zone_instance, sizeof(s->zone_instance), "%s-zone-%s",
+             s->view->name, s->view->zones[i]);
+    return;
+  }
+} /* }}} void bind_stream_zone */
+
+static void bind_stream_text_begin(bind_stream_t *s, /* {{{ */
+                                   bind_text_t type) {
+  s->text_type = type;
+  s->text_depth = s->depth;
+  s->text_len = 0;
+  s->text[0] = 0;
+} /* }}} void bind_stream_text_begin */
+
+static void bind_stream_start_element(/* {{{ */
+                                      void *ctx, const xmlChar *localname,
+                                      const xmlChar __attribute__((unused)) *
+                                          prefix,
+                                      const xmlChar __attribute__((unused)) *
+                                          URI,
+                                      int __attribute__((unused)) nb_namespaces,
+                                      const xmlChar __attribute__((unused)) *
+                                          *namespaces,
+                                      int nb_attributes,
+                                      int __attribute__((unused)) nb_defaulted,
+                                      const xmlChar **attributes) {
+  bind_stream_t *s = ctx;
+  bind_tag_t tag = bind_stream_tag(localname);
+
+  s->depth++;
+  if (s->depth <= BIND_STREAM_MAX_DEPTH)
+    s->path[s->depth - 1] = tag;
+
+  if (s->depth == 1) {
+    char version[16] = "";
+    bind_stream_attr(attributes, nb_attributes, "version", version,
+                     sizeof(version));
+    if ((tag == BIND_TAG_STATISTICS) && (strncmp("3.", version, 2) == 0)) {
+      DEBUG("bind plugin: Found: <statistics version=\"%s\">", version);
+      s->mode = BIND_STREAM_V3;
+    } else {
+      s->mode = BIND_STREAM_DOM;
+      xmlStopParser(s->ctxt);
+    }
+    return;
+  }
+
+  switch (tag) {
+  case BIND_TAG_CURRENT_TIME:
+    if (BIND_STREAM_AT(s, path_current_time))
+      bind_stream_text_begin(s, BIND_TEXT_CURRENT_TIME);
+    break;
+
+  case BIND_TAG_COUNTERS: {
+    char type[DATA_MAX_NAME_LEN];
+    if (bind_stream_attr(attributes, nb_attributes, "type", type,
+                         sizeof(type)))
+      bind_stream_counters(s, type);
+    break;
+  }
+
+  case BIND_TAG_COUNTER:
+    if ((s->counters_callback != NULL) &&
+        (s->depth - 2 < BIND_STREAM_MAX_DEPTH) &&
+        (s->path[s->depth - 2] == BIND_TAG_COUNTERS) &&
+        bind_stream_attr(attributes, nb_attributes, "name", s->text_name,
+                         sizeof(s->text_name)))
+      bind_stream_text_begin(s, BIND_TEXT_COUNTER);
+    else if ((s->view != NULL) && BIND_STREAM_IN(s, path_rrset))
+      bind_stream_text_begin(s, BIND_TEXT_RRSET_COUNTER);
+    break;
+
+  case BIND_TAG_NAME:
+    if ((s->view != NULL) && BIND_STREAM_IN(s, path_rrset))
+      bind_stream_text_begin(s, BIND_TEXT_RRSET_NAME);
+    break;
+
+  case BIND_TAG_VIEW:
+    if (BIND_STREAM_AT(s, path_view)) {
+      char name[DATA_MAX_NAME_LEN];
+      s->view = NULL;
+      if (!bind_stream_attr(attributes, nb_attributes, "name", name,
+                            sizeof(name))) {
+        ERROR("bind plugin: Could not determine view name.");
+        break;
+      }
+      for (size_t i = 0; i < views_num; i++)
+        if (strcasecmp(name, views[i].name) == 0)
+          s->view = views + i;
+    }
+    break;
+
+  case BIND_TAG_ZONE:
+    if ((s->view != NULL) && (s->view->zones_num > 0) &&
+        BIND_STREAM_AT(s, path_zone))
+      bind_stream_zone(s, attributes, nb_attributes);
+    break;
+
+  case BIND_TAG_RRSET:
+    if ((s->view != NULL) && BIND_STREAM_AT(s, path_rrset)) {
+      s->rrset_name[0] = 0;
+      s->rrset_counter[0] = 0;
+    }
+    break;
+
+  default:
+    /* Children of <memory><summary> are named after the value. */
+    if (global_memory_stats && BIND_STREAM_IN(s, path_memory_summary)) {
+      sstrncpy(s->text_name, (const char *)localname, sizeof(s->text_name));
+      bind_stream_text_begin(s, BIND_TEXT_COUNTER);
+      s->counters_ds_type = DS_TYPE_GAUGE;
+      sstrncpy(s->counters_plugin_instance, "global-memory_stats",
+               sizeof(s->counters_plugin_instance));
+      bind_stream_counters_table(s, memsummary_translation_table,
+                                 memsummary_translation_table_length);
+    }
+    break;
+  }
+} /* }}} void bind_stream_start_element */
+
+static void bind_stream_text_end(bind_stream_t *s) /* {{{ */
+{
+  value_t value;
+
+  switch (s->text_type) {
+  case BIND_TEXT_CURRENT_TIME:
+    s->have_current_time =
+        (bind_parse_timestamp(s->text, &s->current_time) == 0);
+    DEBUG("bind plugin: Current server time is %i.", (int)s->current_time);
+    break;
+
+  case BIND_TEXT_COUNTER:
+    /* Like bind_parse_generic_value_list() and friends, everything but
+     * gauges is read with bind_xml_read_derive()'s semantics. */
+    if (s->have_current_time &&
+        (parse_value(s->text, &value,
+                     (s->counters_ds_type == DS_TYPE_GAUGE)
+                         ? DS_TYPE_GAUGE
+                         : DS_TYPE_DERIVE) == 0))
+      (*s->counters_callback)(s->text_name, value, s->current_time,
+                              s->counters_user_data);
+    break;
+
+  case BIND_TEXT_RRSET_NAME:
+    sstrncpy(s->rrset_name, s->text, sizeof(s->rrset_name));
+    break;
+
+  case BIND_TEXT_RRSET_COUNTER:
+    sstrncpy(s->rrset_counter, s->text, sizeof(s->rrset_counter));
+    break;
+
+  case BIND_TEXT_NONE:
+    break;
+  }
+
+  s->text_type = BIND_TEXT_NONE;
+} /* }}} void bind_stream_text_end */
+
+static void bind_stream_end_element(/* {{{ */
+                                    void *ctx,
+                                    const xmlChar __attribute__((unused)) *
+                                        localname,
+                                    const xmlChar __attribute__((unused)) *
+                                        prefix,
+                                    const xmlChar __attribute__((unused)) *
+                                        URI) {
+  bind_stream_t *s = ctx;
+  bind_tag_t tag = (s->depth <= BIND_STREAM_MAX_DEPTH) ? s->path[s->depth - 1]
+                                                        : BIND_TAG_OTHER;
+
+  if ((s->text_type != BIND_TEXT_NONE) && (s->text_depth == s->depth))
+    bind_stream_text_end(s);
+
+  if ((tag == BIND_TAG_COUNTERS) || BIND_STREAM_IN(s, path_memory_summary))
+    s->counters_callback = NULL;
+  else if ((tag == BIND_TAG_VIEW) && BIND_STREAM_AT(s, path_view))
+    s->view = NULL;
+  else if ((tag == BIND_TAG_ZONE) && BIND_STREAM_AT(s, path_zone))
+    s->zone_instance[0] = 0;
+  else if ((tag == BIND_TAG_RRSET) && (s->view != NULL) &&
+           s->view->cacherrsets && s->have_current_time &&
+           BIND_STREAM_AT(s, path_rrset) &&
+           (s->rrset_name[0] != 0) && (s->rrset_counter[0] != 0)) {
+    char plugin_instance[DATA_MAX_NAME_LEN];
+    list_info_ptr_t list_info = {plugin_instance,
+                                 /* type = */ "dns_qtype_cached"};
+    value_t value;
+
+    snprintf(plugin_instance, sizeof(plugin_instance), "%s-cache_rr_sets",
+             s->view->name);
+    if (parse_value(s->rrset_counter, &value, DS_TYPE_GAUGE) == 0)
+      bind_xml_list_callback(s->rrset_name, value, s->current_time,
+                             &list_info);
+  }
+
+  s->depth--;
+} /* }}} void bind_stream_end_element */
+
+static void bind_stream_characters(void *ctx, const xmlChar *ch, /* {{{ */
+                                   int len) {
+  bind_stream_t *s = ctx;
+
+  if (s->text_type == BIND_TEXT_NONE)
+    return;
+
+  size_t n = (size_t)len;
+  if (n > sizeof(s->text) - 1 - s->text_len)
+    n = sizeof(s->text) - 1 - s->text_len;
+  memcpy(s->text + s->text_len, ch, n);
+  s->text_len += n;
+  s->text[s->text_len] = 0;
+} /* }}} void bind_stream_characters */
+
+static xmlSAXHandler bind_stream_sax = {
+    .initialized = XML_SAX2_MAGIC,
+    .startElementNs = bind_stream_start_element,
+    .endElementNs = bind_stream_end_element,
+    .characters = bind_stream_characters,
+};
+
+static int bind_stream_begin(bind_stream_t *s) /* {{{ */
+{
+  if (s->ctxt != NULL)
+    xmlFreeParserCtxt(s->ctxt);
+
+  memset(s, 0, sizeof(*s));
+  s->ctxt = xmlCreatePushParserCtxt(&bind_stream_sax, s, /* chunk = */ NULL,
+                                    /* size = */ 0, /* filename = */ NULL);
+  if (s->ctxt == NULL) {
+    ERROR("bind plugin: xmlCreatePushParserCtxt failed.");
+    return -1;
+  }
+  xmlCtxtUseOptions(s->ctxt, XML_PARSE_NONET);
+
+  return 0;
+} /* }}} int bind_stream_begin */
+
+/* Feeds a chunk of the document to the streaming parser. `terminate' is true
+ * for the last call, which has no data. */
+static int bind_stream_feed(bind_stream_t *s, const char *data, /* {{{ */
+                            size_t len, bool terminate) {
+  if ((s->ctxt == NULL) || (s->mode == BIND_STREAM_DOM))
+    return 0;
+
+  int status = xmlParseChunk(s->ctxt, data, (int)len, terminate ? 1 : 0);
+  if (s->mode == BIND_STREAM_DOM)
+    return 0;
+  if (status != 0) {
+    const xmlError *err = xmlCtxtGetLastError(s->ctxt);
+    ERROR("bind plugin: Parsing the statistics failed: %s",
+          ((err != NULL) && (err->message != NULL)) ? err->message
+                                                    : "unknown error");
+    return -1;
+  }
+
+  return 0;
+} /* }}} int bind_stream_feed */
+
+static void bind_stream_end(bind_stream_t *s) /* {{{ */
+{
+  if (s->ctxt != NULL)
+    xmlFreeParserCtxt(s->ctxt);
+  s->ctxt = NULL;
+} /* }}} void bind_stream_end */
+
+static size_t bind_curl_callback(char *buf, size_t size, /* {{{ */
+                                 size_t nmemb,
+                                 void __attribute__((unused)) * stream) {
+  size_t len = size * nmemb;
+
+  if (len == 0)
+    return len;
+
+  if (bind_stream_feed(&bind_stream, buf, len, /* terminate = */ false) != 0)
+    return 0;
+
+  /* Version 3 documents are consumed by the streaming parser. Until the root
+   * element has been seen, and for older versions, the document is kept for
+   * bind_xml(). */
+  if (bind_stream.mode == BIND_STREAM_V3) {
+    bind_buffer_fill = 0;
+    return len;
+  }
+
+  if ((bind_buffer_fill + len) >= bind_buffer_size) {
+    char *temp = realloc(bind_buffer, bind_buffer_fill + len + 1);
+    if (temp == NULL) {
+      ERROR("bind plugin: realloc failed.");
+      return 0;
+    }
+    bind_buffer = temp;
+    bind_buffer_size = bind_buffer_fill + len + 1;
+  }
+
+  memcpy(bind_buffer + bind_buffer_fill, buf, len);
+  bind_buffer_fill += len;
+  bind_buffer[bind_buffer_fill] = 0;
+
+  return len;
+} /* }}} size_t bind_curl_callback */
+
 static int bind_config_add_view_zone(cb_view_t *view, /* {{{ */
                                      oconfig_item_t *ci) {
   if ((ci->values_num != 1) || (ci->values[0].type != OCONFIG_TYPE_STRING)) {
@@ -1546,6 +2084,41 @@ static int bind_init(void) /* {{{ */
   return 0;
 } /* }}} int bind_init */
 
+/* Completes the parse of a received document, either by the streaming parser
+ * or by bind_xml(). */
+static int bind_parse_document(void) /* {{{ */
+{
+  int status = bind_stream_feed(&bind_stream, NULL, 0, /* terminate = */ true);
+  bind_stream_mode_t mode = bind_stream.mode;
+  bool have_current_time = bind_stream.have_current_time;
+  bind_stream_end(&bind_stream);
+  if (status != 0)
+    return -1;
+
+  if (mode == BIND_STREAM_V3) {
+    if (!have_current_time) {
+      ERROR("bind plugin: Reading `server/current-time' failed.");
+      return -1;
+    }
+    return 0;
+  }
+
+  return bind_xml(bind_buffer);
+} /* }}} int bind_parse_document */
+
+/* Called by the cURL engine once the statistics have been received. */
+static void bind_page_done(__attribute__((unused)) CURL *c, /* {{{ */
+                           CURLcode code,
+                           __attribute__((unused)) void *user_data) {
+  if (code != CURLE_OK) {
+    ERROR("bind plugin: curl_easy_perform failed: %s", bind_curl_error);
+    bind_stream_end(&bind_stream);
+    return;
+  }
+
+  bind_parse_document();
+} /* }}} void bind_page_done */
+
 static int bind_read(void) /* {{{ */
 {
   if (curl == NULL) {
@@ -1553,28 +2126,44 @@ static int bind_read(void) /* {{{ */
     return -1;
   }
 
+  char const *u = (url != NULL) ? url : BIND_DEFAULT_URL;
+
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(curl, &submitted);
+  if (skipped > 0) {
+    WARNING("bind plugin: The request to `%s' has not finished after %.3f "
+            "seconds, skipping this interval (%u skipped so far).",
+            u, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
   bind_buffer_fill = 0;
+  if (bind_stream_begin(&bind_stream) != 0)
+    return -1;
 
-  curl_easy_setopt(curl, CURLOPT_URL, (url != NULL) ? url : BIND_DEFAULT_URL);
+  curl_easy_setopt(curl, CURLOPT_URL, u);
 
-  if (curl_easy_perform(curl) != CURLE_OK) {
-    ERROR("bind plugin: curl_easy_perform failed: %s", bind_curl_error);
+  int status = curl_engine_submit(curl, bind_curl_callback,
+                                  /* write_data = */ NULL, bind_page_done,
+                                  /* user_data = */ NULL);
+  if (status != 0) {
+    ERROR("bind plugin: Submitting request to `%s' failed: %s", u,
+          STRERROR(status));
+    bind_stream_end(&bind_stream);
     return -1;
   }
 
-  int status = bind_xml(bind_buffer);
-  if (status != 0)
-    return -1;
-  else
-    return 0;
+  return 0;
 } /* }}} int bind_read */
 
 static int bind_shutdown(void) /* {{{ */
 {
   if (curl != NULL) {
+    curl_engine_cancel(curl);
     curl_easy_cleanup(curl);
     curl = NULL;
   }
+  bind_stream_end(&bind_stream);
 
   return 0;
 } /* }}} int bind_shutdown */
@@ -1582,6 +2171,7 @@ static int bind_shutdown(void) /* {{{ */
 void module_register(void) {
   plugin_register_complex_config("bind", bind_config);
   plugin_register_init("bind", bind_init);
+  plugin_register_init_exclusive("bind");
   plugin_register_read("bind", bind_read);
   plugin_register_shutdown("bind", bind_shutdown);
 } /* void module_register */
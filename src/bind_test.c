@@ -0,0 +1,228 @@
+/**
+ * collectd - src/bind_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#define plugin_dispatch_values plugin_dispatch_values_bind_test
+
+#include "bind.c" /* sic */
+#include "testing.h"
+
+#define FIXTURE_HEAD                                                           \
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"                               \
+  "<statistics version=\"3.8\">\n"                                             \
+  "  <server>\n"                                                               \
+  "    <boot-time>2026-10-01T08:00:00.000Z</boot-time>\n"
+#define FIXTURE_CURRENT_TIME                                                   \
+  "    <current-time>2026-10-18T12:34:56.789Z</current-time>\n"
+#define FIXTURE_BODY                                                           \
+  "    <version>9.16.1</version>\n"                                            \
+  "    <counters type=\"opcode\">\n"                                           \
+  "      <counter name=\"QUERY\">18446744073709551615</counter>\n"             \
+  "      <counter name=\"NOTIFY\">3</counter>\n"                               \
+  "    </counters>\n"                                                          \
+  "    <counters type=\"qtype\">\n"                                            \
+  "      <counter name=\"A\">1204</counter>\n"                                 \
+  "      <counter name=\"AAAA\">337</counter>\n"                               \
+  "    </counters>\n"                                                          \
+  "    <counters type=\"nsstat\">\n"                                           \
+  "      <counter name=\"Requestv4\">1541</counter>\n"                         \
+  "      <counter name=\"QrySuccess\">1020</counter>\n"                        \
+  "      <counter name=\"NotInTheTable\">7</counter>\n"                        \
+  "    </counters>\n"                                                          \
+  "    <counters type=\"zonestat\">\n"                                         \
+  "      <counter name=\"NotifyOutv4\">12</counter>\n"                         \
+  "    </counters>\n"                                                          \
+  "    <counters type=\"resstat\">\n"                                          \
+  "      <counter name=\"Queryv4\">88</counter>\n"                             \
+  "    </counters>\n"                                                          \
+  "  </server>\n"                                                              \
+  "  <views>\n"                                                                \
+  "    <view name=\"_default\">\n"                                             \
+  "      <counters type=\"resqtype\">\n"                                       \
+  "        <counter name=\"A\">55</counter>\n"                                 \
+  "      </counters>\n"                                                        \
+  "      <counters type=\"resstats\">\n"                                       \
+  "        <counter name=\"Lame\">2</counter>\n"                               \
+  "        <counter name=\"ValOk\">41</counter>\n"                             \
+  "      </counters>\n"                                                        \
+  "      <zones>\n"                                                            \
+  "        <zone name=\"example.com\" rdataclass=\"IN\">\n"                    \
+  "          <serial>2026101801</serial>\n"                                    \
+  "          <counters type=\"rcode\">\n"                                      \
+  "            <counter name=\"QrySuccess\">17</counter>\n"                    \
+  "          </counters>\n"                                                    \
+  "          <counters type=\"qtype\">\n"                                      \
+  "            <counter name=\"MX\">4</counter>\n"                             \
+  "          </counters>\n"                                                    \
+  "        </zone>\n"                                                          \
+  "        <zone name=\"example.org\" rdataclass=\"IN\">\n"                    \
+  "          <counters type=\"rcode\">\n"                                      \
+  "            <counter name=\"QrySuccess\">99</counter>\n"                    \
+  "          </counters>\n"                                                    \
+  "        </zone>\n"                                                          \
+  "      </zones>\n"                                                           \
+  "      <cache name=\"_default\">\n"                                          \
+  "        <rrset><name>A</name><counter>23</counter></rrset>\n"               \
+  "        <rrset><name>!NS</name><counter>5</counter></rrset>\n"              \
+  "      </cache>\n"                                                           \
+  "    </view>\n"                                                              \
+  "  </views>\n"                                                               \
+  "  <memory>\n"                                                               \
+  "    <summary>\n"                                                            \
+  "      <TotalUse>6587096</TotalUse>\n"                                       \
+  "      <InUse>1345424</InUse>\n"                                             \
+  "    </summary>\n"                                                           \
+  "  </memory>\n"                                                              \
+  "</statistics>\n"
+
+static char const fixture[] = FIXTURE_HEAD FIXTURE_CURRENT_TIME FIXTURE_BODY;
+static char const fixture_no_time[] = FIXTURE_HEAD FIXTURE_BODY;
+
+#define MAX_DISPATCHED 64
+static char dispatched[MAX_DISPATCHED][512];
+static size_t dispatched_num;
+
+int plugin_dispatch_values_bind_test(value_list_t const *vl) {
+  if (dispatched_num >= MAX_DISPATCHED)
+    return ENOMEM;
+
+  /* The raw value is compared, so that a value parsed with a different data
+   * source type or dropped by the parser shows up as a difference. */
+  snprintf(dispatched[dispatched_num], sizeof(dispatched[dispatched_num]),
+           "%s/%s/%s=%" PRIu64 "@%.3f", vl->plugin_instance, vl->type,
+           vl->type_instance, (uint64_t)vl->values[0].counter,
+           CDTIME_T_TO_DOUBLE(vl->time));
+  dispatched_num++;
+  return 0;
+}
+
+static int dispatched_compare(void const *a, void const *b) {
+  return strcmp(a, b);
+}
+
+static char *zones[] = {"example.com/IN"};
+static cb_view_t test_view = {
+    .name = "_default",
+    .qtypes = 1,
+    .resolver_stats = 1,
+    .cacherrsets = 1,
+    .zones = zones,
+    .zones_num = STATIC_ARRAY_SIZE(zones),
+};
+
+/* Passes the document to the callback the way libcurl would, in small chunks
+ * so that elements are split across calls. */
+static int parse_stream(char const *doc) {
+  bind_buffer_fill = 0;
+  if (bind_stream_begin(&bind_stream) != 0)
+    return -1;
+
+  size_t len = strlen(doc);
+  for (size_t off = 0; off < len; off += 13) {
+    size_t n = (len - off < 13) ? len - off : 13;
+    if (bind_curl_callback((void *)(doc + off), 1, n, NULL) != n) {
+      bind_stream_end(&bind_stream);
+      return -1;
+    }
+  }
+
+  return bind_parse_document();
+}
+
+DEF_TEST(stream_matches_dom) {
+  char dom[MAX_DISPATCHED][512];
+
+  dispatched_num = 0;
+  CHECK_ZERO(bind_xml(fixture));
+  size_t dom_num = dispatched_num;
+  memcpy(dom, dispatched, sizeof(dom));
+  /* The DOM parser evaluates one XPath expression after the other, so the
+   * order differs from the document order. */
+  qsort(dom, dom_num, sizeof(dom[0]), dispatched_compare);
+
+  dispatched_num = 0;
+  CHECK_ZERO(parse_stream(fixture));
+  EXPECT_EQ_INT(BIND_STREAM_V3, bind_stream.mode);
+  qsort(dispatched, dispatched_num, sizeof(dispatched[0]), dispatched_compare);
+
+  /* 2 opcodes, 2 qtypes, 2 nsstats, 1 zonestat, 1 resstat, 1 resqtype,
+   * 2 resstats, 2 zone counters, 2 rrsets and 2 memory values. */
+  EXPECT_EQ_INT(17, (int)dom_num);
+  EXPECT_EQ_INT((int)dom_num, (int)dispatched_num);
+  for (size_t i = 0; (i < dom_num) && (i < dispatched_num); i++)
+    EXPECT_EQ_STR(dom[i], dispatched[i]);
+
+  /* Both parsers read counters the way bind_xml_read_derive() does. */
+  bool found = false;
+  for (size_t i = 0; i < dispatched_num; i++)
+    if (strcmp("global-opcodes/dns_opcode/QUERY=9223372036854775807"
+               "@1792326896.000",
+               dispatched[i]) == 0)
+      found = true;
+  OK(found);
+
+  return 0;
+}
+
+DEF_TEST(missing_current_time) {
+  dispatched_num = 0;
+  EXPECT_EQ_INT(-1, bind_xml(fixture_no_time));
+  EXPECT_EQ_INT(0, (int)dispatched_num);
+
+  EXPECT_EQ_INT(-1, parse_stream(fixture_no_time));
+  EXPECT_EQ_INT(0, (int)dispatched_num);
+
+  return 0;
+}
+
+DEF_TEST(deep_nesting) {
+  char doc[4096] = FIXTURE_HEAD FIXTURE_CURRENT_TIME
+      "    <counters type=\"opcode\">\n";
+
+  for (int i = 0; i < 2 * BIND_STREAM_MAX_DEPTH; i++)
+    strncat(doc, "<x>", sizeof(doc) - strlen(doc) - 1);
+  strncat(doc, "<counter name=\"QUERY\">1</counter>",
+          sizeof(doc) - strlen(doc) - 1);
+  for (int i = 0; i < 2 * BIND_STREAM_MAX_DEPTH; i++)
+    strncat(doc, "</x>", sizeof(doc) - strlen(doc) - 1);
+  strncat(doc, "\n    </counters>\n  </server>\n</statistics>\n",
+          sizeof(doc) - strlen(doc) - 1);
+
+  /* Counters below the recorded depth are not inside <counters>. */
+  dispatched_num = 0;
+  CHECK_ZERO(parse_stream(doc));
+  EXPECT_EQ_INT(0, (int)dispatched_num);
+
+  return 0;
+}
+
+int main(void) {
+  views = &test_view;
+  views_num = 1;
+  global_resolver_stats = 1;
+
+  RUN_TEST(stream_matches_dom);
+  RUN_TEST(missing_current_time);
+  RUN_TEST(deep_nesting);
+
+  END_TEST;
+}
@@ -30,6 +30,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/key_trie/key_trie.h"
 
 #include <arpa/inet.h>
 #include <errno.h>
@@ -126,10 +127,20 @@ struct ceph_daemon {
   struct last_data **last_poll_data;
   /** index of last poll data */
   int last_idx;
+
+  /**
+   * Maps the keys of the perf counter dump, e.g. "osd" -> "op_latency" ->
+   * "sum", to the index of their counter. Built while parsing the schema.
+   */
+  key_trie_t *data_keys;
+  /** Last sum/count of latency counters found in data_keys, by ds index */
+  struct last_latency *ds_latency;
 };
 
 /******* JSON parsing *******/
 typedef int (*node_handler_t)(void *, const char *, const char *);
+/** Called with the counter index of keys found in yajl_struct.trie */
+typedef int (*counter_handler_t)(void *, const char *, const char *, int);
 
 /** Track state and handler while parsing JSON */
 struct yajl_struct {
@@ -139,9 +150,22 @@ struct yajl_struct {
   char *key;
   char *stack[YAJL_MAX_DEPTH];
   size_t depth;
+
+  /**
+   * Optional compiled keys. Numbers found in the trie are passed to
+   * counter_handler, all others to handler.
+   */
+  key_trie_t *trie;
+  counter_handler_t counter_handler;
+  key_trie_node_t *nodes[YAJL_MAX_DEPTH];
 };
 typedef struct yajl_struct yajl_struct;
 
+/* Counter indexes are stored in the trie as pointers; zero is reserved for
+ * "no value". */
+#define DS_INDEX_TO_PTR(i) ((void *)(intptr_t)((i) + 1))
+#define PTR_TO_DS_INDEX(p) ((int)((intptr_t)(p)-1))
+
 enum perfcounter_type_d {
   PERFCOUNTER_LATENCY = 0x4,
   PERFCOUNTER_DERIVE = 0x8,
@@ -160,6 +184,9 @@ static int long_run_latency_avg;
  */
 static int convert_special_metrics = 1;
 
+/** Give user option to report the time it takes to read each daemon */
+static int report_latency;
+
 /** Array of daemons to monitor */
 static struct ceph_daemon **g_daemons;
 
@@ -198,6 +225,21 @@ struct last_data {
   uint64_t last_count;
 };
 
+/** Same as last_data for counters that are looked up by index */
+struct last_latency {
+  double last_sum;
+  uint64_t last_count;
+  bool valid;
+};
+
+/** Part of a latency counter's avgcount/sum pair a value belongs to */
+enum latency_part_d {
+  LATENCY_OTHER = 0,
+  LATENCY_AVGCOUNT,
+  LATENCY_SUM,
+  LATENCY_AVGTIME,
+};
+
 /******* network I/O *******/
 enum cstate_t {
   CSTATE_UNCONNECTED = 0,
@@ -290,6 +332,21 @@ static int ceph_cb_number(void *ctx, const char *number_val,
     return CEPH_CB_CONTINUE;
   }
 
+  if ((state->trie != NULL) && (state->depth > 0) && (state->key != NULL)) {
+    key_trie_node_t *node = key_trie_child(state->nodes[state->depth - 1],
+                                           state->key, strlen(state->key));
+    void *value = key_trie_value(node);
+    if (value != NULL) {
+      status = state->counter_handler(state->handler_arg, buffer, state->key,
+                                      PTR_TO_DS_INDEX(value));
+      if (status != 0) {
+        ERROR("ceph plugin: JSON handler failed with status %d.", status);
+        return CEPH_CB_ABORT;
+      }
+      return CEPH_CB_CONTINUE;
+    }
+  }
+
   BUFFER_ADD(key, ".");
   BUFFER_ADD(key, state->key);
 
@@ -315,6 +372,16 @@ static int ceph_cb_start_map(void *ctx) {
   if (state->depth == YAJL_MAX_DEPTH)
     return CEPH_CB_ABORT;
 
+  if (state->trie != NULL) {
+    if (state->depth == 0)
+      state->nodes[0] = key_trie_root(state->trie);
+    else if (state->key != NULL)
+      state->nodes[state->depth] = key_trie_child(
+          state->nodes[state->depth - 1], state->key, strlen(state->key));
+    else
+      state->nodes[state->depth] = NULL;
+  }
+
   state->stack[state->depth] = state->key;
   state->depth++;
   state->key = NULL;
@@ -381,7 +448,8 @@ static void ceph_daemons_print(void) {
   }
 }
 
-static void ceph_daemon_free(struct ceph_daemon *d) {
+/** Free everything that has been learned from the daemon's schema */
+static void ceph_daemon_reset_schema(struct ceph_daemon *d) {
   for (int i = 0; i < d->last_idx; i++) {
     sfree(d->last_poll_data[i]);
   }
@@ -394,6 +462,15 @@ static void ceph_daemon_free(struct ceph_daemon *d) {
   }
   sfree(d->ds_types);
   sfree(d->ds_names);
+  sfree(d->ds_latency);
+  d->ds_num = 0;
+
+  key_trie_destroy(d->data_keys, NULL);
+  d->data_keys = NULL;
+}
+
+static void ceph_daemon_free(struct ceph_daemon *d) {
+  ceph_daemon_reset_schema(d);
   sfree(d);
 }
 
@@ -539,6 +616,47 @@ static int parse_keys(char *buffer, size_t buffer_size, const char *key_str) {
   return compact_ds_name(buffer, buffer_size, tmp);
 }
 
+/**
+ * Add the keys under which the perf counter dump reports the counter described
+ * by the schema entry `name', e.g. "osd.op_r.type", to the daemon's data keys.
+ * Keys that are not added are still handled by node_handler_fetch_data.
+ */
+static int ceph_daemon_add_data_keys(struct ceph_daemon *d, const char *name,
+                                     int pc_type, int ds_index) {
+  const char *latency_suffixes[] = {".avgcount", ".sum", ".avgtime"};
+  char path[2 * DATA_MAX_NAME_LEN];
+
+  if ((count_parts(name) <= 2) || !has_suffix(name, ".type"))
+    return 0;
+
+  if (d->data_keys == NULL) {
+    d->data_keys = key_trie_create(/* wildcard = */ NULL);
+    if (d->data_keys == NULL)
+      return -ENOMEM;
+  }
+
+  cut_suffix(path, sizeof(path), name, ".type");
+
+  /* Latency counters are reported as an avgcount/sum/avgtime tuple, all other
+   * counters as a single value. If a key is already taken, the first counter
+   * wins, like the index based lookup. */
+  if (!(pc_type & PERFCOUNTER_LATENCY)) {
+    int status =
+        key_trie_insert(d->data_keys, path, '.', DS_INDEX_TO_PTR(ds_index));
+    return (status == ENOMEM) ? -ENOMEM : 0;
+  }
+
+  size_t path_len = strlen(path);
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(latency_suffixes); i++) {
+    sstrncpy(path + path_len, latency_suffixes[i], sizeof(path) - path_len);
+    int status =
+        key_trie_insert(d->data_keys, path, '.', DS_INDEX_TO_PTR(ds_index));
+    if (status == ENOMEM)
+      return -ENOMEM;
+  }
+  return 0;
+}
+
 /**
  * while parsing ceph admin socket schema, save counter name and type for later
  * data processing
@@ -547,6 +665,7 @@ static int ceph_daemon_add_ds_entry(struct ceph_daemon *d, const char *name,
                                     int pc_type) {
   uint32_t type;
   char ds_name[DATA_MAX_NAME_LEN];
+  int schema_pc_type = pc_type;
 
   if (convert_special_metrics) {
     /**
@@ -572,6 +691,13 @@ static int ceph_daemon_add_ds_entry(struct ceph_daemon *d, const char *name,
     return -ENOMEM;
   }
 
+  d->ds_latency =
+      realloc(d->ds_latency, sizeof(*d->ds_latency) * (d->ds_num + 1));
+  if (!d->ds_latency) {
+    return -ENOMEM;
+  }
+  d->ds_latency[d->ds_num] = (struct last_latency){0};
+
   d->ds_names[d->ds_num] = malloc(DATA_MAX_NAME_LEN);
   if (!d->ds_names[d->ds_num]) {
     return -ENOMEM;
@@ -589,7 +715,7 @@ static int ceph_daemon_add_ds_entry(struct ceph_daemon *d, const char *name,
   sstrncpy(d->ds_names[d->ds_num], ds_name, DATA_MAX_NAME_LEN - 1);
   d->ds_num = (d->ds_num + 1);
 
-  return 0;
+  return ceph_daemon_add_data_keys(d, name, schema_pc_type, d->ds_num - 1);
 }
 
 /******* ceph_config *******/
@@ -710,6 +836,11 @@ static int ceph_config(oconfig_item_t *ci) {
       if (ret) {
         return ret;
       }
+    } else if (strcasecmp("ReportLatency", child->key) == 0) {
+      ret = cc_handle_bool(child, &report_latency);
+      if (ret) {
+        return ret;
+      }
     } else {
       WARNING("ceph plugin: ignoring unknown option %s", child->key);
     }
@@ -861,56 +992,44 @@ static uint32_t backup_search_for_type(struct ceph_daemon *d, char *ds_name) {
 }
 
 /**
- * Process counter data and dispatch values
+ * Calculate average b/t current data and last poll data of a counter found
+ * by index
  */
-static int node_handler_fetch_data(void *arg, const char *val,
-                                   const char *key) {
-  value_t uv;
-  double tmp_d;
-  uint64_t tmp_u;
-  struct values_tmp *vtmp = (struct values_tmp *)arg;
-  uint32_t type = DSET_TYPE_UNFOUND;
-  int index = vtmp->index;
+static double get_last_latency_avg(struct last_latency *last, double cur_sum,
+                                   uint64_t cur_count) {
+  double result = NAN;
 
-  char ds_name[DATA_MAX_NAME_LEN];
-
-  if (parse_keys(ds_name, sizeof(ds_name), key)) {
-    return 1;
+  if (last->valid && (cur_count > last->last_count)) {
+    result = (cur_sum - last->last_sum) /
+             (double)(cur_count - last->last_count);
   }
 
-  if (index >= vtmp->d->ds_num) {
-    // don't overflow bounds of array
-    index = (vtmp->d->ds_num - 1);
-  }
-
-  /**
-   * counters should remain in same order we parsed schema... we maintain the
-   * index variable to keep track of current point in list of counters. first
-   * use index to guess point in array for retrieving type. if that doesn't
-   * work, use the old way to get the counter type
-   */
-  if (strcmp(ds_name, vtmp->d->ds_names[index]) == 0) {
-    // found match
-    type = vtmp->d->ds_types[index];
-  } else if ((index > 0) &&
-             (strcmp(ds_name, vtmp->d->ds_names[index - 1]) == 0)) {
-    // try previous key
-    type = vtmp->d->ds_types[index - 1];
-  }
+  last->last_sum = cur_sum;
+  last->last_count = cur_count;
+  last->valid = true;
+  return result;
+}
 
-  if (type == DSET_TYPE_UNFOUND) {
-    // couldn't find right type by guessing, check the old way
-    type = backup_search_for_type(vtmp->d, ds_name);
-  }
+/**
+ * Dispatch the value of a counter. `ds_index' is the counter's index if it was
+ * found in the daemon's data keys, or -1 if it was found by name.
+ */
+static int ceph_submit_counter(struct values_tmp *vtmp, const char *val,
+                               const char *key, enum latency_part_d part,
+                               uint32_t type, const char *ds_name,
+                               int ds_index) {
+  value_t uv;
+  double tmp_d;
+  uint64_t tmp_u;
 
   switch (type) {
   case DSET_LATENCY:
-    if (has_suffix(key, ".avgcount")) {
+    if (part == LATENCY_AVGCOUNT) {
       sscanf(val, "%" PRIu64, &vtmp->avgcount);
       // return after saving avgcount - don't dispatch value
       // until latency calculation
       return 0;
-    } else if (has_suffix(key, ".sum")) {
+    } else if (part == LATENCY_SUM) {
       if (vtmp->avgcount == 0) {
         vtmp->avgcount = 1;
       }
@@ -921,14 +1040,19 @@ static int node_handler_fetch_data(void *arg, const char *val,
       }
       double sum, result;
       sscanf(val, "%lf", &sum);
-      result = get_last_avg(vtmp->d, ds_name, vtmp->latency_index, sum,
-                            vtmp->avgcount);
-      if (result == -ENOMEM) {
-        return -ENOMEM;
+      if (ds_index >= 0) {
+        result = get_last_latency_avg(&vtmp->d->ds_latency[ds_index], sum,
+                                      vtmp->avgcount);
+      } else {
+        result = get_last_avg(vtmp->d, ds_name, vtmp->latency_index, sum,
+                              vtmp->avgcount);
+        if (result == -ENOMEM) {
+          return -ENOMEM;
+        }
       }
       uv.gauge = result;
       vtmp->latency_index = (vtmp->latency_index + 1);
-    } else if (has_suffix(key, ".avgtime")) {
+    } else if (part == LATENCY_AVGTIME) {
 
       /* The "avgtime" metric reports ("sum" / "avgcount"), i.e. the average
        * time per request since the start of the Ceph daemon. Report this only
@@ -974,6 +1098,79 @@ static int node_handler_fetch_data(void *arg, const char *val,
   return 0;
 }
 
+/**
+ * Process counter data and dispatch values
+ */
+static int node_handler_fetch_data(void *arg, const char *val,
+                                   const char *key) {
+  struct values_tmp *vtmp = (struct values_tmp *)arg;
+  uint32_t type = DSET_TYPE_UNFOUND;
+  int index = vtmp->index;
+  enum latency_part_d part = LATENCY_OTHER;
+
+  char ds_name[DATA_MAX_NAME_LEN];
+
+  if (parse_keys(ds_name, sizeof(ds_name), key)) {
+    return 1;
+  }
+
+  if (index >= vtmp->d->ds_num) {
+    // don't overflow bounds of array
+    index = (vtmp->d->ds_num - 1);
+  }
+
+  /**
+   * counters should remain in same order we parsed schema... we maintain the
+   * index variable to keep track of current point in list of counters. first
+   * use index to guess point in array for retrieving type. if that doesn't
+   * work, use the old way to get the counter type
+   */
+  if (strcmp(ds_name, vtmp->d->ds_names[index]) == 0) {
+    // found match
+    type = vtmp->d->ds_types[index];
+  } else if ((index > 0) &&
+             (strcmp(ds_name, vtmp->d->ds_names[index - 1]) == 0)) {
+    // try previous key
+    type = vtmp->d->ds_types[index - 1];
+  }
+
+  if (type == DSET_TYPE_UNFOUND) {
+    // couldn't find right type by guessing, check the old way
+    type = backup_search_for_type(vtmp->d, ds_name);
+  }
+
+  if (has_suffix(key, ".avgcount"))
+    part = LATENCY_AVGCOUNT;
+  else if (has_suffix(key, ".sum"))
+    part = LATENCY_SUM;
+  else if (has_suffix(key, ".avgtime"))
+    part = LATENCY_AVGTIME;
+
+  return ceph_submit_counter(vtmp, val, key, part, type, ds_name,
+                             /* ds_index = */ -1);
+}
+
+/**
+ * Dispatch the value of a counter found in the daemon's data keys. `key' is
+ * the last part of the counter's key only.
+ */
+static int node_handler_fetch_counter(void *arg, const char *val,
+                                      const char *key, int ds_index) {
+  struct values_tmp *vtmp = (struct values_tmp *)arg;
+  enum latency_part_d part = LATENCY_OTHER;
+
+  if (strcmp("avgcount", key) == 0)
+    part = LATENCY_AVGCOUNT;
+  else if (strcmp("sum", key) == 0)
+    part = LATENCY_SUM;
+  else if (strcmp("avgtime", key) == 0)
+    part = LATENCY_AVGTIME;
+
+  return ceph_submit_counter(vtmp, val, vtmp->d->ds_names[ds_index], part,
+                             vtmp->d->ds_types[ds_index],
+                             vtmp->d->ds_names[ds_index], ds_index);
+}
+
 static int cconn_connect(struct cconn *io) {
   struct sockaddr_un address = {0};
   int flags, fd, err;
@@ -1082,13 +1279,14 @@ static int cconn_process_json(struct cconn *io) {
   switch (io->request_type) {
   case ASOK_REQ_DATA:
     io->yajl.handler = node_handler_fetch_data;
+    io->yajl.trie = io->d->data_keys;
+    io->yajl.counter_handler = node_handler_fetch_counter;
     result = cconn_process_data(io, &io->yajl, hand);
     break;
   case ASOK_REQ_SCHEMA:
     // init daemon specific variables
-    io->d->ds_num = 0;
-    io->d->last_idx = 0;
-    io->d->last_poll_data = NULL;
+    ceph_daemon_reset_schema(io->d);
+    io->yajl.trie = NULL;
     io->yajl.handler = node_handler_define_schema;
     io->yajl.handler_arg = io->d;
     result = traverse_json(io->json, io->json_len, hand);
@@ -1305,25 +1503,27 @@ static int milli_diff(const struct timeval *t1, const struct timeval *t2) {
 
 /** This handles the actual network I/O to talk to the Ceph daemons.
  */
-static ssize_t cconn_main_loop(uint32_t request_type) {
+static ssize_t cconn_main_loop(uint32_t request_type,
+                               struct ceph_daemon **daemons,
+                               size_t num_daemons) {
   int some_unreachable = 0;
   ssize_t ret;
   struct timeval end_tv;
-  struct cconn io_array[g_num_daemons];
+  struct cconn io_array[num_daemons];
 
   DEBUG("ceph plugin: entering cconn_main_loop(request_type = %" PRIu32 ")",
         request_type);
 
-  if (g_num_daemons < 1) {
+  if (num_daemons < 1) {
     ERROR("ceph plugin: No daemons configured. See the \"Daemon\" config "
           "option.");
     return ENOENT;
   }
 
   /* create cconn array */
-  for (size_t i = 0; i < g_num_daemons; i++) {
+  for (size_t i = 0; i < num_daemons; i++) {
     io_array[i] = (struct cconn){
-        .d = g_daemons[i],
+        .d = daemons[i],
         .request_type = request_type,
         .state = CSTATE_UNCONNECTED,
         .asok = -1,
@@ -1337,11 +1537,11 @@ static ssize_t cconn_main_loop(uint32_t request_type) {
   while (1) {
     int nfds, diff;
     struct timeval tv;
-    struct cconn *polled_io_array[g_num_daemons];
-    struct pollfd fds[g_num_daemons];
+    struct cconn *polled_io_array[num_daemons];
+    struct pollfd fds[num_daemons];
     memset(fds, 0, sizeof(fds));
     nfds = 0;
-    for (size_t i = 0; i < g_num_daemons; ++i) {
+    for (size_t i = 0; i < num_daemons; ++i) {
       struct cconn *io = io_array + i;
       ret = cconn_prepare(io, fds + nfds);
       if (ret < 0) {
@@ -1400,7 +1600,7 @@ static ssize_t cconn_main_loop(uint32_t request_type) {
     }
   }
 done:
-  for (size_t i = 0; i < g_num_daemons; ++i) {
+  for (size_t i = 0; i < num_daemons; ++i) {
     cconn_close(io_array + i);
   }
   if (some_unreachable) {
@@ -1411,7 +1611,42 @@ done:
   return ret;
 }
 
-static int ceph_read(void) { return (int)cconn_main_loop(ASOK_REQ_DATA); }
+static void ceph_submit_latency(struct ceph_daemon *d, cdtime_t latency) {
+  value_list_t vl = VALUE_LIST_INIT;
+
+  vl.values = &(value_t){.gauge = CDTIME_T_TO_DOUBLE(latency)};
+  vl.values_len = 1;
+  sstrncpy(vl.plugin, "ceph", sizeof(vl.plugin));
+  sstrncpy(vl.plugin_instance, d->name, sizeof(vl.plugin_instance));
+  sstrncpy(vl.type, "response_time", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "admin_socket", sizeof(vl.type_instance));
+
+  plugin_dispatch_values(&vl);
+}
+
+/**
+ * Each daemon has its own read callback, so daemons are polled concurrently by
+ * the read threads and a slow daemon does not delay the others.
+ */
+static int ceph_read(user_data_t *ud) {
+  struct ceph_daemon *d = ud->data;
+  cdtime_t start = cdtime();
+  ssize_t ret;
+
+  /* The daemon was not reachable when the plugin was initialized, or its
+   * schema could not be read. Try again. */
+  if (d->ds_num == 0) {
+    cconn_main_loop(ASOK_REQ_VERSION, &d, 1);
+    if (d->ds_num == 0)
+      return -1;
+  }
+
+  ret = cconn_main_loop(ASOK_REQ_DATA, &d, 1);
+  if (ret == 0 && report_latency)
+    ceph_submit_latency(d, cdtime() - start);
+
+  return (int)ret;
+}
 
 /******* lifecycle *******/
 static int ceph_init(void) {
@@ -1438,7 +1673,26 @@ static int ceph_init(void) {
     return ENOENT;
   }
 
-  return (int)cconn_main_loop(ASOK_REQ_VERSION);
+  /* Fetch the version and schema of all daemons at once. Daemons that cannot
+   * be reached are retried by their read callback. */
+  ssize_t ret = cconn_main_loop(ASOK_REQ_VERSION, g_daemons, g_num_daemons);
+  if (ret < 0) {
+    WARNING("ceph plugin: Reading the schema of some daemons failed: %zd",
+            ret);
+  }
+
+  for (size_t i = 0; i < g_num_daemons; i++) {
+    char cb_name[sizeof("ceph/") + DATA_MAX_NAME_LEN];
+
+    snprintf(cb_name, sizeof(cb_name), "ceph/%s", g_daemons[i]->name);
+    plugin_register_complex_read(/* group = */ "ceph", cb_name, ceph_read,
+                                 /* interval = */ 0,
+                                 &(user_data_t){
+                                     .data = g_daemons[i],
+                                 });
+  }
+
+  return 0;
 }
 
 static int ceph_shutdown(void) {
@@ -1455,6 +1709,5 @@ static int ceph_shutdown(void) {
 void module_register(void) {
   plugin_register_complex_config("ceph", ceph_config);
   plugin_register_init("ceph", ceph_init);
-  plugin_register_read("ceph", ceph_read);
   plugin_register_shutdown("ceph", ceph_shutdown);
 }
@@ -181,9 +181,113 @@ DEF_TEST(parse_keys) {
   return 0;
 }
 
+static int parse_json(yajl_struct *ctx, char const *json) {
+  yajl_handle hndl;
+  int status;
+
+#if HAVE_YAJL_V2
+  hndl = yajl_alloc(&callbacks, NULL, ctx);
+#else
+  hndl = yajl_alloc(&callbacks, NULL, NULL, ctx);
+#endif
+  status = traverse_json((const unsigned char *)json, (uint32_t)strlen(json),
+                         hndl);
+  if (status == 0) {
+#if HAVE_YAJL_V2
+    status = yajl_complete_parse(hndl);
+#else
+    status = yajl_parse_complete(hndl);
+#endif
+  }
+  yajl_free(hndl);
+  return status;
+}
+
+/* Returns the counter index stored for the "."-separated `key' or -1. */
+static int data_key_index(struct ceph_daemon *d, char const *key) {
+  key_trie_node_t *node = key_trie_root(d->data_keys);
+
+  while ((node != NULL) && (*key != 0)) {
+    char const *end = strchr(key, '.');
+    size_t len = (end != NULL) ? (size_t)(end - key) : strlen(key);
+
+    node = key_trie_child(node, key, len);
+    key += len;
+    if (*key == '.')
+      key++;
+  }
+
+  void *value = key_trie_value(node);
+  return (value != NULL) ? PTR_TO_DS_INDEX(value) : -1;
+}
+
+static int ds_index(struct ceph_daemon *d, char const *ds_name) {
+  for (int i = 0; i < d->ds_num; i++)
+    if (strcmp(ds_name, d->ds_names[i]) == 0)
+      return i;
+  return -1;
+}
+
+DEF_TEST(data_keys) {
+  char const *schema = "{\"WBThrottle\": {"
+                       "  \"bytes_dirtied\": {\"type\": 2, \"priority\": 5},"
+                       "  \"ios_wb\": {\"type\": 10}"
+                       "},"
+                       "\"filestore\": {"
+                       "  \"journal_wr_bytes\": {\"type\": 6},"
+                       "  \"op_latency\": {\"type\": 5, \"priority\": 3}"
+                       "}}";
+  char const *data = "{\"WBThrottle\": {\"bytes_dirtied\": 7, \"ios_wb\": 8},"
+                     "\"filestore\": {"
+                     "  \"journal_wr_bytes\": {\"avgcount\": 1, \"sum\": 9},"
+                     "  \"op_latency\": {\"avgcount\": 2, \"sum\": 4.5}"
+                     "}}";
+  struct ceph_daemon *d;
+  int bytes_dirtied, ios_wb, journal_wr_bytes, op_latency;
+
+  CHECK_NOT_NULL(d = calloc(1, sizeof(*d)));
+  yajl_struct schema_ctx = {node_handler_define_schema, d};
+  CHECK_ZERO(parse_json(&schema_ctx, schema));
+  CHECK_NOT_NULL(d->data_keys);
+
+  OK((bytes_dirtied = ds_index(d, "WBThrottle.bytesDirtied")) >= 0);
+  OK((ios_wb = ds_index(d, "WBThrottle.iosWb")) >= 0);
+  OK((journal_wr_bytes = ds_index(d, "Filestore.journalWrBytes")) >= 0);
+  OK((op_latency = ds_index(d, "Filestore.opLatency")) >= 0);
+
+  EXPECT_EQ_INT(bytes_dirtied, data_key_index(d, "WBThrottle.bytes_dirtied"));
+  EXPECT_EQ_INT(ios_wb, data_key_index(d, "WBThrottle.ios_wb"));
+  EXPECT_EQ_INT(journal_wr_bytes,
+                data_key_index(d, "filestore.journal_wr_bytes.sum"));
+  EXPECT_EQ_INT(op_latency, data_key_index(d, "filestore.op_latency.avgcount"));
+  EXPECT_EQ_INT(op_latency, data_key_index(d, "filestore.op_latency.sum"));
+  EXPECT_EQ_INT(op_latency, data_key_index(d, "filestore.op_latency.avgtime"));
+  EXPECT_EQ_INT(-1, data_key_index(d, "filestore.op_latency"));
+  EXPECT_EQ_INT(-1, data_key_index(d, "filestore.op_latency.priority"));
+  EXPECT_EQ_INT(-1, data_key_index(d, "WBThrottle.bytes_dirtied.sum"));
+
+  /* Latency values found in the data keys are tracked by index. */
+  struct values_tmp vtmp = {.d = d, .vlist = VALUE_LIST_INIT};
+  yajl_struct data_ctx = {
+      .handler = node_handler_fetch_data,
+      .handler_arg = &vtmp,
+      .trie = d->data_keys,
+      .counter_handler = node_handler_fetch_counter,
+  };
+  CHECK_ZERO(parse_json(&data_ctx, data));
+  OK(d->ds_latency[op_latency].valid);
+  EXPECT_EQ_INT(2, (int)d->ds_latency[op_latency].last_count);
+  EXPECT_EQ_DOUBLE(4.5, d->ds_latency[op_latency].last_sum);
+  EXPECT_EQ_INT(0, d->last_idx);
+
+  ceph_daemon_free(d);
+  return 0;
+}
+
 int main(void) {
   RUN_TEST(traverse_json);
   RUN_TEST(parse_keys);
+  RUN_TEST(data_keys);
 
   END_TEST;
 }
@@ -24,9 +24,11 @@
  *   Sven Trenkel <collectd at semidefinite.de>
  **/
 
-/* Some python versions don't include this by default. */
-
+/* Some python versions don't include this by default. Since 3.11 it is
+ * included by Python.h and no longer installed at the top level. */
+#if PY_VERSION_HEX < 0x030B0000
 #include <longintrepr.h>
+#endif
 
 /* These two macros are basically Py_BEGIN_ALLOW_THREADS and
  * Py_BEGIN_ALLOW_THREADS
@@ -109,6 +111,15 @@ static inline void CPY_STRCAT(PyObject **a, PyObject *b) {
 
 #endif
 
+/* Python 3.12 and newer can give every sub-interpreter its own GIL, so that
+ * modules imported into different interpreters run in parallel (see the
+ * "SubInterpreters" option). The "collectd" module supports this by using
+ * multi-phase initialization and by creating its types as heap types, once
+ * per interpreter. Older versions use static types. */
+#if PY_VERSION_HEX >= 0x030C0000
+#define CPY_SUB_INTERPRETERS
+#endif
+
 static inline const char *cpy_unicode_or_bytes_to_string(PyObject **o) {
   if (PyUnicode_Check(*o)) {
     PyObject *tmp;
@@ -139,7 +150,19 @@ static inline PyObject *cpy_string_to_unicode_or_bytes(const char *buf) {
 #endif
 }
 
+/* Appends the C string "b" to "*a". Unlike caching the string object, this
+ * does not share objects between interpreters. */
+static inline void cpy_strcat_string(PyObject **a, const char *b) {
+  PyObject *tmp = cpy_string_to_unicode_or_bytes(b); /* New reference. */
+  if (tmp == NULL) {
+    Py_CLEAR(*a);
+    return;
+  }
+  CPY_STRCAT_AND_DEL(a, tmp);
+}
+
 void cpy_log_exception(const char *context);
+PyObject *cpy_dispatch_many(PyObject *self, PyObject *args);
 
 /* Python object declarations. */
 
@@ -152,7 +175,6 @@ typedef struct {
   PyObject *children;   /* Sequence */
   // clang-format on
 } Config;
-extern PyTypeObject ConfigType;
 
 typedef struct {
   // clang-format off
@@ -165,9 +187,6 @@ typedef struct {
   char type[DATA_MAX_NAME_LEN];
   char type_instance[DATA_MAX_NAME_LEN];
 } PluginData;
-extern PyTypeObject PluginDataType;
-#define PluginData_New()                                                       \
-  PyObject_CallFunctionObjArgs((PyObject *)&PluginDataType, (void *)0)
 
 typedef struct {
   PluginData data;
@@ -175,9 +194,6 @@ typedef struct {
   PyObject *meta;   /* dict */
   double interval;
 } Values;
-extern PyTypeObject ValuesType;
-#define Values_New()                                                           \
-  PyObject_CallFunctionObjArgs((PyObject *)&ValuesType, (void *)0)
 
 typedef struct {
   PluginData data;
@@ -185,12 +201,48 @@ typedef struct {
   int severity;
   char message[NOTIF_MAX_MSG_LEN];
 } Notification;
-extern PyTypeObject NotificationType;
-#define Notification_New()                                                     \
-  PyObject_CallFunctionObjArgs((PyObject *)&NotificationType, (void *)0)
 
 typedef PyLongObject Signed;
-extern PyTypeObject SignedType;
 
 typedef PyLongObject Unsigned;
+
+#ifdef CPY_SUB_INTERPRETERS
+extern PyType_Spec Config_spec;
+extern PyType_Spec PluginData_spec;
+extern PyType_Spec Values_spec;
+extern PyType_Spec Notification_spec;
+extern PyType_Spec Signed_spec;
+extern PyType_Spec Unsigned_spec;
+#else
+extern PyTypeObject ConfigType;
+extern PyTypeObject PluginDataType;
+extern PyTypeObject ValuesType;
+extern PyTypeObject NotificationType;
+extern PyTypeObject SignedType;
 extern PyTypeObject UnsignedType;
+#endif
+
+/* The types and the exception of the "collectd" module. Every interpreter has
+ * its own set. */
+typedef struct {
+  PyTypeObject *config_type;
+  PyTypeObject *plugin_data_type;
+  PyTypeObject *values_type;
+  PyTypeObject *notification_type;
+  PyTypeObject *signed_type;
+  PyTypeObject *unsigned_type;
+  PyObject *error; /* CollectdError */
+} cpy_state_t;
+
+/* Returns the state of the current interpreter. You must hold the GIL. */
+cpy_state_t *cpy_get_state(void);
+
+#define PluginData_New()                                                       \
+  PyObject_CallFunctionObjArgs((PyObject *)cpy_get_state()->plugin_data_type, \
+                               (void *)0)
+#define Values_New()                                                           \
+  PyObject_CallFunctionObjArgs((PyObject *)cpy_get_state()->values_type,      \
+                               (void *)0)
+#define Notification_New()                                                     \
+  PyObject_CallFunctionObjArgs(                                                \
+      (PyObject *)cpy_get_state()->notification_type, (void *)0)
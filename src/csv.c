@@ -25,6 +25,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 
 /*
@@ -47,7 +48,7 @@ static int value_list_to_string(char *buffer, int buffer_len,
 
   memset(buffer, '\0', buffer_len);
 
-  status = snprintf(buffer, buffer_len, "%.3f", CDTIME_T_TO_DOUBLE(vl->time));
+  status = serialize_fixed(buffer, buffer_len, CDTIME_T_TO_DOUBLE(vl->time), 3);
   if ((status < 1) || (status >= buffer_len))
     return -1;
   offset = status;
@@ -61,9 +62,15 @@ static int value_list_to_string(char *buffer, int buffer_len,
       return -1;
     }
 
+    if ((buffer_len - offset) < 2) {
+      sfree(rates);
+      return -1;
+    }
+    buffer[offset++] = ',';
+
     if (ds->ds[i].type == DS_TYPE_GAUGE) {
-      status = snprintf(buffer + offset, buffer_len - offset, ",%lf",
-                        vl->values[i].gauge);
+      status = serialize_fixed(buffer + offset, buffer_len - offset,
+                               vl->values[i].gauge, 6);
     } else if (store_rates != 0) {
       if (rates == NULL)
         rates = uc_get_rate(ds, vl);
@@ -72,16 +79,17 @@ static int value_list_to_string(char *buffer, int buffer_len,
                 "uc_get_rate failed.");
         return -1;
       }
-      status = snprintf(buffer + offset, buffer_len - offset, ",%lf", rates[i]);
+      status = serialize_fixed(buffer + offset, buffer_len - offset, rates[i],
+                               6);
     } else if (ds->ds[i].type == DS_TYPE_COUNTER) {
-      status = snprintf(buffer + offset, buffer_len - offset, ",%" PRIu64,
-                        (uint64_t)vl->values[i].counter);
+      status = serialize_uint64(buffer + offset, buffer_len - offset,
+                                (uint64_t)vl->values[i].counter);
     } else if (ds->ds[i].type == DS_TYPE_DERIVE) {
-      status = snprintf(buffer + offset, buffer_len - offset, ",%" PRIi64,
-                        vl->values[i].derive);
+      status = serialize_int64(buffer + offset, buffer_len - offset,
+                               vl->values[i].derive);
     } else if (ds->ds[i].type == DS_TYPE_ABSOLUTE) {
-      status = snprintf(buffer + offset, buffer_len - offset, ",%" PRIu64,
-                        vl->values[i].absolute);
+      status = serialize_uint64(buffer + offset, buffer_len - offset,
+                                vl->values[i].absolute);
     }
 
     if ((status < 1) || (status >= (buffer_len - offset))) {
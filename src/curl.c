@@ -25,6 +25,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 #include "utils/curl_stats/curl_stats.h"
 #include "utils/match/match.h"
 #include "utils_time.h"
@@ -77,6 +78,7 @@ struct web_page_s /* {{{ */
   char *buffer;
   size_t buffer_size;
   size_t buffer_fill;
+  cdtime_t start;
 
   web_match_t *matches;
 }; /* }}} */
@@ -86,7 +88,7 @@ struct web_page_s /* {{{ */
  */
 static int cc_read_page(user_data_t *ud);
 
-static size_t cc_curl_callback(void *buf, /* {{{ */
+static size_t cc_curl_callback(char *buf, /* {{{ */
                                size_t size, size_t nmemb, void *user_data) {
   web_page_t *wp;
   size_t len;
@@ -139,8 +141,10 @@ static void cc_web_page_free(void *arg) /* {{{ */
   if (wp == NULL)
     return;
 
-  if (wp->curl != NULL)
+  if (wp->curl != NULL) {
+    curl_engine_cancel(wp->curl);
     curl_easy_cleanup(wp->curl);
+  }
   wp->curl = NULL;
 
   sfree(wp->plugin_name);
@@ -340,8 +344,7 @@ static int cc_page_init_curl(web_page_t *wp) /* {{{ */
   }
 
   curl_easy_setopt(wp->curl, CURLOPT_NOSIGNAL, 1L);
-  curl_easy_setopt(wp->curl, CURLOPT_WRITEFUNCTION, cc_curl_callback);
-  curl_easy_setopt(wp->curl, CURLOPT_WRITEDATA, wp);
+  curl_easy_setopt(wp->curl, CURLOPT_URL, wp->url);
   curl_easy_setopt(wp->curl, CURLOPT_USERAGENT, COLLECTD_USERAGENT);
   curl_easy_setopt(wp->curl, CURLOPT_ERRORBUFFER, wp->curl_errbuf);
   curl_easy_setopt(wp->curl, CURLOPT_FOLLOWLOCATION, 1L);
@@ -568,6 +571,13 @@ static int cc_config(oconfig_item_t *ci) /* {{{ */
         success++;
       else
         errors++;
+    } else if (strcasecmp("MaxHostConnections", child->key) == 0) {
+      int max_host_connections = 0;
+      status = cf_util_get_int(child, &max_host_connections);
+      if (status == 0)
+        curl_engine_set_max_host_connections((long)max_host_connections);
+      else
+        errors++;
     } else {
       WARNING("curl plugin: Option `%s' not allowed here.", child->key);
       errors++;
@@ -632,35 +642,20 @@ static void cc_submit_response_time(const web_page_t *wp, /* {{{ */
   plugin_dispatch_values(&vl);
 } /* }}} void cc_submit_response_time */
 
-static int cc_read_page(user_data_t *ud) /* {{{ */
-{
-
-  if ((ud == NULL) || (ud->data == NULL)) {
-    ERROR("curl plugin: cc_read_page: Invalid user data.");
-    return -1;
-  }
-
-  web_page_t *wp = (web_page_t *)ud->data;
-
+/* Called by the cURL engine once the page has been received. */
+static void cc_page_done(__attribute__((unused)) CURL *curl, /* {{{ */
+                         CURLcode code, void *user_data) {
+  web_page_t *wp = user_data;
   int status;
-  cdtime_t start = 0;
-
-  if (wp->response_time)
-    start = cdtime();
-
-  wp->buffer_fill = 0;
-
-  curl_easy_setopt(wp->curl, CURLOPT_URL, wp->url);
 
-  status = curl_easy_perform(wp->curl);
-  if (status != CURLE_OK) {
-    ERROR("curl plugin: curl_easy_perform failed with status %i: %s", status,
+  if (code != CURLE_OK) {
+    ERROR("curl plugin: curl_easy_perform failed with status %i: %s", code,
           wp->curl_errbuf);
-    return -1;
+    return;
   }
 
   if (wp->response_time)
-    cc_submit_response_time(wp, CDTIME_T_TO_DOUBLE(cdtime() - start));
+    cc_submit_response_time(wp, CDTIME_T_TO_DOUBLE(cdtime() - wp->start));
   if (wp->stats != NULL)
     curl_stats_dispatch(wp->stats, wp->curl, NULL, "curl", wp->instance);
 
@@ -694,6 +689,39 @@ static int cc_read_page(user_data_t *ud) /* {{{ */
     cc_submit(wp, wm, mv->value);
     match_value_reset(mv);
   } /* for (wm = wp->matches; wm != NULL; wm = wm->next) */
+} /* }}} void cc_page_done */
+
+static int cc_read_page(user_data_t *ud) /* {{{ */
+{
+
+  if ((ud == NULL) || (ud->data == NULL)) {
+    ERROR("curl plugin: cc_read_page: Invalid user data.");
+    return -1;
+  }
+
+  web_page_t *wp = (web_page_t *)ud->data;
+
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(wp->curl, &submitted);
+  if (skipped > 0) {
+    WARNING("curl plugin: The request to `%s' has not finished after %.3f "
+            "seconds, skipping this interval (%u skipped so far).",
+            wp->url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
+  wp->start = cdtime();
+  wp->buffer_fill = 0;
+  if (wp->buffer != NULL)
+    wp->buffer[0] = 0;
+
+  int status =
+      curl_engine_submit(wp->curl, cc_curl_callback, wp, cc_page_done, wp);
+  if (status != 0) {
+    ERROR("curl plugin: Submitting request to `%s' failed: %s", wp->url,
+          STRERROR(status));
+    return -1;
+  }
 
   return 0;
 } /* }}} int cc_read_page */
@@ -701,4 +729,5 @@ static int cc_read_page(user_data_t *ud) /* {{{ */
 void module_register(void) {
   plugin_register_complex_config("curl", cc_config);
   plugin_register_init("curl", cc_init);
+  plugin_register_init_exclusive("curl");
 } /* void module_register */
@@ -27,6 +27,7 @@
 #include "configfile.h"
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 #include "utils_complain.h"
 #include "utils_llist.h"
 
@@ -441,7 +442,7 @@ static yajl_callbacks ycallbacks = {
  *------------------------------------------------------------------------------
  * cURL Handling
  */
-static size_t cjo_curl_callback(void *buf, /* {{{ */
+static size_t cjo_curl_callback(char *buf, /* {{{ */
                                 size_t size, size_t nmemb, void *user_data) {
   size_t len = size * nmemb;
 
@@ -452,7 +453,7 @@ static size_t cjo_curl_callback(void *buf, /* {{{ */
   if (db == NULL)
     return 0;
 
-  cjo_append_buffer(&db->replybuffer, (char *)buf, len);
+  cjo_append_buffer(&db->replybuffer, buf, len);
 
   return len;
 } /* }}} size_t cjo_curl_callback */
@@ -543,33 +544,27 @@ static int cjo_sock_perform(cjo_t *db) /* {{{ */
       close(fd);
       return -1;
     }
-    if (!cjo_curl_callback(buffer, red, 1, db))
+    if (!cjo_curl_callback((char *)buffer, red, 1, db))
       break;
   } while (red > 0);
   close(fd);
   return 0;
 } /* }}} int cjo_sock_perform */
 
-static int cjo_curl_perform(cjo_t *db) /* {{{ */
+/* Handles the reply of a transfer submitted by cjo_curl_submit(). */
+static int cjo_curl_perform(cjo_t *db, CURLcode status) /* {{{ */
 {
 
   char *url = NULL;
 
   curl_easy_getinfo(db->curl, CURLINFO_EFFECTIVE_URL, &url);
 
-  size_t len = db->post_body_len;
-  if (len < 4096)
-    len = 4096;
-
-  cjo_init_buffer(&db->replybuffer, len * 4);
-  cjo_init_buffer(&db->itembuffer, len);
-
-  int status = curl_easy_perform(db->curl);
   if (status != CURLE_OK) {
     ERROR(
         "curl_jolokia plugin: curl_easy_perform failed with status %i: %s (%s)",
         status, db->curl_errbuf, (url != NULL) ? url : "<null>");
     cjo_release_buffercontent(&db->replybuffer);
+    cjo_release_buffercontent(&db->itembuffer);
     return -1;
   }
 
@@ -582,6 +577,7 @@ static int cjo_curl_perform(cjo_t *db) /* {{{ */
           "response code %ld (%s)",
           rc, url);
     cjo_release_buffercontent(&db->replybuffer);
+    cjo_release_buffercontent(&db->itembuffer);
     return -1;
   }
 
@@ -602,7 +598,7 @@ static int cjo_curl_perform(cjo_t *db) /* {{{ */
   return 0;
 } /* }}} int cjo_curl_perform */
 
-static int cjo_perform(cjo_t *db) /* {{{ */
+static int cjo_perform(cjo_t *db, CURLcode curl_status) /* {{{ */
 {
   yajl_handle yprev = db->yajl;
 
@@ -621,7 +617,7 @@ static int cjo_perform(cjo_t *db) /* {{{ */
 
   int status;
   if (db->url)
-    status = cjo_curl_perform(db);
+    status = cjo_curl_perform(db, curl_status);
   else
     status = cjo_sock_perform(db);
   if (status < 0) {
@@ -653,6 +649,43 @@ static int cjo_perform(cjo_t *db) /* {{{ */
   return 0;
 } /* }}} int cjo_perform */
 
+/* Called by the cURL engine once the reply has been received. */
+static void cjo_curl_done(__attribute__((unused)) CURL *curl, /* {{{ */
+                          CURLcode status, void *user_data) {
+  cjo_perform(user_data, status);
+} /* }}} void cjo_curl_done */
+
+static int cjo_curl_submit(cjo_t *db) /* {{{ */
+{
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(db->curl, &submitted);
+  if (skipped > 0) {
+    WARNING("curl_jolokia plugin: The request to `%s' has not finished after "
+            "%.3f seconds, skipping this interval (%u skipped so far).",
+            db->url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
+  size_t len = db->post_body_len;
+  if (len < 4096)
+    len = 4096;
+
+  cjo_init_buffer(&db->replybuffer, len * 4);
+  cjo_init_buffer(&db->itembuffer, len);
+
+  int status =
+      curl_engine_submit(db->curl, cjo_curl_callback, db, cjo_curl_done, db);
+  if (status != 0) {
+    ERROR("curl_jolokia plugin: Submitting request to `%s' failed: %s",
+          db->url, STRERROR(status));
+    cjo_release_buffercontent(&db->replybuffer);
+    cjo_release_buffercontent(&db->itembuffer);
+    return -1;
+  }
+
+  return 0;
+} /* }}} int cjo_curl_submit */
+
 static int cjo_read(user_data_t *ud) /* {{{ */
 {
   if ((ud == NULL) || (ud->data == NULL)) {
@@ -660,7 +693,11 @@ static int cjo_read(user_data_t *ud) /* {{{ */
     return -1;
   }
 
-  return cjo_perform((cjo_t *)ud->data);
+  cjo_t *db = ud->data;
+  if (db->url != NULL)
+    return cjo_curl_submit(db);
+
+  return cjo_perform(db, CURLE_OK);
 } /* }}} int cjo_read */
 /* end cURL callbacks */
 
@@ -884,9 +921,13 @@ static void cjo_free(void *arg) /* {{{ */
   if (db == NULL)
     return;
 
-  if (db->curl != NULL)
+  if (db->curl != NULL) {
+    curl_engine_cancel(db->curl);
     curl_easy_cleanup(db->curl);
+  }
   db->curl = NULL;
+  cjo_release_buffercontent(&db->replybuffer);
+  cjo_release_buffercontent(&db->itembuffer);
 
   cjo_destroy_bean_configs(db->bean_configs);
   db->bean_configs = NULL;
@@ -24,9 +24,10 @@
 #include "collectd.h"
 
 #include "plugin.h"
-#include "utils/avltree/avltree.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 #include "utils/curl_stats/curl_stats.h"
+#include "utils/key_trie/key_trie.h"
 #include "utils_complain.h"
 
 #include <sys/types.h>
@@ -57,23 +58,14 @@ struct cj_key_s /* {{{ */
 };
 /* }}} */
 
-/* cj_tree_entry_t is a union of either a metric configuration ("key") or a tree
- * mapping array indexes / map keys to a descendant cj_tree_entry_t*. */
-typedef struct {
-  enum { KEY, TREE } type;
-  union {
-    c_avl_tree_t *tree;
-    cj_key_t *key;
-  };
-} cj_tree_entry_t;
-
 /* cj_state_t is a stack providing the configuration relevant for the context
- * that is currently being parsed. If entry->type == KEY, the parser should
- * expect a metric (a numeric value). If entry->type == TREE, the parser should
- * expect an array of map to descent into. If entry == NULL, no configuration
- * exists for this part of the JSON structure. */
+ * that is currently being parsed. If node has a value (a cj_key_t), the parser
+ * should expect a metric (a numeric value). If node has children, the parser
+ * should expect an array or map to descent into. If node == NULL, no
+ * configuration exists for this part of the JSON structure and it is skipped
+ * without looking at its keys. */
 typedef struct {
-  cj_tree_entry_t *entry;
+  key_trie_node_t *node;
   bool in_array;
   int index;
   char name[DATA_MAX_NAME_LEN];
@@ -105,7 +97,7 @@ struct cj_s /* {{{ */
   char curl_errbuf[CURL_ERROR_SIZE];
 
   yajl_handle yajl;
-  c_avl_tree_t *tree;
+  key_trie_t *keys;
   int depth;
   cj_state_t state[YAJL_MAX_DEPTH];
 };
@@ -124,7 +116,7 @@ static void cj_submit_impl(cj_t *db, cj_key_t *key, value_t *value);
  * overwrite which function is called. */
 static void (*cj_submit)(cj_t *, cj_key_t *, value_t *) = cj_submit_impl;
 
-static size_t cj_curl_callback(void *buf, /* {{{ */
+static size_t cj_curl_callback(char *buf, /* {{{ */
                                size_t size, size_t nmemb, void *user_data) {
   cj_t *db;
   size_t len;
@@ -184,30 +176,25 @@ static int cj_get_type(cj_key_t *key) {
   return ds->ds[0].type;
 }
 
-/* cj_load_key loads the configuration for "key" from the parent context and
- * sets either .key or .tree in the current context. */
-static int cj_load_key(cj_t *db, char const *key) {
+/* cj_load_key looks up "key" in the parent context and sets the node of the
+ * current context. The key's name is only remembered if it may be needed for
+ * the type instance, i.e. if the parent is part of a configured path. */
+static int cj_load_key(cj_t *db, char const *key, size_t key_len) {
   if (db == NULL || key == NULL || db->depth <= 0)
     return EINVAL;
 
-  sstrncpy(db->state[db->depth].name, key, sizeof(db->state[db->depth].name));
-
-  if (db->state[db->depth - 1].entry == NULL ||
-      db->state[db->depth - 1].entry->type != TREE) {
+  key_trie_node_t *parent = db->state[db->depth - 1].node;
+  if (!key_trie_has_children(parent)) {
+    db->state[db->depth].node = NULL;
     return 0;
   }
 
-  c_avl_tree_t *tree = db->state[db->depth - 1].entry->tree;
-  cj_tree_entry_t *e = NULL;
-
-  if (c_avl_get(tree, key, (void *)&e) == 0) {
-    db->state[db->depth].entry = e;
-  } else if (c_avl_get(tree, CJ_ANY, (void *)&e) == 0) {
-    db->state[db->depth].entry = e;
-  } else {
-    db->state[db->depth].entry = NULL;
-  }
+  cj_state_t *state = db->state + db->depth;
+  size_t name_len = COUCH_MIN(key_len, sizeof(state->name) - 1);
+  memcpy(state->name, key, name_len);
+  state->name[name_len] = 0;
 
+  state->node = key_trie_child(parent, key, key_len);
   return 0;
 }
 
@@ -217,9 +204,15 @@ static void cj_advance_array(cj_t *db) {
 
   db->state[db->depth].index++;
 
+  /* Skip formatting the index if nothing is configured below the array. */
+  if (!key_trie_has_children(db->state[db->depth - 1].node)) {
+    db->state[db->depth].node = NULL;
+    return;
+  }
+
   char name[DATA_MAX_NAME_LEN];
-  snprintf(name, sizeof(name), "%d", db->state[db->depth].index);
-  cj_load_key(db, name);
+  int name_len = snprintf(name, sizeof(name), "%d", db->state[db->depth].index);
+  cj_load_key(db, name, (size_t)name_len);
 }
 
 /* yajl callbacks */
@@ -233,25 +226,27 @@ static int cj_cb_null(void *ctx) {
 
 static int cj_cb_number(void *ctx, const char *number, yajl_len_t number_len) {
   cj_t *db = (cj_t *)ctx;
+  key_trie_node_t *node = db->state[db->depth].node;
+
+  if (node == NULL) {
+    cj_advance_array(ctx);
+    return CJ_CB_CONTINUE;
+  }
 
   /* Create a null-terminated version of the string. */
   char buffer[number_len + 1];
   memcpy(buffer, number, number_len);
   buffer[sizeof(buffer) - 1] = '\0';
 
-  if (db->state[db->depth].entry == NULL ||
-      db->state[db->depth].entry->type != KEY) {
-    if (db->state[db->depth].entry != NULL) {
-      NOTICE("curl_json plugin: Found \"%s\", but the configuration expects a "
-             "map.",
-             buffer);
-    }
+  cj_key_t *key = key_trie_value(node);
+  if (key == NULL) {
+    NOTICE("curl_json plugin: Found \"%s\", but the configuration expects a "
+           "map.",
+           buffer);
     cj_advance_array(ctx);
     return CJ_CB_CONTINUE;
   }
 
-  cj_key_t *key = db->state[db->depth].entry->key;
-
   int type = cj_get_type(key);
   value_t vt;
   int status = parse_value(buffer, &vt, type);
@@ -270,12 +265,7 @@ static int cj_cb_number(void *ctx, const char *number, yajl_len_t number_len) {
  * NULL. */
 static int cj_cb_map_key(void *ctx, unsigned char const *in_name,
                          yajl_len_t in_name_len) {
-  char name[in_name_len + 1];
-
-  memmove(name, in_name, in_name_len);
-  name[sizeof(name) - 1] = '\0';
-
-  if (cj_load_key(ctx, name) != 0)
+  if (cj_load_key(ctx, (char const *)in_name, (size_t)in_name_len) != 0)
     return CJ_CB_ABORT;
 
   return CJ_CB_CONTINUE;
@@ -327,7 +317,7 @@ static int cj_cb_start_array(void *ctx) {
   db->state[db->depth].in_array = true;
   db->state[db->depth].index = 0;
 
-  cj_load_key(db, "0");
+  cj_load_key(db, "0", 1);
 
   return CJ_CB_CONTINUE;
 }
@@ -360,23 +350,10 @@ static void cj_key_free(cj_key_t *key) /* {{{ */
   sfree(key);
 } /* }}} void cj_key_free */
 
-static void cj_tree_free(c_avl_tree_t *tree) /* {{{ */
+static void cj_key_free_value(void *key) /* {{{ */
 {
-  char *name;
-  cj_tree_entry_t *e;
-
-  while (c_avl_pick(tree, (void *)&name, (void *)&e) == 0) {
-    sfree(name);
-
-    if (e->type == KEY)
-      cj_key_free(e->key);
-    else
-      cj_tree_free(e->tree);
-    sfree(e);
-  }
-
-  c_avl_destroy(tree);
-} /* }}} void cj_tree_free */
+  cj_key_free(key);
+} /* }}} void cj_key_free_value */
 
 static void cj_free(void *arg) /* {{{ */
 {
@@ -389,13 +366,18 @@ static void cj_free(void *arg) /* {{{ */
   if (db == NULL)
     return;
 
-  if (db->curl != NULL)
+  if (db->curl != NULL) {
+    curl_engine_cancel(db->curl);
     curl_easy_cleanup(db->curl);
+  }
   db->curl = NULL;
 
-  if (db->tree != NULL)
-    cj_tree_free(db->tree);
-  db->tree = NULL;
+  if (db->yajl != NULL)
+    yajl_free(db->yajl);
+  db->yajl = NULL;
+
+  key_trie_destroy(db->keys, cj_key_free_value);
+  db->keys = NULL;
 
   sfree(db->instance);
   sfree(db->plugin_name);
@@ -417,10 +399,6 @@ static void cj_free(void *arg) /* {{{ */
 
 /* Configuration handling functions {{{ */
 
-static c_avl_tree_t *cj_avl_create(void) {
-  return c_avl_create((int (*)(const void *, const void *))strcmp);
-}
-
 static int cj_config_append_string(const char *name,
                                    struct curl_slist **dest, /* {{{ */
                                    oconfig_item_t *ci) {
@@ -447,57 +425,26 @@ static int cj_config_append_string(const char *name,
  * { "httpd": { "requests": { "count": $key, "current": $key } } }
  */
 static int cj_append_key(cj_t *db, cj_key_t *key) { /* {{{ */
-  if (db->tree == NULL)
-    db->tree = cj_avl_create();
-
-  c_avl_tree_t *tree = db->tree;
-
-  char const *start = key->path;
-  if (*start == '/')
-    ++start;
-
-  char const *end;
-  while ((end = strchr(start, '/')) != NULL) {
-    char name[PATH_MAX];
-
-    size_t len = end - start;
-    if (len == 0)
-      break;
-
-    len = COUCH_MIN(len, sizeof(name) - 1);
-    sstrncpy(name, start, len + 1);
-
-    cj_tree_entry_t *e;
-    if (c_avl_get(tree, name, (void *)&e) != 0) {
-      e = calloc(1, sizeof(*e));
-      if (e == NULL)
-        return ENOMEM;
-      e->type = TREE;
-      e->tree = cj_avl_create();
-
-      c_avl_insert(tree, strdup(name), e);
-    }
-
-    if (e->type != TREE)
-      return EINVAL;
-
-    tree = e->tree;
-    start = end + 1;
+  if (db->keys == NULL) {
+    db->keys = key_trie_create(CJ_ANY);
+    if (db->keys == NULL)
+      return ENOMEM;
   }
 
-  if (strlen(start) == 0) {
+  char const *path = key->path;
+  if (*path == '/')
+    ++path;
+
+  int status = key_trie_insert(db->keys, path, '/', key);
+  if (status == EINVAL) {
     ERROR("curl_json plugin: invalid key: %s", key->path);
     return -1;
+  } else if (status == EEXIST) {
+    ERROR("curl_json plugin: duplicate key: %s", key->path);
+    return -1;
   }
 
-  cj_tree_entry_t *e = calloc(1, sizeof(*e));
-  if (e == NULL)
-    return ENOMEM;
-  e->type = KEY;
-  e->key = key;
-
-  c_avl_insert(tree, strdup(start), e);
-  return 0;
+  return status;
 } /* }}} int cj_append_key */
 
 static int cj_config_add_key(cj_t *db, /* {{{ */
@@ -577,8 +524,7 @@ static int cj_init_curl(cj_t *db) /* {{{ */
   }
 
   curl_easy_setopt(db->curl, CURLOPT_NOSIGNAL, 1L);
-  curl_easy_setopt(db->curl, CURLOPT_WRITEFUNCTION, cj_curl_callback);
-  curl_easy_setopt(db->curl, CURLOPT_WRITEDATA, db);
+  curl_easy_setopt(db->curl, CURLOPT_URL, db->url);
   curl_easy_setopt(db->curl, CURLOPT_USERAGENT, COLLECTD_USERAGENT);
   curl_easy_setopt(db->curl, CURLOPT_ERRORBUFFER, db->curl_errbuf);
   curl_easy_setopt(db->curl, CURLOPT_FOLLOWLOCATION, 1L);
@@ -740,7 +686,7 @@ static int cj_config_add_url(oconfig_item_t *ci) /* {{{ */
   }
 
   if (status == 0) {
-    if (db->tree == NULL) {
+    if (db->keys == NULL) {
       WARNING("curl_json plugin: No (valid) `Key' block within `%s' \"`%s'\".",
               db->url ? "URL" : "Sock", db->url ? db->url : db->sock);
       status = -1;
@@ -795,6 +741,13 @@ static int cj_config(oconfig_item_t *ci) /* {{{ */
         success++;
       else
         errors++;
+    } else if (strcasecmp("MaxHostConnections", child->key) == 0) {
+      int max_host_connections = 0;
+      status = cf_util_get_int(child, &max_host_connections);
+      if (status == 0)
+        curl_engine_set_max_host_connections((long)max_host_connections);
+      else
+        errors++;
     } else {
       WARNING("curl_json plugin: Option `%s' not allowed here.", child->key);
       errors++;
@@ -870,22 +823,18 @@ static int cj_sock_perform(cj_t *db) /* {{{ */
       close(fd);
       return -1;
     }
-    if (!cj_curl_callback(buffer, red, 1, db))
+    if (!cj_curl_callback((char *)buffer, red, 1, db))
       break;
   } while (red > 0);
   close(fd);
   return 0;
 } /* }}} int cj_sock_perform */
 
-static int cj_curl_perform(cj_t *db) /* {{{ */
+static int cj_curl_check(cj_t *db, CURLcode status) /* {{{ */
 {
-  int status;
   long rc;
   char *url;
 
-  curl_easy_setopt(db->curl, CURLOPT_URL, db->url);
-
-  status = curl_easy_perform(db->curl);
   if (status != CURLE_OK) {
     ERROR("curl_json plugin: curl_easy_perform failed with status %i: %s (%s)",
           status, db->curl_errbuf, db->url);
@@ -906,12 +855,14 @@ static int cj_curl_perform(cj_t *db) /* {{{ */
     return -1;
   }
   return 0;
-} /* }}} int cj_curl_perform */
+} /* }}} int cj_curl_check */
 
-static int cj_perform(cj_t *db) /* {{{ */
+/* Resets the parser state and allocates a new yajl handle. */
+static int cj_parse_begin(cj_t *db) /* {{{ */
 {
-  int status;
-  yajl_handle yprev = db->yajl;
+  db->depth = 0;
+  memset(&db->state, 0, sizeof(db->state));
+  db->state[0].node = key_trie_root(db->keys);
 
   db->yajl = yajl_alloc(&ycallbacks,
 #if HAVE_YAJL_V2
@@ -922,41 +873,49 @@ static int cj_perform(cj_t *db) /* {{{ */
                         /* context = */ (void *)db);
   if (db->yajl == NULL) {
     ERROR("curl_json plugin: yajl_alloc failed.");
-    db->yajl = yprev;
+    db->state[0].node = NULL;
     return -1;
   }
 
-  if (db->url)
-    status = cj_curl_perform(db);
-  else
-    status = cj_sock_perform(db);
-  if (status < 0) {
-    yajl_free(db->yajl);
-    db->yajl = yprev;
-    return -1;
-  }
+  return 0;
+} /* }}} int cj_parse_begin */
 
+/* Finishes parsing if `status' is zero and frees the yajl handle. */
+static int cj_parse_end(cj_t *db, int status) /* {{{ */
+{
+  if (status == 0) {
 #if HAVE_YAJL_V2
-  status = yajl_complete_parse(db->yajl);
+    status = yajl_complete_parse(db->yajl);
 #else
-  status = yajl_parse_complete(db->yajl);
+    status = yajl_parse_complete(db->yajl);
 #endif
-  if (status != yajl_status_ok) {
-    unsigned char *errmsg;
-
-    errmsg = yajl_get_error(db->yajl, /* verbose = */ 0,
-                            /* jsonText = */ NULL, /* jsonTextLen = */ 0);
-    ERROR("curl_json plugin: yajl_parse_complete failed: %s", (char *)errmsg);
-    yajl_free_error(db->yajl, errmsg);
-    yajl_free(db->yajl);
-    db->yajl = yprev;
-    return -1;
+    if (status != yajl_status_ok) {
+      unsigned char *errmsg;
+
+      errmsg = yajl_get_error(db->yajl, /* verbose = */ 0,
+                              /* jsonText = */ NULL, /* jsonTextLen = */ 0);
+      ERROR("curl_json plugin: yajl_parse_complete failed: %s",
+            (char *)errmsg);
+      yajl_free_error(db->yajl, errmsg);
+      status = -1;
+    }
   }
 
   yajl_free(db->yajl);
-  db->yajl = yprev;
-  return 0;
-} /* }}} int cj_perform */
+  db->yajl = NULL;
+  db->state[0].node = NULL;
+
+  return (status == 0) ? 0 : -1;
+} /* }}} int cj_parse_end */
+
+/* Called by the cURL engine once the response has been received and parsed
+ * by `cj_curl_callback'. */
+static void cj_curl_done(__attribute__((unused)) CURL *curl, /* {{{ */
+                         CURLcode status, void *user_data) {
+  cj_t *db = user_data;
+
+  cj_parse_end(db, cj_curl_check(db, status));
+} /* }}} void cj_curl_done */
 
 static int cj_read(user_data_t *ud) /* {{{ */
 {
@@ -969,21 +928,34 @@ static int cj_read(user_data_t *ud) /* {{{ */
 
   db = (cj_t *)ud->data;
 
-  db->depth = 0;
-  memset(&db->state, 0, sizeof(db->state));
+  if (db->url != NULL) {
+    cdtime_t submitted;
+    unsigned int skipped = curl_engine_skip(db->curl, &submitted);
+    if (skipped > 0) {
+      WARNING("curl_json plugin: The request to `%s' has not finished after "
+              "%.3f seconds, skipping this interval (%u skipped so far).",
+              db->url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+      return 0;
+    }
+  }
 
-  /* This is not a compound literal because EPEL6's GCC is not cool enough to
-   * handle anonymous unions within compound literals. */
-  cj_tree_entry_t root = {0};
-  root.type = TREE;
-  root.tree = db->tree;
-  db->state[0].entry = &root;
+  if (cj_parse_begin(db) != 0)
+    return -1;
 
-  int status = cj_perform(db);
+  if (db->url == NULL)
+    return cj_parse_end(db, cj_sock_perform(db));
 
-  db->state[0].entry = NULL;
+  /* The response is parsed in the cURL engine's thread as it arrives. */
+  int status =
+      curl_engine_submit(db->curl, cj_curl_callback, db, cj_curl_done, db);
+  if (status != 0) {
+    ERROR("curl_json plugin: Submitting request to `%s' failed: %s", db->url,
+          STRERROR(status));
+    cj_parse_end(db, -1);
+    return -1;
+  }
 
-  return status;
+  return 0;
 } /* }}} int cj_read */
 
 static int cj_init(void) /* {{{ */
@@ -997,4 +969,5 @@ static int cj_init(void) /* {{{ */
 void module_register(void) {
   plugin_register_complex_config("curl_json", cj_config);
   plugin_register_init("curl_json", cj_init);
+  plugin_register_init_exclusive("curl_json");
 } /* void module_register */
@@ -11,6 +11,7 @@
 #include "curl_json.c"
 
 #include "testing.h"
+#include "utils/avltree/avltree.h"
 
 static void test_submit(cj_t *db, cj_key_t *key, value_t *value) {
   /* hack: we repurpose db->curl to store received values. */
@@ -44,7 +45,8 @@ static cj_t *test_setup(char *json, char *key_path) {
                         /* context = */ (void *)db);
 
   /* hack; see above. */
-  db->curl = (void *)cj_avl_create();
+  db->curl =
+      (void *)c_avl_create((int (*)(const void *, const void *))strcmp);
 
   cj_key_t *key = calloc(1, sizeof(*key));
   key->path = strdup(key_path);
@@ -52,10 +54,7 @@ static cj_t *test_setup(char *json, char *key_path) {
 
   assert(cj_append_key(db, key) == 0);
 
-  cj_tree_entry_t root = {0};
-  root.type = TREE;
-  root.tree = db->tree;
-  db->state[0].entry = &root;
+  db->state[0].node = key_trie_root(db->keys);
 
   cj_curl_callback(json, strlen(json), 1, db);
 #if HAVE_YAJL_V2
@@ -64,7 +63,7 @@ static cj_t *test_setup(char *json, char *key_path) {
   yajl_parse_complete(db->yajl);
 #endif
 
-  db->state[0].entry = NULL;
+  db->state[0].node = NULL;
 
   return db;
 }
@@ -99,6 +98,9 @@ DEF_TEST(parse) {
       /* nested map */
       {"{\"a\":{\"b\":{\"c\":123}}", "a/b/c", 123},
       {"{\"x\":{\"y\":{\"z\":789}}", "x/*/z", 789},
+      /* unconfigured siblings are skipped */
+      {"{\"a\":{\"x\":[1,{\"b\":2}],\"b\":3}}", "a/b", 3},
+      {"{\"a\":[{\"b\":5},{\"b\":6}]}", "a/1/b", 6},
       /* simple array */
       {"[10,11,12,13]", "0", 10},
       {"[10,11,12,13]", "1", 11},
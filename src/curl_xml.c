@@ -23,6 +23,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 #include "utils/curl_stats/curl_stats.h"
 #include "utils_llist.h"
 
@@ -105,7 +106,7 @@ typedef struct cx_s cx_t; /* }}} */
 /*
  * Private functions
  */
-static size_t cx_curl_callback(void *buf, /* {{{ */
+static size_t cx_curl_callback(char *buf, /* {{{ */
                                size_t size, size_t nmemb, void *user_data) {
   size_t len = size * nmemb;
 
@@ -129,7 +130,7 @@ static size_t cx_curl_callback(void *buf, /* {{{ */
     db->buffer_size = db->buffer_fill + len + 1;
   }
 
-  memcpy(db->buffer + db->buffer_fill, (char *)buf, len);
+  memcpy(db->buffer + db->buffer_fill, buf, len);
   db->buffer_fill += len;
   db->buffer[db->buffer_fill] = 0;
 
@@ -178,8 +179,10 @@ static void cx_free(void *arg) /* {{{ */
   if (db == NULL)
     return;
 
-  if (db->curl != NULL)
+  if (db->curl != NULL) {
+    curl_engine_cancel(db->curl);
     curl_easy_cleanup(db->curl);
+  }
   db->curl = NULL;
 
   if (db->xpath_list != NULL)
@@ -539,26 +542,17 @@ static int cx_parse_xml(cx_t *db, char *xml) /* {{{ */
   return status;
 } /* }}} cx_parse_xml */
 
-static int cx_read(user_data_t *ud) /* {{{ */
-{
-  if ((ud == NULL) || (ud->data == NULL)) {
-    ERROR("curl_xml plugin: cx_read: Invalid user data.");
-    return -1;
-  }
-
+/* Called by the cURL engine once the document has been received. */
+static void cx_curl_done(__attribute__((unused)) CURL *curl, /* {{{ */
+                         CURLcode code, void *user_data) {
   long rc;
   char *url;
-  cx_t *db = (cx_t *)ud->data;
-
-  db->buffer_fill = 0;
-
-  curl_easy_setopt(db->curl, CURLOPT_URL, db->url);
+  cx_t *db = user_data;
 
-  int status = curl_easy_perform(db->curl);
-  if (status != CURLE_OK) {
+  if (code != CURLE_OK) {
     ERROR("curl_xml plugin: curl_easy_perform failed with status %i: %s (%s)",
-          status, db->curl_errbuf, db->url);
-    return -1;
+          code, db->curl_errbuf, db->url);
+    return;
   }
   if (db->stats != NULL)
     curl_stats_dispatch(db->stats, db->curl, cx_host(db), "curl_xml",
@@ -572,13 +566,44 @@ static int cx_read(user_data_t *ud) /* {{{ */
     ERROR(
         "curl_xml plugin: curl_easy_perform failed with response code %ld (%s)",
         rc, url);
+    return;
+  }
+
+  cx_parse_xml(db, db->buffer);
+  db->buffer_fill = 0;
+} /* }}} void cx_curl_done */
+
+static int cx_read(user_data_t *ud) /* {{{ */
+{
+  if ((ud == NULL) || (ud->data == NULL)) {
+    ERROR("curl_xml plugin: cx_read: Invalid user data.");
     return -1;
   }
 
-  status = cx_parse_xml(db, db->buffer);
+  cx_t *db = (cx_t *)ud->data;
+
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(db->curl, &submitted);
+  if (skipped > 0) {
+    WARNING("curl_xml plugin: The request to `%s' has not finished after "
+            "%.3f seconds, skipping this interval (%u skipped so far).",
+            db->url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
   db->buffer_fill = 0;
 
-  return status;
+  curl_easy_setopt(db->curl, CURLOPT_URL, db->url);
+
+  int status = curl_engine_submit(db->curl, cx_curl_callback, db,
+                                  cx_curl_done, db);
+  if (status != 0) {
+    ERROR("curl_xml plugin: Submitting request to `%s' failed: %s", db->url,
+          STRERROR(status));
+    return -1;
+  }
+
+  return 0;
 } /* }}} int cx_read */
 
 /* Configuration handling functions {{{ */
@@ -972,4 +997,5 @@ static int cx_init(void) /* {{{ */
 void module_register(void) {
   plugin_register_complex_config("curl_xml", cx_config);
   plugin_register_init("curl_xml", cx_init);
+  plugin_register_init_exclusive("curl_xml");
 } /* void module_register */
@@ -107,9 +107,12 @@ static cf_global_option_t cf_global_options[] = {
     {"FQDNLookup", NULL, 0, "true"},
     {"Interval", NULL, 0, NULL},
     {"ReadThreads", NULL, 0, "5"},
+    {"InitThreads", NULL, 0, "1"},
     {"WriteThreads", NULL, 0, "5"},
     {"WriteQueueLimitHigh", NULL, 0, NULL},
     {"WriteQueueLimitLow", NULL, 0, NULL},
+    {"NotificationThreads", NULL, 0, "1"},
+    {"NotificationQueueLimit", NULL, 0, "10000"},
     {"Timeout", NULL, 0, "2"},
     {"AutoLoadPlugin", NULL, 0, "false"},
     {"CollectInternalStats", NULL, 0, "false"},
@@ -302,7 +305,17 @@ static int dispatch_loadplugin(oconfig_item_t *ci) {
       cf_util_get_cdtime(child, &ctx.flush_interval);
     else if (strcasecmp("FlushTimeout", child->key) == 0)
       cf_util_get_cdtime(child, &ctx.flush_timeout);
-    else {
+    else if (strcasecmp("InitAfter", child->key) == 0) {
+      for (int j = 0; j < child->values_num; j++) {
+        if (child->values[j].type != OCONFIG_TYPE_STRING) {
+          WARNING("The \"InitAfter\" option of plugin \"%s\" requires "
+                  "string arguments.",
+                  name);
+          continue;
+        }
+        plugin_register_init_after(name, child->values[j].value.string);
+      }
+    } else {
       WARNING("Ignoring unknown LoadPlugin option \"%s\" "
               "for plugin \"%s\"",
               child->key, name);
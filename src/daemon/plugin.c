@@ -35,6 +35,9 @@
 #include "plugin.h"
 #include "utils/avltree/avltree.h"
 #include "utils/common/common.h"
+#if HAVE_CURL_ENGINE
+#include "utils/curl_engine/curl_engine.h"
+#endif
 #include "utils/heap/heap.h"
 #include "utils_cache.h"
 #include "utils_complain.h"
@@ -101,6 +104,25 @@ struct write_queue_s {
   write_queue_t *next;
 };
 
+struct notification_queue_s;
+typedef struct notification_queue_s notification_queue_t;
+struct notification_queue_s {
+  notification_t n;
+  /* Identifies duplicates of this notification, see plugin_notification_key. */
+  char *key;
+  plugin_ctx_t ctx;
+  cdtime_t enqueue_time;
+  notification_queue_t *next;
+};
+
+/* Per notification callback statistics, reset whenever they are reported. */
+struct notification_stats_s {
+  derive_t failed;
+  cdtime_t time_sum;
+  uint64_t calls;
+};
+typedef struct notification_stats_s notification_stats_t;
+
 struct flush_callback_s {
   char *name;
   cdtime_t timeout;
@@ -113,6 +135,8 @@ typedef struct flush_callback_s flush_callback_t;
 static c_avl_tree_t *plugins_loaded;
 
 static llist_t *list_init;
+static llist_t *list_init_after; /* plugin name -> name of plugin to wait for */
+static llist_t *list_init_exclusive; /* names of plugins */
 static llist_t *list_write;
 static llist_t *list_flush;
 static llist_t *list_missing;
@@ -127,9 +151,41 @@ static fc_chain_t *pre_cache_chain;
 static fc_chain_t *post_cache_chain;
 
 static c_avl_tree_t *data_sets;
+/* Types may be registered by init callbacks running in parallel. */
+static pthread_rwlock_t data_sets_lock = PTHREAD_RWLOCK_INITIALIZER;
 
 static char *plugindir;
 
+/* Protects the callback lists, so that init callbacks running in parallel can
+ * register further callbacks. */
+static pthread_mutex_t register_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef enum { INIT_PENDING, INIT_RUNNING, INIT_DONE } init_state_t;
+
+typedef struct {
+  llentry_t *le; /* entry of `list_init' */
+  init_state_t state;
+  bool exclusive; /* see plugin_register_init_exclusive */
+  int status;
+  cdtime_t duration;
+} init_task_t;
+
+static init_task_t *init_tasks;
+static size_t init_tasks_num;
+static size_t init_tasks_running;
+/* While init callbacks run in parallel, the read threads are already running.
+ * Read callbacks of plugins that are still being initialized are put aside in
+ * `init_reads_waiting' until their init callback has returned. */
+static bool init_parallel;
+static read_func_t **init_reads_waiting;
+static size_t init_reads_waiting_num;
+/* Exclusive init callbacks run while no other init or read callback runs. */
+static size_t init_shared_running;
+static size_t init_exclusive_waiting;
+static bool init_exclusive_running;
+static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t init_cond = PTHREAD_COND_INITIALIZER;
+
 #ifndef DEFAULT_MAX_READ_INTERVAL
 #define DEFAULT_MAX_READ_INTERVAL TIME_T_TO_CDTIME_T_STATIC(86400)
 #endif
@@ -151,8 +207,51 @@ static pthread_cond_t write_cond = PTHREAD_COND_INITIALIZER;
 static pthread_t *write_threads;
 static size_t write_threads_num;
 
+static notification_queue_t *notification_queue_head;
+static notification_queue_t *notification_queue_tail;
+static long notification_queue_length;
+static long notification_queue_limit;
+/* coalescing key -> queued notification */
+static c_avl_tree_t *notification_queue_index;
+static bool notification_loop = true;
+static pthread_mutex_t notification_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notification_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *notification_threads;
+static size_t notification_threads_num;
+static derive_t stats_notifications_dropped;
+static derive_t stats_notifications_coalesced;
+static cdtime_t stats_notifications_wait_sum;
+static uint64_t stats_notifications_delivered;
+
+#define LOG_QUEUE_SIZE 1024
+#define LOG_REPEAT_INTERVAL TIME_T_TO_CDTIME_T_STATIC(10)
+typedef struct {
+  int level;
+  cdtime_t time;
+  plugin_ctx_t ctx;
+  char msg[1024];
+} log_queue_entry_t;
+static log_queue_entry_t *log_queue;
+static size_t log_queue_head;
+static size_t log_queue_length;
+static bool log_loop = true;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t log_thread;
+/* Time of the message currently handed to the log callbacks. */
+static cdtime_t log_thread_time;
+/* The last queued message and the number of suppressed duplicates. */
+static int log_last_level = -1;
+static plugin_ctx_t log_last_ctx;
+static char log_last_msg[1024];
+static uint64_t log_repeated;
+static cdtime_t log_repeated_since;
+static uint64_t log_dropped;
+static uint64_t log_dropped_pending;
+
 static pthread_key_t plugin_ctx_key;
 static bool plugin_ctx_key_initialized;
+static plugin_ctx_t ctx_init = {/* interval = */ 0};
 
 static long write_limit_high;
 static long write_limit_low;
@@ -160,11 +259,14 @@ static long write_limit_low;
 static pthread_mutex_t statistics_lock = PTHREAD_MUTEX_INITIALIZER;
 static derive_t stats_values_dropped;
 static bool record_statistics;
+/* callback name -> notification_stats_t */
+static llist_t *notification_stats;
 
 /*
  * Static functions
  */
 static int plugin_dispatch_values_internal(value_list_t *vl);
+static int plugin_dispatch_notification_internal(const notification_t *notif);
 
 static const char *plugin_get_dir(void) {
   if (plugindir == NULL)
@@ -198,6 +300,119 @@ static int plugin_update_internal_statistics(void) { /* {{{ */
   sstrncpy(vl.type_instance, "dropped", sizeof(vl.type_instance));
   plugin_dispatch_values(&vl);
 
+  /* Notification queue */
+  pthread_mutex_lock(&notification_lock);
+  gauge_t notification_queue_len = (gauge_t)notification_queue_length;
+  derive_t notifications_dropped = stats_notifications_dropped;
+  derive_t notifications_coalesced = stats_notifications_coalesced;
+  gauge_t notification_wait =
+      (stats_notifications_delivered > 0)
+          ? CDTIME_T_TO_DOUBLE(stats_notifications_wait_sum) /
+                (gauge_t)stats_notifications_delivered
+          : NAN;
+  stats_notifications_wait_sum = 0;
+  stats_notifications_delivered = 0;
+  pthread_mutex_unlock(&notification_lock);
+
+  sstrncpy(vl.plugin_instance, "notification_queue",
+           sizeof(vl.plugin_instance));
+
+  /* Notification queue : queue length */
+  vl.values = &(value_t){.gauge = notification_queue_len};
+  vl.values_len = 1;
+  sstrncpy(vl.type, "queue_length", sizeof(vl.type));
+  vl.type_instance[0] = 0;
+  plugin_dispatch_values(&vl);
+
+  /* Notification queue : Notifications dropped (queue length > limit) */
+  vl.values = &(value_t){.derive = notifications_dropped};
+  sstrncpy(vl.type, "derive", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "dropped", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+
+  /* Notification queue : Duplicates merged with a queued notification */
+  vl.values = &(value_t){.derive = notifications_coalesced};
+  sstrncpy(vl.type_instance, "coalesced", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+
+  /* Notification queue : Average time spent in the queue */
+  vl.values = &(value_t){.gauge = notification_wait};
+  sstrncpy(vl.type, "duration", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "wait", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+
+  /* Notification callbacks : Average duration and number of failures. The
+   * statistics are copied first, because dispatching values may need the
+   * lock, too. */
+  struct {
+    char name[DATA_MAX_NAME_LEN];
+    gauge_t duration;
+    derive_t failed;
+  } *callbacks = NULL;
+  size_t callbacks_num = 0;
+
+  pthread_mutex_lock(&statistics_lock);
+  if (notification_stats != NULL)
+    callbacks = calloc((size_t)llist_size(notification_stats) + 1,
+                       sizeof(*callbacks));
+  for (llentry_t *le = llist_head(notification_stats);
+       (callbacks != NULL) && (le != NULL); le = le->next) {
+    notification_stats_t *ns = le->value;
+
+    sstrncpy(callbacks[callbacks_num].name, le->key,
+             sizeof(callbacks[callbacks_num].name));
+    callbacks[callbacks_num].duration =
+        (ns->calls > 0) ? CDTIME_T_TO_DOUBLE(ns->time_sum) / (gauge_t)ns->calls
+                        : NAN;
+    callbacks[callbacks_num].failed = ns->failed;
+    callbacks_num++;
+
+    ns->time_sum = 0;
+    ns->calls = 0;
+  }
+  pthread_mutex_unlock(&statistics_lock);
+
+  for (size_t i = 0; i < callbacks_num; i++) {
+    /* Callback names, e.g. "write_http/foo", may contain slashes. */
+    ssnprintf(vl.plugin_instance, sizeof(vl.plugin_instance), "notification-%s",
+              callbacks[i].name);
+    for (char *c = vl.plugin_instance; *c != 0; c++)
+      if (*c == '/')
+        *c = '_';
+
+    vl.values = &(value_t){.gauge = callbacks[i].duration};
+    sstrncpy(vl.type, "duration", sizeof(vl.type));
+    vl.type_instance[0] = 0;
+    plugin_dispatch_values(&vl);
+
+    vl.values = &(value_t){.derive = callbacks[i].failed};
+    sstrncpy(vl.type, "derive", sizeof(vl.type));
+    sstrncpy(vl.type_instance, "failed", sizeof(vl.type_instance));
+    plugin_dispatch_values(&vl);
+  }
+  sfree(callbacks);
+
+  /* Log queue */
+  pthread_mutex_lock(&log_lock);
+  gauge_t log_queue_len = (gauge_t)log_queue_length;
+  derive_t log_messages_dropped = (derive_t)log_dropped;
+  pthread_mutex_unlock(&log_lock);
+
+  sstrncpy(vl.plugin_instance, "log_queue", sizeof(vl.plugin_instance));
+
+  /* Log queue : queue length */
+  vl.values = &(value_t){.gauge = log_queue_len};
+  vl.values_len = 1;
+  sstrncpy(vl.type, "queue_length", sizeof(vl.type));
+  vl.type_instance[0] = 0;
+  plugin_dispatch_values(&vl);
+
+  /* Log queue : Messages dropped (queue full) */
+  vl.values = &(value_t){.derive = log_messages_dropped};
+  sstrncpy(vl.type, "derive", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "dropped", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+
   /* Cache */
   sstrncpy(vl.plugin_instance, "cache", sizeof(vl.plugin_instance));
 
@@ -274,10 +489,12 @@ static void destroy_read_heap(void) /* {{{ */
 
 static int register_callback(llist_t **list, /* {{{ */
                              const char *name, callback_func_t *cf) {
+  pthread_mutex_lock(&register_lock);
 
   if (*list == NULL) {
     *list = llist_create();
     if (*list == NULL) {
+      pthread_mutex_unlock(&register_lock);
       ERROR("plugin: register_callback: "
             "llist_create failed.");
       destroy_callback(cf);
@@ -287,6 +504,7 @@ static int register_callback(llist_t **list, /* {{{ */
 
   char *key = strdup(name);
   if (key == NULL) {
+    pthread_mutex_unlock(&register_lock);
     ERROR("plugin: register_callback: strdup failed.");
     destroy_callback(cf);
     return -1;
@@ -296,6 +514,7 @@ static int register_callback(llist_t **list, /* {{{ */
   if (le == NULL) {
     le = llentry_create(key, cf);
     if (le == NULL) {
+      pthread_mutex_unlock(&register_lock);
       ERROR("plugin: register_callback: "
             "llentry_create failed.");
       sfree(key);
@@ -308,15 +527,20 @@ static int register_callback(llist_t **list, /* {{{ */
     callback_func_t *old_cf = le->value;
     le->value = cf;
 
+    pthread_mutex_unlock(&register_lock);
+
     P_WARNING("register_callback: "
               "a callback named `%s' already exists - "
               "overwriting the old entry!",
               name);
 
+    /* The free function may register or unregister callbacks itself. */
     destroy_callback(old_cf);
     sfree(key);
+    return 0;
   }
 
+  pthread_mutex_unlock(&register_lock);
   return 0;
 } /* }}} int register_callback */
 
@@ -392,11 +616,15 @@ static int plugin_unregister(llist_t *list, const char *name) /* {{{ */
   if (list == NULL)
     return -1;
 
+  pthread_mutex_lock(&register_lock);
   e = llist_search(list, name);
-  if (e == NULL)
+  if (e == NULL) {
+    pthread_mutex_unlock(&register_lock);
     return -1;
+  }
 
   llist_remove(list, e);
+  pthread_mutex_unlock(&register_lock);
 
   sfree(e->key);
   destroy_callback(e->value);
@@ -447,6 +675,123 @@ static int plugin_load_file(char const *file, bool global) {
   return 0;
 }
 
+/* Waits until no exclusive init callback runs or waits to run, if `exclusive'
+ * is false, or until no other init or read callback runs otherwise. Waiting
+ * exclusive callbacks take precedence. The caller must hold `init_lock'. */
+static void init_exclusion_enter(bool exclusive) /* {{{ */
+{
+  if (!exclusive) {
+    while (init_exclusive_running || (init_exclusive_waiting > 0))
+      pthread_cond_wait(&init_cond, &init_lock);
+    init_shared_running++;
+    return;
+  }
+
+  init_exclusive_waiting++;
+  while (init_exclusive_running || (init_shared_running > 0))
+    pthread_cond_wait(&init_cond, &init_lock);
+  init_exclusive_waiting--;
+  init_exclusive_running = true;
+} /* }}} void init_exclusion_enter */
+
+/* The caller must hold `init_lock'. */
+static void init_exclusion_leave(bool exclusive) /* {{{ */
+{
+  if (exclusive)
+    init_exclusive_running = false;
+  else
+    init_shared_running--;
+  pthread_cond_broadcast(&init_cond);
+} /* }}} void init_exclusion_leave */
+
+/* Returns true if the init callback of the plugin that registered `rf' has not
+ * returned yet. The caller must hold `init_lock'. */
+static bool init_read_waiting(read_func_t const *rf) /* {{{ */
+{
+  if (rf->rf_ctx.name == NULL)
+    return false;
+
+  for (size_t i = 0; i < init_tasks_num; i++) {
+    callback_func_t const *cf = init_tasks[i].le->value;
+    if ((init_tasks[i].state != INIT_DONE) && (cf->cf_ctx.name != NULL) &&
+        (strcasecmp(rf->rf_ctx.name, cf->cf_ctx.name) == 0))
+      return true;
+  }
+
+  return false;
+} /* }}} bool init_read_waiting */
+
+/* Hands the read callbacks of initialized plugins back to the read threads.
+ * The caller must hold `init_lock'. */
+static void init_release_reads(void) /* {{{ */
+{
+  size_t kept = 0;
+  bool released = false;
+
+  for (size_t i = 0; i < init_reads_waiting_num; i++) {
+    read_func_t *rf = init_reads_waiting[i];
+    if (init_read_waiting(rf)) {
+      init_reads_waiting[kept++] = rf;
+      continue;
+    }
+    c_heap_insert(read_heap, rf);
+    released = true;
+  }
+  init_reads_waiting_num = kept;
+
+  if (released) {
+    pthread_mutex_lock(&read_lock);
+    pthread_cond_broadcast(&read_cond);
+    pthread_mutex_unlock(&read_lock);
+  }
+} /* }}} void init_release_reads */
+
+/* While init callbacks run in parallel, puts `rf' aside and returns EAGAIN if
+ * its plugin is still being initialized. Otherwise waits until no exclusive
+ * init callback runs and sets `*shared', if the caller has to call
+ * plugin_read_leave() once the read callback has returned. */
+static int plugin_read_enter(read_func_t *rf, bool *shared) /* {{{ */
+{
+  *shared = false;
+
+  pthread_mutex_lock(&init_lock);
+  if (!init_parallel) {
+    pthread_mutex_unlock(&init_lock);
+    return 0;
+  }
+
+  if (init_read_waiting(rf)) {
+    read_func_t **tmp =
+        realloc(init_reads_waiting,
+                (init_reads_waiting_num + 1) * sizeof(*init_reads_waiting));
+    if (tmp != NULL) {
+      init_reads_waiting = tmp;
+      init_reads_waiting[init_reads_waiting_num++] = rf;
+    } else {
+      /* Try again later. */
+      rf->rf_next_read = cdtime() + MS_TO_CDTIME_T(100);
+      c_heap_insert(read_heap, rf);
+    }
+    pthread_mutex_unlock(&init_lock);
+    return EAGAIN;
+  }
+
+  init_exclusion_enter(/* exclusive = */ false);
+  *shared = true;
+  pthread_mutex_unlock(&init_lock);
+  return 0;
+} /* }}} int plugin_read_enter */
+
+static void plugin_read_leave(bool shared) /* {{{ */
+{
+  if (!shared)
+    return;
+
+  pthread_mutex_lock(&init_lock);
+  init_exclusion_leave(/* exclusive = */ false);
+  pthread_mutex_unlock(&init_lock);
+} /* }}} void plugin_read_leave */
+
 static void *plugin_read_thread(void __attribute__((unused)) * args) {
   while (read_loop != 0) {
     read_func_t *rf;
@@ -457,6 +802,7 @@ static void *plugin_read_thread(void __attribute__((unused)) * args) {
     int status;
     int rf_type;
     int rc;
+    bool shared;
 
     /* Get the read function that needs to be read next.
      * We don't need to hold "read_lock" for the heap, but we need
@@ -520,6 +866,9 @@ static void *plugin_read_thread(void __attribute__((unused)) * args) {
       continue;
     }
 
+    if (plugin_read_enter(rf, &shared) != 0)
+      continue;
+
     DEBUG("plugin_read_thread: Handling `%s'.", rf->rf_name);
 
     start = cdtime();
@@ -541,6 +890,7 @@ static void *plugin_read_thread(void __attribute__((unused)) * args) {
     }
 
     plugin_set_ctx(old_ctx);
+    plugin_read_leave(shared);
 
     /* If the function signals failure, we will increase the
      * intervals in which it will be called. */
@@ -898,6 +1248,484 @@ static void stop_write_threads(void) /* {{{ */
   }
 } /* }}} void stop_write_threads */
 
+static notification_stats_t *plugin_notification_stats(char *name) /* {{{ */
+{
+  llentry_t *le;
+
+  if (notification_stats == NULL) {
+    notification_stats = llist_create();
+    if (notification_stats == NULL)
+      return NULL;
+  }
+
+  le = llist_search(notification_stats, name);
+  if (le != NULL)
+    return le->value;
+
+  notification_stats_t *ns = calloc(1, sizeof(*ns));
+  char *key = strdup(name);
+  if ((ns == NULL) || (key == NULL) ||
+      ((le = llentry_create(key, ns)) == NULL)) {
+    sfree(ns);
+    sfree(key);
+    return NULL;
+  }
+  llist_append(notification_stats, le);
+
+  return ns;
+} /* }}} notification_stats_t *plugin_notification_stats */
+
+static void plugin_notification_stats_free(void) /* {{{ */
+{
+  if (notification_stats == NULL)
+    return;
+
+  for (llentry_t *le = llist_head(notification_stats); le != NULL;
+       le = le->next) {
+    sfree(le->key);
+    sfree(le->value);
+  }
+  llist_destroy(notification_stats);
+  notification_stats = NULL;
+} /* }}} void plugin_notification_stats_free */
+
+/* Notifications which only differ in their time and meta data are considered
+ * duplicates. */
+static char *plugin_notification_key(notification_t const *n) /* {{{ */
+{
+  return ssnprintf_alloc("%d/%s/%s/%s/%s/%s/%s", n->severity, n->host,
+                         n->plugin, n->plugin_instance, n->type,
+                         n->type_instance, n->message);
+} /* }}} char *plugin_notification_key */
+
+static void plugin_notification_queue_free(notification_queue_t *q) /* {{{ */
+{
+  if (q == NULL)
+    return;
+
+  if (q->n.meta != NULL)
+    plugin_notification_meta_free(q->n.meta);
+  sfree(q->key);
+  sfree(q);
+} /* }}} void plugin_notification_queue_free */
+
+/* Returns zero if the notification has been queued, ENOTCONN if there are no
+ * notification threads (any more) and another error code if it had to be
+ * dropped. */
+static int plugin_notification_enqueue(notification_t const *n) /* {{{ */
+{
+  notification_queue_t *q = calloc(1, sizeof(*q));
+  if (q == NULL)
+    return ENOMEM;
+
+  q->n = *n;
+  q->n.meta = NULL;
+  if ((plugin_notification_meta_copy(&q->n, n) != 0) ||
+      ((q->key = plugin_notification_key(n)) == NULL)) {
+    plugin_notification_queue_free(q);
+    return ENOMEM;
+  }
+
+  /* Store context of caller, so that the notification callbacks see the
+   * same context as if they were called directly. */
+  q->ctx = plugin_get_ctx();
+  q->enqueue_time = cdtime();
+
+  pthread_mutex_lock(&notification_lock);
+
+  if (!notification_loop || (notification_threads == NULL)) {
+    pthread_mutex_unlock(&notification_lock);
+    plugin_notification_queue_free(q);
+    return ENOTCONN;
+  }
+
+  /* A burst of identical notifications is only delivered once. The newest
+   * one wins, so that its time and meta data, e.g. the current value of a
+   * threshold notification, are delivered together. */
+  notification_queue_t *queued = NULL;
+  if (c_avl_get(notification_queue_index, q->key, (void *)&queued) == 0) {
+    if (queued->n.time <= q->n.time) {
+      notification_meta_t *meta = queued->n.meta;
+      queued->n.time = q->n.time;
+      queued->n.meta = q->n.meta;
+      q->n.meta = meta;
+    }
+    stats_notifications_coalesced++;
+    pthread_mutex_unlock(&notification_lock);
+    plugin_notification_queue_free(q);
+    return 0;
+  }
+
+  if ((notification_queue_limit > 0) &&
+      (notification_queue_length >= notification_queue_limit)) {
+    stats_notifications_dropped++;
+    pthread_mutex_unlock(&notification_lock);
+    plugin_notification_queue_free(q);
+    return ENOBUFS;
+  }
+
+  if (c_avl_insert(notification_queue_index, q->key, q) != 0) {
+    pthread_mutex_unlock(&notification_lock);
+    plugin_notification_queue_free(q);
+    return ENOMEM;
+  }
+
+  if (notification_queue_tail == NULL)
+    notification_queue_head = q;
+  else
+    notification_queue_tail->next = q;
+  notification_queue_tail = q;
+  notification_queue_length++;
+
+  pthread_cond_signal(&notification_cond);
+  pthread_mutex_unlock(&notification_lock);
+
+  return 0;
+} /* }}} int plugin_notification_enqueue */
+
+/* Returns NULL once the threads are shutting down and the queue is empty. */
+static notification_queue_t *plugin_notification_dequeue(void) /* {{{ */
+{
+  notification_queue_t *q;
+
+  pthread_mutex_lock(&notification_lock);
+
+  while (notification_loop && (notification_queue_head == NULL))
+    pthread_cond_wait(&notification_cond, &notification_lock);
+
+  q = notification_queue_head;
+  if (q == NULL) {
+    pthread_mutex_unlock(&notification_lock);
+    return NULL;
+  }
+
+  notification_queue_head = q->next;
+  if (notification_queue_head == NULL)
+    notification_queue_tail = NULL;
+  notification_queue_length--;
+  c_avl_remove(notification_queue_index, q->key, NULL, NULL);
+
+  stats_notifications_wait_sum += cdtime() - q->enqueue_time;
+  stats_notifications_delivered++;
+
+  pthread_mutex_unlock(&notification_lock);
+
+  return q;
+} /* }}} notification_queue_t *plugin_notification_dequeue */
+
+static void *plugin_notification_thread(void __attribute__((unused)) *
+                                        args) /* {{{ */
+{
+  notification_queue_t *q;
+
+  /* Notifications that were queued before shutting down are still
+   * delivered. */
+  while ((q = plugin_notification_dequeue()) != NULL) {
+    (void)plugin_set_ctx(q->ctx);
+    plugin_dispatch_notification_internal(&q->n);
+    plugin_notification_queue_free(q);
+  }
+
+  pthread_exit(NULL);
+  return (void *)0;
+} /* }}} void *plugin_notification_thread */
+
+static void start_notification_threads(size_t num) /* {{{ */
+{
+  if ((notification_threads != NULL) || (num == 0))
+    return;
+
+  notification_queue_index =
+      c_avl_create((int (*)(const void *, const void *))strcmp);
+  if (notification_queue_index == NULL) {
+    ERROR("plugin: start_notification_threads: c_avl_create failed.");
+    return;
+  }
+
+  pthread_mutex_lock(&notification_lock);
+  notification_threads = calloc(num, sizeof(*notification_threads));
+  if (notification_threads == NULL) {
+    pthread_mutex_unlock(&notification_lock);
+    ERROR("plugin: start_notification_threads: calloc failed.");
+    return;
+  }
+
+  notification_loop = true;
+  notification_threads_num = 0;
+  for (size_t i = 0; i < num; i++) {
+    int status = pthread_create(
+        notification_threads + notification_threads_num, /* attr = */ NULL,
+        plugin_notification_thread, /* arg = */ NULL);
+    if (status != 0) {
+      ERROR("plugin: start_notification_threads: pthread_create failed with "
+            "status %i (%s).",
+            status, STRERROR(status));
+      break;
+    }
+
+    char name[THREAD_NAME_MAX];
+    ssnprintf(name, sizeof(name), "notify#%" PRIu64,
+              (uint64_t)notification_threads_num);
+    set_thread_name(notification_threads[notification_threads_num], name);
+
+    notification_threads_num++;
+  } /* for (i) */
+
+  /* Without any threads, notifications are dispatched synchronously. */
+  if (notification_threads_num == 0)
+    sfree(notification_threads);
+  pthread_mutex_unlock(&notification_lock);
+} /* }}} void start_notification_threads */
+
+static void stop_notification_threads(void) /* {{{ */
+{
+  pthread_mutex_lock(&notification_lock);
+  if (notification_threads == NULL) {
+    pthread_mutex_unlock(&notification_lock);
+    return;
+  }
+
+  INFO("collectd: Stopping %" PRIsz " notification threads.",
+       notification_threads_num);
+
+  notification_loop = false;
+  pthread_cond_broadcast(&notification_cond);
+  pthread_mutex_unlock(&notification_lock);
+
+  /* The threads exit once the queue is empty. */
+  for (size_t i = 0; i < notification_threads_num; i++) {
+    if (pthread_join(notification_threads[i], NULL) != 0) {
+      ERROR("plugin: stop_notification_threads: pthread_join failed.");
+    }
+  }
+
+  pthread_mutex_lock(&notification_lock);
+  sfree(notification_threads);
+  notification_threads_num = 0;
+  assert(notification_queue_head == NULL);
+  c_avl_destroy(notification_queue_index);
+  notification_queue_index = NULL;
+  pthread_mutex_unlock(&notification_lock);
+} /* }}} void stop_notification_threads */
+
+/* Log messages are copied into a ring buffer by the logging threads and handed
+ * to the log callbacks by the log thread, so that slow log plugins don't hold
+ * up the other threads. */
+static void plugin_log_dispatch(int level, const char *msg) /* {{{ */
+{
+  llentry_t *le = llist_head(list_log);
+  while (le != NULL) {
+    callback_func_t *cf;
+    plugin_log_cb callback;
+
+    cf = le->value;
+    callback = cf->cf_callback;
+
+    /* do not switch plugin context; rather keep the context
+     * (interval) information of the calling plugin. The log thread restores
+     * that context from the queue entry before calling this. */
+
+    (*callback)(level, msg, &cf->cf_udata);
+
+    le = le->next;
+  }
+} /* }}} void plugin_log_dispatch */
+
+/* Must hold log_lock. Returns false if the ring is full. */
+static bool log_queue_push(int level, cdtime_t time, /* {{{ */
+                           plugin_ctx_t ctx, const char *msg) {
+  if (log_queue_length >= LOG_QUEUE_SIZE)
+    return false;
+
+  log_queue_entry_t *e =
+      log_queue + ((log_queue_head + log_queue_length) % LOG_QUEUE_SIZE);
+  e->level = level;
+  e->time = time;
+  e->ctx = ctx;
+  sstrncpy(e->msg, msg, sizeof(e->msg));
+  log_queue_length++;
+
+  pthread_cond_signal(&log_cond);
+  return true;
+} /* }}} bool log_queue_push */
+
+/* Must hold log_lock. Queues the summary of suppressed duplicates, if any. */
+static void log_queue_push_repeated(cdtime_t now) /* {{{ */
+{
+  char msg[64];
+
+  if (log_repeated == 0)
+    return;
+
+  ssnprintf(msg, sizeof(msg), "last message repeated %" PRIu64 " times",
+            log_repeated);
+  if (log_queue_push(log_last_level, now, log_last_ctx, msg)) {
+    log_repeated = 0;
+    log_repeated_since = now;
+  }
+} /* }}} void log_queue_push_repeated */
+
+/* Returns ENOTCONN if there is no log thread, i.e. the message has to be
+ * handed to the log callbacks directly. */
+static int plugin_log_enqueue(int level, const char *msg) /* {{{ */
+{
+  cdtime_t now = cdtime();
+
+  /* Store context of caller, so that the log callbacks see the same context
+   * as if they were called directly. Unlike plugin_get_ctx(), this does not
+   * allocate a context, which might have to log an error itself. */
+  plugin_ctx_t const *caller_ctx =
+      plugin_ctx_key_initialized ? pthread_getspecific(plugin_ctx_key) : NULL;
+  plugin_ctx_t ctx = (caller_ctx != NULL) ? *caller_ctx : ctx_init;
+
+  pthread_mutex_lock(&log_lock);
+
+  if (!log_loop || (log_queue == NULL)) {
+    pthread_mutex_unlock(&log_lock);
+    return ENOTCONN;
+  }
+
+  /* Consecutive duplicates are counted and summarized by the log thread at
+   * most once per LOG_REPEAT_INTERVAL. */
+  if ((level == log_last_level) && (strcmp(msg, log_last_msg) == 0)) {
+    if (log_repeated == 0)
+      log_repeated_since = now;
+    log_repeated++;
+    pthread_mutex_unlock(&log_lock);
+    return 0;
+  }
+  log_queue_push_repeated(now);
+
+  /* Leave room for the message about dropped messages. */
+  if ((log_dropped_pending > 0) && (log_queue_length + 1 < LOG_QUEUE_SIZE)) {
+    char dropped_msg[64];
+    ssnprintf(dropped_msg, sizeof(dropped_msg),
+              "%" PRIu64 " log messages were dropped", log_dropped_pending);
+    log_queue_push(LOG_WARNING, now, ctx, dropped_msg);
+    log_dropped_pending = 0;
+  }
+
+  if ((log_dropped_pending > 0) || !log_queue_push(level, now, ctx, msg)) {
+    log_dropped++;
+    log_dropped_pending++;
+    pthread_mutex_unlock(&log_lock);
+    return 0;
+  }
+
+  log_last_level = level;
+  log_last_ctx = ctx;
+  sstrncpy(log_last_msg, msg, sizeof(log_last_msg));
+
+  pthread_mutex_unlock(&log_lock);
+  return 0;
+} /* }}} int plugin_log_enqueue */
+
+static void *plugin_log_thread(void __attribute__((unused)) * args) /* {{{ */
+{
+  log_queue_entry_t e;
+
+  pthread_mutex_lock(&log_lock);
+  while (true) {
+    if (log_queue_length == 0) {
+      cdtime_t now = cdtime();
+
+      if ((log_repeated > 0) &&
+          (!log_loop || ((now - log_repeated_since) >= LOG_REPEAT_INTERVAL)))
+        log_queue_push_repeated(now);
+      else if (!log_loop)
+        break;
+      else {
+        struct timespec ts = CDTIME_T_TO_TIMESPEC(now + TIME_T_TO_CDTIME_T(1));
+        pthread_cond_timedwait(&log_cond, &log_lock, &ts);
+      }
+      continue;
+    }
+
+    memcpy(&e, log_queue + log_queue_head, sizeof(e));
+    log_queue_head = (log_queue_head + 1) % LOG_QUEUE_SIZE;
+    log_queue_length--;
+    pthread_mutex_unlock(&log_lock);
+
+    log_thread_time = e.time;
+    (void)plugin_set_ctx(e.ctx);
+    plugin_log_dispatch(e.level, e.msg);
+
+    pthread_mutex_lock(&log_lock);
+  }
+  pthread_mutex_unlock(&log_lock);
+
+  pthread_exit(NULL);
+  return (void *)0;
+} /* }}} void *plugin_log_thread */
+
+static void start_log_thread(void) /* {{{ */
+{
+  pthread_mutex_lock(&log_lock);
+  if ((log_queue != NULL) || (list_log == NULL)) {
+    pthread_mutex_unlock(&log_lock);
+    return;
+  }
+
+  log_queue = calloc(LOG_QUEUE_SIZE, sizeof(*log_queue));
+  if (log_queue == NULL) {
+    pthread_mutex_unlock(&log_lock);
+    ERROR("plugin: start_log_thread: calloc failed.");
+    return;
+  }
+  log_queue_head = 0;
+  log_queue_length = 0;
+  log_last_level = -1;
+  log_loop = true;
+
+  int status = pthread_create(&log_thread, /* attr = */ NULL,
+                              plugin_log_thread, /* arg = */ NULL);
+  if (status != 0) {
+    sfree(log_queue);
+    pthread_mutex_unlock(&log_lock);
+    ERROR("plugin: start_log_thread: pthread_create failed with status %i "
+          "(%s).",
+          status, STRERROR(status));
+    return;
+  }
+  set_thread_name(log_thread, "log");
+  pthread_mutex_unlock(&log_lock);
+} /* }}} void start_log_thread */
+
+static void stop_log_thread(void) /* {{{ */
+{
+  pthread_mutex_lock(&log_lock);
+  if (log_queue == NULL) {
+    pthread_mutex_unlock(&log_lock);
+    return;
+  }
+  log_loop = false;
+  pthread_cond_broadcast(&log_cond);
+  pthread_mutex_unlock(&log_lock);
+
+  /* The thread exits once all queued messages have been handed to the log
+   * callbacks. Until then, new messages are still queued. */
+  if (pthread_join(log_thread, NULL) != 0)
+    fprintf(stderr, "plugin: stop_log_thread: pthread_join failed.\n");
+
+  pthread_mutex_lock(&log_lock);
+  assert(log_queue_length == 0);
+  sfree(log_queue);
+  pthread_mutex_unlock(&log_lock);
+} /* }}} void stop_log_thread */
+
+EXPORT cdtime_t plugin_log_time(void) /* {{{ */
+{
+  pthread_mutex_lock(&log_lock);
+  bool in_log_thread =
+      (log_queue != NULL) && pthread_equal(pthread_self(), log_thread);
+  pthread_mutex_unlock(&log_lock);
+
+  /* log_thread_time is only written by the log thread itself. */
+  if (in_log_thread)
+    return log_thread_time;
+  return cdtime();
+} /* }}} cdtime_t plugin_log_time */
+
 /*
  * Public functions
  */
@@ -1070,6 +1898,61 @@ EXPORT int plugin_register_init(const char *name, int (*callback)(void)) {
   return create_register_callback(&list_init, name, (void *)callback, NULL);
 } /* plugin_register_init */
 
+EXPORT int plugin_register_init_after(const char *plugin, const char *after) {
+  if ((plugin == NULL) || (after == NULL))
+    return EINVAL;
+
+  char *key = strdup(plugin);
+  char *value = strdup(after);
+  if ((key == NULL) || (value == NULL)) {
+    sfree(key);
+    sfree(value);
+    return ENOMEM;
+  }
+
+  pthread_mutex_lock(&register_lock);
+  if (list_init_after == NULL)
+    list_init_after = llist_create();
+  llentry_t *le =
+      (list_init_after != NULL) ? llentry_create(key, value) : NULL;
+  if (le == NULL) {
+    pthread_mutex_unlock(&register_lock);
+    ERROR("plugin_register_init_after: Creating a list entry failed.");
+    sfree(key);
+    sfree(value);
+    return ENOMEM;
+  }
+  llist_append(list_init_after, le);
+  pthread_mutex_unlock(&register_lock);
+
+  return 0;
+} /* int plugin_register_init_after */
+
+EXPORT int plugin_register_init_exclusive(const char *plugin) {
+  if (plugin == NULL)
+    return EINVAL;
+
+  char *key = strdup(plugin);
+  if (key == NULL)
+    return ENOMEM;
+
+  pthread_mutex_lock(&register_lock);
+  if (list_init_exclusive == NULL)
+    list_init_exclusive = llist_create();
+  llentry_t *le =
+      (list_init_exclusive != NULL) ? llentry_create(key, NULL) : NULL;
+  if (le == NULL) {
+    pthread_mutex_unlock(&register_lock);
+    ERROR("plugin_register_init_exclusive: Creating a list entry failed.");
+    sfree(key);
+    return ENOMEM;
+  }
+  llist_append(list_init_exclusive, le);
+  pthread_mutex_unlock(&register_lock);
+
+  return 0;
+} /* int plugin_register_init_exclusive */
+
 static int plugin_compare_read_func(const void *arg0, const void *arg1) {
   const read_func_t *rf0;
   const read_func_t *rf1;
@@ -1382,8 +2265,11 @@ static void plugin_free_data_sets(void) {
   void *key;
   void *value;
 
-  if (data_sets == NULL)
+  pthread_rwlock_wrlock(&data_sets_lock);
+  if (data_sets == NULL) {
+    pthread_rwlock_unlock(&data_sets_lock);
     return;
+  }
 
   while (c_avl_pick(data_sets, &key, &value) == 0) {
     data_set_t *ds = value;
@@ -1395,20 +2281,28 @@ static void plugin_free_data_sets(void) {
 
   c_avl_destroy(data_sets);
   data_sets = NULL;
+  pthread_rwlock_unlock(&data_sets_lock);
 } /* void plugin_free_data_sets */
 
+/* The caller must hold `data_sets_lock' for writing. */
+static int plugin_remove_data_set(const char *name) {
+  data_set_t *ds;
+
+  if (data_sets == NULL)
+    return -1;
+
+  if (c_avl_remove(data_sets, name, NULL, (void *)&ds) != 0)
+    return -1;
+
+  sfree(ds->ds);
+  sfree(ds);
+
+  return 0;
+} /* int plugin_remove_data_set */
+
 EXPORT int plugin_register_data_set(const data_set_t *ds) {
   data_set_t *ds_copy;
 
-  if ((data_sets != NULL) && (c_avl_get(data_sets, ds->type, NULL) == 0)) {
-    NOTICE("Replacing DS `%s' with another version.", ds->type);
-    plugin_unregister_data_set(ds->type);
-  } else if (data_sets == NULL) {
-    data_sets = c_avl_create((int (*)(const void *, const void *))strcmp);
-    if (data_sets == NULL)
-      return -1;
-  }
-
   ds_copy = malloc(sizeof(*ds_copy));
   if (ds_copy == NULL)
     return -1;
@@ -1423,7 +2317,23 @@ EXPORT int plugin_register_data_set(const data_set_t *ds) {
   for (size_t i = 0; i < ds->ds_num; i++)
     memcpy(ds_copy->ds + i, ds->ds + i, sizeof(data_source_t));
 
-  return c_avl_insert(data_sets, (void *)ds_copy->type, (void *)ds_copy);
+  pthread_rwlock_wrlock(&data_sets_lock);
+  if ((data_sets != NULL) && (c_avl_get(data_sets, ds->type, NULL) == 0)) {
+    NOTICE("Replacing DS `%s' with another version.", ds->type);
+    plugin_remove_data_set(ds->type);
+  } else if (data_sets == NULL) {
+    data_sets = c_avl_create((int (*)(const void *, const void *))strcmp);
+    if (data_sets == NULL) {
+      pthread_rwlock_unlock(&data_sets_lock);
+      sfree(ds_copy->ds);
+      sfree(ds_copy);
+      return -1;
+    }
+  }
+
+  int status = c_avl_insert(data_sets, (void *)ds_copy->type, (void *)ds_copy);
+  pthread_rwlock_unlock(&data_sets_lock);
+  return status;
 } /* int plugin_register_data_set */
 
 EXPORT int plugin_register_log(const char *name, plugin_log_cb callback,
@@ -1606,18 +2516,11 @@ EXPORT int plugin_unregister_shutdown(const char *name) {
 }
 
 EXPORT int plugin_unregister_data_set(const char *name) {
-  data_set_t *ds;
-
-  if (data_sets == NULL)
-    return -1;
+  pthread_rwlock_wrlock(&data_sets_lock);
+  int status = plugin_remove_data_set(name);
+  pthread_rwlock_unlock(&data_sets_lock);
 
-  if (c_avl_remove(data_sets, name, NULL, (void *)&ds) != 0)
-    return -1;
-
-  sfree(ds->ds);
-  sfree(ds);
-
-  return 0;
+  return status;
 } /* int plugin_unregister_data_set */
 
 EXPORT int plugin_unregister_log(const char *name) {
@@ -1628,15 +2531,195 @@ EXPORT int plugin_unregister_notification(const char *name) {
   return plugin_unregister(list_notification, name);
 }
 
+/* Returns true if all plugins `task' has to wait for are initialized. Plugins
+ * without an init callback are ignored. The caller must hold `init_lock'. */
+static bool init_task_ready(init_task_t const *task) /* {{{ */
+{
+  for (llentry_t *le = llist_head(list_init_after); le != NULL; le = le->next) {
+    if (strcasecmp(le->key, task->le->key) != 0)
+      continue;
+
+    for (size_t i = 0; i < init_tasks_num; i++)
+      if ((strcasecmp(le->value, init_tasks[i].le->key) == 0) &&
+          (init_tasks[i].state != INIT_DONE))
+        return false;
+  }
+
+  return true;
+} /* }}} bool init_task_ready */
+
+/* `args' is NULL for the calling thread and the thread's number plus one for
+ * the additional threads. */
+static void *plugin_init_thread(void *args) /* {{{ */
+{
+  /* The thread names itself, as it may be done before its creator could. */
+  if (args != NULL) {
+    char name[THREAD_NAME_MAX];
+    ssnprintf(name, sizeof(name), "init#%" PRIuPTR, (uintptr_t)args - 1);
+    set_thread_name(pthread_self(), name);
+  }
+
+  pthread_mutex_lock(&init_lock);
+  while (true) {
+    init_task_t *task = NULL;
+    init_task_t *first_pending = NULL;
+
+    for (size_t i = 0; i < init_tasks_num; i++) {
+      if (init_tasks[i].state != INIT_PENDING)
+        continue;
+      if (first_pending == NULL)
+        first_pending = init_tasks + i;
+      if (init_task_ready(init_tasks + i)) {
+        task = init_tasks + i;
+        break;
+      }
+    }
+
+    if (first_pending == NULL)
+      break;
+
+    if (task == NULL) {
+      if (init_tasks_running > 0) {
+        pthread_cond_wait(&init_cond, &init_lock);
+        continue;
+      }
+
+      /* Nothing is running, so the remaining plugins wait for each other. */
+      task = first_pending;
+      ERROR("plugin_init_all: The plugins waiting for other plugins to be "
+            "initialized form a cycle. Initializing `%s' now.",
+            task->le->key);
+    }
+
+    task->state = INIT_RUNNING;
+    init_tasks_running++;
+    init_exclusion_enter(task->exclusive);
+    pthread_mutex_unlock(&init_lock);
+
+    callback_func_t *cf = task->le->value;
+    plugin_init_cb callback = cf->cf_callback;
+    plugin_ctx_t old_ctx = plugin_set_ctx(cf->cf_ctx);
+    cdtime_t start = cdtime();
+    task->status = (*callback)();
+    task->duration = cdtime() - start;
+    plugin_set_ctx(old_ctx);
+
+    /* Plugins that register read callbacks from the init
+     * callback should take care of appropriate error
+     * handling themselves. */
+    /* FIXME: Unload _all_ functions */
+    if (task->status != 0)
+      plugin_unregister_read(task->le->key);
+
+    pthread_mutex_lock(&init_lock);
+    init_exclusion_leave(task->exclusive);
+    task->state = INIT_DONE;
+    init_tasks_running--;
+    init_release_reads();
+    pthread_cond_broadcast(&init_cond);
+  }
+  pthread_mutex_unlock(&init_lock);
+
+  return NULL;
+} /* }}} void *plugin_init_thread */
+
+/* Calls all init callbacks using `threads_num' threads, including the calling
+ * one. If they run in parallel, `read_threads_num' read threads are started
+ * first, so that each plugin is read as soon as its init callback has
+ * returned. Returns non-zero if any of the callbacks failed. */
+static int init_all_callbacks(size_t threads_num, /* {{{ */
+                              size_t read_threads_num) {
+  int ret = 0;
+
+  init_tasks_num = (size_t)llist_size(list_init);
+  init_tasks = calloc(init_tasks_num, sizeof(*init_tasks));
+  if (init_tasks == NULL) {
+    ERROR("plugin_init_all: calloc failed.");
+    return -1;
+  }
+
+  size_t i = 0;
+  for (llentry_t *le = llist_head(list_init); le != NULL; le = le->next) {
+    init_tasks[i].le = le;
+    init_tasks[i].exclusive =
+        (llist_search(list_init_exclusive, le->key) != NULL);
+    i++;
+  }
+
+  if (threads_num > init_tasks_num)
+    threads_num = init_tasks_num;
+
+  pthread_mutex_lock(&init_lock);
+  init_parallel = (threads_num > 1);
+  pthread_mutex_unlock(&init_lock);
+
+  if ((threads_num > 1) && (read_threads_num > 0) && (read_heap != NULL))
+    start_read_threads(read_threads_num);
+
+  pthread_t *threads = NULL;
+  size_t threads_started = 0;
+  if (threads_num > 1)
+    threads = calloc(threads_num - 1, sizeof(*threads));
+  for (i = 0; (threads != NULL) && (i < threads_num - 1); i++) {
+    int status =
+        pthread_create(threads + threads_started, /* attr = */ NULL,
+                       plugin_init_thread, (void *)(threads_started + 1));
+    if (status != 0) {
+      ERROR("plugin_init_all: pthread_create failed with status %i (%s).",
+            status, STRERROR(status));
+      break;
+    }
+    threads_started++;
+  }
+
+  cdtime_t start = cdtime();
+  plugin_init_thread(/* args = */ NULL);
+  for (i = 0; i < threads_started; i++)
+    pthread_join(threads[i], /* retval = */ NULL);
+  sfree(threads);
+
+  pthread_mutex_lock(&init_lock);
+  init_parallel = false;
+  init_release_reads();
+  sfree(init_reads_waiting);
+  pthread_mutex_unlock(&init_lock);
+
+  for (i = 0; i < init_tasks_num; i++) {
+    init_task_t *task = init_tasks + i;
+
+    if (task->duration >= TIME_T_TO_CDTIME_T(1))
+      INFO("Initialization of plugin `%s' took %.3f seconds.", task->le->key,
+           CDTIME_T_TO_DOUBLE(task->duration));
+    else
+      DEBUG("Initialization of plugin `%s' took %.3f seconds.", task->le->key,
+            CDTIME_T_TO_DOUBLE(task->duration));
+
+    if (task->status != 0) {
+      ERROR("Initialization of plugin `%s' "
+            "failed with status %i. "
+            "Plugin will be unloaded.",
+            task->le->key, task->status);
+      ret = -1;
+    }
+  }
+  INFO("Initialization of %" PRIsz " plugins took %.3f seconds.",
+       init_tasks_num, CDTIME_T_TO_DOUBLE(cdtime() - start));
+
+  sfree(init_tasks);
+  init_tasks_num = 0;
+
+  return ret;
+} /* }}} int init_all_callbacks */
+
 EXPORT int plugin_init_all(void) {
   char const *chain_name;
-  llentry_t *le;
-  int status;
   int ret = 0;
 
   /* Init the value cache */
   uc_init();
 
+  start_log_thread();
+
   if (IS_TRUE(global_option_get("CollectInternalStats"))) {
     record_statistics = true;
     plugin_register_read("collectd", plugin_update_internal_statistics);
@@ -1674,55 +2757,52 @@ EXPORT int plugin_init_all(void) {
     write_threads_num = 5;
   }
 
+  long notification_threads_wanted =
+      global_option_get_long("NotificationThreads", /* default = */ 1);
+  if (notification_threads_wanted < 0) {
+    ERROR("NotificationThreads must be positive or zero.");
+    notification_threads_wanted = 1;
+  }
+
+  notification_queue_limit =
+      global_option_get_long("NotificationQueueLimit", /* default = */ 10000);
+  if (notification_queue_limit < 0) {
+    ERROR("NotificationQueueLimit must be positive or zero.");
+    notification_queue_limit = 10000;
+  }
+
   if ((list_init == NULL) && (read_heap == NULL))
     return ret;
 
-  /* Calling all init callbacks before checking if read callbacks
-   * are available allows the init callbacks to register the read
-   * callback. */
-  le = llist_head(list_init);
-  while (le != NULL) {
-    callback_func_t *cf;
-    plugin_init_cb callback;
-    plugin_ctx_t old_ctx;
+  long init_threads_num =
+      global_option_get_long("InitThreads", /* default = */ 1);
+  if (init_threads_num < 1) {
+    ERROR("InitThreads must be positive.");
+    init_threads_num = 1;
+  }
 
-    cf = le->value;
-    old_ctx = plugin_set_ctx(cf->cf_ctx);
-    callback = cf->cf_callback;
-    status = (*callback)();
-    plugin_set_ctx(old_ctx);
+  max_read_interval =
+      global_option_get_time("MaxReadInterval", DEFAULT_MAX_READ_INTERVAL);
 
-    if (status != 0) {
-      ERROR("Initialization of plugin `%s' "
-            "failed with status %i. "
-            "Plugin will be unloaded.",
-            le->key, status);
-      /* Plugins that register read callbacks from the init
-       * callback should take care of appropriate error
-       * handling themselves. */
-      /* FIXME: Unload _all_ functions */
-      plugin_unregister_read(le->key);
-      ret = -1;
-    }
+  /* ReadThreads is -1 when reading only once, see plugin_read_all_once(). */
+  int num = atoi(global_option_get("ReadThreads"));
+  size_t read_threads_num = 0;
+  if (num != -1)
+    read_threads_num = (num > 0) ? ((size_t)num) : 5;
 
-    le = le->next;
-  }
+  /* Calling all init callbacks before checking if read callbacks
+   * are available allows the init callbacks to register the read
+   * callback. */
+  if ((list_init != NULL) &&
+      (init_all_callbacks((size_t)init_threads_num, read_threads_num) != 0))
+    ret = -1;
 
   start_write_threads((size_t)write_threads_num);
-
-  max_read_interval =
-      global_option_get_time("MaxReadInterval", DEFAULT_MAX_READ_INTERVAL);
+  start_notification_threads((size_t)notification_threads_wanted);
 
   /* Start read-threads */
-  if (read_heap != NULL) {
-    const char *rt;
-    int num;
-
-    rt = global_option_get("ReadThreads");
-    num = atoi(rt);
-    if (num != -1)
-      start_read_threads((num > 0) ? ((size_t)num) : 5);
-  }
+  if ((read_heap != NULL) && (read_threads_num > 0))
+    start_read_threads(read_threads_num);
   return ret;
 } /* void plugin_init_all */
 
@@ -1896,6 +2976,18 @@ EXPORT int plugin_shutdown_all(void) {
 
   destroy_all_callbacks(&list_init);
 
+  for (le = llist_head(list_init_after); le != NULL; le = le->next) {
+    sfree(le->key);
+    sfree(le->value);
+  }
+  llist_destroy(list_init_after);
+  list_init_after = NULL;
+
+  for (le = llist_head(list_init_exclusive); le != NULL; le = le->next)
+    sfree(le->key);
+  llist_destroy(list_init_exclusive);
+  list_init_exclusive = NULL;
+
   stop_read_threads();
 
   pthread_mutex_lock(&read_lock);
@@ -1908,11 +3000,18 @@ EXPORT int plugin_shutdown_all(void) {
   /* blocks until all write threads have shut down. */
   stop_write_threads();
 
+  /* blocks until all queued notifications have been delivered. */
+  stop_notification_threads();
+
   /* ask all plugins to write out the state they kept. */
   plugin_flush(/* plugin = */ NULL,
                /* timeout = */ 0,
                /* identifier = */ NULL);
 
+  /* log plugins may free their resources in their shutdown callbacks, so all
+   * queued messages have to be written before. */
+  stop_log_thread();
+
   le = NULL;
   if (list_shutdown != NULL)
     le = llist_head(list_shutdown);
@@ -1938,6 +3037,12 @@ EXPORT int plugin_shutdown_all(void) {
     plugin_set_ctx(old_ctx);
   }
 
+#if HAVE_CURL_ENGINE
+  /* Plugins have cancelled their transfers when their read callbacks were
+   * freed or in their shutdown callbacks. */
+  curl_engine_shutdown();
+#endif
+
   /* Write plugins which use the `user_data' pointer usually need the
    * same data available to the flush callback. If this is the case, set
    * the free_function to NULL when registering the flush callback and to
@@ -1949,6 +3054,7 @@ EXPORT int plugin_shutdown_all(void) {
   destroy_all_callbacks(&list_write);
 
   destroy_all_callbacks(&list_notification);
+  plugin_notification_stats_free();
   destroy_all_callbacks(&list_shutdown);
   destroy_all_callbacks(&list_log);
 
@@ -2094,7 +3200,9 @@ static int plugin_dispatch_values_internal(value_list_t *vl) {
                     "registered. Please load at least one output plugin, "
                     "if you want the collected data to be stored.");
 
+  pthread_rwlock_rdlock(&data_sets_lock);
   if (data_sets == NULL) {
+    pthread_rwlock_unlock(&data_sets_lock);
     ERROR("plugin_dispatch_values: No data sets registered. "
           "Could the types database be read? Check "
           "your `TypesDB' setting!");
@@ -2102,7 +3210,9 @@ static int plugin_dispatch_values_internal(value_list_t *vl) {
   }
 
   data_set_t *ds = NULL;
-  if (c_avl_get(data_sets, vl->type, (void *)&ds) != 0) {
+  status = c_avl_get(data_sets, vl->type, (void *)&ds);
+  pthread_rwlock_unlock(&data_sets_lock);
+  if (status != 0) {
     char ident[6 * DATA_MAX_NAME_LEN];
 
     FORMAT_VL(ident, sizeof(ident), vl);
@@ -2348,18 +3458,8 @@ plugin_dispatch_multivalue(value_list_t const *template, /* {{{ */
   return failed;
 } /* }}} int plugin_dispatch_multivalue */
 
-EXPORT int plugin_dispatch_notification(const notification_t *notif) {
+static int plugin_dispatch_notification_internal(const notification_t *notif) {
   llentry_t *le;
-  /* Possible TODO: Add flap detection here */
-
-  DEBUG("plugin_dispatch_notification: severity = %i; message = %s; "
-        "time = %.3f; host = %s;",
-        notif->severity, notif->message, CDTIME_T_TO_DOUBLE(notif->time),
-        notif->host);
-
-  /* Nobody cares for notifications */
-  if (list_notification == NULL)
-    return -1;
 
   le = llist_head(list_notification);
   while (le != NULL) {
@@ -2372,6 +3472,8 @@ EXPORT int plugin_dispatch_notification(const notification_t *notif) {
 
     cf = le->value;
     callback = cf->cf_callback;
+
+    cdtime_t start = record_statistics ? cdtime() : 0;
     status = (*callback)(notif, &cf->cf_udata);
     if (status != 0) {
       WARNING("plugin_dispatch_notification: Notification "
@@ -2379,16 +3481,52 @@ EXPORT int plugin_dispatch_notification(const notification_t *notif) {
               le->key, status);
     }
 
+    if (record_statistics) {
+      cdtime_t duration = cdtime() - start;
+
+      pthread_mutex_lock(&statistics_lock);
+      notification_stats_t *ns = plugin_notification_stats(le->key);
+      if (ns != NULL) {
+        ns->time_sum += duration;
+        ns->calls++;
+        if (status != 0)
+          ns->failed++;
+      }
+      pthread_mutex_unlock(&statistics_lock);
+    }
+
     le = le->next;
   }
 
+  return 0;
+} /* int plugin_dispatch_notification_internal */
+
+EXPORT int plugin_dispatch_notification(const notification_t *notif) {
+  /* Possible TODO: Add flap detection here */
+
+  DEBUG("plugin_dispatch_notification: severity = %i; message = %s; "
+        "time = %.3f; host = %s;",
+        notif->severity, notif->message, CDTIME_T_TO_DOUBLE(notif->time),
+        notif->host);
+
+  /* Nobody cares for notifications */
+  if (list_notification == NULL)
+    return -1;
+
+  /* Notifications are handed to the notification threads, unless there are
+   * none, e.g. before all plugins have been initialized. */
+  int status = plugin_notification_enqueue(notif);
+  if (status == ENOTCONN)
+    return plugin_dispatch_notification_internal(notif);
+  else if (status != 0)
+    return -1;
+
   return 0;
 } /* int plugin_dispatch_notification */
 
 EXPORT void plugin_log(int level, const char *format, ...) {
   char msg[1024];
   va_list ap;
-  llentry_t *le;
 
 #if !COLLECT_DEBUG
   if (level >= LOG_DEBUG)
@@ -2405,21 +3543,8 @@ EXPORT void plugin_log(int level, const char *format, ...) {
     return;
   }
 
-  le = llist_head(list_log);
-  while (le != NULL) {
-    callback_func_t *cf;
-    plugin_log_cb callback;
-
-    cf = le->value;
-    callback = cf->cf_callback;
-
-    /* do not switch plugin context; rather keep the context
-     * (interval) information of the calling plugin */
-
-    (*callback)(level, msg, &cf->cf_udata);
-
-    le = le->next;
-  }
+  if (plugin_log_enqueue(level, msg) == ENOTCONN)
+    plugin_log_dispatch(level, msg);
 } /* void plugin_log */
 
 void daemon_log(int level, const char *format, ...) {
@@ -2475,12 +3600,16 @@ EXPORT int parse_notif_severity(const char *severity) {
 EXPORT const data_set_t *plugin_get_ds(const char *name) {
   data_set_t *ds;
 
+  pthread_rwlock_rdlock(&data_sets_lock);
   if (data_sets == NULL) {
+    pthread_rwlock_unlock(&data_sets_lock);
     P_ERROR("plugin_get_ds: No data sets are defined yet.");
     return NULL;
   }
 
-  if (c_avl_get(data_sets, name, (void *)&ds) != 0) {
+  int status = c_avl_get(data_sets, name, (void *)&ds);
+  pthread_rwlock_unlock(&data_sets_lock);
+  if (status != 0) {
     DEBUG("No such dataset registered: %s", name);
     return NULL;
   }
@@ -2641,8 +3770,6 @@ static void plugin_ctx_destructor(void *ctx) {
   sfree(ctx);
 } /* void plugin_ctx_destructor */
 
-static plugin_ctx_t ctx_init = {/* interval = */ 0};
-
 static plugin_ctx_t *plugin_ctx_create(void) {
   plugin_ctx_t *ctx;
 
@@ -297,6 +297,14 @@ int plugin_register_config(const char *name,
 int plugin_register_complex_config(const char *type,
                                    int (*callback)(oconfig_item_t *));
 int plugin_register_init(const char *name, plugin_init_cb callback);
+/* Declares that the init callback of `plugin' must not be called before the
+ * init callback of `after' has returned, which matters when init callbacks
+ * run in parallel (see the "InitThreads" option). */
+int plugin_register_init_after(const char *plugin, const char *after);
+/* Declares that the init callback of `plugin' must not run at the same time as
+ * any other init or read callback, e.g. because it initializes a library that
+ * is not thread-safe, such as libcurl or Net-SNMP. */
+int plugin_register_init_exclusive(const char *plugin);
 int plugin_register_read(const char *name, int (*callback)(void));
 /* "user_data" will be freed automatically, unless
  * "plugin_register_complex_read" returns an error (non-zero). */
@@ -408,6 +416,11 @@ int plugin_dispatch_notification(const notification_t *notif);
 void plugin_log(int level, const char *format, ...)
     __attribute__((format(printf, 2, 3)));
 
+/* Returns the time at which the message passed to a log callback has been
+ * logged. Log messages are handed to the log callbacks asynchronously, so this
+ * may be earlier than the current time. */
+cdtime_t plugin_log_time(void);
+
 /* These functions return the parsed severity or less than zero on failure. */
 int parse_log_severity(const char *severity);
 int parse_notif_severity(const char *severity);
@@ -58,6 +58,15 @@ int plugin_register_init(const char *name, plugin_init_cb callback) {
   return ENOTSUP;
 }
 
+int plugin_register_init_after(__attribute__((unused)) const char *plugin,
+                               __attribute__((unused)) const char *after) {
+  return ENOTSUP;
+}
+
+int plugin_register_init_exclusive(__attribute__((unused)) const char *plugin) {
+  return ENOTSUP;
+}
+
 int plugin_register_read(__attribute__((unused)) const char *name,
                          __attribute__((unused)) int (*callback)(void)) {
   return ENOTSUP;
@@ -121,6 +130,12 @@ DECLARE_UNREGISTER(notification)
 
 int plugin_dispatch_values(value_list_t const *vl) { return ENOTSUP; }
 
+int plugin_write(__attribute__((unused)) const char *plugin,
+                 __attribute__((unused)) const data_set_t *ds,
+                 __attribute__((unused)) const value_list_t *vl) {
+  return ENOTSUP;
+}
+
 int plugin_dispatch_notification(__attribute__((unused))
                                  const notification_t *notif) {
   return ENOTSUP;
@@ -204,6 +219,8 @@ void plugin_log(int level, char const *format, ...) {
   printf("plugin_log (%i, \"%s\");\n", level, buffer);
 }
 
+cdtime_t plugin_log_time(void) { return cdtime(); }
+
 void daemon_log(int level, char const *format, ...) {
   char buffer[1024];
   va_list ap;
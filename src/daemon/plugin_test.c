@@ -0,0 +1,397 @@
+/**
+ * collectd - src/daemon/plugin_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "plugin.c" /* sic */
+#include "testing.h"
+
+typedef struct {
+  char message[NOTIF_MAX_MSG_LEN];
+  cdtime_t time;
+  double current_value;
+  pthread_t thread;
+} delivered_t;
+
+static pthread_mutex_t test_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t test_cond = PTHREAD_COND_INITIALIZER;
+/* The notification callback blocks while the gate is closed, so that the
+ * following notifications stay in the queue. */
+static bool gate_open = true;
+static delivered_t delivered[16];
+static size_t delivered_num;
+
+static int test_notification(const notification_t *n,
+                             user_data_t __attribute__((unused)) * ud) {
+  pthread_mutex_lock(&test_lock);
+  while (!gate_open)
+    pthread_cond_wait(&test_cond, &test_lock);
+
+  assert(delivered_num < STATIC_ARRAY_SIZE(delivered));
+  delivered_t *d = delivered + delivered_num;
+  sstrncpy(d->message, n->message, sizeof(d->message));
+  d->time = n->time;
+  d->current_value = NAN;
+  for (notification_meta_t *m = n->meta; m != NULL; m = m->next)
+    if ((strcmp("CurrentValue", m->name) == 0) && (m->type == NM_TYPE_DOUBLE))
+      d->current_value = m->nm_value.nm_double;
+  d->thread = pthread_self();
+  delivered_num++;
+
+  pthread_cond_broadcast(&test_cond);
+  pthread_mutex_unlock(&test_lock);
+  return 0;
+}
+
+static void gate_set(bool open) {
+  pthread_mutex_lock(&test_lock);
+  gate_open = open;
+  pthread_cond_broadcast(&test_cond);
+  pthread_mutex_unlock(&test_lock);
+}
+
+static void wait_delivered(size_t num) {
+  pthread_mutex_lock(&test_lock);
+  while (delivered_num < num)
+    pthread_cond_wait(&test_cond, &test_lock);
+  pthread_mutex_unlock(&test_lock);
+}
+
+/* Waits until the notification thread has taken all queued notifications. */
+static void wait_dequeued(void) {
+  pthread_mutex_lock(&notification_lock);
+  while (notification_queue_length > 0) {
+    pthread_mutex_unlock(&notification_lock);
+    usleep(1000);
+    pthread_mutex_lock(&notification_lock);
+  }
+  pthread_mutex_unlock(&notification_lock);
+}
+
+static long queue_length(void) {
+  pthread_mutex_lock(&notification_lock);
+  long len = notification_queue_length;
+  pthread_mutex_unlock(&notification_lock);
+  return len;
+}
+
+static int dispatch(char const *message, cdtime_t time, double current_value) {
+  notification_t n = {
+      .severity = NOTIF_WARNING,
+      .time = time,
+      .plugin = "test",
+  };
+  sstrncpy(n.message, message, sizeof(n.message));
+  if (!isnan(current_value))
+    plugin_notification_meta_add_double(&n, "CurrentValue", current_value);
+
+  int status = plugin_dispatch_notification(&n);
+  if (n.meta != NULL)
+    plugin_notification_meta_free(n.meta);
+  return status;
+}
+
+DEF_TEST(synchronous) {
+  delivered_num = 0;
+
+  /* Without notification threads, the callbacks run in the caller's
+   * thread before plugin_dispatch_notification() returns. */
+  CHECK_ZERO(dispatch("synchronous", TIME_T_TO_CDTIME_T(1), 1.0));
+  EXPECT_EQ_INT(1, (int)delivered_num);
+  OK(pthread_equal(pthread_self(), delivered[0].thread));
+  EXPECT_EQ_DOUBLE(1.0, delivered[0].current_value);
+
+  return 0;
+}
+
+DEF_TEST(coalesce) {
+  delivered_num = 0;
+  stats_notifications_coalesced = 0;
+  notification_queue_limit = 0;
+  gate_set(false);
+
+  start_notification_threads(1);
+  CHECK_NOT_NULL(notification_threads);
+
+  /* Keeps the thread busy. */
+  CHECK_ZERO(dispatch("blocker", TIME_T_TO_CDTIME_T(1), NAN));
+  wait_dequeued();
+
+  CHECK_ZERO(dispatch("value too high", TIME_T_TO_CDTIME_T(10), 10.0));
+  CHECK_ZERO(dispatch("value too high", TIME_T_TO_CDTIME_T(30), 30.0));
+  /* Older than the queued one; neither its time nor its meta data are
+   * used. */
+  CHECK_ZERO(dispatch("value too high", TIME_T_TO_CDTIME_T(20), 20.0));
+  CHECK_ZERO(dispatch("something else", TIME_T_TO_CDTIME_T(40), 40.0));
+  EXPECT_EQ_INT(2, (int)queue_length());
+  EXPECT_EQ_INT(2, (int)stats_notifications_coalesced);
+
+  gate_set(true);
+  wait_delivered(3);
+  stop_notification_threads();
+
+  EXPECT_EQ_INT(3, (int)delivered_num);
+  EXPECT_EQ_STR("blocker", delivered[0].message);
+  OK(!pthread_equal(pthread_self(), delivered[0].thread));
+  EXPECT_EQ_STR("value too high", delivered[1].message);
+  EXPECT_EQ_UINT64(TIME_T_TO_CDTIME_T(30), delivered[1].time);
+  EXPECT_EQ_DOUBLE(30.0, delivered[1].current_value);
+  EXPECT_EQ_STR("something else", delivered[2].message);
+  EXPECT_EQ_DOUBLE(40.0, delivered[2].current_value);
+
+  return 0;
+}
+
+DEF_TEST(queue_limit) {
+  delivered_num = 0;
+  stats_notifications_dropped = 0;
+  notification_queue_limit = 2;
+  gate_set(false);
+
+  start_notification_threads(1);
+  CHECK_NOT_NULL(notification_threads);
+
+  CHECK_ZERO(dispatch("blocker", TIME_T_TO_CDTIME_T(1), NAN));
+  wait_dequeued();
+
+  CHECK_ZERO(dispatch("first", TIME_T_TO_CDTIME_T(2), NAN));
+  CHECK_ZERO(dispatch("second", TIME_T_TO_CDTIME_T(3), NAN));
+  /* The queue is full. */
+  EXPECT_EQ_INT(-1, dispatch("third", TIME_T_TO_CDTIME_T(4), NAN));
+  EXPECT_EQ_INT(1, (int)stats_notifications_dropped);
+  /* Duplicates of queued notifications are still merged. */
+  CHECK_ZERO(dispatch("second", TIME_T_TO_CDTIME_T(5), NAN));
+  EXPECT_EQ_INT(1, (int)stats_notifications_dropped);
+
+  gate_set(true);
+  /* Notifications queued before shutting down are still delivered. */
+  stop_notification_threads();
+  OK(notification_threads == NULL);
+
+  EXPECT_EQ_INT(3, (int)delivered_num);
+  EXPECT_EQ_STR("first", delivered[1].message);
+  EXPECT_EQ_STR("second", delivered[2].message);
+  EXPECT_EQ_UINT64(TIME_T_TO_CDTIME_T(5), delivered[2].time);
+
+  /* After the threads have stopped, delivery is synchronous again. */
+  CHECK_ZERO(dispatch("after", TIME_T_TO_CDTIME_T(6), NAN));
+  EXPECT_EQ_INT(4, (int)delivered_num);
+  OK(pthread_equal(pthread_self(), delivered[3].thread));
+
+  return 0;
+}
+
+typedef struct {
+  char name[DATA_MAX_NAME_LEN];
+  cdtime_t interval;
+  cdtime_t time;
+  pthread_t thread;
+} logged_t;
+
+static logged_t logged[4];
+static size_t logged_num;
+
+static void test_log(int __attribute__((unused)) severity, const char *msg,
+                     user_data_t __attribute__((unused)) * ud) {
+  if ((strncmp("test: ", msg, strlen("test: ")) != 0) ||
+      (logged_num >= STATIC_ARRAY_SIZE(logged)))
+    return;
+
+  plugin_ctx_t ctx = plugin_get_ctx();
+  logged_t *l = logged + logged_num;
+  sstrncpy(l->name, (ctx.name != NULL) ? ctx.name : "", sizeof(l->name));
+  l->interval = ctx.interval;
+  l->time = plugin_log_time();
+  l->thread = pthread_self();
+  logged_num++;
+}
+
+DEF_TEST(log_context) {
+  logged_num = 0;
+  CHECK_ZERO(plugin_register_log("test", test_log, NULL));
+
+  plugin_ctx_t ctx = {
+      .name = "caller",
+      .interval = TIME_T_TO_CDTIME_T(42),
+  };
+  plugin_ctx_t old = plugin_set_ctx(ctx);
+
+  start_log_thread();
+  CHECK_NOT_NULL(log_queue);
+
+  cdtime_t before = cdtime();
+  plugin_log(LOG_INFO, "test: queued");
+  cdtime_t after = cdtime();
+  /* Waits for all queued messages to be handed to the callbacks. */
+  stop_log_thread();
+
+  /* The log callbacks run in the log thread with the caller's context and
+   * see the time the message was logged. */
+  EXPECT_EQ_INT(1, (int)logged_num);
+  OK(!pthread_equal(pthread_self(), logged[0].thread));
+  EXPECT_EQ_STR("caller", logged[0].name);
+  EXPECT_EQ_UINT64(TIME_T_TO_CDTIME_T(42), logged[0].interval);
+  OK((logged[0].time >= before) && (logged[0].time <= after));
+
+  /* Without the log thread, the callbacks are called directly. */
+  plugin_log(LOG_INFO, "test: direct");
+  EXPECT_EQ_INT(2, (int)logged_num);
+  OK(pthread_equal(pthread_self(), logged[1].thread));
+  EXPECT_EQ_STR("caller", logged[1].name);
+
+  plugin_set_ctx(old);
+  plugin_unregister_log("test");
+  return 0;
+}
+
+/* Number of init and read callbacks of the "parallel" test running. */
+static int callbacks_running;
+static bool exclusive_alone = true;
+static int fast_reads;
+static int slow_reads;
+static bool slow_init_done;
+static bool slow_read_early;
+static bool slow_saw_fast_read;
+
+static void callback_enter(void) {
+  pthread_mutex_lock(&test_lock);
+  callbacks_running++;
+  pthread_mutex_unlock(&test_lock);
+}
+
+static void callback_leave(void) {
+  pthread_mutex_lock(&test_lock);
+  callbacks_running--;
+  pthread_cond_broadcast(&test_cond);
+  pthread_mutex_unlock(&test_lock);
+}
+
+/* Waits up to five seconds for `*counter' to become positive. The caller
+ * must hold `test_lock'. */
+static bool wait_positive(int const *counter) {
+  cdtime_t deadline = cdtime() + TIME_T_TO_CDTIME_T(5);
+  while ((*counter <= 0) && (cdtime() < deadline))
+    pthread_cond_timedwait(&test_cond, &test_lock,
+                           &CDTIME_T_TO_TIMESPEC(deadline));
+  return *counter > 0;
+}
+
+static int fast_init(void) { return 0; }
+
+static int fast_read(void) {
+  callback_enter();
+  pthread_mutex_lock(&test_lock);
+  fast_reads++;
+  pthread_mutex_unlock(&test_lock);
+  callback_leave();
+  return 0;
+}
+
+/* Returns only after "fast" has been read, i.e. reads of initialized plugins
+ * do not wait for the other init callbacks. */
+static int slow_init(void) {
+  callback_enter();
+  pthread_mutex_lock(&test_lock);
+  slow_saw_fast_read = wait_positive(&fast_reads);
+  slow_init_done = true;
+  pthread_mutex_unlock(&test_lock);
+  callback_leave();
+  return 0;
+}
+
+static int slow_read(void) {
+  callback_enter();
+  pthread_mutex_lock(&test_lock);
+  if (!slow_init_done)
+    slow_read_early = true;
+  slow_reads++;
+  pthread_mutex_unlock(&test_lock);
+  callback_leave();
+  return 0;
+}
+
+static int exclusive_init(void) {
+  pthread_mutex_lock(&test_lock);
+  int reads = fast_reads;
+  pthread_mutex_unlock(&test_lock);
+
+  for (int i = 0; i < 5; i++) {
+    /* Gives "fast" the chance to be read. */
+    usleep(10000);
+    pthread_mutex_lock(&test_lock);
+    if ((callbacks_running != 0) || (fast_reads != reads))
+      exclusive_alone = false;
+    pthread_mutex_unlock(&test_lock);
+  }
+  return 0;
+}
+
+static int register_plugin(char const *name, int (*init)(void),
+                           int (*read)(void)) {
+  plugin_ctx_t ctx = {
+      .name = (char *)name,
+      .interval = MS_TO_CDTIME_T(10),
+  };
+  plugin_ctx_t old = plugin_set_ctx(ctx);
+  int status = plugin_register_init(name, init);
+  if ((status == 0) && (read != NULL))
+    status = plugin_register_read(name, read);
+  plugin_set_ctx(old);
+  return status;
+}
+
+DEF_TEST(parallel) {
+  CHECK_ZERO(register_plugin("fast", fast_init, fast_read));
+  CHECK_ZERO(register_plugin("slow", slow_init, slow_read));
+  CHECK_ZERO(register_plugin("exclusive", exclusive_init, NULL));
+  CHECK_ZERO(plugin_register_init_after("exclusive", "slow"));
+  CHECK_ZERO(plugin_register_init_exclusive("exclusive"));
+
+  CHECK_ZERO(init_all_callbacks(3, /* read_threads_num = */ 2));
+
+  pthread_mutex_lock(&test_lock);
+  bool slow_read_seen = wait_positive(&slow_reads);
+  pthread_mutex_unlock(&test_lock);
+  stop_read_threads();
+
+  OK(slow_saw_fast_read);
+  OK(slow_read_seen);
+  OK(!slow_read_early);
+  OK(exclusive_alone);
+  OK(init_reads_waiting == NULL);
+
+  destroy_all_callbacks(&list_init);
+  return 0;
+}
+
+int main(void) {
+  plugin_init_ctx();
+  CHECK_ZERO(plugin_register_notification("test", test_notification, NULL));
+
+  RUN_TEST(synchronous);
+  RUN_TEST(coalesce);
+  RUN_TEST(queue_limit);
+  RUN_TEST(log_context);
+  RUN_TEST(parallel);
+
+  plugin_unregister_notification("test");
+  END_TEST;
+}
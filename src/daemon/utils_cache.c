@@ -874,6 +874,23 @@ uc_iter_t *uc_get_iterator(void) {
   return iter;
 } /* uc_iter_t *uc_get_iterator */
 
+uc_iter_t *uc_get_iterator_after(const char *name) {
+  uc_iter_t *iter = calloc(1, sizeof(*iter));
+  if (iter == NULL)
+    return NULL;
+
+  pthread_mutex_lock(&cache_lock);
+
+  iter->iter = c_avl_get_iterator_after(cache_tree, name);
+  if (iter->iter == NULL) {
+    pthread_mutex_unlock(&cache_lock);
+    free(iter);
+    return NULL;
+  }
+
+  return iter;
+} /* uc_iter_t *uc_get_iterator_after */
+
 int uc_iterator_next(uc_iter_t *iter, char **ret_name) {
   int status;
 
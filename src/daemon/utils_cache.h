@@ -82,6 +82,21 @@ typedef struct uc_iter_s uc_iter_t;
  */
 uc_iter_t *uc_get_iterator(void);
 
+/*
+ * NAME
+ *   uc_get_iterator_after
+ *
+ * DESCRIPTION
+ *   Like `uc_get_iterator', but the iteration starts with the first entry
+ *   following `name', which doesn't need to exist anymore. This allows to
+ *   iterate over the cache in chunks without holding the cache lock all the
+ *   time.
+ *
+ * RETURN VALUE
+ *   An iterator object on success or NULL else.
+ */
+uc_iter_t *uc_get_iterator_after(const char *name);
+
 /*
  * NAME
  *   uc_iterator_next
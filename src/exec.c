@@ -37,6 +37,7 @@
 #include "utils/cmds/putnotif.h"
 #include "utils/cmds/putval.h"
 
+#include <fcntl.h>
 #include <grp.h>
 #include <poll.h>
 #include <pwd.h>
@@ -51,6 +52,7 @@ extern char **environ;
 
 #define PL_NORMAL 0x01
 #define PL_NOTIF_ACTION 0x02
+#define PL_WORKER 0x04
 
 #define PL_RUNNING 0x10
 
@@ -64,7 +66,12 @@ extern char **environ;
  * The `pid' and `status' fields are thus unused if the `PL_NOTIF_ACTION' flag
  * is set.
  * The `PL_RUNNING' flag is set in `exec_read' and unset in `exec_read_one'.
+ * Programs with the `PL_WORKER' flag set are kept running between intervals
+ * and have a `worker' structure attached, see below.
  */
+struct exec_worker_s;
+typedef struct exec_worker_s exec_worker_t;
+
 struct program_list_s;
 typedef struct program_list_s program_list_t;
 struct program_list_s {
@@ -75,9 +82,32 @@ struct program_list_s {
   int pid;
   int status;
   int flags;
+  exec_worker_t *worker;
   program_list_t *next;
 };
 
+typedef struct {
+  char data[1200];
+  size_t len;
+} exec_line_buffer_t;
+
+/*
+ * State of a persistent `WorkerExec' program. The file descriptors and the
+ * trigger time are protected by `pl_lock': they are set up by `exec_read' when
+ * the program is (re-)started and torn down by the worker thread when the
+ * program closes STDOUT. The line buffers are only used by the worker thread.
+ */
+struct exec_worker_s {
+  int fd_in;
+  int fd_out;
+  int fd_err;
+  exec_line_buffer_t buffer_out;
+  exec_line_buffer_t buffer_err;
+  /* Time the last "COLLECT" request was sent; zero if no request is pending.
+   */
+  cdtime_t trigger_time;
+};
+
 typedef struct program_list_and_notification_s {
   program_list_t *pl;
   notification_t n;
@@ -94,6 +124,16 @@ const long int MAX_GRBUF_SIZE = 65536;
 static program_list_t *pl_head;
 static pthread_mutex_t pl_lock = PTHREAD_MUTEX_INITIALIZER;
 
+static bool report_latency;
+
+/* A single thread multiplexes the output of all `WorkerExec' programs. It is
+ * woken up through `worker_wakeup' when a worker has been (re-)started or the
+ * plugin is shut down. */
+static pthread_t worker_thread;
+static bool worker_thread_running;
+static bool worker_thread_loop;
+static int worker_wakeup[2] = {-1, -1};
+
 /*
  * Functions
  */
@@ -143,12 +183,27 @@ static int exec_config_exec(oconfig_item_t *ci) /* {{{ */
 
   if (strcasecmp("NotificationExec", ci->key) == 0)
     pl->flags |= PL_NOTIF_ACTION;
+  else if (strcasecmp("WorkerExec", ci->key) == 0)
+    pl->flags |= PL_WORKER;
   else
     pl->flags |= PL_NORMAL;
 
+  if (pl->flags & PL_WORKER) {
+    pl->worker = calloc(1, sizeof(*pl->worker));
+    if (pl->worker == NULL) {
+      ERROR("exec plugin: calloc failed.");
+      sfree(pl);
+      return -1;
+    }
+    pl->worker->fd_in = -1;
+    pl->worker->fd_out = -1;
+    pl->worker->fd_err = -1;
+  }
+
   pl->user = strdup(ci->values[0].value.string);
   if (pl->user == NULL) {
     ERROR("exec plugin: strdup failed.");
+    sfree(pl->worker);
     sfree(pl);
     return -1;
   }
@@ -163,6 +218,7 @@ static int exec_config_exec(oconfig_item_t *ci) /* {{{ */
   if (pl->exec == NULL) {
     ERROR("exec plugin: strdup failed.");
     sfree(pl->user);
+    sfree(pl->worker);
     sfree(pl);
     return -1;
   }
@@ -172,6 +228,7 @@ static int exec_config_exec(oconfig_item_t *ci) /* {{{ */
     ERROR("exec plugin: calloc failed.");
     sfree(pl->exec);
     sfree(pl->user);
+    sfree(pl->worker);
     sfree(pl);
     return -1;
   }
@@ -189,6 +246,7 @@ static int exec_config_exec(oconfig_item_t *ci) /* {{{ */
     sfree(pl->argv);
     sfree(pl->exec);
     sfree(pl->user);
+    sfree(pl->worker);
     sfree(pl);
     return -1;
   }
@@ -222,6 +280,7 @@ static int exec_config_exec(oconfig_item_t *ci) /* {{{ */
     sfree(pl->argv);
     sfree(pl->exec);
     sfree(pl->user);
+    sfree(pl->worker);
     sfree(pl);
     return -1;
   }
@@ -241,8 +300,11 @@ static int exec_config(oconfig_item_t *ci) /* {{{ */
   for (int i = 0; i < ci->children_num; i++) {
     oconfig_item_t *child = ci->children + i;
     if ((strcasecmp("Exec", child->key) == 0) ||
-        (strcasecmp("NotificationExec", child->key) == 0))
+        (strcasecmp("NotificationExec", child->key) == 0) ||
+        (strcasecmp("WorkerExec", child->key) == 0))
       exec_config_exec(child);
+    else if (strcasecmp("ReportLatency", child->key) == 0)
+      cf_util_get_boolean(child, &report_latency);
     else {
       WARNING("exec plugin: Unknown config option `%s'.", child->key);
     }
@@ -798,12 +860,331 @@ static void *exec_notification_one(void *arg) /* {{{ */
   return NULL;
 } /* void *exec_notification_one }}} */
 
+static void exec_worker_dispatch_latency(program_list_t *pl, /* {{{ */
+                                         cdtime_t latency) {
+  value_list_t vl = VALUE_LIST_INIT;
+
+  vl.values = &(value_t){.gauge = CDTIME_T_TO_DOUBLE(latency)};
+  vl.values_len = 1;
+  sstrncpy(vl.plugin, "exec", sizeof(vl.plugin));
+  sstrncpy(vl.plugin_instance, pl->argv[0], sizeof(vl.plugin_instance));
+  sstrncpy(vl.type, "response_time", sizeof(vl.type));
+
+  plugin_dispatch_values(&vl);
+} /* }}} void exec_worker_dispatch_latency */
+
+static void exec_worker_handle_line(program_list_t *pl, char *line, /* {{{ */
+                                    bool is_stderr) {
+  if (is_stderr) {
+    ERROR("exec plugin: %s: %s", pl->argv[0], line);
+    return;
+  }
+
+  /* "DONE" terminates the response to a "COLLECT" request. */
+  if (strcasecmp("DONE", line) != 0) {
+    parse_line(line);
+    return;
+  }
+
+  pthread_mutex_lock(&pl_lock);
+  cdtime_t trigger_time = pl->worker->trigger_time;
+  pl->worker->trigger_time = 0;
+  pthread_mutex_unlock(&pl_lock);
+
+  if (trigger_time == 0) {
+    WARNING("exec plugin: `%s' sent an unsolicited \"DONE\".", pl->exec);
+    return;
+  }
+
+  if (report_latency)
+    exec_worker_dispatch_latency(pl, cdtime() - trigger_time);
+} /* }}} void exec_worker_handle_line */
+
+/* Reads whatever is available on `fd' and handles all complete lines. Returns
+ * zero on EOF, less than zero on error and the number of bytes read
+ * otherwise. */
+static ssize_t exec_worker_read(program_list_t *pl, int fd, /* {{{ */
+                                exec_line_buffer_t *buf, bool is_stderr) {
+  ssize_t len =
+      read(fd, buf->data + buf->len, sizeof(buf->data) - 1 - buf->len);
+  if (len <= 0)
+    return len;
+
+  buf->len += (size_t)len;
+  buf->data[buf->len] = '\0';
+
+  char *line = buf->data;
+  char *pnl;
+  while ((pnl = strchr(line, '\n')) != NULL) {
+    *pnl = '\0';
+    if ((pnl > line) && (pnl[-1] == '\r'))
+      pnl[-1] = '\0';
+
+    exec_worker_handle_line(pl, line, is_stderr);
+
+    line = pnl + 1;
+  }
+
+  buf->len -= (size_t)(line - buf->data);
+  if (buf->len == sizeof(buf->data) - 1) {
+    WARNING("exec plugin: `%s' sent a line longer than %" PRIsz
+            " bytes, ignoring it.",
+            pl->exec, sizeof(buf->data) - 1);
+    buf->len = 0;
+  } else if (buf->len > 0) {
+    memmove(buf->data, line, buf->len);
+  }
+
+  return len;
+} /* }}} ssize_t exec_worker_read */
+
+/* Called with `pl_lock' held. Reaps the worker's process if it has exited.
+ * The SIGCHLD handler may have reaped it already, in which case `waitpid'
+ * fails with ECHILD. */
+static void exec_worker_reap(program_list_t *pl) /* {{{ */
+{
+  int status;
+
+  if (pl->pid <= 0)
+    return;
+
+  pid_t pid = waitpid(pl->pid, &status, WNOHANG);
+  if (pid == 0)
+    return;
+
+  if (pid > 0)
+    pl->status = status;
+
+  DEBUG("exec plugin: Worker %i exited with status %i.", pl->pid, pl->status);
+  pl->pid = 0;
+} /* }}} void exec_worker_reap */
+
+/* Called with `pl_lock' held. */
+static void exec_worker_close(program_list_t *pl) /* {{{ */
+{
+  exec_worker_t *w = pl->worker;
+
+  if (w->fd_in >= 0)
+    close(w->fd_in);
+  if (w->fd_out >= 0)
+    close(w->fd_out);
+  if (w->fd_err >= 0)
+    close(w->fd_err);
+
+  w->fd_in = -1;
+  w->fd_out = -1;
+  w->fd_err = -1;
+  w->buffer_out.len = 0;
+  w->buffer_err.len = 0;
+  w->trigger_time = 0;
+} /* }}} void exec_worker_close */
+
+/* Called with `pl_lock' held. Starts the worker's process and hands its file
+ * descriptors to the worker thread. */
+static int exec_worker_start(program_list_t *pl) /* {{{ */
+{
+  exec_worker_t *w = pl->worker;
+  int fd_in, fd_out, fd_err;
+
+  int pid = fork_child(pl, &fd_in, &fd_out, &fd_err);
+  if (pid < 0)
+    return -1;
+  pl->pid = pid;
+
+  fcntl(fd_in, F_SETFL, fcntl(fd_in, F_GETFL) | O_NONBLOCK);
+  fcntl(fd_out, F_SETFL, fcntl(fd_out, F_GETFL) | O_NONBLOCK);
+  fcntl(fd_err, F_SETFL, fcntl(fd_err, F_GETFL) | O_NONBLOCK);
+
+  w->fd_in = fd_in;
+  w->fd_out = fd_out;
+  w->fd_err = fd_err;
+
+  INFO("exec plugin: Started worker `%s' (pid %i).", pl->exec, pid);
+
+  /* Make the worker thread pick up the new file descriptors. */
+  if (write(worker_wakeup[1], "", 1) < 0 && errno != EAGAIN)
+    ERROR("exec plugin: Waking up the worker thread failed: %s", STRERRNO);
+
+  return 0;
+} /* }}} int exec_worker_start */
+
+/* Sends a "COLLECT" request to the worker, starting it first if it is not
+ * running. If the previous request has not been answered yet, the interval is
+ * skipped. */
+static void exec_worker_trigger(program_list_t *pl) /* {{{ */
+{
+  exec_worker_t *w = pl->worker;
+  static const char request[] = "COLLECT\n";
+
+  pthread_mutex_lock(&pl_lock);
+
+  if (w->fd_in < 0) {
+    exec_worker_reap(pl);
+    if (pl->pid != 0) {
+      /* Closed its pipes, but hasn't exited yet. */
+      pthread_mutex_unlock(&pl_lock);
+      return;
+    }
+
+    if (exec_worker_start(pl) != 0) {
+      pthread_mutex_unlock(&pl_lock);
+      return;
+    }
+  }
+
+  if (w->trigger_time != 0) {
+    pthread_mutex_unlock(&pl_lock);
+    WARNING("exec plugin: `%s' has not answered the previous request yet, "
+            "skipping this interval.",
+            pl->exec);
+    return;
+  }
+
+  ssize_t status = write(w->fd_in, request, sizeof(request) - 1);
+  if (status == (ssize_t)(sizeof(request) - 1))
+    w->trigger_time = cdtime();
+
+  pthread_mutex_unlock(&pl_lock);
+
+  if (status < 0)
+    ERROR("exec plugin: Sending request to `%s' failed: %s", pl->exec,
+          STRERRNO);
+  else if (status != (ssize_t)(sizeof(request) - 1))
+    ERROR("exec plugin: Sending request to `%s' failed: short write.",
+          pl->exec);
+} /* }}} void exec_worker_trigger */
+
+static void *exec_worker_loop(void __attribute__((unused)) * arg) /* {{{ */
+{
+  size_t fds_size = 1;
+  for (program_list_t *pl = pl_head; pl != NULL; pl = pl->next)
+    if (pl->flags & PL_WORKER)
+      fds_size += 2;
+
+  struct pollfd fds[fds_size];
+  program_list_t *fds_pl[fds_size];
+  bool fds_is_stderr[fds_size];
+
+  pthread_mutex_lock(&pl_lock);
+  while (worker_thread_loop) {
+    size_t fds_num = 0;
+
+    fds[fds_num] = (struct pollfd){.fd = worker_wakeup[0], .events = POLLIN};
+    fds_pl[fds_num++] = NULL;
+
+    for (program_list_t *pl = pl_head; pl != NULL; pl = pl->next) {
+      if (((pl->flags & PL_WORKER) == 0) || (pl->worker->fd_out < 0))
+        continue;
+
+      fds[fds_num] =
+          (struct pollfd){.fd = pl->worker->fd_out, .events = POLLIN};
+      fds_is_stderr[fds_num] = false;
+      fds_pl[fds_num++] = pl;
+      if (pl->worker->fd_err >= 0) {
+        fds[fds_num] =
+            (struct pollfd){.fd = pl->worker->fd_err, .events = POLLIN};
+        fds_is_stderr[fds_num] = true;
+        fds_pl[fds_num++] = pl;
+      }
+    }
+    pthread_mutex_unlock(&pl_lock);
+
+    int status = poll(fds, fds_num, -1);
+    if (status < 0) {
+      if (errno != EINTR) {
+        ERROR("exec plugin: poll failed: %s", STRERRNO);
+        sleep(1);
+      }
+      pthread_mutex_lock(&pl_lock);
+      continue;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      char buffer[64];
+      while (read(worker_wakeup[0], buffer, sizeof(buffer)) > 0)
+        /* drain */;
+    }
+
+    /* The file descriptors are only closed by this thread, so they are still
+     * valid, even though the lock is not held. */
+    for (size_t i = 1; i < fds_num; i++) {
+      program_list_t *pl = fds_pl[i];
+      exec_worker_t *w = pl->worker;
+      bool is_stderr = fds_is_stderr[i];
+
+      if (fds[i].revents == 0)
+        continue;
+
+      ssize_t len = exec_worker_read(
+          pl, fds[i].fd, is_stderr ? &w->buffer_err : &w->buffer_out,
+          is_stderr);
+      if ((len < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+        continue;
+      if (len > 0)
+        continue;
+
+      pthread_mutex_lock(&pl_lock);
+      if (is_stderr) {
+        /* The worker closed STDERR only; keep reading its STDOUT. */
+        close(w->fd_err);
+        w->fd_err = -1;
+      } else {
+        if (len < 0)
+          ERROR("exec plugin: Failed to read from `%s': %s", pl->exec,
+                STRERRNO);
+        NOTICE("exec plugin: Worker `%s' has closed STDOUT. It will be "
+               "restarted with the next interval.",
+               pl->exec);
+        exec_worker_close(pl);
+        exec_worker_reap(pl);
+        /* Skip the STDERR entry of this worker, if any. */
+        if ((i + 1 < fds_num) && (fds_pl[i + 1] == pl))
+          i++;
+      }
+      pthread_mutex_unlock(&pl_lock);
+    }
+
+    pthread_mutex_lock(&pl_lock);
+  }
+  pthread_mutex_unlock(&pl_lock);
+
+  return NULL;
+} /* }}} void *exec_worker_loop */
+
 static int exec_init(void) /* {{{ */
 {
   struct sigaction sa = {.sa_handler = sigchld_handler};
 
   sigaction(SIGCHLD, &sa, NULL);
 
+  bool have_workers = false;
+  for (program_list_t *pl = pl_head; pl != NULL; pl = pl->next)
+    if (pl->flags & PL_WORKER)
+      have_workers = true;
+
+  if (have_workers && !worker_thread_running) {
+    if (pipe(worker_wakeup) != 0) {
+      ERROR("exec plugin: pipe failed: %s", STRERRNO);
+      return -1;
+    }
+    fcntl(worker_wakeup[0], F_SETFL,
+          fcntl(worker_wakeup[0], F_GETFL) | O_NONBLOCK);
+    fcntl(worker_wakeup[1], F_SETFL,
+          fcntl(worker_wakeup[1], F_GETFL) | O_NONBLOCK);
+
+    worker_thread_loop = true;
+    int status = plugin_thread_create(&worker_thread, exec_worker_loop, NULL,
+                                      "exec worker");
+    if (status != 0) {
+      ERROR("exec plugin: plugin_thread_create failed.");
+      worker_thread_loop = false;
+      close_pipe(worker_wakeup);
+      worker_wakeup[0] = worker_wakeup[1] = -1;
+      return -1;
+    }
+    worker_thread_running = true;
+  }
+
 #if defined(HAVE_SYS_CAPABILITY_H) && defined(CAP_SETUID) && defined(CAP_SETGID)
   if ((check_capability(CAP_SETUID) != 0) ||
       (check_capability(CAP_SETGID) != 0)) {
@@ -829,6 +1210,11 @@ static int exec_read(void) /* {{{ */
   for (program_list_t *pl = pl_head; pl != NULL; pl = pl->next) {
     pthread_t t;
 
+    if ((pl->flags & PL_WORKER) && worker_thread_running) {
+      exec_worker_trigger(pl);
+      continue;
+    }
+
     /* Only execute `normal' style executables here. */
     if ((pl->flags & PL_NORMAL) == 0)
       continue;
@@ -900,10 +1286,28 @@ static int exec_shutdown(void) /* {{{ */
   program_list_t *pl;
   program_list_t *next;
 
+  if (worker_thread_running) {
+    pthread_mutex_lock(&pl_lock);
+    worker_thread_loop = false;
+    pthread_mutex_unlock(&pl_lock);
+
+    if (write(worker_wakeup[1], "", 1) < 0)
+      ERROR("exec plugin: Waking up the worker thread failed: %s", STRERRNO);
+    pthread_join(worker_thread, NULL);
+    worker_thread_running = false;
+
+    close_pipe(worker_wakeup);
+    worker_wakeup[0] = worker_wakeup[1] = -1;
+  }
+
   pl = pl_head;
   while (pl != NULL) {
     next = pl->next;
 
+    /* Closing STDIN gives workers a chance to exit on their own. */
+    if (pl->worker != NULL)
+      exec_worker_close(pl);
+
     if (pl->pid > 0) {
       kill(pl->pid, SIGTERM);
       INFO("exec plugin: Sent SIGTERM to %hu", (unsigned short int)pl->pid);
@@ -915,6 +1319,7 @@ static int exec_shutdown(void) /* {{{ */
     sfree(pl->argv);
     sfree(pl->exec);
     sfree(pl->user);
+    sfree(pl->worker);
     sfree(pl);
 
     pl = next;
@@ -31,7 +31,6 @@
 
 #include <fstream>
 #include <iostream>
-#include <queue>
 #include <vector>
 
 #include "collectd.grpc.pb.h"
@@ -71,6 +70,11 @@ struct Listener {
 };
 static std::vector<Listener> listeners;
 static grpc::string default_addr("0.0.0.0:50051");
+static int completion_queues = 0;
+
+/* QueryValues copies at most this many value lists, or looks at four times as
+ * many cache entries, before it releases the cache lock and sends them. */
+#define QUERY_BATCH_SIZE 256
 
 /*
  * helper functions
@@ -407,20 +411,31 @@ public:
       return status;
     }
 
-    std::queue<value_list_t> value_lists;
-    status = this->queryValuesRead(&match, &value_lists);
-    if (status.ok()) {
-      status = this->queryValuesWrite(ctx, writer, &value_lists);
-    }
+    /* The cache is read in batches, so that the cache lock is not held while
+     * waiting for a slow client and memory usage does not depend on the
+     * number of matching value lists. */
+    std::vector<QueryValuesResponse> batch;
+    grpc::string last;
+    bool done = false;
+    while (!done) {
+      if (ctx->IsCancelled()) {
+        return grpc::Status::CANCELLED;
+      }
 
-    while (!value_lists.empty()) {
-      auto vl = value_lists.front();
-      value_lists.pop();
-      sfree(vl.values);
-      meta_data_destroy(vl.meta);
+      status = this->queryValuesRead(&match, &last, &batch, &done);
+      if (!status.ok()) {
+        return status;
+      }
+
+      for (auto const &res : batch) {
+        if (!writer->Write(res)) {
+          return grpc::Status::CANCELLED;
+        }
+      }
+      batch.clear();
     }
 
-    return status;
+    return grpc::Status::OK;
   }
 
   grpc::Status PutValues(grpc::ServerContext *ctx,
@@ -429,15 +444,17 @@ public:
     PutValuesRequest req;
 
     while (reader->Read(&req)) {
-      value_list_t vl = {0};
-      auto status = unmarshal_value_list(req.value_list(), &vl);
-      if (!status.ok())
-        return status;
+      if (req.has_value_list()) {
+        auto status = this->putValue(req.value_list());
+        if (!status.ok())
+          return status;
+      }
 
-      if (plugin_dispatch_values(&vl))
-        return grpc::Status(
-            grpc::StatusCode::INTERNAL,
-            grpc::string("failed to enqueue values for writing"));
+      for (auto const &value_list : req.value_lists()) {
+        auto status = this->putValue(value_list);
+        if (!status.ok())
+          return status;
+      }
     }
 
     res->Clear();
@@ -445,10 +462,32 @@ public:
   }
 
 private:
-  grpc::Status queryValuesRead(value_list_t const *match,
-                               std::queue<value_list_t> *value_lists) {
-    uc_iter_t *iter;
-    if ((iter = uc_get_iterator()) == NULL) {
+  grpc::Status putValue(collectd::types::ValueList const &msg) {
+    value_list_t vl = {0};
+    auto status = unmarshal_value_list(msg, &vl);
+    if (!status.ok())
+      return status;
+
+    /* plugin_dispatch_values() copies the value list. */
+    int dispatch_status = plugin_dispatch_values(&vl);
+    sfree(vl.values);
+    meta_data_destroy(vl.meta);
+    if (dispatch_status != 0)
+      return grpc::Status(grpc::StatusCode::INTERNAL,
+                          grpc::string("failed to enqueue values for writing"));
+
+    return grpc::Status::OK;
+  }
+
+  /* Adds the value lists matching `match' which follow the cache entry `last'
+   * to `batch' and updates `last'. Sets `done' when the end of the cache has
+   * been reached. */
+  grpc::Status queryValuesRead(value_list_t const *match, grpc::string *last,
+                               std::vector<QueryValuesResponse> *batch,
+                               bool *done) {
+    uc_iter_t *iter = last->empty() ? uc_get_iterator()
+                                    : uc_get_iterator_after(last->c_str());
+    if (iter == NULL) {
       return grpc::Status(
           grpc::StatusCode::INTERNAL,
           grpc::string("failed to query values: cannot create iterator"));
@@ -456,7 +495,16 @@ private:
 
     grpc::Status status = grpc::Status::OK;
     char *name = NULL;
-    while (uc_iterator_next(iter, &name) == 0) {
+    size_t scanned = 0;
+    while ((batch->size() < QUERY_BATCH_SIZE) &&
+           (scanned < 4 * QUERY_BATCH_SIZE)) {
+      if (uc_iterator_next(iter, &name) != 0) {
+        *done = true;
+        break;
+      }
+      scanned++;
+      last->assign(name);
+
       value_list_t vl;
       if (parse_identifier_vl(name, &vl) != 0) {
         status = grpc::Status(grpc::StatusCode::INTERNAL,
@@ -484,41 +532,24 @@ private:
         break;
       }
       if (uc_iterator_get_meta(iter, &vl.meta) < 0) {
+        sfree(vl.values);
         status =
             grpc::Status(grpc::StatusCode::INTERNAL,
                          grpc::string("failed to retrieve value metadata"));
+        break;
       }
 
-      value_lists->push(vl);
-    } // while (uc_iterator_next(iter, &name) == 0)
+      batch->emplace_back();
+      status = marshal_value_list(&vl, batch->back().mutable_value_list());
+      sfree(vl.values);
+      meta_data_destroy(vl.meta);
+      if (!status.ok())
+        break;
+    } // while (batch->size() < QUERY_BATCH_SIZE)
 
     uc_iterator_destroy(iter);
     return status;
   }
-
-  grpc::Status queryValuesWrite(grpc::ServerContext *ctx,
-                                grpc::ServerWriter<QueryValuesResponse> *writer,
-                                std::queue<value_list_t> *value_lists) {
-    while (!value_lists->empty()) {
-      auto vl = value_lists->front();
-      QueryValuesResponse res;
-      res.Clear();
-
-      auto status = marshal_value_list(&vl, res.mutable_value_list());
-      if (!status.ok()) {
-        return status;
-      }
-
-      if (!writer->Write(res)) {
-        return grpc::Status::CANCELLED;
-      }
-
-      value_lists->pop();
-      sfree(vl.values);
-    }
-
-    return grpc::Status::OK;
-  }
 };
 
 /*
@@ -550,6 +581,13 @@ public:
       }
     }
 
+    /* Incoming calls are accepted by the threads polling the completion
+     * queues, which then handle the call themselves. gRPC starts and stops
+     * polling threads per queue as needed. */
+    if (completion_queues > 0)
+      builder.SetSyncServerOption(
+          grpc::ServerBuilder::SyncServerOption::NUM_CQS, completion_queues);
+
     builder.RegisterService(&collectd_service_);
 
     server_ = builder.BuildAndStart();
@@ -767,6 +805,13 @@ static int c_grpc_config(oconfig_item_t *ci) {
     } else if (!strcasecmp("Server", child->key)) {
       if (c_grpc_config_server(child))
         return -1;
+    } else if (!strcasecmp("CompletionQueues", child->key)) {
+      if (cf_util_get_int(child, &completion_queues))
+        return -1;
+      if (completion_queues < 0) {
+        ERROR("grpc: CompletionQueues must not be negative.");
+        return -1;
+      }
     }
 
     else {
@@ -63,6 +63,34 @@ typedef struct java_plugin_class_s java_plugin_class_t;
 #define CB_TYPE_NOTIFICATION 8
 #define CB_TYPE_MATCH 9
 #define CB_TYPE_TARGET 10
+#define CB_TYPE_WRITE_BATCH 11
+
+/* Copies of value lists to be passed to a CB_TYPE_WRITE_BATCH callback. */
+struct cjni_write_items_s /* {{{ */
+{
+  value_list_t *vl;
+  const data_set_t **ds;
+  size_t num;
+};
+typedef struct cjni_write_items_s cjni_write_items_t;
+/* }}} */
+
+/* Value lists queued for a CB_TYPE_WRITE_BATCH callback. A read callback, the
+ * "timer", passes on partial batches after the timeout. The write callback
+ * and the timer each hold a reference to the callback. */
+struct cjni_write_batch_s /* {{{ */
+{
+  pthread_mutex_t lock;
+  cjni_write_items_t items; /* Allocated when the first value list is queued */
+  size_t size;
+  cdtime_t first;
+  cdtime_t timeout;
+  int refs;
+  char timer_name[512 + sizeof(".batch")];
+};
+typedef struct cjni_write_batch_s cjni_write_batch_t;
+/* }}} */
+
 struct cjni_callback_info_s /* {{{ */
 {
   char *name;
@@ -70,10 +98,50 @@ struct cjni_callback_info_s /* {{{ */
   jclass class;
   jobject object;
   jmethodID method;
+  cjni_write_batch_t *batch;
 };
 typedef struct cjni_callback_info_s cjni_callback_info_t;
 /* }}} */
 
+/* Classes and methods needed to convert value lists. Looking them up for
+ * every value list is expensive, so this is done once after the JVM has been
+ * created. */
+struct cjni_value_list_cache_s /* {{{ */
+{
+  jclass c_valuelist;
+  jmethodID m_constructor;
+  jmethodID m_set_data_set;
+  jmethodID m_set_host;
+  jmethodID m_set_plugin;
+  jmethodID m_set_plugin_instance;
+  jmethodID m_set_type;
+  jmethodID m_set_type_instance;
+  jmethodID m_set_time;
+  jmethodID m_set_interval;
+  jmethodID m_add_value;
+  jmethodID m_get_host;
+  jmethodID m_get_plugin;
+  jmethodID m_get_plugin_instance;
+  jmethodID m_get_type;
+  jmethodID m_get_type_instance;
+  jmethodID m_get_time;
+  jmethodID m_get_interval;
+  jmethodID m_get_values;
+
+  /* java.util.List */
+  jmethodID m_list_to_array;
+
+  /* java.lang.Number, java.lang.Long and java.lang.Double */
+  jmethodID m_double_value;
+  jmethodID m_long_value;
+  jclass c_long;
+  jmethodID m_long_constructor;
+  jclass c_double;
+  jmethodID m_double_constructor;
+};
+typedef struct cjni_value_list_cache_s cjni_value_list_cache_t;
+/* }}} */
+
 /*
  * Global variables
  */
@@ -95,6 +163,14 @@ static pthread_mutex_t java_callbacks_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static oconfig_item_t *config_block;
 
+static cjni_value_list_cache_t vl_cache;
+
+/* Write callbacks with a batch. Pending values are delivered before the JVM is
+ * destroyed. */
+static cjni_callback_info_t **java_batch_callbacks;
+static size_t java_batch_callbacks_num;
+static pthread_mutex_t java_batch_callbacks_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Prototypes
  *
@@ -111,6 +187,14 @@ static int cjni_callback_register(JNIEnv *jvm_env, jobject o_name,
 static int cjni_read(user_data_t *user_data);
 static int cjni_write(const data_set_t *ds, const value_list_t *vl,
                       user_data_t *ud);
+static int cjni_write_batch(const data_set_t *ds, const value_list_t *vl,
+                            user_data_t *ud);
+static int cjni_write_batch_timer(user_data_t *ud);
+static void cjni_write_batch_free(void *arg);
+static void cjni_write_batch_timer_free(void *arg);
+static cjni_write_items_t cjni_write_batch_take(cjni_write_batch_t *b);
+static int cjni_write_batch_deliver(JNIEnv *jvm_env, cjni_callback_info_t *cbi,
+                                    cjni_write_items_t *items);
 static int cjni_flush(cdtime_t timeout, const char *identifier,
                       user_data_t *ud);
 static void cjni_log(int severity, const char *message, user_data_t *ud);
@@ -127,10 +211,10 @@ static int cjni_match_target_invoke(const data_set_t *ds, value_list_t *vl,
 /*
  * C to Java conversion functions
  */
-static int ctoj_string(JNIEnv *jvm_env, /* {{{ */
-                       const char *string, jclass class_ptr, jobject object_ptr,
-                       const char *method_name) {
-  jmethodID m_set;
+/* Call a `void setFoo (String s)' method given its method ID. */
+static int ctoj_string_method(JNIEnv *jvm_env, /* {{{ */
+                              const char *string, jobject object_ptr,
+                              jmethodID m_set) {
   jstring o_string;
 
   /* Create a java.lang.String */
@@ -140,23 +224,30 @@ static int ctoj_string(JNIEnv *jvm_env, /* {{{ */
     return -1;
   }
 
+  /* Call the method. */
+  (*jvm_env)->CallVoidMethod(jvm_env, object_ptr, m_set, o_string);
+
+  /* Decrease reference counter on the java.lang.String object. */
+  (*jvm_env)->DeleteLocalRef(jvm_env, o_string);
+
+  return 0;
+} /* }}} int ctoj_string_method */
+
+static int ctoj_string(JNIEnv *jvm_env, /* {{{ */
+                       const char *string, jclass class_ptr, jobject object_ptr,
+                       const char *method_name) {
+  jmethodID m_set;
+
   /* Search for the `void setFoo (String s)' method. */
   m_set = (*jvm_env)->GetMethodID(jvm_env, class_ptr, method_name,
                                   "(Ljava/lang/String;)V");
   if (m_set == NULL) {
     ERROR("java plugin: ctoj_string: Cannot find method `void %s (String)'.",
           method_name);
-    (*jvm_env)->DeleteLocalRef(jvm_env, o_string);
     return -1;
   }
 
-  /* Call the method. */
-  (*jvm_env)->CallVoidMethod(jvm_env, object_ptr, m_set, o_string);
-
-  /* Decrease reference counter on the java.lang.String object. */
-  (*jvm_env)->DeleteLocalRef(jvm_env, o_string);
-
-  return 0;
+  return ctoj_string_method(jvm_env, string, object_ptr, m_set);
 } /* }}} int ctoj_string */
 
 static jstring ctoj_output_string(JNIEnv *jvm_env, /* {{{ */
@@ -230,51 +321,15 @@ static int ctoj_double(JNIEnv *jvm_env, /* {{{ */
 /* Convert a jlong to a java.lang.Number */
 static jobject ctoj_jlong_to_number(JNIEnv *jvm_env, jlong value) /* {{{ */
 {
-  jclass c_long;
-  jmethodID m_long_constructor;
-
-  /* Look up the java.lang.Long class */
-  c_long = (*jvm_env)->FindClass(jvm_env, "java/lang/Long");
-  if (c_long == NULL) {
-    ERROR("java plugin: ctoj_jlong_to_number: Looking up the "
-          "java.lang.Long class failed.");
-    return NULL;
-  }
-
-  m_long_constructor =
-      (*jvm_env)->GetMethodID(jvm_env, c_long, "<init>", "(J)V");
-  if (m_long_constructor == NULL) {
-    ERROR("java plugin: ctoj_jlong_to_number: Looking up the "
-          "`Long (long)' constructor failed.");
-    return NULL;
-  }
-
-  return (*jvm_env)->NewObject(jvm_env, c_long, m_long_constructor, value);
+  return (*jvm_env)->NewObject(jvm_env, vl_cache.c_long,
+                               vl_cache.m_long_constructor, value);
 } /* }}} jobject ctoj_jlong_to_number */
 
 /* Convert a jdouble to a java.lang.Number */
 static jobject ctoj_jdouble_to_number(JNIEnv *jvm_env, jdouble value) /* {{{ */
 {
-  jclass c_double;
-  jmethodID m_double_constructor;
-
-  /* Look up the java.lang.Long class */
-  c_double = (*jvm_env)->FindClass(jvm_env, "java/lang/Double");
-  if (c_double == NULL) {
-    ERROR("java plugin: ctoj_jdouble_to_number: Looking up the "
-          "java.lang.Double class failed.");
-    return NULL;
-  }
-
-  m_double_constructor =
-      (*jvm_env)->GetMethodID(jvm_env, c_double, "<init>", "(D)V");
-  if (m_double_constructor == NULL) {
-    ERROR("java plugin: ctoj_jdouble_to_number: Looking up the "
-          "`Double (double)' constructor failed.");
-    return NULL;
-  }
-
-  return (*jvm_env)->NewObject(jvm_env, c_double, m_double_constructor, value);
+  return (*jvm_env)->NewObject(jvm_env, vl_cache.c_double,
+                               vl_cache.m_double_constructor, value);
 } /* }}} jobject ctoj_jdouble_to_number */
 
 /* Convert a value_t to a java.lang.Number */
@@ -625,157 +680,78 @@ static jobject ctoj_data_set(JNIEnv *jvm_env, const data_set_t *ds) /* {{{ */
   return o_dataset;
 } /* }}} jobject ctoj_data_set */
 
-static int ctoj_value_list_add_value(JNIEnv *jvm_env, /* {{{ */
-                                     value_t value, int ds_type,
-                                     jclass class_ptr, jobject object_ptr) {
-  jmethodID m_addvalue;
-  jobject o_number;
-
-  m_addvalue = (*jvm_env)->GetMethodID(jvm_env, class_ptr, "addValue",
-                                       "(Ljava/lang/Number;)V");
-  if (m_addvalue == NULL) {
-    ERROR("java plugin: ctoj_value_list_add_value: "
-          "Cannot find method `void addValue (Number)'.");
-    return -1;
-  }
-
-  o_number = ctoj_value_to_number(jvm_env, value, ds_type);
-  if (o_number == NULL) {
-    ERROR("java plugin: ctoj_value_list_add_value: "
-          "ctoj_value_to_number failed.");
-    return -1;
-  }
-
-  (*jvm_env)->CallVoidMethod(jvm_env, object_ptr, m_addvalue, o_number);
-
-  (*jvm_env)->DeleteLocalRef(jvm_env, o_number);
-
-  return 0;
-} /* }}} int ctoj_value_list_add_value */
-
-static int ctoj_value_list_add_data_set(JNIEnv *jvm_env, /* {{{ */
-                                        jclass c_valuelist, jobject o_valuelist,
-                                        const data_set_t *ds) {
-  jmethodID m_setdataset;
-  jobject o_dataset;
-
-  /* Look for the `void setDataSource (List<DataSource> ds)' method. */
-  m_setdataset = (*jvm_env)->GetMethodID(jvm_env, c_valuelist, "setDataSet",
-                                         "(Lorg/collectd/api/DataSet;)V");
-  if (m_setdataset == NULL) {
-    ERROR("java plugin: ctoj_value_list_add_data_set: "
-          "Cannot find the `void setDataSet (DataSet)' method.");
-    return -1;
-  }
-
-  /* Create a DataSet object. */
-  o_dataset = ctoj_data_set(jvm_env, ds);
-  if (o_dataset == NULL) {
-    ERROR("java plugin: ctoj_value_list_add_data_set: "
-          "ctoj_data_set (%s) failed.",
-          ds->type);
-    return -1;
-  }
-
-  /* Actually call the method. */
-  (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, m_setdataset, o_dataset);
-
-  /* Decrease reference counter on the List<DataSource> object. */
-  (*jvm_env)->DeleteLocalRef(jvm_env, o_dataset);
-
-  return 0;
-} /* }}} int ctoj_value_list_add_data_set */
-
-/* Convert a value_list_t (and data_set_t) to a org/collectd/api/ValueList */
+/* Convert a value_list_t (and data_set_t) to a org/collectd/api/ValueList. If
+ * `o_dataset' is NULL, a new DataSet object is created from `ds'. */
 static jobject ctoj_value_list(JNIEnv *jvm_env, /* {{{ */
-                               const data_set_t *ds, const value_list_t *vl) {
-  jclass c_valuelist;
-  jmethodID m_valuelist_constructor;
+                               const data_set_t *ds, const value_list_t *vl,
+                               jobject o_dataset) {
+  cjni_value_list_cache_t *c = &vl_cache;
   jobject o_valuelist;
   int status;
 
-  /* First, create a new ValueList instance..
-   * Look up the class.. */
-  c_valuelist = (*jvm_env)->FindClass(jvm_env, "org/collectd/api/ValueList");
-  if (c_valuelist == NULL) {
-    ERROR("java plugin: ctoj_value_list: "
-          "FindClass (org/collectd/api/ValueList) failed.");
-    return NULL;
-  }
-
-  /* Lookup the `ValueList ()' constructor. */
-  m_valuelist_constructor =
-      (*jvm_env)->GetMethodID(jvm_env, c_valuelist, "<init>", "()V");
-  if (m_valuelist_constructor == NULL) {
-    ERROR("java plugin: ctoj_value_list: Cannot find the "
-          "`ValueList ()' constructor.");
-    return NULL;
-  }
-
-  /* Create a new instance. */
+  /* First, create a new ValueList instance.. */
   o_valuelist =
-      (*jvm_env)->NewObject(jvm_env, c_valuelist, m_valuelist_constructor);
+      (*jvm_env)->NewObject(jvm_env, c->c_valuelist, c->m_constructor);
   if (o_valuelist == NULL) {
     ERROR("java plugin: ctoj_value_list: Creating a new ValueList instance "
           "failed.");
     return NULL;
   }
 
-  status = ctoj_value_list_add_data_set(jvm_env, c_valuelist, o_valuelist, ds);
-  if (status != 0) {
-    ERROR("java plugin: ctoj_value_list: "
-          "ctoj_value_list_add_data_set failed.");
-    (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);
-    return NULL;
+  if (o_dataset != NULL) {
+    (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, c->m_set_data_set,
+                               o_dataset);
+  } else {
+    o_dataset = ctoj_data_set(jvm_env, ds);
+    if (o_dataset == NULL) {
+      ERROR("java plugin: ctoj_value_list: ctoj_data_set (%s) failed.",
+            ds->type);
+      (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);
+      return NULL;
+    }
+    (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, c->m_set_data_set,
+                               o_dataset);
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_dataset);
   }
 
 /* Set the strings.. */
-#define SET_STRING(str, method_name)                                           \
+#define SET_STRING(str, method)                                                \
   do {                                                                         \
-    status = ctoj_string(jvm_env, str, c_valuelist, o_valuelist, method_name); \
+    status = ctoj_string_method(jvm_env, str, o_valuelist, c->method);         \
     if (status != 0) {                                                         \
       ERROR("java plugin: ctoj_value_list: ctoj_string (%s) failed.",          \
-            method_name);                                                      \
+            #method);                                                          \
       (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);                        \
       return NULL;                                                             \
     }                                                                          \
   } while (0)
 
-  SET_STRING(vl->host, "setHost");
-  SET_STRING(vl->plugin, "setPlugin");
-  SET_STRING(vl->plugin_instance, "setPluginInstance");
-  SET_STRING(vl->type, "setType");
-  SET_STRING(vl->type_instance, "setTypeInstance");
+  SET_STRING(vl->host, m_set_host);
+  SET_STRING(vl->plugin, m_set_plugin);
+  SET_STRING(vl->plugin_instance, m_set_plugin_instance);
+  SET_STRING(vl->type, m_set_type);
+  SET_STRING(vl->type_instance, m_set_type_instance);
 
 #undef SET_STRING
 
-  /* Set the `time' member. Java stores time in milliseconds. */
-  status = ctoj_long(jvm_env, (jlong)CDTIME_T_TO_MS(vl->time), c_valuelist,
-                     o_valuelist, "setTime");
-  if (status != 0) {
-    ERROR("java plugin: ctoj_value_list: ctoj_long (setTime) failed.");
-    (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);
-    return NULL;
-  }
-
-  /* Set the `interval' member.. */
-  status = ctoj_long(jvm_env, (jlong)CDTIME_T_TO_MS(vl->interval), c_valuelist,
-                     o_valuelist, "setInterval");
-  if (status != 0) {
-    ERROR("java plugin: ctoj_value_list: ctoj_long (setInterval) failed.");
-    (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);
-    return NULL;
-  }
+  /* Set the `time' and `interval' members. Java stores time in
+   * milliseconds. */
+  (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, c->m_set_time,
+                             (jlong)CDTIME_T_TO_MS(vl->time));
+  (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, c->m_set_interval,
+                             (jlong)CDTIME_T_TO_MS(vl->interval));
 
   for (size_t i = 0; i < vl->values_len; i++) {
-    status = ctoj_value_list_add_value(jvm_env, vl->values[i], ds->ds[i].type,
-                                       c_valuelist, o_valuelist);
-    if (status != 0) {
-      ERROR("java plugin: ctoj_value_list: "
-            "ctoj_value_list_add_value failed.");
+    jobject o_number = ctoj_value_to_number(jvm_env, vl->values[i],
+                                            ds->ds[i].type);
+    if (o_number == NULL) {
+      ERROR("java plugin: ctoj_value_list: ctoj_value_to_number failed.");
       (*jvm_env)->DeleteLocalRef(jvm_env, o_valuelist);
       return NULL;
     }
+
+    (*jvm_env)->CallVoidMethod(jvm_env, o_valuelist, c->m_add_value, o_number);
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_number);
   }
 
   return o_valuelist;
@@ -863,27 +839,16 @@ static jobject ctoj_notification(JNIEnv *jvm_env, /* {{{ */
 /*
  * Java to C conversion functions
  */
-/* Call a `String <method> ()' method. */
-static int jtoc_string(JNIEnv *jvm_env, /* {{{ */
-                       char *buffer, size_t buffer_size, int empty_okay,
-                       jclass class_ptr, jobject object_ptr,
-                       const char *method_name) {
-  jmethodID method_id;
+/* Call a `String <method> ()' method given its method ID. */
+static int jtoc_string_method(JNIEnv *jvm_env, /* {{{ */
+                              char *buffer, size_t buffer_size, int empty_okay,
+                              jobject object_ptr, jmethodID method_id) {
   jobject string_obj;
   const char *c_str;
 
-  method_id = (*jvm_env)->GetMethodID(jvm_env, class_ptr, method_name,
-                                      "()Ljava/lang/String;");
-  if (method_id == NULL) {
-    ERROR("java plugin: jtoc_string: Cannot find method `String %s ()'.",
-          method_name);
-    return -1;
-  }
-
   string_obj = (*jvm_env)->CallObjectMethod(jvm_env, object_ptr, method_id);
   if ((string_obj == NULL) && (empty_okay == 0)) {
-    ERROR("java plugin: jtoc_string: CallObjectMethod (%s) failed.",
-          method_name);
+    ERROR("java plugin: jtoc_string: CallObjectMethod failed.");
     return -1;
   } else if ((string_obj == NULL) && (empty_okay != 0)) {
     memset(buffer, 0, buffer_size);
@@ -903,6 +868,25 @@ static int jtoc_string(JNIEnv *jvm_env, /* {{{ */
   (*jvm_env)->DeleteLocalRef(jvm_env, string_obj);
 
   return 0;
+} /* }}} int jtoc_string_method */
+
+/* Call a `String <method> ()' method. */
+static int jtoc_string(JNIEnv *jvm_env, /* {{{ */
+                       char *buffer, size_t buffer_size, int empty_okay,
+                       jclass class_ptr, jobject object_ptr,
+                       const char *method_name) {
+  jmethodID method_id;
+
+  method_id = (*jvm_env)->GetMethodID(jvm_env, class_ptr, method_name,
+                                      "()Ljava/lang/String;");
+  if (method_id == NULL) {
+    ERROR("java plugin: jtoc_string: Cannot find method `String %s ()'.",
+          method_name);
+    return -1;
+  }
+
+  return jtoc_string_method(jvm_env, buffer, buffer_size, empty_okay,
+                            object_ptr, method_id);
 } /* }}} int jtoc_string */
 
 /* Call an `int <method> ()' method. */
@@ -941,51 +925,16 @@ static int jtoc_long(JNIEnv *jvm_env, /* {{{ */
   return 0;
 } /* }}} int jtoc_long */
 
-/* Call a `double <method> ()' method. */
-static int jtoc_double(JNIEnv *jvm_env, /* {{{ */
-                       jdouble *ret_value, jclass class_ptr, jobject object_ptr,
-                       const char *method_name) {
-  jmethodID method_id;
-
-  method_id = (*jvm_env)->GetMethodID(jvm_env, class_ptr, method_name, "()D");
-  if (method_id == NULL) {
-    ERROR("java plugin: jtoc_double: Cannot find method `double %s ()'.",
-          method_name);
-    return -1;
-  }
-
-  *ret_value = (*jvm_env)->CallDoubleMethod(jvm_env, object_ptr, method_id);
-
-  return 0;
-} /* }}} int jtoc_double */
-
-static int jtoc_value(JNIEnv *jvm_env, /* {{{ */
-                      value_t *ret_value, int ds_type, jobject object_ptr) {
-  jclass class_ptr;
-  int status;
-
-  class_ptr = (*jvm_env)->GetObjectClass(jvm_env, object_ptr);
-
+/* Convert a java.lang.Number to a value_t. */
+static void jtoc_value(JNIEnv *jvm_env, /* {{{ */
+                       value_t *ret_value, int ds_type, jobject object_ptr) {
   if (ds_type == DS_TYPE_GAUGE) {
-    jdouble tmp_double;
-
-    status =
-        jtoc_double(jvm_env, &tmp_double, class_ptr, object_ptr, "doubleValue");
-    if (status != 0) {
-      ERROR("java plugin: jtoc_value: "
-            "jtoc_double failed.");
-      return -1;
-    }
+    jdouble tmp_double = (*jvm_env)->CallDoubleMethod(jvm_env, object_ptr,
+                                                      vl_cache.m_double_value);
     (*ret_value).gauge = (gauge_t)tmp_double;
   } else {
-    jlong tmp_long;
-
-    status = jtoc_long(jvm_env, &tmp_long, class_ptr, object_ptr, "longValue");
-    if (status != 0) {
-      ERROR("java plugin: jtoc_value: "
-            "jtoc_long failed.");
-      return -1;
-    }
+    jlong tmp_long = (*jvm_env)->CallLongMethod(jvm_env, object_ptr,
+                                                vl_cache.m_long_value);
 
     if (ds_type == DS_TYPE_DERIVE)
       (*ret_value).derive = (derive_t)tmp_long;
@@ -994,17 +943,13 @@ static int jtoc_value(JNIEnv *jvm_env, /* {{{ */
     else
       (*ret_value).counter = (counter_t)tmp_long;
   }
-
-  return 0;
-} /* }}} int jtoc_value */
+} /* }}} void jtoc_value */
 
 /* Read a List<Number>, convert it to `value_t' and add it to the given
  * `value_list_t'. */
 static int jtoc_values_array(JNIEnv *jvm_env, /* {{{ */
                              const data_set_t *ds, value_list_t *vl,
-                             jclass class_ptr, jobject object_ptr) {
-  jmethodID m_getvalues;
-  jmethodID m_toarray;
+                             jobject object_ptr) {
   jobject o_list;
   jobjectArray o_number_array;
 
@@ -1025,15 +970,8 @@ static int jtoc_values_array(JNIEnv *jvm_env, /* {{{ */
   return status;
 
   /* Call: List<Number> ValueList.getValues () */
-  m_getvalues = (*jvm_env)->GetMethodID(jvm_env, class_ptr, "getValues",
-                                        "()Ljava/util/List;");
-  if (m_getvalues == NULL) {
-    ERROR("java plugin: jtoc_values_array: "
-          "Cannot find method `List getValues ()'.");
-    BAIL_OUT(-1);
-  }
-
-  o_list = (*jvm_env)->CallObjectMethod(jvm_env, object_ptr, m_getvalues);
+  o_list = (*jvm_env)->CallObjectMethod(jvm_env, object_ptr,
+                                        vl_cache.m_get_values);
   if (o_list == NULL) {
     ERROR("java plugin: jtoc_values_array: "
           "CallObjectMethod (getValues) failed.");
@@ -1041,19 +979,20 @@ static int jtoc_values_array(JNIEnv *jvm_env, /* {{{ */
   }
 
   /* Call: Number[] List.toArray () */
-  m_toarray = (*jvm_env)->GetMethodID(
-      jvm_env, (*jvm_env)->GetObjectClass(jvm_env, o_list), "toArray",
-      "()[Ljava/lang/Object;");
-  if (m_toarray == NULL) {
+  o_number_array = (*jvm_env)->CallObjectMethod(jvm_env, o_list,
+                                                vl_cache.m_list_to_array);
+  if (o_number_array == NULL) {
     ERROR("java plugin: jtoc_values_array: "
-          "Cannot find method `Object[] toArray ()'.");
+          "CallObjectMethod (toArray) failed.");
     BAIL_OUT(-1);
   }
 
-  o_number_array = (*jvm_env)->CallObjectMethod(jvm_env, o_list, m_toarray);
-  if (o_number_array == NULL) {
-    ERROR("java plugin: jtoc_values_array: "
-          "CallObjectMethod (toArray) failed.");
+  if ((size_t)(*jvm_env)->GetArrayLength(jvm_env, o_number_array) <
+      values_num) {
+    ERROR("java plugin: jtoc_values_array: Data-set `%s' has %" PRIsz
+          " data sources, but the value list has %i values.",
+          ds->type, values_num,
+          (int)(*jvm_env)->GetArrayLength(jvm_env, o_number_array));
     BAIL_OUT(-1);
   }
 
@@ -1065,24 +1004,18 @@ static int jtoc_values_array(JNIEnv *jvm_env, /* {{{ */
 
   for (size_t i = 0; i < values_num; i++) {
     jobject o_number;
-    int status;
 
     o_number =
         (*jvm_env)->GetObjectArrayElement(jvm_env, o_number_array, (jsize)i);
     if (o_number == NULL) {
       ERROR("java plugin: jtoc_values_array: "
-            "GetObjectArrayElement (%zu) failed.",
+            "GetObjectArrayElement (%" PRIsz ") failed.",
             i);
       BAIL_OUT(-1);
     }
 
-    status = jtoc_value(jvm_env, values + i, ds->ds[i].type, o_number);
-    if (status != 0) {
-      ERROR("java plugin: jtoc_values_array: "
-            "jtoc_value (%zu) failed.",
-            i);
-      BAIL_OUT(-1);
-    }
+    jtoc_value(jvm_env, values + i, ds->ds[i].type, o_number);
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_number);
   } /* for (i = 0; i < values_num; i++) */
 
   vl->values = values;
@@ -1097,29 +1030,23 @@ static int jtoc_values_array(JNIEnv *jvm_env, /* {{{ */
 /* Convert a org/collectd/api/ValueList to a value_list_t. */
 static int jtoc_value_list(JNIEnv *jvm_env, value_list_t *vl, /* {{{ */
                            jobject object_ptr) {
-  jclass class_ptr;
+  cjni_value_list_cache_t *c = &vl_cache;
   int status;
-  jlong tmp_long;
   const data_set_t *ds;
 
-  class_ptr = (*jvm_env)->GetObjectClass(jvm_env, object_ptr);
-  if (class_ptr == NULL) {
-    ERROR("java plugin: jtoc_value_list: GetObjectClass failed.");
-    return -1;
-  }
-
 /* eo == empty okay */
 #define SET_STRING(buffer, method, eo)                                         \
   do {                                                                         \
-    status = jtoc_string(jvm_env, buffer, sizeof(buffer), eo, class_ptr,       \
-                         object_ptr, method);                                  \
+    status = jtoc_string_method(jvm_env, buffer, sizeof(buffer), eo,           \
+                                object_ptr, c->method);                        \
     if (status != 0) {                                                         \
-      ERROR("java plugin: jtoc_value_list: jtoc_string (%s) failed.", method); \
+      ERROR("java plugin: jtoc_value_list: jtoc_string (%s) failed.",          \
+            #method);                                                          \
       return -1;                                                               \
     }                                                                          \
   } while (0)
 
-  SET_STRING(vl->type, "getType", /* empty = */ 0);
+  SET_STRING(vl->type, m_get_type, /* empty = */ 0);
 
   ds = plugin_get_ds(vl->type);
   if (ds == NULL) {
@@ -1129,29 +1056,20 @@ static int jtoc_value_list(JNIEnv *jvm_env, value_list_t *vl, /* {{{ */
     return -1;
   }
 
-  SET_STRING(vl->host, "getHost", /* empty = */ 0);
-  SET_STRING(vl->plugin, "getPlugin", /* empty = */ 0);
-  SET_STRING(vl->plugin_instance, "getPluginInstance", /* empty = */ 1);
-  SET_STRING(vl->type_instance, "getTypeInstance", /* empty = */ 1);
+  SET_STRING(vl->host, m_get_host, /* empty = */ 0);
+  SET_STRING(vl->plugin, m_get_plugin, /* empty = */ 0);
+  SET_STRING(vl->plugin_instance, m_get_plugin_instance, /* empty = */ 1);
+  SET_STRING(vl->type_instance, m_get_type_instance, /* empty = */ 1);
 
 #undef SET_STRING
 
-  status = jtoc_long(jvm_env, &tmp_long, class_ptr, object_ptr, "getTime");
-  if (status != 0) {
-    ERROR("java plugin: jtoc_value_list: jtoc_long (getTime) failed.");
-    return -1;
-  }
   /* Java measures time in milliseconds. */
-  vl->time = MS_TO_CDTIME_T(tmp_long);
-
-  status = jtoc_long(jvm_env, &tmp_long, class_ptr, object_ptr, "getInterval");
-  if (status != 0) {
-    ERROR("java plugin: jtoc_value_list: jtoc_long (getInterval) failed.");
-    return -1;
-  }
-  vl->interval = MS_TO_CDTIME_T(tmp_long);
+  vl->time = MS_TO_CDTIME_T(
+      (*jvm_env)->CallLongMethod(jvm_env, object_ptr, c->m_get_time));
+  vl->interval = MS_TO_CDTIME_T(
+      (*jvm_env)->CallLongMethod(jvm_env, object_ptr, c->m_get_interval));
 
-  status = jtoc_values_array(jvm_env, ds, vl, class_ptr, object_ptr);
+  status = jtoc_values_array(jvm_env, ds, vl, object_ptr);
   if (status != 0) {
     ERROR("java plugin: jtoc_value_list: jtoc_values_array failed.");
     return -1;
@@ -1235,6 +1153,46 @@ static jint JNICALL cjni_api_dispatch_values(JNIEnv *jvm_env, /* {{{ */
   return status;
 } /* }}} jint cjni_api_dispatch_values */
 
+static jint JNICALL cjni_api_dispatch_values_batch(JNIEnv *jvm_env, /* {{{ */
+                                                   jobject this,
+                                                   jobjectArray o_array) {
+  jsize array_len;
+  jint failed = 0;
+
+  if (o_array == NULL)
+    return -1;
+
+  array_len = (*jvm_env)->GetArrayLength(jvm_env, o_array);
+  for (jsize i = 0; i < array_len; i++) {
+    value_list_t vl = VALUE_LIST_INIT;
+    jobject o_vl;
+    int status;
+
+    o_vl = (*jvm_env)->GetObjectArrayElement(jvm_env, o_array, i);
+    if (o_vl == NULL) {
+      failed++;
+      continue;
+    }
+
+    status = jtoc_value_list(jvm_env, &vl, o_vl);
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_vl);
+    if (status != 0) {
+      ERROR("java plugin: cjni_api_dispatch_values_batch: "
+            "jtoc_value_list (%i) failed.",
+            (int)i);
+      failed++;
+      continue;
+    }
+
+    if (plugin_dispatch_values(&vl) != 0)
+      failed++;
+
+    sfree(vl.values);
+  }
+
+  return failed;
+} /* }}} jint cjni_api_dispatch_values_batch */
+
 static jint JNICALL cjni_api_dispatch_notification(JNIEnv *jvm_env, /* {{{ */
                                                    jobject this,
                                                    jobject o_notification) {
@@ -1337,6 +1295,92 @@ static jint JNICALL cjni_api_register_write(JNIEnv *jvm_env, /* {{{ */
   return 0;
 } /* }}} jint cjni_api_register_write */
 
+static cjni_write_batch_t *cjni_write_batch_create(size_t size, /* {{{ */
+                                                   cdtime_t timeout) {
+  cjni_write_batch_t *b = calloc(1, sizeof(*b));
+  if (b == NULL)
+    return NULL;
+
+  pthread_mutex_init(&b->lock, NULL);
+  b->size = size;
+  b->timeout = timeout;
+
+  return b;
+} /* }}} cjni_write_batch_t *cjni_write_batch_create */
+
+static jint JNICALL cjni_api_register_write_batch(JNIEnv *jvm_env, /* {{{ */
+                                                  jobject this, jobject o_name,
+                                                  jobject o_write,
+                                                  jint batch_size) {
+  cjni_callback_info_t *cbi;
+  cjni_callback_info_t **tmp;
+
+  if (batch_size < 1) {
+    ERROR("java plugin: cjni_api_register_write_batch: "
+          "Invalid batch size: %i",
+          (int)batch_size);
+    return -1;
+  }
+
+  cbi =
+      cjni_callback_info_create(jvm_env, o_name, o_write, CB_TYPE_WRITE_BATCH);
+  if (cbi == NULL)
+    return -1;
+
+  cbi->batch = cjni_write_batch_create((size_t)batch_size,
+                                       plugin_get_interval());
+  if (cbi->batch == NULL) {
+    ERROR("java plugin: cjni_api_register_write_batch: "
+          "cjni_write_batch_create failed.");
+    cjni_callback_info_destroy(cbi);
+    return -1;
+  }
+
+  pthread_mutex_lock(&java_batch_callbacks_lock);
+  tmp = realloc(java_batch_callbacks,
+                (java_batch_callbacks_num + 1) * sizeof(*java_batch_callbacks));
+  if (tmp != NULL) {
+    java_batch_callbacks = tmp;
+    java_batch_callbacks[java_batch_callbacks_num] = cbi;
+    java_batch_callbacks_num++;
+  }
+  pthread_mutex_unlock(&java_batch_callbacks_lock);
+
+  if (tmp == NULL) {
+    ERROR("java plugin: cjni_api_register_write_batch: realloc failed.");
+    cjni_callback_info_destroy(cbi);
+    return -1;
+  }
+
+  DEBUG("java plugin: Registering new batched write callback: %s", cbi->name);
+
+  cbi->batch->refs = 1;
+  snprintf(cbi->batch->timer_name, sizeof(cbi->batch->timer_name), "%s.batch",
+           cbi->name);
+  if (plugin_register_complex_read(
+          /* group = */ NULL, cbi->batch->timer_name, cjni_write_batch_timer,
+          (cbi->batch->timeout > 1) ? cbi->batch->timeout / 2 : 1,
+          &(user_data_t){
+              .data = cbi,
+              .free_func = cjni_write_batch_timer_free,
+          }) == 0)
+    cbi->batch->refs++;
+  else
+    WARNING("java plugin: Registering the timer of %s failed, partial "
+            "batches are only passed on when values are written.",
+            cbi->name);
+
+  plugin_register_write(cbi->name, cjni_write_batch,
+                        &(user_data_t){
+                            .data = cbi,
+                            .free_func = cjni_write_batch_free,
+                        });
+
+  (*jvm_env)->DeleteLocalRef(jvm_env, o_write);
+
+  return 0;
+} /* }}} jint cjni_api_register_write_batch */
+
 static jint JNICALL cjni_api_register_flush(JNIEnv *jvm_env, /* {{{ */
                                             jobject this, jobject o_name,
                                             jobject o_flush) {
@@ -1511,6 +1555,9 @@ static JNINativeMethod jni_api_functions[] = /* {{{ */
         {"dispatchValues", "(Lorg/collectd/api/ValueList;)I",
          cjni_api_dispatch_values},
 
+        {"dispatchValuesBatch", "([Lorg/collectd/api/ValueList;)I",
+         cjni_api_dispatch_values_batch},
+
         {"dispatchNotification", "(Lorg/collectd/api/Notification;)I",
          cjni_api_dispatch_notification},
 
@@ -1533,6 +1580,10 @@ static JNINativeMethod jni_api_functions[] = /* {{{ */
          "(Ljava/lang/String;Lorg/collectd/api/CollectdWriteInterface;)I",
          cjni_api_register_write},
 
+        {"registerWriteBatch",
+         "(Ljava/lang/String;Lorg/collectd/api/CollectdWriteBatchInterface;I)I",
+         cjni_api_register_write_batch},
+
         {"registerFlush",
          "(Ljava/lang/String;Lorg/collectd/api/CollectdFlushInterface;)I",
          cjni_api_register_flush},
@@ -1603,6 +1654,11 @@ cjni_callback_info_create(JNIEnv *jvm_env, /* {{{ */
     method_signature = "(Lorg/collectd/api/ValueList;)I";
     break;
 
+  case CB_TYPE_WRITE_BATCH:
+    method_name = "write";
+    method_signature = "([Lorg/collectd/api/ValueList;)I";
+    break;
+
   case CB_TYPE_FLUSH:
     method_name = "flush";
     method_signature = "(Ljava/lang/Number;Ljava/lang/String;)I";
@@ -1791,6 +1847,114 @@ static void cjni_jvm_env_destroy(void *args) /* {{{ */
   free(cjni_env);
 } /* }}} void cjni_jvm_env_destroy */
 
+/* Look up a class and keep a global reference to it. */
+static jclass cjni_find_class(JNIEnv *jvm_env, const char *name) /* {{{ */
+{
+  jclass c_local;
+  jclass c_global;
+
+  c_local = (*jvm_env)->FindClass(jvm_env, name);
+  if (c_local == NULL) {
+    ERROR("java plugin: cjni_find_class: FindClass (%s) failed.", name);
+    return NULL;
+  }
+
+  c_global = (*jvm_env)->NewGlobalRef(jvm_env, c_local);
+  (*jvm_env)->DeleteLocalRef(jvm_env, c_local);
+  if (c_global == NULL)
+    ERROR("java plugin: cjni_find_class: NewGlobalRef (%s) failed.", name);
+
+  return c_global;
+} /* }}} jclass cjni_find_class */
+
+static void cjni_value_list_cache_free(JNIEnv *jvm_env) /* {{{ */
+{
+  if (vl_cache.c_valuelist != NULL)
+    (*jvm_env)->DeleteGlobalRef(jvm_env, vl_cache.c_valuelist);
+  if (vl_cache.c_long != NULL)
+    (*jvm_env)->DeleteGlobalRef(jvm_env, vl_cache.c_long);
+  if (vl_cache.c_double != NULL)
+    (*jvm_env)->DeleteGlobalRef(jvm_env, vl_cache.c_double);
+
+  memset(&vl_cache, 0, sizeof(vl_cache));
+} /* }}} void cjni_value_list_cache_free */
+
+/* Fill `vl_cache'. */
+static int cjni_value_list_cache_init(JNIEnv *jvm_env) /* {{{ */
+{
+  cjni_value_list_cache_t *c = &vl_cache;
+  jclass c_list;
+  jclass c_number;
+
+  c->c_valuelist = cjni_find_class(jvm_env, "org/collectd/api/ValueList");
+  c->c_long = cjni_find_class(jvm_env, "java/lang/Long");
+  c->c_double = cjni_find_class(jvm_env, "java/lang/Double");
+  if ((c->c_valuelist == NULL) || (c->c_long == NULL) ||
+      (c->c_double == NULL)) {
+    cjni_value_list_cache_free(jvm_env);
+    return -1;
+  }
+
+#define GET_METHOD(member, class, name, signature)                             \
+  do {                                                                         \
+    c->member = (*jvm_env)->GetMethodID(jvm_env, class, name, signature);      \
+    if (c->member == NULL) {                                                   \
+      ERROR("java plugin: cjni_value_list_cache_init: Cannot find method "    \
+            "`%s' with signature `%s'.",                                       \
+            name, signature);                                                  \
+      cjni_value_list_cache_free(jvm_env);                                     \
+      return -1;                                                               \
+    }                                                                          \
+  } while (0)
+
+  GET_METHOD(m_constructor, c->c_valuelist, "<init>", "()V");
+  GET_METHOD(m_set_data_set, c->c_valuelist, "setDataSet",
+             "(Lorg/collectd/api/DataSet;)V");
+  GET_METHOD(m_set_host, c->c_valuelist, "setHost", "(Ljava/lang/String;)V");
+  GET_METHOD(m_set_plugin, c->c_valuelist, "setPlugin",
+             "(Ljava/lang/String;)V");
+  GET_METHOD(m_set_plugin_instance, c->c_valuelist, "setPluginInstance",
+             "(Ljava/lang/String;)V");
+  GET_METHOD(m_set_type, c->c_valuelist, "setType", "(Ljava/lang/String;)V");
+  GET_METHOD(m_set_type_instance, c->c_valuelist, "setTypeInstance",
+             "(Ljava/lang/String;)V");
+  GET_METHOD(m_set_time, c->c_valuelist, "setTime", "(J)V");
+  GET_METHOD(m_set_interval, c->c_valuelist, "setInterval", "(J)V");
+  GET_METHOD(m_add_value, c->c_valuelist, "addValue", "(Ljava/lang/Number;)V");
+  GET_METHOD(m_get_host, c->c_valuelist, "getHost", "()Ljava/lang/String;");
+  GET_METHOD(m_get_plugin, c->c_valuelist, "getPlugin",
+             "()Ljava/lang/String;");
+  GET_METHOD(m_get_plugin_instance, c->c_valuelist, "getPluginInstance",
+             "()Ljava/lang/String;");
+  GET_METHOD(m_get_type, c->c_valuelist, "getType", "()Ljava/lang/String;");
+  GET_METHOD(m_get_type_instance, c->c_valuelist, "getTypeInstance",
+             "()Ljava/lang/String;");
+  GET_METHOD(m_get_time, c->c_valuelist, "getTime", "()J");
+  GET_METHOD(m_get_interval, c->c_valuelist, "getInterval", "()J");
+  GET_METHOD(m_get_values, c->c_valuelist, "getValues", "()Ljava/util/List;");
+  GET_METHOD(m_long_constructor, c->c_long, "<init>", "(J)V");
+  GET_METHOD(m_double_constructor, c->c_double, "<init>", "(D)V");
+
+  /* Method IDs stay valid as long as the class is loaded, which is always
+   * the case for java.util.List and java.lang.Number. */
+  c_list = (*jvm_env)->FindClass(jvm_env, "java/util/List");
+  c_number = (*jvm_env)->FindClass(jvm_env, "java/lang/Number");
+  if ((c_list == NULL) || (c_number == NULL)) {
+    ERROR("java plugin: cjni_value_list_cache_init: FindClass failed.");
+    cjni_value_list_cache_free(jvm_env);
+    return -1;
+  }
+  GET_METHOD(m_list_to_array, c_list, "toArray", "()[Ljava/lang/Object;");
+  GET_METHOD(m_double_value, c_number, "doubleValue", "()D");
+  GET_METHOD(m_long_value, c_number, "longValue", "()J");
+
+#undef GET_METHOD
+
+  (*jvm_env)->DeleteLocalRef(jvm_env, c_list);
+  (*jvm_env)->DeleteLocalRef(jvm_env, c_number);
+  return 0;
+} /* }}} int cjni_value_list_cache_init */
+
 /* Register ``native'' functions with the JVM. Native functions are C-functions
  * that can be called by Java code. */
 static int cjni_init_native(JNIEnv *jvm_env) /* {{{ */
@@ -1813,6 +1977,12 @@ static int cjni_init_native(JNIEnv *jvm_env) /* {{{ */
     return -1;
   }
 
+  status = cjni_value_list_cache_init(jvm_env);
+  if (status != 0) {
+    ERROR("cjni_init_native: cjni_value_list_cache_init failed.");
+    return -1;
+  }
+
   return 0;
 } /* }}} int cjni_init_native */
 
@@ -2246,6 +2416,47 @@ static int cjni_config_callback(oconfig_item_t *ci) /* {{{ */
   return 0;
 } /* }}} int cjni_config_callback */
 
+/* Free value lists taken from a batch. */
+static void cjni_write_items_free(cjni_write_items_t *items) /* {{{ */
+{
+  for (size_t i = 0; i < items->num; i++) {
+    meta_data_destroy(items->vl[i].meta);
+    sfree(items->vl[i].values);
+  }
+  sfree(items->vl);
+  sfree(items->ds);
+  items->num = 0;
+} /* }}} void cjni_write_items_free */
+
+static void cjni_write_batch_destroy(cjni_write_batch_t *b) /* {{{ */
+{
+  if (b == NULL)
+    return;
+
+  cjni_write_items_free(&b->items);
+  pthread_mutex_destroy(&b->lock);
+  free(b);
+} /* }}} void cjni_write_batch_destroy */
+
+/* Remove `cbi' from `java_batch_callbacks'. */
+static void cjni_batch_callback_remove(cjni_callback_info_t *cbi) /* {{{ */
+{
+  pthread_mutex_lock(&java_batch_callbacks_lock);
+  for (size_t i = 0; i < java_batch_callbacks_num; i++) {
+    if (java_batch_callbacks[i] != cbi)
+      continue;
+
+    memmove(java_batch_callbacks + i, java_batch_callbacks + i + 1,
+            (java_batch_callbacks_num - i - 1) *
+                sizeof(*java_batch_callbacks));
+    java_batch_callbacks_num--;
+    break;
+  }
+  if (java_batch_callbacks_num == 0)
+    sfree(java_batch_callbacks);
+  pthread_mutex_unlock(&java_batch_callbacks_lock);
+} /* }}} void cjni_batch_callback_remove */
+
 /* Free the data contained in the `user_data_t' pointer passed to `cjni_read'
  * and `cjni_write'. In particular, delete the global reference to the Java
  * object. */
@@ -2258,8 +2469,13 @@ static void cjni_callback_info_destroy(void *arg) /* {{{ */
 
   cbi = (cjni_callback_info_t *)arg;
 
+  if ((cbi != NULL) && (cbi->batch != NULL))
+    cjni_batch_callback_remove(cbi);
+
   /* This condition can occur when shutting down. */
   if (jvm == NULL) {
+    if (cbi != NULL)
+      cjni_write_batch_destroy(cbi->batch);
     sfree(cbi);
     return;
   }
@@ -2274,6 +2490,16 @@ static void cjni_callback_info_destroy(void *arg) /* {{{ */
     return;
   }
 
+  if (cbi->batch != NULL) {
+    /* Deliver what's left before the callback goes away. */
+    pthread_mutex_lock(&cbi->batch->lock);
+    cjni_write_items_t items = cjni_write_batch_take(cbi->batch);
+    pthread_mutex_unlock(&cbi->batch->lock);
+    cjni_write_batch_deliver(jvm_env, cbi, &items);
+    cjni_write_batch_destroy(cbi->batch);
+    cbi->batch = NULL;
+  }
+
   (*jvm_env)->DeleteGlobalRef(jvm_env, cbi->object);
 
   cbi->method = NULL;
@@ -2337,7 +2563,7 @@ static int cjni_write(const data_set_t *ds, const value_list_t *vl, /* {{{ */
 
   cbi = (cjni_callback_info_t *)ud->data;
 
-  vl_java = ctoj_value_list(jvm_env, ds, vl);
+  vl_java = ctoj_value_list(jvm_env, ds, vl, /* o_dataset = */ NULL);
   if (vl_java == NULL) {
     ERROR("java plugin: cjni_write: ctoj_value_list failed.");
     cjni_thread_detach();
@@ -2353,6 +2579,222 @@ static int cjni_write(const data_set_t *ds, const value_list_t *vl, /* {{{ */
   return ret_status;
 } /* }}} int cjni_write */
 
+/* Move the queued value lists out of the batch, so that they can be delivered
+ * after releasing the batch lock. The batch lock must be held. */
+static cjni_write_items_t cjni_write_batch_take(cjni_write_batch_t *b) /* {{{ */
+{
+  cjni_write_items_t items = b->items;
+  b->items = (cjni_write_items_t){0};
+  return items;
+} /* }}} cjni_write_items_t cjni_write_batch_take */
+
+/* Pass the value lists to the CB_TYPE_WRITE_BATCH callback as one array and
+ * free them. The batch lock must not be held, so that writes are not blocked
+ * while Java handles the array. Every value list is still converted to a
+ * ValueList object with one JNI call per field and value. */
+static int cjni_write_batch_deliver(JNIEnv *jvm_env, /* {{{ */
+                                    cjni_callback_info_t *cbi,
+                                    cjni_write_items_t *items) {
+  const data_set_t *last_ds = NULL;
+  jobjectArray o_array;
+  jobject o_dataset = NULL;
+  int ret_status = -1;
+  size_t i;
+
+  if (items->num == 0) {
+    cjni_write_items_free(items);
+    return 0;
+  }
+
+  o_array = (*jvm_env)->NewObjectArray(jvm_env, (jsize)items->num,
+                                       vl_cache.c_valuelist, NULL);
+  if (o_array == NULL) {
+    ERROR("java plugin: cjni_write_batch_deliver: NewObjectArray failed.");
+    cjni_write_items_free(items);
+    return -1;
+  }
+
+  for (i = 0; i < items->num; i++) {
+    jobject o_vl;
+
+    /* Consecutive value lists of the same type share one DataSet object. */
+    if (items->ds[i] != last_ds) {
+      if (o_dataset != NULL)
+        (*jvm_env)->DeleteLocalRef(jvm_env, o_dataset);
+      o_dataset = ctoj_data_set(jvm_env, items->ds[i]);
+      if (o_dataset == NULL) {
+        ERROR("java plugin: cjni_write_batch_deliver: "
+              "ctoj_data_set (%s) failed.",
+              items->ds[i]->type);
+        break;
+      }
+      last_ds = items->ds[i];
+    }
+
+    o_vl = ctoj_value_list(jvm_env, items->ds[i], &items->vl[i], o_dataset);
+    if (o_vl == NULL) {
+      ERROR("java plugin: cjni_write_batch_deliver: ctoj_value_list failed.");
+      break;
+    }
+
+    (*jvm_env)->SetObjectArrayElement(jvm_env, o_array, (jsize)i, o_vl);
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_vl);
+  }
+
+  if (i == items->num)
+    ret_status =
+        (*jvm_env)->CallIntMethod(jvm_env, cbi->object, cbi->method, o_array);
+
+  if (o_dataset != NULL)
+    (*jvm_env)->DeleteLocalRef(jvm_env, o_dataset);
+  (*jvm_env)->DeleteLocalRef(jvm_env, o_array);
+  cjni_write_items_free(items);
+
+  return ret_status;
+} /* }}} int cjni_write_batch_deliver */
+
+/* Queue the value list for the CB_TYPE_WRITE_BATCH callback pointed to by the
+ * `user_data_t' pointer. The queue is delivered when it is full, or by
+ * `cjni_write_batch_timer' once the oldest value list has been waiting for one
+ * interval. */
+static int cjni_write_batch(const data_set_t *ds, /* {{{ */
+                            const value_list_t *vl, user_data_t *ud) {
+  JNIEnv *jvm_env;
+  cjni_callback_info_t *cbi;
+  cjni_write_batch_t *b;
+  cjni_write_items_t items = {0};
+  value_list_t *vl_copy;
+  cdtime_t now = cdtime();
+  int ret_status;
+
+  if (jvm == NULL) {
+    ERROR("java plugin: cjni_write_batch: jvm == NULL");
+    return -1;
+  }
+
+  if ((ud == NULL) || (ud->data == NULL)) {
+    ERROR("java plugin: cjni_write_batch: Invalid user data.");
+    return -1;
+  }
+
+  cbi = (cjni_callback_info_t *)ud->data;
+  b = cbi->batch;
+
+  pthread_mutex_lock(&b->lock);
+
+  if (b->items.vl == NULL) {
+    b->items.vl = calloc(b->size, sizeof(*b->items.vl));
+    b->items.ds = calloc(b->size, sizeof(*b->items.ds));
+    if ((b->items.vl == NULL) || (b->items.ds == NULL)) {
+      sfree(b->items.vl);
+      sfree(b->items.ds);
+      pthread_mutex_unlock(&b->lock);
+      ERROR("java plugin: cjni_write_batch: calloc failed.");
+      return -1;
+    }
+  }
+
+  vl_copy = &b->items.vl[b->items.num];
+  *vl_copy = *vl;
+  vl_copy->values = malloc(vl->values_len * sizeof(*vl_copy->values));
+  if (vl_copy->values == NULL) {
+    pthread_mutex_unlock(&b->lock);
+    ERROR("java plugin: cjni_write_batch: malloc failed.");
+    return -1;
+  }
+  memcpy(vl_copy->values, vl->values,
+         vl->values_len * sizeof(*vl_copy->values));
+  vl_copy->meta = meta_data_clone(vl->meta);
+  b->items.ds[b->items.num] = ds;
+  if (b->items.num == 0)
+    b->first = now;
+  b->items.num++;
+
+  if ((b->items.num >= b->size) || ((now - b->first) >= b->timeout))
+    items = cjni_write_batch_take(b);
+
+  pthread_mutex_unlock(&b->lock);
+
+  if (items.num == 0)
+    return 0;
+
+  jvm_env = cjni_thread_attach();
+  if (jvm_env == NULL) {
+    cjni_write_items_free(&items);
+    return -1;
+  }
+
+  ret_status = cjni_write_batch_deliver(jvm_env, cbi, &items);
+
+  cjni_thread_detach();
+  return ret_status;
+} /* }}} int cjni_write_batch */
+
+/* Pass on a partial batch once the timeout has passed, even if no more value
+ * lists are written. Runs twice per timeout, so value lists are kept back for
+ * at most one and a half times the timeout. */
+static int cjni_write_batch_timer(user_data_t *ud) /* {{{ */
+{
+  cjni_callback_info_t *cbi = ud->data;
+  cjni_write_batch_t *b = cbi->batch;
+  cjni_write_items_t items = {0};
+  JNIEnv *jvm_env;
+  int ret_status;
+
+  if (jvm == NULL)
+    return 0;
+
+  pthread_mutex_lock(&b->lock);
+  if ((b->items.num > 0) && ((cdtime() - b->first) >= b->timeout))
+    items = cjni_write_batch_take(b);
+  pthread_mutex_unlock(&b->lock);
+
+  if (items.num == 0)
+    return 0;
+
+  jvm_env = cjni_thread_attach();
+  if (jvm_env == NULL) {
+    cjni_write_items_free(&items);
+    return -1;
+  }
+
+  ret_status = cjni_write_batch_deliver(jvm_env, cbi, &items);
+
+  cjni_thread_detach();
+  return (ret_status == 0) ? 0 : -1;
+} /* }}} int cjni_write_batch_timer */
+
+/* Drop a reference to a batched write callback. Returns true if it was the
+ * last one. */
+static bool cjni_write_batch_unref(cjni_write_batch_t *b) /* {{{ */
+{
+  pthread_mutex_lock(&b->lock);
+  bool last = (--b->refs == 0);
+  pthread_mutex_unlock(&b->lock);
+  return last;
+} /* }}} bool cjni_write_batch_unref */
+
+/* Free function of the timer. */
+static void cjni_write_batch_timer_free(void *arg) /* {{{ */
+{
+  cjni_callback_info_t *cbi = arg;
+
+  if (cjni_write_batch_unref(cbi->batch))
+    cjni_callback_info_destroy(cbi);
+} /* }}} void cjni_write_batch_timer_free */
+
+/* Free function of the write callback. The timer is stopped as well; its
+ * reference is dropped once the read thread is done with it. */
+static void cjni_write_batch_free(void *arg) /* {{{ */
+{
+  cjni_callback_info_t *cbi = arg;
+
+  if (cjni_write_batch_unref(cbi->batch))
+    cjni_callback_info_destroy(cbi);
+  else
+    plugin_unregister_read(cbi->batch->timer_name);
+} /* }}} void cjni_write_batch_free */
+
 /* Call the CB_TYPE_FLUSH callback pointed to by the `user_data_t' pointer. */
 static int cjni_flush(cdtime_t timeout, const char *identifier, /* {{{ */
                       user_data_t *ud) {
@@ -2655,7 +3097,7 @@ static int cjni_match_target_invoke(const data_set_t *ds, /* {{{ */
 
   cbi = (cjni_callback_info_t *)*user_data;
 
-  o_vl = ctoj_value_list(jvm_env, ds, vl);
+  o_vl = ctoj_value_list(jvm_env, ds, vl, /* o_dataset = */ NULL);
   if (o_vl == NULL) {
     ERROR("java plugin: cjni_match_target_invoke: ctoj_value_list failed.");
     cjni_thread_detach();
@@ -2766,6 +3208,19 @@ static int cjni_shutdown(void) /* {{{ */
     return -1;
   }
 
+  /* Deliver the values still queued for batched write callbacks. The list
+   * lock keeps the callbacks from being destroyed meanwhile. */
+  pthread_mutex_lock(&java_batch_callbacks_lock);
+  for (size_t i = 0; i < java_batch_callbacks_num; i++) {
+    cjni_callback_info_t *cbi = java_batch_callbacks[i];
+
+    pthread_mutex_lock(&cbi->batch->lock);
+    cjni_write_items_t items = cjni_write_batch_take(cbi->batch);
+    pthread_mutex_unlock(&cbi->batch->lock);
+    cjni_write_batch_deliver(jvm_env, cbi, &items);
+  }
+  pthread_mutex_unlock(&java_batch_callbacks_lock);
+
   /* Execute all the shutdown functions registered by plugins. */
   cjni_shutdown_plugins(jvm_env);
 
@@ -2791,6 +3246,8 @@ static int cjni_shutdown(void) /* {{{ */
   java_classes_list_len = 0;
   sfree(java_classes_list);
 
+  cjni_value_list_cache_free(jvm_env);
+
   /* Destroy the JVM */
   DEBUG("java plugin: Destroying the JVM.");
   (*jvm)->DestroyJavaVM(jvm);
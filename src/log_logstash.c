@@ -203,7 +203,7 @@ static void log_logstash_log(int severity, const char *msg,
   if (yajl_gen_string(g, (u_char *)msg, strlen(msg)) != yajl_gen_status_ok)
     goto err;
 
-  log_logstash_print(g, severity, cdtime());
+  log_logstash_print(g, severity, plugin_log_time());
   return;
 err:
   yajl_gen_free(g);
@@ -151,7 +151,7 @@ static void logfile_log(int severity, const char *msg,
   if (severity > log_level)
     return;
 
-  logfile_print(msg, severity, cdtime());
+  logfile_print(msg, severity, plugin_log_time());
 } /* void logfile_log (int, const char *) */
 
 static int logfile_notification(const notification_t *n,
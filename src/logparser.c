@@ -78,6 +78,7 @@ typedef struct log_parser_s {
   message_pattern_t *patterns;
   size_t patterns_len;
   bool first_read;
+  bool follow;
   char *filename;
   char *def_plugin_inst;
   char *def_type;
@@ -243,7 +244,7 @@ free_ptr:
 }
 
 static int logparser_config_message(const oconfig_item_t *ci, char *filename,
-                                    bool first_read) {
+                                    bool first_read, bool follow) {
   char *msg_name = NULL;
   char *severity = NULL;
   int ret;
@@ -270,6 +271,7 @@ static int logparser_config_message(const oconfig_item_t *ci, char *filename,
   memset(parser, 0, sizeof(*parser));
   parser->name = msg_name;
   parser->first_read = first_read;
+  parser->follow = follow;
   parser->filename = filename;
   parser->def_severity = NOTIF_OKAY;
 
@@ -318,6 +320,7 @@ error:
 static int logparser_config_logfile(oconfig_item_t *ci) {
   char *filename = NULL;
   bool first_read = false; // First full read
+  bool follow = false;
   int ret = 0;
 
   ret = cf_util_get_string(ci, &filename);
@@ -330,8 +333,10 @@ static int logparser_config_logfile(oconfig_item_t *ci) {
     oconfig_item_t *child = ci->children + i;
     if (strcasecmp("FirstFullRead", child->key) == 0)
       ret = cf_util_get_boolean(child, &first_read);
+    else if (strcasecmp("Follow", child->key) == 0)
+      ret = cf_util_get_boolean(child, &follow);
     else if (strcasecmp("Message", child->key) == 0)
-      ret = logparser_config_message(child, filename, first_read);
+      ret = logparser_config_message(child, filename, first_read, follow);
     else {
       ERROR(PLUGIN_NAME ": Invalid configuration option \"%s\".", child->key);
       goto error;
@@ -534,6 +539,10 @@ static int logparser_init(void) {
       logparser_shutdown();
       return -1;
     }
+
+    if (parser->follow && (message_parser_follow(parser->job) != 0))
+      WARNING(PLUGIN_NAME ": Not following file %s for %s parser.",
+              parser->filename, parser->name);
   }
 
   return 0;
@@ -36,6 +36,7 @@
 #include "filter_chain.h"
 #include "utils/common/common.h"
 #include "utils/metadata/meta_data.h"
+#include "utils/string_cache/string_cache.h"
 #include "utils_llist.h"
 
 #include <regex.h>
@@ -44,6 +45,10 @@
 #define log_err(...) ERROR("`regex' match: " __VA_ARGS__)
 #define log_warn(...) WARNING("`regex' match: " __VA_ARGS__)
 
+/* Number of input strings a list of regular expressions remembers the result
+ * for. */
+#define MR_CACHE_SIZE 1024
+
 /*
  * private data types
  */
@@ -53,6 +58,9 @@ typedef struct mr_regex_s mr_regex_t;
 struct mr_regex_s {
   regex_t re;
   char *re_str;
+  /* Only set for the first regex of a list and caches the result of all
+   * regexen in the list, FC_MATCH_MATCHES or FC_MATCH_NO_MATCH. */
+  string_cache_t *cache;
 
   mr_regex_t *next;
 };
@@ -67,6 +75,9 @@ struct mr_match_s {
   mr_regex_t *type_instance;
   llist_t *meta; /* Maps each meta key into mr_regex_t* */
   bool invert;
+
+  /* NULL unless `ReportStats' is enabled. */
+  string_cache_report_t *report;
 };
 
 /*
@@ -80,9 +91,12 @@ static void mr_free_regex(mr_regex_t *r) /* {{{ */
   regfree(&r->re);
   memset(&r->re, 0, sizeof(r->re));
   sfree(r->re_str);
+  string_cache_destroy(r->cache);
 
   if (r->next != NULL)
     mr_free_regex(r->next);
+
+  sfree(r);
 } /* }}} void mr_free_regex */
 
 static void mr_free_match(mr_match_t *m) /* {{{ */
@@ -90,6 +104,8 @@ static void mr_free_match(mr_match_t *m) /* {{{ */
   if (m == NULL)
     return;
 
+  string_cache_report_destroy(m->report);
+
   mr_free_regex(m->host);
   mr_free_regex(m->plugin);
   mr_free_regex(m->plugin_instance);
@@ -109,6 +125,10 @@ static int mr_match_regexen(mr_regex_t *re_head, /* {{{ */
   if (re_head == NULL)
     return FC_MATCH_MATCHES;
 
+  int cached;
+  if (string_cache_get(re_head->cache, string, &cached, NULL, 0) == 0)
+    return cached;
+
   for (mr_regex_t *re = re_head; re != NULL; re = re->next) {
     int status;
 
@@ -121,10 +141,12 @@ static int mr_match_regexen(mr_regex_t *re_head, /* {{{ */
     } else {
       DEBUG("regex match: Regular expression `%s' does not match `%s'.",
             re->re_str, string);
+      string_cache_put(re_head->cache, string, FC_MATCH_NO_MATCH, NULL);
       return FC_MATCH_NO_MATCH;
     }
   }
 
+  string_cache_put(re_head->cache, string, FC_MATCH_MATCHES, NULL);
   return FC_MATCH_MATCHES;
 } /* }}} int mr_match_regexen */
 
@@ -160,6 +182,12 @@ static int mr_add_regex(mr_regex_t **re_head, const char *re_str, /* {{{ */
   }
 
   if (*re_head == NULL) {
+    re->cache = string_cache_create(MR_CACHE_SIZE);
+    if (re->cache == NULL) {
+      log_err("mr_add_regex: string_cache_create failed.");
+      mr_free_regex(re);
+      return -1;
+    }
     *re_head = re;
   } else {
     mr_regex_t *ptr;
@@ -234,9 +262,47 @@ static int mr_config_add_meta_regex(llist_t **meta, /* {{{ */
   return status;
 } /* }}} int mr_config_add_meta_regex */
 
+static int mr_report_create(mr_match_t *m) /* {{{ */
+{
+  struct {
+    const char *field;
+    mr_regex_t *re;
+  } fields[] = {
+      {"host", m->host},
+      {"plugin", m->plugin},
+      {"plugin_instance", m->plugin_instance},
+      {"type", m->type},
+      {"type_instance", m->type_instance},
+  };
+  int status = 0;
+
+  m->report = string_cache_report_create("match_regex");
+  if (m->report == NULL)
+    return -ENOMEM;
+
+  for (size_t i = 0; (i < STATIC_ARRAY_SIZE(fields)) && (status == 0); i++)
+    if (fields[i].re != NULL)
+      status = string_cache_report_add(m->report, fields[i].field,
+                                       fields[i].re->cache);
+
+  for (llentry_t *e = llist_head(m->meta); (e != NULL) && (status == 0);
+       e = e->next)
+    status = string_cache_report_add(m->report, "meta_data",
+                                     ((mr_regex_t *)e->value)->cache);
+
+  if (status == 0)
+    status = string_cache_report_register(m->report,
+                                          cf_get_default_interval());
+  if (status != 0)
+    log_err("Reporting the cache statistics failed.");
+
+  return status;
+} /* }}} int mr_report_create */
+
 static int mr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
 {
   mr_match_t *m;
+  bool report_stats = false;
   int status;
 
   m = calloc(1, sizeof(*m));
@@ -266,6 +332,8 @@ static int mr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
       status = mr_config_add_meta_regex(&m->meta, child);
     else if (strcasecmp("Invert", child->key) == 0)
       status = cf_util_get_boolean(child, &m->invert);
+    else if (strcasecmp("ReportStats", child->key) == 0)
+      status = cf_util_get_boolean(child, &report_stats);
     else {
       log_err("The `%s' configuration option is not understood and "
               "will be ignored.",
@@ -290,6 +358,9 @@ static int mr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
     break;
   }
 
+  if ((status == 0) && report_stats)
+    status = mr_report_create(m);
+
   if (status != 0) {
     mr_free_match(m);
     return status;
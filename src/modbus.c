@@ -37,6 +37,12 @@
 /* Assume version 2.9.2 */
 #endif
 
+/* Maximum number of registers that may be read with one "read holding
+ * registers" or "read input registers" request. */
+#ifndef MODBUS_MAX_READ_REGISTERS
+#define MODBUS_MAX_READ_REGISTERS 125
+#endif
+
 #ifndef MODBUS_TCP_DEFAULT_PORT
 #ifdef MODBUS_TCP_PORT
 #define MODBUS_TCP_DEFAULT_PORT MODBUS_TCP_PORT
@@ -62,6 +68,7 @@
  *   # Baudrate 38400
  *   # (Assumes 8N1)
  *   Interval 60
+ *   MaxRegisterGap 0
  *
  *   <Slave 1>
  *     Instance "foobar" # optional
@@ -119,11 +126,32 @@ struct mb_data_s /* {{{ */
   mb_data_t *next;
 }; /* }}} */
 
+/* A range of registers of one slave which is read with a single request. The
+ * data of a group are adjacent in the slave's "collect" list, which is kept
+ * sorted by register type and base. */
+struct mb_data_group_s;
+typedef struct mb_data_group_s mb_data_group_t;
+struct mb_data_group_s /* {{{ */
+{
+  mb_mreg_type_t modbus_register_type;
+  int register_base;
+  int registers_num;
+
+  mb_data_t *data;
+  size_t data_num;
+
+  /* Set if the device rejected reading the group at once. */
+  bool read_separately;
+
+  mb_data_group_t *next;
+}; /* }}} */
+
 struct mb_slave_s /* {{{ */
 {
   int id;
   char instance[DATA_MAX_NAME_LEN];
   mb_data_t *collect;
+  mb_data_group_t *groups;
 }; /* }}} */
 typedef struct mb_slave_s mb_slave_t;
 
@@ -136,6 +164,7 @@ struct mb_host_s /* {{{ */
   int baudrate;           /* for Modbus/RTU */
   mb_uarttype_t uarttype; /* UART type for Modbus/RTU */
   mb_conntype_t conntype;
+  int max_register_gap; /* negative: do not coalesce reads */
 
   mb_slave_t *slaves;
   size_t slaves_num;
@@ -149,16 +178,6 @@ struct mb_host_s /* {{{ */
 }; /* }}} */
 typedef struct mb_host_s mb_host_t;
 
-struct mb_data_group_s;
-typedef struct mb_data_group_s mb_data_group_t;
-struct mb_data_group_s /* {{{ */
-{
-  mb_data_t *registers;
-  size_t registers_num;
-
-  mb_data_group_t *next;
-}; /* }}} */
-
 /*
  * Global variables
  */
@@ -426,55 +445,28 @@ static int mb_init_connection(mb_host_t *host) /* {{{ */
       (vt).absolute = (((absolute_t)(raw)*scale) + shift);                     \
   } while (0)
 
-static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
-                        mb_data_t *data) {
-  uint16_t values[4] = {0};
-  int values_num;
-  const data_set_t *ds;
-  int status = 0;
-
-  if ((host == NULL) || (slave == NULL) || (data == NULL))
-    return EINVAL;
-
-  ds = plugin_get_ds(data->type);
-  if (ds == NULL) {
-    ERROR("Modbus plugin: Type \"%s\" is not defined.", data->type);
-    return -1;
-  }
-
-  if (ds->ds_num != 1) {
-    ERROR("Modbus plugin: The type \"%s\" has %" PRIsz " data sources. "
-          "I can only handle data sets with only one data source.",
-          data->type, ds->ds_num);
-    return -1;
-  }
-
-  if ((ds->ds[0].type != DS_TYPE_GAUGE) &&
-      (data->register_type != REG_TYPE_INT32) &&
-      (data->register_type != REG_TYPE_INT32_CDAB) &&
-      (data->register_type != REG_TYPE_UINT32) &&
-      (data->register_type != REG_TYPE_UINT32_CDAB) &&
-      (data->register_type != REG_TYPE_INT64) &&
-      (data->register_type != REG_TYPE_UINT64)) {
-    NOTICE(
-        "Modbus plugin: The data source of type \"%s\" is %s, not gauge. "
-        "This will most likely result in problems, because the register type "
-        "is not UINT32 or UINT64.",
-        data->type, DS_TYPE_TO_STRING(ds->ds[0].type));
-  }
-
+/* Returns the number of registers occupied by `data'. */
+static int mb_data_registers_num(mb_data_t const *data) /* {{{ */
+{
   if ((data->register_type == REG_TYPE_INT32) ||
       (data->register_type == REG_TYPE_INT32_CDAB) ||
       (data->register_type == REG_TYPE_UINT32) ||
       (data->register_type == REG_TYPE_UINT32_CDAB) ||
       (data->register_type == REG_TYPE_FLOAT) ||
       (data->register_type == REG_TYPE_FLOAT_CDAB))
-    values_num = 2;
+    return 2;
   else if ((data->register_type == REG_TYPE_INT64) ||
            (data->register_type == REG_TYPE_UINT64))
-    values_num = 4;
+    return 4;
   else
-    values_num = 1;
+    return 1;
+} /* }}} int mb_data_registers_num */
+
+static int mb_read_registers(mb_host_t *host, mb_slave_t *slave, /* {{{ */
+                             mb_mreg_type_t modbus_register_type,
+                             int register_base, int registers_num,
+                             uint16_t *values) {
+  int status = 0;
 
   if (host->connection == NULL) {
     status = EBADF;
@@ -519,21 +511,22 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     return -1;
   }
 #endif
-  if (data->modbus_register_type == MREG_INPUT) {
+  if (modbus_register_type == MREG_INPUT) {
     status = modbus_read_input_registers(host->connection,
-                                         /* start_addr = */ data->register_base,
-                                         /* num_registers = */ values_num,
+                                         /* start_addr = */ register_base,
+                                         /* num_registers = */ registers_num,
                                          /* buffer = */ values);
   } else {
     status = modbus_read_registers(host->connection,
-                                   /* start_addr = */ data->register_base,
-                                   /* num_registers = */ values_num,
+                                   /* start_addr = */ register_base,
+                                   /* num_registers = */ registers_num,
                                    /* buffer = */ values);
   }
-  if (status != values_num) {
+  if (status != registers_num) {
+    int read_errno = errno;
     ERROR("Modbus plugin: modbus read function (%s/%s) failed. "
           " status = %i, start_addr = %i, values_num = %i. Giving up.",
-          host->host, host->node, status, data->register_base, values_num);
+          host->host, host->node, status, register_base, registers_num);
 #if LEGACY_LIBMODBUS
     modbus_close(&host->connection);
 #else
@@ -541,19 +534,58 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     modbus_free(host->connection);
 #endif
     host->connection = NULL;
+    errno = read_errno;
     return -1;
   }
 
-  DEBUG("Modbus plugin: mb_read_data: Success! "
+  DEBUG("Modbus plugin: mb_read_registers: Success! "
         "modbus_read_registers returned with status %i.",
         status);
 
+  return 0;
+} /* }}} int mb_read_registers */
+
+/* Decodes the registers of `data' from `values' and dispatches the result. */
+static int mb_submit_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
+                          mb_data_t *data, uint16_t const *values) {
+  const data_set_t *ds;
+
+  if ((host == NULL) || (slave == NULL) || (data == NULL))
+    return EINVAL;
+
+  ds = plugin_get_ds(data->type);
+  if (ds == NULL) {
+    ERROR("Modbus plugin: Type \"%s\" is not defined.", data->type);
+    return -1;
+  }
+
+  if (ds->ds_num != 1) {
+    ERROR("Modbus plugin: The type \"%s\" has %" PRIsz " data sources. "
+          "I can only handle data sets with only one data source.",
+          data->type, ds->ds_num);
+    return -1;
+  }
+
+  if ((ds->ds[0].type != DS_TYPE_GAUGE) &&
+      (data->register_type != REG_TYPE_INT32) &&
+      (data->register_type != REG_TYPE_INT32_CDAB) &&
+      (data->register_type != REG_TYPE_UINT32) &&
+      (data->register_type != REG_TYPE_UINT32_CDAB) &&
+      (data->register_type != REG_TYPE_INT64) &&
+      (data->register_type != REG_TYPE_UINT64)) {
+    NOTICE(
+        "Modbus plugin: The data source of type \"%s\" is %s, not gauge. "
+        "This will most likely result in problems, because the register type "
+        "is not UINT32 or UINT64.",
+        data->type, DS_TYPE_TO_STRING(ds->ds[0].type));
+  }
+
   if (data->register_type == REG_TYPE_FLOAT) {
     float float_value;
     value_t vt;
 
     float_value = mb_register_to_float(values[0], values[1]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned float value is %g",
           (double)float_value);
 
@@ -564,7 +596,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     value_t vt;
 
     float_value = mb_register_to_float(values[1], values[0]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned float value is %g",
           (double)float_value);
 
@@ -578,7 +610,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     value_t vt;
 
     v.u32 = (((uint32_t)values[0]) << 16) | ((uint32_t)values[1]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned int32 value is %" PRIi32,
           v.i32);
 
@@ -592,7 +624,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     value_t vt;
 
     v.u32 = (((uint32_t)values[1]) << 16) | ((uint32_t)values[0]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned int32 value is %" PRIi32,
           v.i32);
 
@@ -607,7 +639,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
 
     v.u16 = values[0];
 
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned int16 value is %" PRIi16,
           v.i16);
 
@@ -618,7 +650,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     value_t vt;
 
     v32 = (((uint32_t)values[0]) << 16) | ((uint32_t)values[1]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned uint32 value is %" PRIu32,
           v32);
 
@@ -629,7 +661,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
     value_t vt;
 
     v32 = (((uint32_t)values[1]) << 16) | ((uint32_t)values[0]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned uint32 value is %" PRIu32,
           v32);
 
@@ -641,7 +673,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
 
     v64 = (((uint64_t)values[0]) << 48) | (((uint64_t)values[1]) << 32) |
           (((uint64_t)values[2]) << 16) | (((uint64_t)values[3]));
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned uint64 value is %" PRIu64,
           v64);
 
@@ -656,7 +688,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
 
     v.u64 = (((uint64_t)values[0]) << 48) | (((uint64_t)values[1]) << 32) |
             (((uint64_t)values[2]) << 16) | ((uint64_t)values[3]);
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned uint64 value is %" PRIi64,
           v.i64);
 
@@ -666,7 +698,7 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
   {
     value_t vt;
 
-    DEBUG("Modbus plugin: mb_read_data: "
+    DEBUG("Modbus plugin: mb_submit_data: "
           "Returned uint16 value is %" PRIu16,
           values[0]);
 
@@ -675,22 +707,73 @@ static int mb_read_data(mb_host_t *host, mb_slave_t *slave, /* {{{ */
   }
 
   return 0;
-} /* }}} int mb_read_data */
+} /* }}} int mb_submit_data */
+
+/* Reads all registers of a group with one request. Returns the number of data
+ * which have been dispatched successfully. */
+static size_t mb_read_group(mb_host_t *host, mb_slave_t *slave, /* {{{ */
+                            mb_data_group_t *group) {
+  uint16_t values[MODBUS_MAX_READ_REGISTERS] = {0};
+  mb_data_t *data;
+  size_t success = 0;
+  int status;
+
+  if (group->read_separately) {
+    data = group->data;
+    for (size_t i = 0; i < group->data_num; i++, data = data->next) {
+      status = mb_read_registers(host, slave, data->modbus_register_type,
+                                 data->register_base,
+                                 mb_data_registers_num(data), values);
+      if (status != 0)
+        continue;
+      if (mb_submit_data(host, slave, data, values) == 0)
+        success++;
+    }
+    return success;
+  }
+
+  status = mb_read_registers(host, slave, group->modbus_register_type,
+                             group->register_base, group->registers_num,
+                             values);
+#ifdef EMBXILADD
+  /* The group spans registers which are not mapped on this device. Fall back
+   * to reading each data on its own. */
+  if ((status != 0) && (errno == EMBXILADD) && (group->data_num > 1)) {
+    WARNING("Modbus plugin: Reading registers %i to %i of slave %i on "
+            "\"%s\" in one request failed. Reading them one by one from "
+            "now on. Consider lowering \"MaxRegisterGap\".",
+            group->register_base,
+            group->register_base + group->registers_num - 1, slave->id,
+            host->host);
+    group->read_separately = true;
+    return mb_read_group(host, slave, group);
+  }
+#endif
+  if (status != 0)
+    return 0;
+
+  data = group->data;
+  for (size_t i = 0; i < group->data_num; i++, data = data->next) {
+    int offset = data->register_base - group->register_base;
+    status = mb_submit_data(host, slave, data, values + offset);
+    if (status == 0)
+      success++;
+  }
+
+  return success;
+} /* }}} size_t mb_read_group */
 
 static int mb_read_slave(mb_host_t *host, mb_slave_t *slave) /* {{{ */
 {
-  int success;
-  int status;
+  size_t success;
 
   if ((host == NULL) || (slave == NULL))
     return EINVAL;
 
   success = 0;
-  for (mb_data_t *data = slave->collect; data != NULL; data = data->next) {
-    status = mb_read_data(host, slave, data);
-    if (status == 0)
-      success++;
-  }
+  for (mb_data_group_t *group = slave->groups; group != NULL;
+       group = group->next)
+    success += mb_read_group(host, slave, group);
 
   if (success == 0)
     return -1;
@@ -746,13 +829,24 @@ static void data_free_all(mb_data_t *data) /* {{{ */
   data_free_all(next);
 } /* }}} void data_free_all */
 
+static void groups_free_all(mb_data_group_t *group) /* {{{ */
+{
+  while (group != NULL) {
+    mb_data_group_t *next = group->next;
+    sfree(group);
+    group = next;
+  }
+} /* }}} void groups_free_all */
+
 static void slaves_free_all(mb_slave_t *slaves, size_t slaves_num) /* {{{ */
 {
   if (slaves == NULL)
     return;
 
-  for (size_t i = 0; i < slaves_num; i++)
+  for (size_t i = 0; i < slaves_num; i++) {
     data_free_all(slaves[i].collect);
+    groups_free_all(slaves[i].groups);
+  }
   sfree(slaves);
 } /* }}} void slaves_free_all */
 
@@ -769,6 +863,87 @@ static void host_free(void *void_host) /* {{{ */
 
 /* Config functions */
 
+static int data_compare(const void *a, const void *b) /* {{{ */
+{
+  mb_data_t const *d0 = *(mb_data_t *const *)a;
+  mb_data_t const *d1 = *(mb_data_t *const *)b;
+
+  if (d0->modbus_register_type != d1->modbus_register_type)
+    return (d0->modbus_register_type < d1->modbus_register_type) ? -1 : 1;
+  if (d0->register_base != d1->register_base)
+    return (d0->register_base < d1->register_base) ? -1 : 1;
+  return 0;
+} /* }}} int data_compare */
+
+/* Sorts the slave's data by register and merges data whose registers are at
+ * most `max_gap' registers apart into groups, which are read with a single
+ * request each. A negative `max_gap' puts every data into its own group. */
+static int mb_slave_group_data(mb_slave_t *slave, int max_gap) /* {{{ */
+{
+  mb_data_t **sorted;
+  size_t data_num = 0;
+  mb_data_group_t *group = NULL;
+
+  groups_free_all(slave->groups);
+  slave->groups = NULL;
+
+  for (mb_data_t *data = slave->collect; data != NULL; data = data->next)
+    data_num++;
+  if (data_num == 0)
+    return 0;
+
+  sorted = calloc(data_num, sizeof(*sorted));
+  if (sorted == NULL)
+    return ENOMEM;
+
+  data_num = 0;
+  for (mb_data_t *data = slave->collect; data != NULL; data = data->next)
+    sorted[data_num++] = data;
+  qsort(sorted, data_num, sizeof(*sorted), data_compare);
+
+  slave->collect = sorted[0];
+  for (size_t i = 0; i < data_num; i++)
+    sorted[i]->next = (i + 1 < data_num) ? sorted[i + 1] : NULL;
+
+  for (size_t i = 0; i < data_num; i++) {
+    mb_data_t *data = sorted[i];
+    int data_end = data->register_base + mb_data_registers_num(data);
+
+    if ((group != NULL) && (max_gap >= 0) &&
+        (group->modbus_register_type == data->modbus_register_type)) {
+      int group_end = group->register_base + group->registers_num;
+      int end = (data_end > group_end) ? data_end : group_end;
+
+      if ((data->register_base <= group_end + max_gap) &&
+          (end - group->register_base <= MODBUS_MAX_READ_REGISTERS)) {
+        group->registers_num = end - group->register_base;
+        group->data_num++;
+        continue;
+      }
+    }
+
+    mb_data_group_t *new_group = calloc(1, sizeof(*new_group));
+    if (new_group == NULL) {
+      sfree(sorted);
+      return ENOMEM;
+    }
+    new_group->modbus_register_type = data->modbus_register_type;
+    new_group->register_base = data->register_base;
+    new_group->registers_num = data_end - data->register_base;
+    new_group->data = data;
+    new_group->data_num = 1;
+
+    if (group == NULL)
+      slave->groups = new_group;
+    else
+      group->next = new_group;
+    group = new_group;
+  }
+
+  sfree(sorted);
+  return 0;
+} /* }}} int mb_slave_group_data */
+
 static int mb_config_add_data(oconfig_item_t *ci) /* {{{ */
 {
   mb_data_t data = {0};
@@ -1036,6 +1211,8 @@ static int mb_config_add_host(oconfig_item_t *ci) /* {{{ */
 #endif
     } else if (strcasecmp("Interval", child->key) == 0)
       status = cf_util_get_cdtime(child, &interval);
+    else if (strcasecmp("MaxRegisterGap", child->key) == 0)
+      status = cf_util_get_int(child, &host->max_register_gap);
     else if (strcasecmp("Slave", child->key) == 0)
       /* Don't set status: Gracefully continue if a slave fails. */
       mb_config_add_slave(host, child);
@@ -1069,6 +1246,13 @@ static int mb_config_add_host(oconfig_item_t *ci) /* {{{ */
     status = -1;
   }
 
+  for (size_t i = 0; (status == 0) && (i < host->slaves_num); i++) {
+    status = mb_slave_group_data(host->slaves + i, host->max_register_gap);
+    if (status != 0)
+      ERROR("Modbus plugin: Grouping the registers of slave %i failed.",
+            host->slaves[i].id);
+  }
+
   if (status == 0) {
     char name[1024];
 
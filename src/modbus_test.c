@@ -0,0 +1,126 @@
+/**
+ * collectd - src/modbus_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; only version 2.1 of the License is
+ * applicable.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ **/
+
+#include "modbus.c" /* sic */
+#include "testing.h"
+
+static void add_data(mb_slave_t *slave, char const *name, int register_base,
+                     mb_register_type_t register_type,
+                     mb_mreg_type_t modbus_register_type) {
+  mb_data_t data = {
+      .name = (char *)name,
+      .register_base = register_base,
+      .register_type = register_type,
+      .modbus_register_type = modbus_register_type,
+  };
+  data_copy(&slave->collect, &data);
+}
+
+static size_t groups_num(mb_slave_t const *slave) {
+  size_t n = 0;
+  for (mb_data_group_t *g = slave->groups; g != NULL; g = g->next)
+    n++;
+  return n;
+}
+
+DEF_TEST(group_data) {
+  struct {
+    int max_gap;
+    size_t want_groups;
+  } cases[] = {
+      {-1, 6}, {0, 4}, {3, 3}, {200, 3},
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    mb_slave_t slave = {0};
+
+    /* Holding registers 0 (1 register), 1-2, 6-9 and 200, in random order. */
+    add_data(&slave, "int64", 6, REG_TYPE_INT64, MREG_HOLDING);
+    add_data(&slave, "far", 200, REG_TYPE_UINT16, MREG_HOLDING);
+    add_data(&slave, "uint16", 0, REG_TYPE_UINT16, MREG_HOLDING);
+    add_data(&slave, "float", 1, REG_TYPE_FLOAT, MREG_HOLDING);
+    /* Input registers are never merged with holding registers. */
+    add_data(&slave, "input", 3, REG_TYPE_UINT16, MREG_INPUT);
+    /* Overlaps "int64". */
+    add_data(&slave, "overlap", 8, REG_TYPE_UINT32, MREG_HOLDING);
+
+    printf("## Case %zu: MaxRegisterGap %d\n", i, cases[i].max_gap);
+    CHECK_ZERO(mb_slave_group_data(&slave, cases[i].max_gap));
+    EXPECT_EQ_INT(cases[i].want_groups, groups_num(&slave));
+
+    /* The collect list is sorted and every data is part of exactly one group
+     * which contains all of its registers. */
+    mb_data_t *data = slave.collect;
+    size_t data_num = 0;
+    for (mb_data_group_t *g = slave.groups; g != NULL; g = g->next) {
+      OK(g->registers_num <= MODBUS_MAX_READ_REGISTERS);
+      for (size_t j = 0; j < g->data_num; j++, data = data->next) {
+        OK(data != NULL);
+        OK(g->data != NULL);
+        EXPECT_EQ_INT(g->modbus_register_type, data->modbus_register_type);
+        OK(data->register_base >= g->register_base);
+        OK(data->register_base + mb_data_registers_num(data) <=
+           g->register_base + g->registers_num);
+        data_num++;
+      }
+    }
+    OK(data == NULL);
+    EXPECT_EQ_INT(6, data_num);
+
+    if (cases[i].max_gap == 3) {
+      mb_data_group_t *g = slave.groups;
+      EXPECT_EQ_INT(0, g->register_base);
+      EXPECT_EQ_INT(10, g->registers_num);
+      EXPECT_EQ_INT(4, g->data_num);
+    }
+
+    data_free_all(slave.collect);
+    groups_free_all(slave.groups);
+  }
+
+  return 0;
+}
+
+DEF_TEST(group_limit) {
+  mb_slave_t slave = {0};
+
+  for (int i = 0; i < 200; i++) {
+    char name[16];
+    ssnprintf(name, sizeof(name), "reg%d", i);
+    add_data(&slave, name, i, REG_TYPE_UINT16, MREG_HOLDING);
+  }
+
+  CHECK_ZERO(mb_slave_group_data(&slave, 0));
+  EXPECT_EQ_INT(2, groups_num(&slave));
+  EXPECT_EQ_INT(MODBUS_MAX_READ_REGISTERS, slave.groups->registers_num);
+  EXPECT_EQ_INT(MODBUS_MAX_READ_REGISTERS, slave.groups->next->register_base);
+  EXPECT_EQ_INT(200 - MODBUS_MAX_READ_REGISTERS,
+                slave.groups->next->registers_num);
+
+  data_free_all(slave.collect);
+  groups_free_all(slave.groups);
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(group_data);
+  RUN_TEST(group_limit);
+
+  END_TEST;
+}
@@ -795,4 +795,5 @@ static int mqtt_init(void) {
 void module_register(void) {
   plugin_register_complex_config("mqtt", mqtt_config);
   plugin_register_init("mqtt", mqtt_init);
+  plugin_register_init_exclusive("mqtt");
 } /* void module_register */
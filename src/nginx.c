@@ -30,6 +30,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
 
 #include <curl/curl.h>
 
@@ -51,7 +52,7 @@ static const char *config_keys[] = {
     "URL", "User", "Password", "VerifyPeer", "VerifyHost", "CACert", "Timeout"};
 static int config_keys_num = STATIC_ARRAY_SIZE(config_keys);
 
-static size_t nginx_curl_callback(void *buf, size_t size, size_t nmemb,
+static size_t nginx_curl_callback(char *buf, size_t size, size_t nmemb,
                                   void __attribute__((unused)) * stream) {
   size_t len = size * nmemb;
 
@@ -103,8 +104,10 @@ static int config(const char *key, const char *value) {
 } /* int config */
 
 static int init(void) {
-  if (curl != NULL)
+  if (curl != NULL) {
+    curl_engine_cancel(curl);
     curl_easy_cleanup(curl);
+  }
 
   if ((curl = curl_easy_init()) == NULL) {
     ERROR("nginx plugin: curl_easy_init failed.");
@@ -188,7 +191,9 @@ static void submit(const char *type, const char *inst, long long value) {
   plugin_dispatch_values(&vl);
 } /* void submit */
 
-static int nginx_read(void) {
+/* Called by the cURL engine once the status page has been received. */
+static void nginx_page_done(__attribute__((unused)) CURL *c, CURLcode code,
+                            __attribute__((unused)) void *user_data) {
   char *ptr;
   char *lines[16];
   int lines_num = 0;
@@ -197,18 +202,9 @@ static int nginx_read(void) {
   char *fields[16];
   int fields_num;
 
-  if (curl == NULL)
-    return -1;
-  if (url == NULL)
-    return -1;
-
-  nginx_buffer_len = 0;
-
-  curl_easy_setopt(curl, CURLOPT_URL, url);
-
-  if (curl_easy_perform(curl) != CURLE_OK) {
+  if (code != CURLE_OK) {
     WARNING("nginx plugin: curl_easy_perform failed: %s", nginx_curl_error);
-    return -1;
+    return;
   }
 
   ptr = nginx_buffer;
@@ -257,12 +253,54 @@ static int nginx_read(void) {
   }
 
   nginx_buffer_len = 0;
+} /* void nginx_page_done */
+
+static int nginx_read(void) {
+  if (curl == NULL)
+    return -1;
+  if (url == NULL)
+    return -1;
+
+  cdtime_t submitted;
+  unsigned int skipped = curl_engine_skip(curl, &submitted);
+  if (skipped > 0) {
+    WARNING("nginx plugin: The request to `%s' has not finished after %.3f "
+            "seconds, skipping this interval (%u skipped so far).",
+            url, CDTIME_T_TO_DOUBLE(cdtime() - submitted), skipped);
+    return 0;
+  }
+
+  nginx_buffer_len = 0;
+  nginx_buffer[0] = 0;
+
+  curl_easy_setopt(curl, CURLOPT_URL, url);
+
+  int status = curl_engine_submit(curl, nginx_curl_callback,
+                                  /* write_data = */ NULL, nginx_page_done,
+                                  /* user_data = */ NULL);
+  if (status != 0) {
+    ERROR("nginx plugin: Submitting request to `%s' failed: %s", url,
+          STRERROR(status));
+    return -1;
+  }
 
   return 0;
 } /* int nginx_read */
 
+static int nginx_shutdown(void) {
+  if (curl != NULL) {
+    curl_engine_cancel(curl);
+    curl_easy_cleanup(curl);
+    curl = NULL;
+  }
+
+  return 0;
+} /* int nginx_shutdown */
+
 void module_register(void) {
   plugin_register_config("nginx", config, config_keys, config_keys_num);
   plugin_register_init("nginx", init);
+  plugin_register_init_exclusive("nginx");
   plugin_register_read("nginx", nginx_read);
+  plugin_register_shutdown("nginx", nginx_shutdown);
 } /* void module_register */
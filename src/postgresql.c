@@ -105,6 +105,23 @@ typedef struct {
   bool store_rates;
 } c_psql_writer_t;
 
+/* Number of times in a row preparing a query may fail while the query works
+ * as plain text, before it is no longer prepared. */
+#define C_PSQL_PREPARE_ATTEMPTS 3
+
+/* State of the server-side prepared statement of a query. Prepared
+ * statements are bound to a session, so this is reset on reconnect. */
+typedef enum {
+  C_PSQL_STMT_UNPREPARED = 0,
+  C_PSQL_STMT_PREPARED,
+  C_PSQL_STMT_UNPREPARABLE,
+} c_psql_stmt_state_t;
+
+typedef struct {
+  c_psql_stmt_state_t state;
+  int failures; /* failed attempts to prepare the statement in a row */
+} c_psql_stmt_t;
+
 typedef struct {
   PGconn *conn;
   c_complain_t conn_complaint;
@@ -116,9 +133,14 @@ typedef struct {
 
   /* user configuration */
   udb_query_preparation_area_t **q_prep_areas;
+  c_psql_stmt_t *q_stmts;
   udb_query_t **queries;
   size_t queries_num;
 
+  bool prepared_statements;
+  bool report_query_time;
+  int connections;
+
   c_psql_writer_t **writers;
   size_t writers_num;
 
@@ -227,9 +249,14 @@ static c_psql_database_t *c_psql_database_new(const char *name) {
   db->max_params_num = 0;
 
   db->q_prep_areas = NULL;
+  db->q_stmts = NULL;
   db->queries = NULL;
   db->queries_num = 0;
 
+  db->prepared_statements = true;
+  db->report_query_time = false;
+  db->connections = 1;
+
   db->writers = NULL;
   db->writers_num = 0;
 
@@ -259,6 +286,30 @@ static c_psql_database_t *c_psql_database_new(const char *name) {
   return db;
 } /* c_psql_database_new */
 
+/* Creates a database object with the same connection settings as `src', but
+ * without any queries or writers. */
+static c_psql_database_t *c_psql_database_clone(const c_psql_database_t *src) {
+  c_psql_database_t *db = c_psql_database_new(src->database);
+  if (db == NULL)
+    return NULL;
+
+  sfree(db->instance);
+  db->instance = sstrdup(src->instance);
+  db->host = sstrdup(src->host);
+  db->port = sstrdup(src->port);
+  db->user = sstrdup(src->user);
+  db->password = sstrdup(src->password);
+  db->plugin_name = sstrdup(src->plugin_name);
+  db->sslmode = sstrdup(src->sslmode);
+  db->krbsrvname = sstrdup(src->krbsrvname);
+  db->service = sstrdup(src->service);
+
+  db->prepared_statements = src->prepared_statements;
+  db->report_query_time = src->report_query_time;
+  db->connections = 1;
+  return db;
+} /* c_psql_database_clone */
+
 static void c_psql_database_delete(void *data) {
   c_psql_database_t *db = data;
 
@@ -280,6 +331,7 @@ static void c_psql_database_delete(void *data) {
     for (size_t i = 0; i < db->queries_num; ++i)
       udb_query_delete_preparation_area(db->q_prep_areas[i]);
   free(db->q_prep_areas);
+  sfree(db->q_stmts);
 
   sfree(db->queries);
   db->queries_num = 0;
@@ -343,6 +395,19 @@ static int c_psql_connect(c_psql_database_t *db) {
   return 0;
 } /* c_psql_connect */
 
+/* Forgets about all prepared statements, e.g. after the session has been
+ * reset. Queries which cannot be prepared are not retried. */
+static void c_psql_reset_statements(c_psql_database_t *db) {
+  if (db->q_stmts == NULL)
+    return;
+
+  for (size_t i = 0; i < db->queries_num; ++i) {
+    if (db->q_stmts[i].state == C_PSQL_STMT_PREPARED)
+      db->q_stmts[i].state = C_PSQL_STMT_UNPREPARED;
+    db->q_stmts[i].failures = 0;
+  }
+} /* c_psql_reset_statements */
+
 static int c_psql_check_connection(c_psql_database_t *db) {
   bool init = false;
 
@@ -354,10 +419,12 @@ static int c_psql_check_connection(c_psql_database_t *db) {
       db->conn_complaint.interval = 1;
 
     c_psql_connect(db);
+    c_psql_reset_statements(db);
   }
 
   if (CONNECTION_OK != PQstatus(db->conn)) {
     PQreset(db->conn);
+    c_psql_reset_statements(db);
 
     /* trigger c_release() */
     if (0 == db->conn_complaint.interval)
@@ -399,17 +466,21 @@ static int c_psql_check_connection(c_psql_database_t *db) {
 } /* c_psql_check_connection */
 
 static PGresult *c_psql_exec_query_noparams(c_psql_database_t *db,
-                                            udb_query_t *q) {
+                                            udb_query_t *q,
+                                            const char *stmt_name) {
+  if (stmt_name != NULL)
+    return PQexecPrepared(db->conn, stmt_name, 0, NULL, NULL, NULL, 0);
   return PQexec(db->conn, udb_query_get_statement(q));
 } /* c_psql_exec_query_noparams */
 
 static PGresult *c_psql_exec_query_params(c_psql_database_t *db, udb_query_t *q,
-                                          c_psql_user_data_t *data) {
+                                          c_psql_user_data_t *data,
+                                          const char *stmt_name) {
   const char *params[db->max_params_num];
   char interval[64];
 
   if ((data == NULL) || (data->params_num == 0))
-    return c_psql_exec_query_noparams(db, q);
+    return c_psql_exec_query_noparams(db, q, stmt_name);
 
   assert(db->max_params_num >= data->params_num);
 
@@ -438,18 +509,88 @@ static PGresult *c_psql_exec_query_params(c_psql_database_t *db, udb_query_t *q,
     }
   }
 
+  if (stmt_name != NULL)
+    return PQexecPrepared(db->conn, stmt_name, data->params_num,
+                          (const char *const *)params, NULL, NULL, 0);
   return PQexecParams(db->conn, udb_query_get_statement(q), data->params_num,
                       NULL, (const char *const *)params, NULL, NULL, 0);
 } /* c_psql_exec_query_params */
 
+/* Prepares the statement of the query with index `idx' on the current
+ * connection unless that has been done before. Returns the name of the
+ * prepared statement or NULL if the query has to be sent as text. `failed' is
+ * set if preparing the statement failed although the connection is fine.
+ * db->db_lock must be locked when calling this function */
+static const char *c_psql_prepare_query(c_psql_database_t *db, size_t idx,
+                                        char *name, size_t name_size,
+                                        bool *failed) {
+  udb_query_t *q = db->queries[idx];
+  c_psql_user_data_t *data = udb_query_get_user_data(q);
+
+  *failed = false;
+  if (!db->prepared_statements || (db->q_stmts == NULL) ||
+      (db->q_stmts[idx].state == C_PSQL_STMT_UNPREPARABLE))
+    return NULL;
+
+  ssnprintf(name, name_size, "collectd_%" PRIsz, idx);
+  if (db->q_stmts[idx].state == C_PSQL_STMT_PREPARED)
+    return name;
+
+  PGresult *res =
+      PQprepare(db->conn, name, udb_query_get_statement(q),
+                (data != NULL) ? data->params_num : 0, /* paramTypes = */ NULL);
+  ExecStatusType status = PQresultStatus(res);
+  PQclear(res);
+
+  if (PGRES_COMMAND_OK == status) {
+    db->q_stmts[idx].state = C_PSQL_STMT_PREPARED;
+    db->q_stmts[idx].failures = 0;
+    return name;
+  }
+
+  /* Try again once the connection has been re-established. */
+  if (CONNECTION_OK != PQstatus(db->conn))
+    return NULL;
+
+  /* Whether this counts as a failure depends on the plain text query, see
+   * c_psql_exec_query(). */
+  log_info("Preparing query \"%s\" failed, sending it as plain text: %s",
+           udb_query_get_name(q), PQerrorMessage(db->conn));
+  *failed = true;
+  return NULL;
+} /* c_psql_prepare_query */
+
+static void c_psql_submit_query_time(c_psql_database_t *db, udb_query_t *q,
+                                     const char *host, cdtime_t query_time) {
+  value_list_t vl = VALUE_LIST_INIT;
+
+  vl.values = &(value_t){.gauge = CDTIME_T_TO_DOUBLE(query_time)};
+  vl.values_len = 1;
+  sstrncpy(vl.host, host, sizeof(vl.host));
+  sstrncpy(vl.plugin,
+           (db->plugin_name != NULL) ? db->plugin_name : "postgresql",
+           sizeof(vl.plugin));
+  sstrncpy(vl.plugin_instance, db->instance, sizeof(vl.plugin_instance));
+  sstrncpy(vl.type, "response_time", sizeof(vl.type));
+  sstrncpy(vl.type_instance, udb_query_get_name(q), sizeof(vl.type_instance));
+
+  plugin_dispatch_values(&vl);
+} /* c_psql_submit_query_time */
+
 /* db->db_lock must be locked when calling this function */
-static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
-                             udb_query_preparation_area_t *prep_area) {
+static int c_psql_exec_query(c_psql_database_t *db, size_t idx) {
+  udb_query_t *q = db->queries[idx];
+  udb_query_preparation_area_t *prep_area = db->q_prep_areas[idx];
   PGresult *res;
 
   c_psql_user_data_t *data;
 
   const char *host;
+  char stmt_name[32];
+  const char *stmt;
+  bool prepare_failed = false;
+  cdtime_t start;
+  cdtime_t query_time;
 
   char **column_names;
   char **column_values;
@@ -461,12 +602,17 @@ static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
   /* The user data may hold parameter information, but may be NULL. */
   data = udb_query_get_user_data(q);
 
+  start = cdtime();
+
   /* Versions up to `3' don't know how to handle parameters. */
-  if (3 <= db->proto_version)
-    res = c_psql_exec_query_params(db, q, data);
-  else if ((NULL == data) || (0 == data->params_num))
-    res = c_psql_exec_query_noparams(db, q);
-  else {
+  if (3 <= db->proto_version) {
+    stmt = c_psql_prepare_query(db, idx, stmt_name, sizeof(stmt_name),
+                                &prepare_failed);
+    res = c_psql_exec_query_params(db, q, data, stmt);
+  } else if ((NULL == data) || (0 == data->params_num)) {
+    stmt = NULL;
+    res = c_psql_exec_query_noparams(db, q, stmt);
+  } else {
     log_err("Connection to database \"%s\" (%s) does not support "
             "parameters (protocol version %d) - "
             "cannot execute query \"%s\".",
@@ -475,6 +621,19 @@ static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
     return -1;
   }
 
+  query_time = cdtime() - start;
+
+  /* Only give up on preparing the query if that keeps failing while the plain
+   * text query works. Otherwise the error is most likely in the query or the
+   * server and may go away. */
+  if (prepare_failed && (PGRES_TUPLES_OK == PQresultStatus(res)) &&
+      (++db->q_stmts[idx].failures >= C_PSQL_PREPARE_ATTEMPTS)) {
+    log_warn("Preparing query \"%s\" failed %d times in a row, sending it as "
+             "plain text from now on.",
+             udb_query_get_name(q), db->q_stmts[idx].failures);
+    db->q_stmts[idx].state = C_PSQL_STMT_UNPREPARABLE;
+  }
+
   /* give c_psql_write() a chance to acquire the lock if called recursively
    * through dispatch_values(); this will happen if, both, queries and
    * writers are configured for a single connection */
@@ -489,7 +648,21 @@ static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
     if ((CONNECTION_OK != PQstatus(db->conn)) &&
         (0 == c_psql_check_connection(db))) {
       PQclear(res);
-      return c_psql_exec_query(db, q, prep_area);
+      return c_psql_exec_query(db, idx);
+    }
+
+    /* The statement vanished from the session, e.g. because a connection
+     * pooler switched server connections behind our back. */
+    const char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+    if ((stmt != NULL) && (sqlstate != NULL) &&
+        (0 == strcmp(sqlstate, "26000"))) {
+      log_warn("Prepared statement of query \"%s\" does not exist. Sending "
+               "it as plain text from now on. Consider setting "
+               "\"PreparedStatements false\".",
+               udb_query_get_name(q));
+      db->q_stmts[idx].state = C_PSQL_STMT_UNPREPARABLE;
+      PQclear(res);
+      return c_psql_exec_query(db, idx);
     }
 
     log_err("Failed to execute SQL query: %s", PQerrorMessage(db->conn));
@@ -505,6 +678,16 @@ static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
   pthread_mutex_lock(&db->db_lock);                                            \
   return status
 
+  if (C_PSQL_IS_UNIX_DOMAIN_SOCKET(db->host) ||
+      (0 == strcmp(db->host, "127.0.0.1")) ||
+      (0 == strcmp(db->host, "localhost")))
+    host = hostname_g;
+  else
+    host = db->host;
+
+  if (db->report_query_time)
+    c_psql_submit_query_time(db, q, host, query_time);
+
   rows_num = PQntuples(res);
   if (1 > rows_num) {
     BAIL_OUT(0);
@@ -533,13 +716,6 @@ static int c_psql_exec_query(c_psql_database_t *db, udb_query_t *q,
     }
   }
 
-  if (C_PSQL_IS_UNIX_DOMAIN_SOCKET(db->host) ||
-      (0 == strcmp(db->host, "127.0.0.1")) ||
-      (0 == strcmp(db->host, "localhost")))
-    host = hostname_g;
-  else
-    host = db->host;
-
   status = udb_query_prepare_result(
       q, prep_area, host,
       (db->plugin_name != NULL) ? db->plugin_name : "postgresql", db->instance,
@@ -602,17 +778,11 @@ static int c_psql_read(user_data_t *ud) {
   }
 
   for (size_t i = 0; i < db->queries_num; ++i) {
-    udb_query_preparation_area_t *prep_area;
-    udb_query_t *q;
-
-    prep_area = db->q_prep_areas[i];
-    q = db->queries[i];
-
     if ((0 != db->server_version) &&
-        (udb_query_check_version(q, db->server_version) <= 0))
+        (udb_query_check_version(db->queries[i], db->server_version) <= 0))
       continue;
 
-    if (0 == c_psql_exec_query(db, q, prep_area))
+    if (0 == c_psql_exec_query(db, i))
       success = 1;
   }
 
@@ -1115,6 +1285,45 @@ static int c_psql_config_writer(oconfig_item_t *ci) {
   return 0;
 } /* c_psql_config_writer */
 
+/* Allocates the per-query state of `db' and registers its read callback. */
+static int c_psql_database_setup_queries(c_psql_database_t *db,
+                                         const char *cb_name,
+                                         cdtime_t interval) {
+  if (db->queries_num == 0)
+    return 0;
+
+  db->q_prep_areas = calloc(db->queries_num, sizeof(*db->q_prep_areas));
+  db->q_stmts = calloc(db->queries_num, sizeof(*db->q_stmts));
+  if ((db->q_prep_areas == NULL) || (db->q_stmts == NULL)) {
+    log_err("Out of memory.");
+    c_psql_database_delete(db);
+    return -1;
+  }
+
+  for (size_t i = 0; i < db->queries_num; ++i) {
+    c_psql_user_data_t *data;
+    data = udb_query_get_user_data(db->queries[i]);
+    if ((data != NULL) && (data->params_num > db->max_params_num))
+      db->max_params_num = data->params_num;
+
+    db->q_prep_areas[i] = udb_query_allocate_preparation_area(db->queries[i]);
+
+    if (db->q_prep_areas[i] == NULL) {
+      log_err("Out of memory.");
+      c_psql_database_delete(db);
+      return -1;
+    }
+  }
+
+  ++db->ref_cnt;
+  plugin_register_complex_read("postgresql", cb_name, c_psql_read, interval,
+                               &(user_data_t){
+                                   .data = db,
+                                   .free_func = c_psql_database_delete,
+                               });
+  return 0;
+} /* c_psql_database_setup_queries */
+
 static int c_psql_config_database(oconfig_item_t *ci) {
   c_psql_database_t *db;
 
@@ -1164,6 +1373,12 @@ static int c_psql_config_database(oconfig_item_t *ci) {
       cf_util_get_cdtime(c, &db->commit_interval);
     else if (strcasecmp("ExpireDelay", c->key) == 0)
       cf_util_get_cdtime(c, &db->expire_delay);
+    else if (strcasecmp("PreparedStatements", c->key) == 0)
+      cf_util_get_boolean(c, &db->prepared_statements);
+    else if (strcasecmp("ReportQueryTime", c->key) == 0)
+      cf_util_get_boolean(c, &db->report_query_time);
+    else if (strcasecmp("Connections", c->key) == 0)
+      cf_util_get_int(c, &db->connections);
     else
       log_warn("Ignoring unknown config key \"%s\".", c->key);
   }
@@ -1175,27 +1390,56 @@ static int c_psql_config_database(oconfig_item_t *ci) {
                                        &db->queries, &db->queries_num);
   }
 
-  if (db->queries_num > 0) {
-    db->q_prep_areas = calloc(db->queries_num, sizeof(*db->q_prep_areas));
-    if (db->q_prep_areas == NULL) {
-      log_err("Out of memory.");
-      c_psql_database_delete(db);
-      return -1;
-    }
+  if (db->connections < 1) {
+    log_warn("Database '%s': 'Connections' must be at least 1.",
+             db->database);
+    db->connections = 1;
   }
 
-  for (int i = 0; (size_t)i < db->queries_num; ++i) {
-    c_psql_user_data_t *data;
-    data = udb_query_get_user_data(db->queries[i]);
-    if ((data != NULL) && (data->params_num > db->max_params_num))
-      db->max_params_num = data->params_num;
+  /* Spread the queries over up to `Connections' database objects, each of
+   * which is read by its own read callback so that queries run in parallel.
+   * Writers only ever use the first connection. */
+  if ((size_t)db->connections > db->queries_num)
+    db->connections = (db->queries_num > 0) ? (int)db->queries_num : 1;
+
+  if (db->connections > 1) {
+    udb_query_t **all_queries = db->queries;
+    size_t all_queries_num = db->queries_num;
+    c_psql_database_t *pool[db->connections];
+
+    pool[0] = db;
+    for (int i = 1; i < db->connections; ++i) {
+      pool[i] = c_psql_database_clone(db);
+      if (pool[i] == NULL) {
+        log_err("Out of memory.");
+        db->connections = i;
+        break;
+      }
+    }
 
-    db->q_prep_areas[i] = udb_query_allocate_preparation_area(db->queries[i]);
+    db->queries = NULL;
+    db->queries_num = 0;
+    for (size_t i = 0; i < all_queries_num; ++i) {
+      c_psql_database_t *dst = pool[i % (size_t)db->connections];
+      udb_query_t **tmp = realloc(dst->queries,
+                                  (dst->queries_num + 1) * sizeof(*tmp));
+      if (tmp == NULL) {
+        log_err("Out of memory.");
+        sfree(all_queries);
+        /* No read callbacks have been registered yet. */
+        for (int j = 0; j < db->connections; ++j)
+          c_psql_database_delete(pool[j]);
+        return -1;
+      }
+      dst->queries = tmp;
+      dst->queries[dst->queries_num++] = all_queries[i];
+    }
+    sfree(all_queries);
 
-    if (db->q_prep_areas[i] == NULL) {
-      log_err("Out of memory.");
-      c_psql_database_delete(db);
-      return -1;
+    for (int i = 1; i < db->connections; ++i) {
+      char name[DATA_MAX_NAME_LEN];
+      ssnprintf(name, sizeof(name), "postgresql-%s-%d", db->instance, i);
+      c_psql_database_setup_queries(pool[i], name, interval);
     }
   }
 
@@ -1203,11 +1447,9 @@ static int c_psql_config_database(oconfig_item_t *ci) {
 
   user_data_t ud = {.data = db, .free_func = c_psql_database_delete};
 
-  if (db->queries_num > 0) {
-    ++db->ref_cnt;
-    plugin_register_complex_read("postgresql", cb_name, c_psql_read, interval,
-                                 &ud);
-  }
+  if (c_psql_database_setup_queries(db, cb_name, interval) != 0)
+    return -1;
+
   if (db->writers_num > 0) {
     ++db->ref_cnt;
     plugin_register_write(cb_name, c_psql_write, &ud);
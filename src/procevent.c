@@ -27,11 +27,14 @@
 #include "collectd.h"
 
 #include "plugin.h"
+#include "utils/avltree/avltree.h"
 #include "utils/common/common.h"
 #include "utils/ignorelist/ignorelist.h"
 #include "utils_complain.h"
 
+#include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
@@ -41,6 +44,7 @@
 #include <dirent.h>
 #include <linux/cn_proc.h>
 #include <linux/connector.h>
+#include <linux/filter.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <signal.h>
@@ -65,6 +69,11 @@
 #define RBUF_PROC_ID_INDEX 0
 #define RBUF_PROC_STATUS_INDEX 1
 #define RBUF_TIME_INDEX 2
+// Number of process names whose watch state is remembered
+#define PROCEVENT_COMM_CACHE_SIZE 1024
+// Offset of a proc_event field within a netlink message
+#define PROCEVENT_FIELD_OFFSET(field)                                          \
+  (NLMSG_HDRLEN + sizeof(struct cn_msg) + offsetof(struct proc_event, field))
 
 #define PROCEVENT_DOMAIN_FIELD "domain"
 #define PROCEVENT_DOMAIN_VALUE "fault"
@@ -122,6 +131,12 @@ struct processlist_s {
 };
 typedef struct processlist_s processlist_t;
 
+// Cached result of matching a process name against the configured processes
+typedef struct {
+  bool watched;
+  char process[];
+} comm_cache_entry_t;
+
 /*
  * Private variables
  */
@@ -139,6 +154,9 @@ static int nl_sock = -1;
 static int buffer_length;
 static circbuf_t ring;
 static processlist_t *processlist_head = NULL;
+static c_avl_tree_t *pid_index = NULL;  // pid -> processlist_t
+static c_avl_tree_t *comm_cache = NULL; // name -> comm_cache_entry_t
+static int proc_fd = -1;
 static int event_id = 0;
 
 static const char *config_keys[] = {"BufferLength", "Process", "ProcessRegex"};
@@ -425,49 +443,120 @@ err:
   return -1;
 }
 
-// Does /proc/<pid>/comm contain a process name we are interested in?
+static int pid_compare(const void *a, const void *b) {
+  long pid_a = *(const long *)a;
+  long pid_b = *(const long *)b;
+
+  return (pid_a > pid_b) - (pid_a < pid_b);
+}
+
+// Associates a processlist_t object with a pid (or with none, if pid is -1)
+// and keeps the pid index up to date.
 // NOTE: Caller MUST hold procevent_data_lock when calling this function
-static processlist_t *process_check(long pid) {
+static void process_set_pid(processlist_t *pl, long pid) {
+  processlist_t *indexed = NULL;
+
+  if (pl->pid != -1 &&
+      c_avl_get(pid_index, &pl->pid, (void **)&indexed) == 0 &&
+      indexed == pl)
+    c_avl_remove(pid_index, &pl->pid, NULL, NULL);
+
+  pl->pid = pid;
+
+  if (pid == -1)
+    return;
+
+  // A process that exec'd a different program may still be indexed under
+  // its old name
+  c_avl_remove(pid_index, &pl->pid, NULL, NULL);
+
+  if (c_avl_insert(pid_index, &pl->pid, pl) != 0)
+    ERROR("procevent plugin: unable to index PID %ld", pid);
+}
+
+// Reads the name of a process from /proc/<pid>/comm
+static int process_name(long pid, char *buffer, size_t buffer_size) {
   char file[BUFSIZE];
 
-  int len = snprintf(file, sizeof(file), PROCDIR "/%ld/comm", pid);
+  int len = snprintf(file, sizeof(file), "%ld/comm", pid);
 
   if ((len < 0) || (len >= BUFSIZE)) {
     WARNING("procevent process_check: process name too large");
-    return NULL;
+    return -1;
   }
 
-  FILE *fh;
+  int fd = openat(proc_fd, file, O_RDONLY | O_CLOEXEC);
 
-  if (NULL == (fh = fopen(file, "r"))) {
+  if (fd < 0) {
     // No /proc/<pid>/comm for this pid, just ignore
     DEBUG("procevent plugin: no comm file available for pid %ld", pid);
-    return NULL;
+    return -1;
   }
 
-  char buffer[BUFSIZE];
-  int retval = fscanf(fh, "%[^\n]", buffer);
+  ssize_t status = pread(fd, buffer, buffer_size - 1, 0);
+  close(fd);
 
-  if (retval < 0) {
+  if (status < 0) {
     WARNING("procevent process_check: unable to read comm file for pid %ld",
             pid);
-    fclose(fh);
-    return NULL;
+    return -1;
+  }
+
+  buffer[status] = '\0';
+
+  char *newline = strchr(buffer, '\n');
+  if (newline != NULL)
+    *newline = '\0';
+
+  return 0;
+}
+
+// Is a process with this name of interest to us?  Processes are started
+// under the same few names over and over again, so the answer is cached.
+// NOTE: Caller MUST hold procevent_data_lock when calling this function
+static bool process_watched(const char *process) {
+  comm_cache_entry_t *entry = NULL;
+
+  if (c_avl_get(comm_cache, process, (void **)&entry) == 0)
+    return entry->watched;
+
+  bool watched = (ignorelist_match(ignorelist, process) == 0);
+
+  if (c_avl_size(comm_cache) >= PROCEVENT_COMM_CACHE_SIZE) {
+    void *key;
+    while (c_avl_pick(comm_cache, &key, (void **)&entry) == 0)
+      sfree(entry);
   }
 
+  size_t len = strlen(process);
+  entry = malloc(sizeof(*entry) + len + 1);
+  if (entry == NULL)
+    return watched;
+
+  entry->watched = watched;
+  memcpy(entry->process, process, len + 1);
+
+  if (c_avl_insert(comm_cache, entry->process, entry) != 0)
+    sfree(entry);
+
+  return watched;
+}
+
+// Does /proc/<pid>/comm contain a process name we are interested in?
+// NOTE: Caller MUST hold procevent_data_lock when calling this function
+static processlist_t *process_check(long pid) {
+  char buffer[BUFSIZE];
+
+  if (process_name(pid, buffer, sizeof(buffer)) != 0)
+    return NULL;
+
   // Now that we have the process name in the buffer, check if we are
   // even interested in it
-  if (ignorelist_match(ignorelist, buffer) != 0) {
+  if (!process_watched(buffer)) {
     DEBUG("procevent process_check: ignoring process %s (%ld)", buffer, pid);
-    fclose(fh);
     return NULL;
   }
 
-  if (fh != NULL) {
-    fclose(fh);
-    fh = NULL;
-  }
-
   //
   // Go through the processlist linked list and look for the process name
   // in /proc/<pid>/comm.  If found:
@@ -500,7 +589,7 @@ static processlist_t *process_check(long pid) {
         DEBUG("procevent plugin: reusing pl object with PID %ld for incoming "
               "PID %ld",
               pl->pid, pid);
-        pl->pid = pid;
+        process_set_pid(pl, pid);
         match = pl;
         break;
       } else if (pl->pid != -1) {
@@ -543,9 +632,10 @@ static processlist_t *process_check(long pid) {
     }
 
     pl2->process = process;
-    pl2->pid = pid;
+    pl2->pid = -1;
     pl2->next = processlist_head;
     processlist_head = pl2;
+    process_set_pid(pl2, pid);
 
     match = pl2;
   }
@@ -553,38 +643,15 @@ static processlist_t *process_check(long pid) {
   return match;
 }
 
-// Does our map have this PID or name?
+// Does our map have this PID?
 // NOTE: Caller MUST hold procevent_data_lock when calling this function
-static processlist_t *process_map_check(long pid, char *process) {
-  for (processlist_t *pl = processlist_head; pl != NULL; pl = pl->next) {
-    int match_pid = 0;
-
-    if (pid > 0) {
-      if (pl->pid == pid)
-        match_pid = 1;
-    }
-
-    int match_process = 0;
-
-    if (process != NULL) {
-      if (strcmp(pl->process, process) == 0)
-        match_process = 1;
-    }
-
-    int match = 0;
+static processlist_t *process_map_check(long pid) {
+  processlist_t *pl = NULL;
 
-    if ((pid > 0 && process == NULL && match_pid == 1) ||
-        (pid < 0 && process != NULL && match_process == 1) ||
-        (pid > 0 && process != NULL && match_pid == 1 && match_process == 1)) {
-      match = 1;
-    }
-
-    if (match == 1) {
-      return pl;
-    }
-  }
+  if (c_avl_get(pid_index, &pid, (void **)&pl) != 0)
+    return NULL;
 
-  return NULL;
+  return pl;
 }
 
 static int process_map_refresh(void) {
@@ -662,6 +729,38 @@ static int process_map_refresh(void) {
   return 0;
 }
 
+// Lets the kernel discard all process events but EXECs and the EXITs of
+// whole processes, so that e.g. forks and thread exits never reach us
+static int nl_attach_filter(void) {
+  struct sock_filter filter[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, PROCEVENT_FIELD_OFFSET(what)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(PROC_EVENT_EXEC), 6, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(PROC_EVENT_EXIT), 0, 6),
+      // EXIT: accept if process_pid == process_tgid
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+               PROCEVENT_FIELD_OFFSET(event_data.exit.process_tgid)),
+      BPF_STMT(BPF_ST, 0),
+      BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, 0),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+               PROCEVENT_FIELD_OFFSET(event_data.exit.process_pid)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_X, 0, 0, 1),
+      BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+      BPF_STMT(BPF_RET | BPF_K, 0),
+  };
+  struct sock_fprog fprog = {
+      .len = STATIC_ARRAY_SIZE(filter),
+      .filter = filter,
+  };
+
+  if (setsockopt(nl_sock, SOL_SOCKET, SO_ATTACH_FILTER, &fprog,
+                 sizeof(fprog)) != 0) {
+    WARNING("procevent plugin: attaching socket filter failed: %s", STRERRNO);
+    return -1;
+  }
+
+  return 0;
+}
+
 static int nl_connect() {
   struct sockaddr_nl sa_nl = {
       .nl_family = AF_NETLINK,
@@ -683,6 +782,9 @@ static int nl_connect() {
     return -1;
   }
 
+  // Not fatal: uninteresting events are also discarded in read_event()
+  nl_attach_filter();
+
   return 0;
 }
 
@@ -784,6 +886,11 @@ static int read_event() {
       proc_id = nlcn_msg.proc_ev.event_data.exec.process_pid;
       break;
     case PROC_EVENT_EXIT:
+      // Only the exit of a whole process is of interest, not that of one of
+      // its threads
+      if (nlcn_msg.proc_ev.event_data.exit.process_pid !=
+          nlcn_msg.proc_ev.event_data.exit.process_tgid)
+        break;
       proc_id = nlcn_msg.proc_ev.event_data.exit.process_pid;
       proc_status = PROCEVENT_EXITED;
       break;
@@ -887,7 +994,7 @@ static void read_ring_buffer() {
       next = 0;
 
     if (ring.buffer[ring.tail][RBUF_PROC_STATUS_INDEX] == PROCEVENT_EXITED) {
-      processlist_t *pl = process_map_check(ring.buffer[ring.tail][0], NULL);
+      processlist_t *pl = process_map_check(ring.buffer[ring.tail][0]);
 
       if (pl != NULL) {
         // This process is of interest to us, so publish its EXITED status
@@ -899,7 +1006,7 @@ static void read_ring_buffer() {
             "procevent plugin: PID %ld (%s) EXITED, removing PID from process "
             "list",
             pl->pid, pl->process);
-        pl->pid = -1;
+        process_set_pid(pl, -1);
         pl->last_status = -1;
       }
     } else if (ring.buffer[ring.tail][RBUF_PROC_STATUS_INDEX] ==
@@ -1196,6 +1303,23 @@ static int procevent_init(void) /* {{{ */
     ring.buffer[i] = (cdtime_t *)calloc(PROCEVENT_FIELDS, sizeof(cdtime_t));
   }
 
+  pid_index = c_avl_create(pid_compare);
+  comm_cache = c_avl_create((int (*)(const void *, const void *))strcmp);
+
+  if (pid_index == NULL || comm_cache == NULL) {
+    ERROR("procevent plugin: c_avl_create failed.");
+    return -1;
+  }
+
+  if (proc_fd == -1) {
+    proc_fd = open(PROCDIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (proc_fd == -1) {
+      ERROR("procevent plugin: open (%s): %s", PROCDIR, STRERRNO);
+      return -1;
+    }
+  }
+
   int status = process_map_refresh();
 
   if (status == -1) {
@@ -1277,6 +1401,27 @@ static int procevent_shutdown(void) /* {{{ */
 
   free(ring.buffer);
 
+  if (comm_cache != NULL) {
+    void *key;
+    comm_cache_entry_t *entry;
+
+    while (c_avl_pick(comm_cache, &key, (void **)&entry) == 0)
+      sfree(entry);
+
+    c_avl_destroy(comm_cache);
+    comm_cache = NULL;
+  }
+
+  if (pid_index != NULL) {
+    c_avl_destroy(pid_index);
+    pid_index = NULL;
+  }
+
+  if (proc_fd != -1) {
+    close(proc_fd);
+    proc_fd = -1;
+  }
+
   processlist_t *pl = processlist_head;
   while (pl != NULL) {
     processlist_t *pl_next;
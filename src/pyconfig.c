@@ -129,31 +129,23 @@ static int Config_init(PyObject *s, PyObject *args, PyObject *kwds) {
 static PyObject *Config_repr(PyObject *s) {
   Config *self = (Config *)s;
   PyObject *ret = NULL;
-  static PyObject *node_prefix, *root_prefix, *ending;
-
-  /* This is ok because we have the GIL, so this is thread-save by default. */
-  if (node_prefix == NULL)
-    node_prefix = cpy_string_to_unicode_or_bytes("<collectd.Config node ");
-  if (root_prefix == NULL)
-    root_prefix = cpy_string_to_unicode_or_bytes("<collectd.Config root node ");
-  if (ending == NULL)
-    ending = cpy_string_to_unicode_or_bytes(">");
-  if (node_prefix == NULL || root_prefix == NULL || ending == NULL)
-    return NULL;
 
   ret = PyObject_Str(self->key);
   CPY_SUBSTITUTE(PyObject_Repr, ret, ret);
   if (self->parent == NULL || self->parent == Py_None)
-    CPY_STRCAT(&ret, root_prefix);
+    cpy_strcat_string(&ret, "<collectd.Config root node ");
   else
-    CPY_STRCAT(&ret, node_prefix);
-  CPY_STRCAT(&ret, ending);
+    cpy_strcat_string(&ret, "<collectd.Config node ");
+  cpy_strcat_string(&ret, ">");
 
   return ret;
 }
 
 static int Config_traverse(PyObject *self, visitproc visit, void *arg) {
   Config *c = (Config *)self;
+#ifdef CPY_SUB_INTERPRETERS
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(c->parent);
   Py_VISIT(c->key);
   Py_VISIT(c->values);
@@ -171,8 +163,13 @@ static int Config_clear(PyObject *self) {
 }
 
 static void Config_dealloc(PyObject *self) {
+  PyTypeObject *type = Py_TYPE(self);
+
   Config_clear(self);
-  self->ob_type->tp_free(self);
+  type->tp_free(self);
+#ifdef CPY_SUB_INTERPRETERS
+  Py_DECREF(type); /* Instances of heap types hold a reference. */
+#endif
 }
 
 static PyMemberDef Config_members[] = {
@@ -182,6 +179,22 @@ static PyMemberDef Config_members[] = {
     {"children", T_OBJECT_EX, offsetof(Config, children), 0, children_doc},
     {NULL}};
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot Config_slots[] = {
+    {Py_tp_dealloc, Config_dealloc},   {Py_tp_repr, Config_repr},
+    {Py_tp_doc, config_doc},           {Py_tp_traverse, Config_traverse},
+    {Py_tp_clear, Config_clear},       {Py_tp_members, Config_members},
+    {Py_tp_init, Config_init},         {Py_tp_new, Config_new},
+    {0, NULL}};
+
+PyType_Spec Config_spec = {
+    .name = "collectd.Config",
+    .basicsize = sizeof(Config),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = Config_slots,
+};
+#else
 PyTypeObject ConfigType = {
     CPY_INIT_TYPE "collectd.Config", /* tp_name */
     sizeof(Config),                  /* tp_basicsize */
@@ -221,3 +234,4 @@ PyTypeObject ConfigType = {
     0,               /* tp_alloc */
     Config_new       /* tp_new */
 };
+#endif
@@ -35,10 +35,63 @@
 
 #include "cpython.h"
 
+/* Copies of value lists to be passed to a batched write callback. */
+typedef struct {
+  value_list_t *vl;
+  const data_set_t **ds;
+  size_t num;
+} cpy_write_items_t;
+
+/* Value lists queued for a write callback registered with a batch size. A
+ * read callback, the "timer", passes on partial batches after the timeout.
+ * The write callback and the timer each hold a reference to the callback. */
+typedef struct cpy_write_batch_s {
+  pthread_mutex_t lock;
+  cpy_write_items_t items; /* Allocated when the first value list is queued */
+  size_t size;
+  cdtime_t timeout;
+  cdtime_t first; /* Time the oldest queued value list has been queued */
+  int refs;
+  char timer_name[512 + sizeof(".batch")];
+} cpy_write_batch_t;
+
+/* An interpreter callbacks are run in. All modules share the main
+ * interpreter unless "SubInterpreters" is enabled, in which case every
+ * imported module gets its own one, with its own GIL. */
+typedef struct cpy_interp_s {
+  char *name;
+  cpy_state_t state;          /* Objects of the "collectd" module. */
+  PyObject *format_exception; /* Loaded on first use, see "LogTraces". */
+#ifdef CPY_SUB_INTERPRETERS
+  PyInterpreterState *interp;
+  PyThreadState *thread_state; /* Thread state it was created with. */
+  /* Thread states of other threads, see cpy_interp_thread_state(). */
+  pthread_key_t thread_key;
+  PyThreadState **threads;
+  size_t threads_num;
+#endif
+  /* Callback statistics, guarded by cpy_data_lock. */
+  derive_t calls;
+  cdtime_t run_time;
+  cdtime_t wait_time;
+  struct cpy_interp_s *next;
+} cpy_interp_t;
+
+/* Holds the GIL of an interpreter, see cpy_interp_lock(). */
+typedef struct {
+  cpy_interp_t *interp;
+  PyGILState_STATE gil_state;
+  PyThreadState *saved; /* Thread state of another interpreter. */
+  bool nested;
+  cdtime_t start;
+} cpy_lock_t;
+
 typedef struct cpy_callback_s {
   char *name;
   PyObject *callback;
   PyObject *data;
+  cpy_interp_t *interp;
+  cpy_write_batch_t *batch;
   struct cpy_callback_s *next;
 } cpy_callback_t;
 
@@ -152,7 +205,8 @@ static char reg_read_doc[] =
     "data if it was supplied.";
 
 static char reg_write_doc[] =
-    "register_write(callback[, data][, name]) -> identifier\n"
+    "register_write(callback[, data][, name][, batch_size][, batch_timeout])"
+    " -> identifier\n"
     "\n"
     "Register a callback function to receive values dispatched by other "
     "plugins.\n"
@@ -167,11 +221,27 @@ static char reg_write_doc[] =
     "    to specify a name here.\n"
     "'identifier' is the full identifier assigned to this callback.\n"
     "\n"
+    "'batch_size' is an optional number of value lists to deliver at once.\n"
+    "    If greater than zero, the callback receives a list of Values\n"
+    "    objects instead of a single one.\n"
+    "'batch_timeout' is the maximum time in seconds a value list is kept\n"
+    "    back before a partial batch is delivered. Defaults to the interval.\n"
+    "\n"
     "The callback function will be called with one or two parameters:\n"
-    "values: A Values object which is a copy of the dispatched values.\n"
+    "values: A Values object which is a copy of the dispatched values, or a\n"
+    "    list of them if 'batch_size' was given.\n"
     "data: The optional data parameter passed to the register function.\n"
     "    If the parameter was omitted it will be omitted here, too.";
 
+static char dispatch_many_doc[] =
+    "dispatch_many(values) -> None.  Dispatch multiple value lists.\n"
+    "\n"
+    "'values' is a sequence of Values objects. Every object is dispatched as\n"
+    "if its dispatch method was called without arguments, but the GIL is\n"
+    "released only once for the whole sequence. The 'values' member of the\n"
+    "objects may also be an object supporting the buffer protocol, e.g. an\n"
+    "array.array.";
+
 static char reg_notification_doc[] =
     "register_notification(callback[, data][, name]) -> identifier\n"
     "\n"
@@ -250,29 +320,251 @@ static bool do_interactive;
 
 static PyThreadState *state;
 
-static PyObject *sys_path, *cpy_format_exception, *CollectdError;
+static PyObject *sys_path;
 
 static cpy_callback_t *cpy_config_callbacks;
 static cpy_callback_t *cpy_init_callbacks;
 static cpy_callback_t *cpy_shutdown_callbacks;
 
-/* Make sure to hold the GIL while modifying these. */
+/* Each interpreter may have its own GIL, so data used by all of them is
+ * guarded by this lock instead. Python code is never run while holding it.
+ * It guards the lists above and these: */
+static pthread_mutex_t cpy_data_lock = PTHREAD_MUTEX_INITIALIZER;
 static int cpy_shutdown_triggered;
 static int cpy_num_callbacks;
 
+/* Sub-interpreters are linked after the main interpreter. The list is only
+ * changed while reading the config and when shutting down. */
+static cpy_interp_t cpy_main_interp;
+static bool cpy_sub_interpreters;
+static char **cpy_module_paths;
+static size_t cpy_module_paths_num;
+
+static bool cpy_log_traces;
+static bool cpy_statistics;
+
+/* Returns the interpreter of the calling thread, or NULL if it is not one of
+ * ours. You must hold the GIL. */
+static cpy_interp_t *cpy_interp_current(void) {
+#ifdef CPY_SUB_INTERPRETERS
+  PyInterpreterState *interp = PyInterpreterState_Get();
+
+  for (cpy_interp_t *i = &cpy_main_interp; i != NULL; i = i->next)
+    if (i->interp == interp)
+      return i;
+  return NULL;
+#else
+  return &cpy_main_interp;
+#endif
+}
+
+cpy_state_t *cpy_get_state(void) { return &cpy_interp_current()->state; }
+
+#ifdef CPY_SUB_INTERPRETERS
+/* Returns the thread state of the calling thread if it holds a GIL. */
+static PyThreadState *cpy_thread_state(void) {
+#if PY_VERSION_HEX >= 0x030D0000
+  return PyThreadState_GetUnchecked();
+#else
+  return _PyThreadState_UncheckedGet();
+#endif
+}
+
+/* Returns the thread state of the calling thread in "interp", creating it if
+ * necessary. The PyGILState API can't be used for this: activating a thread
+ * state makes it the one PyGILState_Ensure() returns, whatever its
+ * interpreter. */
+static PyThreadState *cpy_interp_thread_state(cpy_interp_t *interp) {
+  PyThreadState *ts = pthread_getspecific(interp->thread_key);
+  if (ts != NULL)
+    return ts;
+
+  pthread_mutex_lock(&cpy_data_lock);
+  PyThreadState **tmp = realloc(interp->threads, (interp->threads_num + 1) *
+                                                     sizeof(*interp->threads));
+  if (tmp != NULL) {
+    interp->threads = tmp;
+    ts = PyThreadState_New(interp->interp);
+    if (ts != NULL)
+      interp->threads[interp->threads_num++] = ts;
+  }
+  pthread_mutex_unlock(&cpy_data_lock);
+
+  if (ts != NULL)
+    pthread_setspecific(interp->thread_key, ts);
+  return ts;
+}
+#endif
+
+/* Acquires the GIL of "interp" and makes it the current interpreter of the
+ * calling thread. If the thread holds the GIL of another interpreter, e.g.
+ * because Python code logged a message, that one is released meanwhile. */
+static void cpy_interp_lock(cpy_interp_t *interp, cpy_lock_t *lock) {
+  cdtime_t start = cpy_statistics ? cdtime() : 0;
+
+  *lock = (cpy_lock_t){.interp = interp};
+#ifdef CPY_SUB_INTERPRETERS
+  PyThreadState *current = cpy_thread_state();
+  if (current != NULL &&
+      PyThreadState_GetInterpreter(current) == interp->interp) {
+    lock->nested = true;
+  } else {
+    if (current != NULL)
+      lock->saved = PyEval_SaveThread();
+    PyEval_RestoreThread(cpy_interp_thread_state(interp));
+  }
+#else
+  lock->gil_state = PyGILState_Ensure();
+#endif
+
+  if (cpy_statistics) {
+    lock->start = cdtime();
+    pthread_mutex_lock(&cpy_data_lock);
+    interp->wait_time += lock->start - start;
+    pthread_mutex_unlock(&cpy_data_lock);
+  }
+}
+
+static void cpy_interp_unlock(cpy_lock_t *lock) {
+  cpy_interp_t *interp = lock->interp;
+
+  if (cpy_statistics) {
+    cdtime_t run_time = cdtime() - lock->start;
+    pthread_mutex_lock(&cpy_data_lock);
+    interp->calls++;
+    interp->run_time += run_time;
+    pthread_mutex_unlock(&cpy_data_lock);
+  }
+
+#ifdef CPY_SUB_INTERPRETERS
+  if (!lock->nested)
+    PyEval_SaveThread();
+  if (lock->saved != NULL)
+    PyEval_RestoreThread(lock->saved);
+#else
+  PyGILState_Release(lock->gil_state);
+#endif
+}
+
+/* Like CPY_LOCK_THREADS, but runs the enclosed code in "interp" and updates
+ * its callback statistics. */
+#define CPY_LOCK_INTERP(interp)                                                \
+  {                                                                            \
+    cpy_lock_t cpy_lock;                                                       \
+    cpy_interp_lock((interp), &cpy_lock);
+
+#define CPY_RETURN_FROM_INTERP                                                 \
+  cpy_interp_unlock(&cpy_lock);                                                \
+  return
+
+#define CPY_RELEASE_INTERP                                                     \
+  cpy_interp_unlock(&cpy_lock);                                                \
+  }
+
+#ifdef CPY_SUB_INTERPRETERS
+/* Drops the references to the objects of "interp" and deletes the thread
+ * states of threads other than the one it was created in. You must hold its
+ * GIL. */
+static void cpy_interp_clear(cpy_interp_t *interp) {
+  cpy_state_t *st = &interp->state;
+
+  for (size_t i = 0; i < interp->threads_num; ++i) {
+    PyThreadState_Clear(interp->threads[i]);
+    PyThreadState_Delete(interp->threads[i]);
+  }
+  sfree(interp->threads);
+  interp->threads_num = 0;
+  pthread_key_delete(interp->thread_key);
+
+  Py_CLEAR(st->config_type);
+  Py_CLEAR(st->plugin_data_type);
+  Py_CLEAR(st->values_type);
+  Py_CLEAR(st->notification_type);
+  Py_CLEAR(st->signed_type);
+  Py_CLEAR(st->unsigned_type);
+  Py_CLEAR(st->error);
+  Py_CLEAR(interp->format_exception);
+}
+#endif
+
+/* Ends the sub-interpreters and shuts Python down. You must not hold the
+ * GIL. */
+static void cpy_finalize(void) {
+#ifdef CPY_SUB_INTERPRETERS
+  while (cpy_main_interp.next != NULL) {
+    cpy_interp_t *i = cpy_main_interp.next;
+    cpy_main_interp.next = i->next;
+
+    PyEval_RestoreThread(i->thread_state);
+    cpy_interp_clear(i);
+    /* Like Py_Finalize(), this waits for threads started by Python code. */
+    Py_EndInterpreter(i->thread_state);
+
+    free(i->name);
+    free(i);
+  }
+
+  PyEval_RestoreThread(cpy_main_interp.thread_state);
+  cpy_interp_clear(&cpy_main_interp);
+#else
+  PyGILState_Ensure();
+#endif
+
+  Py_Finalize();
+}
+
+/* Accounts a registered callback. */
+static void cpy_callback_added(void) {
+  pthread_mutex_lock(&cpy_data_lock);
+  ++cpy_num_callbacks;
+  pthread_mutex_unlock(&cpy_data_lock);
+}
+
+/* Returns the callback following "c" in the list, or the first one if "c" is
+ * NULL. The lock is not held while running the callbacks, as they may
+ * register further ones. */
+static cpy_callback_t *cpy_callback_next(cpy_callback_t **list_head,
+                                         cpy_callback_t *c) {
+  pthread_mutex_lock(&cpy_data_lock);
+  c = (c == NULL) ? *list_head : c->next;
+  pthread_mutex_unlock(&cpy_data_lock);
+  return c;
+}
+
+static cpy_write_items_t cpy_write_batch_take(cpy_write_batch_t *b);
+static void cpy_write_batch_deliver(cpy_callback_t *c,
+                                    cpy_write_items_t *items);
+
+static void cpy_write_batch_destroy(cpy_write_batch_t *b) {
+  if (b == NULL)
+    return;
+
+  pthread_mutex_destroy(&b->lock);
+  free(b);
+}
+
 static void cpy_destroy_user_data(void *data) {
   cpy_callback_t *c = data;
+  if (c->batch != NULL) {
+    /* Deliver what's left before the callback goes away. */
+    pthread_mutex_lock(&c->batch->lock);
+    cpy_write_items_t items = cpy_write_batch_take(c->batch);
+    pthread_mutex_unlock(&c->batch->lock);
+    cpy_write_batch_deliver(c, &items);
+    cpy_write_batch_destroy(c->batch);
+  }
   free(c->name);
-  CPY_LOCK_THREADS
+  CPY_LOCK_INTERP(c->interp)
   Py_DECREF(c->callback);
   Py_XDECREF(c->data);
+  CPY_RELEASE_INTERP
   free(c);
-  --cpy_num_callbacks;
-  if (!cpy_num_callbacks && cpy_shutdown_triggered) {
-    Py_Finalize();
-    return;
-  }
-  CPY_RELEASE_THREADS
+
+  pthread_mutex_lock(&cpy_data_lock);
+  bool finalize = (--cpy_num_callbacks == 0) && cpy_shutdown_triggered;
+  pthread_mutex_unlock(&cpy_data_lock);
+  if (finalize)
+    cpy_finalize();
 }
 
 /* You must hold the GIL to call this function!
@@ -305,16 +597,37 @@ static void cpy_build_name(char *buf, size_t size, PyObject *callback,
   PyErr_Clear();
 }
 
+/* Returns traceback.format_exception() of the current interpreter if
+ * "LogTraces" is enabled. Returns a borrowed reference. */
+static PyObject *cpy_format_exception(void) {
+  cpy_interp_t *interp = cpy_interp_current();
+  PyObject *tb;
+
+  if (!cpy_log_traces)
+    return NULL;
+  if (interp->format_exception != NULL)
+    return interp->format_exception;
+
+  tb = PyImport_ImportModule("traceback"); /* New reference. */
+  if (tb != NULL) {
+    interp->format_exception =
+        PyObject_GetAttrString(tb, "format_exception"); /* New reference. */
+    Py_DECREF(tb);
+  }
+  PyErr_Clear();
+  return interp->format_exception;
+}
+
 void cpy_log_exception(const char *context) {
   int l = 0, collectd_error;
   const char *typename = NULL, *message = NULL;
-  PyObject *type, *value, *traceback, *tn, *m, *list;
+  PyObject *type, *value, *traceback, *tn, *m, *list, *format_exception;
 
   PyErr_Fetch(&type, &value, &traceback);
   PyErr_NormalizeException(&type, &value, &traceback);
   if (type == NULL)
     return;
-  collectd_error = PyErr_GivenExceptionMatches(value, CollectdError);
+  collectd_error = PyErr_GivenExceptionMatches(value, cpy_get_state()->error);
   tn = PyObject_GetAttrString(type, "__name__"); /* New reference. */
   m = PyObject_Str(value);                       /* New reference. */
   if (tn != NULL)
@@ -335,14 +648,15 @@ void cpy_log_exception(const char *context) {
   Py_END_ALLOW_THREADS;
   Py_XDECREF(tn);
   Py_XDECREF(m);
-  if (!cpy_format_exception || !traceback || collectd_error) {
+  format_exception = cpy_format_exception(); /* Borrowed reference. */
+  if (!format_exception || !traceback || collectd_error) {
     PyErr_Clear();
     Py_DECREF(type);
     Py_XDECREF(value);
     Py_XDECREF(traceback);
     return;
   }
-  list = PyObject_CallFunction(cpy_format_exception, "NNN", type, value,
+  list = PyObject_CallFunction(format_exception, "NNN", type, value,
                                traceback); /* New reference. Steals references
                                               from "type", "value" and
                                               "traceback". */
@@ -384,7 +698,7 @@ static int cpy_read_callback(user_data_t *data) {
   cpy_callback_t *c = data->data;
   PyObject *ret;
 
-  CPY_LOCK_THREADS
+  CPY_LOCK_INTERP(c->interp)
   ret = PyObject_CallFunctionObjArgs(c->callback, c->data,
                                      (void *)0); /* New reference. */
   if (ret == NULL) {
@@ -392,25 +706,22 @@ static int cpy_read_callback(user_data_t *data) {
   } else {
     Py_DECREF(ret);
   }
-  CPY_RELEASE_THREADS
+  CPY_RELEASE_INTERP
   if (ret == NULL)
     return 1;
   return 0;
 }
 
-static int cpy_write_callback(const data_set_t *ds,
-                              const value_list_t *value_list,
-                              user_data_t *data) {
-  cpy_callback_t *c = data->data;
-  PyObject *ret, *list, *temp, *dict = NULL;
+/* Builds a Values object from a value list. You must hold the GIL. Returns a
+ * new reference or NULL with an exception set. */
+static PyObject *cpy_values_from_value_list(const data_set_t *ds,
+                                            const value_list_t *value_list) {
+  PyObject *list, *temp, *dict = NULL;
   Values *v;
 
-  CPY_LOCK_THREADS
   list = PyList_New(value_list->values_len); /* New reference. */
-  if (list == NULL) {
-    cpy_log_exception("write callback");
-    CPY_RETURN_FROM_THREADS 0;
-  }
+  if (list == NULL)
+    return NULL;
   for (size_t i = 0; i < value_list->values_len; ++i) {
     if (ds->ds[i].type == DS_TYPE_COUNTER) {
       PyList_SetItem(
@@ -424,16 +735,14 @@ static int cpy_write_callback(const data_set_t *ds,
       PyList_SetItem(
           list, i, PyLong_FromUnsignedLongLong(value_list->values[i].absolute));
     } else {
-      Py_BEGIN_ALLOW_THREADS;
-      ERROR("cpy_write_callback: Unknown value type %d.", ds->ds[i].type);
-      Py_END_ALLOW_THREADS;
+      PyErr_Format(PyExc_RuntimeError, "Unknown value type %d.",
+                   ds->ds[i].type);
       Py_DECREF(list);
-      CPY_RETURN_FROM_THREADS 0;
+      return NULL;
     }
     if (PyErr_Occurred() != NULL) {
-      cpy_log_exception("value building for write callback");
       Py_DECREF(list);
-      CPY_RETURN_FROM_THREADS 0;
+      return NULL;
     }
   }
   dict = PyDict_New(); /* New reference. */
@@ -462,8 +771,9 @@ static int cpy_write_callback(const data_set_t *ds,
         if (meta_data_get_signed_int(meta, table[i], &si))
           continue;
         PyObject *sival = PyLong_FromLongLong(si); /* New reference */
-        temp = PyObject_CallFunctionObjArgs((void *)&SignedType, sival,
-                                            (void *)0); /* New reference. */
+        temp = PyObject_CallFunctionObjArgs(
+            (void *)cpy_get_state()->signed_type, sival,
+            (void *)0); /* New reference. */
         PyDict_SetItemString(dict, table[i], temp);
         Py_XDECREF(temp);
         Py_XDECREF(sival);
@@ -471,8 +781,9 @@ static int cpy_write_callback(const data_set_t *ds,
         if (meta_data_get_unsigned_int(meta, table[i], &ui))
           continue;
         PyObject *uval = PyLong_FromUnsignedLongLong(ui); /* New reference */
-        temp = PyObject_CallFunctionObjArgs((void *)&UnsignedType, uval,
-                                            (void *)0); /* New reference. */
+        temp = PyObject_CallFunctionObjArgs(
+            (void *)cpy_get_state()->unsigned_type, uval,
+            (void *)0); /* New reference. */
         PyDict_SetItemString(dict, table[i], temp);
         Py_XDECREF(temp);
         Py_XDECREF(uval);
@@ -495,6 +806,11 @@ static int cpy_write_callback(const data_set_t *ds,
     free(table);
   }
   v = (Values *)Values_New(); /* New reference. */
+  if (v == NULL) {
+    Py_DECREF(list);
+    Py_XDECREF(dict);
+    return NULL;
+  }
   sstrncpy(v->data.host, value_list->host, sizeof(v->data.host));
   sstrncpy(v->data.type, value_list->type, sizeof(v->data.type));
   sstrncpy(v->data.type_instance, value_list->type_instance,
@@ -508,6 +824,21 @@ static int cpy_write_callback(const data_set_t *ds,
   v->values = list;
   Py_CLEAR(v->meta);
   v->meta = dict; /* Steals a reference. */
+  return (PyObject *)v;
+}
+
+static int cpy_write_callback(const data_set_t *ds,
+                              const value_list_t *value_list,
+                              user_data_t *data) {
+  cpy_callback_t *c = data->data;
+  PyObject *ret, *v;
+
+  CPY_LOCK_INTERP(c->interp)
+  v = cpy_values_from_value_list(ds, value_list); /* New reference. */
+  if (v == NULL) {
+    cpy_log_exception("value building for write callback");
+    CPY_RETURN_FROM_INTERP 0;
+  }
   ret = PyObject_CallFunctionObjArgs(c->callback, v, c->data,
                                      (void *)0); /* New reference. */
   Py_XDECREF(v);
@@ -516,17 +847,161 @@ static int cpy_write_callback(const data_set_t *ds,
   } else {
     Py_DECREF(ret);
   }
-  CPY_RELEASE_THREADS
+  CPY_RELEASE_INTERP
   return 0;
 }
 
+/* Moves the queued value lists out of the batch, so that they can be
+ * delivered after releasing the batch lock. You must hold the batch lock. */
+static cpy_write_items_t cpy_write_batch_take(cpy_write_batch_t *b) {
+  cpy_write_items_t items = b->items;
+  b->items = (cpy_write_items_t){0};
+  return items;
+}
+
+/* Passes the value lists to the callback as one list and frees them. You must
+ * not hold the batch lock, as the write threads take it without the GIL. */
+static void cpy_write_batch_deliver(cpy_callback_t *c,
+                                    cpy_write_items_t *items) {
+  PyObject *ret, *list;
+
+  if (items->num == 0) {
+    free(items->vl);
+    free(items->ds);
+    return;
+  }
+
+  CPY_LOCK_INTERP(c->interp)
+  list = PyList_New(items->num); /* New reference. */
+  for (size_t i = 0; list != NULL && i < items->num; ++i) {
+    PyObject *v = cpy_values_from_value_list(items->ds[i], &items->vl[i]);
+    if (v == NULL)
+      Py_CLEAR(list);
+    else
+      PyList_SET_ITEM(list, i, v); /* Steals a reference. */
+  }
+  if (list == NULL) {
+    cpy_log_exception("value building for write callback");
+  } else {
+    ret = PyObject_CallFunctionObjArgs(c->callback, list, c->data,
+                                       (void *)0); /* New reference. */
+    Py_DECREF(list);
+    if (ret == NULL) {
+      cpy_log_exception("write callback");
+    } else {
+      Py_DECREF(ret);
+    }
+  }
+  CPY_RELEASE_INTERP
+
+  for (size_t i = 0; i < items->num; ++i) {
+    meta_data_destroy(items->vl[i].meta);
+    sfree(items->vl[i].values);
+  }
+  free(items->vl);
+  free(items->ds);
+  *items = (cpy_write_items_t){0};
+}
+
+static int cpy_write_batch_callback(const data_set_t *ds,
+                                    const value_list_t *value_list,
+                                    user_data_t *data) {
+  cpy_callback_t *c = data->data;
+  cpy_write_batch_t *b = c->batch;
+  cdtime_t now = cdtime();
+
+  pthread_mutex_lock(&b->lock);
+
+  if (b->items.vl == NULL) {
+    b->items.vl = calloc(b->size, sizeof(*b->items.vl));
+    b->items.ds = calloc(b->size, sizeof(*b->items.ds));
+    if (b->items.vl == NULL || b->items.ds == NULL) {
+      sfree(b->items.vl);
+      sfree(b->items.ds);
+      pthread_mutex_unlock(&b->lock);
+      ERROR("python plugin: cpy_write_batch_callback: calloc failed.");
+      return -1;
+    }
+  }
+
+  value_list_t *vl = &b->items.vl[b->items.num];
+  *vl = *value_list;
+  vl->values = malloc(value_list->values_len * sizeof(*vl->values));
+  if (vl->values == NULL) {
+    pthread_mutex_unlock(&b->lock);
+    ERROR("python plugin: cpy_write_batch_callback: malloc failed.");
+    return -1;
+  }
+  memcpy(vl->values, value_list->values,
+         value_list->values_len * sizeof(*vl->values));
+  vl->meta = meta_data_clone(value_list->meta);
+  b->items.ds[b->items.num] = ds;
+  if (b->items.num == 0)
+    b->first = now;
+  b->items.num++;
+
+  cpy_write_items_t items = {0};
+  if (b->items.num >= b->size || (now - b->first) >= b->timeout)
+    items = cpy_write_batch_take(b);
+
+  pthread_mutex_unlock(&b->lock);
+
+  cpy_write_batch_deliver(c, &items);
+  return 0;
+}
+
+/* Passes on a partial batch once the timeout has passed, even if no more
+ * value lists are written. Runs twice per timeout, so value lists are kept
+ * back for at most one and a half times the timeout. */
+static int cpy_write_batch_timer(user_data_t *data) {
+  cpy_callback_t *c = data->data;
+  cpy_write_batch_t *b = c->batch;
+  cpy_write_items_t items = {0};
+
+  pthread_mutex_lock(&b->lock);
+  if ((b->items.num > 0) && ((cdtime() - b->first) >= b->timeout))
+    items = cpy_write_batch_take(b);
+  pthread_mutex_unlock(&b->lock);
+
+  cpy_write_batch_deliver(c, &items);
+  return 0;
+}
+
+/* Drops a reference to a batched write callback. Returns true if it was the
+ * last one. */
+static bool cpy_write_batch_unref(cpy_write_batch_t *b) {
+  pthread_mutex_lock(&b->lock);
+  bool last = (--b->refs == 0);
+  pthread_mutex_unlock(&b->lock);
+  return last;
+}
+
+/* Free function of the timer. */
+static void cpy_write_batch_timer_free(void *data) {
+  cpy_callback_t *c = data;
+
+  if (cpy_write_batch_unref(c->batch))
+    cpy_destroy_user_data(c);
+}
+
+/* Free function of the write callback. The timer is stopped as well; its
+ * reference is dropped once the read thread is done with it. */
+static void cpy_write_batch_free(void *data) {
+  cpy_callback_t *c = data;
+
+  if (cpy_write_batch_unref(c->batch))
+    cpy_destroy_user_data(c);
+  else
+    plugin_unregister_read(c->batch->timer_name);
+}
+
 static int cpy_notification_callback(const notification_t *notification,
                                      user_data_t *data) {
   cpy_callback_t *c = data->data;
   PyObject *ret, *notify;
   Notification *n;
 
-  CPY_LOCK_THREADS
+  CPY_LOCK_INTERP(c->interp)
   PyObject *dict = PyDict_New(); /* New reference. */
   for (notification_meta_t *meta = notification->meta; meta != NULL;
        meta = meta->next) {
@@ -538,16 +1013,18 @@ static int cpy_notification_callback(const notification_t *notification,
       Py_XDECREF(temp);
     } else if (meta->type == NM_TYPE_SIGNED_INT) {
       PyObject *sival = PyLong_FromLongLong(meta->nm_value.nm_signed_int);
-      temp = PyObject_CallFunctionObjArgs((void *)&SignedType, sival,
-                                          (void *)0); /* New reference. */
+      temp = PyObject_CallFunctionObjArgs(
+          (void *)cpy_get_state()->signed_type, sival,
+          (void *)0); /* New reference. */
       PyDict_SetItemString(dict, meta->name, temp);
       Py_XDECREF(temp);
       Py_XDECREF(sival);
     } else if (meta->type == NM_TYPE_UNSIGNED_INT) {
       PyObject *uval =
           PyLong_FromUnsignedLongLong(meta->nm_value.nm_unsigned_int);
-      temp = PyObject_CallFunctionObjArgs((void *)&UnsignedType, uval,
-                                          (void *)0); /* New reference. */
+      temp = PyObject_CallFunctionObjArgs(
+          (void *)cpy_get_state()->unsigned_type, uval,
+          (void *)0); /* New reference. */
       PyDict_SetItemString(dict, meta->name, temp);
       Py_XDECREF(temp);
       Py_XDECREF(uval);
@@ -582,7 +1059,7 @@ static int cpy_notification_callback(const notification_t *notification,
   } else {
     Py_DECREF(ret);
   }
-  CPY_RELEASE_THREADS
+  CPY_RELEASE_INTERP
   return 0;
 }
 
@@ -591,7 +1068,7 @@ static void cpy_log_callback(int severity, const char *message,
   cpy_callback_t *c = data->data;
   PyObject *ret, *text;
 
-  CPY_LOCK_THREADS
+  CPY_LOCK_INTERP(c->interp)
   text = cpy_string_to_unicode_or_bytes(message); /* New reference. */
   if (c->data == NULL)
     ret = PyObject_CallFunction(
@@ -614,14 +1091,14 @@ static void cpy_log_callback(int severity, const char *message,
   } else {
     Py_DECREF(ret);
   }
-  CPY_RELEASE_THREADS
+  CPY_RELEASE_INTERP
 }
 
 static void cpy_flush_callback(int timeout, const char *id, user_data_t *data) {
   cpy_callback_t *c = data->data;
   PyObject *ret, *text;
 
-  CPY_LOCK_THREADS
+  CPY_LOCK_INTERP(c->interp)
   if (id) {
     text = cpy_string_to_unicode_or_bytes(id);
   } else {
@@ -640,7 +1117,7 @@ static void cpy_flush_callback(int timeout, const char *id, user_data_t *data) {
   } else {
     Py_DECREF(ret);
   }
-  CPY_RELEASE_THREADS
+  CPY_RELEASE_INTERP
 }
 
 static PyObject *cpy_register_generic(cpy_callback_t **list_head,
@@ -671,9 +1148,12 @@ static PyObject *cpy_register_generic(cpy_callback_t **list_head,
   c->name = strdup(buf);
   c->callback = callback;
   c->data = data;
+  c->interp = cpy_interp_current();
+  pthread_mutex_lock(&cpy_data_lock);
   c->next = *list_head;
   ++cpy_num_callbacks;
   *list_head = c;
+  pthread_mutex_unlock(&cpy_data_lock);
   Py_XDECREF(mod);
   PyMem_Free(name);
   return cpy_string_to_unicode_or_bytes(buf);
@@ -771,6 +1251,7 @@ static PyObject *cpy_register_generic_userdata(void *reg, void *handler,
   c->name = strdup(buf);
   c->callback = callback;
   c->data = data;
+  c->interp = cpy_interp_current();
   c->next = NULL;
 
   register_function(buf, handler,
@@ -779,7 +1260,7 @@ static PyObject *cpy_register_generic_userdata(void *reg, void *handler,
                         .free_func = cpy_destroy_user_data,
                     });
 
-  ++cpy_num_callbacks;
+  cpy_callback_added();
   return cpy_string_to_unicode_or_bytes(buf);
 }
 
@@ -813,6 +1294,7 @@ static PyObject *cpy_register_read(PyObject *self, PyObject *args,
   c->name = strdup(buf);
   c->callback = callback;
   c->data = data;
+  c->interp = cpy_interp_current();
   c->next = NULL;
 
   plugin_register_complex_read(
@@ -822,7 +1304,7 @@ static PyObject *cpy_register_read(PyObject *self, PyObject *args,
           .data = c,
           .free_func = cpy_destroy_user_data,
       });
-  ++cpy_num_callbacks;
+  cpy_callback_added();
   return cpy_string_to_unicode_or_bytes(buf);
 }
 
@@ -832,10 +1314,105 @@ static PyObject *cpy_register_log(PyObject *self, PyObject *args,
                                        (void *)cpy_log_callback, args, kwds);
 }
 
+static cpy_write_batch_t *cpy_write_batch_create(size_t size,
+                                                 cdtime_t timeout) {
+  cpy_write_batch_t *b = calloc(1, sizeof(*b));
+  if (b == NULL)
+    return NULL;
+
+  pthread_mutex_init(&b->lock, NULL);
+  b->size = size;
+  b->timeout = timeout;
+
+  return b;
+}
+
 static PyObject *cpy_register_write(PyObject *self, PyObject *args,
                                     PyObject *kwds) {
-  return cpy_register_generic_userdata((void *)plugin_register_write,
-                                       (void *)cpy_write_callback, args, kwds);
+  char buf[512];
+  cpy_callback_t *c = NULL;
+  char *name = NULL;
+  int batch_size = 0;
+  double batch_timeout = 0;
+  PyObject *callback = NULL, *data = NULL;
+  static char *kwlist[] = {"callback",   "data",          "name",
+                           "batch_size", "batch_timeout", NULL};
+
+  if (PyArg_ParseTupleAndKeywords(args, kwds, "O|Oetid", kwlist, &callback,
+                                  &data, NULL, &name, &batch_size,
+                                  &batch_timeout) == 0)
+    return NULL;
+  if (PyCallable_Check(callback) == 0) {
+    PyMem_Free(name);
+    PyErr_SetString(PyExc_TypeError, "callback needs a be a callable object.");
+    return NULL;
+  }
+  if (batch_size < 0) {
+    PyMem_Free(name);
+    PyErr_SetString(PyExc_ValueError, "batch_size must not be negative.");
+    return NULL;
+  }
+  cpy_build_name(buf, sizeof(buf), callback, name);
+  PyMem_Free(name);
+
+  c = calloc(1, sizeof(*c));
+  if (c == NULL)
+    return PyErr_NoMemory();
+
+  if (batch_size > 0) {
+    cdtime_t timeout = (batch_timeout > 0) ? DOUBLE_TO_CDTIME_T(batch_timeout)
+                                           : plugin_get_interval();
+
+    c->batch = cpy_write_batch_create((size_t)batch_size, timeout);
+    if (c->batch == NULL) {
+      free(c);
+      return PyErr_NoMemory();
+    }
+  }
+
+  Py_INCREF(callback);
+  Py_XINCREF(data);
+
+  c->name = strdup(buf);
+  c->callback = callback;
+  c->data = data;
+  c->interp = cpy_interp_current();
+  c->next = NULL;
+
+  if (c->batch == NULL) {
+    plugin_register_write(buf, cpy_write_callback,
+                          &(user_data_t){
+                              .data = c,
+                              .free_func = cpy_destroy_user_data,
+                          });
+    cpy_callback_added();
+    return cpy_string_to_unicode_or_bytes(buf);
+  }
+
+  c->batch->refs = 1;
+  ssnprintf(c->batch->timer_name, sizeof(c->batch->timer_name), "%s.batch",
+            buf);
+  if (plugin_register_complex_read(
+          /* group = */ NULL, c->batch->timer_name, cpy_write_batch_timer,
+          (c->batch->timeout > 1) ? c->batch->timeout / 2 : 1,
+          &(user_data_t){
+              .data = c,
+              .free_func = cpy_write_batch_timer_free,
+          }) == 0)
+    c->batch->refs++;
+  else
+    WARNING("python plugin: Registering the timer of %s failed, partial "
+            "batches are only passed on when values are written.",
+            buf);
+
+  plugin_register_write(buf, cpy_write_batch_callback,
+                        &(user_data_t){
+                            .data = c,
+                            .free_func = cpy_write_batch_free,
+                        });
+
+  cpy_callback_added();
+  return cpy_string_to_unicode_or_bytes(buf);
 }
 
 static PyObject *cpy_register_notification(PyObject *self, PyObject *args,
@@ -933,33 +1510,40 @@ static PyObject *cpy_unregister_generic(cpy_callback_t **list_head,
     cpy_build_name(buf, sizeof(buf), arg, NULL);
     name = buf;
   }
+  pthread_mutex_lock(&cpy_data_lock);
   for (tmp = *list_head; tmp; prev = tmp, tmp = tmp->next)
     if (strcmp(name, tmp->name) == 0)
       break;
 
-  Py_DECREF(arg);
+  if (tmp != NULL && prev == NULL)
+    *list_head = tmp->next;
+  else if (tmp != NULL)
+    prev->next = tmp->next;
+  pthread_mutex_unlock(&cpy_data_lock);
+
   if (tmp == NULL) {
     PyErr_Format(PyExc_RuntimeError, "Unable to unregister %s callback '%s'.",
                  desc, name);
+    Py_DECREF(arg);
     return NULL;
   }
-  /* Yes, this is actually safe. To call this function the caller has to
-   * hold the GIL. Well, safe as long as there is only one GIL anyway ... */
-  if (prev == NULL)
-    *list_head = tmp->next;
-  else
-    prev->next = tmp->next;
+  Py_DECREF(arg);
   cpy_destroy_user_data(tmp);
   Py_RETURN_NONE;
 }
 
 static void cpy_unregister_list(cpy_callback_t **list_head) {
   cpy_callback_t *cur, *next;
-  for (cur = *list_head; cur; cur = next) {
+
+  pthread_mutex_lock(&cpy_data_lock);
+  cur = *list_head;
+  *list_head = NULL;
+  pthread_mutex_unlock(&cpy_data_lock);
+
+  for (; cur; cur = next) {
     next = cur->next;
     cpy_destroy_user_data(cur);
   }
-  *list_head = NULL;
 }
 
 typedef int cpy_unregister_function_t(const char *name);
@@ -1035,6 +1619,7 @@ static PyMethodDef cpy_methods[] = {
     {"error", cpy_error, METH_VARARGS, log_doc},
     {"get_dataset", (PyCFunction)cpy_get_dataset, METH_VARARGS, get_ds_doc},
     {"flush", (PyCFunction)cpy_flush, METH_VARARGS | METH_KEYWORDS, flush_doc},
+    {"dispatch_many", cpy_dispatch_many, METH_VARARGS, dispatch_many_doc},
     {"register_log", (PyCFunction)cpy_register_log,
      METH_VARARGS | METH_KEYWORDS, reg_log_doc},
     {"register_init", (PyCFunction)cpy_register_init,
@@ -1078,31 +1663,30 @@ static int cpy_shutdown(void) {
         "================================================================\n");
   }
 
-  CPY_LOCK_THREADS
-
-  for (cpy_callback_t *c = cpy_shutdown_callbacks; c; c = c->next) {
+  for (cpy_callback_t *c = cpy_callback_next(&cpy_shutdown_callbacks, NULL);
+       c != NULL; c = cpy_callback_next(&cpy_shutdown_callbacks, c)) {
+    CPY_LOCK_INTERP(c->interp)
     ret = PyObject_CallFunctionObjArgs(c->callback, c->data,
                                        (void *)0); /* New reference. */
     if (ret == NULL)
       cpy_log_exception("shutdown callback");
     else
       Py_DECREF(ret);
+    PyErr_Print();
+    CPY_RELEASE_INTERP
   }
-  PyErr_Print();
 
-  Py_BEGIN_ALLOW_THREADS;
   cpy_unregister_list(&cpy_config_callbacks);
   cpy_unregister_list(&cpy_init_callbacks);
   cpy_unregister_list(&cpy_shutdown_callbacks);
-  cpy_shutdown_triggered = 1;
-  Py_END_ALLOW_THREADS;
 
-  if (!cpy_num_callbacks) {
-    Py_Finalize();
-    return 0;
-  }
+  pthread_mutex_lock(&cpy_data_lock);
+  cpy_shutdown_triggered = 1;
+  bool finalize = (cpy_num_callbacks == 0);
+  pthread_mutex_unlock(&cpy_data_lock);
+  if (finalize)
+    cpy_finalize();
 
-  CPY_RELEASE_THREADS
   return 0;
 }
 
@@ -1181,16 +1765,17 @@ static int cpy_init(void) {
     PyEval_InitThreads();
     state = PyEval_SaveThread();
   }
-  CPY_LOCK_THREADS
-  for (cpy_callback_t *c = cpy_init_callbacks; c; c = c->next) {
+  for (cpy_callback_t *c = cpy_callback_next(&cpy_init_callbacks, NULL);
+       c != NULL; c = cpy_callback_next(&cpy_init_callbacks, c)) {
+    CPY_LOCK_INTERP(c->interp)
     ret = PyObject_CallFunctionObjArgs(c->callback, c->data,
                                        (void *)0); /* New reference. */
     if (ret == NULL)
       cpy_log_exception("init callback");
     else
       Py_DECREF(ret);
+    CPY_RELEASE_INTERP
   }
-  CPY_RELEASE_THREADS
 
   return 0;
 }
@@ -1216,8 +1801,8 @@ static PyObject *cpy_oconfig_to_pyconfig(oconfig_item_t *ci, PyObject *parent) {
   }
 
   tmp = cpy_string_to_unicode_or_bytes(ci->key);
-  item = PyObject_CallFunction((void *)&ConfigType, "NONO", tmp, parent, values,
-                               Py_None);
+  item = PyObject_CallFunction((void *)cpy_get_state()->config_type, "NONO",
+                               tmp, parent, values, Py_None);
   if (item == NULL)
     return NULL;
   children = PyTuple_New(ci->children_num); /* New reference. */
@@ -1231,101 +1816,107 @@ static PyObject *cpy_oconfig_to_pyconfig(oconfig_item_t *ci, PyObject *parent) {
   return item;
 }
 
-#ifdef IS_PY3K
-static struct PyModuleDef collectdmodule = {
-    PyModuleDef_HEAD_INIT, "collectd",  /* name of module */
-    "The python interface to collectd", /* module documentation, may be NULL */
-    -1, cpy_methods};
-
-PyMODINIT_FUNC PyInit_collectd(void) {
-  return PyModule_Create(&collectdmodule);
-}
-#endif
-
-static int cpy_init_python(void) {
-  PyOS_sighandler_t cur_sig;
-  PyObject *sys, *errordict;
-  PyObject *module;
-
-#ifdef IS_PY3K
-  wchar_t *argv = L"";
-  /* Add a builtin module, before Py_Initialize */
-  PyImport_AppendInittab("collectd", PyInit_collectd);
+/* Creates the types and the exception of the "collectd" module. */
+static int cpy_state_init(cpy_state_t *st) {
+  PyObject *errordict, *doc;
+
+#ifdef CPY_SUB_INTERPRETERS
+  st->config_type = (PyTypeObject *)PyType_FromSpec(&Config_spec);
+  st->plugin_data_type = (PyTypeObject *)PyType_FromSpec(&PluginData_spec);
+  if (st->plugin_data_type != NULL) {
+    st->values_type = (PyTypeObject *)PyType_FromSpecWithBases(
+        &Values_spec, (PyObject *)st->plugin_data_type);
+    st->notification_type = (PyTypeObject *)PyType_FromSpecWithBases(
+        &Notification_spec, (PyObject *)st->plugin_data_type);
+  }
+  st->signed_type = (PyTypeObject *)PyType_FromSpecWithBases(
+      &Signed_spec, (PyObject *)&PyLong_Type);
+  st->unsigned_type = (PyTypeObject *)PyType_FromSpecWithBases(
+      &Unsigned_spec, (PyObject *)&PyLong_Type);
 #else
-  char *argv = "";
-#endif
-
-  /* Chances are the current signal handler is already SIG_DFL, but let's make
-   * sure. */
-  cur_sig = PyOS_setsig(SIGINT, SIG_DFL);
-  Py_Initialize();
-  python_sigint_handler = PyOS_setsig(SIGINT, cur_sig);
-
   if (PyType_Ready(&ConfigType) == -1) {
     cpy_log_exception("python initialization: ConfigType");
-    return 1;
+    return -1;
   }
   if (PyType_Ready(&PluginDataType) == -1) {
     cpy_log_exception("python initialization: PluginDataType");
-    return 1;
+    return -1;
   }
   ValuesType.tp_base = &PluginDataType;
   if (PyType_Ready(&ValuesType) == -1) {
     cpy_log_exception("python initialization: ValuesType");
-    return 1;
+    return -1;
   }
   NotificationType.tp_base = &PluginDataType;
   if (PyType_Ready(&NotificationType) == -1) {
     cpy_log_exception("python initialization: NotificationType");
-    return 1;
+    return -1;
   }
   SignedType.tp_base = &PyLong_Type;
   if (PyType_Ready(&SignedType) == -1) {
     cpy_log_exception("python initialization: SignedType");
-    return 1;
+    return -1;
   }
   UnsignedType.tp_base = &PyLong_Type;
   if (PyType_Ready(&UnsignedType) == -1) {
     cpy_log_exception("python initialization: UnsignedType");
-    return 1;
-  }
-  errordict = PyDict_New();
-  PyDict_SetItemString(
-      errordict, "__doc__",
-      cpy_string_to_unicode_or_bytes(CollectdError_doc)); /* New reference. */
-  CollectdError = PyErr_NewException("collectd.CollectdError", NULL, errordict);
-  sys = PyImport_ImportModule("sys"); /* New reference. */
-  if (sys == NULL) {
-    cpy_log_exception("python initialization");
-    return 1;
+    return -1;
   }
-  sys_path = PyObject_GetAttrString(sys, "path"); /* New reference. */
-  Py_DECREF(sys);
-  if (sys_path == NULL) {
-    cpy_log_exception("python initialization");
-    return 1;
-  }
-  PySys_SetArgv(1, &argv);
-  PyList_SetSlice(sys_path, 0, 1, NULL);
+  st->config_type = &ConfigType;
+  st->plugin_data_type = &PluginDataType;
+  st->values_type = &ValuesType;
+  st->notification_type = &NotificationType;
+  st->signed_type = &SignedType;
+  st->unsigned_type = &UnsignedType;
+#endif
 
-#ifdef IS_PY3K
-  module = PyImport_ImportModule("collectd");
-#else
-  module = Py_InitModule("collectd", cpy_methods); /* Borrowed reference. */
+  errordict = PyDict_New(); /* New reference. */
+  doc = cpy_string_to_unicode_or_bytes(CollectdError_doc); /* New reference. */
+  if (errordict != NULL && doc != NULL)
+    PyDict_SetItemString(errordict, "__doc__", doc);
+  Py_XDECREF(doc);
+  if (errordict != NULL)
+    st->error = PyErr_NewException("collectd.CollectdError", NULL, errordict);
+  Py_XDECREF(errordict);
+
+#ifdef CPY_SUB_INTERPRETERS
+  if (st->config_type == NULL || st->values_type == NULL ||
+      st->notification_type == NULL || st->signed_type == NULL ||
+      st->unsigned_type == NULL || st->error == NULL) {
+    Py_CLEAR(st->config_type);
+    Py_CLEAR(st->plugin_data_type);
+    Py_CLEAR(st->values_type);
+    Py_CLEAR(st->notification_type);
+    Py_CLEAR(st->signed_type);
+    Py_CLEAR(st->unsigned_type);
+    Py_CLEAR(st->error);
+    return -1;
+  }
 #endif
+  return (st->error == NULL) ? -1 : 0;
+}
+
+/* Adds the types, the exception and the constants to the "collectd"
+ * module. */
+static int cpy_module_populate(PyObject *module, cpy_state_t *st) {
+  Py_INCREF(st->config_type);
   PyModule_AddObject(module, "Config",
-                     (void *)&ConfigType); /* Steals a reference. */
+                     (void *)st->config_type); /* Steals a reference. */
+  Py_INCREF(st->values_type);
   PyModule_AddObject(module, "Values",
-                     (void *)&ValuesType); /* Steals a reference. */
+                     (void *)st->values_type); /* Steals a reference. */
+  Py_INCREF(st->notification_type);
   PyModule_AddObject(module, "Notification",
-                     (void *)&NotificationType); /* Steals a reference. */
+                     (void *)st->notification_type); /* Steals a reference. */
+  Py_INCREF(st->signed_type);
   PyModule_AddObject(module, "Signed",
-                     (void *)&SignedType); /* Steals a reference. */
+                     (void *)st->signed_type); /* Steals a reference. */
+  Py_INCREF(st->unsigned_type);
   PyModule_AddObject(module, "Unsigned",
-                     (void *)&UnsignedType); /* Steals a reference. */
-  Py_XINCREF(CollectdError);
+                     (void *)st->unsigned_type); /* Steals a reference. */
+  Py_INCREF(st->error);
   PyModule_AddObject(module, "CollectdError",
-                     CollectdError); /* Steals a reference. */
+                     st->error); /* Steals a reference. */
   PyModule_AddIntConstant(module, "LOG_DEBUG", LOG_DEBUG);
   PyModule_AddIntConstant(module, "LOG_INFO", LOG_INFO);
   PyModule_AddIntConstant(module, "LOG_NOTICE", LOG_NOTICE);
@@ -1345,8 +1936,227 @@ static int cpy_init_python(void) {
   return 0;
 }
 
+#ifdef CPY_SUB_INTERPRETERS
+/* Called whenever the "collectd" module is imported into an interpreter.
+ * Every interpreter has its own copy of the module and its types. */
+static int cpy_module_exec(PyObject *module) {
+  cpy_interp_t *interp = cpy_interp_current();
+
+  if (interp == NULL) {
+    PyErr_SetString(PyExc_ImportError,
+                    "collectd can only be imported into interpreters "
+                    "created by collectd");
+    return -1;
+  }
+  if (interp->state.values_type == NULL &&
+      cpy_state_init(&interp->state) != 0)
+    return -1;
+  return cpy_module_populate(module, &interp->state);
+}
+
+static PyModuleDef_Slot cpy_module_slots[] = {
+    {Py_mod_exec, cpy_module_exec},
+    {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+    {0, NULL}};
+#endif
+
+#ifdef IS_PY3K
+static struct PyModuleDef collectdmodule = {
+    PyModuleDef_HEAD_INIT, "collectd",  /* name of module */
+    "The python interface to collectd", /* module documentation, may be NULL */
+#ifdef CPY_SUB_INTERPRETERS
+    0, cpy_methods, cpy_module_slots};
+#else
+    -1, cpy_methods};
+#endif
+
+PyMODINIT_FUNC PyInit_collectd(void) {
+#ifdef CPY_SUB_INTERPRETERS
+  return PyModuleDef_Init(&collectdmodule);
+#else
+  PyObject *module = PyModule_Create(&collectdmodule); /* New reference. */
+  if (module != NULL)
+    cpy_module_populate(module, &cpy_main_interp.state);
+  return module;
+#endif
+}
+#endif
+
+static int cpy_stats_read(void) {
+  for (cpy_interp_t *i = &cpy_main_interp; i != NULL; i = i->next) {
+    value_list_t vl = VALUE_LIST_INIT;
+    derive_t calls;
+    cdtime_t run_time, wait_time;
+
+    pthread_mutex_lock(&cpy_data_lock);
+    calls = i->calls;
+    run_time = i->run_time;
+    wait_time = i->wait_time;
+    pthread_mutex_unlock(&cpy_data_lock);
+
+    sstrncpy(vl.plugin, "python", sizeof(vl.plugin));
+    if (i != &cpy_main_interp)
+      sstrncpy(vl.plugin_instance, i->name, sizeof(vl.plugin_instance));
+    vl.values_len = 1;
+
+    vl.values = &(value_t){.derive = calls};
+    sstrncpy(vl.type, "total_requests", sizeof(vl.type));
+    sstrncpy(vl.type_instance, "callbacks", sizeof(vl.type_instance));
+    plugin_dispatch_values(&vl);
+
+    vl.values = &(value_t){.derive = CDTIME_T_TO_MS(run_time)};
+    sstrncpy(vl.type, "total_time_in_ms", sizeof(vl.type));
+    plugin_dispatch_values(&vl);
+
+    vl.values = &(value_t){.derive = CDTIME_T_TO_MS(wait_time)};
+    sstrncpy(vl.type_instance, "gil_wait", sizeof(vl.type_instance));
+    plugin_dispatch_values(&vl);
+  }
+
+  return 0;
+}
+
+/* Sets up "sys" of the current interpreter and imports the "collectd" module
+ * into it. Returns a new reference to "sys.path". */
+static PyObject *cpy_interp_setup(void) {
+  PyObject *sys, *path, *module;
+
+#ifdef IS_PY3K
+  wchar_t *argv = L"";
+#else
+  char *argv = "";
+#endif
+
+  sys = PyImport_ImportModule("sys"); /* New reference. */
+  if (sys == NULL) {
+    cpy_log_exception("python initialization");
+    return NULL;
+  }
+  path = PyObject_GetAttrString(sys, "path"); /* New reference. */
+  Py_DECREF(sys);
+  if (path == NULL) {
+    cpy_log_exception("python initialization");
+    return NULL;
+  }
+  PySys_SetArgv(1, &argv);
+  PyList_SetSlice(path, 0, 1, NULL);
+
+#ifdef IS_PY3K
+  module = PyImport_ImportModule("collectd"); /* New reference. */
+#else
+  module = Py_InitModule("collectd", cpy_methods); /* Borrowed reference. */
+  if (module != NULL) {
+    Py_INCREF(module);
+    cpy_module_populate(module, &cpy_main_interp.state);
+  }
+#endif
+  if (module == NULL) {
+    cpy_log_exception("python initialization");
+    Py_DECREF(path);
+    return NULL;
+  }
+  Py_DECREF(module);
+  return path;
+}
+
+#ifdef CPY_SUB_INTERPRETERS
+/* Creates a sub-interpreter with its own GIL for the module "name" and
+ * switches the calling thread to it. The caller has to switch back to the
+ * main interpreter. On failure, the calling thread stays in the main
+ * interpreter. */
+static cpy_interp_t *cpy_interp_create(const char *name) {
+  const PyInterpreterConfig config = {
+      .use_main_obmalloc = 0,
+      .allow_fork = 0,
+      .allow_exec = 0,
+      .allow_threads = 1,
+      .allow_daemon_threads = 0,
+      .check_multi_interp_extensions = 1,
+      .gil = PyInterpreterConfig_OWN_GIL,
+  };
+  cpy_interp_t *interp;
+  PyStatus status;
+  PyObject *path;
+
+  interp = calloc(1, sizeof(*interp));
+  if (interp == NULL || (interp->name = strdup(name)) == NULL) {
+    ERROR("python plugin: calloc failed.");
+    free(interp);
+    return NULL;
+  }
+  if (pthread_key_create(&interp->thread_key, NULL) != 0) {
+    ERROR("python plugin: pthread_key_create failed.");
+    free(interp->name);
+    free(interp);
+    return NULL;
+  }
+
+  status = Py_NewInterpreterFromConfig(&interp->thread_state, &config);
+  if (PyStatus_Exception(status)) {
+    ERROR("python plugin: Unable to create an interpreter for \"%s\": %s",
+          name, (status.err_msg != NULL) ? status.err_msg : "unknown error");
+    pthread_key_delete(interp->thread_key);
+    free(interp->name);
+    free(interp);
+    return NULL;
+  }
+  interp->interp = PyThreadState_GetInterpreter(interp->thread_state);
+  pthread_setspecific(interp->thread_key, interp->thread_state);
+
+  interp->next = cpy_main_interp.next;
+  cpy_main_interp.next = interp;
+
+  path = cpy_interp_setup(); /* New reference. */
+  for (size_t i = 0; path != NULL && i < cpy_module_paths_num; ++i) {
+    PyObject *dir = cpy_string_to_unicode_or_bytes(cpy_module_paths[i]);
+    if (dir == NULL || PyList_Insert(path, 0, dir) != 0) {
+      ERROR("python plugin: Unable to prepend \"%s\" to "
+            "python module path.",
+            cpy_module_paths[i]);
+      cpy_log_exception("python initialization");
+    }
+    Py_XDECREF(dir);
+  }
+  Py_XDECREF(path);
+  return interp;
+}
+#endif
+
+static int cpy_init_python(void) {
+  PyOS_sighandler_t cur_sig;
+
+#ifdef IS_PY3K
+  /* Add a builtin module, before Py_Initialize */
+  PyImport_AppendInittab("collectd", PyInit_collectd);
+#endif
+
+  /* Chances are the current signal handler is already SIG_DFL, but let's make
+   * sure. */
+  cur_sig = PyOS_setsig(SIGINT, SIG_DFL);
+  Py_Initialize();
+  python_sigint_handler = PyOS_setsig(SIGINT, cur_sig);
+
+#ifdef CPY_SUB_INTERPRETERS
+  cpy_main_interp.interp = PyInterpreterState_Get();
+  cpy_main_interp.thread_state = PyThreadState_Get();
+  if (pthread_key_create(&cpy_main_interp.thread_key, NULL) != 0) {
+    ERROR("python plugin: pthread_key_create failed.");
+    return 1;
+  }
+  pthread_setspecific(cpy_main_interp.thread_key,
+                      cpy_main_interp.thread_state);
+#else
+  if (cpy_state_init(&cpy_main_interp.state) != 0)
+    return 1;
+#endif
+
+  sys_path = cpy_interp_setup(); /* New reference. */
+  if (sys_path == NULL)
+    return 1;
+  return 0;
+}
+
 static int cpy_config(oconfig_item_t *ci) {
-  PyObject *tb;
   int status = 0;
 
   /* Ok in theory we shouldn't do initialization at this point
@@ -1367,6 +2177,28 @@ static int cpy_config(oconfig_item_t *ci) {
         status = 1;
         continue;
       }
+    } else if (strcasecmp(item->key, "InterpreterStatistics") == 0) {
+      if (cf_util_get_boolean(item, &cpy_statistics) != 0) {
+        status = 1;
+        continue;
+      }
+      if (cpy_statistics)
+        plugin_register_read("python", cpy_stats_read);
+      else
+        plugin_unregister_read("python");
+    } else if (strcasecmp(item->key, "SubInterpreters") == 0) {
+      if (cf_util_get_boolean(item, &cpy_sub_interpreters) != 0) {
+        status = 1;
+        continue;
+      }
+#ifndef CPY_SUB_INTERPRETERS
+      if (cpy_sub_interpreters) {
+        ERROR("python plugin: \"SubInterpreters\" requires Python 3.12 or "
+              "newer.");
+        cpy_sub_interpreters = false;
+        status = 1;
+      }
+#endif
     } else if (strcasecmp(item->key, "Encoding") == 0) {
       char *encoding = NULL;
       if (cf_util_get_string(item, &encoding) != 0) {
@@ -1388,31 +2220,13 @@ static int cpy_config(oconfig_item_t *ci) {
 #endif
       sfree(encoding);
     } else if (strcasecmp(item->key, "LogTraces") == 0) {
-      bool log_traces;
-      if (cf_util_get_boolean(item, &log_traces) != 0) {
+      if (cf_util_get_boolean(item, &cpy_log_traces) != 0) {
         status = 1;
         continue;
       }
-      if (!log_traces) {
-        Py_XDECREF(cpy_format_exception);
-        cpy_format_exception = NULL;
-        continue;
-      }
-      if (cpy_format_exception)
-        continue;
-      tb = PyImport_ImportModule("traceback"); /* New reference. */
-      if (tb == NULL) {
-        cpy_log_exception("python initialization");
-        status = 1;
-        continue;
-      }
-      cpy_format_exception =
-          PyObject_GetAttrString(tb, "format_exception"); /* New reference. */
-      Py_DECREF(tb);
-      if (cpy_format_exception == NULL) {
-        cpy_log_exception("python initialization");
-        status = 1;
-      }
+      /* traceback.format_exception() is loaded once it is needed. */
+      if (!cpy_log_traces)
+        Py_CLEAR(cpy_main_interp.format_exception);
     } else if (strcasecmp(item->key, "ModulePath") == 0) {
       char *dir = NULL;
       PyObject *dir_object;
@@ -1437,6 +2251,11 @@ static int cpy_config(oconfig_item_t *ci) {
               dir);
         cpy_log_exception("python initialization");
         status = 1;
+      } else if (strarray_add(&cpy_module_paths, &cpy_module_paths_num,
+                              dir) != 0) {
+        /* Sub-interpreters created later on use the path, too. */
+        ERROR("python plugin: strarray_add failed.");
+        status = 1;
       }
       Py_DECREF(dir_object);
       free(dir);
@@ -1448,6 +2267,14 @@ static int cpy_config(oconfig_item_t *ci) {
         status = 1;
         continue;
       }
+#ifdef CPY_SUB_INTERPRETERS
+      PyThreadState *main_state = cpy_thread_state();
+      if (cpy_sub_interpreters && cpy_interp_create(module_name) == NULL) {
+        status = 1;
+        free(module_name);
+        continue;
+      }
+#endif
       module = PyImport_ImportModule(module_name); /* New reference. */
       if (module == NULL) {
         ERROR("python plugin: Error importing module \"%s\".", module_name);
@@ -1456,6 +2283,12 @@ static int cpy_config(oconfig_item_t *ci) {
       }
       free(module_name);
       Py_XDECREF(module);
+#ifdef CPY_SUB_INTERPRETERS
+      if (cpy_thread_state() != main_state) {
+        PyEval_SaveThread();
+        PyEval_RestoreThread(main_state);
+      }
+#endif
     } else if (strcasecmp(item->key, "Module") == 0) {
       char *name = NULL;
       cpy_callback_t *c;
@@ -1465,10 +2298,12 @@ static int cpy_config(oconfig_item_t *ci) {
         status = 1;
         continue;
       }
+      pthread_mutex_lock(&cpy_data_lock);
       for (c = cpy_config_callbacks; c; c = c->next) {
         if (strcasecmp(c->name + 7, name) == 0)
           break;
       }
+      pthread_mutex_unlock(&cpy_data_lock);
       if (c == NULL) {
         WARNING("python plugin: Found a configuration for the \"%s\" plugin, "
                 "but the plugin isn't loaded or didn't register "
@@ -1478,6 +2313,7 @@ static int cpy_config(oconfig_item_t *ci) {
         continue;
       }
       free(name);
+      CPY_LOCK_INTERP(c->interp)
       if (c->data == NULL)
         ret = PyObject_CallFunction(
             c->callback, "N",
@@ -1491,6 +2327,7 @@ static int cpy_config(oconfig_item_t *ci) {
         status = 1;
       } else
         Py_DECREF(ret);
+      CPY_RELEASE_INTERP
     } else {
       ERROR("python plugin: Unknown config key \"%s\".", item->key);
       status = 1;
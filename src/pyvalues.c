@@ -52,64 +52,45 @@ typedef struct {
 
 static PyObject *cpy_common_repr(PyObject *s) {
   PyObject *ret, *tmp;
-  static PyObject *l_type, *l_type_instance, *l_plugin, *l_plugin_instance;
-  static PyObject *l_host, *l_time;
   PluginData *self = (PluginData *)s;
 
-  if (l_type == NULL)
-    l_type = cpy_string_to_unicode_or_bytes("(type=");
-  if (l_type_instance == NULL)
-    l_type_instance = cpy_string_to_unicode_or_bytes(",type_instance=");
-  if (l_plugin == NULL)
-    l_plugin = cpy_string_to_unicode_or_bytes(",plugin=");
-  if (l_plugin_instance == NULL)
-    l_plugin_instance = cpy_string_to_unicode_or_bytes(",plugin_instance=");
-  if (l_host == NULL)
-    l_host = cpy_string_to_unicode_or_bytes(",host=");
-  if (l_time == NULL)
-    l_time = cpy_string_to_unicode_or_bytes(",time=");
-
-  if (!l_type || !l_type_instance || !l_plugin || !l_plugin_instance ||
-      !l_host || !l_time)
-    return NULL;
-
   ret = cpy_string_to_unicode_or_bytes(s->ob_type->tp_name);
 
-  CPY_STRCAT(&ret, l_type);
+  cpy_strcat_string(&ret, "(type=");
   tmp = cpy_string_to_unicode_or_bytes(self->type);
   CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
   CPY_STRCAT_AND_DEL(&ret, tmp);
 
   if (self->type_instance[0] != 0) {
-    CPY_STRCAT(&ret, l_type_instance);
+    cpy_strcat_string(&ret, ",type_instance=");
     tmp = cpy_string_to_unicode_or_bytes(self->type_instance);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
 
   if (self->plugin[0] != 0) {
-    CPY_STRCAT(&ret, l_plugin);
+    cpy_strcat_string(&ret, ",plugin=");
     tmp = cpy_string_to_unicode_or_bytes(self->plugin);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
 
   if (self->plugin_instance[0] != 0) {
-    CPY_STRCAT(&ret, l_plugin_instance);
+    cpy_strcat_string(&ret, ",plugin_instance=");
     tmp = cpy_string_to_unicode_or_bytes(self->plugin_instance);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
 
   if (self->host[0] != 0) {
-    CPY_STRCAT(&ret, l_host);
+    cpy_strcat_string(&ret, ",host=");
     tmp = cpy_string_to_unicode_or_bytes(self->host);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
 
   if (self->time != 0) {
-    CPY_STRCAT(&ret, l_time);
+    cpy_strcat_string(&ret, ",time=");
     tmp = PyFloat_FromDouble(self->time);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
@@ -202,16 +183,9 @@ static int PluginData_init(PyObject *s, PyObject *args, PyObject *kwds) {
 
 static PyObject *PluginData_repr(PyObject *s) {
   PyObject *ret;
-  static PyObject *l_closing;
-
-  if (l_closing == NULL)
-    l_closing = cpy_string_to_unicode_or_bytes(")");
-
-  if (l_closing == NULL)
-    return NULL;
 
   ret = cpy_common_repr(s);
-  CPY_STRCAT(&ret, l_closing);
+  cpy_strcat_string(&ret, ")");
   return ret;
 }
 
@@ -284,6 +258,21 @@ static PyGetSetDef PluginData_getseters[] = {
      (void *)offsetof(PluginData, type)},
     {NULL}};
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot PluginData_slots[] = {
+    {Py_tp_repr, PluginData_repr},       {Py_tp_doc, PluginData_doc},
+    {Py_tp_members, PluginData_members}, {Py_tp_getset, PluginData_getseters},
+    {Py_tp_init, PluginData_init},       {Py_tp_new, PluginData_new},
+    {0, NULL}};
+
+PyType_Spec PluginData_spec = {
+    .name = "collectd.PluginData",
+    .basicsize = sizeof(PluginData),
+    .flags =
+        Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = PluginData_slots,
+};
+#else
 PyTypeObject PluginDataType = {
     CPY_INIT_TYPE "collectd.PluginData", /* tp_name */
     sizeof(PluginData),                  /* tp_basicsize */
@@ -324,6 +313,7 @@ PyTypeObject PluginDataType = {
     0,                                                /* tp_alloc */
     PluginData_new                                    /* tp_new */
 };
+#endif
 
 static char interval_doc[] =
     "The interval is the timespan in seconds between two submits for\n"
@@ -505,12 +495,12 @@ static int cpy_build_meta_generic(PyObject *meta,
       meta_func->add_boolean(m, keystring, 0);
     } else if (PyFloat_Check(value)) {
       meta_func->add_double(m, keystring, PyFloat_AsDouble(value));
-    } else if (PyObject_TypeCheck(value, &SignedType)) {
+    } else if (PyObject_TypeCheck(value, cpy_get_state()->signed_type)) {
       long long int lli;
       lli = PyLong_AsLongLong(value);
       if (!PyErr_Occurred() && (lli == (int64_t)lli))
         meta_func->add_signed_int(m, keystring, lli);
-    } else if (PyObject_TypeCheck(value, &UnsignedType)) {
+    } else if (PyObject_TypeCheck(value, cpy_get_state()->unsigned_type)) {
       long long unsigned llu;
       llu = PyLong_AsUnsignedLongLong(value);
       if (!PyErr_Occurred() && (llu == (uint64_t)llu))
@@ -586,69 +576,146 @@ static void cpy_build_notification_meta(notification_t *n, PyObject *meta) {
   cpy_build_meta_generic(meta, &cpy_plugin_notification_meta, (void *)n);
 }
 
-static PyObject *Values_dispatch(Values *self, PyObject *args, PyObject *kwds) {
-  int ret;
-  const data_set_t *ds;
-  size_t size;
-  value_t *value;
-  value_list_t value_list = VALUE_LIST_INIT;
-  PyObject *values = self->values, *meta = self->meta;
-  double time = self->data.time, interval = self->interval;
-  char *host = NULL, *plugin = NULL, *plugin_instance = NULL, *type = NULL,
-       *type_instance = NULL;
+/* Converts the items of an object supporting the buffer protocol, e.g. an
+ * array.array or a numpy array, without creating a Python object for every
+ * item. */
+static int cpy_build_values_from_buffer(const data_set_t *ds, PyObject *values,
+                                        value_t *value) {
+  Py_buffer view;
 
-  static char *kwlist[] = {
-      "type", "values", "plugin_instance", "type_instance", "plugin",
-      "host", "time",   "interval",        "meta",          NULL};
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|etOetetetetddO", kwlist, NULL,
-                                   &type, &values, NULL, &plugin_instance, NULL,
-                                   &type_instance, NULL, &plugin, NULL, &host,
-                                   &time, &interval, &meta))
-    return NULL;
+  if (PyObject_GetBuffer(values, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) !=
+      0)
+    return -1;
 
-  sstrncpy(value_list.host, host ? host : self->data.host,
-           sizeof(value_list.host));
-  sstrncpy(value_list.plugin, plugin ? plugin : self->data.plugin,
-           sizeof(value_list.plugin));
-  sstrncpy(value_list.plugin_instance,
-           plugin_instance ? plugin_instance : self->data.plugin_instance,
-           sizeof(value_list.plugin_instance));
-  sstrncpy(value_list.type, type ? type : self->data.type,
-           sizeof(value_list.type));
-  sstrncpy(value_list.type_instance,
-           type_instance ? type_instance : self->data.type_instance,
-           sizeof(value_list.type_instance));
-  FreeAll();
-  if (value_list.type[0] == 0) {
-    PyErr_SetString(PyExc_RuntimeError, "type not set");
-    FreeAll();
-    return NULL;
+  const char *format = (view.format != NULL) ? view.format : "B";
+  if (format[0] == '@' || format[0] == '=')
+    ++format;
+
+  /* With the "=" prefix the items have the standard rather than the native
+   * size, e.g. four bytes for "l", so integers are read by their item size. */
+  Py_ssize_t itemsize = view.itemsize;
+  bool size_ok = (itemsize == 1 || itemsize == 2 || itemsize == 4 ||
+                  itemsize == 8);
+  if (format[0] == 'f')
+    size_ok = (itemsize == sizeof(float));
+  else if (format[0] == 'd')
+    size_ok = (itemsize == sizeof(double));
+  if (format[0] == 0 || format[1] != 0 ||
+      strchr("bBhHiIlLqQfd", format[0]) == NULL || !size_ok) {
+    PyErr_Format(PyExc_TypeError, "unsupported buffer format \"%s\"",
+                 view.format);
+    PyBuffer_Release(&view);
+    return -1;
   }
-  ds = plugin_get_ds(value_list.type);
-  if (ds == NULL) {
-    PyErr_Format(PyExc_TypeError, "Dataset %s not found", value_list.type);
-    return NULL;
+  bool is_float = (format[0] == 'f' || format[0] == 'd');
+  bool is_signed = (strchr("bhilq", format[0]) != NULL);
+
+  size_t size = (size_t)(view.len / view.itemsize);
+  if (size != ds->ds_num) {
+    PyErr_Format(PyExc_RuntimeError,
+                 "type %s needs %" PRIsz " values, got %" PRIsz, ds->type,
+                 ds->ds_num, size);
+    PyBuffer_Release(&view);
+    return -1;
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    const char *item = (const char *)view.buf + i * view.itemsize;
+    double d = 0.0;
+    int64_t si = 0;
+    uint64_t ui = 0;
+
+    /* Items are not necessarily aligned, hence memcpy. */
+    if (format[0] == 'f') {
+      float f;
+      memcpy(&f, item, sizeof(f));
+      d = f;
+    } else if (format[0] == 'd') {
+      memcpy(&d, item, sizeof(d));
+    } else if (view.itemsize == 1) {
+      uint8_t v;
+      memcpy(&v, item, sizeof(v));
+      si = (int8_t)v;
+      ui = v;
+    } else if (view.itemsize == 2) {
+      uint16_t v;
+      memcpy(&v, item, sizeof(v));
+      si = (int16_t)v;
+      ui = v;
+    } else if (view.itemsize == 4) {
+      uint32_t v;
+      memcpy(&v, item, sizeof(v));
+      si = (int32_t)v;
+      ui = v;
+    } else {
+      memcpy(&ui, item, sizeof(ui));
+      si = (int64_t)ui;
+    }
+
+    switch (ds->ds[i].type) {
+    case DS_TYPE_GAUGE:
+      value[i].gauge = is_float ? d : is_signed ? (gauge_t)si : (gauge_t)ui;
+      break;
+    case DS_TYPE_DERIVE:
+      value[i].derive = is_float ? (derive_t)d : is_signed ? si : (derive_t)ui;
+      break;
+    case DS_TYPE_COUNTER:
+      value[i].counter =
+          is_float ? (counter_t)d : is_signed ? (counter_t)si : ui;
+      break;
+    case DS_TYPE_ABSOLUTE:
+      value[i].absolute =
+          is_float ? (absolute_t)d : is_signed ? (absolute_t)si : ui;
+      break;
+    default:
+      PyErr_Format(PyExc_RuntimeError, "unknown data type %d for %s",
+                   ds->ds[i].type, ds->type);
+      PyBuffer_Release(&view);
+      return -1;
+    }
+  }
+
+  PyBuffer_Release(&view);
+  return 0;
+}
+
+/* Converts "values", a list, a tuple or an object supporting the buffer
+ * protocol, to a newly allocated array of ds->ds_num values. Returns NULL
+ * with an exception set on error. */
+static value_t *cpy_build_values(const data_set_t *ds, PyObject *values) {
+  value_t *value;
+  size_t size;
+
+  if (values != NULL && PyObject_CheckBuffer(values) &&
+      !IS_BYTES_OR_UNICODE(values)) {
+    value = calloc(ds->ds_num, sizeof(*value));
+    if (value == NULL)
+      return (value_t *)PyErr_NoMemory();
+    if (cpy_build_values_from_buffer(ds, values, value) != 0) {
+      free(value);
+      return NULL;
+    }
+    return value;
   }
+
   if (values == NULL ||
       (PyTuple_Check(values) == 0 && PyList_Check(values) == 0)) {
-    PyErr_Format(PyExc_TypeError, "values must be list or tuple");
-    return NULL;
-  }
-  if (meta != NULL && meta != Py_None && !PyDict_Check(meta)) {
-    PyErr_Format(PyExc_TypeError, "meta must be a dict");
+    PyErr_Format(PyExc_TypeError, "values must be list, tuple or buffer");
     return NULL;
   }
   size = (size_t)PySequence_Length(values);
   if (size != ds->ds_num) {
     PyErr_Format(PyExc_RuntimeError,
-                 "type %s needs %" PRIsz " values, got %" PRIsz,
-                 value_list.type, ds->ds_num, size);
+                 "type %s needs %" PRIsz " values, got %" PRIsz, ds->type,
+                 ds->ds_num, size);
     return NULL;
   }
   value = calloc(size, sizeof(*value));
+  if (value == NULL)
+    return (value_t *)PyErr_NoMemory();
   for (size_t i = 0; i < size; ++i) {
     PyObject *item, *num;
-    item = PySequence_Fast_GET_ITEM(values, (int)i); /* Borrowed reference. */
+    item = PySequence_Fast_GET_ITEM(values, i); /* Borrowed reference. */
     switch (ds->ds[i].type) {
     case DS_TYPE_COUNTER:
       num = PyNumber_Long(item); /* New reference. */
@@ -685,7 +752,7 @@ static PyObject *Values_dispatch(Values *self, PyObject *args, PyObject *kwds) {
     default:
       free(value);
       PyErr_Format(PyExc_RuntimeError, "unknown data type %d for %s",
-                   ds->ds[i].type, value_list.type);
+                   ds->ds[i].type, ds->type);
       return NULL;
     }
     if (PyErr_Occurred() != NULL) {
@@ -693,6 +760,60 @@ static PyObject *Values_dispatch(Values *self, PyObject *args, PyObject *kwds) {
       return NULL;
     }
   }
+  return value;
+}
+
+static PyObject *Values_dispatch(Values *self, PyObject *args, PyObject *kwds) {
+  int ret;
+  const data_set_t *ds;
+  size_t size;
+  value_t *value;
+  value_list_t value_list = VALUE_LIST_INIT;
+  PyObject *values = self->values, *meta = self->meta;
+  double time = self->data.time, interval = self->interval;
+  char *host = NULL, *plugin = NULL, *plugin_instance = NULL, *type = NULL,
+       *type_instance = NULL;
+
+  static char *kwlist[] = {
+      "type", "values", "plugin_instance", "type_instance", "plugin",
+      "host", "time",   "interval",        "meta",          NULL};
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|etOetetetetddO", kwlist, NULL,
+                                   &type, &values, NULL, &plugin_instance, NULL,
+                                   &type_instance, NULL, &plugin, NULL, &host,
+                                   &time, &interval, &meta))
+    return NULL;
+
+  sstrncpy(value_list.host, host ? host : self->data.host,
+           sizeof(value_list.host));
+  sstrncpy(value_list.plugin, plugin ? plugin : self->data.plugin,
+           sizeof(value_list.plugin));
+  sstrncpy(value_list.plugin_instance,
+           plugin_instance ? plugin_instance : self->data.plugin_instance,
+           sizeof(value_list.plugin_instance));
+  sstrncpy(value_list.type, type ? type : self->data.type,
+           sizeof(value_list.type));
+  sstrncpy(value_list.type_instance,
+           type_instance ? type_instance : self->data.type_instance,
+           sizeof(value_list.type_instance));
+  FreeAll();
+  if (value_list.type[0] == 0) {
+    PyErr_SetString(PyExc_RuntimeError, "type not set");
+    FreeAll();
+    return NULL;
+  }
+  ds = plugin_get_ds(value_list.type);
+  if (ds == NULL) {
+    PyErr_Format(PyExc_TypeError, "Dataset %s not found", value_list.type);
+    return NULL;
+  }
+  if (meta != NULL && meta != Py_None && !PyDict_Check(meta)) {
+    PyErr_Format(PyExc_TypeError, "meta must be a dict");
+    return NULL;
+  }
+  value = cpy_build_values(ds, values);
+  if (value == NULL)
+    return NULL;
+  size = ds->ds_num;
   value_list.values = value;
   value_list.meta = cpy_build_meta(meta);
   value_list.values_len = size;
@@ -758,66 +879,10 @@ static PyObject *Values_write(Values *self, PyObject *args, PyObject *kwds) {
     PyErr_Format(PyExc_TypeError, "Dataset %s not found", value_list.type);
     return NULL;
   }
-  if (values == NULL ||
-      (PyTuple_Check(values) == 0 && PyList_Check(values) == 0)) {
-    PyErr_Format(PyExc_TypeError, "values must be list or tuple");
-    return NULL;
-  }
-  size = (size_t)PySequence_Length(values);
-  if (size != ds->ds_num) {
-    PyErr_Format(PyExc_RuntimeError,
-                 "type %s needs %" PRIsz " values, got %" PRIsz,
-                 value_list.type, ds->ds_num, size);
+  value = cpy_build_values(ds, values);
+  if (value == NULL)
     return NULL;
-  }
-  value = calloc(size, sizeof(*value));
-  for (size_t i = 0; i < size; ++i) {
-    PyObject *item, *num;
-    item = PySequence_Fast_GET_ITEM(values, i); /* Borrowed reference. */
-    switch (ds->ds[i].type) {
-    case DS_TYPE_COUNTER:
-      num = PyNumber_Long(item); /* New reference. */
-      if (num != NULL) {
-        value[i].counter = PyLong_AsUnsignedLongLong(num);
-        Py_XDECREF(num);
-      }
-      break;
-    case DS_TYPE_GAUGE:
-      num = PyNumber_Float(item); /* New reference. */
-      if (num != NULL) {
-        value[i].gauge = PyFloat_AsDouble(num);
-        Py_XDECREF(num);
-      }
-      break;
-    case DS_TYPE_DERIVE:
-      /* This might overflow without raising an exception.
-       * Not much we can do about it */
-      num = PyNumber_Long(item); /* New reference. */
-      if (num != NULL) {
-        value[i].derive = PyLong_AsLongLong(num);
-        Py_XDECREF(num);
-      }
-      break;
-    case DS_TYPE_ABSOLUTE:
-      /* This might overflow without raising an exception.
-       * Not much we can do about it */
-      num = PyNumber_Long(item); /* New reference. */
-      if (num != NULL) {
-        value[i].absolute = PyLong_AsUnsignedLongLong(num);
-        Py_XDECREF(num);
-      }
-      break;
-    default:
-      free(value);
-      PyErr_Format(PyExc_RuntimeError, "unknown data type %d for %s",
-                   ds->ds[i].type, value_list.type);
-      return NULL;
-    }
-    if (PyErr_Occurred() != NULL) {
-      free(value);
-      return NULL;
-    }
-  }
+  size = ds->ds_num;
   value_list.values = value;
   value_list.values_len = size;
   value_list.time = DOUBLE_TO_CDTIME_T(time);
@@ -840,49 +905,136 @@ static PyObject *Values_write(Values *self, PyObject *args, PyObject *kwds) {
   Py_RETURN_NONE;
 }
 
+/* Fills "vl" from a Values object, like Values.dispatch() does when called
+ * without arguments. */
+static int cpy_values_to_value_list(Values *v, value_list_t *vl) {
+  const data_set_t *ds;
+
+  if (v->data.type[0] == 0) {
+    PyErr_SetString(PyExc_RuntimeError, "type not set");
+    return -1;
+  }
+  ds = plugin_get_ds(v->data.type);
+  if (ds == NULL) {
+    PyErr_Format(PyExc_TypeError, "Dataset %s not found", v->data.type);
+    return -1;
+  }
+  if (v->meta != NULL && v->meta != Py_None && !PyDict_Check(v->meta)) {
+    PyErr_Format(PyExc_TypeError, "meta must be a dict");
+    return -1;
+  }
+  vl->values = cpy_build_values(ds, v->values);
+  if (vl->values == NULL)
+    return -1;
+  vl->values_len = ds->ds_num;
+
+  sstrncpy(vl->host, v->data.host[0] ? v->data.host : hostname_g,
+           sizeof(vl->host));
+  sstrncpy(vl->plugin, v->data.plugin[0] ? v->data.plugin : "python",
+           sizeof(vl->plugin));
+  sstrncpy(vl->plugin_instance, v->data.plugin_instance,
+           sizeof(vl->plugin_instance));
+  sstrncpy(vl->type, v->data.type, sizeof(vl->type));
+  sstrncpy(vl->type_instance, v->data.type_instance,
+           sizeof(vl->type_instance));
+  vl->time = DOUBLE_TO_CDTIME_T(v->data.time);
+  vl->interval = DOUBLE_TO_CDTIME_T(v->interval);
+  vl->meta = cpy_build_meta(v->meta);
+  return 0;
+}
+
+PyObject *cpy_dispatch_many(PyObject *self, PyObject *args) {
+  PyObject *seq, *list;
+  value_list_t *vls;
+  Py_ssize_t num, i;
+  int failed = 0;
+
+  if (!PyArg_ParseTuple(args, "O", &seq))
+    return NULL;
+  list = PySequence_Fast(seq, "values must be a sequence"); /* New reference. */
+  if (list == NULL)
+    return NULL;
+  num = PySequence_Fast_GET_SIZE(list);
+  if (num == 0) {
+    Py_DECREF(list);
+    Py_RETURN_NONE;
+  }
+  vls = calloc(num, sizeof(*vls));
+  if (vls == NULL) {
+    Py_DECREF(list);
+    return PyErr_NoMemory();
+  }
+
+  /* Convert everything first, so the GIL is released only once. */
+  for (i = 0; i < num; ++i) {
+    PyObject *item = PySequence_Fast_GET_ITEM(list, i); /* Borrowed reference */
+
+    if (!PyObject_TypeCheck(item, cpy_get_state()->values_type)) {
+      PyErr_Format(PyExc_TypeError, "item %zd is not a Values object", i);
+      break;
+    }
+    if (cpy_values_to_value_list((Values *)item, &vls[i]) != 0)
+      break;
+  }
+  Py_DECREF(list);
+
+  if (i == num) {
+    Py_BEGIN_ALLOW_THREADS;
+    for (Py_ssize_t j = 0; j < num; ++j)
+      if (plugin_dispatch_values(&vls[j]) != 0)
+        ++failed;
+    Py_END_ALLOW_THREADS;
+  }
+
+  for (Py_ssize_t j = 0; j < i; ++j) {
+    meta_data_destroy(vls[j].meta);
+    free(vls[j].values);
+  }
+  free(vls);
+
+  if (i != num)
+    return NULL;
+  if (failed != 0) {
+    PyErr_Format(PyExc_RuntimeError,
+                 "error dispatching %d of %zd value lists, read the logs",
+                 failed, num);
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
 static PyObject *Values_repr(PyObject *s) {
   PyObject *ret, *tmp;
-  static PyObject *l_interval, *l_values, *l_meta, *l_closing;
   Values *self = (Values *)s;
 
-  if (l_interval == NULL)
-    l_interval = cpy_string_to_unicode_or_bytes(",interval=");
-  if (l_values == NULL)
-    l_values = cpy_string_to_unicode_or_bytes(",values=");
-  if (l_meta == NULL)
-    l_meta = cpy_string_to_unicode_or_bytes(",meta=");
-  if (l_closing == NULL)
-    l_closing = cpy_string_to_unicode_or_bytes(")");
-
-  if (l_interval == NULL || l_values == NULL || l_meta == NULL ||
-      l_closing == NULL)
-    return NULL;
-
   ret = cpy_common_repr(s);
   if (self->interval != 0) {
-    CPY_STRCAT(&ret, l_interval);
+    cpy_strcat_string(&ret, ",interval=");
     tmp = PyFloat_FromDouble(self->interval);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
   if (self->values &&
       (!PyList_Check(self->values) || PySequence_Length(self->values) > 0)) {
-    CPY_STRCAT(&ret, l_values);
+    cpy_strcat_string(&ret, ",values=");
     tmp = PyObject_Repr(self->values);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
   if (self->meta &&
       (!PyDict_Check(self->meta) || PyDict_Size(self->meta) > 0)) {
-    CPY_STRCAT(&ret, l_meta);
+    cpy_strcat_string(&ret, ",meta=");
     tmp = PyObject_Repr(self->meta);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
-  CPY_STRCAT(&ret, l_closing);
+  cpy_strcat_string(&ret, ")");
   return ret;
 }
 
 static int Values_traverse(PyObject *self, visitproc visit, void *arg) {
   Values *v = (Values *)self;
+#ifdef CPY_SUB_INTERPRETERS
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(v->values);
   Py_VISIT(v->meta);
   return 0;
@@ -896,8 +1048,13 @@ static int Values_clear(PyObject *self) {
 }
 
 static void Values_dealloc(PyObject *self) {
+  PyTypeObject *type = Py_TYPE(self);
+
   Values_clear(self);
-  self->ob_type->tp_free(self);
+  type->tp_free(self);
+#ifdef CPY_SUB_INTERPRETERS
+  Py_DECREF(type); /* Instances of heap types hold a reference. */
+#endif
 }
 
 static PyMemberDef Values_members[] = {
@@ -913,6 +1070,23 @@ static PyMethodDef Values_methods[] = {
      write_doc},
     {NULL}};
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot Values_slots[] = {
+    {Py_tp_dealloc, Values_dealloc},   {Py_tp_repr, Values_repr},
+    {Py_tp_doc, Values_doc},           {Py_tp_traverse, Values_traverse},
+    {Py_tp_clear, Values_clear},       {Py_tp_methods, Values_methods},
+    {Py_tp_members, Values_members},   {Py_tp_init, Values_init},
+    {Py_tp_new, Values_new},           {0, NULL}};
+
+/* The base type, PluginData, is passed when creating the type. */
+PyType_Spec Values_spec = {
+    .name = "collectd.Values",
+    .basicsize = sizeof(Values),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = Values_slots,
+};
+#else
 PyTypeObject ValuesType = {
     CPY_INIT_TYPE "collectd.Values", /* tp_name */
     sizeof(Values),                  /* tp_basicsize */
@@ -952,6 +1126,7 @@ PyTypeObject ValuesType = {
     0,               /* tp_alloc */
     Values_new       /* tp_new */
 };
+#endif
 
 static char notification_meta_doc[] =
     "These are the meta data for the Notification object.\n"
@@ -1144,47 +1319,36 @@ static int Notification_setstring(PyObject *self, PyObject *value, void *data) {
 
 static PyObject *Notification_repr(PyObject *s) {
   PyObject *ret, *tmp;
-  static PyObject *l_severity, *l_message, *l_meta, *l_closing;
   Notification *self = (Notification *)s;
 
-  if (l_severity == NULL)
-    l_severity = cpy_string_to_unicode_or_bytes(",severity=");
-  if (l_message == NULL)
-    l_message = cpy_string_to_unicode_or_bytes(",message=");
-  if (l_meta == NULL)
-    l_meta = cpy_string_to_unicode_or_bytes(",meta=");
-  if (l_closing == NULL)
-    l_closing = cpy_string_to_unicode_or_bytes(")");
-
-  if (l_severity == NULL || l_message == NULL || l_meta == NULL ||
-      l_closing == NULL)
-    return NULL;
-
   ret = cpy_common_repr(s);
   if (self->severity != 0) {
-    CPY_STRCAT(&ret, l_severity);
+    cpy_strcat_string(&ret, ",severity=");
     tmp = PyInt_FromLong(self->severity);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
   if (self->message[0] != 0) {
-    CPY_STRCAT(&ret, l_message);
+    cpy_strcat_string(&ret, ",message=");
     tmp = cpy_string_to_unicode_or_bytes(self->message);
     CPY_SUBSTITUTE(PyObject_Repr, tmp, tmp);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
   if (self->meta &&
       (!PyDict_Check(self->meta) || PyDict_Size(self->meta) > 0)) {
-    CPY_STRCAT(&ret, l_meta);
+    cpy_strcat_string(&ret, ",meta=");
     tmp = PyObject_Repr(self->meta);
     CPY_STRCAT_AND_DEL(&ret, tmp);
   }
-  CPY_STRCAT(&ret, l_closing);
+  cpy_strcat_string(&ret, ")");
   return ret;
 }
 
 static int Notification_traverse(PyObject *self, visitproc visit, void *arg) {
   Notification *n = (Notification *)self;
+#ifdef CPY_SUB_INTERPRETERS
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(n->meta);
   return 0;
 }
@@ -1196,8 +1360,13 @@ static int Notification_clear(PyObject *self) {
 }
 
 static void Notification_dealloc(PyObject *self) {
+  PyTypeObject *type = Py_TYPE(self);
+
   Notification_clear(self);
-  self->ob_type->tp_free(self);
+  type->tp_free(self);
+#ifdef CPY_SUB_INTERPRETERS
+  Py_DECREF(type); /* Instances of heap types hold a reference. */
+#endif
 }
 
 static PyMethodDef Notification_methods[] = {
@@ -1216,6 +1385,29 @@ static PyGetSetDef Notification_getseters[] = {
      (void *)offsetof(Notification, message)},
     {NULL}};
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot Notification_slots[] = {
+    {Py_tp_dealloc, Notification_dealloc},
+    {Py_tp_repr, Notification_repr},
+    {Py_tp_doc, Notification_doc},
+    {Py_tp_traverse, Notification_traverse},
+    {Py_tp_clear, Notification_clear},
+    {Py_tp_methods, Notification_methods},
+    {Py_tp_members, Notification_members},
+    {Py_tp_getset, Notification_getseters},
+    {Py_tp_init, Notification_init},
+    {Py_tp_new, Notification_new},
+    {0, NULL}};
+
+/* The base type, PluginData, is passed when creating the type. */
+PyType_Spec Notification_spec = {
+    .name = "collectd.Notification",
+    .basicsize = sizeof(Notification),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = Notification_slots,
+};
+#else
 PyTypeObject NotificationType = {
     CPY_INIT_TYPE "collectd.Notification", /* tp_name */
     sizeof(Notification),                  /* tp_basicsize */
@@ -1255,11 +1447,24 @@ PyTypeObject NotificationType = {
     0,                      /* tp_alloc */
     Notification_new        /* tp_new */
 };
+#endif
 
 static char Signed_doc[] =
     "This is a long by another name. Use it in meta data dicts\n"
     "to choose the way it is stored in the meta data.";
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot Signed_slots[] = {{Py_tp_doc, Signed_doc}, {0, NULL}};
+
+/* Subclass of int. The size is inherited from the base type, which is passed
+ * when creating the type. */
+PyType_Spec Signed_spec = {
+    .name = "collectd.Signed",
+    .flags =
+        Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = Signed_slots,
+};
+#else
 PyTypeObject SignedType = {
     CPY_INIT_TYPE "collectd.Signed",          /* tp_name */
     sizeof(Signed),                           /* tp_basicsize */
@@ -1282,11 +1487,24 @@ PyTypeObject SignedType = {
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* tp_flags */
     Signed_doc                                /* tp_doc */
 };
+#endif
 
 static char Unsigned_doc[] =
     "This is a long by another name. Use it in meta data dicts\n"
     "to choose the way it is stored in the meta data.";
 
+#ifdef CPY_SUB_INTERPRETERS
+static PyType_Slot Unsigned_slots[] = {{Py_tp_doc, Unsigned_doc},
+                                        {0, NULL}};
+
+/* Subclass of int, see Signed_spec. */
+PyType_Spec Unsigned_spec = {
+    .name = "collectd.Unsigned",
+    .flags =
+        Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_IMMUTABLETYPE,
+    .slots = Unsigned_slots,
+};
+#else
 PyTypeObject UnsignedType = {
     CPY_INIT_TYPE "collectd.Unsigned",        /* tp_name */
     sizeof(Unsigned),                         /* tp_basicsize */
@@ -1309,3 +1527,4 @@ PyTypeObject UnsignedType = {
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* tp_flags */
     Unsigned_doc                              /* tp_doc */
 };
+#endif
@@ -0,0 +1,136 @@
+/**
+ * collectd - src/pyvalues_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "pyvalues.c" /* sic */
+#include "testing.h"
+
+/* Defined in python.c, which is not part of the test. */
+void cpy_log_exception(const char *context) { PyErr_Clear(); }
+
+static data_source_t test_dsrc[] = {
+    {"one", DS_TYPE_DERIVE, NAN, NAN},
+    {"two", DS_TYPE_GAUGE, NAN, NAN},
+};
+static data_set_t test_ds = {"test", STATIC_ARRAY_SIZE(test_dsrc), test_dsrc};
+
+/* Converts two items of `itemsize' bytes, described by `format'. */
+static int build(char const *format, Py_ssize_t itemsize, void *items,
+                 value_t *values) {
+  Py_ssize_t shape = 2;
+  Py_buffer view = {
+      .buf = items,
+      .len = 2 * itemsize,
+      .itemsize = itemsize,
+      .readonly = 1,
+      .ndim = 1,
+      .format = (char *)format,
+      .shape = &shape,
+      .strides = &itemsize,
+  };
+
+  PyObject *mv = PyMemoryView_FromBuffer(&view); /* New reference. */
+  if (mv == NULL)
+    return -1;
+
+  int status = cpy_build_values_from_buffer(&test_ds, mv, values);
+  Py_DECREF(mv);
+  PyErr_Clear();
+  return status;
+}
+
+DEF_TEST(buffer_formats) {
+  value_t values[2];
+
+  int32_t i32[] = {-3, 42};
+  /* Standard size: "l" is four bytes, whatever the size of long is. */
+  CHECK_ZERO(build("=l", sizeof(int32_t), i32, values));
+  EXPECT_EQ_INT(-3, values[0].derive);
+  EXPECT_EQ_DOUBLE(42.0, values[1].gauge);
+
+  long native[] = {-5, 7};
+  CHECK_ZERO(build("l", sizeof(long), native, values));
+  EXPECT_EQ_INT(-5, values[0].derive);
+  EXPECT_EQ_DOUBLE(7.0, values[1].gauge);
+
+  uint16_t u16[] = {65535, 1};
+  CHECK_ZERO(build("=H", sizeof(uint16_t), u16, values));
+  EXPECT_EQ_INT(65535, values[0].derive);
+  EXPECT_EQ_DOUBLE(1.0, values[1].gauge);
+
+  int64_t i64[] = {INT64_MIN, 9};
+  CHECK_ZERO(build("=q", sizeof(int64_t), i64, values));
+  OK(values[0].derive == INT64_MIN);
+
+  double d[] = {1.9, 0.25};
+  CHECK_ZERO(build("d", sizeof(double), d, values));
+  EXPECT_EQ_INT(1, values[0].derive);
+  EXPECT_EQ_DOUBLE(0.25, values[1].gauge);
+
+  float f[] = {2.5, -0.5};
+  CHECK_ZERO(build("=f", sizeof(float), f, values));
+  EXPECT_EQ_DOUBLE(-0.5, values[1].gauge);
+
+  return 0;
+}
+
+DEF_TEST(buffer_errors) {
+  value_t values[2];
+  int32_t i32[] = {1, 2};
+
+  /* The item size must match the format. */
+  EXPECT_EQ_INT(-1, build("f", 2, i32, values));
+  EXPECT_EQ_INT(-1, build("=l", 3, i32, values));
+  /* Non-native byte order and unsupported types. */
+  EXPECT_EQ_INT(-1, build("<l", sizeof(int32_t), i32, values));
+  EXPECT_EQ_INT(-1, build("e", 2, i32, values));
+  EXPECT_EQ_INT(-1, build("", sizeof(int32_t), i32, values));
+
+  /* The number of items must match the data set. */
+  Py_ssize_t shape = 1, itemsize = sizeof(int32_t);
+  Py_buffer view = {
+      .buf = i32,
+      .len = sizeof(int32_t),
+      .itemsize = itemsize,
+      .readonly = 1,
+      .ndim = 1,
+      .format = "i",
+      .shape = &shape,
+      .strides = &itemsize,
+  };
+  PyObject *mv = PyMemoryView_FromBuffer(&view);
+  EXPECT_EQ_INT(-1, cpy_build_values_from_buffer(&test_ds, mv, values));
+  Py_DECREF(mv);
+  PyErr_Clear();
+
+  return 0;
+}
+
+int main(void) {
+  Py_Initialize();
+
+  RUN_TEST(buffer_formats);
+  RUN_TEST(buffer_errors);
+
+  Py_Finalize();
+  END_TEST;
+}
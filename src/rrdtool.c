@@ -29,6 +29,7 @@
 #include "utils/avltree/avltree.h"
 #include "utils/common/common.h"
 #include "utils/rrdcreate/rrdcreate.h"
+#include "utils/serialize/serialize.h"
 #include "utils_random.h"
 
 #include <rrd.h>
@@ -163,6 +164,40 @@ static int srrd_update(char *filename, char *template, int argc,
 } /* int srrd_update */
 #endif /* !HAVE_THREADSAFE_LIBRRD */
 
+/* Writes `separator' followed by `value' to `buffer'. Returns the number of
+ * bytes written or a negative error code. */
+static int value_to_string(char *buffer, int buffer_len, char separator,
+                           int ds_type, value_t value) {
+  int status;
+
+  if (buffer_len < 2)
+    return -ENOMEM;
+  buffer[0] = separator;
+
+  switch (ds_type) {
+  case DS_TYPE_COUNTER:
+    status = serialize_uint64(buffer + 1, buffer_len - 1,
+                              (uint64_t)value.counter);
+    break;
+  case DS_TYPE_GAUGE:
+    status = serialize_gauge(buffer + 1, buffer_len - 1, value.gauge);
+    break;
+  case DS_TYPE_DERIVE:
+    status = serialize_int64(buffer + 1, buffer_len - 1, value.derive);
+    break;
+  case DS_TYPE_ABSOLUTE:
+    status = serialize_uint64(buffer + 1, buffer_len - 1, value.absolute);
+    break;
+  default:
+    return -EINVAL;
+  }
+
+  if (status >= (buffer_len - 1))
+    return -ENOMEM;
+
+  return status + 1;
+} /* int value_to_string */
+
 static int value_list_to_string_multiple(char *buffer, int buffer_len,
                                          const data_set_t *ds,
                                          const value_list_t *vl) {
@@ -173,32 +208,15 @@ static int value_list_to_string_multiple(char *buffer, int buffer_len,
   memset(buffer, '\0', buffer_len);
 
   tt = CDTIME_T_TO_TIME_T(vl->time);
-  status = ssnprintf(buffer, buffer_len, "%u", (unsigned int)tt);
+  status = serialize_uint64(buffer, buffer_len, (unsigned int)tt);
   if ((status < 1) || (status >= buffer_len))
     return -1;
   offset = status;
 
   for (size_t i = 0; i < ds->ds_num; i++) {
-    if ((ds->ds[i].type != DS_TYPE_COUNTER) &&
-        (ds->ds[i].type != DS_TYPE_GAUGE) &&
-        (ds->ds[i].type != DS_TYPE_DERIVE) &&
-        (ds->ds[i].type != DS_TYPE_ABSOLUTE))
-      return -1;
-
-    if (ds->ds[i].type == DS_TYPE_COUNTER)
-      status = ssnprintf(buffer + offset, buffer_len - offset, ":%" PRIu64,
-                         (uint64_t)vl->values[i].counter);
-    else if (ds->ds[i].type == DS_TYPE_GAUGE)
-      status = ssnprintf(buffer + offset, buffer_len - offset, ":" GAUGE_FORMAT,
-                         vl->values[i].gauge);
-    else if (ds->ds[i].type == DS_TYPE_DERIVE)
-      status = ssnprintf(buffer + offset, buffer_len - offset, ":%" PRIi64,
-                         vl->values[i].derive);
-    else /*if (ds->ds[i].type == DS_TYPE_ABSOLUTE) */
-      status = ssnprintf(buffer + offset, buffer_len - offset, ":%" PRIu64,
-                         vl->values[i].absolute);
-
-    if ((status < 1) || (status >= (buffer_len - offset)))
+    status = value_to_string(buffer + offset, buffer_len - offset, ':',
+                             ds->ds[i].type, vl->values[i]);
+    if (status < 0)
       return -1;
 
     offset += status;
@@ -216,30 +234,15 @@ static int value_list_to_string(char *buffer, int buffer_len,
     return value_list_to_string_multiple(buffer, buffer_len, ds, vl);
 
   tt = CDTIME_T_TO_TIME_T(vl->time);
-  switch (ds->ds[0].type) {
-  case DS_TYPE_DERIVE:
-    status = ssnprintf(buffer, buffer_len, "%u:%" PRIi64, (unsigned)tt,
-                       vl->values[0].derive);
-    break;
-  case DS_TYPE_GAUGE:
-    status = ssnprintf(buffer, buffer_len, "%u:" GAUGE_FORMAT, (unsigned)tt,
-                       vl->values[0].gauge);
-    break;
-  case DS_TYPE_COUNTER:
-    status = ssnprintf(buffer, buffer_len, "%u:%" PRIu64, (unsigned)tt,
-                       (uint64_t)vl->values[0].counter);
-    break;
-  case DS_TYPE_ABSOLUTE:
-    status = ssnprintf(buffer, buffer_len, "%u:%" PRIu64, (unsigned)tt,
-                       vl->values[0].absolute);
-    break;
-  default:
-    return EINVAL;
-  }
-
+  status = serialize_uint64(buffer, buffer_len, (unsigned)tt);
   if ((status < 1) || (status >= buffer_len))
     return ENOMEM;
 
+  status = value_to_string(buffer + status, buffer_len - status, ':',
+                           ds->ds[0].type, vl->values[0]);
+  if (status < 0)
+    return -status;
+
   return 0;
 } /* int value_list_to_string */
 
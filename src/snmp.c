@@ -33,6 +33,7 @@
 
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/library/large_fd_set.h>
 
 #include <fnmatch.h>
 
@@ -101,6 +102,8 @@ struct host_definition_s {
   data_definition_t **data_list;
   int data_list_len;
   int bulk_size;
+  int max_inflight;
+  bool polling; /* job submitted to the asynchronous engine */
 };
 typedef struct host_definition_s host_definition_t;
 
@@ -133,11 +136,13 @@ typedef enum {
  * Private variables
  */
 static data_definition_t *data_head;
+static bool csnmp_async;
 
 /*
  * Prototypes
  */
 static int csnmp_read_host(user_data_t *ud);
+static void csnmp_engine_stop(void);
 
 /*
  * Private functions
@@ -202,6 +207,11 @@ static void csnmp_host_definition_destroy(void *arg) /* {{{ */
     DEBUG("snmp plugin: Destroying host definition for host `%s'.", hd->name);
   }
 
+  /* Hosts are destroyed on shutdown, before `csnmp_shutdown' is called. The
+   * engine thread may still be using this host and its session, so it has to
+   * be stopped first. */
+  csnmp_engine_stop();
+
   csnmp_host_close_session(hd);
 
   sfree(hd->name);
@@ -772,6 +782,7 @@ static int csnmp_config_add_host(oconfig_item_t *ci) {
   hd->timeout = 0;
   hd->retries = -1;
   hd->bulk_size = 0;
+  hd->max_inflight = 1;
 
   for (int i = 0; i < ci->children_num; i++) {
     oconfig_item_t *option = ci->children + i;
@@ -806,6 +817,8 @@ static int csnmp_config_add_host(oconfig_item_t *ci) {
       status = cf_util_get_string(option, &hd->context);
     else if (strcasecmp("BulkSize", option->key) == 0)
       status = cf_util_get_int(option, &hd->bulk_size);
+    else if (strcasecmp("MaxInflight", option->key) == 0)
+      status = cf_util_get_int(option, &hd->max_inflight);
     else {
       WARNING(
           "snmp plugin: csnmp_config_add_host: Option `%s' not allowed here.",
@@ -913,6 +926,8 @@ static int csnmp_config(oconfig_item_t *ci) {
       csnmp_config_add_data(child);
     else if (strcasecmp("Host", child->key) == 0)
       csnmp_config_add_host(child);
+    else if (strcasecmp("Asynchronous", child->key) == 0)
+      cf_util_get_boolean(child, &csnmp_async);
     else {
       WARNING("snmp plugin: Ignoring unknown config option `%s'.", child->key);
     }
@@ -1608,63 +1623,106 @@ static int csnmp_dispatch_table(host_definition_t *host,
   return 0;
 } /* int csnmp_dispatch_table */
 
-static int csnmp_read_table(host_definition_t *host, data_definition_t *data) {
-  struct snmp_pdu *req;
-  struct snmp_pdu *res = NULL;
-  struct variable_list *vb;
-
+/* State of a table walk. The walk is driven either synchronously by
+ * `csnmp_read_table' or by the asynchronous engine. */
+struct csnmp_table_walk_s {
+  host_definition_t *host;
+  data_definition_t *data;
   const data_set_t *ds;
 
-  size_t oid_list_len = data->values_len;
-
-  if (data->type_instance.oid.oid_len > 0)
-    oid_list_len++;
-
-  if (data->plugin_instance.oid.oid_len > 0)
-    oid_list_len++;
-
-  if (data->host.oid.oid_len > 0)
-    oid_list_len++;
-
-  if (data->filter_oid.oid_len > 0)
-    oid_list_len++;
-
   /* Holds the last OID returned by the device. We use this in the GETNEXT
    * request to proceed. */
-  oid_t oid_list[oid_list_len];
+  oid_t *oid_list;
   /* Set to false when an OID has left its subtree so we don't re-request it
    * again. */
-  csnmp_oid_type_t oid_list_todo[oid_list_len];
+  csnmp_oid_type_t *oid_list_todo;
+  size_t oid_list_len;
 
-  int status;
-  size_t i;
+  /* Maps variables of the last request to `oid_list' entries. */
+  size_t *var_idx;
+  size_t oid_list_todo_num;
 
   /* `value_list_head' and `value_cells_tail' implement a linked list for each
    * value. `instance_cells_head' and `instance_cells_tail' implement a linked
    * list of instance names. This is used to jump gaps in the table. */
-  csnmp_cell_char_t *type_instance_cells_head = NULL;
-  csnmp_cell_char_t *type_instance_cells_tail = NULL;
-  csnmp_cell_char_t *plugin_instance_cells_head = NULL;
-  csnmp_cell_char_t *plugin_instance_cells_tail = NULL;
-  csnmp_cell_char_t *hostname_cells_head = NULL;
-  csnmp_cell_char_t *hostname_cells_tail = NULL;
-  csnmp_cell_char_t *filter_cells_head = NULL;
-  csnmp_cell_char_t *filter_cells_tail = NULL;
+  csnmp_cell_char_t *type_instance_cells_head;
+  csnmp_cell_char_t *type_instance_cells_tail;
+  csnmp_cell_char_t *plugin_instance_cells_head;
+  csnmp_cell_char_t *plugin_instance_cells_tail;
+  csnmp_cell_char_t *hostname_cells_head;
+  csnmp_cell_char_t *hostname_cells_tail;
+  csnmp_cell_char_t *filter_cells_head;
+  csnmp_cell_char_t *filter_cells_tail;
   csnmp_cell_value_t **value_cells_head;
   csnmp_cell_value_t **value_cells_tail;
+};
+typedef struct csnmp_table_walk_s csnmp_table_walk_t;
 
-  DEBUG("snmp plugin: csnmp_read_table (host = %s, data = %s)", host->name,
-        data->name);
+/* Frees the table walk. If `dispatch' is true, the values collected so far
+ * are dispatched first. */
+static void csnmp_table_walk_destroy(csnmp_table_walk_t *walk, bool dispatch) {
+  if (walk == NULL)
+    return;
 
-  if (host->sess_handle == NULL) {
-    DEBUG("snmp plugin: csnmp_read_table: host->sess_handle == NULL");
-    return -1;
+  if (dispatch)
+    csnmp_dispatch_table(walk->host, walk->data,
+                         walk->type_instance_cells_head,
+                         walk->plugin_instance_cells_head,
+                         walk->hostname_cells_head, walk->filter_cells_head,
+                         walk->value_cells_head, walk->data->count);
+
+  /* Free all allocated variables here */
+  while (walk->type_instance_cells_head != NULL) {
+    csnmp_cell_char_t *next = walk->type_instance_cells_head->next;
+    sfree(walk->type_instance_cells_head);
+    walk->type_instance_cells_head = next;
+  }
+
+  while (walk->plugin_instance_cells_head != NULL) {
+    csnmp_cell_char_t *next = walk->plugin_instance_cells_head->next;
+    sfree(walk->plugin_instance_cells_head);
+    walk->plugin_instance_cells_head = next;
+  }
+
+  while (walk->hostname_cells_head != NULL) {
+    csnmp_cell_char_t *next = walk->hostname_cells_head->next;
+    sfree(walk->hostname_cells_head);
+    walk->hostname_cells_head = next;
+  }
+
+  while (walk->filter_cells_head != NULL) {
+    csnmp_cell_char_t *next = walk->filter_cells_head->next;
+    sfree(walk->filter_cells_head);
+    walk->filter_cells_head = next;
+  }
+
+  for (size_t i = 0; (walk->value_cells_head != NULL) &&
+                     (i < walk->data->values_len);
+       i++) {
+    while (walk->value_cells_head[i] != NULL) {
+      csnmp_cell_value_t *next = walk->value_cells_head[i]->next;
+      sfree(walk->value_cells_head[i]);
+      walk->value_cells_head[i] = next;
+    }
   }
 
+  sfree(walk->value_cells_head);
+  sfree(walk->value_cells_tail);
+  sfree(walk->oid_list);
+  sfree(walk->oid_list_todo);
+  sfree(walk->var_idx);
+  sfree(walk);
+} /* void csnmp_table_walk_destroy */
+
+static csnmp_table_walk_t *csnmp_table_walk_create(host_definition_t *host,
+                                                   data_definition_t *data) {
+  const data_set_t *ds;
+  size_t i;
+
   ds = plugin_get_ds(data->type);
   if (!ds) {
     ERROR("snmp plugin: DataSet `%s' not defined.", data->type);
-    return -1;
+    return NULL;
   }
 
   if (data->count) {
@@ -1672,7 +1730,7 @@ static int csnmp_read_table(host_definition_t *host, data_definition_t *data) {
       ERROR("snmp plugin: DataSet `%s' requires %" PRIsz
             " values, but `Count' option only delivers one",
             data->type, ds->ds_num);
-      return -1;
+      return NULL;
     }
   } else {
     if (ds->ds_num != data->values_len) {
@@ -1680,436 +1738,453 @@ static int csnmp_read_table(host_definition_t *host, data_definition_t *data) {
             " values, but config talks "
             "about %" PRIsz,
             data->type, ds->ds_num, data->values_len);
-      return -1;
+      return NULL;
     }
   }
   assert(data->values_len > 0);
 
+  csnmp_table_walk_t *walk = calloc(1, sizeof(*walk));
+  if (walk == NULL) {
+    ERROR("snmp plugin: csnmp_table_walk_create: calloc failed.");
+    return NULL;
+  }
+  walk->host = host;
+  walk->data = data;
+  walk->ds = ds;
+
+  walk->oid_list_len = data->values_len;
+
+  if (data->type_instance.oid.oid_len > 0)
+    walk->oid_list_len++;
+
+  if (data->plugin_instance.oid.oid_len > 0)
+    walk->oid_list_len++;
+
+  if (data->host.oid.oid_len > 0)
+    walk->oid_list_len++;
+
+  if (data->filter_oid.oid_len > 0)
+    walk->oid_list_len++;
+
+  walk->oid_list = calloc(walk->oid_list_len, sizeof(*walk->oid_list));
+  walk->oid_list_todo =
+      calloc(walk->oid_list_len, sizeof(*walk->oid_list_todo));
+  walk->var_idx = calloc(walk->oid_list_len, sizeof(*walk->var_idx));
+
+  /* We're going to construct n linked lists, one for each "value".
+   * value_cells_head will contain pointers to the heads of these linked lists,
+   * value_cells_tail will contain pointers to the tail of the lists. */
+  walk->value_cells_head =
+      calloc(data->values_len, sizeof(*walk->value_cells_head));
+  walk->value_cells_tail =
+      calloc(data->values_len, sizeof(*walk->value_cells_tail));
+
+  if ((walk->oid_list == NULL) || (walk->oid_list_todo == NULL) ||
+      (walk->var_idx == NULL) || (walk->value_cells_head == NULL) ||
+      (walk->value_cells_tail == NULL)) {
+    ERROR("snmp plugin: csnmp_table_walk_create: calloc failed.");
+    csnmp_table_walk_destroy(walk, /* dispatch = */ false);
+    return NULL;
+  }
+
   for (i = 0; i < data->values_len; i++)
-    oid_list_todo[i] = OID_TYPE_VARIABLE;
+    walk->oid_list_todo[i] = OID_TYPE_VARIABLE;
 
   /* We need a copy of all the OIDs, because GETNEXT will destroy them. */
-  memcpy(oid_list, data->values, data->values_len * sizeof(oid_t));
+  memcpy(walk->oid_list, data->values, data->values_len * sizeof(oid_t));
 
   if (data->type_instance.oid.oid_len > 0) {
-    memcpy(oid_list + i, &data->type_instance.oid, sizeof(oid_t));
-    oid_list_todo[i] = OID_TYPE_TYPEINSTANCE;
+    memcpy(walk->oid_list + i, &data->type_instance.oid, sizeof(oid_t));
+    walk->oid_list_todo[i] = OID_TYPE_TYPEINSTANCE;
     i++;
   }
 
   if (data->plugin_instance.oid.oid_len > 0) {
-    memcpy(oid_list + i, &data->plugin_instance.oid, sizeof(oid_t));
-    oid_list_todo[i] = OID_TYPE_PLUGININSTANCE;
+    memcpy(walk->oid_list + i, &data->plugin_instance.oid, sizeof(oid_t));
+    walk->oid_list_todo[i] = OID_TYPE_PLUGININSTANCE;
     i++;
   }
 
   if (data->host.oid.oid_len > 0) {
-    memcpy(oid_list + i, &data->host.oid, sizeof(oid_t));
-    oid_list_todo[i] = OID_TYPE_HOST;
+    memcpy(walk->oid_list + i, &data->host.oid, sizeof(oid_t));
+    walk->oid_list_todo[i] = OID_TYPE_HOST;
     i++;
   }
 
   if (data->filter_oid.oid_len > 0) {
-    memcpy(oid_list + i, &data->filter_oid, sizeof(oid_t));
-    oid_list_todo[i] = OID_TYPE_FILTER;
+    memcpy(walk->oid_list + i, &data->filter_oid, sizeof(oid_t));
+    walk->oid_list_todo[i] = OID_TYPE_FILTER;
     i++;
   }
 
-  /* We're going to construct n linked lists, one for each "value".
-   * value_cells_head will contain pointers to the heads of these linked lists,
-   * value_cells_tail will contain pointers to the tail of the lists. */
-  value_cells_head = calloc(data->values_len, sizeof(*value_cells_head));
-  value_cells_tail = calloc(data->values_len, sizeof(*value_cells_tail));
-  if ((value_cells_head == NULL) || (value_cells_tail == NULL)) {
-    ERROR("snmp plugin: csnmp_read_table: calloc failed.");
-    sfree(value_cells_head);
-    sfree(value_cells_tail);
-    return -1;
-  }
+  return walk;
+} /* csnmp_table_walk_t *csnmp_table_walk_create */
 
-  status = 0;
-  while (status == 0) {
-    /* If SNMP v2 and later and bulk transfers enabled, use GETBULK PDU */
-    if (host->version > 1 && host->bulk_size > 0) {
-      req = snmp_pdu_create(SNMP_MSG_GETBULK);
+/* Creates the next request of the table walk. Sets `ret_req' to NULL if all
+ * variables have left their subtree, i.e. the walk is finished. */
+static int csnmp_table_walk_request(csnmp_table_walk_t *walk,
+                                    struct snmp_pdu **ret_req) {
+  host_definition_t *host = walk->host;
+  struct snmp_pdu *req;
+
+  *ret_req = NULL;
+
+  /* If SNMP v2 and later and bulk transfers enabled, use GETBULK PDU */
+  if (host->version > 1 && host->bulk_size > 0) {
+    req = snmp_pdu_create(SNMP_MSG_GETBULK);
+    if (req != NULL) {
       req->non_repeaters = 0;
       req->max_repetitions = host->bulk_size;
-    } else {
-      req = snmp_pdu_create(SNMP_MSG_GETNEXT);
-    }
-    if (req == NULL) {
-      ERROR("snmp plugin: snmp_pdu_create failed.");
-      status = -1;
-      break;
     }
+  } else {
+    req = snmp_pdu_create(SNMP_MSG_GETNEXT);
+  }
+  if (req == NULL) {
+    ERROR("snmp plugin: snmp_pdu_create failed.");
+    return -1;
+  }
 
-    size_t oid_list_todo_num = 0;
-    size_t var_idx[oid_list_len];
-    memset(var_idx, 0, sizeof(var_idx));
+  walk->oid_list_todo_num = 0;
+  memset(walk->var_idx, 0, walk->oid_list_len * sizeof(*walk->var_idx));
 
-    for (i = 0; i < oid_list_len; i++) {
-      /* Do not rerequest already finished OIDs */
-      if (!oid_list_todo[i])
-        continue;
-      snmp_add_null_var(req, oid_list[i].oid, oid_list[i].oid_len);
-      var_idx[oid_list_todo_num] = i;
-      oid_list_todo_num++;
-    }
+  for (size_t i = 0; i < walk->oid_list_len; i++) {
+    /* Do not rerequest already finished OIDs */
+    if (!walk->oid_list_todo[i])
+      continue;
+    snmp_add_null_var(req, walk->oid_list[i].oid, walk->oid_list[i].oid_len);
+    walk->var_idx[walk->oid_list_todo_num] = i;
+    walk->oid_list_todo_num++;
+  }
 
-    if (oid_list_todo_num == 0) {
-      /* The request is still empty - so we are finished */
-      DEBUG("snmp plugin: all variables have left their subtree");
-      snmp_free_pdu(req);
-      status = 0;
-      break;
-    }
+  if (walk->oid_list_todo_num == 0) {
+    /* The request is still empty - so we are finished */
+    DEBUG("snmp plugin: all variables have left their subtree");
+    snmp_free_pdu(req);
+    return 0;
+  }
 
-    if (req->command == SNMP_MSG_GETBULK) {
-      /* In bulk mode the host will send 'max_repetitions' values per
-         requested variable, so we need to split it per number of variable
-         to stay 'in budget' */
-      req->max_repetitions = floor(host->bulk_size / oid_list_todo_num);
-    }
+  if (req->command == SNMP_MSG_GETBULK) {
+    /* In bulk mode the host will send 'max_repetitions' values per
+       requested variable, so we need to split it per number of variable
+       to stay 'in budget' */
+    req->max_repetitions = floor(host->bulk_size / walk->oid_list_todo_num);
+  }
 
-    res = NULL;
-    status = snmp_sess_synch_response(host->sess_handle, req, &res);
+  *ret_req = req;
+  return 0;
+} /* int csnmp_table_walk_request */
+
+/* Processes the response to the last request of the table walk. The response
+ * is not freed. */
+static int csnmp_table_walk_response(csnmp_table_walk_t *walk,
+                                     struct snmp_pdu *res) {
+  host_definition_t *host = walk->host;
+  data_definition_t *data = walk->data;
+  csnmp_oid_type_t *oid_list_todo = walk->oid_list_todo;
+  size_t oid_list_len = walk->oid_list_len;
+  size_t oid_list_todo_num = walk->oid_list_todo_num;
+  struct variable_list *vb;
+  size_t i;
 
-    /* snmp_sess_synch_response always frees our req PDU */
-    req = NULL;
+  vb = res->variables;
+  if (vb == NULL)
+    return -1;
 
-    if ((status != STAT_SUCCESS) || (res == NULL)) {
-      char *errstr = NULL;
+  if (res->errstat != SNMP_ERR_NOERROR) {
+    if (res->errindex != 0) {
+      /* Find the OID which caused error */
+      for (i = 1, vb = res->variables; vb != NULL && i != res->errindex;
+           vb = vb->next_variable, i++)
+        /* do nothing */;
+    }
 
-      snmp_sess_error(host->sess_handle, NULL, NULL, &errstr);
+    if ((res->errindex == 0) || (vb == NULL)) {
+      ERROR("snmp plugin: host %s; data %s: response error: %s (%li) ",
+            host->name, data->name, snmp_errstring(res->errstat),
+            res->errstat);
+      return -1;
+    }
 
-      c_complain(LOG_ERR, &host->complaint,
-                 "snmp plugin: host %s: snmp_sess_synch_response failed: %s",
-                 host->name, (errstr == NULL) ? "Unknown problem" : errstr);
+    char oid_buffer[1024] = {0};
+    snprint_objid(oid_buffer, sizeof(oid_buffer) - 1, vb->name,
+                  vb->name_length);
+    NOTICE("snmp plugin: host %s; data %s: OID `%s` failed: %s", host->name,
+           data->name, oid_buffer, snmp_errstring(res->errstat));
 
-      if (res != NULL)
-        snmp_free_pdu(res);
-      res = NULL;
+    /* Get value index from todo list and skip OID found */
+    assert(res->errindex <= oid_list_todo_num);
+    i = walk->var_idx[res->errindex - 1];
+    assert(i < oid_list_len);
+    oid_list_todo[i] = 0;
 
-      sfree(errstr);
-      csnmp_host_close_session(host);
+    return 0;
+  }
 
-      status = -1;
-      break;
+  size_t j;
+  for (vb = res->variables, j = 0; (vb != NULL); vb = vb->next_variable, j++) {
+    i = j;
+    /* If bulk request is active convert value index of the extra value */
+    if (host->version > 1 && host->bulk_size > 0) {
+      i %= oid_list_todo_num;
     }
-
-    status = 0;
-    assert(res != NULL);
-    c_release(LOG_INFO, &host->complaint,
-              "snmp plugin: host %s: snmp_sess_synch_response successful.",
-              host->name);
-
-    vb = res->variables;
-    if (vb == NULL) {
-      status = -1;
+    /* Calculate value index from todo list */
+    while ((i < oid_list_len) && !oid_list_todo[i]) {
+      i++;
+      j++;
+    }
+    if (i >= oid_list_len) {
       break;
     }
 
-    if (res->errstat != SNMP_ERR_NOERROR) {
-      if (res->errindex != 0) {
-        /* Find the OID which caused error */
-        for (i = 1, vb = res->variables; vb != NULL && i != res->errindex;
-             vb = vb->next_variable, i++)
-          /* do nothing */;
+    /* An instance is configured and the res variable we process is the
+     * instance value */
+    if (oid_list_todo[i] == OID_TYPE_TYPEINSTANCE) {
+      if ((vb->type == SNMP_ENDOFMIBVIEW) ||
+          (snmp_oid_ncompare(
+               data->type_instance.oid.oid, data->type_instance.oid.oid_len,
+               vb->name, vb->name_length, data->type_instance.oid.oid_len) !=
+           0)) {
+        DEBUG("snmp plugin: host = %s; data = %s; TypeInstance left its "
+              "subtree.",
+              host->name, data->name);
+        oid_list_todo[i] = 0;
+        continue;
       }
 
-      if ((res->errindex == 0) || (vb == NULL)) {
-        ERROR("snmp plugin: host %s; data %s: response error: %s (%li) ",
-              host->name, data->name, snmp_errstring(res->errstat),
-              res->errstat);
-        status = -1;
-        break;
+      /* Allocate a new `csnmp_cell_char_t', insert the instance name and
+       * add it to the list */
+      csnmp_cell_char_t *cell =
+          csnmp_get_char_cell(vb, &data->type_instance.oid, host, data);
+      if (cell == NULL) {
+        ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
+              host->name);
+        return -1;
       }
 
-      char oid_buffer[1024] = {0};
-      snprint_objid(oid_buffer, sizeof(oid_buffer) - 1, vb->name,
-                    vb->name_length);
-      NOTICE("snmp plugin: host %s; data %s: OID `%s` failed: %s", host->name,
-             data->name, oid_buffer, snmp_errstring(res->errstat));
-
-      /* Get value index from todo list and skip OID found */
-      assert(res->errindex <= oid_list_todo_num);
-      i = var_idx[res->errindex - 1];
-      assert(i < oid_list_len);
-      oid_list_todo[i] = 0;
-
-      snmp_free_pdu(res);
-      res = NULL;
-      continue;
-    }
+      if (csnmp_ignore_instance(cell, data)) {
+        sfree(cell);
+      } else {
+        csnmp_cell_replace_reserved_chars(cell);
 
-    size_t j;
-    for (vb = res->variables, j = 0; (vb != NULL);
-         vb = vb->next_variable, j++) {
-      i = j;
-      /* If bulk request is active convert value index of the extra value */
-      if (host->version > 1 && host->bulk_size > 0) {
-        i %= oid_list_todo_num;
+        DEBUG("snmp plugin: il->type_instance = `%s';", cell->value);
+        csnmp_cells_append(&walk->type_instance_cells_head,
+                           &walk->type_instance_cells_tail, cell);
       }
-      /* Calculate value index from todo list */
-      while ((i < oid_list_len) && !oid_list_todo[i]) {
-        i++;
-        j++;
-      }
-      if (i >= oid_list_len) {
-        break;
+    } else if (oid_list_todo[i] == OID_TYPE_PLUGININSTANCE) {
+      if ((vb->type == SNMP_ENDOFMIBVIEW) ||
+          (snmp_oid_ncompare(data->plugin_instance.oid.oid,
+                             data->plugin_instance.oid.oid_len, vb->name,
+                             vb->name_length,
+                             data->plugin_instance.oid.oid_len) != 0)) {
+        DEBUG("snmp plugin: host = %s; data = %s; TypeInstance left its "
+              "subtree.",
+              host->name, data->name);
+        oid_list_todo[i] = 0;
+        continue;
       }
 
-      /* An instance is configured and the res variable we process is the
-       * instance value */
-      if (oid_list_todo[i] == OID_TYPE_TYPEINSTANCE) {
-        if ((vb->type == SNMP_ENDOFMIBVIEW) ||
-            (snmp_oid_ncompare(data->type_instance.oid.oid,
-                               data->type_instance.oid.oid_len, vb->name,
-                               vb->name_length,
-                               data->type_instance.oid.oid_len) != 0)) {
-          DEBUG("snmp plugin: host = %s; data = %s; TypeInstance left its "
-                "subtree.",
-                host->name, data->name);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+      /* Allocate a new `csnmp_cell_char_t', insert the instance name and
+       * add it to the list */
+      csnmp_cell_char_t *cell =
+          csnmp_get_char_cell(vb, &data->plugin_instance.oid, host, data);
+      if (cell == NULL) {
+        ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
+              host->name);
+        return -1;
+      }
 
-        /* Allocate a new `csnmp_cell_char_t', insert the instance name and
-         * add it to the list */
-        csnmp_cell_char_t *cell =
-            csnmp_get_char_cell(vb, &data->type_instance.oid, host, data);
-        if (cell == NULL) {
-          ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
-                host->name);
-          status = -1;
-          break;
-        }
+      csnmp_cell_replace_reserved_chars(cell);
+
+      DEBUG("snmp plugin: il->plugin_instance = `%s';", cell->value);
+      csnmp_cells_append(&walk->plugin_instance_cells_head,
+                         &walk->plugin_instance_cells_tail, cell);
+    } else if (oid_list_todo[i] == OID_TYPE_HOST) {
+      if ((vb->type == SNMP_ENDOFMIBVIEW) ||
+          (snmp_oid_ncompare(data->host.oid.oid, data->host.oid.oid_len,
+                             vb->name, vb->name_length,
+                             data->host.oid.oid_len) != 0)) {
+        DEBUG("snmp plugin: host = %s; data = %s; Host left its subtree.",
+              host->name, data->name);
+        oid_list_todo[i] = 0;
+        continue;
+      }
 
-        if (csnmp_ignore_instance(cell, data)) {
-          sfree(cell);
-        } else {
-          csnmp_cell_replace_reserved_chars(cell);
+      /* Allocate a new `csnmp_cell_char_t', insert the instance name and
+       * add it to the list */
+      csnmp_cell_char_t *cell =
+          csnmp_get_char_cell(vb, &data->host.oid, host, data);
+      if (cell == NULL) {
+        ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
+              host->name);
+        return -1;
+      }
 
-          DEBUG("snmp plugin: il->type_instance = `%s';", cell->value);
-          csnmp_cells_append(&type_instance_cells_head,
-                             &type_instance_cells_tail, cell);
-        }
-      } else if (oid_list_todo[i] == OID_TYPE_PLUGININSTANCE) {
-        if ((vb->type == SNMP_ENDOFMIBVIEW) ||
-            (snmp_oid_ncompare(data->plugin_instance.oid.oid,
-                               data->plugin_instance.oid.oid_len, vb->name,
-                               vb->name_length,
-                               data->plugin_instance.oid.oid_len) != 0)) {
-          DEBUG("snmp plugin: host = %s; data = %s; TypeInstance left its "
-                "subtree.",
-                host->name, data->name);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+      csnmp_cell_replace_reserved_chars(cell);
+
+      DEBUG("snmp plugin: il->hostname = `%s';", cell->value);
+      csnmp_cells_append(&walk->hostname_cells_head,
+                         &walk->hostname_cells_tail, cell);
+    } else if (oid_list_todo[i] == OID_TYPE_FILTER) {
+      if ((vb->type == SNMP_ENDOFMIBVIEW) ||
+          (snmp_oid_ncompare(data->filter_oid.oid, data->filter_oid.oid_len,
+                             vb->name, vb->name_length,
+                             data->filter_oid.oid_len) != 0)) {
+        DEBUG("snmp plugin: host = %s; data = %s; Host left its subtree.",
+              host->name, data->name);
+        oid_list_todo[i] = 0;
+        continue;
+      }
 
-        /* Allocate a new `csnmp_cell_char_t', insert the instance name and
-         * add it to the list */
-        csnmp_cell_char_t *cell =
-            csnmp_get_char_cell(vb, &data->plugin_instance.oid, host, data);
-        if (cell == NULL) {
-          ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
-                host->name);
-          status = -1;
-          break;
-        }
+      /* Allocate a new `csnmp_cell_char_t', insert the instance name and
+       * add it to the list */
+      csnmp_cell_char_t *cell =
+          csnmp_get_char_cell(vb, &data->filter_oid, host, data);
+      if (cell == NULL) {
+        ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
+              host->name);
+        return -1;
+      }
 
-        csnmp_cell_replace_reserved_chars(cell);
+      csnmp_cell_replace_reserved_chars(cell);
 
-        DEBUG("snmp plugin: il->plugin_instance = `%s';", cell->value);
-        csnmp_cells_append(&plugin_instance_cells_head,
-                           &plugin_instance_cells_tail, cell);
-      } else if (oid_list_todo[i] == OID_TYPE_HOST) {
-        if ((vb->type == SNMP_ENDOFMIBVIEW) ||
-            (snmp_oid_ncompare(data->host.oid.oid, data->host.oid.oid_len,
-                               vb->name, vb->name_length,
-                               data->host.oid.oid_len) != 0)) {
-          DEBUG("snmp plugin: host = %s; data = %s; Host left its subtree.",
-                host->name, data->name);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+      DEBUG("snmp plugin: il->filter = `%s';", cell->value);
+      csnmp_cells_append(&walk->filter_cells_head, &walk->filter_cells_tail,
+                         cell);
+    } else /* The variable we are processing is a normal value */
+    {
+      assert(oid_list_todo[i] == OID_TYPE_VARIABLE);
+
+      csnmp_cell_value_t *vt;
+      oid_t vb_name;
+      oid_t suffix;
+      int ret;
+
+      csnmp_oid_init(&vb_name, vb->name, vb->name_length);
+
+      /* Calculate the current suffix. This is later used to check that the
+       * suffix is increasing. This also checks if we left the subtree */
+      ret = csnmp_oid_suffix(&suffix, &vb_name, data->values + i);
+      if (ret != 0) {
+        DEBUG("snmp plugin: host = %s; data = %s; i = %" PRIsz "; "
+              "Value probably left its subtree.",
+              host->name, data->name, i);
+        oid_list_todo[i] = 0;
+        continue;
+      }
 
-        /* Allocate a new `csnmp_cell_char_t', insert the instance name and
-         * add it to the list */
-        csnmp_cell_char_t *cell =
-            csnmp_get_char_cell(vb, &data->host.oid, host, data);
-        if (cell == NULL) {
-          ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
-                host->name);
-          status = -1;
-          break;
-        }
+      /* Make sure the OIDs returned by the agent are increasing. Otherwise
+       * our table matching algorithm will get confused. */
+      if ((walk->value_cells_tail[i] != NULL) &&
+          (csnmp_oid_compare(&suffix, &walk->value_cells_tail[i]->suffix) <=
+           0)) {
+        DEBUG("snmp plugin: host = %s; data = %s; i = %" PRIsz "; "
+              "Suffix is not increasing.",
+              host->name, data->name, i);
+        oid_list_todo[i] = 0;
+        continue;
+      }
 
-        csnmp_cell_replace_reserved_chars(cell);
+      vt = calloc(1, sizeof(*vt));
+      if (vt == NULL) {
+        ERROR("snmp plugin: calloc failed.");
+        return -1;
+      }
 
-        DEBUG("snmp plugin: il->hostname = `%s';", cell->value);
-        csnmp_cells_append(&hostname_cells_head, &hostname_cells_tail, cell);
-      } else if (oid_list_todo[i] == OID_TYPE_FILTER) {
-        if ((vb->type == SNMP_ENDOFMIBVIEW) ||
-            (snmp_oid_ncompare(data->filter_oid.oid, data->filter_oid.oid_len,
-                               vb->name, vb->name_length,
-                               data->filter_oid.oid_len) != 0)) {
-          DEBUG("snmp plugin: host = %s; data = %s; Host left its subtree.",
-                host->name, data->name);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+      vt->value =
+          csnmp_value_list_to_value(vb, walk->ds->ds[i].type, data->scale,
+                                    data->shift, host->name, data->name);
+      memcpy(&vt->suffix, &suffix, sizeof(vt->suffix));
+      vt->next = NULL;
 
-        /* Allocate a new `csnmp_cell_char_t', insert the instance name and
-         * add it to the list */
-        csnmp_cell_char_t *cell =
-            csnmp_get_char_cell(vb, &data->filter_oid, host, data);
-        if (cell == NULL) {
-          ERROR("snmp plugin: host %s: csnmp_get_char_cell() failed.",
-                host->name);
-          status = -1;
-          break;
-        }
+      if (walk->value_cells_tail[i] == NULL)
+        walk->value_cells_head[i] = vt;
+      else
+        walk->value_cells_tail[i]->next = vt;
+      walk->value_cells_tail[i] = vt;
+    }
 
-        csnmp_cell_replace_reserved_chars(cell);
+    /* Copy OID to oid_list[i] */
+    memcpy(walk->oid_list[i].oid, vb->name, sizeof(oid) * vb->name_length);
+    walk->oid_list[i].oid_len = vb->name_length;
 
-        DEBUG("snmp plugin: il->filter = `%s';", cell->value);
-        csnmp_cells_append(&filter_cells_head, &filter_cells_tail, cell);
-      } else /* The variable we are processing is a normal value */
-      {
-        assert(oid_list_todo[i] == OID_TYPE_VARIABLE);
-
-        csnmp_cell_value_t *vt;
-        oid_t vb_name;
-        oid_t suffix;
-        int ret;
-
-        csnmp_oid_init(&vb_name, vb->name, vb->name_length);
-
-        /* Calculate the current suffix. This is later used to check that the
-         * suffix is increasing. This also checks if we left the subtree */
-        ret = csnmp_oid_suffix(&suffix, &vb_name, data->values + i);
-        if (ret != 0) {
-          DEBUG("snmp plugin: host = %s; data = %s; i = %" PRIsz "; "
-                "Value probably left its subtree.",
-                host->name, data->name, i);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+  } /* for (vb = res->variables ...) */
 
-        /* Make sure the OIDs returned by the agent are increasing. Otherwise
-         * our table matching algorithm will get confused. */
-        if ((value_cells_tail[i] != NULL) &&
-            (csnmp_oid_compare(&suffix, &value_cells_tail[i]->suffix) <= 0)) {
-          DEBUG("snmp plugin: host = %s; data = %s; i = %" PRIsz "; "
-                "Suffix is not increasing.",
-                host->name, data->name, i);
-          oid_list_todo[i] = 0;
-          continue;
-        }
+  return 0;
+} /* int csnmp_table_walk_response */
 
-        vt = calloc(1, sizeof(*vt));
-        if (vt == NULL) {
-          ERROR("snmp plugin: calloc failed.");
-          status = -1;
-          break;
-        }
+static int csnmp_read_table(host_definition_t *host, data_definition_t *data) {
+  csnmp_table_walk_t *walk;
+  struct snmp_pdu *req;
+  struct snmp_pdu *res = NULL;
+  int status;
 
-        vt->value =
-            csnmp_value_list_to_value(vb, ds->ds[i].type, data->scale,
-                                      data->shift, host->name, data->name);
-        memcpy(&vt->suffix, &suffix, sizeof(vt->suffix));
-        vt->next = NULL;
+  DEBUG("snmp plugin: csnmp_read_table (host = %s, data = %s)", host->name,
+        data->name);
 
-        if (value_cells_tail[i] == NULL)
-          value_cells_head[i] = vt;
-        else
-          value_cells_tail[i]->next = vt;
-        value_cells_tail[i] = vt;
-      }
+  if (host->sess_handle == NULL) {
+    DEBUG("snmp plugin: csnmp_read_table: host->sess_handle == NULL");
+    return -1;
+  }
 
-      /* Copy OID to oid_list[i] */
-      memcpy(oid_list[i].oid, vb->name, sizeof(oid) * vb->name_length);
-      oid_list[i].oid_len = vb->name_length;
+  walk = csnmp_table_walk_create(host, data);
+  if (walk == NULL)
+    return -1;
 
-    } /* for (vb = res->variables ...) */
+  status = 0;
+  while (status == 0) {
+    status = csnmp_table_walk_request(walk, &req);
+    if ((status != 0) || (req == NULL))
+      break;
 
-    if (res != NULL)
-      snmp_free_pdu(res);
     res = NULL;
-  } /* while (status == 0) */
+    status = snmp_sess_synch_response(host->sess_handle, req, &res);
 
-  if (res != NULL)
-    snmp_free_pdu(res);
-  res = NULL;
+    /* snmp_sess_synch_response always frees our req PDU */
+    req = NULL;
 
-  if (status == 0)
-    csnmp_dispatch_table(host, data, type_instance_cells_head,
-                         plugin_instance_cells_head, hostname_cells_head,
-                         filter_cells_head, value_cells_head, data->count);
+    if ((status != STAT_SUCCESS) || (res == NULL)) {
+      char *errstr = NULL;
 
-  /* Free all allocated variables here */
-  while (type_instance_cells_head != NULL) {
-    csnmp_cell_char_t *next = type_instance_cells_head->next;
-    sfree(type_instance_cells_head);
-    type_instance_cells_head = next;
-  }
+      snmp_sess_error(host->sess_handle, NULL, NULL, &errstr);
 
-  while (plugin_instance_cells_head != NULL) {
-    csnmp_cell_char_t *next = plugin_instance_cells_head->next;
-    sfree(plugin_instance_cells_head);
-    plugin_instance_cells_head = next;
-  }
+      c_complain(LOG_ERR, &host->complaint,
+                 "snmp plugin: host %s: snmp_sess_synch_response failed: %s",
+                 host->name, (errstr == NULL) ? "Unknown problem" : errstr);
 
-  while (hostname_cells_head != NULL) {
-    csnmp_cell_char_t *next = hostname_cells_head->next;
-    sfree(hostname_cells_head);
-    hostname_cells_head = next;
-  }
+      if (res != NULL)
+        snmp_free_pdu(res);
+      res = NULL;
 
-  while (filter_cells_head != NULL) {
-    csnmp_cell_char_t *next = filter_cells_head->next;
-    sfree(filter_cells_head);
-    filter_cells_head = next;
-  }
+      sfree(errstr);
+      csnmp_host_close_session(host);
 
-  for (i = 0; i < data->values_len; i++) {
-    while (value_cells_head[i] != NULL) {
-      csnmp_cell_value_t *next = value_cells_head[i]->next;
-      sfree(value_cells_head[i]);
-      value_cells_head[i] = next;
+      status = -1;
+      break;
     }
-  }
 
-  sfree(value_cells_head);
-  sfree(value_cells_tail);
+    c_release(LOG_INFO, &host->complaint,
+              "snmp plugin: host %s: snmp_sess_synch_response successful.",
+              host->name);
 
-  return 0;
-} /* int csnmp_read_table */
+    status = csnmp_table_walk_response(walk, res);
 
-static int csnmp_read_value(host_definition_t *host, data_definition_t *data) {
-  struct snmp_pdu *req;
-  struct snmp_pdu *res = NULL;
-  struct variable_list *vb;
-
-  const data_set_t *ds;
-  value_list_t vl = VALUE_LIST_INIT;
+    snmp_free_pdu(res);
+    res = NULL;
+  } /* while (status == 0) */
 
-  int status;
-  size_t i;
+  csnmp_table_walk_destroy(walk, /* dispatch = */ status == 0);
 
-  DEBUG("snmp plugin: csnmp_read_value (host = %s, data = %s)", host->name,
-        data->name);
+  return 0;
+} /* int csnmp_read_table */
 
-  if (host->sess_handle == NULL) {
-    DEBUG("snmp plugin: csnmp_read_value: host->sess_handle == NULL");
-    return -1;
-  }
+/* Looks up the data set of a non-table data definition and checks it. */
+static const data_set_t *csnmp_value_get_ds(data_definition_t *data) {
+  const data_set_t *ds;
 
   ds = plugin_get_ds(data->type);
   if (!ds) {
     ERROR("snmp plugin: DataSet `%s' not defined.", data->type);
-    return -1;
+    return NULL;
   }
 
   if (ds->ds_num != data->values_len) {
@@ -2117,9 +2192,37 @@ static int csnmp_read_value(host_definition_t *host, data_definition_t *data) {
           " values, but config talks "
           "about %" PRIsz,
           data->type, ds->ds_num, data->values_len);
-    return -1;
+    return NULL;
+  }
+
+  return ds;
+} /* const data_set_t *csnmp_value_get_ds */
+
+static struct snmp_pdu *csnmp_value_request(data_definition_t *data) {
+  struct snmp_pdu *req;
+
+  req = snmp_pdu_create(SNMP_MSG_GET);
+  if (req == NULL) {
+    ERROR("snmp plugin: snmp_pdu_create failed.");
+    return NULL;
   }
 
+  for (size_t i = 0; i < data->values_len; i++)
+    snmp_add_null_var(req, data->values[i].oid, data->values[i].oid_len);
+
+  return req;
+} /* struct snmp_pdu *csnmp_value_request */
+
+/* Dispatches the values of the response to the request created by
+ * `csnmp_value_request'. The response is not freed. */
+static int csnmp_value_dispatch(host_definition_t *host,
+                                data_definition_t *data,
+                                const data_set_t *ds,
+                                struct snmp_pdu *res) {
+  struct variable_list *vb;
+  value_list_t vl = VALUE_LIST_INIT;
+  size_t i;
+
   vl.values_len = ds->ds_num;
   vl.values = malloc(sizeof(*vl.values) * vl.values_len);
   if (vl.values == NULL)
@@ -2141,15 +2244,51 @@ static int csnmp_read_value(host_definition_t *host, data_definition_t *data) {
     sstrncpy(vl.plugin_instance, data->plugin_instance.value,
              sizeof(vl.plugin_instance));
 
-  req = snmp_pdu_create(SNMP_MSG_GET);
-  if (req == NULL) {
-    ERROR("snmp plugin: snmp_pdu_create failed.");
-    sfree(vl.values);
+  for (vb = res->variables; vb != NULL; vb = vb->next_variable) {
+#if COLLECT_DEBUG
+    char buffer[1024];
+    snprint_variable(buffer, sizeof(buffer), vb->name, vb->name_length, vb);
+    DEBUG("snmp plugin: Got this variable: %s", buffer);
+#endif /* COLLECT_DEBUG */
+
+    for (i = 0; i < data->values_len; i++)
+      if (snmp_oid_compare(data->values[i].oid, data->values[i].oid_len,
+                           vb->name, vb->name_length) == 0)
+        vl.values[i] =
+            csnmp_value_list_to_value(vb, ds->ds[i].type, data->scale,
+                                      data->shift, host->name, data->name);
+  } /* for (res->variables) */
+
+  DEBUG("snmp plugin: -> plugin_dispatch_values (&vl);");
+  plugin_dispatch_values(&vl);
+  sfree(vl.values);
+
+  return 0;
+} /* int csnmp_value_dispatch */
+
+static int csnmp_read_value(host_definition_t *host, data_definition_t *data) {
+  struct snmp_pdu *req;
+  struct snmp_pdu *res = NULL;
+
+  const data_set_t *ds;
+
+  int status;
+
+  DEBUG("snmp plugin: csnmp_read_value (host = %s, data = %s)", host->name,
+        data->name);
+
+  if (host->sess_handle == NULL) {
+    DEBUG("snmp plugin: csnmp_read_value: host->sess_handle == NULL");
     return -1;
   }
 
-  for (i = 0; i < data->values_len; i++)
-    snmp_add_null_var(req, data->values[i].oid, data->values[i].oid_len);
+  ds = csnmp_value_get_ds(data);
+  if (ds == NULL)
+    return -1;
+
+  req = csnmp_value_request(data);
+  if (req == NULL)
+    return -1;
 
   status = snmp_sess_synch_response(host->sess_handle, req, &res);
 
@@ -2164,35 +2303,379 @@ static int csnmp_read_value(host_definition_t *host, data_definition_t *data) {
       snmp_free_pdu(res);
 
     sfree(errstr);
-    sfree(vl.values);
     csnmp_host_close_session(host);
 
     return -1;
   }
 
-  for (vb = res->variables; vb != NULL; vb = vb->next_variable) {
-#if COLLECT_DEBUG
-    char buffer[1024];
-    snprint_variable(buffer, sizeof(buffer), vb->name, vb->name_length, vb);
-    DEBUG("snmp plugin: Got this variable: %s", buffer);
-#endif /* COLLECT_DEBUG */
+  status = csnmp_value_dispatch(host, data, ds, res);
+  snmp_free_pdu(res);
 
-    for (i = 0; i < data->values_len; i++)
-      if (snmp_oid_compare(data->values[i].oid, data->values[i].oid_len,
-                           vb->name, vb->name_length) == 0)
-        vl.values[i] =
-            csnmp_value_list_to_value(vb, ds->ds[i].type, data->scale,
-                                      data->shift, host->name, data->name);
-  } /* for (res->variables) */
+  return status;
+} /* int csnmp_read_value */
 
-  snmp_free_pdu(res);
+/* Asynchronous engine {{{
+ *
+ * If `Asynchronous' is enabled, the read callback of a host does not wait
+ * for the agent. It submits a "job" to the engine thread instead and
+ * returns immediately. The engine thread sends the requests of all jobs
+ * with `snmp_sess_async_send' and waits for the responses of all hosts in a
+ * single select loop. At most `MaxInflight' requests are outstanding per
+ * host; each table walk and each non-table `Data' block has at most one.
+ * The values of a job are dispatched when all its requests are answered.
+ */
+struct csnmp_job_s;
 
-  DEBUG("snmp plugin: -> plugin_dispatch_values (&vl);");
-  plugin_dispatch_values(&vl);
-  sfree(vl.values);
+struct csnmp_request_s {
+  struct csnmp_job_s *job;
+  data_definition_t *data;
+  const data_set_t *ds;       /* non-table data only */
+  csnmp_table_walk_t *walk;   /* table data only */
+  bool pending;
+  bool done;
+  int status;
+};
+typedef struct csnmp_request_s csnmp_request_t;
+
+struct csnmp_job_s {
+  host_definition_t *host;
+  plugin_ctx_t ctx;
+  cdtime_t start;
+  csnmp_request_t *requests;
+  size_t requests_num;
+  int inflight;
+  bool failed;
+  struct csnmp_job_s *next;
+};
+typedef struct csnmp_job_s csnmp_job_t;
+
+static pthread_mutex_t csnmp_engine_lock = PTHREAD_MUTEX_INITIALIZER;
+static csnmp_job_t *csnmp_engine_queue;
+static bool csnmp_engine_loop;
+static bool csnmp_engine_running;
+static pthread_t csnmp_engine_thread;
+static int csnmp_engine_pipe[2] = {-1, -1};
+
+static void csnmp_job_free(csnmp_job_t *job, bool dispatch) {
+  for (size_t i = 0; i < job->requests_num; i++) {
+    csnmp_request_t *r = job->requests + i;
+    csnmp_table_walk_destroy(r->walk, dispatch && (r->status == 0));
+  }
+
+  pthread_mutex_lock(&csnmp_engine_lock);
+  job->host->polling = false;
+  pthread_mutex_unlock(&csnmp_engine_lock);
+
+  sfree(job->requests);
+  sfree(job);
+} /* void csnmp_job_free */
+
+static csnmp_job_t *csnmp_job_create(host_definition_t *host) {
+  csnmp_job_t *job = calloc(1, sizeof(*job));
+  if (job == NULL)
+    return NULL;
+
+  job->requests = calloc(host->data_list_len, sizeof(*job->requests));
+  if ((host->data_list_len > 0) && (job->requests == NULL)) {
+    sfree(job);
+    return NULL;
+  }
+
+  job->host = host;
+  job->ctx = plugin_get_ctx();
+  job->start = cdtime();
+
+  for (int i = 0; i < host->data_list_len; i++) {
+    csnmp_request_t *r = job->requests + job->requests_num;
+    data_definition_t *data = host->data_list[i];
+
+    r->job = job;
+    r->data = data;
+    if (data->is_table)
+      r->walk = csnmp_table_walk_create(host, data);
+    else
+      r->ds = csnmp_value_get_ds(data);
+
+    /* Misconfigured data definitions are skipped, the error has been
+     * reported already. */
+    if ((r->walk != NULL) || (r->ds != NULL))
+      job->requests_num++;
+  }
+
+  return job;
+} /* csnmp_job_t *csnmp_job_create */
+
+static int csnmp_engine_callback(int operation, netsnmp_session *sess,
+                                 int reqid, netsnmp_pdu *pdu, void *magic) {
+  csnmp_request_t *r = magic;
+  csnmp_job_t *job = r->job;
+  host_definition_t *host = job->host;
+
+  r->pending = false;
+  job->inflight--;
+
+  if (operation != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+    c_complain(LOG_ERR, &host->complaint,
+               "snmp plugin: host %s: data %s: no response received (%i).",
+               host->name, r->data->name, operation);
+    r->status = -1;
+    r->done = true;
+    job->failed = true;
+    return 1;
+  }
+
+  c_release(LOG_INFO, &host->complaint,
+            "snmp plugin: host %s: response received.", host->name);
+
+  if (r->walk != NULL) {
+    /* the next request of the walk is sent by the engine loop */
+    r->status = csnmp_table_walk_response(r->walk, pdu);
+    r->done = (r->status != 0);
+  } else {
+    r->status = csnmp_value_dispatch(host, r->data, r->ds, pdu);
+    r->done = true;
+  }
+
+  return 1;
+} /* int csnmp_engine_callback */
+
+/* Sends the next requests of the job. Returns true if the job is finished. */
+static bool csnmp_engine_job_send(csnmp_job_t *job) {
+  host_definition_t *host = job->host;
+
+  if (host->sess_handle == NULL)
+    csnmp_host_open_session(host);
+
+  if (host->sess_handle == NULL)
+    return true;
+
+  for (size_t i = 0; i < job->requests_num; i++) {
+    csnmp_request_t *r = job->requests + i;
+    struct snmp_pdu *req = NULL;
+
+    if (r->pending || r->done)
+      continue;
+    if ((host->max_inflight > 0) && (job->inflight >= host->max_inflight))
+      break;
+
+    if (r->walk != NULL) {
+      r->status = csnmp_table_walk_request(r->walk, &req);
+      if ((r->status != 0) || (req == NULL)) {
+        r->done = true;
+        continue;
+      }
+    } else if ((req = csnmp_value_request(r->data)) == NULL) {
+      r->status = -1;
+      r->done = true;
+      continue;
+    }
+
+    if (snmp_sess_async_send(host->sess_handle, req, csnmp_engine_callback,
+                             r) == 0) {
+      char *errstr = NULL;
+
+      snmp_sess_error(host->sess_handle, NULL, NULL, &errstr);
+      ERROR("snmp plugin: host %s: snmp_sess_async_send failed: %s",
+            host->name, (errstr == NULL) ? "Unknown problem" : errstr);
+      sfree(errstr);
+
+      snmp_free_pdu(req);
+      r->status = -1;
+      r->done = true;
+      job->failed = true;
+      continue;
+    }
+
+    r->pending = true;
+    job->inflight++;
+  }
+
+  return job->inflight == 0;
+} /* bool csnmp_engine_job_send */
+
+static void csnmp_engine_job_finish(csnmp_job_t *job) {
+  host_definition_t *host = job->host;
+  int success = 0;
+
+  for (size_t i = 0; i < job->requests_num; i++)
+    if (job->requests[i].status == 0)
+      success++;
+
+  DEBUG("snmp plugin: host %s: %d of %" PRIsz " requests succeeded in %.3f "
+        "seconds.",
+        host->name, success, job->requests_num,
+        CDTIME_T_TO_DOUBLE(cdtime() - job->start));
+
+  /* Re-open the session with the next job, as the synchronous code does. */
+  if (job->failed)
+    csnmp_host_close_session(host);
+
+  csnmp_job_free(job, /* dispatch = */ true);
+} /* void csnmp_engine_job_finish */
+
+static void *csnmp_engine_main(void *args) {
+  csnmp_job_t *active = NULL;
+
+  pthread_mutex_lock(&csnmp_engine_lock);
+  while (csnmp_engine_loop) {
+    /* take over the submitted jobs */
+    while (csnmp_engine_queue != NULL) {
+      csnmp_job_t *job = csnmp_engine_queue;
+      csnmp_engine_queue = job->next;
+      job->next = active;
+      active = job;
+    }
+    pthread_mutex_unlock(&csnmp_engine_lock);
+
+    /* send requests and finish completed jobs */
+    for (csnmp_job_t **jobp = &active; *jobp != NULL;) {
+      csnmp_job_t *job = *jobp;
+
+      plugin_set_ctx(job->ctx);
+      if (csnmp_engine_job_send(job)) {
+        *jobp = job->next;
+        csnmp_engine_job_finish(job);
+        continue;
+      }
+      jobp = &job->next;
+    }
+
+    /* wait for responses, retransmission timeouts or new jobs */
+    netsnmp_large_fd_set fdset;
+    struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
+    int block = 0;
+    int numfds = csnmp_engine_pipe[0] + 1;
+
+    netsnmp_large_fd_set_init(&fdset, FD_SETSIZE);
+    NETSNMP_LARGE_FD_SET(csnmp_engine_pipe[0], &fdset);
+    for (csnmp_job_t *job = active; job != NULL; job = job->next)
+      snmp_sess_select_info2(job->host->sess_handle, &numfds, &fdset,
+                             &timeout, &block);
+
+    int status =
+        netsnmp_large_fd_set_select(numfds, &fdset, NULL, NULL, &timeout);
+    if (status < 0 && errno != EINTR)
+      ERROR("snmp plugin: select failed: %s", STRERRNO);
+
+    if ((status > 0) && NETSNMP_LARGE_FD_ISSET(csnmp_engine_pipe[0], &fdset)) {
+      char buffer[32];
+      if (read(csnmp_engine_pipe[0], buffer, sizeof(buffer)) < 0)
+        DEBUG("snmp plugin: read from pipe failed: %s", STRERRNO);
+    }
+
+    for (csnmp_job_t *job = active; job != NULL; job = job->next) {
+      plugin_set_ctx(job->ctx);
+      if (status > 0)
+        snmp_sess_read2(job->host->sess_handle, &fdset);
+      /* handles retransmissions and timed out requests */
+      snmp_sess_timeout(job->host->sess_handle);
+    }
+
+    netsnmp_large_fd_set_cleanup(&fdset);
+
+    pthread_mutex_lock(&csnmp_engine_lock);
+  } /* while (csnmp_engine_loop) */
+  pthread_mutex_unlock(&csnmp_engine_lock);
+
+  /* shutting down: outstanding requests are dropped with the sessions */
+  while (active != NULL) {
+    csnmp_job_t *job = active;
+    active = job->next;
+    csnmp_host_close_session(job->host);
+    csnmp_job_free(job, /* dispatch = */ false);
+  }
+
+  return NULL;
+} /* void *csnmp_engine_main */
+
+static void csnmp_engine_wakeup(void) {
+  if (write(csnmp_engine_pipe[1], "", 1) < 0)
+    DEBUG("snmp plugin: write to pipe failed: %s", STRERRNO);
+}
+
+static int csnmp_engine_start(void) {
+  if (pipe(csnmp_engine_pipe) != 0) {
+    ERROR("snmp plugin: pipe failed: %s", STRERRNO);
+    return -1;
+  }
+  for (int i = 0; i < 2; i++) {
+    int flags = fcntl(csnmp_engine_pipe[i], F_GETFL);
+    fcntl(csnmp_engine_pipe[i], F_SETFL, flags | O_NONBLOCK);
+  }
+
+  csnmp_engine_loop = true;
+  if (plugin_thread_create(&csnmp_engine_thread, csnmp_engine_main, NULL,
+                           "snmp async") != 0) {
+    ERROR("snmp plugin: Starting the engine thread failed.");
+    csnmp_engine_loop = false;
+    close(csnmp_engine_pipe[0]);
+    close(csnmp_engine_pipe[1]);
+    csnmp_engine_pipe[0] = csnmp_engine_pipe[1] = -1;
+    return -1;
+  }
+  csnmp_engine_running = true;
 
   return 0;
-} /* int csnmp_read_value */
+} /* int csnmp_engine_start */
+
+static void csnmp_engine_stop(void) {
+  if (!csnmp_engine_running)
+    return;
+
+  pthread_mutex_lock(&csnmp_engine_lock);
+  csnmp_engine_loop = false;
+  pthread_mutex_unlock(&csnmp_engine_lock);
+  csnmp_engine_wakeup();
+
+  pthread_join(csnmp_engine_thread, NULL);
+  csnmp_engine_running = false;
+
+  /* jobs which have not been taken over by the engine */
+  while (csnmp_engine_queue != NULL) {
+    csnmp_job_t *job = csnmp_engine_queue;
+    csnmp_engine_queue = job->next;
+    csnmp_job_free(job, /* dispatch = */ false);
+  }
+
+  close(csnmp_engine_pipe[0]);
+  close(csnmp_engine_pipe[1]);
+  csnmp_engine_pipe[0] = csnmp_engine_pipe[1] = -1;
+} /* void csnmp_engine_stop */
+
+static int csnmp_read_host_async(host_definition_t *host) {
+  csnmp_job_t *job;
+
+  pthread_mutex_lock(&csnmp_engine_lock);
+  if (host->polling) {
+    pthread_mutex_unlock(&csnmp_engine_lock);
+    c_complain(LOG_WARNING, &host->complaint,
+               "snmp plugin: host %s: the previous poll has not finished yet, "
+               "skipping this interval.",
+               host->name);
+    /* Not an error of this read, so don't trigger the read backoff. */
+    return 0;
+  }
+  host->polling = true;
+  pthread_mutex_unlock(&csnmp_engine_lock);
+
+  job = csnmp_job_create(host);
+  if (job == NULL) {
+    ERROR("snmp plugin: host %s: csnmp_job_create failed.", host->name);
+    pthread_mutex_lock(&csnmp_engine_lock);
+    host->polling = false;
+    pthread_mutex_unlock(&csnmp_engine_lock);
+    return -1;
+  }
+
+  pthread_mutex_lock(&csnmp_engine_lock);
+  job->next = csnmp_engine_queue;
+  csnmp_engine_queue = job;
+  pthread_mutex_unlock(&csnmp_engine_lock);
+  csnmp_engine_wakeup();
+
+  return 0;
+} /* int csnmp_read_host_async */
+/* }}} Asynchronous engine */
 
 static int csnmp_read_host(user_data_t *ud) {
   host_definition_t *host;
@@ -2202,6 +2685,9 @@ static int csnmp_read_host(user_data_t *ud) {
 
   host = ud->data;
 
+  if (csnmp_async)
+    return csnmp_read_host_async(host);
+
   if (host->sess_handle == NULL)
     csnmp_host_open_session(host);
 
@@ -2230,6 +2716,9 @@ static int csnmp_read_host(user_data_t *ud) {
 static int csnmp_init(void) {
   call_snmp_init_once();
 
+  if (csnmp_async)
+    return csnmp_engine_start();
+
   return 0;
 } /* int csnmp_init */
 
@@ -2237,8 +2726,11 @@ static int csnmp_shutdown(void) {
   data_definition_t *data_this;
   data_definition_t *data_next;
 
-  /* When we get here, the read threads have been stopped and all the
-   * `host_definition_t' will be freed. */
+  /* When we get here, the `host_definition_t's have been freed and the
+   * engine has been stopped by the first of them, unless there were no
+   * hosts. */
+  csnmp_engine_stop();
+
   DEBUG("snmp plugin: Destroying all data definitions.");
 
   data_this = data_head;
@@ -2257,5 +2749,6 @@ static int csnmp_shutdown(void) {
 void module_register(void) {
   plugin_register_complex_config("snmp", csnmp_config);
   plugin_register_init("snmp", csnmp_init);
+  plugin_register_init_exclusive("snmp");
   plugin_register_shutdown("snmp", csnmp_shutdown);
 } /* void module_register */
@@ -91,6 +91,9 @@ struct table_definition_s {
   c_avl_tree_t *index_instance;
   c_avl_tree_t *instance_oids; /* Tells us how many OIDs registered for every
                                   instance; */
+  c_avl_tree_t *instance_rows; /* Cached row data of every instance, used to
+                                  answer requests without parsing the index
+                                  OID or looking up the global cache */
   index_key_t index_keys[MAX_INDEX_KEYS]; /* Stores information about what each
                                              index key represents */
   int index_keys_len;
@@ -121,6 +124,23 @@ struct data_definition_s {
 };
 typedef struct data_definition_s data_definition_t;
 
+/* Latest values dispatched for a table column of a single row */
+struct column_value_s {
+  const data_set_t *ds;
+  value_t *values;
+};
+typedef struct column_value_s column_value_t;
+
+/* Row data cached from the write callback. Replies for table OIDs are formed
+ * from it, so the index OID doesn't have to be parsed and the identifier
+ * doesn't have to be looked up in the global value cache for every varbind.
+ * Guarded by snmp_agent_ctx_t.lock */
+struct table_row_s {
+  netsnmp_variable_list *index_keys; /* Index keys of the row */
+  llist_t *values; /* column_value_t, keyed by column name */
+};
+typedef struct table_row_s table_row_t;
+
 struct snmp_agent_ctx_s {
   pthread_t thread;
   pthread_mutex_t lock;
@@ -675,6 +695,92 @@ static int snmp_agent_unregister_oid_string(oid_t *oid,
   return snmp_agent_unregister_oid(&new_oid);
 }
 
+static table_row_t *snmp_agent_row_create(const table_definition_t *td) {
+  table_row_t *row = calloc(1, sizeof(*row));
+  if (row == NULL)
+    return NULL;
+
+  row->values = llist_create();
+  if (row->values == NULL) {
+    sfree(row);
+    return NULL;
+  }
+
+  /* Index key container holds the keys of the instance being added */
+  if (td->index_list_cont != NULL) {
+    row->index_keys = snmp_clone_varbind(td->index_list_cont);
+    if (row->index_keys == NULL) {
+      llist_destroy(row->values);
+      sfree(row);
+      return NULL;
+    }
+  }
+
+  return row;
+}
+
+static void snmp_agent_row_destroy(table_row_t *row) {
+  if (row == NULL)
+    return;
+
+  for (llentry_t *e = llist_head(row->values); e != NULL; e = e->next) {
+    column_value_t *cv = e->value;
+
+    sfree(cv->values);
+    sfree(cv);
+  }
+  llist_destroy(row->values);
+  snmp_free_varbind(row->index_keys);
+  sfree(row);
+}
+
+static int snmp_agent_row_update(table_row_t *row, data_definition_t *dd,
+                                 const data_set_t *ds, const value_list_t *vl) {
+  if (vl->values_len != ds->ds_num) {
+    ERROR(PLUGIN_NAME ": Number of values of '%s' doesn't match data set",
+          dd->name);
+    return -EINVAL;
+  }
+
+  column_value_t *cv;
+  llentry_t *e = llist_search(row->values, dd->name);
+
+  if (e == NULL) {
+    cv = calloc(1, sizeof(*cv));
+    if (cv == NULL)
+      return -ENOMEM;
+
+    cv->values = calloc(ds->ds_num, sizeof(*cv->values));
+    e = llentry_create(dd->name, cv);
+    if (cv->values == NULL || e == NULL) {
+      sfree(cv->values);
+      sfree(cv);
+      return -ENOMEM;
+    }
+    llist_append(row->values, e);
+  } else
+    cv = e->value;
+
+  cv->ds = ds;
+  memcpy(cv->values, vl->values, ds->ds_num * sizeof(*cv->values));
+
+  return 0;
+}
+
+static void snmp_agent_row_remove_value(table_row_t *row,
+                                        data_definition_t *dd) {
+  llentry_t *e = llist_search(row->values, dd->name);
+  if (e == NULL)
+    return;
+
+  column_value_t *cv = e->value;
+
+  llist_remove(row->values, e);
+  llentry_destroy(e);
+  sfree(cv->values);
+  sfree(cv);
+}
+
 static void snmp_agent_table_data_remove(data_definition_t *dd,
                                          table_definition_t *td,
                                          oid_t *index_oid) {
@@ -704,6 +810,11 @@ static void snmp_agent_table_data_remove(data_definition_t *dd,
         snmp_agent_update_instance_oids(td->instance_oids, index_oid, -1);
   }
 
+  table_row_t *row = NULL;
+
+  if (c_avl_get(td->instance_rows, index_oid, (void **)&row) == 0)
+    snmp_agent_row_remove_value(row, dd);
+
   /* Checking if any metrics are left registered */
   if (reg_oids != 0) {
     pthread_mutex_unlock(&g_agent->agentx_lock);
@@ -752,6 +863,11 @@ static void snmp_agent_table_data_remove(data_definition_t *dd,
   c_avl_remove(td->instance_oids, index_oid, NULL, (void **)&val);
   sfree(val);
 
+  if (row != NULL) {
+    c_avl_remove(td->instance_rows, index_oid, NULL, NULL);
+    snmp_agent_row_destroy(row);
+  }
+
   if (index != NULL) {
     pthread_mutex_lock(&g_agent->agentx_lock);
     snmp_agent_unregister_oid_index(&td->index_oid, *index);
@@ -897,6 +1013,16 @@ static void snmp_agent_free_table(table_definition_t **td) {
   c_avl_iterator_destroy(iter);
   c_avl_destroy((*td)->instance_oids);
 
+  /* Keys of instance_rows are owned by instance_index as well */
+  if ((*td)->instance_rows != NULL) {
+    table_row_t *row;
+
+    while (c_avl_pick((*td)->instance_rows, &key, (void **)&row) == 0)
+      snmp_agent_row_destroy(row);
+    c_avl_destroy((*td)->instance_rows);
+    (*td)->instance_rows = NULL;
+  }
+
   /* index_instance and instance_index contain the same pointers */
   c_avl_destroy((*td)->index_instance);
   (*td)->index_instance = NULL;
@@ -1044,18 +1170,13 @@ static int snmp_agent_format_name(char *name, int name_len,
 }
 
 static int snmp_agent_form_reply(struct netsnmp_request_info_s *requests,
-                                 data_definition_t *dd, oid_t *index_oid,
+                                 data_definition_t *dd, table_row_t *row,
                                  int oid_index) {
   int ret;
 
   if (dd->is_index_key) {
     const table_definition_t *td = dd->table;
-    int ret = snmp_agent_parse_oid_index_keys(td, index_oid);
-
-    if (ret != 0)
-      return ret;
-
-    netsnmp_variable_list *key = td->index_list_cont;
+    netsnmp_variable_list *key = row->index_keys;
     /* Searching index key */
     for (int pos = 0; pos < dd->index_key_pos; pos++)
       key = key->next_variable;
@@ -1082,47 +1203,63 @@ static int snmp_agent_form_reply(struct netsnmp_request_info_s *requests,
                                strlen((const char *)key->val.string));
 #endif
 
-    pthread_mutex_unlock(&g_agent->lock);
-
     return SNMP_ERR_NOERROR;
   }
 
-  char name[DATA_MAX_NAME_LEN];
+  const data_set_t *ds;
+  value_t *values = NULL;
+  value_t value;
 
-  ret = snmp_agent_format_name(name, sizeof(name), dd, index_oid);
-  if (ret != 0)
-    return ret;
+  if (row != NULL) {
+    /* Table column, the value is taken from the row cache */
+    llentry_t *e = llist_search(row->values, dd->name);
+    if (e == NULL) {
+      DEBUG(PLUGIN_NAME ": No value cached for '%s'", dd->name);
+      return SNMP_NOSUCHINSTANCE;
+    }
 
-  DEBUG(PLUGIN_NAME ": Identifier '%s'", name);
+    column_value_t *cv = e->value;
+    ds = cv->ds;
+    assert(oid_index < (int)ds->ds_num);
+    value = cv->values[oid_index];
+  } else {
+    char name[DATA_MAX_NAME_LEN];
+    size_t values_num;
 
-  value_t *values;
-  size_t values_num;
-  const data_set_t *ds = plugin_get_ds(dd->type);
-  if (ds == NULL) {
-    ERROR(PLUGIN_NAME ": Data set not found for '%s' type", dd->type);
-    return SNMP_NOSUCHINSTANCE;
-  }
+    ret = snmp_agent_format_name(name, sizeof(name), dd, NULL);
+    if (ret != 0)
+      return ret;
 
-  ret = uc_get_value_by_name(name, &values, &values_num);
+    DEBUG(PLUGIN_NAME ": Identifier '%s'", name);
 
-  if (ret != 0) {
-    ERROR(PLUGIN_NAME ": Failed to get value for '%s'", name);
-    return SNMP_NOSUCHINSTANCE;
-  }
+    ds = plugin_get_ds(dd->type);
+    if (ds == NULL) {
+      ERROR(PLUGIN_NAME ": Data set not found for '%s' type", dd->type);
+      return SNMP_NOSUCHINSTANCE;
+    }
+
+    ret = uc_get_value_by_name(name, &values, &values_num);
 
-  assert(ds->ds_num == values_num);
-  assert(oid_index < (int)values_num);
+    if (ret != 0) {
+      ERROR(PLUGIN_NAME ": Failed to get value for '%s'", name);
+      return SNMP_NOSUCHINSTANCE;
+    }
+
+    assert(ds->ds_num == values_num);
+    assert(oid_index < (int)values_num);
+
+    value = values[oid_index];
+    sfree(values);
+  }
 
   char data[DATA_MAX_NAME_LEN];
   size_t data_len = sizeof(data);
-  ret = snmp_agent_set_vardata(
-      data, &data_len, dd->oids[oid_index].type, dd->scale, dd->shift,
-      &values[oid_index], sizeof(values[oid_index]), ds->ds[oid_index].type);
-
-  sfree(values);
+  ret = snmp_agent_set_vardata(data, &data_len, dd->oids[oid_index].type,
+                               dd->scale, dd->shift, &value, sizeof(value),
+                               ds->ds[oid_index].type);
 
   if (ret != 0) {
-    ERROR(PLUGIN_NAME ": Failed to convert '%s' value to snmp data", name);
+    ERROR(PLUGIN_NAME ": Failed to convert '%s' value to snmp data", dd->name);
     return SNMP_NOSUCHINSTANCE;
   }
 
@@ -1177,27 +1314,30 @@ snmp_agent_table_oid_handler(struct netsnmp_mib_handler_s *handler,
         memcpy(index_oid.oid, &oid.oid[dd->oids[i].oid_len],
                index_oid.oid_len * sizeof(*oid.oid));
 
-        char index_str[DATA_MAX_NAME_LEN];
-        snmp_agent_oid_to_string(index_str, sizeof(index_str), &index_oid);
+        table_row_t *row = NULL;
 
         if (!td->index_oid.oid_len) {
-          ret = c_avl_get(td->instance_index, &index_oid, NULL);
+          ret = c_avl_get(td->instance_rows, &index_oid, (void **)&row);
         } else {
           oid_t *temp_oid;
+          int index = index_oid.oid[0];
 
           assert(index_oid.oid_len == 1);
-          ret = c_avl_get(td->index_instance, (int *)&index_oid.oid[0],
-                          (void **)&temp_oid);
-          memcpy(&index_oid, temp_oid, sizeof(index_oid));
+          ret = c_avl_get(td->index_instance, &index, (void **)&temp_oid);
+          if (ret == 0)
+            ret = c_avl_get(td->instance_rows, temp_oid, (void **)&row);
         }
 
         if (ret != 0) {
+          char index_str[DATA_MAX_NAME_LEN];
+
+          snmp_agent_oid_to_string(index_str, sizeof(index_str), &index_oid);
           INFO(PLUGIN_NAME ": Non-existing index (%s) requested", index_str);
           pthread_mutex_unlock(&g_agent->lock);
           return SNMP_NOSUCHINSTANCE;
         }
 
-        ret = snmp_agent_form_reply(requests, dd, &index_oid, i);
+        ret = snmp_agent_form_reply(requests, dd, row, i);
         pthread_mutex_unlock(&g_agent->lock);
 
         return ret;
@@ -1763,6 +1903,13 @@ static int snmp_agent_config_table(oconfig_item_t *ci) {
     return -ENOMEM;
   }
 
+  td->instance_rows =
+      c_avl_create((int (*)(const void *, const void *))oid_compare);
+  if (td->instance_rows == NULL) {
+    snmp_agent_free_table(&td);
+    return -ENOMEM;
+  }
+
   llentry_t *entry = llentry_create(td->name, td);
   if (entry == NULL) {
     snmp_agent_free_table(&td);
@@ -1891,6 +2038,7 @@ static int snmp_agent_update_index(data_definition_t *dd,
   int ret;
   int *index = NULL;
   int *value = NULL;
+  table_row_t *row = NULL;
 
   if (c_avl_get(td->instance_index, (void *)index_oid, (void **)&index) != 0) {
     /* We'll keep index_oid stored in AVL tree */
@@ -1928,12 +2076,27 @@ static int snmp_agent_update_index(data_definition_t *dd,
         goto error;
     }
 
+    row = snmp_agent_row_create(td);
+    if (row == NULL) {
+      ERROR(PLUGIN_NAME ": Failed to allocate memory");
+      ret = -ENOMEM;
+      goto unregister_index;
+    }
+
+    ret = c_avl_insert(td->instance_rows, index_oid, row);
+    if (ret != 0) {
+      DEBUG(PLUGIN_NAME ": Failed to update instance_rows for '%s' table",
+            td->name);
+      snmp_agent_row_destroy(row);
+      goto unregister_index;
+    }
+
     value = calloc(1, sizeof(*value));
 
     if (value == NULL) {
       ERROR(PLUGIN_NAME ": Failed to allocate memory");
       ret = -ENOMEM;
-      goto unregister_index;
+      goto remove_row;
     }
 
     ret = c_avl_insert(td->instance_oids, index_oid, value);
@@ -2012,6 +2175,9 @@ static int snmp_agent_update_index(data_definition_t *dd,
 
 free_value:
   sfree(value);
+remove_row:
+  c_avl_remove(td->instance_rows, index_oid, NULL, NULL);
+  snmp_agent_row_destroy(row);
 unregister_index:
   if (td->index_oid.oid_len)
     snmp_agent_unregister_oid_index(index_oid, *index);
@@ -2029,7 +2195,7 @@ error:
   return ret;
 }
 
-static int snmp_agent_write(value_list_t const *vl) {
+static int snmp_agent_write(const data_set_t *ds, value_list_t const *vl) {
   if (vl == NULL)
     return -EINVAL;
 
@@ -2055,6 +2221,14 @@ static int snmp_agent_write(value_list_t const *vl) {
           if (ret == 0)
             ret = snmp_agent_update_index(dd, td, index_oid, &free_index_oid);
 
+          if (ret == 0) {
+            table_row_t *row;
+
+            ret = c_avl_get(td->instance_rows, index_oid, (void **)&row);
+            if (ret == 0)
+              ret = snmp_agent_row_update(row, dd, ds, vl);
+          }
+
           /* Index exists or update failed */
           if (free_index_oid)
             sfree(index_oid);
@@ -2073,7 +2247,7 @@ static int snmp_agent_collect(const data_set_t *ds, const value_list_t *vl,
 
   pthread_mutex_lock(&g_agent->lock);
 
-  snmp_agent_write(vl);
+  snmp_agent_write(ds, vl);
 
   pthread_mutex_unlock(&g_agent->lock);
 
@@ -2350,5 +2524,6 @@ static int snmp_agent_config(oconfig_item_t *ci) {
 
 void module_register(void) {
   plugin_register_init(PLUGIN_NAME, snmp_agent_init);
+  plugin_register_init_exclusive(PLUGIN_NAME);
   plugin_register_complex_config(PLUGIN_NAME, snmp_agent_config);
 }
@@ -784,6 +784,57 @@ DEF_TEST(build_name) {
   return 0;
 }
 
+DEF_TEST(row_update) {
+  table_definition_t *td = calloc(1, sizeof(*td));
+  data_definition_t *dd = calloc(1, sizeof(*dd));
+  data_source_t dsrc = {"value", DS_TYPE_GAUGE, 0, NAN};
+  data_set_t ds = {TEST_TYPE, 1, &dsrc};
+  value_t values[] = {{.gauge = 42}};
+  value_list_t vl = {.values = values, .values_len = 1};
+  int key = 7;
+
+  assert(td != NULL);
+  assert(dd != NULL);
+
+  td->index_list_cont = NULL;
+  snmp_varlist_add_variable(&td->index_list_cont, NULL, 0, ASN_INTEGER,
+                            (const u_char *)&key, sizeof(key));
+  dd->name = "test_column";
+  dd->table = td;
+
+  table_row_t *row = snmp_agent_row_create(td);
+  assert(row != NULL);
+
+  /* Index keys are copied, the container is reused for the next instance */
+  OK(row->index_keys != td->index_list_cont);
+  EXPECT_EQ_INT(key, *row->index_keys->val.integer);
+
+  int ret = snmp_agent_row_update(row, dd, &ds, &vl);
+  EXPECT_EQ_INT(0, ret);
+  EXPECT_EQ_INT(1, llist_size(row->values));
+
+  values[0].gauge = 43;
+  ret = snmp_agent_row_update(row, dd, &ds, &vl);
+  EXPECT_EQ_INT(0, ret);
+  EXPECT_EQ_INT(1, llist_size(row->values));
+
+  column_value_t *cv = llist_search(row->values, dd->name)->value;
+  EXPECT_EQ_DOUBLE(43, cv->values[0].gauge);
+
+  vl.values_len = 2;
+  ret = snmp_agent_row_update(row, dd, &ds, &vl);
+  EXPECT_EQ_INT(-EINVAL, ret);
+
+  snmp_agent_row_remove_value(row, dd);
+  EXPECT_EQ_INT(0, llist_size(row->values));
+
+  snmp_agent_row_destroy(row);
+  snmp_free_varbind(td->index_list_cont);
+  sfree(dd);
+  sfree(td);
+  return 0;
+}
+
 int main(void) {
   /* snmp_agent_oid_to_string */
   RUN_TEST(oid_to_string);
@@ -827,5 +878,8 @@ int main(void) {
   /* snmp_agent_build_name */
   RUN_TEST(build_name);
 
+  /* snmp_agent_row_* */
+  RUN_TEST(row_update);
+
   END_TEST;
 }
@@ -0,0 +1,134 @@
+/**
+ * collectd - src/snmp_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "snmp.c" /* sic */
+#include "testing.h"
+
+/* The discard port; nothing answers there, so requests stay outstanding. */
+#define TEST_ADDRESS "udp:127.0.0.1:9"
+
+/* plugin_thread_create() is not available in the test, so the engine thread
+ * is started the same way `csnmp_engine_start' does, using pthread_create. */
+static int engine_start(void) {
+  if (pipe(csnmp_engine_pipe) != 0)
+    return -1;
+  for (int i = 0; i < 2; i++) {
+    int flags = fcntl(csnmp_engine_pipe[i], F_GETFL);
+    fcntl(csnmp_engine_pipe[i], F_SETFL, flags | O_NONBLOCK);
+  }
+
+  csnmp_engine_loop = true;
+  if (pthread_create(&csnmp_engine_thread, NULL, csnmp_engine_main, NULL) !=
+      0)
+    return -1;
+  csnmp_engine_running = true;
+  return 0;
+}
+
+static bool host_polling(host_definition_t *host) {
+  pthread_mutex_lock(&csnmp_engine_lock);
+  bool polling = host->polling;
+  pthread_mutex_unlock(&csnmp_engine_lock);
+  return polling;
+}
+
+static host_definition_t *host_create(data_definition_t *data) {
+  host_definition_t *host = calloc(1, sizeof(*host));
+  host->name = strdup("test");
+  host->address = strdup(TEST_ADDRESS);
+  host->community = strdup("public");
+  host->version = 2;
+  host->timeout = TIME_T_TO_CDTIME_T(10);
+  host->retries = 0;
+  host->max_inflight = 1;
+  C_COMPLAIN_INIT(&host->complaint);
+
+  if (data != NULL) {
+    host->data_list = calloc(1, sizeof(*host->data_list));
+    host->data_list[0] = data;
+    host->data_list_len = 1;
+  }
+  return host;
+}
+
+DEF_TEST(skip_busy_host) {
+  host_definition_t *host = host_create(NULL);
+
+  host->polling = true;
+  /* Skipping an interval must not trigger the read backoff. */
+  EXPECT_EQ_INT(0, csnmp_read_host_async(host));
+  OK(csnmp_engine_queue == NULL);
+
+  host->polling = false;
+  csnmp_host_definition_destroy(host);
+  return 0;
+}
+
+DEF_TEST(finish_job) {
+  host_definition_t *host = host_create(NULL);
+
+  CHECK_ZERO(engine_start());
+  CHECK_ZERO(csnmp_read_host_async(host));
+
+  /* A host without data is done as soon as its session is open. */
+  for (int i = 0; (i < 100) && host_polling(host); i++)
+    usleep(20000);
+  OK(!host_polling(host));
+
+  csnmp_host_definition_destroy(host);
+  OK(!csnmp_engine_running);
+  return 0;
+}
+
+DEF_TEST(destroy_while_polling) {
+  data_definition_t data = {
+      .name = "uptime",
+      .type = "MAGIC",
+      .values = &(oid_t){.oid = {1, 3, 6, 1, 2, 1, 1, 3, 0}, .oid_len = 9},
+      .values_len = 1,
+  };
+  host_definition_t *host = host_create(&data);
+
+  CHECK_ZERO(engine_start());
+  CHECK_ZERO(csnmp_read_host_async(host));
+  usleep(200000);
+  /* The request is not answered within the timeout. */
+  OK(host_polling(host));
+
+  /* Must stop the engine before the host and its session are freed. */
+  csnmp_host_definition_destroy(host);
+  OK(!csnmp_engine_running);
+  OK(csnmp_engine_queue == NULL);
+  return 0;
+}
+
+int main(void) {
+  call_snmp_init_once();
+  csnmp_async = true;
+
+  RUN_TEST(skip_busy_host);
+  RUN_TEST(finish_job);
+  RUN_TEST(destroy_while_polling);
+
+  END_TEST;
+}
@@ -24,6 +24,9 @@
  *     Andrew Bays <abays at redhat.com>
  **/
 
+/* _GNU_SOURCE is needed in Linux to use recvmmsg */
+#define _GNU_SOURCE
+
 #include "collectd.h"
 
 #include "plugin.h"
@@ -48,7 +51,7 @@
 #include <yajl/yajl_version.h>
 #endif
 #if defined(YAJL_MAJOR) && (YAJL_MAJOR > 1)
-#include <yajl/yajl_tree.h>
+#include <yajl/yajl_parse.h>
 #define HAVE_YAJL_V2 1
 #endif
 
@@ -86,18 +89,71 @@
 #define SYSEVENT_SYSLOG_TAG_FIELD "syslogTag"
 #define SYSEVENT_SYSLOG_TAG_VALUE "NILVALUE"
 
+/* Maximum number of datagrams received with a single system call. */
+#define SYSEVENT_RECV_BATCH 64
+
 /*
  * Private data types
  */
 
+/*
+ * The ring is shared by exactly one producer, the socket thread, and one
+ * consumer, the dequeue thread. The entries from `tail' up to `head' belong to
+ * the consumer, all others to the producer, so the entries themselves are
+ * accessed without locking. Only the indices are read and advanced while
+ * holding `sysevent_data_lock'.
+ */
 typedef struct {
   int head;
   int tail;
   int maxLen;
   char **buffer;
+  size_t *length;
   cdtime_t *timestamp;
 } circbuf_t;
 
+typedef struct {
+  derive_t received;
+  derive_t truncated;
+  derive_t dropped;
+  derive_t filtered;
+  derive_t dispatched;
+} sysevent_stats_t;
+
+#if HAVE_YAJL_V2
+enum {
+  SYSEVENT_FIELD_MESSAGE,
+  SYSEVENT_FIELD_SOURCE_HOST,
+  SYSEVENT_FIELD_SEVERITY,
+  SYSEVENT_FIELD_SEVERITY_NUM,
+  SYSEVENT_FIELD_PROGRAM,
+  SYSEVENT_FIELD_NUM
+};
+/* The "@fields" object, whose members are extracted. */
+#define SYSEVENT_FIELD_FIELDS SYSEVENT_FIELD_NUM
+#define SYSEVENT_FIELD_NONE (-1)
+
+/* State of the streaming parser which extracts the values used for the
+ * notification from an rsyslog JSON message. No other values are copied and
+ * parsing stops as soon as all values have been found. */
+typedef struct {
+  int depth;
+  int key;
+  bool is_object;
+  bool in_fields;
+  bool filtered;
+  unsigned int missing;
+  char *values[SYSEVENT_FIELD_NUM];
+
+  /* Holds the extracted values. Unescaped strings are never longer than
+   * their quoted JSON representation, so the size of the receive buffer is
+   * sufficient. */
+  char *arena;
+  size_t arena_size;
+  size_t arena_fill;
+} sysevent_fields_t;
+#endif
+
 /*
  * Private variables
  */
@@ -115,6 +171,13 @@ static pthread_cond_t sysevent_cond = PTHREAD_COND_INITIALIZER;
 static int sock = -1;
 static int event_id = 0;
 static circbuf_t ring;
+static char *drop_buffer;
+static sysevent_stats_t stats;
+static c_complain_t ring_full_complaint = C_COMPLAIN_INIT_STATIC;
+static c_complain_t truncated_complaint = C_COMPLAIN_INIT_STATIC;
+#if HAVE_YAJL_V2
+static sysevent_fields_t fields;
+#endif
 
 static char *listen_ip;
 static char *listen_port;
@@ -122,6 +185,7 @@ static int listen_buffer_size = 4096;
 static int buffer_length = 10;
 
 static int monitor_all_messages = 1;
+static bool report_stats;
 
 #if HAVE_YAJL_V2
 static const char *rsyslog_keys[3] = {"@timestamp", "@source_host", "@message"};
@@ -401,89 +465,331 @@ err:
   return -1;
 }
 
-static int read_socket() {
-  int recv_flags = MSG_DONTWAIT;
+/* Receives up to `num' datagrams into `buffers', which are at least
+ * `listen_buffer_size' bytes large, and stores their lengths in `lengths'.
+ * Blocks until at least one datagram is available. Returns the number of
+ * datagrams received or -1 on error. */
+static int sysevent_recv(char **buffers, size_t *lengths, int num, /* {{{ */
+                         int *ret_truncated) {
+  struct iovec iov[SYSEVENT_RECV_BATCH];
+  int truncated = 0;
+
+  if (num > SYSEVENT_RECV_BATCH)
+    num = SYSEVENT_RECV_BATCH;
+
+  for (int i = 0; i < num; i++) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = listen_buffer_size - 1;
+  }
 
-  while (42) {
-    struct sockaddr_storage src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+#if HAVE_RECVMMSG
+  struct mmsghdr msgs[SYSEVENT_RECV_BATCH];
+  memset(msgs, 0, sizeof(msgs[0]) * num);
 
-    char buffer[listen_buffer_size];
-    memset(buffer, '\0', listen_buffer_size);
+  for (int i = 0; i < num; i++) {
+    msgs[i].msg_hdr.msg_iov = iov + i;
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
 
-    ssize_t count = recvfrom(sock, buffer, sizeof(buffer), recv_flags,
-                             (struct sockaddr *)&src_addr, &src_addr_len);
+  // Block until the first datagram arrives and then take whatever else is
+  // already queued, without waiting for more
+  int count = recvmmsg(sock, msgs, num, MSG_WAITFORONE, NULL);
+  if (count < 0)
+    return (errno == EINTR) ? 0 : -1;
 
-    if (count < 0) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        pthread_mutex_lock(&sysevent_data_lock);
+  for (int i = 0; i < count; i++) {
+    lengths[i] = msgs[i].msg_len;
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+      truncated++;
+  }
+#else
+  int count = 0;
 
-        // There was nothing more to receive for now, so...
-        // If ring head does not equal ring tail, there is data
-        // in the ring buffer for the dequeue thread to read, so
-        // signal it
-        if (ring.head != ring.tail)
-          pthread_cond_signal(&sysevent_cond);
+  while (count < num) {
+    struct msghdr msg = {
+        .msg_iov = iov + count,
+        .msg_iovlen = 1,
+    };
 
-        pthread_mutex_unlock(&sysevent_data_lock);
+    // Only block for the first datagram
+    ssize_t status = recvmsg(sock, &msg, (count == 0) ? 0 : MSG_DONTWAIT);
 
-        // Since there was nothing to receive, set recv to block and
-        // try again
-        recv_flags = 0;
-        continue;
-      } else if (errno != EINTR) {
-        ERROR("sysevent plugin: failed to receive data: %s", STRERRNO);
-        return -1;
-      } else {
-        // Interrupt, so continue and try again
+    if (status < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      else if (errno == EINTR)
         continue;
-      }
+      else if (count > 0)
+        break;
+      return -1;
     }
 
-    if (count >= sizeof(buffer)) {
-      WARNING("sysevent plugin: datagram too large for buffer: truncated");
-    }
+    lengths[count] = (size_t)status;
+    if (msg.msg_flags & MSG_TRUNC)
+      truncated++;
+    count++;
+  }
+#endif
+
+  for (int i = 0; i < count; i++)
+    buffers[i][lengths[i]] = '\0';
 
-    // We successfully received a message, so don't block on the next
-    // read in case there are more (and if there aren't, it will be
-    // handled above in the EWOULDBLOCK error-checking)
-    recv_flags = MSG_DONTWAIT;
+  *ret_truncated = truncated;
+  return count;
+} /* }}} int sysevent_recv */
 
-    // 1. Acquire data lock
-    // 2. Push to buffer if there is room, otherwise raise warning
-    //    and allow dequeue thread to take over
+static int read_socket() {
+  char *buffers[SYSEVENT_RECV_BATCH];
+  size_t lengths[SYSEVENT_RECV_BATCH];
 
+  while (42) {
     pthread_mutex_lock(&sysevent_data_lock);
+    int head = ring.head;
+    // One entry always stays empty, so that a full ring can be told apart
+    // from an empty one
+    int num = ring.tail - head - 1;
+    if (num < 0)
+      num += ring.maxLen;
+    pthread_mutex_unlock(&sysevent_data_lock);
 
-    int next = ring.head + 1;
-    if (next >= ring.maxLen)
-      next = 0;
+    int truncated = 0;
+
+    if (num == 0) {
+      // The ring is full, so receive the next message into a scratch
+      // buffer and drop it.  Then give the dequeue thread some time to
+      // clean out the ring before trying again.
+      size_t length;
+      int count = sysevent_recv(&drop_buffer, &length, 1, &truncated);
 
-    if (next == ring.tail) {
-      // Buffer is full, signal the dequeue thread to process the buffer
-      // and clean it out, and then sleep
-      WARNING("sysevent plugin: ring buffer full");
+      if (count < 0) {
+        ERROR("sysevent plugin: failed to receive data: %s", STRERRNO);
+        return -1;
+      }
 
+      pthread_mutex_lock(&sysevent_data_lock);
+      stats.received += count;
+      stats.dropped += count;
       pthread_cond_signal(&sysevent_cond);
       pthread_mutex_unlock(&sysevent_data_lock);
 
+      c_complain(LOG_WARNING, &ring_full_complaint,
+                 "sysevent plugin: ring buffer full, dropping messages");
+
       usleep(1000);
       continue;
-    } else {
-      DEBUG("sysevent plugin: writing %s", buffer);
+    }
+
+    if (num > SYSEVENT_RECV_BATCH)
+      num = SYSEVENT_RECV_BATCH;
+
+    // The free entries belong to this thread, so the datagrams are received
+    // right into them without holding the lock
+    for (int i = 0; i < num; i++)
+      buffers[i] = ring.buffer[(head + i) % ring.maxLen];
+
+    int count = sysevent_recv(buffers, lengths, num, &truncated);
+
+    if (count < 0) {
+      ERROR("sysevent plugin: failed to receive data: %s", STRERRNO);
+      return -1;
+    } else if (count == 0)
+      continue;
 
-      sstrncpy(ring.buffer[ring.head], buffer, sizeof(buffer));
-      ring.timestamp[ring.head] = cdtime();
-      ring.head = next;
+    cdtime_t now = cdtime();
+
+    for (int i = 0; i < count; i++) {
+      int entry = (head + i) % ring.maxLen;
+
+      DEBUG("sysevent plugin: writing %s", ring.buffer[entry]);
+
+      ring.length[entry] = lengths[i];
+      ring.timestamp[entry] = now;
     }
 
+    // Publish the new entries and wake up the dequeue thread if it is
+    // waiting for data
+    pthread_mutex_lock(&sysevent_data_lock);
+
+    if (ring.head == ring.tail)
+      pthread_cond_signal(&sysevent_cond);
+
+    ring.head = (head + count) % ring.maxLen;
+    stats.received += count;
+    stats.truncated += truncated;
+
     pthread_mutex_unlock(&sysevent_data_lock);
+
+    if (truncated > 0)
+      c_complain(LOG_WARNING, &truncated_complaint,
+                 "sysevent plugin: datagram too large for buffer: truncated");
   }
 }
 
+#if HAVE_YAJL_V2
+static int sysevent_fields_start_map(void *ctx) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+
+  if (f->depth == 0)
+    f->is_object = true;
+  else if (f->depth == 1 && f->key == SYSEVENT_FIELD_FIELDS)
+    f->in_fields = true;
+
+  f->depth++;
+  f->key = SYSEVENT_FIELD_NONE;
+  return 1;
+} /* }}} int sysevent_fields_start_map */
+
+static int sysevent_fields_start_array(void *ctx) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+
+  f->depth++;
+  f->key = SYSEVENT_FIELD_NONE;
+  return 1;
+} /* }}} int sysevent_fields_start_array */
+
+static int sysevent_fields_end(void *ctx) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+
+  if (f->depth == 2)
+    f->in_fields = false;
+
+  f->depth--;
+  return 1;
+} /* }}} int sysevent_fields_end */
+
+static bool sysevent_key_equal(const unsigned char *key, size_t len, /* {{{ */
+                               const char *name) {
+  return (strlen(name) == len) && (memcmp(key, name, len) == 0);
+} /* }}} bool sysevent_key_equal */
+
+static int sysevent_fields_map_key(void *ctx, const unsigned char *key,
+                                   size_t len) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+
+  f->key = SYSEVENT_FIELD_NONE;
+
+  if (f->depth == 1) {
+    if (sysevent_key_equal(key, len, rsyslog_keys[2]))
+      f->key = SYSEVENT_FIELD_MESSAGE;
+    else if (sysevent_key_equal(key, len, rsyslog_keys[1]))
+      f->key = SYSEVENT_FIELD_SOURCE_HOST;
+    else if (sysevent_key_equal(key, len, "@fields"))
+      f->key = SYSEVENT_FIELD_FIELDS;
+  } else if (f->depth == 2 && f->in_fields) {
+    if (sysevent_key_equal(key, len, rsyslog_field_keys[1]))
+      f->key = SYSEVENT_FIELD_SEVERITY;
+    else if (sysevent_key_equal(key, len, rsyslog_field_keys[2]))
+      f->key = SYSEVENT_FIELD_SEVERITY_NUM;
+    else if (sysevent_key_equal(key, len, rsyslog_field_keys[3]))
+      f->key = SYSEVENT_FIELD_PROGRAM;
+  }
+
+  return 1;
+} /* }}} int sysevent_fields_map_key */
+
+static int sysevent_fields_string(void *ctx, const unsigned char *value,
+                                  size_t len) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+  int field = f->key;
+
+  f->key = SYSEVENT_FIELD_NONE;
+
+  if (field < 0 || field >= SYSEVENT_FIELD_NUM || f->values[field] != NULL)
+    return 1;
+
+  if (f->arena_fill + len + 1 > f->arena_size)
+    return 1;
+
+  char *copy = f->arena + f->arena_fill;
+  memcpy(copy, value, len);
+  copy[len] = '\0';
+  f->arena_fill += len + 1;
+
+  f->values[field] = copy;
+  f->missing &= ~(1u << field);
+
+  // If we have any regex filters, the message portion of the data has to
+  // match one of them. Otherwise there is no need to look any further.
+  if (field == SYSEVENT_FIELD_MESSAGE && monitor_all_messages == 0 &&
+      ignorelist_match(ignorelist, copy) != 0) {
+    f->filtered = true;
+    return 0;
+  }
+
+  // Stop parsing as soon as all values have been found
+  return (f->missing != 0);
+} /* }}} int sysevent_fields_string */
+
+static int sysevent_fields_null(void *ctx) /* {{{ */
+{
+  sysevent_fields_t *f = ctx;
+
+  f->key = SYSEVENT_FIELD_NONE;
+  return 1;
+} /* }}} int sysevent_fields_null */
+
+static int sysevent_fields_boolean(void *ctx, int value) /* {{{ */
+{
+  return sysevent_fields_null(ctx);
+} /* }}} int sysevent_fields_boolean */
+
+static int sysevent_fields_number(void *ctx, const char *value,
+                                  size_t len) /* {{{ */
+{
+  return sysevent_fields_null(ctx);
+} /* }}} int sysevent_fields_number */
+
+/* Extracts the values used for the notification from `msg'. Returns zero if
+ * `msg' is a JSON object, in which case `f->filtered' tells whether the
+ * message has been rejected by the regex filters. */
+static int sysevent_fields_parse(sysevent_fields_t *f, /* {{{ */
+                                 const char *msg, size_t len) {
+  static const yajl_callbacks callbacks = {
+      .yajl_null = sysevent_fields_null,
+      .yajl_boolean = sysevent_fields_boolean,
+      .yajl_number = sysevent_fields_number,
+      .yajl_string = sysevent_fields_string,
+      .yajl_start_map = sysevent_fields_start_map,
+      .yajl_map_key = sysevent_fields_map_key,
+      .yajl_end_map = sysevent_fields_end,
+      .yajl_start_array = sysevent_fields_start_array,
+      .yajl_end_array = sysevent_fields_end,
+  };
+
+  f->depth = 0;
+  f->key = SYSEVENT_FIELD_NONE;
+  f->is_object = false;
+  f->in_fields = false;
+  f->filtered = false;
+  f->missing = (1u << SYSEVENT_FIELD_NUM) - 1;
+  memset(f->values, 0, sizeof(f->values));
+  f->arena_fill = 0;
+
+  yajl_handle handle = yajl_alloc(&callbacks, NULL, f);
+  if (handle == NULL)
+    return -1;
+
+  yajl_status status = yajl_parse(handle, (const unsigned char *)msg, len);
+  if (status == yajl_status_ok)
+    status = yajl_complete_parse(handle);
+
+  yajl_free(handle);
+
+  if (status == yajl_status_error || !f->is_object)
+    return -1;
+
+  return 0;
+} /* }}} int sysevent_fields_parse */
+#endif
+
 static void sysevent_dispatch_notification(const char *message,
 #if HAVE_YAJL_V2
-                                           yajl_val *node,
+                                           const sysevent_fields_t *f,
 #endif
                                            cdtime_t timestamp) {
   char *buf = NULL;
@@ -496,82 +802,24 @@ static void sysevent_dispatch_notification(const char *message,
   };
 
 #if HAVE_YAJL_V2
-  if (node != NULL) {
-    // If we have a parsed-JSON node to work with, use that
-    // msg
-    const char *msg_path[] = {rsyslog_keys[2], (const char *)0};
-    yajl_val msg_v = yajl_tree_get(*node, msg_path, yajl_t_string);
-
-    char msg[listen_buffer_size];
-
-    if (msg_v != NULL) {
-      memset(msg, '\0', listen_buffer_size);
-      snprintf(msg, listen_buffer_size, "%s%c", YAJL_GET_STRING(msg_v), '\0');
-    }
-
-    // severity
-    const char *severity_path[] = {"@fields", rsyslog_field_keys[1],
-                                   (const char *)0};
-    yajl_val severity_v = yajl_tree_get(*node, severity_path, yajl_t_string);
-
-    char severity[listen_buffer_size];
-
-    if (severity_v != NULL) {
-      memset(severity, '\0', listen_buffer_size);
-      snprintf(severity, listen_buffer_size, "%s%c",
-               YAJL_GET_STRING(severity_v), '\0');
-    }
-
-    // sev_num
-    const char *sev_num_str_path[] = {"@fields", rsyslog_field_keys[2],
-                                      (const char *)0};
-    yajl_val sev_num_str_v =
-        yajl_tree_get(*node, sev_num_str_path, yajl_t_string);
-
-    char sev_num_str[listen_buffer_size];
+  if (f != NULL) {
+    // If we have extracted JSON values to work with, use those
     int sev_num = -1;
 
-    if (sev_num_str_v != NULL) {
-      memset(sev_num_str, '\0', listen_buffer_size);
-      snprintf(sev_num_str, listen_buffer_size, "%s%c",
-               YAJL_GET_STRING(sev_num_str_v), '\0');
-
-      sev_num = atoi(sev_num_str);
+    if (f->values[SYSEVENT_FIELD_SEVERITY_NUM] != NULL) {
+      sev_num = atoi(f->values[SYSEVENT_FIELD_SEVERITY_NUM]);
 
       if (sev_num < 4)
         n.severity = NOTIF_FAILURE;
     }
 
-    // process
-    const char *process_path[] = {"@fields", rsyslog_field_keys[3],
-                                  (const char *)0};
-    yajl_val process_v = yajl_tree_get(*node, process_path, yajl_t_string);
-
-    char process[listen_buffer_size];
-
-    if (process_v != NULL) {
-      memset(process, '\0', listen_buffer_size);
-      snprintf(process, listen_buffer_size, "%s%c", YAJL_GET_STRING(process_v),
-               '\0');
-    }
-
-    // hostname
-    const char *hostname_path[] = {rsyslog_keys[1], (const char *)0};
-    yajl_val hostname_v = yajl_tree_get(*node, hostname_path, yajl_t_string);
-
-    char hostname_str[listen_buffer_size];
-
-    if (hostname_v != NULL) {
-      memset(hostname_str, '\0', listen_buffer_size);
-      snprintf(hostname_str, listen_buffer_size, "%s%c",
-               YAJL_GET_STRING(hostname_v), '\0');
-    }
+    char *hostname = f->values[SYSEVENT_FIELD_SOURCE_HOST];
 
-    gen_message_payload(
-        (msg_v != NULL ? msg : NULL), (severity_v != NULL ? severity : NULL),
-        (sev_num_str_v != NULL ? sev_num : -1),
-        (process_v != NULL ? process : NULL),
-        (hostname_v != NULL ? hostname_str : hostname_g), timestamp, &buf);
+    gen_message_payload(f->values[SYSEVENT_FIELD_MESSAGE],
+                        f->values[SYSEVENT_FIELD_SEVERITY], sev_num,
+                        f->values[SYSEVENT_FIELD_PROGRAM],
+                        (hostname != NULL ? hostname : hostname_g), timestamp,
+                        &buf);
   } else {
     // Data was not sent in JSON format, so just treat the whole log entry
     // as the message (and we'll be unable to acquire certain data, so the
@@ -608,6 +856,51 @@ static void sysevent_dispatch_notification(const char *message,
     sfree(buf);
 }
 
+/* Applies the regex filters to a message and dispatches it if it passes.
+ * Returns true if a notification has been dispatched. */
+static bool handle_message(const char *msg, size_t len, cdtime_t timestamp) {
+#if HAVE_YAJL_V2
+  // Only data that looks like a JSON object is handed to the parser; plain
+  // syslog lines are used as they are
+  size_t start = 0;
+  while (start < len && isspace((unsigned char)msg[start]))
+    start++;
+
+  if (start < len && msg[start] == '{' &&
+      sysevent_fields_parse(&fields, msg, len) == 0) {
+    // JSON rsyslog data
+
+    // The regex filters have already been applied to the message portion of
+    // the data while parsing it, unless there was none
+    if (fields.filtered)
+      return false;
+    if (monitor_all_messages == 0 &&
+        fields.values[SYSEVENT_FIELD_MESSAGE] == NULL &&
+        ignorelist_match(ignorelist, "") != 0)
+      return false;
+
+    sysevent_dispatch_notification(NULL, &fields, timestamp);
+    return true;
+  }
+#endif
+
+  // non-JSON rsyslog data
+
+  // If we have any regex filters, we need to see if the message data
+  // matches any of them (otherwise we're not interested)
+  if (monitor_all_messages == 0 && ignorelist_match(ignorelist, msg) != 0)
+    return false;
+
+  DEBUG("sysevent plugin: regex filter match");
+
+#if HAVE_YAJL_V2
+  sysevent_dispatch_notification(msg, NULL, timestamp);
+#else
+  sysevent_dispatch_notification(msg, timestamp);
+#endif
+  return true;
+}
+
 static void read_ring_buffer() {
   pthread_mutex_lock(&sysevent_data_lock);
 
@@ -616,7 +909,14 @@ static void read_ring_buffer() {
   if (ring.head == ring.tail)
     pthread_cond_wait(&sysevent_cond, &sysevent_data_lock);
 
-  while (ring.head != ring.tail) {
+  int head = ring.head;
+
+  pthread_mutex_unlock(&sysevent_data_lock);
+
+  // The entries up to head belong to this thread, so they are processed
+  // without holding the lock. Each one is handed back to the socket thread
+  // as soon as it has been processed.
+  while (ring.tail != head) {
     int next = ring.tail + 1;
 
     if (next >= ring.maxLen)
@@ -625,73 +925,20 @@ static void read_ring_buffer() {
     DEBUG("sysevent plugin: reading from ring buffer: %s",
           ring.buffer[ring.tail]);
 
-    cdtime_t timestamp = ring.timestamp[ring.tail];
-    char *match_str = NULL;
-
-#if HAVE_YAJL_V2
-    // Try to parse JSON, and if it fails, fall back to plain string
-    char errbuf[1024];
-    errbuf[0] = 0;
-    yajl_val node = yajl_tree_parse((const char *)ring.buffer[ring.tail],
-                                    errbuf, sizeof(errbuf));
-
-    if (node != NULL) {
-      // JSON rsyslog data
-
-      // If we have any regex filters, we need to see if the message portion of
-      // the data matches any of them (otherwise we're not interested)
-      if (monitor_all_messages == 0) {
-        const char *path[] = {"@message", (const char *)0};
-        yajl_val v = yajl_tree_get(node, path, yajl_t_string);
-
-        char json_val[listen_buffer_size];
-        memset(json_val, '\0', listen_buffer_size);
-
-        snprintf(json_val, listen_buffer_size, "%s%c", YAJL_GET_STRING(v),
-                 '\0');
-
-        match_str = (char *)&json_val;
-      }
-    } else {
-      // non-JSON rsyslog data
+    bool dispatched = handle_message(ring.buffer[ring.tail],
+                                     ring.length[ring.tail],
+                                     ring.timestamp[ring.tail]);
 
-      // If we have any regex filters, we need to see if the message data
-      // matches any of them (otherwise we're not interested)
-      if (monitor_all_messages == 0)
-        match_str = ring.buffer[ring.tail];
-    }
-#else
-    // If we have any regex filters, we need to see if the message data
-    // matches any of them (otherwise we're not interested)
-    if (monitor_all_messages == 0)
-      match_str = ring.buffer[ring.tail];
-#endif
-
-    int is_match = 1;
-
-    // If we care about matching, do that comparison here
-    if (match_str != NULL) {
-      if (ignorelist_match(ignorelist, match_str) != 0)
-        is_match = 0;
-      else
-        DEBUG("sysevent plugin: regex filter match");
-    }
-
-#if HAVE_YAJL_V2
-    if (is_match == 1 && node != NULL) {
-      sysevent_dispatch_notification(NULL, &node, timestamp);
-      yajl_tree_free(node);
-    } else if (is_match == 1)
-      sysevent_dispatch_notification(ring.buffer[ring.tail], NULL, timestamp);
-#else
-    if (is_match == 1)
-      sysevent_dispatch_notification(ring.buffer[ring.tail], timestamp);
-#endif
+    pthread_mutex_lock(&sysevent_data_lock);
 
     ring.tail = next;
-  }
+    if (dispatched)
+      stats.dispatched++;
+    else
+      stats.filtered++;
 
-  pthread_mutex_unlock(&sysevent_data_lock);
+    pthread_mutex_unlock(&sysevent_data_lock);
+  }
 }
 
 static void *sysevent_socket_thread(void *arg) /* {{{ */
@@ -944,6 +1191,30 @@ static int sysevent_init(void) /* {{{ */
     return -1;
   }
 
+  ring.length = calloc(buffer_length, sizeof(*ring.length));
+
+  if (ring.length == NULL) {
+    ERROR("sysevent plugin: sysevent_init ring buffer length calloc failed");
+    return -1;
+  }
+
+  drop_buffer = calloc(1, listen_buffer_size);
+
+  if (drop_buffer == NULL) {
+    ERROR("sysevent plugin: sysevent_init drop buffer calloc failed");
+    return -1;
+  }
+
+#if HAVE_YAJL_V2
+  fields.arena_size = listen_buffer_size;
+  fields.arena = calloc(1, fields.arena_size);
+
+  if (fields.arena == NULL) {
+    ERROR("sysevent plugin: sysevent_init JSON field buffer calloc failed");
+    return -1;
+  }
+#endif
+
   if (sock == -1) {
     struct addrinfo hints = {
         .ai_family = AF_UNSPEC,
@@ -1076,6 +1347,8 @@ static int sysevent_config(oconfig_item_t *ci) /* {{{ */
       sysevent_config_add_buffer_length(child);
     else if (strcasecmp("RegexFilter", child->key) == 0)
       sysevent_config_add_regex_filter(child);
+    else if (strcasecmp("ReportStats", child->key) == 0)
+      cf_util_get_boolean(child, &report_stats);
     else {
       WARNING("sysevent plugin: Option `%s' is not allowed here.", child->key);
     }
@@ -1084,6 +1357,45 @@ static int sysevent_config(oconfig_item_t *ci) /* {{{ */
   return 0;
 } /* }}} int sysevent_config */
 
+static void submit_stats(void) /* {{{ */
+{
+  pthread_mutex_lock(&sysevent_data_lock);
+  sysevent_stats_t copy = stats;
+  int queue_length = ring.head - ring.tail;
+  if (queue_length < 0)
+    queue_length += ring.maxLen;
+  pthread_mutex_unlock(&sysevent_data_lock);
+
+  struct {
+    const char *type_instance;
+    derive_t value;
+  } counters[] = {
+      {"received", copy.received},     {"truncated", copy.truncated},
+      {"dropped", copy.dropped},       {"filtered", copy.filtered},
+      {"dispatched", copy.dispatched},
+  };
+
+  value_list_t vl = VALUE_LIST_INIT;
+  value_t value;
+
+  vl.values = &value;
+  vl.values_len = 1;
+  sstrncpy(vl.plugin, "sysevent", sizeof(vl.plugin));
+
+  sstrncpy(vl.type, "total_events", sizeof(vl.type));
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(counters); i++) {
+    value.derive = counters[i].value;
+    sstrncpy(vl.type_instance, counters[i].type_instance,
+             sizeof(vl.type_instance));
+    plugin_dispatch_values(&vl);
+  }
+
+  value.gauge = (gauge_t)queue_length;
+  sstrncpy(vl.type, "queue_length", sizeof(vl.type));
+  vl.type_instance[0] = 0;
+  plugin_dispatch_values(&vl);
+} /* }}} void submit_stats */
+
 static int sysevent_read(void) /* {{{ */
 {
   pthread_mutex_lock(&sysevent_thread_lock);
@@ -1104,6 +1416,21 @@ static int sysevent_read(void) /* {{{ */
 
   pthread_mutex_unlock(&sysevent_thread_lock);
 
+  // Report the end of dropping messages once a whole interval went by
+  // without dropping any
+  static derive_t last_dropped;
+  pthread_mutex_lock(&sysevent_data_lock);
+  derive_t dropped = stats.dropped;
+  pthread_mutex_unlock(&sysevent_data_lock);
+
+  if (dropped == last_dropped)
+    c_release(LOG_INFO, &ring_full_complaint,
+              "sysevent plugin: ring buffer no longer full");
+  last_dropped = dropped;
+
+  if (report_stats)
+    submit_stats();
+
   return 0;
 } /* }}} int sysevent_read */
 
@@ -1133,6 +1460,11 @@ static int sysevent_shutdown(void) /* {{{ */
 
   free(ring.buffer);
   free(ring.timestamp);
+  free(ring.length);
+  free(drop_buffer);
+#if HAVE_YAJL_V2
+  free(fields.arena);
+#endif
 
   if (status != 0)
     return status;
@@ -37,6 +37,8 @@
  *      Plugin "mail"
  *      Instance "exim"
  *      Interval 60
+ *      ReportStats false
+ *      Follow false
  *	<Match>
  *	  Regex "S=([1-9][0-9]*)"
  *	  ExcludeRegex "U=root.*S="
@@ -58,13 +60,30 @@ struct ctail_config_match_s {
 };
 typedef struct ctail_config_match_s ctail_config_match_t;
 
+struct ctail_file_s {
+  cu_tail_match_t *tm;
+  char *plugin_name;
+  char *plugin_instance;
+  bool report_stats;
+  bool follow;
+};
+typedef struct ctail_file_s ctail_file_t;
+
 static size_t tail_file_num;
 
 static int ctail_read(user_data_t *ud);
 
-static void ctail_match_free(void *arg) {
-  tail_match_destroy((cu_tail_match_t *)arg);
-} /* void ctail_match_free */
+static void ctail_file_free(void *arg) {
+  ctail_file_t *file = arg;
+
+  if (file == NULL)
+    return;
+
+  tail_match_destroy(file->tm);
+  sfree(file->plugin_name);
+  sfree(file->plugin_instance);
+  sfree(file);
+} /* void ctail_file_free */
 
 static int ctail_config_add_match_dstype(ctail_config_match_t *cm,
                                          oconfig_item_t *ci) {
@@ -213,10 +232,8 @@ static int ctail_config_add_match(cu_tail_match_t *tm, const char *plugin_name,
 } /* int ctail_config_add_match */
 
 static int ctail_config_add_file(oconfig_item_t *ci) {
-  cu_tail_match_t *tm;
+  ctail_file_t *file;
   cdtime_t interval = 0;
-  char *plugin_name = NULL;
-  char *plugin_instance = NULL;
   int num_matches = 0;
 
   if ((ci->values_num != 1) || (ci->values[0].type != OCONFIG_TYPE_STRING)) {
@@ -224,10 +241,17 @@ static int ctail_config_add_file(oconfig_item_t *ci) {
     return -1;
   }
 
-  tm = tail_match_create(ci->values[0].value.string);
-  if (tm == NULL) {
+  file = calloc(1, sizeof(*file));
+  if (file == NULL) {
+    ERROR("tail plugin: calloc failed.");
+    return -1;
+  }
+
+  file->tm = tail_match_create(ci->values[0].value.string);
+  if (file->tm == NULL) {
     ERROR("tail plugin: tail_match_create (%s) failed.",
           ci->values[0].value.string);
+    sfree(file);
     return -1;
   }
 
@@ -236,13 +260,18 @@ static int ctail_config_add_file(oconfig_item_t *ci) {
     int status = 0;
 
     if (strcasecmp("Plugin", option->key) == 0)
-      status = cf_util_get_string(option, &plugin_name);
+      status = cf_util_get_string(option, &file->plugin_name);
     else if (strcasecmp("Instance", option->key) == 0)
-      status = cf_util_get_string(option, &plugin_instance);
+      status = cf_util_get_string(option, &file->plugin_instance);
     else if (strcasecmp("Interval", option->key) == 0)
       cf_util_get_cdtime(option, &interval);
+    else if (strcasecmp("ReportStats", option->key) == 0)
+      status = cf_util_get_boolean(option, &file->report_stats);
+    else if (strcasecmp("Follow", option->key) == 0)
+      status = cf_util_get_boolean(option, &file->follow);
     else if (strcasecmp("Match", option->key) == 0) {
-      status = ctail_config_add_match(tm, plugin_name, plugin_instance, option);
+      status = ctail_config_add_match(file->tm, file->plugin_name,
+                                      file->plugin_instance, option);
       if (status == 0)
         num_matches++;
       /* Be mild with failed matches.. */
@@ -255,13 +284,10 @@ static int ctail_config_add_file(oconfig_item_t *ci) {
       break;
   } /* for (i = 0; i < ci->children_num; i++) */
 
-  sfree(plugin_name);
-  sfree(plugin_instance);
-
   if (num_matches == 0) {
     ERROR("tail plugin: No (valid) matches found for file `%s'.",
           ci->values[0].value.string);
-    tail_match_destroy(tm);
+    ctail_file_free(file);
     return -1;
   }
 
@@ -270,7 +296,7 @@ static int ctail_config_add_file(oconfig_item_t *ci) {
 
   plugin_register_complex_read(
       NULL, str, ctail_read, interval,
-      &(user_data_t){.data = tm, .free_func = ctail_match_free});
+      &(user_data_t){.data = file, .free_func = ctail_file_free});
 
   return 0;
 } /* int ctail_config_add_file */
@@ -289,15 +315,53 @@ static int ctail_config(oconfig_item_t *ci) {
   return 0;
 } /* int ctail_config */
 
+static void ctail_submit_stats(ctail_file_t *file) {
+  value_list_t vl = VALUE_LIST_INIT;
+  uint64_t lines_num;
+  cdtime_t cpu_time;
+
+  tail_match_get_stats(file->tm, &lines_num, &cpu_time);
+
+  sstrncpy(vl.plugin, (file->plugin_name != NULL) ? file->plugin_name : "tail",
+           sizeof(vl.plugin));
+  if (file->plugin_instance != NULL)
+    sstrncpy(vl.plugin_instance, file->plugin_instance,
+             sizeof(vl.plugin_instance));
+  vl.values_len = 1;
+
+  vl.values = &(value_t){.derive = (derive_t)lines_num};
+  sstrncpy(vl.type, "derive", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "lines", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+
+  vl.values = &(value_t){.derive = (derive_t)CDTIME_T_TO_MS(cpu_time)};
+  sstrncpy(vl.type, "total_time_in_ms", sizeof(vl.type));
+  sstrncpy(vl.type_instance, "cpu", sizeof(vl.type_instance));
+  plugin_dispatch_values(&vl);
+} /* void ctail_submit_stats */
+
 static int ctail_read(user_data_t *ud) {
+  ctail_file_t *file = ud->data;
   int status;
 
-  status = tail_match_read((cu_tail_match_t *)ud->data, 0);
+  /* The follower thread is started here rather than when reading the config,
+   * which happens before the daemon forks. If following is not possible, the
+   * file is read at each interval. */
+  if (file->follow) {
+    file->follow = false;
+    if (tail_match_follow(file->tm) != 0)
+      WARNING("tail plugin: Not following file, reading it at each interval.");
+  }
+
+  status = tail_match_read(file->tm, 0);
   if (status != 0) {
     ERROR("tail plugin: tail_match_read failed.");
     return -1;
   }
 
+  if (file->report_stats)
+    ctail_submit_stats(file);
+
   return 0;
 } /* int ctail_read */
 
@@ -48,6 +48,7 @@ struct instance_definition_s {
   char *instance;
   char *path;
   char field_separator;
+  bool follow;
   cu_tail_t *tail;
   metric_definition_t **metric_list;
   size_t metric_list_len;
@@ -215,6 +216,9 @@ static int tcsv_read(user_data_t *ud) {
       ERROR("tail_csv plugin: cu_tail_create (\"%s\") failed.", id->path);
       return -1;
     }
+
+    if (id->follow && (cu_tail_follow(id->tail) != 0))
+      WARNING("tail_csv plugin: Not following file \"%s\".", id->path);
   }
 
   while (42) {
@@ -475,6 +479,8 @@ static int tcsv_config_add_file(oconfig_item_t *ci) {
       status = cf_util_get_string(option, &id->plugin_name);
     else if (strcasecmp("FieldSeparator", option->key) == 0)
       status = tcsv_config_get_separator(option, &id->field_separator);
+    else if (strcasecmp("Follow", option->key) == 0)
+      status = cf_util_get_boolean(option, &id->follow);
     else {
       WARNING("tail_csv plugin: Option `%s' not allowed here.", option->key);
       status = -1;
@@ -28,16 +28,24 @@
 
 #include "filter_chain.h"
 #include "utils/common/common.h"
+#include "utils/string_cache/string_cache.h"
 #include "utils_subst.h"
 
 #include <regex.h>
 
+/* Number of input strings a rule remembers the result for. */
+#define TR_CACHE_SIZE 1024
+
 struct tr_action_s;
 typedef struct tr_action_s tr_action_t;
 struct tr_action_s {
   regex_t re;
   char *replacement;
   bool may_be_empty;
+  /* Only set for the first action of a list and caches the result of all
+   * actions in the list: one and the replaced string, or zero if the input is
+   * left alone. */
+  string_cache_t *cache;
 
   tr_action_t *next;
 };
@@ -48,6 +56,8 @@ struct tr_meta_data_action_s {
   char *key;
   regex_t re;
   char *replacement;
+  /* One and the replaced string, or zero if the regex does not match. */
+  string_cache_t *cache;
 
   tr_meta_data_action_t *next;
 };
@@ -59,6 +69,9 @@ struct tr_data_s {
   /* tr_action_t *type; */
   tr_action_t *type_instance;
   tr_meta_data_action_t *meta;
+
+  /* NULL unless `ReportStats' is enabled. */
+  string_cache_report_t *report;
 };
 typedef struct tr_data_s tr_data_t;
 
@@ -87,6 +100,7 @@ static void tr_action_destroy(tr_action_t *act) /* {{{ */
 
   regfree(&act->re);
   sfree(act->replacement);
+  string_cache_destroy(act->cache);
 
   if (act->next != NULL)
     tr_action_destroy(act->next);
@@ -102,6 +116,7 @@ static void tr_meta_data_action_destroy(tr_meta_data_action_t *act) /* {{{ */
   sfree(act->key);
   regfree(&act->re);
   sfree(act->replacement);
+  string_cache_destroy(act->cache);
 
   if (act->next != NULL)
     tr_meta_data_action_destroy(act->next);
@@ -154,6 +169,15 @@ static int tr_config_add_action(tr_action_t **dest, /* {{{ */
     return -ENOMEM;
   }
 
+  if (*dest == NULL) {
+    act->cache = string_cache_create(TR_CACHE_SIZE);
+    if (act->cache == NULL) {
+      ERROR("tr_config_add_action: string_cache_create failed.");
+      tr_action_destroy(act);
+      return -ENOMEM;
+    }
+  }
+
   /* Insert action at end of list. */
   if (*dest == NULL)
     *dest = act;
@@ -244,6 +268,13 @@ static int tr_config_add_meta_action(tr_meta_data_action_t **dest, /* {{{ */
     }
   }
 
+  act->cache = string_cache_create(TR_CACHE_SIZE);
+  if (act->cache == NULL) {
+    ERROR("tr_config_add_meta_action: string_cache_create failed.");
+    tr_meta_data_action_destroy(act);
+    return -ENOMEM;
+  }
+
   /* Insert action at end of list. */
   if (*dest == NULL)
     *dest = act;
@@ -270,6 +301,14 @@ static int tr_action_invoke(tr_action_t *act_head, /* {{{ */
   if (act_head == NULL)
     return -EINVAL;
 
+  int replaced;
+  if (string_cache_get(act_head->cache, buffer_in, &replaced, buffer,
+                       sizeof(buffer)) == 0) {
+    if (replaced)
+      sstrncpy(buffer_in, buffer, buffer_in_size);
+    return 0;
+  }
+
   sstrncpy(buffer, buffer_in, sizeof(buffer));
 
   DEBUG("target_replace plugin: tr_action_invoke: <- buffer = %s;", buffer);
@@ -309,10 +348,14 @@ static int tr_action_invoke(tr_action_t *act_head, /* {{{ */
   if ((may_be_empty == false) && (buffer[0] == 0)) {
     WARNING("Target `replace': Replacement resulted in an empty string, "
             "which is not allowed for this buffer (`host' or `plugin').");
+    string_cache_put(act_head->cache, buffer_in, /* replaced = */ 0, NULL);
     return 0;
   }
 
   DEBUG("target_replace plugin: tr_action_invoke: -> buffer = %s;", buffer);
+  replaced = (strcmp(buffer, buffer_in) != 0);
+  string_cache_put(act_head->cache, buffer_in, replaced,
+                   replaced ? buffer : NULL);
   sstrncpy(buffer_in, buffer, buffer_in_size);
 
   return 0;
@@ -359,19 +402,46 @@ static int tr_meta_data_action_invoke(/* {{{ */
           "old value = `%s'",
           act->key, value);
 
-    status = regexec(&act->re, value, STATIC_ARRAY_SIZE(matches), matches,
-                     /* flags = */ 0);
-    if (status == REG_NOMATCH) {
+    int matched;
+    status = string_cache_get(act->cache, value, &matched, temp, sizeof(temp));
+    if ((status == 0) && !matched) {
       sfree(value);
       continue;
     } else if (status != 0) {
-      char errbuf[1024] = "";
-
-      regerror(status, &act->re, errbuf, sizeof(errbuf));
-      ERROR("Target `replace': Executing a regular expression failed: %s.",
-            errbuf);
-      sfree(value);
-      continue;
+      status = regexec(&act->re, value, STATIC_ARRAY_SIZE(matches), matches,
+                       /* flags = */ 0);
+      if (status == REG_NOMATCH) {
+        string_cache_put(act->cache, value, /* matched = */ 0, NULL);
+        sfree(value);
+        continue;
+      } else if (status != 0) {
+        char errbuf[1024] = "";
+
+        regerror(status, &act->re, errbuf, sizeof(errbuf));
+        ERROR("Target `replace': Executing a regular expression failed: %s.",
+              errbuf);
+        sfree(value);
+        continue;
+      }
+
+      if (act->replacement == NULL) {
+        /* The key is deleted, so any output will do. */
+        temp[0] = 0;
+      } else {
+        subst_status =
+            subst(temp, sizeof(temp), value, (size_t)matches[0].rm_so,
+                  (size_t)matches[0].rm_eo, act->replacement);
+        if (subst_status == NULL) {
+          ERROR("Target `replace': subst (value = %s, start = %" PRIsz
+                ", end = %" PRIsz ", "
+                "replacement = %s) failed.",
+                value, (size_t)matches[0].rm_so, (size_t)matches[0].rm_eo,
+                act->replacement);
+          sfree(value);
+          continue;
+        }
+      }
+      string_cache_put(act->cache, value, /* matched = */ 1, temp);
     }
 
     if (act->replacement == NULL) {
@@ -384,18 +454,6 @@ static int tr_meta_data_action_invoke(/* {{{ */
       continue;
     }
 
-    subst_status = subst(temp, sizeof(temp), value, (size_t)matches[0].rm_so,
-                         (size_t)matches[0].rm_eo, act->replacement);
-    if (subst_status == NULL) {
-      ERROR("Target `replace': subst (value = %s, start = %" PRIsz
-            ", end = %" PRIsz ", "
-            "replacement = %s) failed.",
-            value, (size_t)matches[0].rm_so, (size_t)matches[0].rm_eo,
-            act->replacement);
-      sfree(value);
-      continue;
-    }
-
     DEBUG("target_replace plugin: tr_meta_data_action_invoke: `%s' "
           "value `%s' -> `%s'",
           act->key, value, temp);
@@ -423,6 +481,41 @@ static int tr_meta_data_action_invoke(/* {{{ */
   return 0;
 } /* }}} int tr_meta_data_action_invoke */
 
+static int tr_report_create(tr_data_t *data) /* {{{ */
+{
+  struct {
+    const char *field;
+    tr_action_t *act;
+  } fields[] = {
+      {"host", data->host},
+      {"plugin", data->plugin},
+      {"plugin_instance", data->plugin_instance},
+      {"type_instance", data->type_instance},
+  };
+  int status = 0;
+
+  data->report = string_cache_report_create("target_replace");
+  if (data->report == NULL)
+    return -ENOMEM;
+
+  for (size_t i = 0; (i < STATIC_ARRAY_SIZE(fields)) && (status == 0); i++)
+    if (fields[i].act != NULL)
+      status = string_cache_report_add(data->report, fields[i].field,
+                                       fields[i].act->cache);
+
+  for (tr_meta_data_action_t *act = data->meta; (act != NULL) && (status == 0);
+       act = act->next)
+    status = string_cache_report_add(data->report, "meta_data", act->cache);
+
+  if (status == 0)
+    status = string_cache_report_register(data->report,
+                                          cf_get_default_interval());
+  if (status != 0)
+    ERROR("Target `replace': Reporting the cache statistics failed.");
+
+  return status;
+} /* }}} int tr_report_create */
+
 static int tr_destroy(void **user_data) /* {{{ */
 {
   tr_data_t *data;
@@ -434,6 +527,8 @@ static int tr_destroy(void **user_data) /* {{{ */
   if (data == NULL)
     return 0;
 
+  string_cache_report_destroy(data->report);
+
   tr_action_destroy(data->host);
   tr_action_destroy(data->plugin);
   tr_action_destroy(data->plugin_instance);
@@ -448,6 +543,7 @@ static int tr_destroy(void **user_data) /* {{{ */
 static int tr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
 {
   tr_data_t *data;
+  bool report_stats = false;
   int status;
 
   data = calloc(1, sizeof(*data));
@@ -491,6 +587,8 @@ static int tr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
     else if (strcasecmp("DeleteMetaData", child->key) == 0)
       status = tr_config_add_meta_action(&data->meta, child,
                                          /* should delete = */ true);
+    else if (strcasecmp("ReportStats", child->key) == 0)
+      status = cf_util_get_boolean(child, &report_stats);
     else {
       ERROR("Target `replace': The `%s' configuration option is not understood "
             "and will be ignored.",
@@ -516,6 +614,9 @@ static int tr_create(const oconfig_item_t *ci, void **user_data) /* {{{ */
     break;
   }
 
+  if ((status == 0) && report_stats)
+    status = tr_report_create(data);
+
   if (status != 0) {
     tr_destroy((void *)&data);
     return status;
@@ -589,6 +589,27 @@ c_avl_iterator_t *c_avl_get_iterator(c_avl_tree_t *t) {
   return iter;
 } /* c_avl_iterator_t *c_avl_get_iterator */
 
+c_avl_iterator_t *c_avl_get_iterator_after(c_avl_tree_t *t, const void *key) {
+  c_avl_iterator_t *iter;
+
+  iter = c_avl_get_iterator(t);
+  if (iter == NULL)
+    return NULL;
+
+  /* Position the iterator on the greatest node not greater than `key'. If
+   * there is no such node, the iteration starts with the smallest node. */
+  for (c_avl_node_t *n = t->root; n != NULL;) {
+    if (t->compare(key, n->key) >= 0) {
+      iter->node = n;
+      n = n->right;
+    } else {
+      n = n->left;
+    }
+  }
+
+  return iter;
+} /* c_avl_iterator_t *c_avl_get_iterator_after */
+
 int c_avl_iterator_next(c_avl_iterator_t *iter, void **key, void **value) {
   c_avl_node_t *n;
 
@@ -173,8 +173,49 @@ DEF_TEST(success) {
   return 0;
 }
 
+DEF_TEST(iterator_after) {
+  char *keys[] = {"b", "d", "f", "h", "j", "l", "n", "p", "r", "t"};
+  struct {
+    char *after;
+    char *want_first;
+    int want_num;
+  } cases[] = {
+      {"", "b", 10}, {"a", "b", 10}, {"b", "d", 9}, {"c", "d", 9},
+      {"m", "n", 4}, {"s", "t", 1},  {"t", NULL, 0}, {"z", NULL, 0},
+  };
+
+  c_avl_tree_t *t = c_avl_create(compare_callback);
+  OK(t != NULL);
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(keys); i++)
+    CHECK_ZERO(c_avl_insert(t, keys[i], keys[i]));
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    c_avl_iterator_t *iter = c_avl_get_iterator_after(t, cases[i].after);
+    OK(iter != NULL);
+
+    char *key = NULL;
+    char *value = NULL;
+    char *prev = cases[i].after;
+    int num = 0;
+    while (c_avl_iterator_next(iter, (void *)&key, (void *)&value) == 0) {
+      if (num == 0)
+        EXPECT_EQ_STR(cases[i].want_first, key);
+      OK(strcmp(prev, key) < 0);
+      prev = key;
+      num++;
+    }
+    c_avl_iterator_destroy(iter);
+    EXPECT_EQ_INT(cases[i].want_num, num);
+  }
+
+  c_avl_destroy(t);
+
+  return 0;
+}
+
 int main(void) {
   RUN_TEST(success);
+  RUN_TEST(iterator_after);
 
   END_TEST;
 }
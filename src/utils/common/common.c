@@ -31,6 +31,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 
 /* for getaddrinfo */
@@ -913,24 +914,27 @@ int format_values(char *ret, size_t ret_len, /* {{{ */
 
   memset(ret, 0, ret_len);
 
-#define BUFFER_ADD(...)                                                        \
+#define BUFFER_ADD(func, ...)                                                  \
   do {                                                                         \
-    status = snprintf(ret + offset, ret_len - offset, __VA_ARGS__);            \
-    if (status < 1) {                                                          \
-      sfree(rates);                                                            \
-      return -1;                                                               \
-    } else if (((size_t)status) >= (ret_len - offset)) {                       \
+    status = func(ret + offset, ret_len - offset, __VA_ARGS__);                \
+    if (((size_t)status) >= (ret_len - offset)) {                              \
       sfree(rates);                                                            \
       return -1;                                                               \
     } else                                                                     \
       offset += ((size_t)status);                                              \
   } while (0)
 
-  BUFFER_ADD("%.3f", CDTIME_T_TO_DOUBLE(vl->time));
+  BUFFER_ADD(serialize_fixed, CDTIME_T_TO_DOUBLE(vl->time), 3);
 
   for (size_t i = 0; i < ds->ds_num; i++) {
+    if ((ret_len - offset) < 2) {
+      sfree(rates);
+      return -1;
+    }
+    ret[offset++] = ':';
+
     if (ds->ds[i].type == DS_TYPE_GAUGE)
-      BUFFER_ADD(":" GAUGE_FORMAT, vl->values[i].gauge);
+      BUFFER_ADD(serialize_gauge, vl->values[i].gauge);
     else if (store_rates) {
       if (rates == NULL)
         rates = uc_get_rate(ds, vl);
@@ -938,13 +942,13 @@ int format_values(char *ret, size_t ret_len, /* {{{ */
         WARNING("format_values: uc_get_rate failed.");
         return -1;
       }
-      BUFFER_ADD(":" GAUGE_FORMAT, rates[i]);
+      BUFFER_ADD(serialize_gauge, rates[i]);
     } else if (ds->ds[i].type == DS_TYPE_COUNTER)
-      BUFFER_ADD(":%" PRIu64, (uint64_t)vl->values[i].counter);
+      BUFFER_ADD(serialize_uint64, (uint64_t)vl->values[i].counter);
     else if (ds->ds[i].type == DS_TYPE_DERIVE)
-      BUFFER_ADD(":%" PRIi64, vl->values[i].derive);
+      BUFFER_ADD(serialize_int64, vl->values[i].derive);
     else if (ds->ds[i].type == DS_TYPE_ABSOLUTE)
-      BUFFER_ADD(":%" PRIu64, vl->values[i].absolute);
+      BUFFER_ADD(serialize_uint64, vl->values[i].absolute);
     else {
       ERROR("format_values: Unknown data source type: %i", ds->ds[i].type);
       sfree(rates);
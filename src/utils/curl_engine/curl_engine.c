@@ -0,0 +1,444 @@
+/**
+ * collectd - src/utils/curl_engine/curl_engine.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "utils/common/common.h"
+#include "utils/curl_engine/curl_engine.h"
+
+#include <fcntl.h>
+
+#ifndef HAVE_CURL_MULTI_WAIT
+#include <sys/select.h>
+#endif
+
+/* Longest time the engine blocks without looking at cURL's timers. */
+#define CURL_ENGINE_WAIT_MS 1000
+
+typedef enum {
+  CE_PENDING,   /* submitted, not yet added to the multi handle */
+  CE_ACTIVE,    /* being transferred */
+  CE_CALLBACK,  /* completion callback is running */
+  CE_CANCELLED, /* to be removed from the multi handle by the engine */
+} curl_engine_state_t;
+
+struct curl_engine_request_s;
+typedef struct curl_engine_request_s curl_engine_request_t;
+struct curl_engine_request_s {
+  CURL *curl;
+  curl_engine_state_t state;
+
+  curl_write_callback write_cb;
+  void *write_data;
+  curl_engine_callback_t callback;
+  void *user_data;
+
+  /* Context of the submitting read callback. */
+  plugin_ctx_t ctx;
+
+  cdtime_t submitted;
+  /* Number of intervals skipped while the transfer was in progress. */
+  unsigned int skipped;
+
+  curl_engine_request_t *next;
+};
+
+/* All variables are protected by `engine_lock', except `engine_multi' which
+ * is only used by the engine's thread once the thread is running. */
+static pthread_mutex_t engine_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t engine_cond = PTHREAD_COND_INITIALIZER;
+static curl_engine_request_t *engine_requests;
+static CURLM *engine_multi;
+static pthread_t engine_thread;
+static bool engine_running;
+static bool engine_loop;
+static int engine_wakeup[2] = {-1, -1};
+static long engine_max_host_connections;
+
+/* Must hold engine_lock. */
+static curl_engine_request_t *curl_engine_lookup(CURL *curl) /* {{{ */
+{
+  for (curl_engine_request_t *req = engine_requests; req != NULL;
+       req = req->next)
+    if (req->curl == curl)
+      return req;
+  return NULL;
+} /* }}} curl_engine_request_t *curl_engine_lookup */
+
+/* Must hold engine_lock. Unlinks and frees `req' and wakes up threads waiting
+ * in `curl_engine_cancel'. */
+static void curl_engine_remove(curl_engine_request_t *req) /* {{{ */
+{
+  curl_engine_request_t **prev = &engine_requests;
+  while ((*prev != NULL) && (*prev != req))
+    prev = &(*prev)->next;
+  if (*prev != NULL)
+    *prev = req->next;
+
+  sfree(req);
+  pthread_cond_broadcast(&engine_cond);
+} /* }}} void curl_engine_remove */
+
+static void curl_engine_wake(void) /* {{{ */
+{
+  if ((write(engine_wakeup[1], "", 1) < 0) && (errno != EAGAIN))
+    ERROR("curl engine: Waking up the engine thread failed: %s", STRERRNO);
+} /* }}} void curl_engine_wake */
+
+static size_t curl_engine_write(char *buf, size_t size, /* {{{ */
+                                size_t nmemb, void *arg) {
+  curl_engine_request_t *req = arg;
+
+  if (req->write_cb == NULL)
+    return size * nmemb;
+
+  plugin_ctx_t old_ctx = plugin_set_ctx(req->ctx);
+  size_t ret = req->write_cb(buf, size, nmemb, req->write_data);
+  plugin_set_ctx(old_ctx);
+
+  return ret;
+} /* }}} size_t curl_engine_write */
+
+/* Calls the completion callback of a transfer that is no longer part of the
+ * multi handle. */
+static void curl_engine_complete(curl_engine_request_t *req, /* {{{ */
+                                 CURLcode status) {
+  pthread_mutex_lock(&engine_lock);
+  if (req->state == CE_CANCELLED) {
+    curl_engine_remove(req);
+    pthread_mutex_unlock(&engine_lock);
+    return;
+  }
+  req->state = CE_CALLBACK;
+  pthread_mutex_unlock(&engine_lock);
+
+  plugin_ctx_t old_ctx = plugin_set_ctx(req->ctx);
+  if (req->skipped > 0) {
+    char *url = NULL;
+    curl_easy_getinfo(req->curl, CURLINFO_EFFECTIVE_URL, &url);
+    NOTICE("curl engine: The transfer of `%s' finished after %.3f seconds, "
+           "%u interval(s) have been skipped.",
+           (url != NULL) ? url : "(unknown)",
+           CDTIME_T_TO_DOUBLE(cdtime() - req->submitted), req->skipped);
+  }
+  req->callback(req->curl, status, req->user_data);
+  plugin_set_ctx(old_ctx);
+
+  pthread_mutex_lock(&engine_lock);
+  curl_engine_remove(req);
+  pthread_mutex_unlock(&engine_lock);
+} /* }}} void curl_engine_complete */
+
+/* Adds submitted transfers to and removes cancelled transfers from the multi
+ * handle. */
+static void curl_engine_update(void) /* {{{ */
+{
+  curl_engine_request_t *failed = NULL;
+
+  pthread_mutex_lock(&engine_lock);
+  curl_engine_request_t *req = engine_requests;
+  while (req != NULL) {
+    curl_engine_request_t *next = req->next;
+
+    if (req->state == CE_CANCELLED) {
+      curl_multi_remove_handle(engine_multi, req->curl);
+      curl_engine_remove(req);
+    } else if ((req->state == CE_PENDING) && (failed == NULL)) {
+      CURLMcode status = curl_multi_add_handle(engine_multi, req->curl);
+      if (status == CURLM_OK) {
+        req->state = CE_ACTIVE;
+      } else {
+        ERROR("curl engine: curl_multi_add_handle failed: %s",
+              curl_multi_strerror(status));
+        req->state = CE_ACTIVE;
+        failed = req;
+      }
+    }
+
+    req = next;
+  }
+  pthread_mutex_unlock(&engine_lock);
+
+  if (failed != NULL)
+    curl_engine_complete(failed, CURLE_FAILED_INIT);
+} /* }}} void curl_engine_update */
+
+static void curl_engine_wait(void) /* {{{ */
+{
+#ifdef HAVE_CURL_MULTI_WAIT
+  struct curl_waitfd wfd = {
+      .fd = engine_wakeup[0],
+      .events = CURL_WAIT_POLLIN,
+  };
+  CURLMcode status = curl_multi_wait(engine_multi, &wfd, 1, CURL_ENGINE_WAIT_MS,
+                                     /* numfds = */ NULL);
+  if (status != CURLM_OK) {
+    ERROR("curl engine: curl_multi_wait failed: %s",
+          curl_multi_strerror(status));
+    sleep(1);
+  }
+#else
+  fd_set fds_read, fds_write, fds_exc;
+  int max_fd = -1;
+  long timeout_ms = -1;
+
+  FD_ZERO(&fds_read);
+  FD_ZERO(&fds_write);
+  FD_ZERO(&fds_exc);
+  curl_multi_fdset(engine_multi, &fds_read, &fds_write, &fds_exc, &max_fd);
+  FD_SET(engine_wakeup[0], &fds_read);
+  if (engine_wakeup[0] > max_fd)
+    max_fd = engine_wakeup[0];
+
+  curl_multi_timeout(engine_multi, &timeout_ms);
+  if ((timeout_ms < 0) || (timeout_ms > CURL_ENGINE_WAIT_MS))
+    timeout_ms = CURL_ENGINE_WAIT_MS;
+
+  struct timeval tv = {
+      .tv_sec = timeout_ms / 1000,
+      .tv_usec = (timeout_ms % 1000) * 1000,
+  };
+  if ((select(max_fd + 1, &fds_read, &fds_write, &fds_exc, &tv) < 0) &&
+      (errno != EINTR)) {
+    ERROR("curl engine: select failed: %s", STRERRNO);
+    sleep(1);
+  }
+#endif
+
+  char buffer[64];
+  while (read(engine_wakeup[0], buffer, sizeof(buffer)) > 0)
+    /* drain */;
+} /* }}} void curl_engine_wait */
+
+static void *curl_engine_thread(void __attribute__((unused)) * arg) /* {{{ */
+{
+  pthread_mutex_lock(&engine_lock);
+  while (engine_loop) {
+    pthread_mutex_unlock(&engine_lock);
+
+    curl_engine_update();
+
+    int running = 0;
+    curl_multi_perform(engine_multi, &running);
+
+    CURLMsg *msg;
+    int msgs_left;
+    while ((msg = curl_multi_info_read(engine_multi, &msgs_left)) != NULL) {
+      if (msg->msg != CURLMSG_DONE)
+        continue;
+
+      /* `msg' is invalidated by curl_multi_remove_handle. */
+      CURL *curl = msg->easy_handle;
+      CURLcode status = msg->data.result;
+      curl_engine_request_t *req = NULL;
+
+      curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&req);
+      curl_multi_remove_handle(engine_multi, curl);
+      if (req != NULL)
+        curl_engine_complete(req, status);
+    }
+
+    curl_engine_wait();
+
+    pthread_mutex_lock(&engine_lock);
+  }
+  pthread_mutex_unlock(&engine_lock);
+
+  return NULL;
+} /* }}} void *curl_engine_thread */
+
+/* Must hold engine_lock. */
+static int curl_engine_start(void) /* {{{ */
+{
+  engine_multi = curl_multi_init();
+  if (engine_multi == NULL) {
+    ERROR("curl engine: curl_multi_init failed.");
+    return -1;
+  }
+
+#ifdef HAVE_CURLMOPT_MAX_HOST_CONNECTIONS
+  if (engine_max_host_connections > 0)
+    curl_multi_setopt(engine_multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      engine_max_host_connections);
+#else
+  if (engine_max_host_connections > 0)
+    WARNING("curl engine: This version of libcurl cannot limit the number of "
+            "connections per host.");
+#endif
+
+  if (pipe(engine_wakeup) != 0) {
+    ERROR("curl engine: pipe failed: %s", STRERRNO);
+    curl_multi_cleanup(engine_multi);
+    engine_multi = NULL;
+    return -1;
+  }
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(engine_wakeup); i++)
+    fcntl(engine_wakeup[i], F_SETFL,
+          fcntl(engine_wakeup[i], F_GETFL) | O_NONBLOCK);
+
+  engine_loop = true;
+  int status = plugin_thread_create(&engine_thread, curl_engine_thread,
+                                    /* arg = */ NULL, "curl engine");
+  if (status != 0) {
+    ERROR("curl engine: plugin_thread_create failed: %s", STRERROR(status));
+    engine_loop = false;
+    close(engine_wakeup[0]);
+    close(engine_wakeup[1]);
+    engine_wakeup[0] = engine_wakeup[1] = -1;
+    curl_multi_cleanup(engine_multi);
+    engine_multi = NULL;
+    return -1;
+  }
+
+  engine_running = true;
+  return 0;
+} /* }}} int curl_engine_start */
+
+void curl_engine_set_max_host_connections(long num) /* {{{ */
+{
+  pthread_mutex_lock(&engine_lock);
+  engine_max_host_connections = num;
+  pthread_mutex_unlock(&engine_lock);
+} /* }}} void curl_engine_set_max_host_connections */
+
+int curl_engine_submit(CURL *curl, curl_write_callback write_cb, /* {{{ */
+                       void *write_data, curl_engine_callback_t callback,
+                       void *user_data) {
+  if ((curl == NULL) || (callback == NULL))
+    return EINVAL;
+
+  pthread_mutex_lock(&engine_lock);
+
+  if (curl_engine_lookup(curl) != NULL) {
+    pthread_mutex_unlock(&engine_lock);
+    return EBUSY;
+  }
+
+  if (!engine_running && (curl_engine_start() != 0)) {
+    pthread_mutex_unlock(&engine_lock);
+    return ENOMEM;
+  }
+
+  curl_engine_request_t *req = calloc(1, sizeof(*req));
+  if (req == NULL) {
+    pthread_mutex_unlock(&engine_lock);
+    ERROR("curl engine: calloc failed.");
+    return ENOMEM;
+  }
+
+  req->curl = curl;
+  req->state = CE_PENDING;
+  req->write_cb = write_cb;
+  req->write_data = write_data;
+  req->callback = callback;
+  req->user_data = user_data;
+  req->ctx = plugin_get_ctx();
+  req->submitted = cdtime();
+
+  curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)req);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_engine_write);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)req);
+
+  req->next = engine_requests;
+  engine_requests = req;
+
+  curl_engine_wake();
+  pthread_mutex_unlock(&engine_lock);
+
+  return 0;
+} /* }}} int curl_engine_submit */
+
+bool curl_engine_in_progress(CURL *curl) /* {{{ */
+{
+  pthread_mutex_lock(&engine_lock);
+  bool ret = (curl_engine_lookup(curl) != NULL);
+  pthread_mutex_unlock(&engine_lock);
+  return ret;
+} /* }}} bool curl_engine_in_progress */
+
+unsigned int curl_engine_skip(CURL *curl, cdtime_t *submitted) /* {{{ */
+{
+  unsigned int skipped = 0;
+
+  pthread_mutex_lock(&engine_lock);
+  curl_engine_request_t *req = curl_engine_lookup(curl);
+  if (req != NULL) {
+    skipped = ++req->skipped;
+    if (submitted != NULL)
+      *submitted = req->submitted;
+  }
+  pthread_mutex_unlock(&engine_lock);
+
+  return skipped;
+} /* }}} unsigned int curl_engine_skip */
+
+void curl_engine_cancel(CURL *curl) /* {{{ */
+{
+  pthread_mutex_lock(&engine_lock);
+
+  curl_engine_request_t *req = curl_engine_lookup(curl);
+  if ((req != NULL) && (req->state == CE_PENDING)) {
+    curl_engine_remove(req);
+    req = NULL;
+  } else if ((req != NULL) && (req->state == CE_ACTIVE)) {
+    req->state = CE_CANCELLED;
+    curl_engine_wake();
+  }
+
+  while ((req != NULL) && (curl_engine_lookup(curl) != NULL))
+    pthread_cond_wait(&engine_cond, &engine_lock);
+
+  pthread_mutex_unlock(&engine_lock);
+} /* }}} void curl_engine_cancel */
+
+void curl_engine_shutdown(void) /* {{{ */
+{
+  pthread_mutex_lock(&engine_lock);
+  if (!engine_running) {
+    pthread_mutex_unlock(&engine_lock);
+    return;
+  }
+  engine_loop = false;
+  curl_engine_wake();
+  pthread_mutex_unlock(&engine_lock);
+
+  pthread_join(engine_thread, /* retval = */ NULL);
+
+  pthread_mutex_lock(&engine_lock);
+  while (engine_requests != NULL) {
+    curl_engine_request_t *req = engine_requests;
+    WARNING("curl engine: Aborting a transfer that is still in progress.");
+    curl_multi_remove_handle(engine_multi, req->curl);
+    curl_engine_remove(req);
+  }
+
+  curl_multi_cleanup(engine_multi);
+  engine_multi = NULL;
+
+  close(engine_wakeup[0]);
+  close(engine_wakeup[1]);
+  engine_wakeup[0] = engine_wakeup[1] = -1;
+
+  engine_running = false;
+  pthread_mutex_unlock(&engine_lock);
+} /* }}} void curl_engine_shutdown */
@@ -0,0 +1,108 @@
+/**
+ * collectd - src/utils/curl_engine/curl_engine.h
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef UTILS_CURL_ENGINE_H
+#define UTILS_CURL_ENGINE_H 1
+
+#include "plugin.h"
+
+#include <curl/curl.h>
+
+/*
+ * The cURL engine runs transfers of many easy handles in a single thread using
+ * the cURL "multi" interface. Read callbacks submit a prepared easy handle and
+ * return immediately; the response is handled in the engine's thread. All
+ * handles share the multi handle's connection cache, so connections to the
+ * same host are kept alive and reused across intervals.
+ *
+ * The engine is part of the daemon, so that there is only one instance that is
+ * shared by all plugins using it. Plugins must not link it themselves.
+ *
+ * Write and completion callbacks are called in the engine's thread with the
+ * plugin context of the read callback that submitted the transfer, so
+ * `plugin_get_interval' and logging behave as they would in the read
+ * callback.
+ */
+
+/*
+ * curl_engine_callback_t is called once a transfer has finished. `status' is
+ * the result of the transfer as it would have been returned by
+ * `curl_easy_perform'.
+ */
+typedef void (*curl_engine_callback_t)(CURL *curl, CURLcode status,
+                                       void *user_data);
+
+/*
+ * curl_engine_set_max_host_connections limits the number of concurrent
+ * connections to a single host for all plugins. Zero, the default, means no
+ * limit. Must be called before the first transfer is submitted, i.e. from a
+ * config or init callback.
+ */
+void curl_engine_set_max_host_connections(long num);
+
+/*
+ * curl_engine_submit starts a transfer of `curl'. The engine installs its own
+ * write function on the handle that calls `write_cb' with `write_data'; other
+ * options must have been set by the caller. `callback' is called with
+ * `user_data' once the transfer has finished. The handle must not be used or
+ * freed until then, or until `curl_engine_cancel' returns.
+ *
+ * Returns zero on success, EBUSY if `curl' is still being transferred and
+ * another errno value on failure.
+ */
+int curl_engine_submit(CURL *curl, curl_write_callback write_cb,
+                       void *write_data, curl_engine_callback_t callback,
+                       void *user_data);
+
+/*
+ * curl_engine_in_progress returns true if `curl' has been submitted and its
+ * completion callback has not returned yet.
+ */
+bool curl_engine_in_progress(CURL *curl);
+
+/*
+ * curl_engine_skip is called by read callbacks before they submit `curl'. If
+ * the previous transfer of `curl' is still in progress, this counts as one
+ * skipped interval and the number of intervals skipped so far is returned;
+ * the time the transfer was submitted is stored in `submitted' unless it is
+ * NULL. Otherwise, zero is returned and the handle may be submitted. When a
+ * transfer that caused skipped intervals finishes, the engine logs a notice.
+ */
+unsigned int curl_engine_skip(CURL *curl, cdtime_t *submitted);
+
+/*
+ * curl_engine_cancel aborts the transfer of `curl', if any. The completion
+ * callback is not called for an aborted transfer. When this function returns,
+ * the engine no longer references `curl' or its callback data, so both may
+ * be freed. Must not be called from a write or completion callback.
+ */
+void curl_engine_cancel(CURL *curl);
+
+/*
+ * curl_engine_shutdown stops the engine's thread and frees its resources. All
+ * transfers must have finished or been cancelled. Called by the daemon after
+ * the shutdown callbacks of all plugins have returned.
+ */
+void curl_engine_shutdown(void);
+
+#endif /* UTILS_CURL_ENGINE_H */
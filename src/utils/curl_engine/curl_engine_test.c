@@ -0,0 +1,255 @@
+/**
+ * collectd - src/utils/curl_engine/curl_engine_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+/* plugin_thread_create() is not available in the test. */
+#define plugin_thread_create curl_engine_test_thread_create
+
+/* Included first, so that utils_time.h declares cdtime_mock. */
+#include "testing.h"
+
+#include "curl_engine.c" /* sic */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+int curl_engine_test_thread_create(pthread_t *thread, void *(*start)(void *),
+                                   void *arg,
+                                   __attribute__((unused)) char const *name) {
+  return pthread_create(thread, /* attr = */ NULL, start, arg);
+}
+
+static pthread_mutex_t test_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool test_done;
+static CURLcode test_status;
+static cdtime_t test_interval;
+static char test_data[256];
+
+static size_t test_write(char *buf, size_t size, size_t nmemb, /* {{{ */
+                         __attribute__((unused)) void *arg) {
+  size_t len = size * nmemb;
+
+  pthread_mutex_lock(&test_lock);
+  size_t fill = strlen(test_data);
+  if (fill + len >= sizeof(test_data))
+    len = sizeof(test_data) - fill - 1;
+  memcpy(test_data + fill, buf, len);
+  test_data[fill + len] = 0;
+  pthread_mutex_unlock(&test_lock);
+
+  return size * nmemb;
+} /* }}} size_t test_write */
+
+static void test_callback(__attribute__((unused)) CURL *curl, /* {{{ */
+                          CURLcode status,
+                          __attribute__((unused)) void *user_data) {
+  pthread_mutex_lock(&test_lock);
+  test_done = true;
+  test_status = status;
+  test_interval = plugin_get_interval();
+  pthread_mutex_unlock(&test_lock);
+} /* }}} void test_callback */
+
+static void test_reset(void) /* {{{ */
+{
+  pthread_mutex_lock(&test_lock);
+  test_done = false;
+  test_status = CURLE_OK;
+  test_interval = 0;
+  test_data[0] = 0;
+  pthread_mutex_unlock(&test_lock);
+} /* }}} void test_reset */
+
+/* Waits up to five seconds for the completion callback. */
+static bool test_wait(void) /* {{{ */
+{
+  for (int i = 0; i < 250; i++) {
+    pthread_mutex_lock(&test_lock);
+    bool done = test_done;
+    pthread_mutex_unlock(&test_lock);
+    if (done)
+      return true;
+    usleep(20000);
+  }
+  return false;
+} /* }}} bool test_wait */
+
+/* Listens on a random port of the loopback interface. Connections are
+ * accepted by the kernel, but nothing is sent until the test does so. */
+static int test_listen(char *url, size_t url_size) /* {{{ */
+{
+  struct sockaddr_in sa = {
+      .sin_family = AF_INET,
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  socklen_t sa_len = sizeof(sa);
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  if ((bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) ||
+      (listen(fd, 4) != 0) ||
+      (getsockname(fd, (struct sockaddr *)&sa, &sa_len) != 0)) {
+    close(fd);
+    return -1;
+  }
+
+  snprintf(url, url_size, "http://127.0.0.1:%d/", (int)ntohs(sa.sin_port));
+  return fd;
+} /* }}} int test_listen */
+
+static CURL *test_curl(char const *url) /* {{{ */
+{
+  CURL *curl = curl_easy_init();
+  if (curl == NULL)
+    return NULL;
+
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_URL, url);
+  return curl;
+} /* }}} CURL *test_curl */
+
+DEF_TEST(transfer) {
+  char path[] = "/tmp/curl_engine_test.XXXXXX";
+  char url[sizeof(path) + 16];
+  char const content[] = "Hello, engine!";
+
+  int fd = mkstemp(path);
+  OK(fd >= 0);
+  EXPECT_EQ_INT(sizeof(content) - 1, write(fd, content, sizeof(content) - 1));
+  close(fd);
+  snprintf(url, sizeof(url), "file://%s", path);
+
+  CURL *curl;
+  CHECK_NOT_NULL(curl = test_curl(url));
+  test_reset();
+
+  /* Callbacks are called with the context of the submitting read callback. */
+  plugin_ctx_t ctx = {.interval = TIME_T_TO_CDTIME_T(7)};
+  plugin_ctx_t old_ctx = plugin_set_ctx(ctx);
+  CHECK_ZERO(curl_engine_submit(curl, test_write, NULL, test_callback, NULL));
+  plugin_set_ctx(old_ctx);
+
+  OK(test_wait());
+  EXPECT_EQ_INT(CURLE_OK, test_status);
+  EXPECT_EQ_STR(content, test_data);
+  EXPECT_EQ_UINT64(TIME_T_TO_CDTIME_T(7), test_interval);
+
+  /* The request is removed after the callback has returned. */
+  for (int i = 0; (i < 100) && curl_engine_in_progress(curl); i++)
+    usleep(10000);
+  OK(!curl_engine_in_progress(curl));
+  EXPECT_EQ_INT(0, curl_engine_skip(curl, NULL));
+
+  curl_easy_cleanup(curl);
+  unlink(path);
+  return 0;
+}
+
+DEF_TEST(skip) {
+  char url[64];
+  int listen_fd = test_listen(url, sizeof(url));
+  OK(listen_fd >= 0);
+
+  CURL *curl;
+  CHECK_NOT_NULL(curl = test_curl(url));
+  test_reset();
+
+  cdtime_mock = TIME_T_TO_CDTIME_T(1500000000);
+  CHECK_ZERO(curl_engine_submit(curl, test_write, NULL, test_callback, NULL));
+  EXPECT_EQ_INT(EBUSY, curl_engine_submit(curl, test_write, NULL,
+                                          test_callback, NULL));
+
+  int fd = accept(listen_fd, NULL, NULL);
+  OK(fd >= 0);
+
+  /* Every call while the transfer is in progress counts as one skipped
+   * interval. */
+  cdtime_t submitted = 0;
+  cdtime_mock += TIME_T_TO_CDTIME_T(10);
+  EXPECT_EQ_INT(1, curl_engine_skip(curl, &submitted));
+  EXPECT_EQ_UINT64(TIME_T_TO_CDTIME_T(1500000000), submitted);
+  cdtime_mock += TIME_T_TO_CDTIME_T(10);
+  EXPECT_EQ_INT(2, curl_engine_skip(curl, NULL));
+  OK(!test_done);
+
+  /* The late response is still handled, and the skipped intervals are
+   * logged. */
+  char const response[] = "HTTP/1.0 200 OK\r\n"
+                          "Content-Length: 4\r\n"
+                          "\r\n"
+                          "late";
+  EXPECT_EQ_INT(sizeof(response) - 1,
+                write(fd, response, sizeof(response) - 1));
+  close(fd);
+
+  OK(test_wait());
+  EXPECT_EQ_INT(CURLE_OK, test_status);
+  EXPECT_EQ_STR("late", test_data);
+
+  curl_easy_cleanup(curl);
+  close(listen_fd);
+  return 0;
+}
+
+DEF_TEST(cancel) {
+  char url[64];
+  int listen_fd = test_listen(url, sizeof(url));
+  OK(listen_fd >= 0);
+
+  CURL *curl;
+  CHECK_NOT_NULL(curl = test_curl(url));
+  test_reset();
+
+  CHECK_ZERO(curl_engine_submit(curl, test_write, NULL, test_callback, NULL));
+  int fd = accept(listen_fd, NULL, NULL);
+  OK(fd >= 0);
+  OK(curl_engine_in_progress(curl));
+
+  /* The request is never answered. Once cancelled, the handle is no longer
+   * referenced and the callback is not called. */
+  curl_engine_cancel(curl);
+  OK(!curl_engine_in_progress(curl));
+  EXPECT_EQ_INT(0, curl_engine_skip(curl, NULL));
+  usleep(100000);
+  OK(!test_done);
+
+  curl_easy_cleanup(curl);
+  close(fd);
+  close(listen_fd);
+  return 0;
+}
+
+int main(void) {
+  curl_global_init(CURL_GLOBAL_ALL);
+
+  RUN_TEST(transfer);
+  RUN_TEST(skip);
+  RUN_TEST(cancel);
+
+  curl_engine_shutdown();
+  OK(!engine_running);
+
+  curl_global_cleanup();
+  END_TEST;
+}
@@ -27,6 +27,7 @@
 #include "utils/common/common.h"
 
 #include "utils/format_graphite/format_graphite.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 
 #define GRAPHITE_FORBIDDEN " \t\"\\:!,/()\n\r"
@@ -73,27 +74,25 @@ static int gr_format_values(char *ret, size_t ret_len, int ds_num,
 
   memset(ret, 0, ret_len);
 
-#define BUFFER_ADD(...)                                                        \
+#define BUFFER_ADD(func, ...)                                                  \
   do {                                                                         \
-    status = snprintf(ret + offset, ret_len - offset, __VA_ARGS__);            \
-    if (status < 1) {                                                          \
-      return -1;                                                               \
-    } else if (((size_t)status) >= (ret_len - offset)) {                       \
+    status = func(ret + offset, ret_len - offset, __VA_ARGS__);                \
+    if (((size_t)status) >= (ret_len - offset)) {                              \
       return -1;                                                               \
     } else                                                                     \
       offset += ((size_t)status);                                              \
   } while (0)
 
   if (ds->ds[ds_num].type == DS_TYPE_GAUGE)
-    BUFFER_ADD(GAUGE_FORMAT, vl->values[ds_num].gauge);
+    BUFFER_ADD(serialize_gauge, vl->values[ds_num].gauge);
   else if (rates != NULL)
-    BUFFER_ADD("%f", rates[ds_num]);
+    BUFFER_ADD(serialize_fixed, rates[ds_num], 6);
   else if (ds->ds[ds_num].type == DS_TYPE_COUNTER)
-    BUFFER_ADD("%" PRIu64, (uint64_t)vl->values[ds_num].counter);
+    BUFFER_ADD(serialize_uint64, (uint64_t)vl->values[ds_num].counter);
   else if (ds->ds[ds_num].type == DS_TYPE_DERIVE)
-    BUFFER_ADD("%" PRIi64, vl->values[ds_num].derive);
+    BUFFER_ADD(serialize_int64, vl->values[ds_num].derive);
   else if (ds->ds[ds_num].type == DS_TYPE_ABSOLUTE)
-    BUFFER_ADD("%" PRIu64, vl->values[ds_num].absolute);
+    BUFFER_ADD(serialize_uint64, vl->values[ds_num].absolute);
   else {
     P_ERROR("gr_format_values: Unknown data source type: %i",
             ds->ds[ds_num].type);
@@ -107,22 +106,26 @@ static int gr_format_values(char *ret, size_t ret_len, int ds_num,
 
 static void gr_copy_escape_part(char *dst, const char *src, size_t dst_len,
                                 char escape_char, bool preserve_separator) {
+  /* Whitespace and control characters, as tested by isspace(3) and
+   * iscntrl(3) in the "C" locale. */
+  static serialize_charset_t const special = {.below = 0x21, .chars = "\x7f"};
+  static serialize_charset_t const special_dot = {.below = 0x21,
+                                                  .chars = "\x7f."};
+  serialize_charset_t const *set =
+      preserve_separator ? &special : &special_dot;
+
   memset(dst, 0, dst_len);
 
   if (src == NULL)
     return;
 
-  for (size_t i = 0; i < dst_len; i++) {
-    if (src[i] == 0) {
-      dst[i] = 0;
-      break;
-    }
+  size_t len = strnlen(src, dst_len);
+  memcpy(dst, src, len);
 
-    if ((!preserve_separator && (src[i] == '.')) || isspace((int)src[i]) ||
-        iscntrl((int)src[i]))
+  for (size_t i = 0; i < len; i++) {
+    i += serialize_span(dst + i, len - i, set);
+    if (i < len)
       dst[i] = escape_char;
-    else
-      dst[i] = src[i];
   }
 }
 
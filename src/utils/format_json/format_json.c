@@ -29,7 +29,9 @@
 #include "utils/format_json/format_json.h"
 
 #include "plugin.h"
+#include "utils/avltree/avltree.h"
 #include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 
 #if HAVE_LIBYAJL
@@ -45,7 +47,13 @@
 
 static int json_escape_string(char *buffer, size_t buffer_size, /* {{{ */
                               const char *string) {
+  /* Control characters are compared as `char', i.e. bytes with the most
+   * significant bit set are replaced, too, if `char' is signed. */
+  static serialize_charset_t const special = {
+      .below = 0x20, .high = (CHAR_MIN < 0), .chars = "\"\\"};
   size_t dst_pos;
+  size_t src_len;
+  size_t src_pos;
 
   if ((buffer == NULL) || (string == NULL))
     return -EINVAL;
@@ -54,6 +62,8 @@ static int json_escape_string(char *buffer, size_t buffer_size, /* {{{ */
     return -ENOMEM;
 
   dst_pos = 0;
+  src_len = strlen(string);
+  src_pos = 0;
 
 #define BUFFER_ADD(c)                                                          \
   do {                                                                         \
@@ -65,17 +75,29 @@ static int json_escape_string(char *buffer, size_t buffer_size, /* {{{ */
     dst_pos++;                                                                 \
   } while (0)
 
-  /* Escape special characters */
+  /* Escape special characters, copying everything in between as a whole. */
   BUFFER_ADD('"');
-  for (size_t src_pos = 0; string[src_pos] != 0; src_pos++) {
+  while (src_pos < src_len) {
+    size_t n = serialize_span(string + src_pos, src_len - src_pos, &special);
+    if (n > 0) {
+      if (n > (buffer_size - 1) - dst_pos) {
+        buffer[buffer_size - 1] = '\0';
+        return -ENOMEM;
+      }
+      memcpy(buffer + dst_pos, string + src_pos, n);
+      dst_pos += n;
+      src_pos += n;
+      if (src_pos == src_len)
+        break;
+    }
+
     if ((string[src_pos] == '"') || (string[src_pos] == '\\')) {
       BUFFER_ADD('\\');
       BUFFER_ADD(string[src_pos]);
-    } else if (string[src_pos] <= 0x001F)
+    } else
       BUFFER_ADD('?');
-    else
-      BUFFER_ADD(string[src_pos]);
-  } /* for */
+    src_pos++;
+  }
   BUFFER_ADD('"');
   buffer[dst_pos] = 0;
 
@@ -106,6 +128,17 @@ static int values_to_json(char *buffer, size_t buffer_size, /* {{{ */
       offset += ((size_t)status);                                              \
   } while (0)
 
+#define BUFFER_ADD_VALUE(func, value)                                          \
+  do {                                                                         \
+    int status;                                                                \
+    status = func(buffer + offset, buffer_size - offset, (value));             \
+    if (((size_t)status) >= (buffer_size - offset)) {                          \
+      sfree(rates);                                                            \
+      return -ENOMEM;                                                          \
+    } else                                                                     \
+      offset += ((size_t)status);                                              \
+  } while (0)
+
   BUFFER_ADD("[");
   for (size_t i = 0; i < ds->ds_num; i++) {
     if (i > 0)
@@ -113,7 +146,7 @@ static int values_to_json(char *buffer, size_t buffer_size, /* {{{ */
 
     if (ds->ds[i].type == DS_TYPE_GAUGE) {
       if (isfinite(vl->values[i].gauge))
-        BUFFER_ADD(JSON_GAUGE_FORMAT, vl->values[i].gauge);
+        BUFFER_ADD_VALUE(serialize_gauge, vl->values[i].gauge);
       else
         BUFFER_ADD("null");
     } else if (store_rates) {
@@ -126,15 +159,15 @@ static int values_to_json(char *buffer, size_t buffer_size, /* {{{ */
       }
 
       if (isfinite(rates[i]))
-        BUFFER_ADD(JSON_GAUGE_FORMAT, rates[i]);
+        BUFFER_ADD_VALUE(serialize_gauge, rates[i]);
       else
         BUFFER_ADD("null");
     } else if (ds->ds[i].type == DS_TYPE_COUNTER)
-      BUFFER_ADD("%" PRIu64, (uint64_t)vl->values[i].counter);
+      BUFFER_ADD_VALUE(serialize_uint64, (uint64_t)vl->values[i].counter);
     else if (ds->ds[i].type == DS_TYPE_DERIVE)
-      BUFFER_ADD("%" PRIi64, vl->values[i].derive);
+      BUFFER_ADD_VALUE(serialize_int64, vl->values[i].derive);
     else if (ds->ds[i].type == DS_TYPE_ABSOLUTE)
-      BUFFER_ADD("%" PRIu64, vl->values[i].absolute);
+      BUFFER_ADD_VALUE(serialize_uint64, vl->values[i].absolute);
     else {
       ERROR("format_json: Unknown data source type: %i", ds->ds[i].type);
       sfree(rates);
@@ -143,6 +176,7 @@ static int values_to_json(char *buffer, size_t buffer_size, /* {{{ */
   } /* for ds->ds_num */
   BUFFER_ADD("]");
 
+#undef BUFFER_ADD_VALUE
 #undef BUFFER_ADD
 
   sfree(rates);
@@ -341,8 +375,10 @@ static int value_list_to_json(char *buffer, size_t buffer_size, /* {{{ */
     return status;
   BUFFER_ADD(",\"dsnames\":%s", temp);
 
-  BUFFER_ADD(",\"time\":%.3f", CDTIME_T_TO_DOUBLE(vl->time));
-  BUFFER_ADD(",\"interval\":%.3f", CDTIME_T_TO_DOUBLE(vl->interval));
+  serialize_fixed(temp, sizeof(temp), CDTIME_T_TO_DOUBLE(vl->time), 3);
+  BUFFER_ADD(",\"time\":%s", temp);
+  serialize_fixed(temp, sizeof(temp), CDTIME_T_TO_DOUBLE(vl->interval), 3);
+  BUFFER_ADD(",\"interval\":%s", temp);
 
 #define BUFFER_ADD_KEYVAL(key, value)                                          \
   do {                                                                         \
@@ -465,6 +501,426 @@ int format_json_value_list(char *buffer, /* {{{ */
                                         (*ret_buffer_free) - 2);
 } /* }}} int format_json_value_list */
 
+/*
+ * Batches
+ *
+ * A batch holds the JSON array of many value lists in a single growing
+ * buffer. The parts of a value list's JSON object that only depend on the
+ * identifier and the data set are formatted once per series and are copied
+ * from the cache on subsequent calls. A series is dropped from the cache once
+ * no value list has been added for twice its interval, independent of how
+ * often the batch is sent.
+ */
+#define FORMAT_JSON_BATCH_INITIAL_SIZE 4096
+/* Upper bound for the space reserved for the meta data of one value list. */
+#define FORMAT_JSON_META_MAX 65536
+
+typedef struct {
+  /* ,"dstypes":[...],"dsnames":[...] */
+  const data_set_t *ds;
+  char *ds_json;
+  size_t ds_json_len;
+
+  /* ,"host":"...",...,"type_instance":"..." */
+  char *id_json;
+  size_t id_json_len;
+
+  cdtime_t expires;
+} format_json_series_t;
+
+struct format_json_batch_s {
+  char *buffer;
+  size_t size;
+  size_t fill;
+
+  /* identifier -> format_json_series_t */
+  c_avl_tree_t *series;
+  /* Time of the last reset. */
+  cdtime_t now;
+  /* No series expires before this time. */
+  cdtime_t next_expire;
+};
+
+static void format_json_series_free(format_json_series_t *s) /* {{{ */
+{
+  if (s == NULL)
+    return;
+
+  sfree(s->ds_json);
+  sfree(s->id_json);
+  sfree(s);
+} /* }}} void format_json_series_free */
+
+static int format_json_series_set_ds(format_json_series_t *s, /* {{{ */
+                                     const data_set_t *ds) {
+  /* Longest type name ("absolute") and data source name, plus quotes and
+   * separators. */
+  size_t temp_size = ds->ds_num * (DATA_MAX_NAME_LEN + 4) + 3;
+  char *temp = malloc(temp_size);
+  char *ds_json = malloc(2 * temp_size + 32);
+  int status;
+
+  if ((temp == NULL) || (ds_json == NULL)) {
+    sfree(temp);
+    sfree(ds_json);
+    return -ENOMEM;
+  }
+
+  status = dstypes_to_json(temp, temp_size, ds);
+  if (status == 0) {
+    strcpy(ds_json, ",\"dstypes\":");
+    strcat(ds_json, temp);
+    status = dsnames_to_json(temp, temp_size, ds);
+  }
+  if (status == 0) {
+    strcat(ds_json, ",\"dsnames\":");
+    strcat(ds_json, temp);
+  }
+  sfree(temp);
+  if (status != 0) {
+    sfree(ds_json);
+    return status;
+  }
+
+  sfree(s->ds_json);
+  s->ds = ds;
+  s->ds_json = ds_json;
+  s->ds_json_len = strlen(ds_json);
+  return 0;
+} /* }}} int format_json_series_set_ds */
+
+static int format_json_series_set_id(format_json_series_t *s, /* {{{ */
+                                     const value_list_t *vl) {
+  struct {
+    char const *key;
+    char const *value;
+  } fields[] = {
+      {"host", vl->host},
+      {"plugin", vl->plugin},
+      {"plugin_instance", vl->plugin_instance},
+      {"type", vl->type},
+      {"type_instance", vl->type_instance},
+  };
+  /* Every byte is escaped with at most two bytes. */
+  char id_json[STATIC_ARRAY_SIZE(fields) * (2 * DATA_MAX_NAME_LEN + 24)];
+  size_t offset = 0;
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(fields); i++) {
+    char temp[2 * DATA_MAX_NAME_LEN + 3];
+    int status = json_escape_string(temp, sizeof(temp), fields[i].value);
+    if (status != 0)
+      return status;
+
+    status = snprintf(id_json + offset, sizeof(id_json) - offset, ",\"%s\":%s",
+                      fields[i].key, temp);
+    if ((status < 1) || ((size_t)status >= sizeof(id_json) - offset))
+      return -ENOMEM;
+    offset += (size_t)status;
+  }
+
+  s->id_json = strdup(id_json);
+  if (s->id_json == NULL)
+    return -ENOMEM;
+  s->id_json_len = offset;
+  return 0;
+} /* }}} int format_json_series_set_id */
+
+static format_json_series_t * /* {{{ */
+format_json_batch_series(format_json_batch_t *batch, const data_set_t *ds,
+                         const value_list_t *vl) {
+  char identifier[6 * DATA_MAX_NAME_LEN];
+  format_json_series_t *s = NULL;
+
+  /* The batch may not have been reset for a while, so the value list's time
+   * is used if it is more recent. */
+  cdtime_t interval = (vl->interval > 0) ? vl->interval : plugin_get_interval();
+  cdtime_t expires = ((vl->time > batch->now) ? vl->time : batch->now) +
+                     2 * interval;
+
+  if (FORMAT_VL(identifier, sizeof(identifier), vl) != 0)
+    return NULL;
+
+  if (c_avl_get(batch->series, identifier, (void *)&s) == 0) {
+    /* The data set is only different if the type has been redefined. */
+    if ((s->ds != ds) && (format_json_series_set_ds(s, ds) != 0))
+      return NULL;
+    s->expires = expires;
+    return s;
+  }
+
+  s = calloc(1, sizeof(*s));
+  char *key = strdup(identifier);
+  if ((s == NULL) || (key == NULL) || (format_json_series_set_ds(s, ds) != 0) ||
+      (format_json_series_set_id(s, vl) != 0) ||
+      (c_avl_insert(batch->series, key, s) != 0)) {
+    format_json_series_free(s);
+    sfree(key);
+    return NULL;
+  }
+
+  s->expires = expires;
+  if ((batch->next_expire == 0) || (expires < batch->next_expire))
+    batch->next_expire = expires;
+  return s;
+} /* }}} format_json_series_t *format_json_batch_series */
+
+/* Makes sure that at least `len' more bytes fit into the buffer. */
+static int format_json_batch_reserve(format_json_batch_t *batch, /* {{{ */
+                                     size_t len) {
+  if ((batch->size - batch->fill) >= len)
+    return 0;
+
+  size_t size =
+      (batch->size > 0) ? batch->size : FORMAT_JSON_BATCH_INITIAL_SIZE;
+  while ((size - batch->fill) < len)
+    size *= 2;
+
+  char *buffer = realloc(batch->buffer, size);
+  if (buffer == NULL)
+    return -ENOMEM;
+
+  batch->buffer = buffer;
+  batch->size = size;
+  return 0;
+} /* }}} int format_json_batch_reserve */
+
+static int format_json_batch_add_meta(format_json_batch_t *batch, /* {{{ */
+                                      meta_data_t *meta) {
+  static char const prefix[] = ",\"meta\":";
+  size_t reserve = 1024;
+
+  while (true) {
+    int status = format_json_batch_reserve(batch, reserve);
+    if (status != 0)
+      return status;
+
+    char *buffer = batch->buffer + batch->fill;
+    size_t buffer_size = batch->size - batch->fill;
+
+    buffer[sizeof(prefix) - 1] = 0;
+    status = meta_data_to_json(buffer + sizeof(prefix) - 1,
+                               buffer_size - (sizeof(prefix) - 1), meta);
+    if ((status == -ENOMEM) && (reserve < FORMAT_JSON_META_MAX)) {
+      reserve = buffer_size * 2;
+      continue;
+    } else if ((status == ENOENT) || ((status == 0) &&
+                                      (buffer[sizeof(prefix) - 1] == 0))) {
+      /* None of the meta data can be represented. */
+      return 0;
+    } else if (status != 0) {
+      return status;
+    }
+
+    memcpy(buffer, prefix, sizeof(prefix) - 1);
+    batch->fill += strlen(buffer);
+    return 0;
+  }
+} /* }}} int format_json_batch_add_meta */
+
+format_json_batch_t *format_json_batch_create(void) /* {{{ */
+{
+  format_json_batch_t *batch = calloc(1, sizeof(*batch));
+  if (batch == NULL)
+    return NULL;
+
+  batch->series = c_avl_create((int (*)(const void *, const void *))strcmp);
+  if (batch->series == NULL) {
+    sfree(batch);
+    return NULL;
+  }
+  batch->now = cdtime();
+
+  return batch;
+} /* }}} format_json_batch_t *format_json_batch_create */
+
+void format_json_batch_destroy(format_json_batch_t *batch) /* {{{ */
+{
+  void *key;
+  void *value;
+
+  if (batch == NULL)
+    return;
+
+  while (c_avl_pick(batch->series, &key, &value) == 0) {
+    sfree(key);
+    format_json_series_free(value);
+  }
+  c_avl_destroy(batch->series);
+
+  sfree(batch->buffer);
+  sfree(batch);
+} /* }}} void format_json_batch_destroy */
+
+int format_json_batch_add(format_json_batch_t *batch, /* {{{ */
+                          const data_set_t *ds, const value_list_t *vl,
+                          gauge_t const *rates) {
+  if ((batch == NULL) || (ds == NULL) || (vl == NULL))
+    return -EINVAL;
+
+  format_json_series_t *s = format_json_batch_series(batch, ds, vl);
+  if (s == NULL) {
+    ERROR("format_json: Formatting the identifier of \"%s\" failed.",
+          vl->plugin);
+    return -1;
+  }
+
+  /* ',{"values":[' + values + ']' + ',"time":' + ',"interval":' + '}' */
+  int status = format_json_batch_reserve(
+      batch, ds->ds_num * (SERIALIZE_NUMBER_MAX + 1) + s->ds_json_len +
+                 s->id_json_len + 2 * SERIALIZE_NUMBER_MAX + 64);
+  if (status != 0)
+    return status;
+
+  size_t fill = batch->fill;
+  char *buffer = batch->buffer;
+
+#define BUFFER_ADD_STRING(str, len)                                            \
+  do {                                                                         \
+    memcpy(buffer + fill, (str), (len));                                       \
+    fill += (len);                                                             \
+  } while (0)
+#define BUFFER_ADD_LITERAL(str) BUFFER_ADD_STRING(str, sizeof(str) - 1)
+#define BUFFER_ADD_VALUE(func, ...)                                            \
+  do {                                                                         \
+    int len = func(buffer + fill, SERIALIZE_NUMBER_MAX, __VA_ARGS__);          \
+    if ((len < 1) || (len >= SERIALIZE_NUMBER_MAX))                            \
+      return -1;                                                               \
+    fill += (size_t)len;                                                       \
+  } while (0)
+
+  /* All value lists have a leading comma. The first one is replaced with a
+   * square bracket in `format_json_batch_finalize'. */
+  BUFFER_ADD_LITERAL(",{\"values\":[");
+  for (size_t i = 0; i < ds->ds_num; i++) {
+    if (i > 0)
+      BUFFER_ADD_LITERAL(",");
+
+    if ((ds->ds[i].type == DS_TYPE_GAUGE) || (rates != NULL)) {
+      gauge_t value =
+          (ds->ds[i].type == DS_TYPE_GAUGE) ? vl->values[i].gauge : rates[i];
+      if (isfinite(value))
+        BUFFER_ADD_VALUE(serialize_gauge, value);
+      else
+        BUFFER_ADD_LITERAL("null");
+    } else if (ds->ds[i].type == DS_TYPE_COUNTER)
+      BUFFER_ADD_VALUE(serialize_uint64, (uint64_t)vl->values[i].counter);
+    else if (ds->ds[i].type == DS_TYPE_DERIVE)
+      BUFFER_ADD_VALUE(serialize_int64, vl->values[i].derive);
+    else if (ds->ds[i].type == DS_TYPE_ABSOLUTE)
+      BUFFER_ADD_VALUE(serialize_uint64, vl->values[i].absolute);
+    else {
+      ERROR("format_json: Unknown data source type: %i", ds->ds[i].type);
+      return -1;
+    }
+  }
+  BUFFER_ADD_LITERAL("]");
+
+  BUFFER_ADD_STRING(s->ds_json, s->ds_json_len);
+  BUFFER_ADD_LITERAL(",\"time\":");
+  BUFFER_ADD_VALUE(serialize_fixed, CDTIME_T_TO_DOUBLE(vl->time), 3);
+  BUFFER_ADD_LITERAL(",\"interval\":");
+  BUFFER_ADD_VALUE(serialize_fixed, CDTIME_T_TO_DOUBLE(vl->interval), 3);
+  BUFFER_ADD_STRING(s->id_json, s->id_json_len);
+
+#undef BUFFER_ADD_VALUE
+#undef BUFFER_ADD_LITERAL
+#undef BUFFER_ADD_STRING
+
+  if (vl->meta != NULL) {
+    size_t start = batch->fill;
+    batch->fill = fill;
+    status = format_json_batch_add_meta(batch, vl->meta);
+    fill = batch->fill;
+    batch->fill = start;
+    if (status != 0)
+      return status;
+  }
+
+  status = format_json_batch_reserve(batch, (fill - batch->fill) + 1);
+  if (status != 0)
+    return status;
+  batch->buffer[fill] = '}';
+  batch->fill = fill + 1;
+
+  return 0;
+} /* }}} int format_json_batch_add */
+
+size_t format_json_batch_size(format_json_batch_t const *batch) /* {{{ */
+{
+  return (batch != NULL) ? batch->fill : 0;
+} /* }}} size_t format_json_batch_size */
+
+char const *format_json_batch_finalize(format_json_batch_t *batch) /* {{{ */
+{
+  if ((batch == NULL) || (batch->fill == 0) || (batch->buffer[0] != ','))
+    return NULL;
+
+  if (format_json_batch_reserve(batch, 2) != 0)
+    return NULL;
+
+  /* Replace the leading comma added in `format_json_batch_add' with a square
+   * bracket. */
+  batch->buffer[0] = '[';
+  batch->buffer[batch->fill] = ']';
+  batch->buffer[batch->fill + 1] = 0;
+  batch->fill++;
+
+  return batch->buffer;
+} /* }}} char const *format_json_batch_finalize */
+
+size_t format_json_batch_series_num(format_json_batch_t const *batch) /* {{{ */
+{
+  return (batch != NULL) ? (size_t)c_avl_size(batch->series) : 0;
+} /* }}} size_t format_json_batch_series_num */
+
+void format_json_batch_reset(format_json_batch_t *batch) /* {{{ */
+{
+  if (batch == NULL)
+    return;
+
+  batch->fill = 0;
+  batch->now = cdtime();
+
+  /* Batches may be sent many times per interval. The cache is only searched
+   * for expired series once the first one has expired. */
+  if ((batch->next_expire == 0) || (batch->now < batch->next_expire))
+    return;
+
+  char **keys = NULL;
+  size_t keys_num = 0;
+  cdtime_t next_expire = 0;
+  c_avl_iterator_t *iter = c_avl_get_iterator(batch->series);
+  char *key;
+  format_json_series_t *s;
+
+  while (c_avl_iterator_next(iter, (void *)&key, (void *)&s) == 0) {
+    if (s->expires > batch->now) {
+      if ((next_expire == 0) || (s->expires < next_expire))
+        next_expire = s->expires;
+      continue;
+    }
+
+    char **tmp = realloc(keys, (keys_num + 1) * sizeof(*keys));
+    if (tmp == NULL) {
+      /* Try again with the next batch. */
+      next_expire = batch->now;
+      break;
+    }
+    keys = tmp;
+    keys[keys_num++] = key;
+  }
+  c_avl_iterator_destroy(iter);
+  batch->next_expire = next_expire;
+
+  for (size_t i = 0; i < keys_num; i++) {
+    if (c_avl_remove(batch->series, keys[i], (void *)&key, (void *)&s) == 0) {
+      sfree(key);
+      format_json_series_free(s);
+    }
+  }
+  sfree(keys);
+} /* }}} void format_json_batch_reset */
+
 #if HAVE_LIBYAJL
 static int json_add_string(yajl_gen g, char const *str) /* {{{ */
 {
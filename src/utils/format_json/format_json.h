@@ -45,4 +45,29 @@ int format_json_finalize(char *buffer, size_t *ret_buffer_fill,
 int format_json_notification(char *buffer, size_t buffer_size,
                              notification_t const *n);
 
+/*
+ * A batch of value lists, formatted as a JSON array in the same way as with
+ * format_json_value_list(). The buffer grows as needed and the parts that only
+ * depend on the identifier and the data set are cached between batches.
+ *
+ * If `rates' is not NULL, it must contain the rates of all data sources,
+ * e.g. as returned by uc_get_rate(), which are then used instead of the
+ * values of non-gauge data sources. format_json_batch_finalize() returns the
+ * null-terminated array or NULL if the batch is empty. Afterwards, the batch
+ * has to be reset before more value lists can be added.
+ *
+ * The formatted identifiers are cached for twice the interval of the value
+ * lists. format_json_batch_series_num() returns the number of cached series.
+ */
+typedef struct format_json_batch_s format_json_batch_t;
+
+format_json_batch_t *format_json_batch_create(void);
+void format_json_batch_destroy(format_json_batch_t *batch);
+int format_json_batch_add(format_json_batch_t *batch, const data_set_t *ds,
+                          const value_list_t *vl, gauge_t const *rates);
+size_t format_json_batch_size(format_json_batch_t const *batch);
+char const *format_json_batch_finalize(format_json_batch_t *batch);
+size_t format_json_batch_series_num(format_json_batch_t const *batch);
+void format_json_batch_reset(format_json_batch_t *batch);
+
 #endif /* UTILS_FORMAT_JSON_H */
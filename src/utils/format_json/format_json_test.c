@@ -177,8 +177,171 @@ DEF_TEST(notification) {
   return expect_json_labels(got, labels, STATIC_ARRAY_SIZE(labels));
 }
 
+static data_source_t batch_sources[] = {
+    {"value", DS_TYPE_GAUGE, 0.0, NAN},
+    {"rx", DS_TYPE_DERIVE, 0.0, NAN},
+    {"tx", DS_TYPE_COUNTER, 0.0, NAN},
+    {"total", DS_TYPE_ABSOLUTE, 0.0, NAN},
+};
+static data_set_t batch_ds = {"test", STATIC_ARRAY_SIZE(batch_sources),
+                              batch_sources};
+
+/* Formats the value lists with format_json_value_list() so that the output of
+ * the batch can be compared with it. */
+static int batch_want(char *buffer, size_t buffer_size, value_list_t *vls,
+                      size_t vls_num, int store_rates) {
+  size_t fill = 0, buffer_free = buffer_size;
+
+  CHECK_ZERO(format_json_initialize(buffer, &fill, &buffer_free));
+  for (size_t i = 0; i < vls_num; i++)
+    CHECK_ZERO(format_json_value_list(buffer, &fill, &buffer_free, &batch_ds,
+                                      vls + i, store_rates));
+  CHECK_ZERO(format_json_finalize(buffer, &fill, &buffer_free));
+  return 0;
+}
+
+DEF_TEST(batch) {
+  value_t values[][4] = {
+      {{.gauge = 42.5}, {.derive = -7}, {.counter = 1234567}, {.absolute = 1}},
+      {{.gauge = NAN}, {.derive = 0}, {.counter = 0}, {.absolute = 0}},
+      {{.gauge = 1e-7}, {.derive = INT64_MIN}, {.counter = UINT64_MAX},
+       {.absolute = 3}},
+  };
+  value_list_t vls[] = {
+      {.values = values[0],
+       .values_len = 4,
+       .time = TIME_T_TO_CDTIME_T(1448284606),
+       .interval = TIME_T_TO_CDTIME_T(10),
+       .host = "example.com",
+       .plugin = "unit",
+       .type = "test"},
+      {.values = values[1],
+       .values_len = 4,
+       .time = 1555083754651779072ULL,
+       .interval = DOUBLE_TO_CDTIME_T(0.5),
+       .host = "example.com",
+       .plugin = "unit",
+       .plugin_instance = "\"quoted\\\"",
+       .type = "test",
+       .type_instance = "tab\there"},
+      {.values = values[2],
+       .values_len = 4,
+       .time = 1,
+       .interval = 0,
+       .host = "other.example.com",
+       .plugin = "unit",
+       .type = "test"},
+  };
+  char want[4096], got[4096];
+
+  vls[2].meta = meta_data_create();
+  meta_data_add_string(vls[2].meta, "string", "\"value\"");
+  meta_data_add_signed_int(vls[2].meta, "int", -1);
+
+  format_json_batch_t *batch;
+  CHECK_NOT_NULL(batch = format_json_batch_create());
+  OK(format_json_batch_finalize(batch) == NULL);
+
+  /* The second round uses the cached identifiers. */
+  for (int round = 0; round < 2; round++) {
+    CHECK_ZERO(batch_want(want, sizeof(want), vls, STATIC_ARRAY_SIZE(vls), 0));
+    for (size_t i = 0; i < STATIC_ARRAY_SIZE(vls); i++)
+      CHECK_ZERO(format_json_batch_add(batch, &batch_ds, vls + i, NULL));
+    EXPECT_EQ_INT(strlen(want) - 1, format_json_batch_size(batch));
+    EXPECT_EQ_STR(want, format_json_batch_finalize(batch));
+    format_json_batch_reset(batch);
+    EXPECT_EQ_INT(0, format_json_batch_size(batch));
+  }
+
+  /* Rates replace the values of all but the gauge data sources. */
+  gauge_t rates[] = {NAN, 1.5, INFINITY, 0.25};
+  CHECK_ZERO(format_json_batch_add(batch, &batch_ds, vls, rates));
+  sstrncpy(got, format_json_batch_finalize(batch), sizeof(got));
+  OK(strstr(got, "\"values\":[42.5,1.5,null,0.25]") != NULL);
+  format_json_batch_reset(batch);
+
+  /* Enough value lists to grow the buffer a few times. */
+  int status = 0;
+  for (size_t i = 0; i < 1000; i++)
+    status |= format_json_batch_add(batch, &batch_ds, vls + (i % 3), NULL);
+  EXPECT_EQ_INT(0, status);
+  char const *data = format_json_batch_finalize(batch);
+  OK(data != NULL);
+  EXPECT_EQ_INT('[', data[0]);
+  EXPECT_EQ_INT(']', data[strlen(data) - 1]);
+  EXPECT_EQ_INT(strlen(data), format_json_batch_size(batch));
+
+  format_json_batch_destroy(batch);
+  meta_data_destroy(vls[2].meta);
+  return 0;
+}
+
+/* Sends the value lists the way write_http does with its default BufferSize
+ * of 4096 bytes, i.e. many times per interval. Returns the number of series
+ * cached afterwards. */
+static int batch_cache_round(format_json_batch_t *batch, int series_num,
+                             int step) {
+  value_t values[4] = {
+      {.gauge = 0.1}, {.derive = 12345}, {.counter = 67890}, {.absolute = 3}};
+  value_list_t vl = {
+      .values = values,
+      .values_len = 4,
+      .time = cdtime_mock,
+      .interval = TIME_T_TO_CDTIME_T(10),
+      .host = "host.example.com",
+      .plugin = "interface",
+      .type = "test",
+  };
+
+  for (int i = 0; i < series_num; i += step) {
+    ssnprintf(vl.plugin_instance, sizeof(vl.plugin_instance), "eth%d", i);
+    if (format_json_batch_add(batch, &batch_ds, &vl, NULL) != 0)
+      return -1;
+    if (format_json_batch_size(batch) < 4096)
+      continue;
+    if (format_json_batch_finalize(batch) == NULL)
+      return -1;
+    format_json_batch_reset(batch);
+  }
+  format_json_batch_finalize(batch);
+  format_json_batch_reset(batch);
+
+  return (int)format_json_batch_series_num(batch);
+}
+
+DEF_TEST(batch_cache) {
+  cdtime_t interval = TIME_T_TO_CDTIME_T(10);
+  format_json_batch_t *batch;
+
+  cdtime_mock = TIME_T_TO_CDTIME_T(1448284606);
+  CHECK_NOT_NULL(batch = format_json_batch_create());
+
+  /* Series stay cached although the batch is reset many times per interval. */
+  for (int round = 0; round < 5; round++) {
+    EXPECT_EQ_INT(300, batch_cache_round(batch, 300, 1));
+    cdtime_mock += interval;
+  }
+
+  /* Half of the series are no longer reported. They expire twice the
+   * interval after they have been reported last. */
+  EXPECT_EQ_INT(300, batch_cache_round(batch, 300, 2));
+  cdtime_mock += interval;
+  EXPECT_EQ_INT(150, batch_cache_round(batch, 300, 2));
+  cdtime_mock += interval;
+  EXPECT_EQ_INT(150, batch_cache_round(batch, 300, 2));
+  cdtime_mock += interval;
+
+  /* Series that return are added again. */
+  EXPECT_EQ_INT(300, batch_cache_round(batch, 300, 1));
+
+  format_json_batch_destroy(batch);
+  return 0;
+}
+
 int main(void) {
   RUN_TEST(notification);
+  RUN_TEST(batch);
+  RUN_TEST(batch_cache);
 
   END_TEST;
 }
@@ -30,6 +30,7 @@
 #include "utils/common/common.h"
 
 #include "utils/format_kairosdb/format_kairosdb.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 
 /* This is the KAIROSDB format for write_http output
@@ -114,12 +115,23 @@ static int values_to_kairosdb(char *buffer, size_t buffer_size, /* {{{ */
       offset += ((size_t)status);                                              \
   } while (0)
 
+#define BUFFER_ADD_VALUE(func, value)                                          \
+  do {                                                                         \
+    int status;                                                                \
+    status = func(buffer + offset, buffer_size - offset, (value));             \
+    if (((size_t)status) >= (buffer_size - offset)) {                          \
+      sfree(rates);                                                            \
+      return -ENOMEM;                                                          \
+    } else                                                                     \
+      offset += ((size_t)status);                                              \
+  } while (0)
+
   if (ds->ds[ds_idx].type == DS_TYPE_GAUGE) {
     if (isfinite(vl->values[ds_idx].gauge)) {
       BUFFER_ADD("[[");
-      BUFFER_ADD("%" PRIu64, CDTIME_T_TO_MS(vl->time));
+      BUFFER_ADD_VALUE(serialize_uint64, CDTIME_T_TO_MS(vl->time));
       BUFFER_ADD(",");
-      BUFFER_ADD(JSON_GAUGE_FORMAT, vl->values[ds_idx].gauge);
+      BUFFER_ADD_VALUE(serialize_gauge, vl->values[ds_idx].gauge);
     } else {
       DEBUG("utils_format_kairosdb: invalid vl->values[ds_idx].gauge for "
             "%s|%s|%s|%s|%s",
@@ -140,9 +152,9 @@ static int values_to_kairosdb(char *buffer, size_t buffer_size, /* {{{ */
 
     if (isfinite(rates[ds_idx])) {
       BUFFER_ADD("[[");
-      BUFFER_ADD("%" PRIu64, CDTIME_T_TO_MS(vl->time));
+      BUFFER_ADD_VALUE(serialize_uint64, CDTIME_T_TO_MS(vl->time));
       BUFFER_ADD(",");
-      BUFFER_ADD(JSON_GAUGE_FORMAT, rates[ds_idx]);
+      BUFFER_ADD_VALUE(serialize_gauge, rates[ds_idx]);
     } else {
       WARNING("utils_format_kairosdb: invalid rates[ds_idx] for %s|%s|%s|%s|%s",
               vl->plugin, vl->plugin_instance, vl->type, vl->type_instance,
@@ -152,19 +164,19 @@ static int values_to_kairosdb(char *buffer, size_t buffer_size, /* {{{ */
     }
   } else if (ds->ds[ds_idx].type == DS_TYPE_COUNTER) {
     BUFFER_ADD("[[");
-    BUFFER_ADD("%" PRIu64, CDTIME_T_TO_MS(vl->time));
+    BUFFER_ADD_VALUE(serialize_uint64, CDTIME_T_TO_MS(vl->time));
     BUFFER_ADD(",");
-    BUFFER_ADD("%" PRIu64, (uint64_t)vl->values[ds_idx].counter);
+    BUFFER_ADD_VALUE(serialize_uint64, (uint64_t)vl->values[ds_idx].counter);
   } else if (ds->ds[ds_idx].type == DS_TYPE_DERIVE) {
     BUFFER_ADD("[[");
-    BUFFER_ADD("%" PRIu64, CDTIME_T_TO_MS(vl->time));
+    BUFFER_ADD_VALUE(serialize_uint64, CDTIME_T_TO_MS(vl->time));
     BUFFER_ADD(",");
-    BUFFER_ADD("%" PRIi64, vl->values[ds_idx].derive);
+    BUFFER_ADD_VALUE(serialize_int64, vl->values[ds_idx].derive);
   } else if (ds->ds[ds_idx].type == DS_TYPE_ABSOLUTE) {
     BUFFER_ADD("[[");
-    BUFFER_ADD("%" PRIu64, CDTIME_T_TO_MS(vl->time));
+    BUFFER_ADD_VALUE(serialize_uint64, CDTIME_T_TO_MS(vl->time));
     BUFFER_ADD(",");
-    BUFFER_ADD("%" PRIu64, vl->values[ds_idx].absolute);
+    BUFFER_ADD_VALUE(serialize_uint64, vl->values[ds_idx].absolute);
   } else {
     ERROR("format_kairosdb: Unknown data source type: %i", ds->ds[ds_idx].type);
     sfree(rates);
@@ -172,6 +184,7 @@ static int values_to_kairosdb(char *buffer, size_t buffer_size, /* {{{ */
   }
   BUFFER_ADD("]]");
 
+#undef BUFFER_ADD_VALUE
 #undef BUFFER_ADD
 
   DEBUG("format_kairosdb: values_to_kairosdb: buffer = %s;", buffer);
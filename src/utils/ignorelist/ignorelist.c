@@ -55,6 +55,14 @@
 #include "plugin.h"
 #include "utils/common/common.h"
 #include "utils/ignorelist/ignorelist.h"
+#include "utils/string_cache/string_cache.h"
+
+#include <pthread.h>
+
+/* number of slots of the match result cache */
+#define IGNORELIST_CACHE_SIZE 64
+/* longest entry whose match result is cached, including the null byte */
+#define IGNORELIST_CACHE_ENTRY_MAX 64
 
 /*
  * private prototypes
@@ -62,27 +70,71 @@
 struct ignorelist_item_s {
 #if HAVE_REGEX_H
   regex_t *rmatch; /* regular expression entry identification */
+  char *rsource;   /* the regular expression as configured */
 #endif
   char *smatch; /* string entry identification */
   struct ignorelist_item_s *next;
 };
 typedef struct ignorelist_item_s ignorelist_item_t;
 
+typedef struct {
+  bool valid;
+  bool found;
+  char entry[IGNORELIST_CACHE_ENTRY_MAX];
+} ignorelist_cache_t;
+
 struct ignorelist_s {
   int ignore;              /* ignore entries */
   ignorelist_item_t *head; /* pointer to the first entry */
+
+  /*
+   * The list is compiled on the first match after it has been changed: the
+   * string entries go into a hash set and the regex entries are combined
+   * into a single regular expression. Protected by `lock', as are the
+   * results of recent matches in `cache'.
+   */
+  pthread_mutex_t lock;
+  bool compiled;
+  char **strings;      /* open addressing hash set of the string entries */
+  size_t strings_size; /* zero or a power of two */
+#if HAVE_REGEX_H
+  bool have_regex;
+  regex_t *combined; /* all regex entries, or NULL if they can't be combined */
+#endif
+  ignorelist_cache_t cache[IGNORELIST_CACHE_SIZE];
 };
 
 /* *** *** *** ********************************************* *** *** *** */
 /* *** *** *** *** *** ***   private functions   *** *** *** *** *** *** */
 /* *** *** *** ********************************************* *** *** *** */
 
+/*
+ * throw away the compiled form of the list after it has been changed
+ * caller must hold il->lock
+ */
+static void ignorelist_uncompile(ignorelist_t *il) {
+  sfree(il->strings);
+  il->strings_size = 0;
+#if HAVE_REGEX_H
+  if (il->combined != NULL) {
+    regfree(il->combined);
+    sfree(il->combined);
+  }
+  il->have_regex = false;
+#endif
+  memset(il->cache, 0, sizeof(il->cache));
+  il->compiled = false;
+} /* void ignorelist_uncompile (ignorelist_t *il) */
+
 static inline void ignorelist_append(ignorelist_t *il,
                                      ignorelist_item_t *item) {
   assert((il != NULL) && (item != NULL));
 
+  pthread_mutex_lock(&il->lock);
   item->next = il->head;
   il->head = item;
+  ignorelist_uncompile(il);
+  pthread_mutex_unlock(&il->lock);
 }
 
 #if HAVE_REGEX_H
@@ -117,6 +169,14 @@ static int ignorelist_append_regex(ignorelist_t *il, const char *re_str) {
     return ENOMEM;
   }
   entry->rmatch = re;
+  entry->rsource = strdup(re_str);
+  if (entry->rsource == NULL) {
+    ERROR("ignorelist_append_regex: strdup failed.");
+    regfree(re);
+    sfree(re);
+    sfree(entry);
+    return ENOMEM;
+  }
 
   ignorelist_append(il, entry);
   return 0;
@@ -141,34 +201,158 @@ static int ignorelist_append_string(ignorelist_t *il, const char *entry) {
 
 #if HAVE_REGEX_H
 /*
- * check list for entry regex match
- * return 1 if found
+ * combine all regex entries into "(re1)|(re2)|..."
+ * back-references would refer to the wrong group in the combined expression,
+ * so lists using them are not combined
+ * return NULL if the entries can't be combined
  */
-static int ignorelist_match_regex(ignorelist_item_t *item, const char *entry) {
-  assert((item != NULL) && (item->rmatch != NULL) && (entry != NULL) &&
-         (strlen(entry) > 0));
+static regex_t *ignorelist_combine_regex(ignorelist_t *il) {
+  size_t len = 0;
+
+  for (ignorelist_item_t *item = il->head; item != NULL; item = item->next) {
+    if (item->rmatch == NULL)
+      continue;
+
+    for (const char *ptr = strchr(item->rsource, '\\'); ptr != NULL;
+         ptr = strchr(ptr + 2, '\\')) {
+      if (isdigit((unsigned char)ptr[1]))
+        return NULL;
+      if (ptr[1] == 0)
+        break;
+    }
 
-  /* match regex */
-  if (regexec(item->rmatch, entry, 0, NULL, 0) == 0)
-    return 1;
+    /* parentheses and separator */
+    len += strlen(item->rsource) + 3;
+  }
 
-  return 0;
-} /* int ignorelist_match_regex (ignorelist_item_t *item, const char *entry) */
+  char *pattern = malloc(len + 1);
+  if (pattern == NULL)
+    return NULL;
+
+  char *ptr = pattern;
+  for (ignorelist_item_t *item = il->head; item != NULL; item = item->next) {
+    if (item->rmatch == NULL)
+      continue;
+
+    if (ptr != pattern)
+      *(ptr++) = '|';
+    *(ptr++) = '(';
+    size_t source_len = strlen(item->rsource);
+    memcpy(ptr, item->rsource, source_len);
+    ptr += source_len;
+    *(ptr++) = ')';
+  }
+  *ptr = 0;
+
+  regex_t *re = calloc(1, sizeof(*re));
+  if (re == NULL) {
+    sfree(pattern);
+    return NULL;
+  }
+
+  int status = regcomp(re, pattern, REG_EXTENDED | REG_NOSUB);
+  if (status != 0) {
+    DEBUG("ignorelist_combine_regex: Compiling \"%s\" failed, matching the "
+          "regular expressions one by one.",
+          pattern);
+    sfree(re);
+    re = NULL;
+  }
+
+  sfree(pattern);
+  return re;
+} /* regex_t *ignorelist_combine_regex (ignorelist_t *il) */
 #endif
 
 /*
- * check list for entry string match
- * return 1 if found
+ * build the hash set of string entries and the combined regex
+ * caller must hold il->lock
+ * return 0 for success
  */
-static int ignorelist_match_string(ignorelist_item_t *item, const char *entry) {
-  assert((item != NULL) && (item->smatch != NULL) && (entry != NULL) &&
-         (strlen(entry) > 0));
+static int ignorelist_compile(ignorelist_t *il) {
+  size_t strings_num = 0;
 
-  if (strcmp(entry, item->smatch) == 0)
-    return 1;
+  for (ignorelist_item_t *item = il->head; item != NULL; item = item->next) {
+    if (item->smatch != NULL)
+      strings_num++;
+#if HAVE_REGEX_H
+    else
+      il->have_regex = true;
+#endif
+  }
+
+  if (strings_num > 0) {
+    /* keep the load factor at or below one half */
+    size_t size = 8;
+    while (size < 2 * strings_num)
+      size *= 2;
 
+    il->strings = calloc(size, sizeof(*il->strings));
+    if (il->strings == NULL) {
+      ERROR("ignorelist_compile: calloc failed.");
+      return ENOMEM;
+    }
+    il->strings_size = size;
+
+    for (ignorelist_item_t *item = il->head; item != NULL; item = item->next) {
+      if (item->smatch == NULL)
+        continue;
+
+      size_t i = string_cache_hash(item->smatch) & (size - 1);
+      while ((il->strings[i] != NULL) &&
+             (strcmp(il->strings[i], item->smatch) != 0))
+        i = (i + 1) & (size - 1);
+      il->strings[i] = item->smatch;
+    }
+  }
+
+#if HAVE_REGEX_H
+  if (il->have_regex)
+    il->combined = ignorelist_combine_regex(il);
+#endif
+
+  il->compiled = true;
   return 0;
-} /* int ignorelist_match_string (ignorelist_item_t *item, const char *entry) */
+} /* int ignorelist_compile (ignorelist_t *il) */
+
+/*
+ * check list for entry
+ * caller must hold il->lock
+ * return true if found
+ */
+static bool ignorelist_lookup(ignorelist_t *il, const char *entry,
+                              uint32_t hash) {
+  if (il->compiled && (il->strings_size > 0)) {
+    size_t mask = il->strings_size - 1;
+
+    for (size_t i = hash & mask; il->strings[i] != NULL; i = (i + 1) & mask)
+      if (strcmp(il->strings[i], entry) == 0)
+        return true;
+  }
+
+#if HAVE_REGEX_H
+  if (il->compiled && !il->have_regex)
+    return false;
+
+  if (il->compiled && (il->combined != NULL))
+    return regexec(il->combined, entry, 0, NULL, 0) == 0;
+#endif
+
+  /* traverse list and check entries */
+  for (ignorelist_item_t *item = il->head; item != NULL; item = item->next) {
+#if HAVE_REGEX_H
+    if (item->rmatch != NULL) {
+      if (regexec(item->rmatch, entry, 0, NULL, 0) == 0)
+        return true;
+      continue;
+    }
+#endif
+    if (!il->compiled && (strcmp(entry, item->smatch) == 0))
+      return true;
+  }
+
+  return false;
+} /* bool ignorelist_lookup (ignorelist_t *il, const char *entry) */
 
 /* *** *** *** ******************************************** *** *** *** */
 /* *** *** *** *** *** ***   public functions   *** *** *** *** *** *** */
@@ -191,6 +375,8 @@ ignorelist_t *ignorelist_create(int invert) {
    */
   il->ignore = invert ? 0 : 1;
 
+  pthread_mutex_init(&il->lock, /* attr = */ NULL);
+
   return il;
 } /* ignorelist_t *ignorelist_create (int ignore) */
 
@@ -212,6 +398,7 @@ void ignorelist_free(ignorelist_t *il) {
       sfree(this->rmatch);
       this->rmatch = NULL;
     }
+    sfree(this->rsource);
 #endif
     if (this->smatch != NULL) {
       sfree(this->smatch);
@@ -220,6 +407,8 @@ void ignorelist_free(ignorelist_t *il) {
     sfree(this);
   }
 
+  ignorelist_uncompile(il);
+  pthread_mutex_destroy(&il->lock);
   sfree(il);
 } /* void ignorelist_destroy (ignorelist_t *il) */
 
@@ -290,6 +479,8 @@ int ignorelist_remove(ignorelist_t *il, const char *entry) {
   if ((entry == NULL) || (strlen(entry) == 0))
     return 1;
 
+  pthread_mutex_lock(&il->lock);
+
   /* traverse list and check entries */
   for (ignorelist_item_t *prev = NULL, *traverse = il->head; traverse != NULL;
        prev = traverse, traverse = traverse->next) {
@@ -299,6 +490,9 @@ int ignorelist_remove(ignorelist_t *il, const char *entry) {
       } else {
         prev->next = traverse->next;
       }
+      ignorelist_uncompile(il);
+      pthread_mutex_unlock(&il->lock);
+
       sfree(traverse->smatch);
       traverse->smatch = NULL;
       sfree(traverse);
@@ -306,6 +500,7 @@ int ignorelist_remove(ignorelist_t *il, const char *entry) {
     }
   } /* for traverse */
 
+  pthread_mutex_unlock(&il->lock);
   return 1;
 } /* int ignorelist_remove (ignorelist_t *il, const char *entry) */
 
@@ -321,20 +516,29 @@ int ignorelist_match(ignorelist_t *il, const char *entry) {
   if ((entry == NULL) || (strlen(entry) == 0))
     return 0;
 
-  /* traverse list and check entries */
-  for (ignorelist_item_t *traverse = il->head; traverse != NULL;
-       traverse = traverse->next) {
-#if HAVE_REGEX_H
-    if (traverse->rmatch != NULL) {
-      if (ignorelist_match_regex(traverse, entry))
-        return il->ignore;
-    } else
-#endif
-    {
-      if (ignorelist_match_string(traverse, entry))
-        return il->ignore;
+  uint32_t hash = string_cache_hash(entry);
+  ignorelist_cache_t *cached = il->cache + (hash % IGNORELIST_CACHE_SIZE);
+  bool found;
+
+  pthread_mutex_lock(&il->lock);
+
+  /* if compiling fails, the list is traversed instead */
+  if (!il->compiled)
+    ignorelist_compile(il);
+
+  if (cached->valid && (strcmp(cached->entry, entry) == 0)) {
+    found = cached->found;
+  } else {
+    found = ignorelist_lookup(il, entry, hash);
+
+    if (strlen(entry) < sizeof(cached->entry)) {
+      sstrncpy(cached->entry, entry, sizeof(cached->entry));
+      cached->found = found;
+      cached->valid = true;
     }
-  } /* for traverse */
+  }
+
+  pthread_mutex_unlock(&il->lock);
 
-  return 1 - il->ignore;
+  return found ? il->ignore : 1 - il->ignore;
 } /* int ignorelist_match (ignorelist_t *il, const char *entry) */
@@ -0,0 +1,149 @@
+/**
+ * collectd - src/utils/ignorelist/ignorelist_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ **/
+
+#include "collectd.h"
+
+#include "testing.h"
+#include "utils/common/common.h"
+#include "utils/ignorelist/ignorelist.h"
+
+DEF_TEST(match) {
+  struct {
+    const char *entry;
+    int want;
+  } cases[] = {
+      {"eth0", 1},     {"eth1", 1}, {"eth10", 0},   {"lo", 0},
+      {"veth1234", 1}, {"veth", 0}, {"docker0", 1}, {"", 0},
+  };
+
+  ignorelist_t *il = ignorelist_create(/* invert = */ 1);
+  CHECK_NOT_NULL(il);
+
+  /* Empty lists collect everything. */
+  EXPECT_EQ_INT(0, ignorelist_match(il, "eth0"));
+
+  CHECK_ZERO(ignorelist_add(il, "eth0"));
+  CHECK_ZERO(ignorelist_add(il, "eth1"));
+  CHECK_ZERO(ignorelist_add(il, "/^veth[0-9]+$/"));
+  CHECK_ZERO(ignorelist_add(il, "/^docker/"));
+  OK(ignorelist_add(il, "") != 0);
+
+  /* Twice, the second time from the cache. */
+  for (int round = 0; round < 2; round++) {
+    for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+      /* ignorelist_match() returns 0 for entries that are collected. */
+      int want = (cases[i].entry[0] == 0) ? 0 : !cases[i].want;
+      printf("## Case %zu: \"%s\"\n", i, cases[i].entry);
+      EXPECT_EQ_INT(want, ignorelist_match(il, cases[i].entry));
+    }
+  }
+
+  ignorelist_set_invert(il, 0);
+  EXPECT_EQ_INT(1, ignorelist_match(il, "eth0"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "lo"));
+
+  ignorelist_free(il);
+  return 0;
+}
+
+DEF_TEST(change) {
+  ignorelist_t *il = ignorelist_create(/* invert = */ 1);
+  CHECK_NOT_NULL(il);
+
+  CHECK_ZERO(ignorelist_add(il, "sda"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "sda"));
+  EXPECT_EQ_INT(1, ignorelist_match(il, "sdb"));
+
+  /* Results cached before a change must not be used afterwards. */
+  CHECK_ZERO(ignorelist_add(il, "sdb"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "sdb"));
+
+  CHECK_ZERO(ignorelist_remove(il, "sda"));
+  EXPECT_EQ_INT(1, ignorelist_match(il, "sda"));
+  OK(ignorelist_remove(il, "sda") != 0);
+
+  CHECK_ZERO(ignorelist_add(il, "/^sd[a-c]$/"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "sda"));
+
+  ignorelist_free(il);
+  return 0;
+}
+
+DEF_TEST(combined_regex) {
+  ignorelist_t *il = ignorelist_create(/* invert = */ 1);
+  CHECK_NOT_NULL(il);
+
+  /* Anchors and alternations must keep their meaning when combined. */
+  CHECK_ZERO(ignorelist_add(il, "/^a|b$/"));
+  CHECK_ZERO(ignorelist_add(il, "/^(x|y)z$/"));
+
+  EXPECT_EQ_INT(0, ignorelist_match(il, "abc"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "cab"));
+  EXPECT_EQ_INT(1, ignorelist_match(il, "cba"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "yz"));
+  EXPECT_EQ_INT(1, ignorelist_match(il, "xyz"));
+
+  /* Back-references can't be combined and are matched one by one. */
+  CHECK_ZERO(ignorelist_add(il, "/^(.)\\1$/"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "qq"));
+  EXPECT_EQ_INT(1, ignorelist_match(il, "qr"));
+  EXPECT_EQ_INT(0, ignorelist_match(il, "yz"));
+
+  ignorelist_free(il);
+  return 0;
+}
+
+DEF_TEST(many) {
+  ignorelist_t *il = ignorelist_create(/* invert = */ 0);
+  CHECK_NOT_NULL(il);
+
+  for (int i = 0; i < 500; i += 2) {
+    char name[32];
+    ssnprintf(name, sizeof(name), "veth%d", i);
+    CHECK_ZERO(ignorelist_add(il, name));
+  }
+  CHECK_ZERO(ignorelist_add(il, "/^tap/"));
+
+  /* More entries than the cache holds, matched several times. */
+  int failed = 0;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 500; i++) {
+      char name[32];
+      ssnprintf(name, sizeof(name), "veth%d", i);
+      if (ignorelist_match(il, name) != ((i % 2) == 0))
+        failed++;
+      ssnprintf(name, sizeof(name), "tap%d", i);
+      if (ignorelist_match(il, name) != 1)
+        failed++;
+    }
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  ignorelist_free(il);
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(match);
+  RUN_TEST(change);
+  RUN_TEST(combined_regex);
+  RUN_TEST(many);
+
+  END_TEST;
+}
@@ -0,0 +1,290 @@
+/**
+ * collectd - src/utils/key_trie/key_trie.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/key_trie/key_trie.h"
+
+struct key_trie_node_s {
+  /* Interned name of this node's path segment. */
+  char const *name;
+  size_t name_len;
+
+  void *value;
+
+  /* Sorted by name length first and by content second. */
+  key_trie_node_t **children;
+  size_t children_num;
+
+  key_trie_node_t *wildcard;
+};
+
+struct key_trie_s {
+  key_trie_node_t root;
+  char *wildcard;
+
+  /* Open addressing hash table of interned path segments. */
+  char **names;
+  size_t names_size; /* always a power of two */
+  size_t names_num;
+};
+
+static uint32_t key_trie_hash(char const *key, size_t key_len) /* {{{ */
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < key_len; i++) {
+    hash ^= (unsigned char)key[i];
+    hash *= 16777619u;
+  }
+  return hash;
+} /* }}} uint32_t key_trie_hash */
+
+/* Returns the slot of `key' in `names', or the empty slot where it would be
+ * stored. */
+static size_t key_trie_names_slot(char **names, size_t names_size, /* {{{ */
+                                  char const *key, size_t key_len) {
+  size_t mask = names_size - 1;
+  size_t i = key_trie_hash(key, key_len) & mask;
+
+  while (names[i] != NULL) {
+    if ((strncmp(names[i], key, key_len) == 0) && (names[i][key_len] == 0))
+      return i;
+    i = (i + 1) & mask;
+  }
+  return i;
+} /* }}} size_t key_trie_names_slot */
+
+static int key_trie_names_grow(key_trie_t *t) /* {{{ */
+{
+  size_t size = (t->names_size == 0) ? 64 : 2 * t->names_size;
+  char **names = calloc(size, sizeof(*names));
+  if (names == NULL)
+    return ENOMEM;
+
+  for (size_t i = 0; i < t->names_size; i++) {
+    if (t->names[i] == NULL)
+      continue;
+    size_t slot = key_trie_names_slot(names, size, t->names[i],
+                                      strlen(t->names[i]));
+    names[slot] = t->names[i];
+  }
+
+  free(t->names);
+  t->names = names;
+  t->names_size = size;
+  return 0;
+} /* }}} int key_trie_names_grow */
+
+/* Returns the interned copy of `key'. */
+static char const *key_trie_intern(key_trie_t *t, char const *key, /* {{{ */
+                                   size_t key_len) {
+  if ((2 * (t->names_num + 1)) > t->names_size) {
+    if (key_trie_names_grow(t) != 0)
+      return NULL;
+  }
+
+  size_t slot = key_trie_names_slot(t->names, t->names_size, key, key_len);
+  if (t->names[slot] != NULL)
+    return t->names[slot];
+
+  char *name = malloc(key_len + 1);
+  if (name == NULL)
+    return NULL;
+  memcpy(name, key, key_len);
+  name[key_len] = 0;
+
+  t->names[slot] = name;
+  t->names_num++;
+  return name;
+} /* }}} char const *key_trie_intern */
+
+static int key_trie_compare(key_trie_node_t const *n, /* {{{ */
+                            char const *key, size_t key_len) {
+  if (n->name_len != key_len)
+    return (n->name_len < key_len) ? -1 : 1;
+  return memcmp(n->name, key, key_len);
+} /* }}} int key_trie_compare */
+
+/* Binary search for `key' in the children of `node'. Returns true if found;
+ * `ret_index' is set to the child's index or to the position where it would
+ * have to be inserted. */
+static bool key_trie_find(key_trie_node_t const *node, /* {{{ */
+                          char const *key, size_t key_len, size_t *ret_index) {
+  size_t lo = 0;
+  size_t hi = node->children_num;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = key_trie_compare(node->children[mid], key, key_len);
+    if (cmp == 0) {
+      *ret_index = mid;
+      return true;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  *ret_index = lo;
+  return false;
+} /* }}} bool key_trie_find */
+
+static key_trie_node_t *key_trie_add_child(key_trie_t *t, /* {{{ */
+                                           key_trie_node_t *node,
+                                           char const *key, size_t key_len) {
+  size_t index;
+  if (key_trie_find(node, key, key_len, &index))
+    return node->children[index];
+
+  key_trie_node_t **children =
+      realloc(node->children, (node->children_num + 1) * sizeof(*children));
+  if (children == NULL)
+    return NULL;
+  node->children = children;
+
+  key_trie_node_t *child = calloc(1, sizeof(*child));
+  if (child == NULL)
+    return NULL;
+
+  child->name = key_trie_intern(t, key, key_len);
+  if (child->name == NULL) {
+    free(child);
+    return NULL;
+  }
+  child->name_len = key_len;
+
+  memmove(children + index + 1, children + index,
+          (node->children_num - index) * sizeof(*children));
+  children[index] = child;
+  node->children_num++;
+
+  if ((t->wildcard != NULL) && (strcmp(child->name, t->wildcard) == 0))
+    node->wildcard = child;
+
+  return child;
+} /* }}} key_trie_node_t *key_trie_add_child */
+
+static void key_trie_node_free(key_trie_node_t *node, /* {{{ */
+                               void (*free_value)(void *)) {
+  for (size_t i = 0; i < node->children_num; i++) {
+    key_trie_node_free(node->children[i], free_value);
+    free(node->children[i]);
+  }
+  free(node->children);
+
+  if ((free_value != NULL) && (node->value != NULL))
+    free_value(node->value);
+} /* }}} void key_trie_node_free */
+
+key_trie_t *key_trie_create(char const *wildcard) /* {{{ */
+{
+  key_trie_t *t = calloc(1, sizeof(*t));
+  if (t == NULL)
+    return NULL;
+
+  if (wildcard != NULL) {
+    t->wildcard = strdup(wildcard);
+    if (t->wildcard == NULL) {
+      free(t);
+      return NULL;
+    }
+  }
+
+  return t;
+} /* }}} key_trie_t *key_trie_create */
+
+void key_trie_destroy(key_trie_t *t, void (*free_value)(void *)) /* {{{ */
+{
+  if (t == NULL)
+    return;
+
+  key_trie_node_free(&t->root, free_value);
+
+  for (size_t i = 0; i < t->names_size; i++)
+    free(t->names[i]);
+  free(t->names);
+  free(t->wildcard);
+  free(t);
+} /* }}} void key_trie_destroy */
+
+int key_trie_insert(key_trie_t *t, char const *path, /* {{{ */
+                    char separator, void *value) {
+  if ((t == NULL) || (path == NULL))
+    return EINVAL;
+
+  key_trie_node_t *node = &t->root;
+  char const *start = path;
+  while (true) {
+    char const *end = strchr(start, separator);
+    size_t len = (end != NULL) ? (size_t)(end - start) : strlen(start);
+    if (len == 0)
+      return EINVAL;
+
+    node = key_trie_add_child(t, node, start, len);
+    if (node == NULL)
+      return ENOMEM;
+
+    if (end == NULL)
+      break;
+    start = end + 1;
+  }
+
+  if (node->value != NULL)
+    return EEXIST;
+  node->value = value;
+  return 0;
+} /* }}} int key_trie_insert */
+
+key_trie_node_t *key_trie_root(key_trie_t *t) /* {{{ */
+{
+  return (t != NULL) ? &t->root : NULL;
+} /* }}} key_trie_node_t *key_trie_root */
+
+key_trie_node_t *key_trie_child(key_trie_node_t const *node, /* {{{ */
+                                char const *key, size_t key_len) {
+  if (node == NULL)
+    return NULL;
+
+  size_t index;
+  if (key_trie_find(node, key, key_len, &index))
+    return node->children[index];
+
+  return node->wildcard;
+} /* }}} key_trie_node_t *key_trie_child */
+
+void *key_trie_value(key_trie_node_t const *node) /* {{{ */
+{
+  return (node != NULL) ? node->value : NULL;
+} /* }}} void *key_trie_value */
+
+bool key_trie_has_children(key_trie_node_t const *node) /* {{{ */
+{
+  return (node != NULL) && (node->children_num > 0);
+} /* }}} bool key_trie_has_children */
@@ -0,0 +1,137 @@
+/**
+ * collectd - src/utils/key_trie/key_trie.h
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef UTILS_KEY_TRIE_H
+#define UTILS_KEY_TRIE_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A key trie maps paths of keys, such as "httpd/requests/count", to values.
+ * It is meant for matching the keys of a JSON document (or any other
+ * hierarchical format) while it is being parsed: the parser keeps the node of
+ * the current map and looks up each key in it with `key_trie_child'. Keys
+ * that are not part of any configured path yield NULL, so the whole subtree
+ * below them can be skipped without building or comparing path strings.
+ *
+ * Path segments are interned, i.e. each distinct segment is stored once per
+ * trie, and the children of each node are kept sorted so lookups are a binary
+ * search that does not need a null-terminated key.
+ */
+
+struct key_trie_s;
+typedef struct key_trie_s key_trie_t;
+
+struct key_trie_node_s;
+typedef struct key_trie_node_s key_trie_node_t;
+
+/*
+ * NAME
+ *   key_trie_create
+ *
+ * DESCRIPTION
+ *   Allocates a new, empty trie.
+ *
+ * PARAMETERS
+ *   `wildcard'  Path segment that matches any key, for example "*". If a key
+ *               has no child of its own, `key_trie_child' returns the wildcard
+ *               child instead. May be NULL to disable wildcard matching.
+ *
+ * RETURN VALUE
+ *   A key_trie_t-pointer upon success or NULL upon failure.
+ */
+key_trie_t *key_trie_create(char const *wildcard);
+
+/*
+ * NAME
+ *   key_trie_destroy
+ *
+ * DESCRIPTION
+ *   Deallocates a trie. If `free_value' is not NULL, it is called for every
+ *   value stored in the trie.
+ */
+void key_trie_destroy(key_trie_t *t, void (*free_value)(void *));
+
+/*
+ * NAME
+ *   key_trie_insert
+ *
+ * DESCRIPTION
+ *   Stores `value' at `path'. The path is split into segments at every
+ *   occurrence of `separator'. Intermediate nodes are created as needed. A
+ *   node may have both a value and children.
+ *
+ * RETURN VALUE
+ *   Zero upon success, EINVAL if the path contains an empty segment, EEXIST if
+ *   a value is already stored at `path' and ENOMEM if memory allocation
+ *   failed.
+ */
+int key_trie_insert(key_trie_t *t, char const *path, char separator,
+                    void *value);
+
+/*
+ * NAME
+ *   key_trie_root
+ *
+ * DESCRIPTION
+ *   Returns the root node of the trie, i.e. the node representing the empty
+ *   path. Its children are the first segments of all paths.
+ */
+key_trie_node_t *key_trie_root(key_trie_t *t);
+
+/*
+ * NAME
+ *   key_trie_child
+ *
+ * DESCRIPTION
+ *   Looks up the child of `node' for `key'. The key does not have to be
+ *   null-terminated. If `node' has no child for `key', its wildcard child is
+ *   returned, if any.
+ *
+ * RETURN VALUE
+ *   The child node or NULL if `node' is NULL or no path continues with `key'.
+ */
+key_trie_node_t *key_trie_child(key_trie_node_t const *node, char const *key,
+                                size_t key_len);
+
+/*
+ * NAME
+ *   key_trie_value
+ *
+ * DESCRIPTION
+ *   Returns the value stored at `node' or NULL if `node' is NULL or only an
+ *   intermediate node.
+ */
+void *key_trie_value(key_trie_node_t const *node);
+
+/*
+ * NAME
+ *   key_trie_has_children
+ *
+ * DESCRIPTION
+ *   Returns true if any path continues below `node'.
+ */
+bool key_trie_has_children(key_trie_node_t const *node);
+
+#endif /* UTILS_KEY_TRIE_H */
@@ -0,0 +1,136 @@
+/**
+ * collectd - src/utils/key_trie/key_trie_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "testing.h"
+#include "utils/key_trie/key_trie.h"
+
+/* Looks up a "/" separated path one segment at a time. */
+static void *lookup(key_trie_t *t, char const *path) {
+  key_trie_node_t *node = key_trie_root(t);
+
+  while ((node != NULL) && (*path != 0)) {
+    char const *end = strchr(path, '/');
+    size_t len = (end != NULL) ? (size_t)(end - path) : strlen(path);
+
+    node = key_trie_child(node, path, len);
+    path += len;
+    if (*path == '/')
+      path++;
+  }
+
+  return key_trie_value(node);
+}
+
+static int free_count;
+static void count_free(__attribute__((unused)) void *value) { free_count++; }
+
+DEF_TEST(lookup) {
+  int values[] = {0, 1, 2, 3, 4, 5};
+  key_trie_t *t;
+
+  CHECK_NOT_NULL(t = key_trie_create("*"));
+  CHECK_ZERO(key_trie_insert(t, "httpd/requests/count", '/', &values[0]));
+  CHECK_ZERO(key_trie_insert(t, "httpd/requests/current", '/', &values[1]));
+  CHECK_ZERO(key_trie_insert(t, "httpd/*/total", '/', &values[2]));
+  CHECK_ZERO(key_trie_insert(t, "httpd", '/', &values[3]));
+  CHECK_ZERO(key_trie_insert(t, "0/1", '/', &values[4]));
+  EXPECT_EQ_INT(EEXIST, key_trie_insert(t, "httpd/requests/count", '/',
+                                        &values[5]));
+  EXPECT_EQ_INT(EINVAL, key_trie_insert(t, "httpd//count", '/', &values[5]));
+  EXPECT_EQ_INT(EINVAL, key_trie_insert(t, "httpd/", '/', &values[5]));
+
+  EXPECT_EQ_PTR(&values[0], lookup(t, "httpd/requests/count"));
+  EXPECT_EQ_PTR(&values[1], lookup(t, "httpd/requests/current"));
+  EXPECT_EQ_PTR(&values[2], lookup(t, "httpd/responses/total"));
+  EXPECT_EQ_PTR(&values[3], lookup(t, "httpd"));
+  EXPECT_EQ_PTR(&values[4], lookup(t, "0/1"));
+
+  /* The exact match takes precedence over the wildcard, which is not
+   * backtracked into. */
+  EXPECT_EQ_PTR(NULL, lookup(t, "httpd/requests/total"));
+  EXPECT_EQ_PTR(NULL, lookup(t, "httpd/requests"));
+  EXPECT_EQ_PTR(NULL, lookup(t, "httpd/requests/count/x"));
+  EXPECT_EQ_PTR(NULL, lookup(t, "httpdx"));
+  EXPECT_EQ_PTR(NULL, lookup(t, "0/10"));
+
+  /* Keys do not have to be null-terminated. */
+  key_trie_node_t *node = key_trie_child(key_trie_root(t), "httpd/x", 5);
+  OK(key_trie_has_children(node));
+  EXPECT_EQ_PTR(&values[3], key_trie_value(node));
+  node = key_trie_child(node, "requests", 8);
+  OK(key_trie_has_children(node));
+  OK(!key_trie_has_children(key_trie_child(node, "count", 5)));
+
+  free_count = 0;
+  key_trie_destroy(t, count_free);
+  EXPECT_EQ_INT(5, free_count);
+
+  return 0;
+}
+
+DEF_TEST(no_wildcard) {
+  int value = 42;
+  key_trie_t *t;
+
+  CHECK_NOT_NULL(t = key_trie_create(NULL));
+  CHECK_ZERO(key_trie_insert(t, "osd.*", '.', &value));
+
+  OK(key_trie_value(key_trie_child(key_trie_child(key_trie_root(t), "osd", 3),
+                                   "op_r", 4)) == NULL);
+  OK(key_trie_value(key_trie_child(key_trie_child(key_trie_root(t), "osd", 3),
+                                   "*", 1)) == &value);
+
+  key_trie_destroy(t, NULL);
+  return 0;
+}
+
+DEF_TEST(many) {
+  key_trie_t *t;
+  static int values[1000];
+
+  CHECK_NOT_NULL(t = key_trie_create(NULL));
+  for (int i = 0; i < 1000; i++) {
+    char path[64];
+    snprintf(path, sizeof(path), "section%d/counter%d/sum", i % 7, i);
+    CHECK_ZERO(key_trie_insert(t, path, '/', &values[i]));
+  }
+
+  for (int i = 999; i >= 0; i--) {
+    char path[64];
+    snprintf(path, sizeof(path), "section%d/counter%d/sum", i % 7, i);
+    EXPECT_EQ_PTR(&values[i], lookup(t, path));
+  }
+
+  key_trie_destroy(t, NULL);
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(lookup);
+  RUN_TEST(no_wildcard);
+  RUN_TEST(many);
+
+  END_TEST;
+}
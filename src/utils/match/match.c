@@ -41,6 +41,9 @@ struct cu_match_s {
   regex_t excluderegex;
   int flags;
 
+  /* String every matching line contains, used for prefiltering. May be NULL. */
+  char *literal;
+
   int (*callback)(const char *str, char *const *matches, size_t matches_num,
                   void *user_data);
   void *user_data;
@@ -72,6 +75,124 @@ static char *match_substr(const char *str, int begin, int end) {
   return ret;
 } /* char *match_substr */
 
+/* Skips the bracket expression starting at `p' and returns a pointer to its
+ * closing bracket, or NULL if the expression is not terminated. */
+static const char *match_skip_bracket(const char *p) {
+  p++;
+  if (*p == '^')
+    p++;
+  if (*p == ']')
+    p++;
+
+  while (*p != ']') {
+    if (*p == 0)
+      return NULL;
+
+    /* Character classes, collating symbols and equivalence classes, e.g.
+     * "[:digit:]", may contain a closing bracket of their own. */
+    if ((p[0] == '[') && ((p[1] == ':') || (p[1] == '.') || (p[1] == '='))) {
+      char delim = p[1];
+      p += 2;
+      while ((p[0] != 0) && !((p[0] == delim) && (p[1] == ']')))
+        p++;
+      if (*p == 0)
+        return NULL;
+      p += 2;
+      continue;
+    }
+    p++;
+  }
+
+  return p;
+} /* const char *match_skip_bracket */
+
+/* Returns the longest string that every line matched by the extended regular
+ * expression `regex' has to contain, or NULL if none could be determined. The
+ * analysis is conservative: groups, bracket expressions, anchors, escape
+ * sequences with a special meaning and quantified characters end a literal,
+ * and an alternation outside of a group means there is none. */
+static char *match_required_literal(const char *regex) {
+  size_t regex_len = strlen(regex);
+  char *cur = calloc(1, regex_len + 1);
+  char *best = calloc(1, regex_len + 1);
+  size_t cur_len = 0;
+  size_t best_len = 0;
+  int depth = 0;
+
+  if ((cur == NULL) || (best == NULL))
+    goto fail;
+
+  for (const char *p = regex; *p != 0; p++) {
+    char c = *p;
+    bool literal = false;
+
+    if (c == '\\') {
+      c = *(++p);
+      if (c == 0)
+        break;
+      if (c == '|')
+        goto fail;
+      literal = ispunct((unsigned char)c) && (strchr("<>`'", c) == NULL);
+    } else if (c == '|') {
+      if (depth == 0)
+        goto fail;
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')') {
+      if (depth > 0)
+        depth--;
+    } else if (c == '[') {
+      p = match_skip_bracket(p);
+      if (p == NULL)
+        goto fail;
+    } else if ((c == '*') || (c == '?') || (c == '{')) {
+      /* The preceding character is optional. Multibyte characters are dropped
+       * together with the rest of the literal. */
+      if ((cur_len > 0) && ((unsigned char)cur[cur_len - 1] < 0x80))
+        cur_len--;
+      else
+        cur_len = 0;
+
+      if (c == '{') {
+        while (isdigit((unsigned char)p[1]) || (p[1] == ','))
+          p++;
+        if (p[1] == '}')
+          p++;
+      }
+    } else if ((c != '.') && (c != '^') && (c != '$') && (c != '+')) {
+      literal = true;
+    }
+
+    if (literal) {
+      if (depth == 0)
+        cur[cur_len++] = c;
+      continue;
+    }
+
+    if (cur_len > best_len) {
+      memcpy(best, cur, cur_len);
+      best_len = cur_len;
+    }
+    cur_len = 0;
+  }
+
+  if (cur_len > best_len) {
+    memcpy(best, cur, cur_len);
+    best_len = cur_len;
+  }
+  if (best_len == 0)
+    goto fail;
+
+  sfree(cur);
+  best[best_len] = 0;
+  return best;
+
+fail:
+  sfree(cur);
+  sfree(best);
+  return NULL;
+} /* char *match_required_literal */
+
 static int default_callback(const char __attribute__((unused)) * str,
                             char *const *matches, size_t matches_num,
                             void *user_data) {
@@ -237,11 +358,16 @@ match_create_callback(const char *regex, const char *excluderegex,
   }
   obj->flags |= UTILS_MATCH_FLAGS_REGEX;
 
+  /* A failure is not fatal, the literal is an optimization only. */
+  obj->literal = match_required_literal(regex);
+
   if (excluderegex && strcmp(excluderegex, "") != 0) {
     status = regcomp(&obj->excluderegex, excluderegex, REG_EXTENDED);
     if (status != 0) {
       ERROR("Compiling the excluding regular expression \"%s\" failed.",
             excluderegex);
+      regfree(&obj->regex);
+      sfree(obj->literal);
       sfree(obj);
       return NULL;
     }
@@ -307,6 +433,7 @@ void match_destroy(cu_match_t *obj) {
     regfree(&obj->regex);
   if (obj->flags & UTILS_MATCH_FLAGS_EXCLUDE_REGEX)
     regfree(&obj->excluderegex);
+  sfree(obj->literal);
   if ((obj->user_data != NULL) && (obj->free != NULL))
     (*obj->free)(obj->user_data);
 
@@ -374,3 +501,9 @@ void *match_get_user_data(cu_match_t *obj) {
     return NULL;
   return obj->user_data;
 } /* void *match_get_user_data */
+
+const char *match_get_literal(cu_match_t *obj) {
+  if (obj == NULL)
+    return NULL;
+  return obj->literal;
+} /* const char *match_get_literal */
@@ -176,4 +176,16 @@ int match_apply(cu_match_t *obj, const char *str);
  */
 void *match_get_user_data(cu_match_t *obj);
 
+/*
+ * NAME
+ *  match_get_literal
+ *
+ * DESCRIPTION
+ *  Returns a string that is contained in every string matched by the regular
+ *  expression of `obj', or NULL if no such string is known. Callers applying
+ *  many matches to the same string may use this to skip matches that cannot
+ *  match. The string is owned by `obj'.
+ */
+const char *match_get_literal(cu_match_t *obj);
+
 #endif /* UTILS_MATCH_H */
@@ -0,0 +1,122 @@
+/**
+ * collectd - src/utils/match/match_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "testing.h"
+#include "utils/common/common.h"
+#include "utils/match/match.h"
+
+#include <regex.h>
+
+DEF_TEST(literal) {
+  struct {
+    char const *regex;
+    char const *want;
+  } cases[] = {
+      {"S=([1-9][0-9]*)", "S="},
+      {"^status: (ok|fail)$", "status: "},
+      {"GET /index\\.html HTTP", "GET /index.html HTTP"},
+      {"abc*def", "def"},
+      {"abcd?ef", "abc"},
+      {"ab+cd", "ab"},
+      {"x{2,3}yz", "yz"},
+      {"user=[^ ]+ took ([0-9]+)ms", " took "},
+      {"[[:space:]]]*foo", "foo"},
+      {"a\\bcdef", "cdef"},
+      {"(foo)?bar", "bar"},
+      {"foo|bar", NULL},
+      {"foo\\|bar", NULL},
+      {"(a|b)", NULL},
+      {"[0-9]+", NULL},
+      {".*", NULL},
+      {"\xc3\xa4*x", "x"},
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    cu_match_t *m;
+
+    printf("## Case %zu: %s\n", i, cases[i].regex);
+    CHECK_NOT_NULL(m = match_create_simple(
+                       cases[i].regex, NULL,
+                       UTILS_MATCH_DS_TYPE_COUNTER | UTILS_MATCH_CF_COUNTER_INC));
+    if (cases[i].want == NULL)
+      OK(match_get_literal(m) == NULL);
+    else
+      EXPECT_EQ_STR(cases[i].want, match_get_literal(m));
+    match_destroy(m);
+  }
+
+  return 0;
+}
+
+DEF_TEST(literal_is_required) {
+  char const *regexes[] = {
+      "S=([1-9][0-9]*)", "a*b?c+d", "(x)y{0}z", "Connection (from|to) host",
+      "y?z$",
+  };
+  char const *lines[] = {
+      "S=12",  "S=",   "bcd",  "acdd", "yz",   "xyz", "Connection from host",
+      "Connection to host",  "",  "cd",
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(regexes); i++) {
+    cu_match_value_t *mv;
+    cu_match_t *m;
+    regex_t re;
+    uint64_t want = 0;
+
+    CHECK_NOT_NULL(m = match_create_simple(
+                       regexes[i], NULL,
+                       UTILS_MATCH_DS_TYPE_COUNTER | UTILS_MATCH_CF_COUNTER_INC));
+    CHECK_ZERO(regcomp(&re, regexes[i], REG_EXTENDED | REG_NEWLINE));
+    mv = match_get_user_data(m);
+    char const *literal = match_get_literal(m);
+
+    printf("## %s: literal \"%s\"\n", regexes[i],
+           (literal != NULL) ? literal : "");
+    for (size_t j = 0; j < STATIC_ARRAY_SIZE(lines); j++) {
+      CHECK_ZERO(match_apply(m, lines[j]));
+      if (regexec(&re, lines[j], 0, NULL, 0) != 0)
+        continue;
+
+      /* Every matching line contains the literal. */
+      want++;
+      if (literal != NULL)
+        OK(strstr(lines[j], literal) != NULL);
+    }
+    EXPECT_EQ_UINT64(want, mv->value.counter);
+
+    regfree(&re);
+    match_destroy(m);
+  }
+
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(literal);
+  RUN_TEST(literal_is_required);
+
+  END_TEST;
+}
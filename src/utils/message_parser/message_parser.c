@@ -285,6 +285,15 @@ free_parser_job:
   return NULL;
 }
 
+int message_parser_follow(parser_job_data_t *parser_job) {
+  if (parser_job == NULL) {
+    ERROR(UTIL_NAME ": Invalid parser_job pointer");
+    return -1;
+  }
+
+  return tail_match_follow(parser_job->tm);
+}
+
 int message_parser_read(parser_job_data_t *parser_job,
                         message_t **messages_storage, bool force_rewind) {
   if (parser_job == NULL) {
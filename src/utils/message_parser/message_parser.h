@@ -114,6 +114,22 @@ parser_job_data_t *message_parser_init(const char *filename,
                                        message_pattern_t message_patterns[],
                                        size_t message_patterns_len);
 
+/*
+ * NAME
+ *   message_parser_follow
+ *
+ * DESCRIPTION
+ *   Reads the parsed file ahead as data is appended to it, see
+ *   `cu_tail_follow'. Messages are still collected by `message_parser_read'.
+ *
+ * PARAMETERS
+ *   `parser_job' Pointer to parser job.
+ *
+ * RETURN VALUE
+ *   Returns zero upon success, non-zero otherwise.
+ */
+int message_parser_follow(parser_job_data_t *parser_job);
+
 /*
  * NAME
  *   message_parser_read
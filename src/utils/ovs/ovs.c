@@ -90,6 +90,7 @@
 #endif
 
 #include <semaphore.h>
+#include <yajl/yajl_parse.h>
 
 #define OVS_ERROR(fmt, ...)                                                    \
   do {                                                                         \
@@ -122,23 +123,31 @@
     if ((yajl_gen_ret = func(__VA_ARGS__)) != yajl_gen_status_ok)              \
       goto yajl_gen_failure;                                                   \
   } while (0)
-#define OVS_YAJL_ERROR_BUFFER_SIZE 1024
 #define OVS_ERROR_BUFF_SIZE 512
 #define OVS_UID_STR_SIZE 17 /* 64-bit HEX string len + '\0' */
-
-/* JSON reader internal data */
-struct ovs_json_reader_s {
-  char *buff_ptr;
-  size_t buff_size;
-  size_t buff_offset;
-  size_t json_offset;
+#define OVS_JSON_MAX_DEPTH 32 /* max nesting level of JSON-RPC message */
+
+/* JSON parser internal data */
+struct ovs_json_parser_s {
+  ovs_db_t *pdb;
+  yajl_handle handle;
+  /* JSON containers (objects/arrays) being parsed */
+  yajl_val stack[OVS_JSON_MAX_DEPTH];
+  size_t depth;
+  /* JSON-RPC message being parsed */
+  yajl_val root;
+  const char *method;
+  uint64_t table_uid;  /* UID of table update callback ("params"[0]) */
+  uint64_t result_uid; /* UID of result callback ("id") */
+  bool rows_streamed;  /* row updates already passed to the callback */
 };
-typedef struct ovs_json_reader_s ovs_json_reader_t;
+typedef struct ovs_json_parser_s ovs_json_parser_t;
 
 /* Result callback declaration */
 struct ovs_result_cb_s {
   sem_t sync;
   ovs_db_result_cb_t call;
+  bool stream_rows; /* result is <table-updates>, pass it row by row */
 };
 typedef struct ovs_result_cb_s ovs_result_cb_t;
 
@@ -459,8 +468,11 @@ static ovs_callback_t *ovs_db_table_callback_get(ovs_db_t *pdb, yajl_val jid) {
  * This callback is called by POLL thread if OVS DB
  * table update callback is received from the DB
  * server. Once registered callback found, it's called
- * by this handler. */
-static int ovs_db_table_update_cb(ovs_db_t *pdb, yajl_val jnode) {
+ * by this handler. If the row updates have been already
+ * passed to the callback while parsing the request
+ * (`rows_streamed'), only the request is verified. */
+static int ovs_db_table_update_cb(ovs_db_t *pdb, yajl_val jnode,
+                                  bool rows_streamed) {
   ovs_callback_t *cb = NULL;
   yajl_val jvalue;
   yajl_val jparams;
@@ -489,6 +501,9 @@ static int ovs_db_table_update_cb(ovs_db_t *pdb, yajl_val jnode) {
     return -1;
   }
 
+  if (rows_streamed)
+    return 0;
+
   /* find registered callback based on <json-value> */
   pthread_mutex_lock(&pdb->mutex);
   cb = ovs_db_table_callback_get(pdb, jvalue);
@@ -508,8 +523,12 @@ static int ovs_db_table_update_cb(ovs_db_t *pdb, yajl_val jnode) {
  * This callback is called by POLL thread if OVS DB
  * result reply is received from the DB server.
  * Once registered callback found, it's called
- * by this handler. */
-static int ovs_db_result_cb(ovs_db_t *pdb, yajl_val jnode) {
+ * by this handler. If the result rows have been
+ * already passed to the callback while parsing the
+ * reply (`rows_streamed'), only the owner of the
+ * reply is unlocked. */
+static int ovs_db_result_cb(ovs_db_t *pdb, yajl_val jnode,
+                            bool rows_streamed) {
   ovs_callback_t *cb = NULL;
   yajl_val jresult;
   yajl_val jerror;
@@ -531,7 +550,8 @@ static int ovs_db_result_cb(ovs_db_t *pdb, yajl_val jnode) {
   cb = ovs_db_table_callback_get(pdb, jid);
   if (cb != NULL && cb->result.call != NULL) {
     /* call registered callback */
-    cb->result.call(jresult, jerror);
+    if (!rows_streamed)
+      cb->result.call(jresult, jerror);
     /* unlock owner of the reply */
     sem_post(&cb->result.sync);
   }
@@ -545,167 +565,455 @@ static int ovs_db_result_cb(ovs_db_t *pdb, yajl_val jnode) {
  * update callback 'ovs_db_table_update_cb' and
  * result callback 'ovs_db_result_cb' is supported.
  */
-static int ovs_db_json_data_process(ovs_db_t *pdb, const char *data,
-                                    size_t len) {
+static int ovs_db_json_data_process(ovs_db_t *pdb, yajl_val jnode,
+                                    bool rows_streamed) {
   const char *method = NULL;
-  char yajl_errbuf[OVS_YAJL_ERROR_BUFFER_SIZE];
   const char *method_path[] = {"method", NULL};
   const char *result_path[] = {"result", NULL};
-  char *sjson = NULL;
-  yajl_val jnode, jval;
-
-  /* duplicate the data to make null-terminated string
-   * required for yajl_tree_parse() */
-  if ((sjson = calloc(1, len + 1)) == NULL)
-    return -1;
-
-  sstrncpy(sjson, data, len + 1);
-  OVS_DEBUG("[len=%" PRIsz "] %s", len, sjson);
-
-  /* parse json data */
-  jnode = yajl_tree_parse(sjson, yajl_errbuf, sizeof(yajl_errbuf));
-  if (jnode == NULL) {
-    OVS_ERROR("yajl_tree_parse() %s", yajl_errbuf);
-    sfree(sjson);
-    return -1;
-  }
+  yajl_val jval;
 
   /* get method name */
   if ((jval = yajl_tree_get(jnode, method_path, yajl_t_string)) != NULL) {
-    if ((method = YAJL_GET_STRING(jval)) == NULL) {
-      yajl_tree_free(jnode);
-      sfree(sjson);
+    if ((method = YAJL_GET_STRING(jval)) == NULL)
       return -1;
-    }
     if (strcmp("echo", method) == 0) {
       /* echo request from the server */
       if (ovs_db_table_echo_cb(pdb, jnode) < 0)
         OVS_ERROR("handle echo request failed");
     } else if (strcmp("update", method) == 0) {
       /* update notification */
-      if (ovs_db_table_update_cb(pdb, jnode) < 0)
+      if (ovs_db_table_update_cb(pdb, jnode, rows_streamed) < 0)
         OVS_ERROR("handle update notification failed");
     }
   } else if ((jval = yajl_tree_get(jnode, result_path, yajl_t_any)) != NULL) {
     /* result notification */
-    if (ovs_db_result_cb(pdb, jnode) < 0)
+    if (ovs_db_result_cb(pdb, jnode, rows_streamed) < 0)
       OVS_ERROR("handle result reply failed");
   } else
     OVS_ERROR("connot find method or result failed");
 
-  /* release memory */
-  yajl_tree_free(jnode);
-  sfree(sjson);
   return 0;
 }
 
 /*
- * JSON reader implementation.
+ * JSON parser implementation.
  *
- * This module process raw JSON data (byte stream) and
- * returns fully-fledged JSON data which can be processed
- * (parsed) by YAJL later.
+ * This module parses raw JSON data (byte stream) incrementally
+ * as soon as it is received and builds YAJL tree of each
+ * JSON-RPC message. The <row-update>s of the table update
+ * notifications and of the monitor replies are not kept in
+ * the tree: every row is passed to the registered callback
+ * as a single row <table-updates> right after it has been
+ * parsed, and released afterwards. So, the memory used to
+ * handle huge table dumps is bounded by the size of one row.
  */
 
-/* Allocate JSON reader instance */
-static ovs_json_reader_t *ovs_json_reader_alloc() {
-  ovs_json_reader_t *jreader = calloc(1, sizeof(*jreader));
-  if (jreader == NULL)
+/* JSON null passed as an error of the streamed result */
+static struct yajl_val_s ovs_yajl_null = {.type = yajl_t_null};
+
+/* Get the last key of the JSON object being parsed */
+static const char *ovs_json_parser_last_key(yajl_val jobj) {
+  if (!YAJL_IS_OBJECT(jobj) || jobj->u.object.len == 0)
     return NULL;
+  return jobj->u.object.keys[jobj->u.object.len - 1];
+}
+
+/* Check if the value being parsed belongs to given
+ * member of the JSON-RPC message */
+static bool ovs_json_parser_in_member(const ovs_json_parser_t *jparser,
+                                      const char *name) {
+  const char *key;
 
-  return jreader;
+  if (jparser->depth == 0)
+    return false;
+
+  key = ovs_json_parser_last_key(jparser->stack[0]);
+  return (key != NULL) && (strcmp(key, name) == 0);
 }
 
-/* Push raw data into into the JSON reader for processing */
-static int ovs_json_reader_push_data(ovs_json_reader_t *jreader,
-                                     const char *data, size_t data_len) {
-  char *new_buff = NULL;
-  size_t available = jreader->buff_size - jreader->buff_offset;
+/* Get UID of the registered callback the row updates can be
+ * streamed to. The `jid' should be YAJL string (UID).
+ * Returns zero if callback hasn't been found. */
+static uint64_t ovs_json_parser_stream_uid(ovs_db_t *pdb, yajl_val jid,
+                                           bool result) {
+  ovs_callback_t *cb = NULL;
+  uint64_t uid = 0;
+
+  pthread_mutex_lock(&pdb->mutex);
+  cb = ovs_db_table_callback_get(pdb, jid);
+  if (cb != NULL) {
+    if (result && cb->result.stream_rows && cb->result.call != NULL)
+      uid = cb->uid;
+    else if (!result && cb->table.call != NULL)
+      uid = cb->uid;
+  }
+  pthread_mutex_unlock(&pdb->mutex);
+  return uid;
+}
 
-  /* check/update required memory space */
-  if (available < data_len) {
-    OVS_DEBUG("Reallocate buffer [size=%d, available=%d required=%d]",
-              (int)jreader->buff_size, (int)available, (int)data_len);
+/* Check if the JSON container being closed is a <row-update>
+ * which should be streamed, i.e.:
+ *   {"params": [<json-value>, {<table>: {<uuid>: <row-update>}}], ...}
+ * or:
+ *   {"result": {<table>: {<uuid>: <row-update>}}, ...}
+ */
+static bool ovs_json_parser_row_ready(const ovs_json_parser_t *jparser) {
+  const yajl_val *stack = jparser->stack;
 
-    /* allocate new chunk of memory */
-    new_buff = realloc(jreader->buff_ptr, (jreader->buff_size + data_len));
-    if (new_buff == NULL)
-      return -1;
+  if (!YAJL_IS_OBJECT(stack[jparser->depth - 1]))
+    return false;
+
+  if (jparser->table_uid != 0 && jparser->depth == 5)
+    return ovs_json_parser_in_member(jparser, "params") &&
+           YAJL_IS_ARRAY(stack[1]) && (stack[1]->u.array.len == 2) &&
+           YAJL_IS_OBJECT(stack[2]) && YAJL_IS_OBJECT(stack[3]);
+
+  if (jparser->result_uid != 0 && jparser->depth == 4)
+    return ovs_json_parser_in_member(jparser, "result") &&
+           YAJL_IS_OBJECT(stack[1]) && YAJL_IS_OBJECT(stack[2]);
 
-    /* point to new allocated memory */
-    jreader->buff_ptr = new_buff;
-    jreader->buff_size += data_len;
+  return false;
+}
+
+/* Pass the <row-update> being closed to the registered callback
+ * and remove it from the YAJL tree */
+static void ovs_json_parser_row_dispatch(ovs_json_parser_t *jparser) {
+  ovs_db_t *pdb = jparser->pdb;
+  ovs_callback_t *cb = NULL;
+  yajl_val jtable_updates = jparser->stack[jparser->depth - 3];
+  yajl_val jtable = jparser->stack[jparser->depth - 2];
+  size_t row = jtable->u.object.len - 1;
+  const char *table_name = ovs_json_parser_last_key(jtable_updates);
+
+  /* single row <table-update>: {<uuid>: <row-update>} */
+  struct yajl_val_s jrow_update = {.type = yajl_t_object};
+  yajl_val jrow_update_ptr = &jrow_update;
+  jrow_update.u.object.keys = &jtable->u.object.keys[row];
+  jrow_update.u.object.values = &jtable->u.object.values[row];
+  jrow_update.u.object.len = 1;
+
+  /* single row <table-updates>: {<table>: <table-update>} */
+  struct yajl_val_s jrow_updates = {.type = yajl_t_object};
+  jrow_updates.u.object.keys = &table_name;
+  jrow_updates.u.object.values = &jrow_update_ptr;
+  jrow_updates.u.object.len = 1;
+
+  pthread_mutex_lock(&pdb->mutex);
+  if (jparser->table_uid != 0) {
+    cb = ovs_db_callback_get(pdb, jparser->table_uid);
+    if (cb != NULL && cb->table.call != NULL)
+      cb->table.call(&jrow_updates);
+  } else {
+    cb = ovs_db_callback_get(pdb, jparser->result_uid);
+    if (cb != NULL && cb->result.call != NULL)
+      cb->result.call(&jrow_updates, &ovs_yajl_null);
   }
+  pthread_mutex_unlock(&pdb->mutex);
+
+  /* the row is not needed anymore */
+  yajl_tree_free(jtable->u.object.values[row]);
+  free((char *)jtable->u.object.keys[row]);
+  jtable->u.object.len = row;
+  jparser->rows_streamed = true;
+}
 
-  /* store input data */
-  memcpy(jreader->buff_ptr + jreader->buff_offset, data, data_len);
-  jreader->buff_offset += data_len;
+/* Release JSON-RPC message being parsed */
+static void ovs_json_parser_msg_reset(ovs_json_parser_t *jparser) {
+  yajl_tree_free(jparser->root);
+  jparser->root = NULL;
+  jparser->depth = 0;
+  jparser->method = NULL;
+  jparser->table_uid = 0;
+  jparser->result_uid = 0;
+  jparser->rows_streamed = false;
+}
+
+/* Add parsed JSON value into the JSON container being parsed.
+ * The value is released on failure */
+static int ovs_json_parser_value_add(ovs_json_parser_t *jparser,
+                                     yajl_val jval) {
+  yajl_val jparent = jparser->stack[jparser->depth - 1];
+
+  if (YAJL_IS_OBJECT(jparent)) {
+    /* the key has been already added by map key handler */
+    jparent->u.object.values[jparent->u.object.len - 1] = jval;
+    return 0;
+  }
+
+  yajl_val *values = realloc(jparent->u.array.values,
+                             sizeof(*values) * (jparent->u.array.len + 1));
+  if (values == NULL) {
+    yajl_tree_free(jval);
+    return -1;
+  }
+  jparent->u.array.values = values;
+  values[jparent->u.array.len++] = jval;
   return 0;
 }
 
-/* Pop one fully-fledged JSON if already exists. Returns 0 if
- * completed JSON already exists otherwise negative value is
- * returned */
-static int ovs_json_reader_pop(ovs_json_reader_t *jreader,
-                               const char **json_ptr, size_t *json_len_ptr) {
-  size_t nbraces = 0;
-  size_t json_len = 0;
-  char *json = NULL;
-
-  /* search open/close brace */
-  for (size_t i = jreader->json_offset; i < jreader->buff_offset; i++) {
-    if (jreader->buff_ptr[i] == '{') {
-      nbraces++;
-    } else if (jreader->buff_ptr[i] == '}')
-      if (nbraces)
-        if (!(--nbraces)) {
-          /* JSON data */
-          *json_ptr = jreader->buff_ptr + jreader->json_offset;
-          *json_len_ptr = json_len + 1;
-          jreader->json_offset = i + 1;
-          return 0;
-        }
+/* Add parsed JSON scalar value and check if it
+ * identifies the rows which can be streamed */
+static int ovs_json_parser_scalar_add(ovs_json_parser_t *jparser,
+                                      yajl_val jval) {
+  const yajl_val *stack = jparser->stack;
 
-    /* increase JSON data length */
-    if (nbraces)
-      json_len++;
+  if (jval == NULL)
+    return 0;
+
+  if (jparser->depth == 0) {
+    /* not a JSON-RPC message, ignore it */
+    yajl_tree_free(jval);
+    return 1;
   }
 
-  if (jreader->json_offset) {
-    if (jreader->json_offset < jreader->buff_offset) {
-      /* shift data to the beginning of the buffer
-       * and zero rest of the buffer data */
-      json = &jreader->buff_ptr[jreader->json_offset];
-      json_len = jreader->buff_offset - jreader->json_offset;
-      for (size_t i = 0; i < jreader->buff_size; i++)
-        jreader->buff_ptr[i] = ((i < json_len) ? (json[i]) : (0));
-      jreader->buff_offset = json_len;
-    } else
-      /* reset the buffer */
-      jreader->buff_offset = 0;
-
-    /* data is at the beginning of the buffer */
-    jreader->json_offset = 0;
+  if (ovs_json_parser_value_add(jparser, jval) < 0)
+    return 0;
+
+  if (!YAJL_IS_STRING(jval) || jparser->rows_streamed)
+    return 1;
+
+  if (jparser->depth == 1) {
+    if (ovs_json_parser_in_member(jparser, "method")) {
+      jparser->method = YAJL_GET_STRING(jval);
+      if (strcmp("update", jparser->method) != 0)
+        jparser->table_uid = 0;
+    } else if (ovs_json_parser_in_member(jparser, "id"))
+      jparser->result_uid = ovs_json_parser_stream_uid(jparser->pdb, jval, true);
+  } else if (jparser->depth == 2 &&
+             ovs_json_parser_in_member(jparser, "params") &&
+             YAJL_IS_ARRAY(stack[1]) && (stack[1]->u.array.len == 1)) {
+    /* <json-value> of the update notification */
+    if (jparser->method == NULL || strcmp("update", jparser->method) == 0)
+      jparser->table_uid = ovs_json_parser_stream_uid(jparser->pdb, jval, false);
   }
+  return 1;
+}
 
-  return -1;
+/* Allocate new YAJL value */
+static yajl_val ovs_json_parser_value_alloc(yajl_type type) {
+  yajl_val jval = calloc(1, sizeof(*jval));
+  if (jval == NULL)
+    return NULL;
+
+  jval->type = type;
+  return jval;
+}
+
+/* Start new JSON container (object or array) */
+static int ovs_json_parser_container_open(ovs_json_parser_t *jparser,
+                                          yajl_type type) {
+  yajl_val jval;
+
+  if (jparser->depth >= OVS_JSON_MAX_DEPTH) {
+    OVS_ERROR("JSON data nesting level exceeds %d", OVS_JSON_MAX_DEPTH);
+    return 0;
+  }
+
+  if ((jval = ovs_json_parser_value_alloc(type)) == NULL)
+    return 0;
+
+  if (jparser->depth == 0)
+    jparser->root = jval;
+  else if (ovs_json_parser_value_add(jparser, jval) < 0)
+    return 0;
+
+  jparser->stack[jparser->depth++] = jval;
+  return 1;
+}
+
+/*
+ * YAJL parser callbacks
+ */
+static int ovs_json_parser_null_cb(void *ctx) {
+  return ovs_json_parser_scalar_add(ctx,
+                                    ovs_json_parser_value_alloc(yajl_t_null));
+}
+
+static int ovs_json_parser_boolean_cb(void *ctx, int value) {
+  return ovs_json_parser_scalar_add(
+      ctx, ovs_json_parser_value_alloc(value ? yajl_t_true : yajl_t_false));
 }
 
-/* Reset JSON reader. It is useful when start processing
+static int ovs_json_parser_number_cb(void *ctx, const char *number,
+                                     size_t number_len) {
+  yajl_val jval;
+  char *endptr = NULL;
+
+  if ((jval = ovs_json_parser_value_alloc(yajl_t_number)) == NULL)
+    return 0;
+
+  if ((jval->u.number.r = malloc(number_len + 1)) == NULL) {
+    free(jval);
+    return 0;
+  }
+  memcpy(jval->u.number.r, number, number_len);
+  jval->u.number.r[number_len] = '\0';
+
+  errno = 0;
+  jval->u.number.i = strtoll(jval->u.number.r, &endptr, 10);
+  if (errno == 0 && *endptr == '\0')
+    jval->u.number.flags |= YAJL_NUMBER_INT_VALID;
+
+  errno = 0;
+  jval->u.number.d = strtod(jval->u.number.r, &endptr);
+  if (errno == 0 && *endptr == '\0')
+    jval->u.number.flags |= YAJL_NUMBER_DOUBLE_VALID;
+
+  return ovs_json_parser_scalar_add(ctx, jval);
+}
+
+static int ovs_json_parser_string_cb(void *ctx, const unsigned char *str,
+                                     size_t str_len) {
+  yajl_val jval;
+
+  if ((jval = ovs_json_parser_value_alloc(yajl_t_string)) == NULL)
+    return 0;
+
+  if ((jval->u.string = malloc(str_len + 1)) == NULL) {
+    free(jval);
+    return 0;
+  }
+  memcpy(jval->u.string, str, str_len);
+  jval->u.string[str_len] = '\0';
+
+  return ovs_json_parser_scalar_add(ctx, jval);
+}
+
+static int ovs_json_parser_start_map_cb(void *ctx) {
+  return ovs_json_parser_container_open(ctx, yajl_t_object);
+}
+
+static int ovs_json_parser_map_key_cb(void *ctx, const unsigned char *key,
+                                      size_t key_len) {
+  ovs_json_parser_t *jparser = ctx;
+  yajl_val jobj = jparser->stack[jparser->depth - 1];
+  size_t len = jobj->u.object.len;
+  char *skey = NULL;
+
+  if ((skey = malloc(key_len + 1)) == NULL)
+    return 0;
+  memcpy(skey, key, key_len);
+  skey[key_len] = '\0';
+
+  const char **keys =
+      realloc(jobj->u.object.keys, sizeof(*keys) * (len + 1));
+  if (keys == NULL) {
+    free(skey);
+    return 0;
+  }
+  jobj->u.object.keys = keys;
+
+  yajl_val *values = realloc(jobj->u.object.values, sizeof(*values) * (len + 1));
+  if (values == NULL) {
+    free(skey);
+    return 0;
+  }
+  jobj->u.object.values = values;
+
+  /* the value is set once it has been parsed */
+  keys[len] = skey;
+  values[len] = NULL;
+  jobj->u.object.len++;
+  return 1;
+}
+
+static int ovs_json_parser_end_container_cb(void *ctx) {
+  ovs_json_parser_t *jparser = ctx;
+
+  if (ovs_json_parser_row_ready(jparser))
+    ovs_json_parser_row_dispatch(jparser);
+
+  if (--jparser->depth == 0) {
+    /* JSON-RPC message has been parsed */
+    ovs_db_json_data_process(jparser->pdb, jparser->root,
+                             jparser->rows_streamed);
+    ovs_json_parser_msg_reset(jparser);
+  }
+  return 1;
+}
+
+static int ovs_json_parser_start_array_cb(void *ctx) {
+  return ovs_json_parser_container_open(ctx, yajl_t_array);
+}
+
+static yajl_callbacks ovs_json_parser_callbacks = {
+    .yajl_null = ovs_json_parser_null_cb,
+    .yajl_boolean = ovs_json_parser_boolean_cb,
+    .yajl_number = ovs_json_parser_number_cb,
+    .yajl_string = ovs_json_parser_string_cb,
+    .yajl_start_map = ovs_json_parser_start_map_cb,
+    .yajl_map_key = ovs_json_parser_map_key_cb,
+    .yajl_end_map = ovs_json_parser_end_container_cb,
+    .yajl_start_array = ovs_json_parser_start_array_cb,
+    .yajl_end_array = ovs_json_parser_end_container_cb,
+};
+
+/* Allocate YAJL parser handle. The handle accepts
+ * stream of JSON-RPC messages */
+static yajl_handle ovs_json_parser_handle_alloc(ovs_json_parser_t *jparser) {
+  yajl_handle handle = yajl_alloc(&ovs_json_parser_callbacks, NULL, jparser);
+  if (handle == NULL)
+    return NULL;
+
+  yajl_config(handle, yajl_allow_multiple_values, 1);
+  return handle;
+}
+
+/* Allocate JSON parser instance */
+static ovs_json_parser_t *ovs_json_parser_alloc(ovs_db_t *pdb) {
+  ovs_json_parser_t *jparser = calloc(1, sizeof(*jparser));
+  if (jparser == NULL)
+    return NULL;
+
+  jparser->pdb = pdb;
+  if ((jparser->handle = ovs_json_parser_handle_alloc(jparser)) == NULL) {
+    free(jparser);
+    return NULL;
+  }
+  return jparser;
+}
+
+/* Push raw data into the JSON parser for processing. The
+ * parsed JSON-RPC messages are handled immediately. Returns
+ * negative value if the data can't be parsed */
+static int ovs_json_parser_push_data(ovs_json_parser_t *jparser,
+                                     const char *data, size_t data_len) {
+  if (jparser->handle == NULL &&
+      (jparser->handle = ovs_json_parser_handle_alloc(jparser)) == NULL)
+    return -1;
+
+  yajl_status status =
+      yajl_parse(jparser->handle, (const unsigned char *)data, data_len);
+  if (status != yajl_status_ok) {
+    unsigned char *errmsg = yajl_get_error(
+        jparser->handle, /* verbose = */ 0, (const unsigned char *)data,
+        data_len);
+    OVS_ERROR("yajl_parse() %s", (char *)errmsg);
+    yajl_free_error(jparser->handle, errmsg);
+    return -1;
+  }
+  return 0;
+}
+
+/* Reset JSON parser. It is useful when start processing
  * new raw data. E.g.: in case of lost stream connection.
  */
-static void ovs_json_reader_reset(ovs_json_reader_t *jreader) {
-  if (jreader) {
-    jreader->buff_offset = 0;
-    jreader->json_offset = 0;
+static void ovs_json_parser_reset(ovs_json_parser_t *jparser) {
+  if (jparser) {
+    ovs_json_parser_msg_reset(jparser);
+    if (jparser->handle != NULL)
+      yajl_free(jparser->handle);
+    jparser->handle = ovs_json_parser_handle_alloc(jparser);
   }
 }
 
-/* Release internal data allocated for JSON reader */
-static void ovs_json_reader_free(ovs_json_reader_t *jreader) {
-  if (jreader) {
-    free(jreader->buff_ptr);
-    free(jreader);
+/* Release internal data allocated for JSON parser */
+static void ovs_json_parser_free(ovs_json_parser_t *jparser) {
+  if (jparser) {
+    ovs_json_parser_msg_reset(jparser);
+    if (jparser->handle != NULL)
+      yajl_free(jparser->handle);
+    free(jparser);
   }
 }
 
@@ -783,16 +1091,16 @@ static void ovs_db_reconnect(ovs_db_t *pdb) {
  */
 static void *ovs_poll_worker(void *arg) {
   ovs_db_t *pdb = (ovs_db_t *)arg; /* pointer to OVS DB */
-  ovs_json_reader_t *jreader = NULL;
+  ovs_json_parser_t *jparser = NULL;
   struct pollfd poll_fd = {
       .fd = pdb->sock,
       .events = POLLIN | POLLPRI,
       .revents = 0,
   };
 
-  /* create JSON reader instance */
-  if ((jreader = ovs_json_reader_alloc()) == NULL) {
-    OVS_ERROR("initialize json reader failed");
+  /* create JSON parser instance */
+  if ((jparser = ovs_json_parser_alloc(pdb)) == NULL) {
+    OVS_ERROR("initialize json parser failed");
     return NULL;
   }
 
@@ -813,7 +1121,7 @@ static void *ovs_poll_worker(void *arg) {
     if (poll_fd.revents & POLLNVAL) {
       /* invalid file descriptor, clean-up */
       ovs_db_callback_remove_all(pdb);
-      ovs_json_reader_reset(jreader);
+      ovs_json_parser_reset(jparser);
       /* setting poll FD to -1 tells poll() call to ignore this FD.
        * In that case poll() call will return timeout all the time */
       pdb->sock = (-1);
@@ -837,19 +1145,19 @@ static void *ovs_poll_worker(void *arg) {
         OVS_ERROR("recv() peer has performed an orderly shutdown");
         continue;
       }
-      /* read incoming data */
-      size_t json_len = 0;
-      const char *json = NULL;
+      /* parse incoming data */
       OVS_DEBUG("recv(): received %zd bytes of data", nbytes);
-      ovs_json_reader_push_data(jreader, buff, nbytes);
-      while (!ovs_json_reader_pop(jreader, &json, &json_len))
-        /* process JSON data */
-        ovs_db_json_data_process(pdb, json, json_len);
+      if (ovs_json_parser_push_data(jparser, buff, nbytes) < 0) {
+        /* the stream is out of sync, reconnect */
+        close(poll_fd.fd);
+        ovs_db_event_post(pdb, OVS_DB_EVENT_CONN_TERMINATED);
+        continue;
+      }
     }
   }
 
   OVS_DEBUG("poll thread has been completed");
-  ovs_json_reader_free(jreader);
+  ovs_json_parser_free(jparser);
   return NULL;
 }
 
@@ -1077,8 +1385,12 @@ failure:
   return NULL;
 }
 
-int ovs_db_send_request(ovs_db_t *pdb, const char *method, const char *params,
-                        ovs_db_result_cb_t cb) {
+/* Send JSON request to OVS DB server. If `stream_rows' is set, the result
+ * of the request is <table-updates> which is passed to the result callback
+ * row by row (see JSON parser implementation) */
+static int ovs_db_request_send(ovs_db_t *pdb, const char *method,
+                               const char *params, ovs_db_result_cb_t cb,
+                               bool stream_rows) {
   int ret = 0;
   yajl_gen_status yajl_gen_ret;
   yajl_val jparams;
@@ -1131,6 +1443,7 @@ int ovs_db_send_request(ovs_db_t *pdb, const char *method, const char *params,
     /* add new callback to front */
     sem_init(&new_cb->result.sync, 0, 0);
     new_cb->result.call = cb;
+    new_cb->result.stream_rows = stream_rows;
     new_cb->uid = uid;
     ovs_db_callback_add(pdb, new_cb);
   }
@@ -1166,6 +1479,11 @@ yajl_gen_failure:
   return (yajl_gen_ret != yajl_gen_status_ok) ? (-1) : ret;
 }
 
+int ovs_db_send_request(ovs_db_t *pdb, const char *method, const char *params,
+                        ovs_db_result_cb_t cb) {
+  return ovs_db_request_send(pdb, method, params, cb, false);
+}
+
 int ovs_db_table_cb_register(ovs_db_t *pdb, const char *tb_name,
                              const char **tb_column,
                              ovs_db_table_cb_t update_cb,
@@ -1256,7 +1574,7 @@ int ovs_db_table_cb_register(ovs_db_t *pdb, const char *tb_name,
   /* make a request to subscribe to given table */
   OVS_YAJL_CALL(yajl_gen_get_buf, jgen, (const unsigned char **)&params,
                 &params_len);
-  if (ovs_db_send_request(pdb, "monitor", params, result_cb) < 0) {
+  if (ovs_db_request_send(pdb, "monitor", params, result_cb, true) < 0) {
     OVS_ERROR("Failed to subscribe to \"%s\" table", tb_name);
     ovs_db_ret = (-1);
   }
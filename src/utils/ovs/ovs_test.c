@@ -0,0 +1,302 @@
+/**
+ * collectd - src/utils/ovs/ovs_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "ovs.c" /* sic */
+#include "testing.h"
+
+#define TEST_TABLE_UID 0xA1
+#define TEST_RESULT_UID 0xB2
+
+/* Update notification of the table callback with three rows in two tables. */
+static const char test_update[] =
+    "{\"method\": \"update\", \"params\": [\"A1\", {"
+    "\"Interface\": {"
+    "\"1111\": {\"new\": {\"name\": \"eth0\", \"admin_state\": \"up\"}},"
+    "\"2222\": {\"old\": {\"name\": \"eth1\"}, \"new\": null}},"
+    "\"Bridge\": {"
+    "\"3333\": {\"new\": {\"ports\": [\"set\", [[\"uuid\", \"4444\"]]],"
+    " \"stp_enable\": false}}}"
+    "}], \"id\": null}\n";
+
+static const char test_update_rows[] =
+    "table Interface 1111 "
+    "{\"new\":{\"name\":\"eth0\",\"admin_state\":\"up\"}}; "
+    "table Interface 2222 {\"old\":{\"name\":\"eth1\"},\"new\":null}; "
+    "table Bridge 3333 "
+    "{\"new\":{\"ports\":[\"set\",[[\"uuid\",\"4444\"]]],"
+    "\"stp_enable\":false}}";
+
+/* Monitor reply with the initial rows. The rows can only be streamed if "id"
+ * precedes "result". */
+static const char test_reply_id_first[] =
+    "{\"id\": \"B2\", \"result\": {"
+    "\"Interface\": {"
+    "\"5555\": {\"new\": {\"name\": \"eth2\", \"link_state\": \"down\"}},"
+    "\"6666\": {\"new\": {\"name\": \"eth3\", \"link_state\": \"up\"}}}"
+    "}, \"error\": null}";
+
+static const char test_reply_id_last[] =
+    "{\"result\": {"
+    "\"Interface\": {"
+    "\"5555\": {\"new\": {\"name\": \"eth2\", \"link_state\": \"down\"}},"
+    "\"6666\": {\"new\": {\"name\": \"eth3\", \"link_state\": \"up\"}}}"
+    "}, \"error\": null, \"id\": \"B2\"}";
+
+static const char test_reply_rows[] =
+    "result Interface 5555 "
+    "{\"new\":{\"name\":\"eth2\",\"link_state\":\"down\"}}; "
+    "result Interface 6666 "
+    "{\"new\":{\"name\":\"eth3\",\"link_state\":\"up\"}}";
+
+static char test_rows[1024];
+static int test_table_calls;
+static int test_result_calls;
+
+/* Append every <row-update> of `jupdates' to `test_rows'. */
+static void test_rows_add(const char *prefix, yajl_val jupdates) {
+  if (!YAJL_IS_OBJECT(jupdates))
+    return;
+
+  for (size_t i = 0; i < YAJL_GET_OBJECT(jupdates)->len; i++) {
+    const char *table = YAJL_GET_OBJECT(jupdates)->keys[i];
+    yajl_val jtable = YAJL_GET_OBJECT(jupdates)->values[i];
+    if (!YAJL_IS_OBJECT(jtable))
+      continue;
+
+    for (size_t j = 0; j < YAJL_GET_OBJECT(jtable)->len; j++) {
+      yajl_gen jgen = yajl_gen_alloc(NULL);
+      const unsigned char *row = NULL;
+      size_t row_len = 0;
+
+      ovs_yajl_gen_val(jgen, YAJL_GET_OBJECT(jtable)->values[j]);
+      yajl_gen_get_buf(jgen, &row, &row_len);
+
+      size_t len = strlen(test_rows);
+      snprintf(test_rows + len, sizeof(test_rows) - len, "%s%s %s %s %.*s",
+               (len > 0) ? "; " : "", prefix, table,
+               YAJL_GET_OBJECT(jtable)->keys[j], (int)row_len,
+               (const char *)row);
+      yajl_gen_free(jgen);
+    }
+  }
+}
+
+static void test_table_cb(yajl_val jupdates) {
+  test_table_calls++;
+  test_rows_add("table", jupdates);
+}
+
+static void test_result_cb(yajl_val jresult, yajl_val jerror) {
+  test_result_calls++;
+  if (YAJL_IS_NULL(jerror))
+    test_rows_add("result", jresult);
+}
+
+static ovs_db_t *test_db_alloc(bool stream_rows) {
+  ovs_db_t *pdb = calloc(1, sizeof(*pdb));
+  if (pdb == NULL)
+    return NULL;
+  pthread_mutex_init(&pdb->mutex, NULL);
+  pdb->sock = -1;
+
+  ovs_callback_t *table_cb = calloc(1, sizeof(*table_cb));
+  ovs_callback_t *result_cb = calloc(1, sizeof(*result_cb));
+  if ((table_cb == NULL) || (result_cb == NULL)) {
+    free(table_cb);
+    free(result_cb);
+    free(pdb);
+    return NULL;
+  }
+
+  table_cb->uid = TEST_TABLE_UID;
+  table_cb->table.call = test_table_cb;
+  ovs_db_callback_add(pdb, table_cb);
+
+  result_cb->uid = TEST_RESULT_UID;
+  sem_init(&result_cb->result.sync, 0, 0);
+  result_cb->result.call = test_result_cb;
+  result_cb->result.stream_rows = stream_rows;
+  ovs_db_callback_add(pdb, result_cb);
+
+  return pdb;
+}
+
+static void test_db_free(ovs_db_t *pdb) {
+  pthread_mutex_lock(&pdb->mutex);
+  ovs_callback_t *result_cb = ovs_db_callback_get(pdb, TEST_RESULT_UID);
+  pthread_mutex_unlock(&pdb->mutex);
+  sem_destroy(&result_cb->result.sync);
+
+  ovs_db_callback_remove_all(pdb);
+  pthread_mutex_destroy(&pdb->mutex);
+  free(pdb);
+}
+
+/* Returns the number of replies the result callback has been unlocked for. */
+static int test_db_replies(ovs_db_t *pdb) {
+  int replies = 0;
+
+  pthread_mutex_lock(&pdb->mutex);
+  ovs_callback_t *result_cb = ovs_db_callback_get(pdb, TEST_RESULT_UID);
+  while (sem_trywait(&result_cb->result.sync) == 0)
+    replies++;
+  pthread_mutex_unlock(&pdb->mutex);
+
+  return replies;
+}
+
+/* Feeds `data' to a new parser in chunks of `chunk_size' bytes and checks
+ * that the callbacks have been passed `expect_rows'. */
+static int test_parse(ovs_db_t *pdb, const char *data, size_t chunk_size,
+                      const char *expect_rows) {
+  ovs_json_parser_t *jparser;
+  size_t data_len = strlen(data);
+
+  test_rows[0] = 0;
+  CHECK_NOT_NULL(jparser = ovs_json_parser_alloc(pdb));
+
+  for (size_t offset = 0; offset < data_len; offset += chunk_size) {
+    size_t len = data_len - offset;
+    if (len > chunk_size)
+      len = chunk_size;
+    CHECK_ZERO(ovs_json_parser_push_data(jparser, data + offset, len));
+  }
+
+  /* no JSON-RPC message is left incomplete */
+  EXPECT_EQ_INT(0, (int)jparser->depth);
+  OK(jparser->root == NULL);
+  ovs_json_parser_free(jparser);
+
+  EXPECT_EQ_STR(expect_rows, test_rows);
+  return 0;
+}
+
+DEF_TEST(update_notification) {
+  ovs_db_t *pdb;
+  CHECK_NOT_NULL(pdb = test_db_alloc(true));
+
+  for (size_t chunk_size = 1; chunk_size <= strlen(test_update);
+       chunk_size++) {
+    test_table_calls = 0;
+    CHECK_ZERO(test_parse(pdb, test_update, chunk_size, test_update_rows));
+    /* every row is passed to the callback as soon as it has been parsed */
+    EXPECT_EQ_INT(3, test_table_calls);
+  }
+
+  test_db_free(pdb);
+  return 0;
+}
+
+DEF_TEST(monitor_reply) {
+  struct {
+    const char *reply;
+    bool stream_rows;
+    int want_calls;
+  } cases[] = {
+      {test_reply_id_first, true, 2},
+      /* "id" is not known until the rows have been parsed */
+      {test_reply_id_last, true, 1},
+      /* the callback wants the whole result */
+      {test_reply_id_first, false, 1},
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    ovs_db_t *pdb;
+    size_t reply_len = strlen(cases[i].reply);
+
+    printf("## Case %" PRIsz ": %s\n", i, cases[i].reply);
+    CHECK_NOT_NULL(pdb = test_db_alloc(cases[i].stream_rows));
+
+    for (size_t chunk_size = 1; chunk_size <= reply_len; chunk_size++) {
+      test_result_calls = 0;
+      CHECK_ZERO(test_parse(pdb, cases[i].reply, chunk_size, test_reply_rows));
+      EXPECT_EQ_INT(cases[i].want_calls, test_result_calls);
+      EXPECT_EQ_INT(1, test_db_replies(pdb));
+    }
+
+    test_db_free(pdb);
+  }
+
+  return 0;
+}
+
+DEF_TEST(message_stream) {
+  char stream[2048];
+  char expect_rows[1024];
+  ovs_db_t *pdb;
+
+  /* messages of one stream may be split anywhere, including between two
+   * messages */
+  snprintf(stream, sizeof(stream), "%s%s %s%s", test_update,
+           test_reply_id_first, test_update, test_reply_id_last);
+  snprintf(expect_rows, sizeof(expect_rows), "%s; %s; %s; %s",
+           test_update_rows, test_reply_rows, test_update_rows,
+           test_reply_rows);
+
+  CHECK_NOT_NULL(pdb = test_db_alloc(true));
+
+  for (size_t chunk_size = 1; chunk_size <= strlen(stream); chunk_size++) {
+    test_table_calls = 0;
+    test_result_calls = 0;
+    CHECK_ZERO(test_parse(pdb, stream, chunk_size, expect_rows));
+    EXPECT_EQ_INT(6, test_table_calls);
+    EXPECT_EQ_INT(3, test_result_calls);
+    EXPECT_EQ_INT(2, test_db_replies(pdb));
+  }
+
+  test_db_free(pdb);
+  return 0;
+}
+
+DEF_TEST(parse_error) {
+  ovs_json_parser_t *jparser;
+  ovs_db_t *pdb;
+  const char invalid[] = "{\"method\": \"update\", \"params\": [\"A1\" {}]}";
+
+  CHECK_NOT_NULL(pdb = test_db_alloc(true));
+  CHECK_NOT_NULL(jparser = ovs_json_parser_alloc(pdb));
+
+  test_table_calls = 0;
+  OK(ovs_json_parser_push_data(jparser, invalid, strlen(invalid)) < 0);
+  EXPECT_EQ_INT(0, test_table_calls);
+
+  /* the parser accepts new data once it has been reset */
+  ovs_json_parser_reset(jparser);
+  test_rows[0] = 0;
+  CHECK_ZERO(ovs_json_parser_push_data(jparser, test_update,
+                                       strlen(test_update)));
+  EXPECT_EQ_STR(test_update_rows, test_rows);
+
+  ovs_json_parser_free(jparser);
+  test_db_free(pdb);
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(update_notification);
+  RUN_TEST(monitor_reply);
+  RUN_TEST(message_stream);
+  RUN_TEST(parse_error);
+
+  END_TEST;
+}
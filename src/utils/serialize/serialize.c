@@ -0,0 +1,314 @@
+/**
+ * collectd - src/utils/serialize/serialize.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include <math.h>
+
+#include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
+
+static char const serialize_digits[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+
+static uint64_t const serialize_pow10[] = {1ULL,
+                                           10ULL,
+                                           100ULL,
+                                           1000ULL,
+                                           10000ULL,
+                                           100000ULL,
+                                           1000000ULL,
+                                           10000000ULL,
+                                           100000000ULL,
+                                           1000000000ULL,
+                                           10000000000ULL,
+                                           100000000000ULL,
+                                           1000000000000ULL,
+                                           10000000000000ULL,
+                                           100000000000000ULL,
+                                           1000000000000000ULL,
+                                           10000000000000000ULL,
+                                           100000000000000000ULL,
+                                           1000000000000000000ULL,
+                                           10000000000000000000ULL};
+
+/* Copies the formatted number to the caller's buffer with the semantics of
+ * snprintf(3). */
+static int serialize_copy(char *buffer, size_t buffer_size, /* {{{ */
+                          char const *src, size_t len) {
+  if (buffer_size > 0) {
+    size_t n = (len < buffer_size) ? len : buffer_size - 1;
+    memcpy(buffer, src, n);
+    buffer[n] = 0;
+  }
+  return (int)len;
+} /* }}} int serialize_copy */
+
+/* Writes the decimal digits of `value' so that they end right before `end'
+ * and returns their number. Two digits are converted at a time. */
+static size_t serialize_digits_rev(char *end, uint64_t value) /* {{{ */
+{
+  char *ptr = end;
+
+  while (value >= 100) {
+    unsigned idx = (unsigned)(value % 100) * 2;
+    value /= 100;
+    ptr -= 2;
+    ptr[0] = serialize_digits[idx];
+    ptr[1] = serialize_digits[idx + 1];
+  }
+
+  if (value >= 10) {
+    unsigned idx = (unsigned)value * 2;
+    ptr -= 2;
+    ptr[0] = serialize_digits[idx];
+    ptr[1] = serialize_digits[idx + 1];
+  } else {
+    *(--ptr) = (char)('0' + value);
+  }
+
+  return (size_t)(end - ptr);
+} /* }}} size_t serialize_digits_rev */
+
+int serialize_uint64(char *buffer, size_t buffer_size, /* {{{ */
+                     uint64_t value) {
+  char tmp[SERIALIZE_NUMBER_MAX];
+  char *end = tmp + sizeof(tmp);
+  size_t len = serialize_digits_rev(end, value);
+
+  return serialize_copy(buffer, buffer_size, end - len, len);
+} /* }}} int serialize_uint64 */
+
+int serialize_int64(char *buffer, size_t buffer_size, int64_t value) /* {{{ */
+{
+  char tmp[SERIALIZE_NUMBER_MAX];
+  char *end = tmp + sizeof(tmp);
+  /* Negating in unsigned arithmetic also works for INT64_MIN. */
+  uint64_t abs_value = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+  size_t len = serialize_digits_rev(end, abs_value);
+
+  if (value < 0) {
+    len++;
+    end[-(ptrdiff_t)len] = '-';
+  }
+
+  return serialize_copy(buffer, buffer_size, end - len, len);
+} /* }}} int serialize_int64 */
+
+#if defined(__SIZEOF_INT128__)
+/* Computes `value' * 10^`exp10', rounded to the nearest integer with ties
+ * going to the even integer, exactly like printf(3) does for the digits it
+ * prints. `value' must be finite and not negative. Returns false if the
+ * result does not fit into 64 bits. */
+static bool serialize_scale(double value, int exp10, /* {{{ */
+                            uint64_t *ret_value) {
+  if ((exp10 < 0) || (exp10 >= (int)STATIC_ARRAY_SIZE(serialize_pow10)))
+    return false;
+
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  /* value = mantissa * 2^exp2 */
+  uint64_t mantissa = bits & ((UINT64_C(1) << 52) - 1);
+  int biased = (int)((bits >> 52) & 0x7ff);
+  if (biased == 0)
+    biased = 1; /* subnormal */
+  else
+    mantissa |= UINT64_C(1) << 52;
+  int exp2 = biased - 1075;
+
+  /* Less than 2^117, so there is no overflow. */
+  unsigned __int128 product =
+      (unsigned __int128)mantissa * serialize_pow10[exp10];
+
+  if (exp2 >= 0) {
+    if ((exp2 >= 64) || ((product >> (64 - exp2)) != 0))
+      return false;
+    product <<= exp2;
+  } else if (-exp2 >= 118) {
+    /* The product is less than 2^117, so the result is less than 1/2. */
+    product = 0;
+  } else {
+    int shift = -exp2;
+    unsigned __int128 rest = product & (((unsigned __int128)1 << shift) - 1);
+    unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+
+    product >>= shift;
+    if ((rest > half) || ((rest == half) && ((product & 1) != 0)))
+      product++;
+  }
+
+  if (product > UINT64_MAX)
+    return false;
+  *ret_value = (uint64_t)product;
+  return true;
+} /* }}} bool serialize_scale */
+#endif
+
+int serialize_gauge(char *buffer, size_t buffer_size, double value) /* {{{ */
+{
+#if defined(__SIZEOF_INT128__)
+  char tmp[SERIALIZE_NUMBER_MAX];
+  char *ptr = tmp;
+  double abs_value = fabs(value);
+
+  if (value == 0.0)
+    return serialize_copy(buffer, buffer_size, signbit(value) ? "-0" : "0",
+                          signbit(value) ? 2 : 1);
+
+  /* Numbers printed with an exponent and special values are left to
+   * snprintf(3). */
+  if (!isfinite(value) || (abs_value < 1e-4) || (abs_value >= 1e15))
+    return snprintf(buffer, buffer_size, GAUGE_FORMAT, value);
+
+  /* Determine the 15 significant digits. The estimate of the decimal exponent
+   * is either exact or one too small. */
+  int exp2 = ilogb(abs_value);
+  int exp10 = (int)floor(exp2 * 0.30102999566398120);
+  uint64_t digits;
+  if (!serialize_scale(abs_value, 14 - exp10, &digits))
+    return snprintf(buffer, buffer_size, GAUGE_FORMAT, value);
+  if (digits >= serialize_pow10[15]) {
+    exp10++;
+    if (!serialize_scale(abs_value, 14 - exp10, &digits))
+      return snprintf(buffer, buffer_size, GAUGE_FORMAT, value);
+  }
+  /* Rounding up may add a digit, e.g. for 9.9999999999999999. */
+  if (digits >= serialize_pow10[15]) {
+    digits /= 10;
+    exp10++;
+  }
+  if (exp10 >= 15)
+    return snprintf(buffer, buffer_size, GAUGE_FORMAT, value);
+
+  char digit_str[16];
+  serialize_digits_rev(digit_str + 15, digits);
+  size_t int_num = (exp10 >= 0) ? (size_t)exp10 + 1 : 0;
+  size_t digits_num = 15;
+  /* Trailing zeros are never printed after the decimal point. */
+  while ((digits_num > int_num) && (digit_str[digits_num - 1] == '0'))
+    digits_num--;
+
+  if (signbit(value))
+    *(ptr++) = '-';
+
+  if (int_num > 0) {
+    memcpy(ptr, digit_str, int_num);
+    ptr += int_num;
+  } else {
+    *(ptr++) = '0';
+  }
+
+  if (digits_num > int_num) {
+    *(ptr++) = '.';
+    for (int i = -1; i > exp10; i--)
+      *(ptr++) = '0';
+    memcpy(ptr, digit_str + int_num, digits_num - int_num);
+    ptr += digits_num - int_num;
+  }
+
+  return serialize_copy(buffer, buffer_size, tmp, (size_t)(ptr - tmp));
+#else
+  return snprintf(buffer, buffer_size, GAUGE_FORMAT, value);
+#endif
+} /* }}} int serialize_gauge */
+
+int serialize_fixed(char *buffer, size_t buffer_size, /* {{{ */
+                    double value, int precision) {
+#if defined(__SIZEOF_INT128__)
+  char tmp[SERIALIZE_NUMBER_MAX + 1];
+  char *end = tmp + sizeof(tmp);
+  uint64_t scaled;
+
+  if (!isfinite(value) || !serialize_scale(fabs(value), precision, &scaled))
+    return snprintf(buffer, buffer_size, "%.*f", precision, value);
+
+  uint64_t int_part = scaled / serialize_pow10[precision];
+  uint64_t frac_part = scaled % serialize_pow10[precision];
+
+  size_t len = 0;
+  if (precision > 0) {
+    /* Pad the fractional part with leading zeros. */
+    len = serialize_digits_rev(end, frac_part);
+    while (len < (size_t)precision)
+      end[-(ptrdiff_t)(++len)] = '0';
+    end[-(ptrdiff_t)(++len)] = '.';
+  }
+  len += serialize_digits_rev(end - len, int_part);
+  if (signbit(value))
+    end[-(ptrdiff_t)(++len)] = '-';
+
+  return serialize_copy(buffer, buffer_size, end - len, len);
+#else
+  return snprintf(buffer, buffer_size, "%.*f", precision, value);
+#endif
+} /* }}} int serialize_fixed */
+
+static bool serialize_charset_has(serialize_charset_t const *set, /* {{{ */
+                                  unsigned char c) {
+  if (c < set->below)
+    return true;
+  if (set->high && (c >= 0x80))
+    return true;
+  for (size_t i = 0; (i < sizeof(set->chars)) && (set->chars[i] != 0); i++)
+    if ((unsigned char)set->chars[i] == c)
+      return true;
+  return false;
+} /* }}} bool serialize_charset_has */
+
+#define SERIALIZE_ONES UINT64_C(0x0101010101010101)
+#define SERIALIZE_HIGHS UINT64_C(0x8080808080808080)
+/* Non-zero if any byte of `x' is less than `n', for n <= 128. */
+#define SERIALIZE_HAS_LESS(x, n)                                               \
+  (((x) - SERIALIZE_ONES * (n)) & ~(x) & SERIALIZE_HIGHS)
+
+size_t serialize_span(char const *string, size_t len, /* {{{ */
+                      serialize_charset_t const *set) {
+  size_t pos = 0;
+
+  /* Test eight bytes at a time and only look at the individual bytes of a
+   * word that contains a byte of the set. */
+  while ((len - pos) >= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, string + pos, sizeof(word));
+
+    uint64_t found = SERIALIZE_HAS_LESS(word, (uint64_t)set->below);
+    if (set->high)
+      found |= word & SERIALIZE_HIGHS;
+    for (size_t i = 0; (i < sizeof(set->chars)) && (set->chars[i] != 0); i++) {
+      uint64_t match = word ^ (SERIALIZE_ONES * (unsigned char)set->chars[i]);
+      found |= SERIALIZE_HAS_LESS(match, 1);
+    }
+
+    if (found != 0)
+      break;
+    pos += sizeof(uint64_t);
+  }
+
+  while ((pos < len) && !serialize_charset_has(set, (unsigned char)string[pos]))
+    pos++;
+
+  return pos;
+} /* }}} size_t serialize_span */
@@ -0,0 +1,83 @@
+/**
+ * collectd - src/utils/serialize/serialize.h
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef UTILS_SERIALIZE_H
+#define UTILS_SERIALIZE_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Number and string formatting for the output formats (JSON, Graphite, CSV,
+ * ...). The number functions produce exactly the same output as the
+ * corresponding printf(3) conversions, but are considerably faster for the
+ * values that are commonly written. Like snprintf(3), they return the length
+ * of the complete output, which may be larger than `buffer_size', and always
+ * null-terminate the buffer unless `buffer_size' is zero.
+ */
+
+/* Large enough for the output of every number function, including the null
+ * byte. */
+#define SERIALIZE_NUMBER_MAX 32
+
+/* Same as "%" PRIu64. */
+int serialize_uint64(char *buffer, size_t buffer_size, uint64_t value);
+
+/* Same as "%" PRIi64. */
+int serialize_int64(char *buffer, size_t buffer_size, int64_t value);
+
+/* Same as GAUGE_FORMAT, i.e. "%.15g". */
+int serialize_gauge(char *buffer, size_t buffer_size, double value);
+
+/* Same as "%.*f", e.g. "%.3f" for a precision of three. */
+int serialize_fixed(char *buffer, size_t buffer_size, double value,
+                    int precision);
+
+/*
+ * A set of bytes that need special treatment when copying a string, e.g.
+ * because they have to be escaped. Sets are described by a few properties
+ * rather than a table so that they can be tested for eight bytes at a time.
+ */
+typedef struct {
+  /* Bytes less than this value are in the set. Must not exceed 128. */
+  unsigned char below;
+  /* Bytes with the most significant bit set are in the set. */
+  bool high;
+  /* Up to three more bytes in the set. */
+  char chars[4];
+} serialize_charset_t;
+
+/*
+ * NAME
+ *   serialize_span
+ *
+ * DESCRIPTION
+ *   Returns the number of bytes at the beginning of `string', which is `len'
+ *   bytes long, that are not part of `set'. If all bytes can be copied
+ *   unchanged, `len' is returned.
+ */
+size_t serialize_span(char const *string, size_t len,
+                      serialize_charset_t const *set);
+
+#endif /* UTILS_SERIALIZE_H */
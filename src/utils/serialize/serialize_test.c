@@ -0,0 +1,250 @@
+/**
+ * collectd - src/utils/serialize/serialize_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include <float.h>
+
+#include "testing.h"
+#include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
+
+/* Deterministic pseudo random numbers, so that failures can be reproduced. */
+static uint64_t rand_state = 0x2545F4914F6CDD1DULL;
+static uint64_t rand_u64(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static double rand_double(void) {
+  double d;
+  uint64_t bits = rand_u64();
+
+  switch (bits % 4) {
+  case 0: /* any bit pattern */
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+  case 1: /* the typical range of metrics */
+    return ldexp((double)(bits >> 11), -(int)(rand_u64() % 100));
+  case 2: /* a few decimal places */
+    return (double)(int64_t)(bits >> 24) / (double)(1 << (rand_u64() % 24));
+  default: /* near powers of ten */
+    return pow(10.0, (double)(int)(rand_u64() % 40) - 20) *
+           (1.0 - ldexp((double)(rand_u64() % 16), -53));
+  }
+}
+
+/* Counts mismatches instead of reporting every single one. */
+static int compare(char const *want, char const *got, int want_status,
+                   int got_status) {
+  if ((want_status == got_status) && (strcmp(want, got) == 0))
+    return 0;
+  printf("# got \"%s\" (%d), want \"%s\" (%d)\n", got, got_status, want,
+         want_status);
+  return 1;
+}
+
+DEF_TEST(integers) {
+  struct {
+    uint64_t u;
+    int64_t i;
+  } cases[] = {
+      {0, 0},
+      {9, -9},
+      {10, 10},
+      {99, -99},
+      {100, 100},
+      {12345678901234567890ULL, -1234567890123456789LL},
+      {UINT64_MAX, INT64_MIN},
+      {UINT64_MAX - 1, INT64_MAX},
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    char want[SERIALIZE_NUMBER_MAX], got[SERIALIZE_NUMBER_MAX];
+
+    snprintf(want, sizeof(want), "%" PRIu64, cases[i].u);
+    EXPECT_EQ_INT((int)strlen(want),
+                  serialize_uint64(got, sizeof(got), cases[i].u));
+    EXPECT_EQ_STR(want, got);
+
+    snprintf(want, sizeof(want), "%" PRIi64, cases[i].i);
+    EXPECT_EQ_INT((int)strlen(want),
+                  serialize_int64(got, sizeof(got), cases[i].i));
+    EXPECT_EQ_STR(want, got);
+  }
+
+  int failed = 0;
+  for (int i = 0; i < 100000; i++) {
+    char want[SERIALIZE_NUMBER_MAX], got[SERIALIZE_NUMBER_MAX];
+    uint64_t v = rand_u64() >> (rand_u64() % 64);
+
+    failed += compare(want, got, snprintf(want, sizeof(want), "%" PRIu64, v),
+                      serialize_uint64(got, sizeof(got), v));
+    failed += compare(
+        want, got, snprintf(want, sizeof(want), "%" PRIi64, (int64_t)v),
+        serialize_int64(got, sizeof(got), (int64_t)v));
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  return 0;
+}
+
+DEF_TEST(gauge) {
+  double cases[] = {
+      0.0,
+      -0.0,
+      1.0,
+      -1.0,
+      0.1,
+      0.5,
+      12.34,
+      1e-4,
+      9.99999999999999e-5,
+      0.000099999999999999999,
+      123456789012345.0,
+      999999999999999.0,
+      999999999999999.4,
+      999999999999999.5,
+      1e15,
+      1e100,
+      -1e-100,
+      0.30000000000000004,
+      9.9999999999999999,
+      2.5,
+      0.125,
+      1.0 / 3.0,
+      NAN,
+      INFINITY,
+      -INFINITY,
+      5e-324,
+      DBL_MAX,
+  };
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(cases); i++) {
+    char want[SERIALIZE_NUMBER_MAX], got[SERIALIZE_NUMBER_MAX];
+
+    snprintf(want, sizeof(want), GAUGE_FORMAT, cases[i]);
+    EXPECT_EQ_INT((int)strlen(want),
+                  serialize_gauge(got, sizeof(got), cases[i]));
+    EXPECT_EQ_STR(want, got);
+  }
+
+  int failed = 0;
+  for (int i = 0; i < 1000000; i++) {
+    char want[SERIALIZE_NUMBER_MAX], got[SERIALIZE_NUMBER_MAX];
+    double v = rand_double();
+
+    failed += compare(want, got, snprintf(want, sizeof(want), GAUGE_FORMAT, v),
+                      serialize_gauge(got, sizeof(got), v));
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  return 0;
+}
+
+DEF_TEST(fixed) {
+  int failed = 0;
+
+  for (int i = 0; i < 1000000; i++) {
+    char want[64], got[64];
+    double v = rand_double();
+    int precision = (int)(rand_u64() % 8);
+
+    failed += compare(
+        want, got, snprintf(want, sizeof(want), "%.*f", precision, v),
+        serialize_fixed(got, sizeof(got), v, precision));
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  /* The time in seconds, as written by the JSON format. */
+  for (int i = 0; i < 100000; i++) {
+    char want[64], got[64];
+    double v = CDTIME_T_TO_DOUBLE(TIME_T_TO_CDTIME_T(1700000000) +
+                                  (rand_u64() >> 20));
+
+    failed +=
+        compare(want, got, snprintf(want, sizeof(want), "%.3f", v),
+                serialize_fixed(got, sizeof(got), v, 3));
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  return 0;
+}
+
+DEF_TEST(truncation) {
+  char buffer[4];
+
+  EXPECT_EQ_INT(5, serialize_uint64(buffer, sizeof(buffer), 12345));
+  EXPECT_EQ_STR("123", buffer);
+  EXPECT_EQ_INT(6, serialize_gauge(buffer, sizeof(buffer), 0.1234));
+  EXPECT_EQ_STR("0.1", buffer);
+  EXPECT_EQ_INT(5, serialize_fixed(buffer, sizeof(buffer), 1.5, 3));
+  EXPECT_EQ_STR("1.5", buffer);
+  EXPECT_EQ_INT(2, serialize_int64(buffer, 0, -1));
+
+  return 0;
+}
+
+DEF_TEST(span) {
+  serialize_charset_t json = {.below = 0x20, .chars = "\"\\"};
+  serialize_charset_t high = {.high = true, .chars = "."};
+
+  EXPECT_EQ_INT(0, serialize_span("", 0, &json));
+  EXPECT_EQ_INT(5, serialize_span("hello", 5, &json));
+  EXPECT_EQ_INT(5, serialize_span("hello\"world", 11, &json));
+  EXPECT_EQ_INT(21, serialize_span("a long string without\\", 22, &json));
+  EXPECT_EQ_INT(12, serialize_span("tab-separate\td", 14, &json));
+  EXPECT_EQ_INT(16, serialize_span("0123456789abcdef\x1f", 17, &json));
+  EXPECT_EQ_INT(12, serialize_span("ascii-onlyä", 12, &json));
+  EXPECT_EQ_INT(10, serialize_span("ascii-onlyä", 12, &high));
+  EXPECT_EQ_INT(4, serialize_span("host.example.com", 16, &high));
+
+  /* Every byte value at every position within and after a word. */
+  int failed = 0;
+  for (size_t pos = 0; pos < 20; pos++) {
+    char string[20];
+    memset(string, 'x', sizeof(string));
+    for (int c = 0; c < 256; c++) {
+      string[pos] = (char)c;
+      bool special = (c < 0x20) || (c == '"') || (c == '\\');
+      size_t want = special ? pos : sizeof(string);
+      if (serialize_span(string, sizeof(string), &json) != want)
+        failed++;
+    }
+  }
+  EXPECT_EQ_INT(0, failed);
+
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(integers);
+  RUN_TEST(gauge);
+  RUN_TEST(fixed);
+  RUN_TEST(truncation);
+  RUN_TEST(span);
+
+  END_TEST;
+}
@@ -0,0 +1,284 @@
+/**
+ * collectd - src/utils/string_cache/string_cache.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "plugin.h"
+#include "utils/common/common.h"
+#include "utils/string_cache/string_cache.h"
+
+typedef struct {
+  char *key;
+  char *value;
+  int result;
+} string_cache_entry_t;
+
+struct string_cache_s {
+  pthread_mutex_t lock;
+  string_cache_entry_t *entries; /* allocated on first use */
+  size_t size;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+typedef struct {
+  char *field;
+  string_cache_t *cache;
+} string_cache_report_entry_t;
+
+struct string_cache_report_s {
+  char *plugin;
+  string_cache_report_entry_t *entries;
+  size_t entries_num;
+  /* Plugin instance of the values, empty until the report is registered. */
+  char instance[16];
+};
+
+/* Number of reports registered so far, used to name them. */
+static int string_cache_report_num;
+static pthread_mutex_t string_cache_report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t string_cache_hash(char const *str) /* {{{ */
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (unsigned char const *ptr = (unsigned char const *)str; *ptr != 0;
+       ptr++) {
+    hash ^= *ptr;
+    hash *= 16777619u;
+  }
+  return hash;
+} /* }}} uint32_t string_cache_hash */
+
+string_cache_t *string_cache_create(size_t size) /* {{{ */
+{
+  if (size == 0)
+    return NULL;
+
+  string_cache_t *cache = calloc(1, sizeof(*cache));
+  if (cache == NULL)
+    return NULL;
+
+  pthread_mutex_init(&cache->lock, /* attr = */ NULL);
+  cache->size = size;
+
+  return cache;
+} /* }}} string_cache_t *string_cache_create */
+
+void string_cache_destroy(string_cache_t *cache) /* {{{ */
+{
+  if (cache == NULL)
+    return;
+
+  if (cache->entries != NULL) {
+    for (size_t i = 0; i < cache->size; i++) {
+      sfree(cache->entries[i].key);
+      sfree(cache->entries[i].value);
+    }
+    sfree(cache->entries);
+  }
+  pthread_mutex_destroy(&cache->lock);
+  sfree(cache);
+} /* }}} void string_cache_destroy */
+
+int string_cache_get(string_cache_t *cache, char const *key, /* {{{ */
+                     int *result, char *value, size_t value_size) {
+  int status = ENOENT;
+
+  pthread_mutex_lock(&cache->lock);
+  if (cache->entries != NULL) {
+    string_cache_entry_t *e =
+        cache->entries + (string_cache_hash(key) % cache->size);
+    if ((e->key != NULL) && (strcmp(e->key, key) == 0)) {
+      if (result != NULL)
+        *result = e->result;
+      if ((value != NULL) && (e->value != NULL))
+        sstrncpy(value, e->value, value_size);
+      status = 0;
+    }
+  }
+
+  if (status == 0)
+    cache->hits++;
+  else
+    cache->misses++;
+  pthread_mutex_unlock(&cache->lock);
+
+  return status;
+} /* }}} int string_cache_get */
+
+void string_cache_put(string_cache_t *cache, char const *key, /* {{{ */
+                      int result, char const *value) {
+  char *key_copy = strdup(key);
+  char *value_copy = (value != NULL) ? strdup(value) : NULL;
+  if ((key_copy == NULL) || ((value != NULL) && (value_copy == NULL))) {
+    sfree(key_copy);
+    sfree(value_copy);
+    return;
+  }
+
+  pthread_mutex_lock(&cache->lock);
+  if (cache->entries == NULL)
+    cache->entries = calloc(cache->size, sizeof(*cache->entries));
+  if (cache->entries == NULL) {
+    pthread_mutex_unlock(&cache->lock);
+    sfree(key_copy);
+    sfree(value_copy);
+    return;
+  }
+
+  string_cache_entry_t *e =
+      cache->entries + (string_cache_hash(key) % cache->size);
+  sfree(e->key);
+  sfree(e->value);
+  e->key = key_copy;
+  e->value = value_copy;
+  e->result = result;
+  pthread_mutex_unlock(&cache->lock);
+} /* }}} void string_cache_put */
+
+void string_cache_stats(string_cache_t *cache, uint64_t *hits, /* {{{ */
+                        uint64_t *misses) {
+  pthread_mutex_lock(&cache->lock);
+  *hits += cache->hits;
+  *misses += cache->misses;
+  pthread_mutex_unlock(&cache->lock);
+} /* }}} void string_cache_stats */
+
+string_cache_report_t *string_cache_report_create(char const *plugin) /* {{{ */
+{
+  string_cache_report_t *report = calloc(1, sizeof(*report));
+  if (report == NULL)
+    return NULL;
+
+  report->plugin = strdup(plugin);
+  if (report->plugin == NULL) {
+    sfree(report);
+    return NULL;
+  }
+
+  return report;
+} /* }}} string_cache_report_t *string_cache_report_create */
+
+int string_cache_report_add(string_cache_report_t *report, /* {{{ */
+                            char const *field, string_cache_t *cache) {
+  string_cache_report_entry_t *tmp =
+      realloc(report->entries, (report->entries_num + 1) * sizeof(*tmp));
+  if (tmp == NULL)
+    return ENOMEM;
+  report->entries = tmp;
+
+  string_cache_report_entry_t *e = report->entries + report->entries_num;
+  e->field = strdup(field);
+  if (e->field == NULL)
+    return ENOMEM;
+  e->cache = cache;
+  report->entries_num++;
+
+  return 0;
+} /* }}} int string_cache_report_add */
+
+static void string_cache_report_submit(string_cache_report_t *report, /* {{{ */
+                                       char const *field, uint64_t hits,
+                                       uint64_t misses) {
+  value_list_t vl = VALUE_LIST_INIT;
+
+  vl.values_len = 1;
+  sstrncpy(vl.plugin, report->plugin, sizeof(vl.plugin));
+  sstrncpy(vl.plugin_instance, report->instance, sizeof(vl.plugin_instance));
+  sstrncpy(vl.type, "cache_result", sizeof(vl.type));
+
+  vl.values = &(value_t){.derive = (derive_t)hits};
+  snprintf(vl.type_instance, sizeof(vl.type_instance), "%s-hit", field);
+  plugin_dispatch_values(&vl);
+
+  vl.values = &(value_t){.derive = (derive_t)misses};
+  snprintf(vl.type_instance, sizeof(vl.type_instance), "%s-miss", field);
+  plugin_dispatch_values(&vl);
+} /* }}} void string_cache_report_submit */
+
+static int string_cache_report_read(user_data_t *ud) /* {{{ */
+{
+  string_cache_report_t *report = ud->data;
+
+  for (size_t i = 0; i < report->entries_num;) {
+    char const *field = report->entries[i].field;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    for (; (i < report->entries_num) &&
+           (strcmp(field, report->entries[i].field) == 0);
+         i++)
+      string_cache_stats(report->entries[i].cache, &hits, &misses);
+
+    string_cache_report_submit(report, field, hits, misses);
+  }
+
+  return 0;
+} /* }}} int string_cache_report_read */
+
+int string_cache_report_register(string_cache_report_t *report, /* {{{ */
+                                 cdtime_t interval) {
+  char name[DATA_MAX_NAME_LEN];
+
+  pthread_mutex_lock(&string_cache_report_lock);
+  snprintf(report->instance, sizeof(report->instance), "%d",
+           string_cache_report_num);
+  snprintf(name, sizeof(name), "%s-%s", report->plugin, report->instance);
+
+  plugin_ctx_t ctx = {
+      .name = report->plugin,
+      .interval = interval,
+  };
+  plugin_ctx_t old_ctx = plugin_set_ctx(ctx);
+  int status = plugin_register_complex_read(
+      /* group = */ NULL, name, string_cache_report_read, interval,
+      &(user_data_t){.data = report});
+  plugin_set_ctx(old_ctx);
+
+  if (status == 0)
+    string_cache_report_num++;
+  else
+    report->instance[0] = 0;
+  pthread_mutex_unlock(&string_cache_report_lock);
+
+  return status;
+} /* }}} int string_cache_report_register */
+
+void string_cache_report_destroy(string_cache_report_t *report) /* {{{ */
+{
+  if (report == NULL)
+    return;
+
+  if (report->instance[0] != 0) {
+    char name[DATA_MAX_NAME_LEN];
+    snprintf(name, sizeof(name), "%s-%s", report->plugin, report->instance);
+    plugin_unregister_read(name);
+  }
+
+  for (size_t i = 0; i < report->entries_num; i++)
+    sfree(report->entries[i].field);
+  sfree(report->entries);
+  sfree(report->plugin);
+  sfree(report);
+} /* }}} void string_cache_report_destroy */
@@ -0,0 +1,175 @@
+/**
+ * collectd - src/utils/string_cache/string_cache.h
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef UTILS_STRING_CACHE_H
+#define UTILS_STRING_CACHE_H 1
+
+#include "utils_time.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A string cache remembers the result of an expensive operation, such as
+ * running a list of regular expressions, for recently seen input strings. It
+ * is direct-mapped: each input has exactly one slot, and a new input replaces
+ * whatever was stored in its slot before. Lookups and updates are protected
+ * by a mutex, so a cache may be shared by several threads.
+ *
+ * The identifiers of the values passing through collectd repeat every
+ * interval, so even a small cache avoids most of the work.
+ */
+
+struct string_cache_s;
+typedef struct string_cache_s string_cache_t;
+
+struct string_cache_report_s;
+typedef struct string_cache_report_s string_cache_report_t;
+
+/*
+ * NAME
+ *   string_cache_hash
+ *
+ * DESCRIPTION
+ *   Returns the FNV-1a hash of the null-terminated string `str'. Also meant
+ *   for hash tables outside of this module.
+ */
+uint32_t string_cache_hash(char const *str);
+
+/*
+ * NAME
+ *   string_cache_create
+ *
+ * DESCRIPTION
+ *   Allocates a new, empty cache with `size' slots. Memory for the slots is
+ *   only allocated when the first result is stored.
+ *
+ * RETURN VALUE
+ *   A string_cache_t-pointer upon success or NULL upon failure.
+ */
+string_cache_t *string_cache_create(size_t size);
+
+/*
+ * NAME
+ *   string_cache_destroy
+ *
+ * DESCRIPTION
+ *   Deallocates a cache and all results stored in it.
+ */
+void string_cache_destroy(string_cache_t *cache);
+
+/*
+ * NAME
+ *   string_cache_get
+ *
+ * DESCRIPTION
+ *   Looks up the result stored for `key' and counts a hit or a miss. Upon a
+ *   hit, the result is stored in `result' and the value stored with it, if
+ *   any, is copied to `value'. Either may be NULL if the caller is not
+ *   interested.
+ *
+ * RETURN VALUE
+ *   Zero upon a hit and ENOENT if no result is cached for `key'.
+ */
+int string_cache_get(string_cache_t *cache, char const *key, int *result,
+                     char *value, size_t value_size);
+
+/*
+ * NAME
+ *   string_cache_put
+ *
+ * DESCRIPTION
+ *   Stores `result' and, unless it is NULL, a copy of `value' for `key'.
+ *   Failing to allocate memory only means that the result is not cached.
+ */
+void string_cache_put(string_cache_t *cache, char const *key, int result,
+                      char const *value);
+
+/*
+ * NAME
+ *   string_cache_stats
+ *
+ * DESCRIPTION
+ *   Adds the number of hits and misses of `cache' to `hits' and `misses'.
+ */
+void string_cache_stats(string_cache_t *cache, uint64_t *hits,
+                        uint64_t *misses);
+
+/*
+ * NAME
+ *   string_cache_report_create
+ *
+ * DESCRIPTION
+ *   Allocates a report, which dispatches the hits and misses of a number of
+ *   caches as "cache_result" values of `plugin'. The caches are added with
+ *   `string_cache_report_add' and the report is started with
+ *   `string_cache_report_register'.
+ *
+ * RETURN VALUE
+ *   A string_cache_report_t-pointer upon success or NULL upon failure.
+ */
+string_cache_report_t *string_cache_report_create(char const *plugin);
+
+/*
+ * NAME
+ *   string_cache_report_add
+ *
+ * DESCRIPTION
+ *   Adds `cache' to the report. Its counters are dispatched with the type
+ *   instances "<field>-hit" and "<field>-miss". The counters of caches added
+ *   one after the other with the same `field' are summed up. The cache must
+ *   not be destroyed before the report.
+ *
+ * RETURN VALUE
+ *   Zero upon success or ENOMEM if memory allocation failed.
+ */
+int string_cache_report_add(string_cache_report_t *report, char const *field,
+                            string_cache_t *cache);
+
+/*
+ * NAME
+ *   string_cache_report_register
+ *
+ * DESCRIPTION
+ *   Registers a read callback, named "<plugin>-<n>", which dispatches the
+ *   counters every `interval' with the plugin instance "<n>", where `n' is
+ *   the number of reports registered before. Meant for matches and targets,
+ *   which are created outside of any plugin's context.
+ *
+ * RETURN VALUE
+ *   Zero upon success, non-zero otherwise.
+ */
+int string_cache_report_register(string_cache_report_t *report,
+                                 cdtime_t interval);
+
+/*
+ * NAME
+ *   string_cache_report_destroy
+ *
+ * DESCRIPTION
+ *   Unregisters the read callback, if any, and deallocates the report. The
+ *   caches are left alone.
+ */
+void string_cache_report_destroy(string_cache_report_t *report);
+
+#endif /* UTILS_STRING_CACHE_H */
@@ -0,0 +1,122 @@
+/**
+ * collectd - src/utils/string_cache/string_cache_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "testing.h"
+#include "utils/common/common.h" /* for STATIC_ARRAY_SIZE */
+#include "utils/string_cache/string_cache.h"
+
+DEF_TEST(hash) {
+  /* Test vectors of the 32 bit FNV-1a hash. */
+  EXPECT_EQ_UINT64(2166136261u, string_cache_hash(""));
+  EXPECT_EQ_UINT64(0xe40c292cu, string_cache_hash("a"));
+  EXPECT_EQ_UINT64(0xbf9cf968u, string_cache_hash("foobar"));
+
+  return 0;
+}
+
+DEF_TEST(get_put) {
+  string_cache_t *cache;
+  char value[16];
+  int result = -1;
+
+  CHECK_NOT_NULL(cache = string_cache_create(64));
+  EXPECT_EQ_INT(ENOENT, string_cache_get(cache, "foo", &result, NULL, 0));
+
+  string_cache_put(cache, "foo", 1, /* value = */ NULL);
+  string_cache_put(cache, "bar", 2, "replaced value");
+
+  CHECK_ZERO(string_cache_get(cache, "foo", &result, NULL, 0));
+  EXPECT_EQ_INT(1, result);
+
+  /* The value is truncated to the size of the buffer. */
+  sstrncpy(value, "unchanged", sizeof(value));
+  CHECK_ZERO(string_cache_get(cache, "bar", &result, value, 9));
+  EXPECT_EQ_INT(2, result);
+  EXPECT_EQ_STR("replaced", value);
+
+  /* Storing a key again replaces the result. */
+  string_cache_put(cache, "bar", 3, /* value = */ NULL);
+  sstrncpy(value, "unchanged", sizeof(value));
+  CHECK_ZERO(string_cache_get(cache, "bar", &result, value, sizeof(value)));
+  EXPECT_EQ_INT(3, result);
+  EXPECT_EQ_STR("unchanged", value);
+
+  uint64_t hits = 0, misses = 0;
+  string_cache_stats(cache, &hits, &misses);
+  EXPECT_EQ_UINT64(3, hits);
+  EXPECT_EQ_UINT64(1, misses);
+
+  string_cache_destroy(cache);
+  return 0;
+}
+
+DEF_TEST(replace_slot) {
+  string_cache_t *cache;
+  int result = -1;
+
+  /* With a single slot, every key replaces the one before. */
+  CHECK_NOT_NULL(cache = string_cache_create(1));
+  string_cache_put(cache, "foo", 1, "one");
+  string_cache_put(cache, "bar", 2, "two");
+
+  EXPECT_EQ_INT(ENOENT, string_cache_get(cache, "foo", &result, NULL, 0));
+  CHECK_ZERO(string_cache_get(cache, "bar", &result, NULL, 0));
+  EXPECT_EQ_INT(2, result);
+
+  string_cache_destroy(cache);
+
+  OK(string_cache_create(0) == NULL);
+  return 0;
+}
+
+DEF_TEST(report) {
+  string_cache_report_t *report;
+  string_cache_t *caches[3];
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(caches); i++)
+    CHECK_NOT_NULL(caches[i] = string_cache_create(16));
+
+  CHECK_NOT_NULL(report = string_cache_report_create("test"));
+  CHECK_ZERO(string_cache_report_add(report, "host", caches[0]));
+  CHECK_ZERO(string_cache_report_add(report, "meta_data", caches[1]));
+  CHECK_ZERO(string_cache_report_add(report, "meta_data", caches[2]));
+
+  /* Read callbacks are not supported by the mock. */
+  OK(string_cache_report_register(report, TIME_T_TO_CDTIME_T(10)) != 0);
+  string_cache_report_destroy(report);
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(caches); i++)
+    string_cache_destroy(caches[i]);
+  return 0;
+}
+
+int main(void) {
+  RUN_TEST(hash);
+  RUN_TEST(get_put);
+  RUN_TEST(replace_slot);
+  RUN_TEST(report);
+
+  END_TEST;
+}
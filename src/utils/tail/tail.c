@@ -35,34 +35,166 @@
 #include "utils/common/common.h"
 #include "utils/tail/tail.h"
 
+#if HAVE_SYS_INOTIFY_H
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+/* Initial size of the read buffer. It grows up to CU_TAIL_BUFFER_MAX bytes if
+ * a line does not fit and while data is read ahead by the follower thread. */
+#define CU_TAIL_BUFFER_SIZE 65536
+#define CU_TAIL_BUFFER_MAX 4194304
+
 struct cu_tail_s {
   char *file;
-  FILE *fh;
+  int fd;
   struct stat stat;
+  /* File offset of the end of the buffered data. */
+  off_t offset;
+
+  /* Data read from the file. The bytes from `buffer_pos' up to `buffer_fill'
+   * have not been returned yet. */
+  char *buffer;
+  size_t buffer_size;
+  size_t buffer_pos;
+  size_t buffer_fill;
+
+  pthread_mutex_t lock;
+
+#if HAVE_SYS_INOTIFY_H
+  /* Only used while following the file, see `cu_tail_follow'. */
+  bool follow;
+  pthread_t follow_thread;
+  int inotify_fd;
+  int watch_file;
+  int watch_dir;
+  char const *basename;
+  /* Set by events which may mean that the file has been truncated, moved or
+   * replaced. */
+  bool changed;
+#endif
 };
 
+#if HAVE_SYS_INOTIFY_H
+static void cu_tail_watch_file(cu_tail_t *obj) {
+  if (obj->inotify_fd < 0)
+    return;
+
+  if (obj->watch_file >= 0)
+    inotify_rm_watch(obj->inotify_fd, obj->watch_file);
+
+  /* If this fails, the watch of the directory notices when the file is
+   * created. */
+  obj->watch_file =
+      inotify_add_watch(obj->inotify_fd, obj->file,
+                        IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+} /* void cu_tail_watch_file */
+
+/* Reads all pending events without blocking. Returns true if any of them
+ * concerns the file. */
+static bool cu_tail_read_events(cu_tail_t *obj) {
+  char buffer[4096]
+      __attribute__((aligned(__alignof__(struct inotify_event))));
+  bool found = false;
+
+  while (42) {
+    ssize_t len = read(obj->inotify_fd, buffer, sizeof(buffer));
+    if (len <= 0)
+      break;
+
+    for (char *ptr = buffer; ptr < buffer + len;) {
+      struct inotify_event const *ev = (struct inotify_event const *)ptr;
+      ptr += sizeof(*ev) + ev->len;
+
+      /* Ignore other files in the same directory. */
+      if ((ev->wd == obj->watch_dir) &&
+          ((ev->len == 0) || (strcmp(ev->name, obj->basename) != 0)))
+        continue;
+
+      found = true;
+    }
+  }
+
+  if (found)
+    obj->changed = true;
+  return found;
+} /* bool cu_tail_read_events */
+#endif /* HAVE_SYS_INOTIFY_H */
+
+static void cu_tail_close(cu_tail_t *obj) {
+  if (obj->fd < 0)
+    return;
+
+  close(obj->fd);
+  obj->fd = -1;
+} /* void cu_tail_close */
+
+/* Discards an incomplete last line, e.g. after the file has been truncated. */
+static void cu_tail_drop_partial(cu_tail_t *obj) {
+  while ((obj->buffer_fill > obj->buffer_pos) &&
+         (obj->buffer[obj->buffer_fill - 1] != '\n'))
+    obj->buffer_fill--;
+} /* void cu_tail_drop_partial */
+
+/* Terminates an incomplete last line, e.g. after the file has been rotated.
+ * No more data will be appended to it. */
+static void cu_tail_terminate_partial(cu_tail_t *obj) {
+  if ((obj->buffer_fill == obj->buffer_pos) ||
+      (obj->buffer[obj->buffer_fill - 1] == '\n'))
+    return;
+
+  if ((obj->buffer_fill == obj->buffer_size) && (obj->buffer_pos > 0)) {
+    memmove(obj->buffer, obj->buffer + obj->buffer_pos,
+            obj->buffer_fill - obj->buffer_pos);
+    obj->buffer_fill -= obj->buffer_pos;
+    obj->buffer_pos = 0;
+  }
+
+  /* Otherwise the line is returned in pieces anyway. */
+  if (obj->buffer_fill < obj->buffer_size)
+    obj->buffer[obj->buffer_fill++] = '\n';
+} /* void cu_tail_terminate_partial */
+
+/* Returns 1 if the open file is still the right one, 0 if a new file has been
+ * opened or the file has been rewound, and -1 on error. */
 static int cu_tail_reopen(cu_tail_t *obj, bool force_rewind) {
   int seek_end = 0;
   struct stat stat_buf = {0};
 
+#if HAVE_SYS_INOTIFY_H
+  /* While following, the file only has to be checked after an event. */
+  if (obj->follow && (obj->fd >= 0)) {
+    cu_tail_read_events(obj);
+    if (!obj->changed)
+      return 1;
+  }
+#endif
+
   int status = stat(obj->file, &stat_buf);
   if (status != 0) {
     P_ERROR("utils_tail: stat (%s) failed: %s", obj->file, STRERRNO);
     return -1;
   }
 
+#if HAVE_SYS_INOTIFY_H
+  obj->changed = false;
+#endif
+
   /* The file is already open.. */
-  if ((obj->fh != NULL) && (stat_buf.st_ino == obj->stat.st_ino)) {
+  if ((obj->fd >= 0) && (stat_buf.st_ino == obj->stat.st_ino) &&
+      (stat_buf.st_dev == obj->stat.st_dev)) {
     /* Seek to the beginning if file was truncated */
-    if (stat_buf.st_size < obj->stat.st_size) {
+    if (stat_buf.st_size < obj->offset) {
       P_INFO("utils_tail: File `%s' was truncated.", obj->file);
-      status = fseek(obj->fh, 0, SEEK_SET);
-      if (status != 0) {
-        P_ERROR("utils_tail: fseek (%s) failed: %s", obj->file, STRERRNO);
-        fclose(obj->fh);
-        obj->fh = NULL;
+      if (lseek(obj->fd, 0, SEEK_SET) == (off_t)-1) {
+        P_ERROR("utils_tail: lseek (%s) failed: %s", obj->file, STRERRNO);
+        cu_tail_close(obj);
         return -1;
       }
+      obj->offset = 0;
+      cu_tail_drop_partial(obj);
+      memcpy(&obj->stat, &stat_buf, sizeof(struct stat));
+      return 0;
     }
     memcpy(&obj->stat, &stat_buf, sizeof(struct stat));
     return 1;
@@ -74,29 +206,200 @@ static int cu_tail_reopen(cu_tail_t *obj, bool force_rewind) {
   if ((obj->stat.st_ino == 0) || (obj->stat.st_ino == stat_buf.st_ino))
     seek_end = !force_rewind;
 
-  FILE *fh = fopen(obj->file, "r");
-  if (fh == NULL) {
-    P_ERROR("utils_tail: fopen (%s) failed: %s", obj->file, STRERRNO);
+  int fd = open(obj->file, O_RDONLY);
+  if (fd < 0) {
+    P_ERROR("utils_tail: open (%s) failed: %s", obj->file, STRERRNO);
     return -1;
   }
 
+  /* The file may have been replaced since calling stat(2). */
+  if (fstat(fd, &stat_buf) != 0) {
+    P_ERROR("utils_tail: fstat (%s) failed: %s", obj->file, STRERRNO);
+    close(fd);
+    return -1;
+  }
+
+  off_t offset = 0;
   if (seek_end != 0) {
-    status = fseek(fh, 0, SEEK_END);
-    if (status != 0) {
-      P_ERROR("utils_tail: fseek (%s) failed: %s", obj->file, STRERRNO);
-      fclose(fh);
+    offset = lseek(fd, 0, SEEK_END);
+    if (offset == (off_t)-1) {
+      P_ERROR("utils_tail: lseek (%s) failed: %s", obj->file, STRERRNO);
+      close(fd);
       return -1;
     }
   }
 
-  if (obj->fh != NULL)
-    fclose(obj->fh);
-  obj->fh = fh;
+  if (obj->fd >= 0) {
+    cu_tail_close(obj);
+    cu_tail_terminate_partial(obj);
+  }
+  obj->fd = fd;
+  obj->offset = offset;
   memcpy(&obj->stat, &stat_buf, sizeof(struct stat));
 
+#if HAVE_SYS_INOTIFY_H
+  if (obj->follow)
+    cu_tail_watch_file(obj);
+#endif
+
   return 0;
 } /* int cu_tail_reopen */
 
+/* Reads more data into the buffer. Returns the number of bytes read, zero at
+ * the end of the file or if the buffer is full, and -1 on error. */
+static ssize_t cu_tail_fill(cu_tail_t *obj) {
+  if (obj->buffer_pos == obj->buffer_fill) {
+    obj->buffer_pos = 0;
+    obj->buffer_fill = 0;
+  }
+
+  if (obj->buffer_fill == obj->buffer_size) {
+    if (obj->buffer_pos > 0) {
+      memmove(obj->buffer, obj->buffer + obj->buffer_pos,
+              obj->buffer_fill - obj->buffer_pos);
+      obj->buffer_fill -= obj->buffer_pos;
+      obj->buffer_pos = 0;
+    } else if (obj->buffer_size < CU_TAIL_BUFFER_MAX) {
+      size_t size = (obj->buffer_size == 0) ? CU_TAIL_BUFFER_SIZE
+                                            : 2 * obj->buffer_size;
+      char *buffer = realloc(obj->buffer, size);
+      if (buffer == NULL) {
+        ERROR("utils_tail: realloc failed.");
+        return -1;
+      }
+      obj->buffer = buffer;
+      obj->buffer_size = size;
+    } else {
+      return 0;
+    }
+  }
+
+  ssize_t status;
+  do {
+    status = read(obj->fd, obj->buffer + obj->buffer_fill,
+                  obj->buffer_size - obj->buffer_fill);
+  } while ((status < 0) && (errno == EINTR));
+
+  if (status > 0) {
+    obj->buffer_fill += (size_t)status;
+    obj->offset += status;
+  }
+  return status;
+} /* ssize_t cu_tail_fill */
+
+/* Returns the next line, including the newline character, without copying
+ * it. Lines longer than `max_len' bytes are returned in pieces. At the end of
+ * the file, `*ret_line' is set to NULL; an incomplete last line is kept until
+ * it is completed or the file is rotated. The caller must hold the lock. */
+static int cu_tail_next_line(cu_tail_t *obj, bool force_rewind, size_t max_len,
+                             char **ret_line, size_t *ret_len) {
+  size_t scanned = 0;
+
+  *ret_line = NULL;
+  *ret_len = 0;
+
+  if (max_len > CU_TAIL_BUFFER_MAX)
+    max_len = CU_TAIL_BUFFER_MAX;
+
+  if (obj->fd < 0) {
+    int status = cu_tail_reopen(obj, force_rewind);
+    if (status < 0)
+      return status;
+  }
+
+  while (42) {
+    char *start = obj->buffer + obj->buffer_pos;
+    size_t avail = obj->buffer_fill - obj->buffer_pos;
+    char *newline = NULL;
+
+    if (avail > scanned)
+      newline = memchr(start + scanned, '\n', avail - scanned);
+
+    if ((newline != NULL) || (avail >= max_len)) {
+      size_t len = (newline != NULL) ? (size_t)(newline - start) + 1 : max_len;
+      if (len > max_len)
+        len = max_len;
+
+      obj->buffer_pos += len;
+      *ret_line = start;
+      *ret_len = len;
+      return 0;
+    }
+    scanned = avail;
+
+    ssize_t status = cu_tail_fill(obj);
+    if (status > 0)
+      continue;
+
+    if (status < 0) {
+      WARNING("utils_tail: read (%s) failed: %s", obj->file, STRERRNO);
+      /* Force `cu_tail_reopen' to reopen the file.. */
+      cu_tail_close(obj);
+    }
+
+    /* End of file: check if the file was truncated or moved away and reopen
+     * the new file if so.. */
+    status = cu_tail_reopen(obj, force_rewind);
+    if (status < 0)
+      return (int)status;
+    else if (status > 0)
+      return 0;
+    /* A new file has been opened, there may be more to read. */
+  }
+} /* int cu_tail_next_line */
+
+#if HAVE_SYS_INOTIFY_H
+/* Reads the data appended to the file ahead of time, so that it is read as
+ * soon as it has been written and no data is lost when the file is rotated
+ * and removed before the next read. */
+static void cu_tail_read_ahead(cu_tail_t *obj) {
+  /* The file is opened by the first read, which may rewind it. */
+  if (obj->fd < 0) {
+    if ((obj->stat.st_ino == 0) || (cu_tail_reopen(obj, false) < 0))
+      return;
+  }
+
+  while ((obj->buffer_fill - obj->buffer_pos) < CU_TAIL_BUFFER_MAX) {
+    ssize_t status = cu_tail_fill(obj);
+    if (status > 0)
+      continue;
+
+    if (status < 0) {
+      WARNING("utils_tail: read (%s) failed: %s", obj->file, STRERRNO);
+      cu_tail_close(obj);
+    }
+
+    if (cu_tail_reopen(obj, false) != 0)
+      break;
+  }
+} /* void cu_tail_read_ahead */
+
+static void *cu_tail_follow_thread(void *arg) {
+  cu_tail_t *obj = arg;
+
+  while (42) {
+    struct pollfd fds = {.fd = obj->inotify_fd, .events = POLLIN};
+    int old_state;
+
+    /* The thread is canceled while waiting here. */
+    int status = poll(&fds, 1, -1);
+    if ((status < 0) && (errno != EINTR)) {
+      ERROR("utils_tail: poll (%s) failed: %s", obj->file, STRERRNO);
+      break;
+    }
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_state);
+    pthread_mutex_lock(&obj->lock);
+    if (cu_tail_read_events(obj))
+      cu_tail_read_ahead(obj);
+    pthread_mutex_unlock(&obj->lock);
+    pthread_setcancelstate(old_state, NULL);
+  }
+
+  return NULL;
+} /* void *cu_tail_follow_thread */
+#endif /* HAVE_SYS_INOTIFY_H */
+
 cu_tail_t *cu_tail_create(const char *file) {
   cu_tail_t *obj;
 
@@ -110,109 +413,160 @@ cu_tail_t *cu_tail_create(const char *file) {
     return NULL;
   }
 
-  obj->fh = NULL;
+  obj->fd = -1;
+  pthread_mutex_init(&obj->lock, NULL);
+
+#if HAVE_SYS_INOTIFY_H
+  obj->inotify_fd = -1;
+  obj->watch_file = -1;
+  obj->watch_dir = -1;
+#endif
 
   return obj;
 } /* cu_tail_t *cu_tail_create */
 
 int cu_tail_destroy(cu_tail_t *obj) {
-  if (obj->fh != NULL)
-    fclose(obj->fh);
+#if HAVE_SYS_INOTIFY_H
+  if (obj->follow) {
+    pthread_cancel(obj->follow_thread);
+    pthread_join(obj->follow_thread, NULL);
+  }
+  if (obj->inotify_fd >= 0)
+    close(obj->inotify_fd);
+#endif
+
+  cu_tail_close(obj);
+  pthread_mutex_destroy(&obj->lock);
+  free(obj->buffer);
   free(obj->file);
   free(obj);
 
   return 0;
 } /* int cu_tail_destroy */
 
-int cu_tail_readline(cu_tail_t *obj, char *buf, int buflen, bool force_rewind) {
-  int status;
+int cu_tail_follow(cu_tail_t *obj) {
+#if HAVE_SYS_INOTIFY_H
+  int status = 0;
 
-  if (buflen < 1) {
-    ERROR("utils_tail: cu_tail_readline: buflen too small: %i bytes.", buflen);
-    return -1;
+  pthread_mutex_lock(&obj->lock);
+  if (obj->follow) {
+    pthread_mutex_unlock(&obj->lock);
+    return 0;
   }
 
-  if (obj->fh == NULL) {
-    status = cu_tail_reopen(obj, force_rewind);
-    if (status < 0)
-      return status;
+  obj->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (obj->inotify_fd < 0) {
+    ERROR("utils_tail: inotify_init1 failed: %s", STRERRNO);
+    pthread_mutex_unlock(&obj->lock);
+    return -1;
   }
-  assert(obj->fh != NULL);
 
-  /* Try to read from the filehandle. If that succeeds, everything appears to
-   * be fine and we can return. */
-  clearerr(obj->fh);
-  if (fgets(buf, buflen, obj->fh) != NULL) {
-    buf[buflen - 1] = '\0';
-    return 0;
+  /* Watch the directory to notice when the file is created or replaced. */
+  char *slash = strrchr(obj->file, '/');
+  char dir[PATH_MAX];
+  if (slash == NULL)
+    sstrncpy(dir, ".", sizeof(dir));
+  else if (slash == obj->file)
+    sstrncpy(dir, "/", sizeof(dir));
+  else
+    ssnprintf(dir, sizeof(dir), "%.*s", (int)(slash - obj->file), obj->file);
+  obj->basename = (slash != NULL) ? slash + 1 : obj->file;
+
+  obj->watch_dir = inotify_add_watch(obj->inotify_fd, dir,
+                                     IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM |
+                                         IN_DELETE);
+  if (obj->watch_dir < 0) {
+    ERROR("utils_tail: Watching directory `%s' failed: %s", dir, STRERRNO);
+    status = -1;
   }
 
-  /* Check if we encountered an error */
-  if (ferror(obj->fh) != 0) {
-    /* Jupp, error. Force `cu_tail_reopen' to reopen the file.. */
-    fclose(obj->fh);
-    obj->fh = NULL;
-  }
-  /* else: eof -> check if the file was moved away and reopen the new file if
-   * so.. */
+  if (status == 0) {
+    cu_tail_watch_file(obj);
+    obj->changed = true;
+    obj->follow = true;
 
-  status = cu_tail_reopen(obj, force_rewind);
-  /* error -> return with error */
-  if (status < 0)
-    return status;
-  /* file end reached and file not reopened -> nothing more to read */
-  else if (status > 0) {
-    buf[0] = 0;
-    return 0;
+    status = plugin_thread_create(&obj->follow_thread, cu_tail_follow_thread,
+                                  obj, "utils_tail");
+    if (status != 0) {
+      ERROR("utils_tail: Starting thread to follow `%s' failed.", obj->file);
+      obj->follow = false;
+    }
   }
 
-  /* If we get here: file was re-opened and there may be more to read.. Let's
-   * try again. */
-  if (fgets(buf, buflen, obj->fh) != NULL) {
-    buf[buflen - 1] = '\0';
-    return 0;
+  if (status != 0) {
+    close(obj->inotify_fd);
+    obj->inotify_fd = -1;
+    obj->watch_file = -1;
+    obj->watch_dir = -1;
   }
 
-  if (ferror(obj->fh) != 0) {
-    WARNING("utils_tail: fgets (%s) returned an error: %s", obj->file,
-            STRERRNO);
-    fclose(obj->fh);
-    obj->fh = NULL;
+  pthread_mutex_unlock(&obj->lock);
+  return status;
+#else
+  ERROR("utils_tail: Following `%s' is not supported on this system.",
+        obj->file);
+  return ENOTSUP;
+#endif
+} /* int cu_tail_follow */
+
+int cu_tail_readline(cu_tail_t *obj, char *buf, int buflen, bool force_rewind) {
+  char *line;
+  size_t len;
+
+  if (buflen < 1) {
+    ERROR("utils_tail: cu_tail_readline: buflen too small: %i bytes.", buflen);
     return -1;
   }
 
-  /* EOf, well, apparently the new file is empty.. */
-  buf[0] = 0;
-  return 0;
+  pthread_mutex_lock(&obj->lock);
+  int status =
+      cu_tail_next_line(obj, force_rewind, (size_t)buflen - 1, &line, &len);
+  if (status == 0) {
+    if (len > 0)
+      memcpy(buf, line, len);
+    buf[len] = 0;
+  }
+  pthread_mutex_unlock(&obj->lock);
+
+  return status;
 } /* int cu_tail_readline */
 
 int cu_tail_read(cu_tail_t *obj, char *buf, int buflen, tailfunc_t *callback,
                  void *data, bool force_rewind) {
   int status;
 
+  if (buflen < 2) {
+    ERROR("utils_tail: cu_tail_read: buflen too small: %i bytes.", buflen);
+    return -1;
+  }
+
+  pthread_mutex_lock(&obj->lock);
   while (42) {
+    char *line;
     size_t len;
 
-    status = cu_tail_readline(obj, buf, buflen, force_rewind);
+    status =
+        cu_tail_next_line(obj, force_rewind, (size_t)buflen - 1, &line, &len);
     if (status != 0) {
-      ERROR("utils_tail: cu_tail_read: cu_tail_readline "
-            "failed.");
+      ERROR("utils_tail: cu_tail_read: reading `%s' failed.", obj->file);
       break;
     }
 
     /* check for EOF */
-    if (buf[0] == 0)
+    if (line == NULL)
       break;
 
-    len = strlen(buf);
-    while (len > 0) {
-      if (buf[len - 1] != '\n')
-        break;
-      buf[len - 1] = '\0';
+    /* Complete lines are terminated in place, pieces of longer lines are
+     * copied to `buf'. */
+    if (line[len - 1] == '\n') {
       len--;
+    } else {
+      memcpy(buf, line, len);
+      line = buf;
     }
+    line[len] = 0;
 
-    status = callback(data, buf, buflen);
+    status = callback(data, line, (int)len);
     if (status != 0) {
       ERROR("utils_tail: cu_tail_read: callback returned "
             "status %i.",
@@ -220,6 +574,7 @@ int cu_tail_read(cu_tail_t *obj, char *buf, int buflen, tailfunc_t *callback,
       break;
     }
   }
+  pthread_mutex_unlock(&obj->lock);
 
   return status;
 } /* int cu_tail_read */
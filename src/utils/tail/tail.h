@@ -76,13 +76,34 @@ int cu_tail_destroy(cu_tail_t *obj);
 int cu_tail_readline(cu_tail_t *obj, char *buf, int buflen, bool force_rewind);
 
 /*
- * cu_tail_readline
+ * cu_tail_read
  *
- * Reads from the file until eof condition or an error is encountered.
+ * Reads from the file until eof condition or an error is encountered and
+ * calls `callback' for each line, with the trailing newline removed and the
+ * length of the line. Lines longer than `buflen - 1' bytes are passed in
+ * pieces. An incomplete last line is only passed once it has been completed
+ * or the file has been rotated.
  *
  * Returns 0 when successful and non-zero otherwise.
  */
 int cu_tail_read(cu_tail_t *obj, char *buf, int buflen, tailfunc_t *callback,
                  void *data, bool force_rewind);
 
+/*
+ * cu_tail_follow
+ *
+ * Starts a thread which waits for inotify(7) events and reads the data
+ * appended to the file as soon as it has been written, up to a limit. The data
+ * is buffered until it is returned by `cu_tail_readline' or `cu_tail_read', so
+ * lines written just before the file is rotated and removed are not lost.
+ * While following, the file is only checked for truncation and rotation after
+ * an event. The thread is stopped by `cu_tail_destroy'. Since threads do not
+ * survive fork(2), this must not be called from a config callback; call it
+ * from an init or read callback instead.
+ *
+ * Returns 0 when successful, ENOTSUP if inotify is not available and non-zero
+ * otherwise.
+ */
+int cu_tail_follow(cu_tail_t *obj);
+
 #endif /* UTILS_TAIL_H */
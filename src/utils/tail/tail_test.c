@@ -0,0 +1,141 @@
+/**
+ * collectd - src/utils/tail/tail_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "collectd.h"
+
+#include "testing.h"
+#include "utils/common/common.h"
+#include "utils/tail/tail.h"
+
+static char tmpdir[] = "/tmp/collectd_tail_test.XXXXXX";
+static char path[PATH_MAX];
+
+static void append(char const *mode, char const *data) {
+  FILE *fh = fopen(path, mode);
+  assert(fh != NULL);
+  fputs(data, fh);
+  fclose(fh);
+}
+
+static char lines[16][64];
+static size_t lines_num;
+
+static int collect_line(__attribute__((unused)) void *data, char *buf,
+                        int buflen) {
+  assert(lines_num < STATIC_ARRAY_SIZE(lines));
+  assert(strlen(buf) == (size_t)buflen);
+  sstrncpy(lines[lines_num++], buf, sizeof(lines[0]));
+  return 0;
+}
+
+static int read_lines(cu_tail_t *tail, bool force_rewind) {
+  char buf[16];
+  lines_num = 0;
+  return cu_tail_read(tail, buf, sizeof(buf), collect_line, NULL,
+                      force_rewind);
+}
+
+DEF_TEST(read) {
+  cu_tail_t *tail;
+
+  append("w", "old line\n");
+  CHECK_NOT_NULL(tail = cu_tail_create(path));
+
+  /* The first read seeks to the end of the file. */
+  CHECK_ZERO(read_lines(tail, false));
+  EXPECT_EQ_INT(0, lines_num);
+
+  /* Incomplete lines are held back until they are completed. */
+  append("a", "first\n\nsecond");
+  CHECK_ZERO(read_lines(tail, false));
+  EXPECT_EQ_INT(2, lines_num);
+  EXPECT_EQ_STR("first", lines[0]);
+  EXPECT_EQ_STR("", lines[1]);
+
+  /* Lines longer than the buffer are split. */
+  append("a", " line\nthis line is too long\n");
+  CHECK_ZERO(read_lines(tail, false));
+  EXPECT_EQ_INT(3, lines_num);
+  EXPECT_EQ_STR("second line", lines[0]);
+  EXPECT_EQ_STR("this line is to", lines[1]);
+  EXPECT_EQ_STR("o long", lines[2]);
+
+  /* Truncation. */
+  append("w", "new\n");
+  CHECK_ZERO(read_lines(tail, false));
+  EXPECT_EQ_INT(1, lines_num);
+  EXPECT_EQ_STR("new", lines[0]);
+
+  /* Rotation: the rest of the old file is read before the new file, which is
+   * read from the beginning. */
+  char rotated[PATH_MAX + 4];
+  ssnprintf(rotated, sizeof(rotated), "%s.1", path);
+  append("a", "last");
+  CHECK_ZERO(rename(path, rotated));
+  append("w", "rotated\n");
+  CHECK_ZERO(read_lines(tail, false));
+  EXPECT_EQ_INT(2, lines_num);
+  EXPECT_EQ_STR("last", lines[0]);
+  EXPECT_EQ_STR("rotated", lines[1]);
+  unlink(rotated);
+
+  CHECK_ZERO(cu_tail_destroy(tail));
+  return 0;
+}
+
+DEF_TEST(readline) {
+  cu_tail_t *tail;
+  char buf[8];
+
+  append("w", "one\ntwo\n");
+  CHECK_NOT_NULL(tail = cu_tail_create(path));
+
+  CHECK_ZERO(cu_tail_readline(tail, buf, sizeof(buf), true));
+  EXPECT_EQ_STR("one\n", buf);
+  CHECK_ZERO(cu_tail_readline(tail, buf, sizeof(buf), true));
+  EXPECT_EQ_STR("two\n", buf);
+  CHECK_ZERO(cu_tail_readline(tail, buf, sizeof(buf), true));
+  EXPECT_EQ_STR("", buf);
+
+  append("a", "seventeen\n");
+  CHECK_ZERO(cu_tail_readline(tail, buf, sizeof(buf), true));
+  EXPECT_EQ_STR("sevente", buf);
+  CHECK_ZERO(cu_tail_readline(tail, buf, sizeof(buf), true));
+  EXPECT_EQ_STR("en\n", buf);
+
+  CHECK_ZERO(cu_tail_destroy(tail));
+  return 0;
+}
+
+int main(void) {
+  if (mkdtemp(tmpdir) == NULL)
+    return 1;
+  ssnprintf(path, sizeof(path), "%s/log", tmpdir);
+
+  RUN_TEST(read);
+  RUN_TEST(readline);
+
+  unlink(path);
+  rmdir(tmpdir);
+  END_TEST;
+}
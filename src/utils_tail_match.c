@@ -52,13 +52,42 @@ struct cu_tail_match_match_s {
   void *user_data;
   int (*submit)(cu_match_t *match, void *user_data);
   void (*free)(void *user_data);
+
+  /* Set if the match is only applied to lines containing its literal. */
+  bool prefiltered;
+  /* Number of the last line that contained the literal. */
+  uint64_t candidate_line;
+  /* Next match with the same literal or -1. */
+  int next_output;
 };
 typedef struct cu_tail_match_match_s cu_tail_match_match_t;
 
+/* Aho-Corasick automaton finding the literals of all matches (see
+ * `match_get_literal') in a single pass over each line, so that only the
+ * regular expressions of matches whose literal occurs are evaluated. Bytes
+ * which do not occur in any literal share one input class, keeping the
+ * transition table at `classes_num' entries per state. */
+struct cu_tail_prefilter_s {
+  uint8_t classes[256];
+  size_t classes_num;
+  size_t states_num;
+
+  int *delta;  /* states_num * classes_num transitions */
+  int *output; /* first match whose literal ends in a state, or -1 */
+  int *dict;   /* nearest suffix state with an output, or 0 */
+};
+typedef struct cu_tail_prefilter_s cu_tail_prefilter_t;
+
 struct cu_tail_match_s {
   cu_tail_t *tail;
   cu_tail_match_match_t *matches;
   size_t matches_num;
+
+  cu_tail_prefilter_t *prefilter;
+  bool prefilter_valid;
+
+  uint64_t lines_num;
+  cdtime_t cpu_time;
 };
 
 /*
@@ -167,12 +196,174 @@ static int latency_submit_match(cu_match_t *match, void *user_data) {
   return 0;
 } /* int latency_submit_match */
 
+static void tail_prefilter_destroy(cu_tail_prefilter_t *pf) {
+  if (pf == NULL)
+    return;
+
+  sfree(pf->delta);
+  sfree(pf->output);
+  sfree(pf->dict);
+  sfree(pf);
+} /* void tail_prefilter_destroy */
+
+/* Returns NULL if no match has a literal or on failure, in which case all
+ * matches are applied to every line. */
+static cu_tail_prefilter_t *tail_prefilter_create(cu_tail_match_match_t *matches,
+                                                  size_t matches_num) {
+  cu_tail_prefilter_t *pf;
+  bool used[256] = {false};
+  size_t states_max = 1;
+  size_t literals_num = 0;
+  int *fail = NULL;
+  int *queue = NULL;
+
+  for (size_t i = 0; i < matches_num; i++) {
+    const char *literal = match_get_literal(matches[i].match);
+
+    matches[i].prefiltered = false;
+    matches[i].next_output = -1;
+    if (literal == NULL)
+      continue;
+
+    for (const char *p = literal; *p != 0; p++)
+      used[(unsigned char)*p] = true;
+    states_max += strlen(literal);
+    literals_num++;
+  }
+
+  if ((literals_num == 0) || (matches_num > INT_MAX) || (states_max > INT_MAX))
+    return NULL;
+
+  pf = calloc(1, sizeof(*pf));
+  if (pf == NULL)
+    return NULL;
+
+  pf->classes_num = 1;
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(used); i++)
+    if (used[i])
+      pf->classes[i] = (uint8_t)pf->classes_num++;
+
+  pf->delta = malloc(states_max * pf->classes_num * sizeof(*pf->delta));
+  pf->output = malloc(states_max * sizeof(*pf->output));
+  pf->dict = calloc(states_max, sizeof(*pf->dict));
+  fail = calloc(states_max, sizeof(*fail));
+  queue = calloc(states_max, sizeof(*queue));
+  if ((pf->delta == NULL) || (pf->output == NULL) || (pf->dict == NULL) ||
+      (fail == NULL) || (queue == NULL)) {
+    ERROR("tail_match: Allocating the prefilter failed.");
+    tail_prefilter_destroy(pf);
+    sfree(fail);
+    sfree(queue);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < states_max * pf->classes_num; i++)
+    pf->delta[i] = -1;
+  for (size_t i = 0; i < states_max; i++)
+    pf->output[i] = -1;
+
+  /* Build the trie of all literals. */
+  pf->states_num = 1;
+  for (size_t i = 0; i < matches_num; i++) {
+    const char *literal = match_get_literal(matches[i].match);
+    int state = 0;
+
+    if (literal == NULL)
+      continue;
+
+    for (const char *p = literal; *p != 0; p++) {
+      int *next = pf->delta + (state * pf->classes_num) +
+                  pf->classes[(unsigned char)*p];
+      if (*next < 0)
+        *next = (int)pf->states_num++;
+      state = *next;
+    }
+
+    matches[i].next_output = pf->output[state];
+    pf->output[state] = (int)i;
+  }
+
+  /* Turn it into a DFA by computing the failure links breadth first: missing
+   * transitions are copied from the state of the longest proper suffix, which
+   * is always shallower and thus complete already. */
+  size_t queue_head = 0;
+  size_t queue_tail = 0;
+  for (size_t c = 0; c < pf->classes_num; c++) {
+    if (pf->delta[c] < 0)
+      pf->delta[c] = 0;
+    else
+      queue[queue_tail++] = pf->delta[c];
+  }
+
+  while (queue_head < queue_tail) {
+    int state = queue[queue_head++];
+    int *row = pf->delta + (state * pf->classes_num);
+    int *fail_row = pf->delta + (fail[state] * pf->classes_num);
+
+    for (size_t c = 0; c < pf->classes_num; c++) {
+      if (row[c] < 0) {
+        row[c] = fail_row[c];
+        continue;
+      }
+
+      int next = row[c];
+      fail[next] = fail_row[c];
+      pf->dict[next] =
+          (pf->output[fail[next]] >= 0) ? fail[next] : pf->dict[fail[next]];
+      queue[queue_tail++] = next;
+    }
+  }
+
+  sfree(fail);
+  sfree(queue);
+
+  for (size_t i = 0; i < matches_num; i++)
+    matches[i].prefiltered = (match_get_literal(matches[i].match) != NULL);
+
+  return pf;
+} /* cu_tail_prefilter_t *tail_prefilter_create */
+
+/* Sets `candidate_line' of all matches whose literal occurs in `str'. */
+static void tail_prefilter_scan(cu_tail_prefilter_t *pf,
+                                cu_tail_match_match_t *matches,
+                                const char *str, uint64_t line) {
+  int state = 0;
+
+  for (const unsigned char *p = (const unsigned char *)str; *p != 0; p++) {
+    state = pf->delta[(state * pf->classes_num) + pf->classes[*p]];
+
+    int out = (pf->output[state] >= 0) ? state : pf->dict[state];
+    for (; out != 0; out = pf->dict[out])
+      for (int i = pf->output[out]; i >= 0; i = matches[i].next_output)
+        matches[i].candidate_line = line;
+  }
+} /* void tail_prefilter_scan */
+
+static cdtime_t tail_match_cpu_time(void) {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return TIMESPEC_TO_CDTIME_T(&ts);
+#endif
+  return 0;
+} /* cdtime_t tail_match_cpu_time */
+
 static int tail_callback(void *data, char *buf,
                          int __attribute__((unused)) buflen) {
   cu_tail_match_t *obj = (cu_tail_match_t *)data;
 
-  for (size_t i = 0; i < obj->matches_num; i++)
-    match_apply(obj->matches[i].match, buf);
+  obj->lines_num++;
+  if (obj->prefilter != NULL)
+    tail_prefilter_scan(obj->prefilter, obj->matches, buf, obj->lines_num);
+
+  for (size_t i = 0; i < obj->matches_num; i++) {
+    cu_tail_match_match_t *m = obj->matches + i;
+
+    if (m->prefiltered && (m->candidate_line != obj->lines_num))
+      continue;
+
+    match_apply(m->match, buf);
+  }
 
   return 0;
 } /* int tail_callback */
@@ -223,6 +414,7 @@ void tail_match_destroy(cu_tail_match_t *obj) {
     match->user_data = NULL;
   }
 
+  tail_prefilter_destroy(obj->prefilter);
   sfree(obj->matches);
   sfree(obj);
 } /* void tail_match_destroy */
@@ -248,6 +440,13 @@ int tail_match_add_match(cu_tail_match_t *obj, cu_match_t *match,
   temp->user_data = user_data;
   temp->submit = submit_match;
   temp->free = free_user_data;
+  temp->prefiltered = false;
+  temp->candidate_line = 0;
+  temp->next_output = -1;
+
+  /* The prefilter refers to matches by index and is rebuilt on the next read.
+   */
+  obj->prefilter_valid = false;
 
   return 0;
 } /* int tail_match_add_match */
@@ -310,8 +509,16 @@ int tail_match_read(cu_tail_match_t *obj, bool force_rewind) {
   char buffer[4096];
   int status;
 
+  if (!obj->prefilter_valid) {
+    tail_prefilter_destroy(obj->prefilter);
+    obj->prefilter = tail_prefilter_create(obj->matches, obj->matches_num);
+    obj->prefilter_valid = true;
+  }
+
+  cdtime_t cpu_start = tail_match_cpu_time();
   status = cu_tail_read(obj->tail, buffer, sizeof(buffer), tail_callback,
                         (void *)obj, force_rewind);
+  obj->cpu_time += tail_match_cpu_time() - cpu_start;
   if (status != 0) {
     ERROR("tail_match: cu_tail_read failed.");
     return status;
@@ -328,3 +535,15 @@ int tail_match_read(cu_tail_match_t *obj, bool force_rewind) {
 
   return 0;
 } /* int tail_match_read */
+
+int tail_match_follow(cu_tail_match_t *obj) {
+  return cu_tail_follow(obj->tail);
+} /* int tail_match_follow */
+
+void tail_match_get_stats(cu_tail_match_t *obj, uint64_t *lines_num,
+                          cdtime_t *cpu_time) {
+  if (lines_num != NULL)
+    *lines_num = obj->lines_num;
+  if (cpu_time != NULL)
+    *cpu_time = obj->cpu_time;
+} /* void tail_match_get_stats */
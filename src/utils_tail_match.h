@@ -137,4 +137,30 @@ int tail_match_add_match_simple(cu_tail_match_t *obj, const char *regex,
  */
 int tail_match_read(cu_tail_match_t *obj, bool force_rewind);
 
+/*
+ * NAME
+ *   tail_match_follow
+ *
+ * DESCRIPTION
+ *   Starts reading the logfile ahead as data is appended to it, see
+ *   `cu_tail_follow' in utils_tail.h. The lines are still matched and the
+ *   values submitted by `tail_match_read'.
+ *
+ * RETURN VALUE
+ *   Zero on success, nonzero on failure.
+ */
+int tail_match_follow(cu_tail_match_t *obj);
+
+/*
+ * NAME
+ *   tail_match_get_stats
+ *
+ * DESCRIPTION
+ *   Returns the number of lines read from the logfile and the CPU time spent
+ *   reading and matching them since the object has been created. The CPU time
+ *   is zero on systems without per-thread CPU clocks.
+ */
+void tail_match_get_stats(cu_tail_match_t *obj, uint64_t *lines_num,
+                          cdtime_t *cpu_time);
+
 #endif /* UTILS_TAIL_MATCH_H */
@@ -0,0 +1,164 @@
+/**
+ * collectd - src/utils_tail_match_test.c
+ * Copyright (C) 2026       collectd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **/
+
+#include "utils_tail_match.c" /* sic */
+#include "testing.h"
+
+#include <regex.h>
+
+/* Literals overlap and are suffixes of each other, so that several of them
+ * end at the same position of a line. The last two expressions have no
+ * literal and are applied to every line. */
+static char const *regexes[] = {
+    "he",      "she",   "hers",  "his",         "s?he",
+    "ushers",  "h[ei]", "she$",  "^(he|she) s", "[0-9]+",
+    "(he|she)",
+};
+
+static char const *lines[] = {
+    "ushers",
+    "she sells sea shells",
+    "he said his hers",
+    "hhhhhhers",
+    "sshe",
+    "h e r s",
+    "",
+    "12 HE 34",
+    "shishershe",
+    "he",
+    "his",
+    "she",
+};
+
+static char tmpdir[] = "/tmp/collectd_tail_match_test.XXXXXX";
+static char path[PATH_MAX];
+
+static uint64_t regexec_count(char const *regex) {
+  regex_t re;
+  uint64_t n = 0;
+
+  if (regcomp(&re, regex, REG_EXTENDED | REG_NEWLINE) != 0)
+    return UINT64_MAX;
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(lines); i++)
+    if (regexec(&re, lines[i], 0, NULL, 0) == 0)
+      n++;
+  regfree(&re);
+  return n;
+}
+
+static int submit_count(cu_match_t *match, void *user_data) {
+  cu_match_value_t *mv = match_get_user_data(match);
+  *(uint64_t *)user_data = mv->value.counter;
+  return 0;
+}
+
+DEF_TEST(prefilter_scan) {
+  cu_tail_match_match_t matches[STATIC_ARRAY_SIZE(regexes)] = {{0}};
+  cu_tail_prefilter_t *pf;
+
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(regexes); i++)
+    CHECK_NOT_NULL(matches[i].match = match_create_simple(
+                       regexes[i], NULL,
+                       UTILS_MATCH_DS_TYPE_COUNTER |
+                           UTILS_MATCH_CF_COUNTER_INC));
+
+  CHECK_NOT_NULL(
+      pf = tail_prefilter_create(matches, STATIC_ARRAY_SIZE(matches)));
+
+  /* A match is a candidate for exactly the lines containing its literal. */
+  for (size_t j = 0; j < STATIC_ARRAY_SIZE(lines); j++) {
+    uint64_t line = j + 1;
+
+    tail_prefilter_scan(pf, matches, lines[j], line);
+    for (size_t i = 0; i < STATIC_ARRAY_SIZE(matches); i++) {
+      char const *literal = match_get_literal(matches[i].match);
+
+      if (literal == NULL) {
+        OK(!matches[i].prefiltered);
+        continue;
+      }
+      OK(matches[i].prefiltered);
+      bool want = (strstr(lines[j], literal) != NULL);
+      bool got = (matches[i].candidate_line == line);
+      EXPECT_EQ_INT(want, got);
+    }
+  }
+
+  tail_prefilter_destroy(pf);
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(matches); i++)
+    match_destroy(matches[i].match);
+  return 0;
+}
+
+DEF_TEST(read_counts) {
+  uint64_t counts[STATIC_ARRAY_SIZE(regexes)] = {0};
+  cu_tail_match_t *tm;
+
+  FILE *fh = fopen(path, "w");
+  CHECK_NOT_NULL(fh);
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(lines); i++)
+    fprintf(fh, "%s\n", lines[i]);
+  fclose(fh);
+
+  CHECK_NOT_NULL(tm = tail_match_create(path));
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(regexes); i++) {
+    cu_match_t *m;
+
+    CHECK_NOT_NULL(m = match_create_simple(regexes[i], NULL,
+                                           UTILS_MATCH_DS_TYPE_COUNTER |
+                                               UTILS_MATCH_CF_COUNTER_INC));
+    CHECK_ZERO(
+        tail_match_add_match(tm, m, submit_count, counts + i, NULL));
+  }
+
+  CHECK_ZERO(tail_match_read(tm, /* force_rewind = */ true));
+  CHECK_NOT_NULL(tm->prefilter);
+
+  /* Prefiltering must not change the result of any match. */
+  for (size_t i = 0; i < STATIC_ARRAY_SIZE(regexes); i++) {
+    printf("## %s\n", regexes[i]);
+    EXPECT_EQ_UINT64(regexec_count(regexes[i]), counts[i]);
+  }
+
+  uint64_t lines_num = 0;
+  tail_match_get_stats(tm, &lines_num, NULL);
+  EXPECT_EQ_UINT64(STATIC_ARRAY_SIZE(lines), lines_num);
+
+  tail_match_destroy(tm);
+  unlink(path);
+  return 0;
+}
+
+int main(void) {
+  if (mkdtemp(tmpdir) == NULL) {
+    fprintf(stderr, "mkdtemp(\"%s\") failed\n", tmpdir);
+    return 1;
+  }
+  ssnprintf(path, sizeof(path), "%s/test.log", tmpdir);
+
+  RUN_TEST(prefilter_scan);
+  RUN_TEST(read_counts);
+
+  rmdir(tmpdir);
+  END_TEST;
+}
@@ -30,6 +30,7 @@
 #include "utils/curl_stats/curl_stats.h"
 #include "utils/format_json/format_json.h"
 #include "utils/format_kairosdb/format_kairosdb.h"
+#include "utils_cache.h"
 
 #include <curl/curl.h>
 
@@ -86,6 +87,8 @@ struct wh_callback_s {
   size_t send_buffer_free;
   size_t send_buffer_fill;
   cdtime_t send_buffer_init_time;
+  /* Used instead of send_buffer with WH_FORMAT_JSON. */
+  format_json_batch_t *json_batch;
 
   pthread_mutex_t send_lock;
 
@@ -150,7 +153,9 @@ static void wh_reset_buffer(wh_callback_t *cb) /* {{{ */
   cb->send_buffer_fill = 0;
   cb->send_buffer_init_time = cdtime();
 
-  if (cb->format == WH_FORMAT_JSON || cb->format == WH_FORMAT_KAIROSDB) {
+  if (cb->format == WH_FORMAT_JSON) {
+    format_json_batch_reset(cb->json_batch);
+  } else if (cb->format == WH_FORMAT_KAIROSDB) {
     format_json_initialize(cb->send_buffer, &cb->send_buffer_fill,
                            &cb->send_buffer_free);
   }
@@ -306,7 +311,23 @@ static int wh_flush_nolock(cdtime_t timeout, wh_callback_t *cb) /* {{{ */
 
     status = wh_post_nolock(cb, cb->send_buffer);
     wh_reset_buffer(cb);
-  } else if (cb->format == WH_FORMAT_JSON || cb->format == WH_FORMAT_KAIROSDB) {
+  } else if (cb->format == WH_FORMAT_JSON) {
+    if (format_json_batch_size(cb->json_batch) == 0) {
+      cb->send_buffer_init_time = cdtime();
+      return 0;
+    }
+
+    char const *data = format_json_batch_finalize(cb->json_batch);
+    if (data == NULL) {
+      ERROR("write_http: wh_flush_nolock: "
+            "format_json_batch_finalize failed.");
+      wh_reset_buffer(cb);
+      return -1;
+    }
+
+    status = wh_post_nolock(cb, data);
+    wh_reset_buffer(cb);
+  } else if (cb->format == WH_FORMAT_KAIROSDB) {
     if (cb->send_buffer_fill <= 2) {
       cb->send_buffer_init_time = cdtime();
       return 0;
@@ -394,6 +415,7 @@ static void wh_callback_free(void *data) /* {{{ */
   sfree(cb->clientcert);
   sfree(cb->clientkeypass);
   sfree(cb->send_buffer);
+  format_json_batch_destroy(cb->json_batch);
   sfree(cb->metrics_prefix);
 
   sfree(cb);
@@ -484,41 +506,53 @@ static int wh_write_command(const data_set_t *ds,
 
 static int wh_write_json(const data_set_t *ds, const value_list_t *vl, /* {{{ */
                          wh_callback_t *cb) {
+  gauge_t *rates = NULL;
   int status;
 
+  if (cb->store_rates) {
+    for (size_t i = 0; i < ds->ds_num; i++) {
+      if (ds->ds[i].type == DS_TYPE_GAUGE)
+        continue;
+      rates = uc_get_rate(ds, vl);
+      if (rates == NULL) {
+        WARNING("write_http plugin: uc_get_rate failed.");
+        return -1;
+      }
+      break;
+    }
+  }
+
   pthread_mutex_lock(&cb->send_lock);
   if (wh_callback_init(cb) != 0) {
     ERROR("write_http plugin: wh_callback_init failed.");
     pthread_mutex_unlock(&cb->send_lock);
+    sfree(rates);
     return -1;
   }
 
-  status =
-      format_json_value_list(cb->send_buffer, &cb->send_buffer_fill,
-                             &cb->send_buffer_free, ds, vl, cb->store_rates);
-  if (status == -ENOMEM) {
+  status = format_json_batch_add(cb->json_batch, ds, vl, rates);
+  sfree(rates);
+  if (status != 0) {
+    pthread_mutex_unlock(&cb->send_lock);
+    return status;
+  }
+
+  size_t fill = format_json_batch_size(cb->json_batch);
+  DEBUG("write_http plugin: <%s> buffer %" PRIsz "/%" PRIsz " (%g%%), "
+        "%" PRIsz " cached series",
+        cb->location, fill, cb->send_buffer_size,
+        100.0 * ((double)fill) / ((double)cb->send_buffer_size),
+        format_json_batch_series_num(cb->json_batch));
+
+  /* The batch grows as needed, BufferSize only determines when it is sent. */
+  if (fill >= cb->send_buffer_size) {
     status = wh_flush_nolock(/* timeout = */ 0, cb);
     if (status != 0) {
-      wh_reset_buffer(cb);
       pthread_mutex_unlock(&cb->send_lock);
       return status;
     }
-
-    status =
-        format_json_value_list(cb->send_buffer, &cb->send_buffer_fill,
-                               &cb->send_buffer_free, ds, vl, cb->store_rates);
-  }
-  if (status != 0) {
-    pthread_mutex_unlock(&cb->send_lock);
-    return status;
   }
 
-  DEBUG("write_http plugin: <%s> buffer %" PRIsz "/%" PRIsz " (%g%%)",
-        cb->location, cb->send_buffer_fill, cb->send_buffer_size,
-        100.0 * ((double)cb->send_buffer_fill) /
-            ((double)cb->send_buffer_size));
-
-  /* Check if we have enough space for this command. */
   pthread_mutex_unlock(&cb->send_lock);
 
   return 0;
@@ -874,6 +908,15 @@ static int wh_config_node(oconfig_item_t *ci) /* {{{ */
     return -1;
   }
 
+  if (cb->format == WH_FORMAT_JSON) {
+    cb->json_batch = format_json_batch_create();
+    if (cb->json_batch == NULL) {
+      ERROR("write_http plugin: format_json_batch_create failed.");
+      wh_callback_free(cb);
+      return -1;
+    }
+  }
+
   /* Nulls the buffer and sets ..._free and ..._fill. */
   wh_reset_buffer(cb);
 
@@ -935,4 +978,5 @@ void module_register(void) /* {{{ */
 {
   plugin_register_complex_config("write_http", wh_config);
   plugin_register_init("write_http", wh_init);
+  plugin_register_init_exclusive("write_http");
 } /* }}} void module_register */
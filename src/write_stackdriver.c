@@ -687,4 +687,5 @@ void module_register(void) /* {{{ */
 {
   plugin_register_complex_config("write_stackdriver", wg_config);
   plugin_register_init("write_stackdriver", wg_init);
+  plugin_register_init_exclusive("write_stackdriver");
 } /* }}} void module_register */
@@ -45,6 +45,7 @@
 
 #include "plugin.h"
 #include "utils/common/common.h"
+#include "utils/serialize/serialize.h"
 #include "utils_cache.h"
 #include "utils_random.h"
 
@@ -322,13 +323,10 @@ static int wt_format_values(char *ret, size_t ret_len, int ds_num,
 
   memset(ret, 0, ret_len);
 
-#define BUFFER_ADD(...)                                                        \
+#define BUFFER_ADD(func, value)                                                \
   do {                                                                         \
-    status = snprintf(ret + offset, ret_len - offset, __VA_ARGS__);            \
-    if (status < 1) {                                                          \
-      sfree(rates);                                                            \
-      return -1;                                                               \
-    } else if (((size_t)status) >= (ret_len - offset)) {                       \
+    status = func(ret + offset, ret_len - offset, (value));                    \
+    if (((size_t)status) >= (ret_len - offset)) {                              \
       sfree(rates);                                                            \
       return -1;                                                               \
     } else                                                                     \
@@ -336,7 +334,7 @@ static int wt_format_values(char *ret, size_t ret_len, int ds_num,
   } while (0)
 
   if (ds->ds[ds_num].type == DS_TYPE_GAUGE)
-    BUFFER_ADD(GAUGE_FORMAT, vl->values[ds_num].gauge);
+    BUFFER_ADD(serialize_gauge, vl->values[ds_num].gauge);
   else if (store_rates) {
     if (rates == NULL)
       rates = uc_get_rate(ds, vl);
@@ -345,13 +343,13 @@ static int wt_format_values(char *ret, size_t ret_len, int ds_num,
               "uc_get_rate failed.");
       return -1;
     }
-    BUFFER_ADD(GAUGE_FORMAT, rates[ds_num]);
+    BUFFER_ADD(serialize_gauge, rates[ds_num]);
   } else if (ds->ds[ds_num].type == DS_TYPE_COUNTER)
-    BUFFER_ADD("%" PRIu64, (uint64_t)vl->values[ds_num].counter);
+    BUFFER_ADD(serialize_uint64, (uint64_t)vl->values[ds_num].counter);
   else if (ds->ds[ds_num].type == DS_TYPE_DERIVE)
-    BUFFER_ADD("%" PRIi64, vl->values[ds_num].derive);
+    BUFFER_ADD(serialize_int64, vl->values[ds_num].derive);
   else if (ds->ds[ds_num].type == DS_TYPE_ABSOLUTE)
-    BUFFER_ADD("%" PRIu64, vl->values[ds_num].absolute);
+    BUFFER_ADD(serialize_uint64, vl->values[ds_num].absolute);
   else {
     ERROR("format_values plugin: Unknown data source type: %i",
           ds->ds[ds_num].type);